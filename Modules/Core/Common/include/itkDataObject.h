@@ -381,6 +381,14 @@ public:
 
   virtual void UpdateOutputData();
 
+  /** Ask the upstream pipeline to start generating the current requested
+   * region of this data object in the background, so that a later
+   * UpdateOutputData() for the same region finds it ready or in progress.
+   * Call it after PropagateRequestedRegion().  This is only a hint: the
+   * process objects which cannot work ahead ignore it.  StreamingImageFilter
+   * uses it to read the next pieces while the current one is processed. */
+  virtual void PrefetchRequestedRegion();
+
   /** Reset the pipeline. If an exception is thrown during an Update(),
    * the pipeline may be in an inconsistent state.  This method clears
    * the internal state of the pipeline so Update() can be called. */
@@ -0,0 +1,490 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkFunctorBatch_h
+#define __itkFunctorBatch_h
+
+#include "itkImage.h"
+
+// SSE2 is part of every x86-64 processor, so it needs no compiler flag
+// there; on 32 bit x86 it is used when the compiler targets it.
+#if defined( ITK_HAVE_EMMINTRIN_H ) && !defined( __GCCXML__ ) \
+  && ( defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 ) )
+#define ITK_USE_SSE2_FUNCTOR_BATCH
+#include <emmintrin.h> // sse 2 intrinsics
+#endif
+
+namespace itk
+{
+/** \class ContiguousPixelBuffer
+ * \brief Tells whether the pixels of an image type are stored one after
+ * the other in a plain array of pixels.
+ *
+ * Value is true for Image, whose pixels are then accessed through
+ * GetBufferPointer(), and false for images that convert the pixels they
+ * store, like image adaptors and VectorImage.
+ *
+ * \ingroup ITKCommon
+ */
+template< class TImage >
+struct ContiguousPixelBuffer
+{
+  itkStaticConstMacro(Value, bool, false);
+
+  typedef typename TImage::PixelType PixelType;
+
+  static PixelType * GetBufferPointer(TImage *)
+  {
+    return 0;
+  }
+
+  static const PixelType * GetBufferPointer(const TImage *)
+  {
+    return 0;
+  }
+};
+
+template< class TPixel, unsigned int VImageDimension >
+struct ContiguousPixelBuffer< Image< TPixel, VImageDimension > >
+{
+  itkStaticConstMacro(Value, bool, true);
+
+  typedef TPixel PixelType;
+
+  static PixelType * GetBufferPointer(Image< TPixel, VImageDimension > *image)
+  {
+    return image->GetBufferPointer();
+  }
+
+  static const PixelType * GetBufferPointer(const Image< TPixel, VImageDimension > *image)
+  {
+    return image->GetBufferPointer();
+  }
+};
+
+/** \class ScanlineSpanIterator
+ * \brief Walks a region of several pixel buffers in spans of pixels
+ * contiguous in all of them.
+ *
+ * Each buffer holds its own buffered region, which must include the
+ * region walked.  A span is at least a scanline, the pixels along the
+ * first dimension; when the region covers the whole length of the
+ * buffered regions along the first dimensions, the scanlines of these
+ * dimensions are merged into longer spans, up to the whole region.
+ * GetOffset() gives, for each buffer, the offset of the first pixel of
+ * the current span from the start of the buffer.
+ *
+ * \code
+ *   ScanlineSpanIterator< 3 > span(region);
+ *   span.AddBuffer( input->GetBufferedRegion() );
+ *   span.AddBuffer( output->GetBufferedRegion() );
+ *   for ( span.GoToBegin(); !span.IsAtEnd(); ++span )
+ *     {
+ *     process( inputBuffer + span.GetOffset(0),
+ *              outputBuffer + span.GetOffset(1), span.GetLength() );
+ *     }
+ * \endcode
+ *
+ * \ingroup ImageIterators
+ * \ingroup ITKCommon
+ */
+template< unsigned int VImageDimension >
+class ScanlineSpanIterator
+{
+public:
+  typedef ScanlineSpanIterator            Self;
+  typedef ImageRegion< VImageDimension >  RegionType;
+  typedef typename RegionType::IndexType  IndexType;
+
+  itkStaticConstMacro(MaximumNumberOfBuffers, unsigned int, 4);
+
+  ScanlineSpanIterator(const RegionType & region):
+    m_Region(region), m_NumberOfBuffers(0), m_SpanDimension(0), m_Length(0), m_AtEnd(true)
+  {}
+
+  /** Add a buffer holding bufferedRegion, and return its number. */
+  unsigned int AddBuffer(const RegionType & bufferedRegion)
+  {
+    const unsigned int buffer = m_NumberOfBuffers++;
+
+    OffsetValueType stride = 1;
+    for ( unsigned int d = 0; d < VImageDimension; ++d )
+      {
+      m_BufferedIndex[buffer][d] = bufferedRegion.GetIndex(d);
+      m_BufferedSize[buffer][d] = bufferedRegion.GetSize(d);
+      m_Strides[buffer][d] = stride;
+      stride *= static_cast< OffsetValueType >( bufferedRegion.GetSize(d) );
+      }
+    return buffer;
+  }
+
+  void GoToBegin()
+  {
+    // the spans cover the dimensions up to the first one along which
+    // the region is shorter than a buffered region
+    m_SpanDimension = 0;
+    while ( m_SpanDimension + 1 < VImageDimension
+            && this->IsWholeLength(m_SpanDimension) )
+      {
+      ++m_SpanDimension;
+      }
+    m_Length = 1;
+    for ( unsigned int d = 0; d <= m_SpanDimension; ++d )
+      {
+      m_Length *= m_Region.GetSize(d);
+      }
+    m_Index = m_Region.GetIndex();
+    m_AtEnd = m_Length == 0;
+    this->ComputeOffsets();
+  }
+
+  bool IsAtEnd() const
+  {
+    return m_AtEnd;
+  }
+
+  Self & operator++()
+  {
+    for ( unsigned int d = m_SpanDimension + 1; d < VImageDimension; ++d )
+      {
+      if ( ++m_Index[d] < m_Region.GetIndex(d) + static_cast< OffsetValueType >( m_Region.GetSize(d) ) )
+        {
+        this->ComputeOffsets();
+        return *this;
+        }
+      m_Index[d] = m_Region.GetIndex(d);
+      }
+    m_AtEnd = true;
+    return *this;
+  }
+
+  /** Offset of the first pixel of the span in the buffer. */
+  OffsetValueType GetOffset(unsigned int buffer) const
+  {
+    return m_Offsets[buffer];
+  }
+
+  /** Number of pixels of the span. */
+  SizeValueType GetLength() const
+  {
+    return m_Length;
+  }
+
+private:
+  bool IsWholeLength(unsigned int d) const
+  {
+    for ( unsigned int buffer = 0; buffer < m_NumberOfBuffers; ++buffer )
+      {
+      if ( m_Region.GetSize(d) != m_BufferedSize[buffer][d] )
+        {
+        return false;
+        }
+      }
+    return true;
+  }
+
+  void ComputeOffsets()
+  {
+    for ( unsigned int buffer = 0; buffer < m_NumberOfBuffers; ++buffer )
+      {
+      OffsetValueType offset = 0;
+      for ( unsigned int d = 0; d < VImageDimension; ++d )
+        {
+        offset += ( m_Index[d] - m_BufferedIndex[buffer][d] ) * m_Strides[buffer][d];
+        }
+      m_Offsets[buffer] = offset;
+      }
+  }
+
+  RegionType      m_Region;
+  unsigned int    m_NumberOfBuffers;
+  IndexValueType  m_BufferedIndex[MaximumNumberOfBuffers][VImageDimension];
+  SizeValueType   m_BufferedSize[MaximumNumberOfBuffers][VImageDimension];
+  OffsetValueType m_Strides[MaximumNumberOfBuffers][VImageDimension];
+  OffsetValueType m_Offsets[MaximumNumberOfBuffers];
+  unsigned int    m_SpanDimension;
+  SizeValueType   m_Length;
+  IndexType       m_Index;
+  bool            m_AtEnd;
+};
+
+namespace Functor
+{
+/** \class ScalarUnaryBatch
+ * \brief Applies a unary functor to arrays of pixels, one pixel at a
+ * time.
+ *
+ * UnaryFunctorImageFilter calls UnaryBatch< TFunctor >::Evaluate() for
+ * each span of contiguous pixels of images that store plain arrays of
+ * pixels.  UnaryBatch defaults to this loop, which compilers can often
+ * vectorize once the functor is inlined; functors with a faster batch
+ * form specialize UnaryBatch, deriving from this class for the pixel
+ * types they do not handle.
+ *
+ * \ingroup ITKCommon
+ */
+template< class TFunctor >
+class ScalarUnaryBatch
+{
+public:
+  template< class TInput, class TOutput >
+  static void Evaluate(const TFunctor & functor, const TInput *input, TOutput *output,
+                       SizeValueType length)
+  {
+    for ( SizeValueType i = 0; i < length; ++i )
+      {
+      output[i] = functor(input[i]);
+      }
+  }
+};
+
+template< class TFunctor >
+class UnaryBatch:public ScalarUnaryBatch< TFunctor >
+{};
+
+/** \class ScalarBinaryBatch
+ * \brief Applies a binary functor to arrays of pixels, one pixel at a
+ * time.
+ *
+ * The batch form used by BinaryFunctorImageFilter, see
+ * ScalarUnaryBatch.  Either input may be a constant.
+ *
+ * \ingroup ITKCommon
+ */
+template< class TFunctor >
+class ScalarBinaryBatch
+{
+public:
+  template< class TInput1, class TInput2, class TOutput >
+  static void Evaluate(const TFunctor & functor, const TInput1 *input1, const TInput2 *input2,
+                       TOutput *output, SizeValueType length)
+  {
+    for ( SizeValueType i = 0; i < length; ++i )
+      {
+      output[i] = functor(input1[i], input2[i]);
+      }
+  }
+
+  template< class TInput1, class TInput2, class TOutput >
+  static void EvaluateWithConstant1(const TFunctor & functor, const TInput1 & input1,
+                                    const TInput2 *input2, TOutput *output, SizeValueType length)
+  {
+    for ( SizeValueType i = 0; i < length; ++i )
+      {
+      output[i] = functor(input1, input2[i]);
+      }
+  }
+
+  template< class TInput1, class TInput2, class TOutput >
+  static void EvaluateWithConstant2(const TFunctor & functor, const TInput1 *input1,
+                                    const TInput2 & input2, TOutput *output, SizeValueType length)
+  {
+    for ( SizeValueType i = 0; i < length; ++i )
+      {
+      output[i] = functor(input1[i], input2);
+      }
+  }
+};
+
+template< class TFunctor >
+class BinaryBatch:public ScalarBinaryBatch< TFunctor >
+{};
+
+/** \class ScalarTernaryBatch
+ * \brief Applies a ternary functor to arrays of pixels, one pixel at a
+ * time.
+ *
+ * The batch form used by TernaryFunctorImageFilter, see
+ * ScalarUnaryBatch.
+ *
+ * \ingroup ITKCommon
+ */
+template< class TFunctor >
+class ScalarTernaryBatch
+{
+public:
+  template< class TInput1, class TInput2, class TInput3, class TOutput >
+  static void Evaluate(const TFunctor & functor, const TInput1 *input1, const TInput2 *input2,
+                       const TInput3 *input3, TOutput *output, SizeValueType length)
+  {
+    for ( SizeValueType i = 0; i < length; ++i )
+      {
+      output[i] = functor(input1[i], input2[i], input3[i]);
+      }
+  }
+};
+
+template< class TFunctor >
+class TernaryBatch:public ScalarTernaryBatch< TFunctor >
+{};
+
+#ifdef ITK_USE_SSE2_FUNCTOR_BATCH
+/** Arithmetic operations on 4 floats and 8 unsigned shorts, the latter
+ * wrapping around like the C++ arithmetic converted back to unsigned
+ * short. */
+struct SSE2Add {
+  static __m128 Apply(__m128 a, __m128 b) { return _mm_add_ps(a, b); }
+  static __m128i Apply(__m128i a, __m128i b) { return _mm_add_epi16(a, b); }
+};
+
+struct SSE2Subtract {
+  static __m128 Apply(__m128 a, __m128 b) { return _mm_sub_ps(a, b); }
+  static __m128i Apply(__m128i a, __m128i b) { return _mm_sub_epi16(a, b); }
+};
+
+struct SSE2Multiply {
+  static __m128 Apply(__m128 a, __m128 b) { return _mm_mul_ps(a, b); }
+  static __m128i Apply(__m128i a, __m128i b) { return _mm_mullo_epi16(a, b); }
+};
+
+/** Convert 8 floats to unsigned shorts, truncating them like
+ * static_cast. */
+inline __m128i SSE2ConvertToUnsignedShort(__m128 low, __m128 high)
+{
+  // Keep the low 16 bits of each truncated integer, as the scalar
+  // conversion does: SSE2 only packs with signed saturation, so they
+  // are first sign extended into the range of short.
+  const __m128i lowIntegers = _mm_cvttps_epi32(low);
+  const __m128i highIntegers = _mm_cvttps_epi32(high);
+  return _mm_packs_epi32( _mm_srai_epi32(_mm_slli_epi32(lowIntegers, 16), 16),
+                          _mm_srai_epi32(_mm_slli_epi32(highIntegers, 16), 16) );
+}
+
+/** Convert 8 unsigned shorts to floats. */
+inline void SSE2ConvertToFloat(__m128i x, __m128 & low, __m128 & high)
+{
+  const __m128i zero = _mm_setzero_si128();
+  low = _mm_cvtepi32_ps( _mm_unpacklo_epi16(x, zero) );
+  high = _mm_cvtepi32_ps( _mm_unpackhi_epi16(x, zero) );
+}
+
+/** \class SSE2BinaryBatch
+ * \brief Batch form of binary functors computing TOperation on float or
+ * unsigned short pixels with SSE2 instructions.
+ *
+ * BinaryBatch specializations of these functors derive from it; other
+ * pixel types are processed one at a time.
+ *
+ * \ingroup ITKCommon
+ */
+template< class TFunctor, class TOperation >
+class SSE2BinaryBatch:public ScalarBinaryBatch< TFunctor >
+{
+public:
+  using ScalarBinaryBatch< TFunctor >::Evaluate;
+  using ScalarBinaryBatch< TFunctor >::EvaluateWithConstant1;
+  using ScalarBinaryBatch< TFunctor >::EvaluateWithConstant2;
+
+  static void Evaluate(const TFunctor & functor, const float *input1, const float *input2,
+                       float *output, SizeValueType length)
+  {
+    SizeValueType i = 0;
+    for ( ; i + 4 <= length; i += 4 )
+      {
+      _mm_storeu_ps( output + i, TOperation::Apply( _mm_loadu_ps(input1 + i), _mm_loadu_ps(input2 + i) ) );
+      }
+    for ( ; i < length; ++i )
+      {
+      output[i] = functor(input1[i], input2[i]);
+      }
+  }
+
+  static void EvaluateWithConstant1(const TFunctor & functor, const float & input1, const float *input2,
+                                    float *output, SizeValueType length)
+  {
+    const __m128  constant = _mm_set1_ps(input1);
+    SizeValueType i = 0;
+    for ( ; i + 4 <= length; i += 4 )
+      {
+      _mm_storeu_ps( output + i, TOperation::Apply( constant, _mm_loadu_ps(input2 + i) ) );
+      }
+    for ( ; i < length; ++i )
+      {
+      output[i] = functor(input1, input2[i]);
+      }
+  }
+
+  static void EvaluateWithConstant2(const TFunctor & functor, const float *input1, const float & input2,
+                                    float *output, SizeValueType length)
+  {
+    const __m128  constant = _mm_set1_ps(input2);
+    SizeValueType i = 0;
+    for ( ; i + 4 <= length; i += 4 )
+      {
+      _mm_storeu_ps( output + i, TOperation::Apply( _mm_loadu_ps(input1 + i), constant ) );
+      }
+    for ( ; i < length; ++i )
+      {
+      output[i] = functor(input1[i], input2);
+      }
+  }
+
+  static void Evaluate(const TFunctor & functor, const unsigned short *input1,
+                       const unsigned short *input2, unsigned short *output, SizeValueType length)
+  {
+    SizeValueType i = 0;
+    for ( ; i + 8 <= length; i += 8 )
+      {
+      const __m128i a = _mm_loadu_si128( reinterpret_cast< const __m128i * >( input1 + i ) );
+      const __m128i b = _mm_loadu_si128( reinterpret_cast< const __m128i * >( input2 + i ) );
+      _mm_storeu_si128( reinterpret_cast< __m128i * >( output + i ), TOperation::Apply(a, b) );
+      }
+    for ( ; i < length; ++i )
+      {
+      output[i] = functor(input1[i], input2[i]);
+      }
+  }
+
+  static void EvaluateWithConstant1(const TFunctor & functor, const unsigned short & input1,
+                                    const unsigned short *input2, unsigned short *output,
+                                    SizeValueType length)
+  {
+    const __m128i constant = _mm_set1_epi16( static_cast< short >( input1 ) );
+    SizeValueType i = 0;
+    for ( ; i + 8 <= length; i += 8 )
+      {
+      const __m128i b = _mm_loadu_si128( reinterpret_cast< const __m128i * >( input2 + i ) );
+      _mm_storeu_si128( reinterpret_cast< __m128i * >( output + i ), TOperation::Apply(constant, b) );
+      }
+    for ( ; i < length; ++i )
+      {
+      output[i] = functor(input1, input2[i]);
+      }
+  }
+
+  static void EvaluateWithConstant2(const TFunctor & functor, const unsigned short *input1,
+                                    const unsigned short & input2, unsigned short *output,
+                                    SizeValueType length)
+  {
+    const __m128i constant = _mm_set1_epi16( static_cast< short >( input2 ) );
+    SizeValueType i = 0;
+    for ( ; i + 8 <= length; i += 8 )
+      {
+      const __m128i a = _mm_loadu_si128( reinterpret_cast< const __m128i * >( input1 + i ) );
+      _mm_storeu_si128( reinterpret_cast< __m128i * >( output + i ), TOperation::Apply(a, constant) );
+      }
+    for ( ; i < length; ++i )
+      {
+      output[i] = functor(input1[i], input2);
+      }
+  }
+};
+#endif
+} // end namespace Functor
+} // end namespace itk
+
+#endif
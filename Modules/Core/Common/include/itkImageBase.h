@@ -211,10 +211,14 @@ public:
   /** Allocate the image memory. The size of the image must
    * already be set, e.g. by calling SetRegions().
    *
+   * The pixels are left uninitialized unless initializePixels is true,
+   * in which case they are set to their default value (zero for scalar
+   * pixels).  Pass true when the pixels will not all be overwritten.
+   *
    * This method should be pure virtual, if backwards compatibility
    *  was not required.
    */
-  virtual void Allocate() {}
+  virtual void Allocate(bool initializePixels = false) { (void)initializePixels; }
 
   /** Set the region object that defines the size and starting index
    * for the largest possible region this image could represent.  This
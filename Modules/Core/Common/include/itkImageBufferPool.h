@@ -0,0 +1,147 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkImageBufferPool_h
+#define __itkImageBufferPool_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkSimpleFastMutexLock.h"
+#include "itkIntTypes.h"
+#include <map>
+#include <vector>
+
+namespace itk
+{
+/** \class ImageBufferPool
+ * \brief Recycles the memory blocks of image buffers.
+ *
+ * Pipelines that are updated repeatedly (slice by slice, level by level,
+ * frame by frame) free and allocate buffers of the same sizes over and
+ * over again.  An ImageBufferPool keeps the blocks released by
+ * ImportImageContainer and hands them out again for later allocations
+ * of a similar size, which avoids going back to the system allocator and
+ * faulting in fresh pages every time.
+ *
+ * Block sizes are rounded up to buckets, eight per power of two, so that
+ * a request is served by any cached block of its bucket; at most 12.5%
+ * of a block is wasted that way.  Cached blocks are kept until
+ * ReleaseCachedBlocks() is called, until the pool is destroyed, or, once
+ * MaximumCachedBytes would be exceeded, released immediately instead of
+ * cached.
+ *
+ * Containers use the pool set with ImportImageContainer::SetBufferPool()
+ * or, for the outputs of a filter, ImageSource::SetBufferPool().  Those
+ * that have none use the global default pool, if any.  A pool stays
+ * alive as long as blocks it handed out are in use.
+ *
+ * All methods are thread safe.
+ *
+ * \sa ImportImageContainer
+ * \ingroup ImageObjects
+ * \ingroup ITKCommon
+ */
+class ITKCommon_EXPORT ImageBufferPool:public Object
+{
+public:
+  /** Standard class typedefs. */
+  typedef ImageBufferPool            Self;
+  typedef Object                     Superclass;
+  typedef SmartPointer< Self >       Pointer;
+  typedef SmartPointer< const Self > ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ImageBufferPool, Object);
+
+  /** Set/Get the pool used by the containers that have none of their
+   * own.  Unless set explicitly, a pool is created the first time it is
+   * needed if the ITK_USE_IMAGE_BUFFER_POOL environment variable is set
+   * to a value other than "0", "OFF", "NO" or "FALSE"; otherwise there is
+   * no global default pool and buffers come from the system allocator. */
+  static void SetGlobalDefaultPool(Self *pool);
+
+  static Pointer GetGlobalDefaultPool();
+
+  /** Return a block of at least numberOfBytes bytes, reusing a cached one
+   * if possible.  Returns null if the memory cannot be allocated. */
+  void * AcquireBlock(SizeValueType numberOfBytes);
+
+  /** Give back a block obtained from AcquireBlock() with the same
+   * numberOfBytes. */
+  void ReleaseBlock(void *block, SizeValueType numberOfBytes);
+
+  /** Free all cached blocks. */
+  void ReleaseCachedBlocks();
+
+  /** Set/Get the largest number of bytes held in cached blocks.  Defaults
+   * to a quarter of the physical memory of the machine, or to 0, which
+   * turns caching off, if that cannot be determined. */
+  itkSetMacro(MaximumCachedBytes, SizeValueType);
+  itkGetConstMacro(MaximumCachedBytes, SizeValueType);
+
+  /** Number of AcquireBlock() calls served from, and not from, the cache. */
+  SizeValueType GetNumberOfHits() const;
+  SizeValueType GetNumberOfMisses() const;
+
+  /** Bytes currently handed out, and currently cached. */
+  SizeValueType GetBytesInUse() const;
+  SizeValueType GetCachedBytes() const;
+
+  /** Largest number of bytes held by the pool, in use and cached,
+   * since construction or the last ResetStatistics(). */
+  SizeValueType GetPeakBytes() const;
+
+  /** Reset the hit and miss counts, and the peak to the current bytes. */
+  void ResetStatistics();
+
+  /** Size of the blocks used for requests of numberOfBytes bytes. */
+  static SizeValueType GetBucketSize(SizeValueType numberOfBytes);
+
+protected:
+  ImageBufferPool();
+  ~ImageBufferPool();
+  void PrintSelf(std::ostream & os, Indent indent) const;
+
+private:
+  ImageBufferPool(const Self &); //purposely not implemented
+  void operator=(const Self &);  //purposely not implemented
+
+  typedef std::map< SizeValueType, std::vector< void * > > CacheType;
+
+  static Pointer             m_GlobalDefaultPool;
+  static bool                m_GlobalDefaultPoolInitialized;
+  static SimpleFastMutexLock m_GlobalDefaultPoolLock;
+
+  /** Protects every member below. */
+  mutable SimpleFastMutexLock m_Mutex;
+
+  /** Cached blocks, by bucket size. */
+  CacheType m_Cache;
+
+  SizeValueType m_MaximumCachedBytes;
+  SizeValueType m_CachedBytes;
+  SizeValueType m_BytesInUse;
+  SizeValueType m_PeakBytes;
+  SizeValueType m_NumberOfHits;
+  SizeValueType m_NumberOfMisses;
+};
+} // end namespace itk
+
+#endif
@@ -30,6 +30,10 @@
 
 #include "itkProcessObject.h"
 #include "itkImage.h"
+#include "itkVectorImage.h"
+#include "itkRealTimeClock.h"
+#include "itkSimpleFastMutexLock.h"
+#include <vector>
 
 namespace itk
 {
@@ -53,6 +57,24 @@ namespace itk
  * ProcessObject::ReleaseDataBeforeUpdateFlagOn().  A user may want to
  * set this flag to limit peak memory usage during a pipeline update.
  *
+ * By default the requested region is split into one piece per thread
+ * and each thread calls ThreadedGenerateData() once.  Filters whose
+ * per-pixel cost varies across the image can leave most threads idle
+ * while one piece finishes.  With DynamicMultiThreadingOn() the
+ * requested region is instead split into many small chunks that the
+ * threads pull from a shared queue, calling ThreadedGenerateData()
+ * once per chunk with their own threadId.  See
+ * SetDynamicMultiThreading().
+ *
+ * When the MultiThreader binds its threads to processors (see
+ * MultiThreader::SetThreadAffinity()) and AllocateOutputs() had to
+ * allocate a new buffer for the primary output, each thread touches the
+ * memory pages of its piece of the output before calling
+ * ThreadedGenerateData() on it.  With the usual first-touch page
+ * placement of the operating system, every piece then lives on the
+ * memory node of the processor that writes it, instead of wherever the
+ * allocating thread or BeforeThreadedGenerateData() happened to run.
+ *
  * \ingroup DataSources
  * \ingroup ITKCommon
  *
@@ -88,6 +110,9 @@ public:
   itkStaticConstMacro(OutputImageDimension, unsigned int,
                       TOutputImage::ImageDimension);
 
+  /** Type of the per-thread busy times. */
+  typedef std::vector< RealTimeClock::TimeStampType > ThreadBusyTimesType;
+
   /** Get the output data of this process object.  The output of this
    * function is not valid until an appropriate Update() method has
    * been called, either explicitly or implicitly.  Both the filter
@@ -208,9 +233,46 @@ public:
   using Superclass::MakeOutput;
   virtual DataObjectPointer MakeOutput(unsigned int idx);
 
+  /** Set/Get whether the default GenerateData() schedules the work
+   * dynamically.  When on, the output requested region is split with
+   * SplitRequestedRegion() into chunks of about
+   * DynamicMultiThreadingChunkSize pixels, and every thread repeatedly
+   * takes the next unprocessed chunk and passes it to
+   * ThreadedGenerateData() until none are left.  A thread may therefore
+   * call ThreadedGenerateData() several times, always with the same
+   * threadId, so this mode should only be turned on for filters whose
+   * ThreadedGenerateData() accumulates per-thread results rather than
+   * assigning them.  Off by default. */
+  itkSetMacro(DynamicMultiThreading, bool);
+  itkGetConstMacro(DynamicMultiThreading, bool);
+  itkBooleanMacro(DynamicMultiThreading);
+
+  /** Set/Get the approximate number of pixels in each chunk when
+   * DynamicMultiThreading is on.  The actual chunks are whole slabs
+   * along the axis chosen by SplitRequestedRegion().  When zero (the
+   * default) the requested region is split into eight chunks per
+   * thread. */
+  itkSetMacro(DynamicMultiThreadingChunkSize, SizeValueType);
+  itkGetConstMacro(DynamicMultiThreadingChunkSize, SizeValueType);
+
+  /** Set/Get the ImageBufferPool that AllocateOutputs() draws the pixel
+   * buffers of the Image and VectorImage outputs from.  If none is set,
+   * the global default pool is used, if any (see
+   * ImageBufferPool::SetGlobalDefaultPool()).  Giving the filters of a
+   * pipeline that is updated repeatedly a common pool lets them recycle
+   * each other's released buffers. */
+  itkSetObjectMacro(BufferPool, ImageBufferPool);
+  itkGetObjectMacro(BufferPool, ImageBufferPool);
+
+  /** Wall clock time, in seconds, that each thread spent in
+   * ThreadedGenerateData() during the last execution of the default
+   * GenerateData().  The entry at index i corresponds to threadId i. */
+  itkGetConstReferenceMacro(ThreadBusyTimes, ThreadBusyTimesType);
+
 protected:
   ImageSource();
   virtual ~ImageSource() {}
+  void PrintSelf(std::ostream & os, Indent indent) const;
 
   /** A version of GenerateData() specific for image processing
    * filters.  This implementation will split the processing across
@@ -259,7 +321,12 @@ protected:
    * outputs of a filter. Some filters may want to override this default
    * behavior. For example, a filter may have multiple outputs with
    * varying resolution. Or a filter may want to process data in place by
-   * grafting its input to its output. */
+   * grafting its input to its output.
+   *
+   * It also records whether the buffer of the primary output, if it is
+   * an Image or a VectorImage, had to be (re)allocated, in which case
+   * the threads of the default GenerateData() first touch its pages
+   * when the MultiThreader binds them to processors. */
   virtual void AllocateOutputs();
 
   /** If an imaging filter needs to perform processing after the buffer
@@ -307,6 +374,78 @@ protected:
 private:
   ImageSource(const Self &);    //purposely not implemented
   void operator=(const Self &); //purposely not implemented
+
+  /** Return the time stamp of the last allocation of the pixel buffer
+   * of images that have one, and zero for other outputs (e.g. a
+   * LabelMap). */
+  template< class TImage >
+  static unsigned long GetOutputAllocationMTime(TImage *)
+  { return 0; }
+  template< class TPixel >
+  static unsigned long GetOutputAllocationMTime(Image< TPixel, OutputImageDimension > *image)
+  { return image->GetPixelContainer()->GetAllocationMTime(); }
+  template< class TPixel >
+  static unsigned long GetOutputAllocationMTime(VectorImage< TPixel, OutputImageDimension > *image)
+  { return image->GetPixelContainer()->GetAllocationMTime(); }
+
+  /** Make the output draw its buffer from the given pool.  Does nothing
+   * for outputs that have no pixel buffer. */
+  template< class TImage >
+  static void SetOutputBufferPool(TImage *, ImageBufferPool *)
+  {}
+  template< class TPixel >
+  static void SetOutputBufferPool(Image< TPixel, OutputImageDimension > *image, ImageBufferPool *pool)
+  { image->GetPixelContainer()->SetBufferPool(pool); }
+  template< class TPixel >
+  static void SetOutputBufferPool(VectorImage< TPixel, OutputImageDimension > *image, ImageBufferPool *pool)
+  { image->GetPixelContainer()->SetBufferPool(pool); }
+
+  /** Touch the memory pages of the given region of the output, row by
+   * row, by rewriting one byte of each page with its own value.  Does
+   * nothing for outputs that have no pixel buffer. */
+  template< class TImage >
+  static void TouchOutputRegion(TImage *, const OutputImageRegionType &)
+  {}
+  template< class TPixel >
+  static void TouchOutputRegion(Image< TPixel, OutputImageDimension > *image,
+                                const OutputImageRegionType & region)
+  { TouchBufferRegion(image->GetBufferPointer(), image, 1, region); }
+  template< class TPixel >
+  static void TouchOutputRegion(VectorImage< TPixel, OutputImageDimension > *image,
+                                const OutputImageRegionType & region)
+  { TouchBufferRegion( image->GetBufferPointer(), image, image->GetNumberOfComponentsPerPixel(), region ); }
+
+  template< class TInternalPixel >
+  static void TouchBufferRegion(TInternalPixel *buffer,
+                                const ImageBase< OutputImageDimension > *image,
+                                unsigned int numberOfComponents,
+                                const OutputImageRegionType & region);
+
+  /** Return the index of the next chunk to process when scheduling
+   * dynamically, or m_NumberOfDynamicChunks once all have been handed
+   * out. */
+  unsigned int GetNextDynamicChunk();
+
+  bool          m_DynamicMultiThreading;
+  SizeValueType m_DynamicMultiThreadingChunkSize;
+
+  /** Number of chunks of the current execution; zero outside of the
+   * default GenerateData() or when scheduling statically.  The chunks
+   * are the pieces returned by SplitRequestedRegion() when asked for
+   * m_NumberOfRequestedDynamicChunks pieces. */
+  unsigned int        m_NumberOfDynamicChunks;
+  unsigned int        m_NumberOfRequestedDynamicChunks;
+  unsigned int        m_NextDynamicChunk;
+  SimpleFastMutexLock m_NextDynamicChunkLock;
+
+  RealTimeClock::Pointer m_Clock;
+  ThreadBusyTimesType    m_ThreadBusyTimes;
+
+  /** Whether the threads of the current execution first touch their
+   * piece of a newly allocated primary output. */
+  bool m_FirstTouchPrimaryOutput;
+
+  ImageBufferPool::Pointer m_BufferPool;
 };
 } // end namespace itk
 
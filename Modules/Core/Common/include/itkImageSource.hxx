@@ -32,6 +32,7 @@
 #include "itkOutputDataObjectIterator.h"
 
 #include "vnl/vnl_math.h"
+#include <algorithm>
 
 namespace itk
 {
@@ -40,7 +41,13 @@ namespace itk
  */
 template< class TOutputImage >
 ImageSource< TOutputImage >
-::ImageSource()
+::ImageSource():
+  m_DynamicMultiThreading(false),
+  m_DynamicMultiThreadingChunkSize(0),
+  m_NumberOfDynamicChunks(0),
+  m_NumberOfRequestedDynamicChunks(0),
+  m_NextDynamicChunk(0),
+  m_FirstTouchPrimaryOutput(false)
 {
   // Create the output. We use static_cast<> here because we know the default
   // output must be of type TOutputImage
@@ -162,6 +169,27 @@ ImageSource< TOutputImage >
   this->GraftOutput( this->MakeNameFromIndex(idx), graft );
 }
 
+//----------------------------------------------------------------------------
+template< class TOutputImage >
+void
+ImageSource< TOutputImage >
+::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "DynamicMultiThreading: " << m_DynamicMultiThreading << std::endl;
+  os << indent << "DynamicMultiThreadingChunkSize: "
+     << m_DynamicMultiThreadingChunkSize << std::endl;
+  os << indent << "BufferPool: " << m_BufferPool.GetPointer() << std::endl;
+  os << indent << "ThreadBusyTimes:";
+  for ( typename ThreadBusyTimesType::const_iterator it = m_ThreadBusyTimes.begin();
+        it != m_ThreadBusyTimes.end(); ++it )
+    {
+    os << " " << *it;
+    }
+  os << std::endl;
+}
+
 //----------------------------------------------------------------------------
 template< class TOutputImage >
 unsigned int
@@ -231,6 +259,22 @@ ImageSource< TOutputImage >
   typedef ImageBase< OutputImageDimension > ImageBaseType;
   typename ImageBaseType::Pointer outputPtr;
 
+  // Remember when the buffer of the primary output was last allocated, to
+  // find out whether it is reused or newly allocated.  Only the latter
+  // needs to be placed.
+  OutputImageType *primaryOutput = 0;
+  unsigned long    previousAllocationMTime = 0;
+  m_FirstTouchPrimaryOutput = false;
+  if ( this->GetMultiThreader()->GetThreadAffinity() && !m_DynamicMultiThreading
+       && this->GetNumberOfOutputs() > 0 )
+    {
+    primaryOutput = dynamic_cast< OutputImageType * >( this->ProcessObject::GetOutput(0) );
+    if ( primaryOutput )
+      {
+      previousAllocationMTime = GetOutputAllocationMTime(primaryOutput);
+      }
+    }
+
   // Allocate the output memory
   for ( OutputDataObjectIterator it(this); !it.IsAtEnd(); it++ )
     {
@@ -243,8 +287,73 @@ ImageSource< TOutputImage >
 
     if ( outputPtr )
       {
+      OutputImageType *image = dynamic_cast< OutputImageType * >( outputPtr.GetPointer() );
+      if ( image )
+        {
+        SetOutputBufferPool(image, m_BufferPool);
+        }
       outputPtr->SetBufferedRegion( outputPtr->GetRequestedRegion() );
-      outputPtr->Allocate();
+      // ThreadedGenerateData() overwrites every pixel, so there is no
+      // need to initialize them.
+      outputPtr->Allocate(false);
+      }
+    }
+
+  // The threads that will compute the new buffer first touch it.  The
+  // allocation time stamps are global, so this also holds when Allocate()
+  // replaced the pixel container.
+  if ( primaryOutput )
+    {
+    m_FirstTouchPrimaryOutput =
+      GetOutputAllocationMTime(primaryOutput) > previousAllocationMTime;
+    }
+}
+
+//----------------------------------------------------------------------------
+template< class TOutputImage >
+template< class TInternalPixel >
+void
+ImageSource< TOutputImage >
+::TouchBufferRegion(TInternalPixel *buffer,
+                    const ImageBase< OutputImageDimension > *image,
+                    unsigned int numberOfComponents,
+                    const OutputImageRegionType & region)
+{
+  if ( region.GetNumberOfPixels() == 0 )
+    {
+    return;
+    }
+
+  // The usual size of a memory page.  Touching more often is harmless.
+  const size_t pageSize = 4096;
+
+  const size_t        rowBytes = region.GetSize(0) * numberOfComponents * sizeof( TInternalPixel );
+  const SizeValueType numberOfRows = region.GetNumberOfPixels() / region.GetSize(0);
+
+  typename OutputImageRegionType::IndexType index = region.GetIndex();
+  for ( SizeValueType row = 0; row < numberOfRows; ++row )
+    {
+    // Rewrite the first byte of the row, and of every page it crosses,
+    // with its own value: the pixels are left alone, whether or not
+    // BeforeThreadedGenerateData() already set them.
+    volatile unsigned char *rowBegin = reinterpret_cast< volatile unsigned char * >(
+      buffer + image->ComputeOffset(index) * numberOfComponents );
+    volatile unsigned char *rowEnd = rowBegin + rowBytes;
+    for ( volatile unsigned char *byte = rowBegin; byte < rowEnd;
+          byte += pageSize - reinterpret_cast< size_t >( byte ) % pageSize )
+      {
+      *byte = *byte;
+      }
+
+    // move to the first pixel of the next row
+    for ( unsigned int dim = 1; dim < OutputImageDimension; ++dim )
+      {
+      ++index[dim];
+      if ( index[dim] < region.GetIndex(dim) + static_cast< IndexValueType >( region.GetSize(dim) ) )
+        {
+        break;
+        }
+      index[dim] = region.GetIndex(dim);
       }
     }
 }
@@ -271,14 +380,70 @@ ImageSource< TOutputImage >
   this->GetMultiThreader()->SetNumberOfThreads( this->GetNumberOfThreads() );
   this->GetMultiThreader()->SetSingleMethod(this->ThreaderCallback, &str);
 
+  // The MultiThreader may have clamped the number of threads.
+  const ThreadIdType numberOfThreads = this->GetMultiThreader()->GetNumberOfThreads();
+  if ( !m_Clock )
+    {
+    m_Clock = RealTimeClock::New();
+    }
+  m_ThreadBusyTimes.assign(numberOfThreads, 0.0);
+
+  if ( m_DynamicMultiThreading )
+    {
+    unsigned int numberOfChunks = 8 * numberOfThreads;
+    if ( m_DynamicMultiThreadingChunkSize > 0 )
+      {
+      const SizeValueType numberOfPixels =
+        this->GetOutput()->GetRequestedRegion().GetNumberOfPixels();
+      numberOfChunks = static_cast< unsigned int >(
+        std::min< SizeValueType >( NumericTraits< unsigned int >::max(),
+                                   ( numberOfPixels + m_DynamicMultiThreadingChunkSize - 1 )
+                                   / m_DynamicMultiThreadingChunkSize ) );
+      numberOfChunks = std::max( numberOfChunks, 1u );
+      }
+
+    // find out how many pieces the region can actually be split into
+    OutputImageRegionType splitRegion;
+    m_NumberOfRequestedDynamicChunks = numberOfChunks;
+    m_NumberOfDynamicChunks = this->SplitRequestedRegion(0, numberOfChunks, splitRegion);
+    m_NextDynamicChunk = 0;
+    }
+
   // multithread the execution
-  this->GetMultiThreader()->SingleMethodExecute();
+  try
+    {
+    this->GetMultiThreader()->SingleMethodExecute();
+    }
+  catch ( ... )
+    {
+    m_NumberOfDynamicChunks = 0;
+    m_FirstTouchPrimaryOutput = false;
+    throw;
+    }
+  m_NumberOfDynamicChunks = 0;
+  m_FirstTouchPrimaryOutput = false;
 
   // Call a method that can be overridden by a subclass to perform
   // some calculations after all the threads have completed
   this->AfterThreadedGenerateData();
 }
 
+//----------------------------------------------------------------------------
+template< class TOutputImage >
+unsigned int
+ImageSource< TOutputImage >
+::GetNextDynamicChunk()
+{
+  m_NextDynamicChunkLock.Lock();
+  const unsigned int chunk = m_NextDynamicChunk;
+  if ( m_NextDynamicChunk < m_NumberOfDynamicChunks )
+    {
+    ++m_NextDynamicChunk;
+    }
+  m_NextDynamicChunkLock.Unlock();
+  return chunk;
+}
+
 //----------------------------------------------------------------------------
 // The execute method created by the subclass.
 template< class TOutputImage >
@@ -317,22 +482,54 @@ ImageSource< TOutputImage >
 
   str = (ThreadStruct *)( ( (MultiThreader::ThreadInfoStruct *)( arg ) )->UserData );
 
-  // execute the actual method with appropriate output region
-  // first find out how many pieces extent can be split into.
+  Self *filter = str->Filter;
+  const bool timed = filter->m_Clock && threadId < filter->m_ThreadBusyTimes.size();
+  RealTimeClock::TimeStampType start = 0.0;
+  if ( timed )
+    {
+    start = filter->m_Clock->GetTimeInSeconds();
+    }
+
   typename TOutputImage::RegionType splitRegion;
-  total = str->Filter->SplitRequestedRegion(threadId, threadCount,
-                                            splitRegion);
+  if ( filter->m_NumberOfDynamicChunks > 0 )
+    {
+    // pull chunks from the shared queue until it is exhausted
+    const unsigned int numberOfChunks = filter->m_NumberOfDynamicChunks;
+    for ( unsigned int chunk = filter->GetNextDynamicChunk();
+          chunk < numberOfChunks;
+          chunk = filter->GetNextDynamicChunk() )
+      {
+      filter->SplitRequestedRegion(chunk, filter->m_NumberOfRequestedDynamicChunks, splitRegion);
+      filter->ThreadedGenerateData(splitRegion, threadId);
+      }
+    }
+  else
+    {
+    // execute the actual method with appropriate output region
+    // first find out how many pieces extent can be split into.
+    total = filter->SplitRequestedRegion(threadId, threadCount,
+                                         splitRegion);
+
+    if ( threadId < total )
+      {
+      if ( filter->m_FirstTouchPrimaryOutput )
+        {
+        TouchOutputRegion(filter->GetOutput(), splitRegion);
+        }
+      filter->ThreadedGenerateData(splitRegion, threadId);
+      }
+    // else
+    //   {
+    //   otherwise don't use this thread. Sometimes the threads dont
+    //   break up very well and it is just as efficient to leave a
+    //   few threads idle.
+    //   }
+    }
 
-  if ( threadId < total )
+  if ( timed )
     {
-    str->Filter->ThreadedGenerateData(splitRegion, threadId);
+    filter->m_ThreadBusyTimes[threadId] = filter->m_Clock->GetTimeInSeconds() - start;
     }
-  // else
-  //   {
-  //   otherwise don't use this thread. Sometimes the threads dont
-  //   break up very well and it is just as efficient to leave a
-  //   few threads idle.
-  //   }
 
   return ITK_THREAD_RETURN_VALUE;
 }
@@ -19,6 +19,7 @@
 #define __itkImportImageContainer_h
 
 #include "itkObject.h"
+#include "itkImageBufferPool.h"
 #include "itkObjectFactory.h"
 #include <utility>
 
@@ -36,6 +37,22 @@ namespace itk
  *
  * \tparam TElement The element type stored in the container.
  *
+ * By default the container allocates its memory with new[] in
+ * AllocateElements(), and releases it with delete[].  Its elements are
+ * default constructed, which leaves built-in types uninitialized:
+ * callers that do not overwrite every element must ask Reserve() for
+ * initialized elements.
+ *
+ * With UseAlignedAllocationOn(), or when an ImageBufferPool applies (see
+ * SetBufferPool()), the container instead allocates blocks aligned to
+ * BufferAlignment bytes, so that vectorized code may use aligned loads
+ * from the start of the buffer, drawing them from the pool if any.  Such
+ * blocks are not obtained from new[] and AllocateElements() is not
+ * called for them; an application that takes over one of them (see
+ * SetContainerManageMemory()) must release it with FreeElements().  The
+ * container records how each buffer was allocated and releases it
+ * accordingly.
+ *
  * \ingroup ImageObjects
  * \ingroup IOFilters
  * \ingroup ITKCommon
@@ -61,6 +78,9 @@ public:
   /** Standard part of every itk Object. */
   itkTypeMacro(ImportImageContainer, Object);
 
+  /** Alignment, in bytes, of the buffers allocated by the container. */
+  itkStaticConstMacro(BufferAlignment, unsigned int, 64);
+
   /** Get the pointer from which the image data is imported. */
   TElement * GetImportPointer() { return m_ImportPointer; }
 
@@ -73,6 +93,16 @@ public:
   void SetImportPointer(TElement *ptr, TElementIdentifier num,
                         bool LetContainerManageMemory = false);
 
+  /** Set/Get an object that is kept alive for as long as the container
+   * uses the current import pointer, such as the memory mapping of a
+   * file that the pointer points into.  Set it after SetImportPointer();
+   * it is released, with the pointer, when the container stops using
+   * it. */
+  void SetImportPointerOwner(LightObject *owner)
+  { m_ImportPointerOwner = owner; }
+  LightObject * GetImportPointerOwner()
+  { return m_ImportPointerOwner.GetPointer(); }
+
   /** Index operator. This version can be an lvalue. */
   TElement & operator[](const ElementIdentifier id)
   { return m_ImportPointer[id]; }
@@ -105,8 +135,13 @@ public:
    * container. However, in this particular case, Reserve as a Resize
    * semantics that is kept for backward compatibility reasons.
    *
+   * Newly allocated elements are default constructed, i.e. left
+   * uninitialized for built-in types.  If UseDefaultConstructor is true,
+   * all the num elements are instead set to TElement(), which is zero for
+   * built-in types, whether or not memory was allocated.
+   *
    * \sa SetImportPointer() */
-  void Reserve(ElementIdentifier num);
+  void Reserve(ElementIdentifier num, const bool UseDefaultConstructor = false);
 
   /** Tell the container to try to minimize its memory usage for
    * storage of the current number of elements.  If new memory is
@@ -119,6 +154,12 @@ public:
   /** Tell the container to release any of its allocated memory. */
   void Initialize(void);
 
+  /** Return the time stamp of the last allocation of a buffer by the
+   * container, in Reserve() or Squeeze().  Comparing it before and after
+   * a call to Reserve() tells whether new memory was allocated. */
+  unsigned long GetAllocationMTime() const
+  { return m_AllocationTime.GetMTime(); }
+
   /** These methods allow to define whether upon destruction of this class
    *  the memory buffer should be released or not.  Setting it to true
    *  (or ON) makes that this class will take care of memory release.
@@ -131,6 +172,36 @@ public:
   itkSetMacro(ContainerManageMemory, bool);
   itkGetConstMacro(ContainerManageMemory, bool);
   itkBooleanMacro(ContainerManageMemory);
+
+  /** Destroy the size elements of an aligned block allocated by the
+   * container, and release its memory.  This is needed only by
+   * applications that took over such a buffer by turning
+   * ContainerManageMemory off, see GetBufferIsAlignedBlock(); other
+   * buffers are released with delete[]. */
+  static void FreeElements(TElement *data, ElementIdentifier size);
+
+  /** Set/Get the pool that the memory of the next buffer allocated by
+   * the container is drawn from.  If none is set, the global default
+   * ImageBufferPool is used, if any.  A buffer is always returned to the
+   * pool it was drawn from.  Buffers drawn from a pool are aligned
+   * blocks, see UseAlignedAllocationOn(). */
+  itkSetObjectMacro(BufferPool, ImageBufferPool);
+  itkGetObjectMacro(BufferPool, ImageBufferPool);
+
+  /** Set/Get whether the buffers allocated from now on are aligned to
+   * BufferAlignment bytes.  Off by default, in which case the buffers
+   * come from AllocateElements().  Aligned buffers must be released with
+   * FreeElements() by applications that take them over. */
+  itkSetMacro(UseAlignedAllocation, bool);
+  itkGetConstMacro(UseAlignedAllocation, bool);
+  itkBooleanMacro(UseAlignedAllocation);
+
+  /** Whether the current buffer is an aligned block allocated by the
+   * container, to be released with FreeElements(), rather than memory
+   * from AllocateElements() or SetImportPointer(), released with
+   * delete[]. */
+  bool GetBufferIsAlignedBlock() const
+  { return m_ContainerAllocatedBlock; }
 protected:
   ImportImageContainer();
   virtual ~ImportImageContainer();
@@ -140,8 +211,13 @@ protected:
    * call this method but should call Print() instead. */
   void PrintSelf(std::ostream & os, Indent indent) const;
 
+  /** Allocate memory for size default constructed elements with new[],
+   * throwing a MemoryAllocationError on failure.  Subclasses that
+   * override it must also override DeallocateManagedMemory() if the
+   * memory is not to be released with delete[]. */
   virtual TElement * AllocateElements(ElementIdentifier size) const;
 
+  /** Destroy and release the buffer, if the container manages it. */
   virtual void DeallocateManagedMemory();
 
   /* Set the m_Size member that represents the number of elements
@@ -173,6 +249,37 @@ private:
   TElementIdentifier m_Size;
   TElementIdentifier m_Capacity;
   bool               m_ContainerManageMemory;
+
+  /** Allocate a buffer for size elements, as an aligned block if
+   * aligned allocation is on or a pool applies, and with
+   * AllocateElements() otherwise.  Sets isBlock accordingly. */
+  TElement * AllocateBuffer(ElementIdentifier size, bool & isBlock) const;
+
+  /** Allocate a BufferAlignment aligned block for size default
+   * constructed elements, drawn from the pool if any, throwing a
+   * MemoryAllocationError on failure. */
+  TElement * AllocateBlock(ElementIdentifier size) const;
+
+  /** Whether m_ImportPointer is a block from AllocateBlock(), released
+   * with FreeElements(), rather than memory from AllocateElements() or
+   * SetImportPointer(), released with delete[]. */
+  bool m_ContainerAllocatedBlock;
+
+  bool m_UseAlignedAllocation;
+
+  ImageBufferPool::Pointer m_BufferPool;
+
+  LightObject::Pointer m_ImportPointerOwner;
+
+  TimeStamp m_AllocationTime;
+
+  /** Stored in front of the elements of the memory allocated by the
+   * container, so that FreeElements() can release it. */
+  struct BlockHeader {
+    void *Block;
+    ImageBufferPool *Pool;
+    SizeValueType NumberOfBytes;
+  };
 };
 } // end namespace itk
 
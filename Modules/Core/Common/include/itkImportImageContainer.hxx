@@ -29,7 +29,9 @@
 #define __itkImportImageContainer_hxx
 
 #include "itkImportImageContainer.h"
+#include <algorithm>
 #include <cstring>
+#include <new>
 #include <stdlib.h>
 #include <string.h>
 
@@ -41,6 +43,8 @@ ImportImageContainer< TElementIdentifier, TElement >
 {
   m_ImportPointer = 0;
   m_ContainerManageMemory = true;
+  m_ContainerAllocatedBlock = false;
+  m_UseAlignedAllocation = false;
   m_Capacity = 0;
   m_Size = 0;
 }
@@ -59,7 +63,7 @@ ImportImageContainer< TElementIdentifier, TElement >
 template< typename TElementIdentifier, typename TElement >
 void
 ImportImageContainer< TElementIdentifier, TElement >
-::Reserve(ElementIdentifier size)
+::Reserve(ElementIdentifier size, const bool UseDefaultConstructor)
 {
   // Reserve has a Resize semantics. We keep it that way for
   // backwards compatibility .
@@ -68,7 +72,8 @@ ImportImageContainer< TElementIdentifier, TElement >
     {
     if ( size > m_Capacity )
       {
-      TElement *temp = this->AllocateElements(size);
+      bool      isBlock;
+      TElement *temp = this->AllocateBuffer(size, isBlock);
       // only copy the portion of the data used in the old buffer
       memcpy( temp, m_ImportPointer, m_Size * sizeof( TElement ) );
 
@@ -76,6 +81,8 @@ ImportImageContainer< TElementIdentifier, TElement >
 
       m_ImportPointer = temp;
       m_ContainerManageMemory = true;
+      m_ContainerAllocatedBlock = isBlock;
+      m_AllocationTime.Modified();
       m_Capacity = size;
       m_Size = size;
       this->Modified();
@@ -88,12 +95,20 @@ ImportImageContainer< TElementIdentifier, TElement >
     }
   else
     {
-    m_ImportPointer = this->AllocateElements(size);
+    bool isBlock;
+    m_ImportPointer = this->AllocateBuffer(size, isBlock);
     m_Capacity = size;
     m_Size = size;
     m_ContainerManageMemory = true;
+    m_ContainerAllocatedBlock = isBlock;
+    m_AllocationTime.Modified();
     this->Modified();
     }
+
+  if ( UseDefaultConstructor )
+    {
+    std::fill( m_ImportPointer, m_ImportPointer + size, TElement() );
+    }
 }
 
 /**
@@ -110,13 +125,16 @@ ImportImageContainer< TElementIdentifier, TElement >
     if ( m_Size < m_Capacity )
       {
       const TElementIdentifier size = m_Size;
-      TElement *               temp = this->AllocateElements(size);
+      bool                     isBlock;
+      TElement *               temp = this->AllocateBuffer(size, isBlock);
       memcpy( temp, m_ImportPointer, size * sizeof( TElement ) );
 
       DeallocateManagedMemory();
 
       m_ImportPointer = temp;
       m_ContainerManageMemory = true;
+      m_ContainerAllocatedBlock = isBlock;
+      m_AllocationTime.Modified();
       m_Capacity = size;
       m_Size = size;
 
@@ -161,6 +179,7 @@ ImportImageContainer< TElementIdentifier, TElement >
   DeallocateManagedMemory();
   m_ImportPointer = ptr;
   m_ContainerManageMemory = LetContainerManageMemory;
+  m_ContainerAllocatedBlock = false;
   m_Capacity = num;
   m_Size = num;
 
@@ -195,6 +214,101 @@ TElement *ImportImageContainer< TElementIdentifier, TElement >
   return data;
 }
 
+template< typename TElementIdentifier, typename TElement >
+TElement *ImportImageContainer< TElementIdentifier, TElement >
+::AllocateBuffer(ElementIdentifier size, bool & isBlock) const
+{
+  isBlock = m_UseAlignedAllocation || m_BufferPool || ImageBufferPool::GetGlobalDefaultPool();
+  return isBlock ? this->AllocateBlock(size) : this->AllocateElements(size);
+}
+
+template< typename TElementIdentifier, typename TElement >
+TElement *ImportImageContainer< TElementIdentifier, TElement >
+::AllocateBlock(ElementIdentifier size) const
+{
+  // The block is over-allocated so that the elements can start at the
+  // next multiple of BufferAlignment, with a BlockHeader telling
+  // FreeElements() where the block came from just in front of them.
+  const size_t overhead = BufferAlignment + sizeof( BlockHeader );
+  TElement    *data = 0;
+
+  if ( static_cast< size_t >( size ) <= ( static_cast< size_t >( -1 ) - overhead ) / sizeof( TElement ) )
+    {
+    const SizeValueType numberOfBytes = static_cast< size_t >( size ) * sizeof( TElement ) + overhead;
+
+    ImageBufferPool::Pointer pool = m_BufferPool;
+    if ( !pool )
+      {
+      pool = ImageBufferPool::GetGlobalDefaultPool();
+      }
+    char *block = static_cast< char * >( pool ? pool->AcquireBlock(numberOfBytes) : malloc(numberOfBytes) );
+    if ( block )
+      {
+      const size_t address = reinterpret_cast< size_t >( block + sizeof( BlockHeader ) );
+      char *aligned = block + sizeof( BlockHeader )
+                      + ( BufferAlignment - address % BufferAlignment ) % BufferAlignment;
+      BlockHeader *header = reinterpret_cast< BlockHeader * >( aligned ) - 1;
+      header->Block = block;
+      header->Pool = pool.GetPointer();
+      header->NumberOfBytes = numberOfBytes;
+      if ( pool )
+        {
+        // keep the pool alive until the block is given back
+        pool->Register();
+        }
+      data = reinterpret_cast< TElement * >( aligned );
+
+      // Default construction leaves built-in types untouched, so this
+      // loop costs nothing for them and the pages are first written by
+      // whoever fills the buffer.
+      ElementIdentifier constructed = 0;
+      try
+        {
+        for (; constructed < size; ++constructed )
+          {
+          new( data + constructed ) TElement;
+          }
+        }
+      catch ( ... )
+        {
+        FreeElements(data, constructed);
+        data = 0;
+        }
+      }
+    }
+  if ( !data )
+    {
+    // We cannot construct an error string here because we may be out
+    // of memory.  Do not use the exception macro.
+    throw MemoryAllocationError(__FILE__, __LINE__,
+                                "Failed to allocate memory for image.",
+                                ITK_LOCATION);
+    }
+  return data;
+}
+
+template< typename TElementIdentifier, typename TElement >
+void ImportImageContainer< TElementIdentifier, TElement >
+::FreeElements(TElement *data, ElementIdentifier size)
+{
+  for ( ElementIdentifier i = 0; i < size; ++i )
+    {
+    data[i].~TElement();
+    }
+
+  const BlockHeader *header = reinterpret_cast< BlockHeader * >( data ) - 1;
+  if ( header->Pool )
+    {
+    ImageBufferPool *pool = header->Pool;
+    pool->ReleaseBlock(header->Block, header->NumberOfBytes);
+    pool->UnRegister();
+    }
+  else
+    {
+    free(header->Block);
+    }
+}
+
 template< typename TElementIdentifier, typename TElement >
 void ImportImageContainer< TElementIdentifier, TElement >
 ::DeallocateManagedMemory()
@@ -202,9 +316,18 @@ void ImportImageContainer< TElementIdentifier, TElement >
   // Encapsulate all image memory deallocation here
   if ( m_ImportPointer && m_ContainerManageMemory )
     {
-    delete[] m_ImportPointer;
+    if ( m_ContainerAllocatedBlock )
+      {
+      FreeElements(m_ImportPointer, m_Capacity);
+      }
+    else
+      {
+      delete[] m_ImportPointer;
+      }
     }
   m_ImportPointer = 0;
+  m_ImportPointerOwner = 0;
+  m_ContainerAllocatedBlock = false;
   m_Capacity = 0;
   m_Size = 0;
 }
@@ -219,6 +342,11 @@ ImportImageContainer< TElementIdentifier, TElement >
   os << indent << "Pointer: " << static_cast< void * >( m_ImportPointer ) << std::endl;
   os << indent << "Container manages memory: "
      << ( m_ContainerManageMemory ? "true" : "false" ) << std::endl;
+  os << indent << "Use aligned allocation: "
+     << ( m_UseAlignedAllocation ? "true" : "false" ) << std::endl;
+  os << indent << "Buffer is aligned block: "
+     << ( m_ContainerAllocatedBlock ? "true" : "false" ) << std::endl;
+  os << indent << "Import pointer owner: " << m_ImportPointerOwner.GetPointer() << std::endl;
   os << indent << "Size: " << m_Size << std::endl;
   os << indent << "Capacity: " << m_Capacity << std::endl;
 }
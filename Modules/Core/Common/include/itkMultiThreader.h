@@ -30,7 +30,9 @@
 
 #include "itkMutexLock.h"
 #include "itkThreadSupport.h"
+#include "itkThreadPool.h"
 #include "itkIntTypes.h"
+#include <vector>
 
 namespace itk
 {
@@ -47,6 +49,11 @@ namespace itk
  * If ITK_USE_PTHREADS is defined, then
  * pthread_create() will be used to create multiple threads (on
  * a sun, for example).
+ *
+ * By default SingleMethodExecute() does not create threads itself but
+ * dispatches the work onto the persistent workers of the process-wide
+ * ThreadPool, which avoids the cost of creating and joining threads on
+ * every execution.  See SetUseThreadPool().
  * \ingroup ITKCommon
  */
 
@@ -73,10 +80,13 @@ public:
   itkGetConstMacro(NumberOfThreads, ThreadIdType);
 
   /** Set/Get the maximum number of threads to use when multithreading.  It
-   * will be clamped to the range [ 1, ITK_MAX_THREADS ] because several arrays
-   * are already statically allocated using the ITK_MAX_THREADS number.
-   * Therefore the caller of this method should check that the requested number
-   * of threads was accepted. */
+   * will be clamped to be at least 1 (and at most 1 when ITK is built
+   * without a threading library); the per-thread storage is sized at run
+   * time, so there is no other upper bound.  It defaults to
+   * ITK_MAX_THREADS, and is raised automatically the first time the
+   * global default number of threads is computed if the platform or the
+   * environment asks for more threads, unless it has been set
+   * explicitly before. */
   static void SetGlobalMaximumNumberOfThreads(ThreadIdType val);
 
   static ThreadIdType  GetGlobalMaximumNumberOfThreads();
@@ -89,6 +99,41 @@ public:
 
   static ThreadIdType  GetGlobalDefaultNumberOfThreads();
 
+  /** Set/Get whether SingleMethodExecute() runs on the persistent workers
+   * of the ThreadPool rather than on freshly created threads. */
+  itkSetMacro(UseThreadPool, bool);
+  itkGetConstMacro(UseThreadPool, bool);
+  itkBooleanMacro(UseThreadPool);
+
+  /** Set/Get the value which is used to initialize UseThreadPool in the
+   * constructor.  Unless set explicitly, it is read the first time it is
+   * needed from the ITK_GLOBAL_DEFAULT_USE_THREAD_POOL environment
+   * variable ("0", "OFF", "NO" or "FALSE" disable the pool) and otherwise
+   * defaults to true. */
+  static void SetGlobalDefaultUseThreadPool(bool useThreadPool);
+
+  static bool GetGlobalDefaultUseThreadPool();
+
+  /** Set/Get whether the threads running ThreadIDs 1 to
+   * NumberOfThreads-1 of SingleMethodExecute() are each bound to one
+   * processor while they run.  The processor is chosen from the ThreadID
+   * among those the process may use, so that a given ThreadID always runs
+   * on the same processor.  This keeps memory that a thread touched first
+   * local to it on NUMA machines (see ImageSource::AllocateOutputs()).
+   * The calling thread, which runs ThreadID 0, is never bound.  Thread
+   * affinity is supported on Linux and Windows and ignored elsewhere. */
+  itkSetMacro(ThreadAffinity, bool);
+  itkGetConstMacro(ThreadAffinity, bool);
+  itkBooleanMacro(ThreadAffinity);
+
+  /** Set/Get the value which is used to initialize ThreadAffinity in the
+   * constructor.  Unless set explicitly, it is read the first time it is
+   * needed from the ITK_GLOBAL_DEFAULT_THREAD_AFFINITY environment
+   * variable and otherwise defaults to false. */
+  static void SetGlobalDefaultThreadAffinity(bool threadAffinity);
+
+  static bool GetGlobalDefaultThreadAffinity();
+
   /** Execute the SingleMethod (as define by SetSingleMethod) using
    * m_NumberOfThreads threads. As a side effect the m_NumberOfThreads will be
    * checked against the current m_GlobalMaximumNumberOfThreads and clamped if
@@ -113,7 +158,8 @@ public:
   void SetMultipleMethod(ThreadIdType index, ThreadFunctionType, void *data);
 
   /** Create a new thread for the given function. Return a thread id
-     * which is a number between 0 and ITK_MAX_THREADS - 1. This
+   * which is a number between 0 and ITK_MAX_THREADS - 1, which is the
+   * number of threads that can be spawned simultaneously. This
    * id should be used to kill the thread at a later time. */
   // FIXME: Doesn't seem to be called anywhere...
   int SpawnThread(ThreadFunctionType, void *data);
@@ -154,13 +200,14 @@ private:
   void operator=(const Self &); //purposely not implemented
 
   /** An array of thread info containing a thread id
-   *  (0, 1, 2, .. ITK_MAX_THREADS-1), the thread count, and a pointer
-   *  to void so that user data can be passed to each thread. */
-  ThreadInfoStruct m_ThreadInfoArray[ITK_MAX_THREADS];
+   *  (0, 1, 2, .. m_NumberOfThreads-1), the thread count, and a pointer
+   *  to void so that user data can be passed to each thread. It is
+   *  resized, never shrunk, by SetNumberOfThreads(). */
+  std::vector< ThreadInfoStruct > m_ThreadInfoArray;
 
   /** The methods to invoke. */
-  ThreadFunctionType m_SingleMethod;
-  ThreadFunctionType m_MultipleMethod[ITK_MAX_THREADS];
+  ThreadFunctionType                m_SingleMethod;
+  std::vector< ThreadFunctionType > m_MultipleMethod;
 
   /** Storage of MutexFunctions and ints used to control spawned
    *  threads and the spawned thread ids. */
@@ -170,14 +217,17 @@ private:
   ThreadInfoStruct    m_SpawnedThreadInfoArray[ITK_MAX_THREADS];
 
   /** Internal storage of the data. */
-  void *m_SingleData;
-  void *m_MultipleData[ITK_MAX_THREADS];
+  void                 *m_SingleData;
+  std::vector< void * > m_MultipleData;
 
   /** Global variable defining the maximum number of threads that can be used.
-   *  The m_GlobalMaximumNumberOfThreads must always be less than or equal to
-   *  ITK_MAX_THREADS and greater than zero. */
+   *  The m_GlobalMaximumNumberOfThreads must always be greater than zero. */
   static ThreadIdType m_GlobalMaximumNumberOfThreads;
 
+  /** Whether SetGlobalMaximumNumberOfThreads() has been called, in which
+   *  case the maximum is no longer raised to the default automatically. */
+  static bool m_GlobalMaximumNumberOfThreadsHasBeenSet;
+
   /*  Global variable defining the default number of threads to set at
    *  construction time of a MultiThreader instance.  The
    *  m_GlobalDefaultNumberOfThreads must always be less than or equal to the
@@ -189,6 +239,13 @@ private:
   /**  Platform specific number of threads */
   static ThreadIdType  GetGlobalDefaultNumberOfThreadsByPlatform();
 
+  /** Clamp a number of threads to the range supported by the threading
+   *  library, i.e. at least one and, without threads, at most one. */
+  static ThreadIdType ClampNumberOfThreads(ThreadIdType numberOfThreads);
+
+  /** Grow the per-thread arrays to hold at least numberOfThreads entries. */
+  void ResizeThreadArrays(ThreadIdType numberOfThreads);
+
   /** The number of threads to use.
    *  The m_NumberOfThreads must always be less than or equal to
    *  the m_GlobalMaximumNumberOfThreads before it is used during the execution
@@ -200,6 +257,21 @@ private:
    */
   ThreadIdType m_NumberOfThreads;
 
+  /** Whether SingleMethodExecute() dispatches onto the ThreadPool, and the
+   *  jobs used to do so. */
+  bool                               m_UseThreadPool;
+  std::vector< ThreadPool::ThreadJob > m_ThreadJobArray;
+
+  /** Global default for m_UseThreadPool. */
+  static bool m_GlobalDefaultUseThreadPool;
+  static bool m_GlobalDefaultUseThreadPoolInitialized;
+
+  /** Whether the threads of SingleMethodExecute() are bound to
+   *  processors, and its global default. */
+  bool        m_ThreadAffinity;
+  static bool m_GlobalDefaultThreadAffinity;
+  static bool m_GlobalDefaultThreadAffinityInitialized;
+
   /** Static function used as a "proxy callback" by the MultiThreader.  The
    * threading library will call this routine for each thread, which
    * will delegate the control to the prescribed SingleMethod. This
@@ -208,6 +280,12 @@ private:
    * exceptions thrown by the threads. */
   static ITK_THREAD_RETURN_TYPE SingleMethodProxy(void *arg);
 
+  /** Same as SingleMethodProxy(), but binds the calling thread to the
+   * processor assigned to its ThreadID for the duration of the call and
+   * restores the previous affinity afterwards.  Used when ThreadAffinity
+   * is on; implemented per threading library. */
+  static ITK_THREAD_RETURN_TYPE AffinitySingleMethodProxy(void *arg);
+
   /** Spawn a thread for the prescribed SingleMethod.  This routine
    * spawns a thread to the SingleMethodProxy which runs the
    * prescribed SingleMethod.  The SingleMethodProxy allows for
@@ -297,6 +297,14 @@ public:
   /** Actually generate new output  */
   virtual void UpdateOutputData(DataObject *output);
 
+  /** Start generating the requested region of the output in the
+   * background, if this process object can, ahead of the
+   * UpdateOutputData() that will ask for it.  Called from
+   * DataObject::PrefetchRequestedRegion(), after the requested regions
+   * have been propagated.  The default implementation passes the request
+   * on to the inputs. */
+  virtual void PrefetchRequestedRegion(DataObject *output);
+
   /** Give the process object a chance to indictate that it will produce more
    * output than it was requested to produce. For example, many imaging
    * filters must compute the entire output at once or can only produce output
@@ -353,8 +361,10 @@ public:
   itkGetConstReferenceMacro(ReleaseDataBeforeUpdateFlag, bool);
   itkBooleanMacro(ReleaseDataBeforeUpdateFlag);
 
-  /** Get/Set the number of threads to create when executing. */
-  itkSetClampMacro(NumberOfThreads, ThreadIdType, 1, ITK_MAX_THREADS);
+  /** Get/Set the number of threads to create when executing.  The value
+   * is clamped to be at least 1; the MultiThreader further limits it to
+   * MultiThreader::GetGlobalMaximumNumberOfThreads() when executing. */
+  virtual void SetNumberOfThreads(ThreadIdType numberOfThreads);
   itkGetConstReferenceMacro(NumberOfThreads, ThreadIdType);
 
   /** Return the multithreader used by this class. */
@@ -96,6 +96,23 @@ public:
       }
   }
 
+  /** Called by a filter after completing numberOfPixels pixels at once,
+   * like calling CompletedPixel() as many times, but updating the
+   * progress only once. */
+  void CompletedPixels(SizeValueType numberOfPixels)
+  {
+    if ( numberOfPixels < m_PixelsBeforeUpdate )
+      {
+      m_PixelsBeforeUpdate -= numberOfPixels;
+      return;
+      }
+    const SizeValueType pixelsAfterUpdate = numberOfPixels - m_PixelsBeforeUpdate;
+    m_CurrentPixel += ( pixelsAfterUpdate / m_PixelsPerUpdate ) * m_PixelsPerUpdate;
+    m_PixelsBeforeUpdate = 1;
+    this->CompletedPixel(); // potential exception thrown here
+    m_PixelsBeforeUpdate = m_PixelsPerUpdate - pixelsAfterUpdate % m_PixelsPerUpdate;
+  }
+
 protected:
   ProcessObject *m_Filter;
   ThreadIdType   m_ThreadId;
@@ -169,8 +169,9 @@ public:
   typedef typename PixelContainer::ConstPointer PixelContainerConstPointer;
 
   /** Allocate the image memory. The size of the image must
-   * already be set, e.g. by calling SetRegions(). */
-  void Allocate();
+   * already be set, e.g. by calling SetRegions().  The pixels are only
+   * initialized if initializePixels is true, see ImageBase::Allocate(). */
+  void Allocate(bool initializePixels = false);
 
   /** Convenience methods to set the LargestPossibleRegion,
    *  BufferedRegion and RequestedRegion. Allocate must still be called.
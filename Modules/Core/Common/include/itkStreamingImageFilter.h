@@ -36,6 +36,13 @@ namespace itk
  * This filter will produce the entire output as one image, but the upstream
  * filters will do their processing in pieces.
  *
+ * With NumberOfPrefetchedDivisions set above zero, the pieces are
+ * pipelined: before the upstream pipeline is executed for a piece, the
+ * requested regions of up to that many following pieces are propagated
+ * and handed to DataObject::PrefetchRequestedRegion(), so that sources
+ * able to work ahead, like ImageFileReader, read them in the background
+ * while the current piece is being processed.
+ *
  * \ingroup ITKSystemObjects
  * \ingroup DataProcessing
  * \ingroup ITKCommon
@@ -87,6 +94,14 @@ public:
    * will be executed this many times. */
   itkGetConstReferenceMacro(NumberOfStreamDivisions, unsigned int);
 
+  /** Set/Get the number of pieces following the one being processed
+   * whose generation upstream process objects may start in the
+   * background.  This bounds the number of pieces in flight, and the
+   * memory they take.  Default is 0, executing the pieces strictly one
+   * after the other. */
+  itkSetMacro(NumberOfPrefetchedDivisions, unsigned int);
+  itkGetConstReferenceMacro(NumberOfPrefetchedDivisions, unsigned int);
+
   /** Set the helper class for dividing the input into chunks. */
   itkSetObjectMacro(RegionSplitter, SplitterType);
 
@@ -106,6 +121,11 @@ public:
    */
   virtual void PropagateRequestedRegion(DataObject *output);
 
+  /** Override PrefetchRequestedRegion from ProcessObject.  The requested
+   * regions of the input are managed in UpdateOutputData(), so the request
+   * is not passed on. */
+  virtual void PrefetchRequestedRegion( DataObject *itkNotUsed(output) ) {}
+
 #ifdef ITK_USE_CONCEPT_CHECKING
   /** Begin concept checking */
   itkConceptMacro( SameDimensionCheck,
@@ -127,6 +147,7 @@ private:
   // implemented
 
   unsigned int          m_NumberOfStreamDivisions;
+  unsigned int          m_NumberOfPrefetchedDivisions;
   RegionSplitterPointer m_RegionSplitter;
 };
 } // end namespace itk
@@ -34,6 +34,9 @@ StreamingImageFilter< TInputImage, TOutputImage >
   // default to 10 divisions
   m_NumberOfStreamDivisions = 10;
 
+  // execute the pieces one after the other
+  m_NumberOfPrefetchedDivisions = 0;
+
   // create default region splitter
   m_RegionSplitter = ImageRegionSplitter< InputImageDimension >::New();
 }
@@ -58,6 +61,8 @@ StreamingImageFilter< TInputImage, TOutputImage >
 
   os << indent << "Number of stream divisions: " << m_NumberOfStreamDivisions
      << std::endl;
+  os << indent << "Number of prefetched divisions: " << m_NumberOfPrefetchedDivisions
+     << std::endl;
   if ( m_RegionSplitter )
     {
     os << indent << "Region splitter:" << m_RegionSplitter << std::endl;
@@ -187,11 +192,29 @@ StreamingImageFilter< TInputImage, TOutputImage >
    * piece, and copy the results into the output image.
    */
   unsigned int         piece;
+  unsigned int         prefetchedPiece = 1;
   InputImageRegionType streamRegion;
   for ( piece = 0;
         piece < numDivisions && !this->GetAbortGenerateData();
         piece++ )
     {
+    // let the upstream pipeline start on the following pieces, which it
+    // may do in the background while this one is processed
+    if ( prefetchedPiece <= piece )
+      {
+      prefetchedPiece = piece + 1;
+      }
+    for (; prefetchedPiece < numDivisions
+         && prefetchedPiece <= piece + m_NumberOfPrefetchedDivisions;
+         prefetchedPiece++ )
+      {
+      streamRegion = m_RegionSplitter->GetSplit(prefetchedPiece, numDivisions,
+                                                outputRegion);
+      inputPtr->SetRequestedRegion(streamRegion);
+      inputPtr->PropagateRequestedRegion();
+      inputPtr->PrefetchRequestedRegion();
+      }
+
     streamRegion = m_RegionSplitter->GetSplit(piece, numDivisions,
                                               outputRegion);
 
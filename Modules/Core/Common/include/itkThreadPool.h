@@ -0,0 +1,158 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkThreadPool_h
+#define __itkThreadPool_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkConditionVariable.h"
+#include "itkThreadSupport.h"
+#include "itkIntTypes.h"
+#include <deque>
+#include <vector>
+
+namespace itk
+{
+/** \class ThreadPool
+ * \brief A process-wide pool of persistent worker threads.
+ *
+ * ThreadPool keeps a set of worker threads alive between calls so that
+ * MultiThreader::SingleMethodExecute() does not have to create and join
+ * operating system threads every time a filter executes.  Work is handed
+ * to the pool as ThreadJob instances which are picked up by idle workers
+ * in submission order.
+ *
+ * The pool grows on demand: whenever more jobs are queued than there are
+ * idle workers, a new worker is started.  This guarantees forward progress
+ * when a job itself submits work to the pool (e.g. a filter run from
+ * inside another filter's threaded callback), at the cost of the pool
+ * possibly holding more workers than processors.
+ *
+ * There is only one instance of this class per process; use
+ * GetInstance() (or New(), which returns the same instance) to access it.
+ * The workers are not joined by a static destructor, since at process exit
+ * or library unload they may already have been killed, or joining them
+ * may deadlock on the loader lock.  Call Shutdown() to stop and join them
+ * explicitly, e.g. before unloading a library that links ITK; otherwise
+ * they are left blocked and are reclaimed by the operating system.
+ *
+ * When ITK is built without thread support, AssignWork() runs the job
+ * immediately in the calling thread.
+ *
+ * \sa MultiThreader
+ * \ingroup OSSystemObjects
+ * \ingroup ITKCommon
+ */
+class ITKCommon_EXPORT ThreadPool:public Object
+{
+public:
+  /** Standard class typedefs. */
+  typedef ThreadPool                 Self;
+  typedef Object                     Superclass;
+  typedef SmartPointer< Self >       Pointer;
+  typedef SmartPointer< const Self > ConstPointer;
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ThreadPool, Object);
+
+  /** This is a singleton pattern New.  There will only be ONE
+   * ThreadPool object per process; this simply calls GetInstance(). */
+  static Pointer New();
+
+  /** Return the process-wide instance, creating it on first use. */
+  static Pointer GetInstance();
+
+  /** Stop and join the workers of the process-wide instance, after they
+   * have run the queued jobs, and release it.  It must not be called
+   * while a MultiThreader is executing on the pool.  A later
+   * GetInstance() creates a new pool. */
+  static void Shutdown();
+
+  /** \class ThreadJob
+   * \brief A unit of work executed by one worker of the ThreadPool.
+   *
+   * The caller owns the job and must keep it alive until WaitForJob()
+   * has returned.
+   * \ingroup ITKCommon
+   */
+  struct ThreadJob {
+    ThreadJob():ThreadFunction(0), UserData(0), Done(false) {}
+
+    ThreadFunctionType ThreadFunction;
+    void *UserData;
+    bool Done;
+  };
+
+  /** Queue the job for execution by the next idle worker.  An exception
+   * is thrown, and the job is not queued, if a new worker is needed but
+   * cannot be created. */
+  void AssignWork(ThreadJob *job);
+
+  /** Block the calling thread until the job has been executed. */
+  void WaitForJob(ThreadJob *job);
+
+  /** Start workers until at least count of them exist.  This is used to
+   * warm up the pool so that the first threaded execution does not pay
+   * for thread creation. */
+  void AddThreads(ThreadIdType count);
+
+  /** Number of worker threads currently owned by the pool. */
+  ThreadIdType GetNumberOfThreads() const;
+
+protected:
+  ThreadPool();
+  ~ThreadPool();
+  void PrintSelf(std::ostream & os, Indent indent) const;
+
+private:
+  ThreadPool(const Self &);     //purposely not implemented
+  void operator=(const Self &); //purposely not implemented
+
+  /** Start one more worker.  Must be called with m_Mutex held. */
+  void SpawnWorker();
+
+  /** Stop and join all the workers. */
+  void StopWorkers();
+
+  /** Body of every worker thread. */
+  static ITK_THREAD_RETURN_TYPE WorkerMain(void *arg);
+
+  /** The instance holds a reference to itself until Shutdown(), so that
+   * it is never destroyed by a static destructor. */
+  static ThreadPool     *m_Instance;
+  static SimpleMutexLock m_InstanceMutex;
+
+  /** Protects every member below. */
+  mutable SimpleMutexLock m_Mutex;
+
+  /** Signaled when a job is queued or the pool is shutting down. */
+  ConditionVariable::Pointer m_WorkAvailable;
+
+  /** Broadcast whenever a job has finished executing. */
+  ConditionVariable::Pointer m_JobCompleted;
+
+  std::deque< ThreadJob * >          m_JobQueue;
+  std::vector< ThreadProcessIDType > m_Workers;
+
+  /** Number of workers currently waiting for a job. */
+  ThreadIdType m_NumberOfIdleThreads;
+
+  bool m_Stop;
+};
+}  // end namespace itk
+#endif
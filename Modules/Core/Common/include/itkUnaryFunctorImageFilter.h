@@ -20,6 +20,7 @@
 
 #include "itkInPlaceImageFilter.h"
 #include "itkImageRegionIteratorWithIndex.h"
+#include "itkFunctorBatch.h"
 
 namespace itk
 {
@@ -35,6 +36,11 @@ namespace itk
  * UnaryFunctorImageFilter (like the CastImageFilter) can be used
  * to promote a 2D image to a 3D image, etc.
  *
+ * When the input and output are Images of the same dimension, the
+ * pixels are processed a span of contiguous pixels at a time through
+ * Functor::UnaryBatch< TFunction >, which functors specialize to
+ * process spans faster, with SIMD instructions for instance.
+ *
  * \sa BinaryFunctorImageFilter TernaryFunctorImageFilter
  *
  * \ingroup   IntensityImageFilters     MultiThreaded
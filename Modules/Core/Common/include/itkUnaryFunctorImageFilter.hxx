@@ -161,12 +161,44 @@ UnaryFunctorImageFilter< TInputImage, TOutputImage, TFunction >
 
   this->CallCopyOutputRegionToInputRegion(inputRegionForThread, outputRegionForThread);
 
+  ProgressReporter progress( this, threadId, outputRegionForThread.GetNumberOfPixels() );
+
+  // Pixels stored in plain arrays are processed a span at a time.
+  if ( ContiguousPixelBuffer< TInputImage >::Value && ContiguousPixelBuffer< TOutputImage >::Value
+       && static_cast< unsigned int >( TInputImage::ImageDimension ) == TOutputImage::ImageDimension )
+    {
+    // with the same dimension, the regions copied back to the output
+    // are the input ones
+    OutputImageRegionType inputRegion;
+    OutputImageRegionType inputBufferedRegion;
+    this->CallCopyInputRegionToOutputRegion(inputRegion, inputRegionForThread);
+    this->CallCopyInputRegionToOutputRegion( inputBufferedRegion, inputPtr->GetBufferedRegion() );
+    if ( inputRegion == outputRegionForThread )
+      {
+      const InputImagePixelType *inputBuffer =
+        ContiguousPixelBuffer< TInputImage >::GetBufferPointer( inputPtr.GetPointer() );
+      OutputImagePixelType *outputBuffer =
+        ContiguousPixelBuffer< TOutputImage >::GetBufferPointer( outputPtr.GetPointer() );
+
+      ScanlineSpanIterator< TOutputImage::ImageDimension > span(outputRegionForThread);
+      span.AddBuffer(inputBufferedRegion);
+      span.AddBuffer( outputPtr->GetBufferedRegion() );
+      for ( span.GoToBegin(); !span.IsAtEnd(); ++span )
+        {
+        Functor::UnaryBatch< FunctorType >::Evaluate( m_Functor,
+                                                      inputBuffer + span.GetOffset(0),
+                                                      outputBuffer + span.GetOffset(1),
+                                                      span.GetLength() );
+        progress.CompletedPixels( span.GetLength() ); // potential exception thrown here
+        }
+      return;
+      }
+    }
+
   // Define the iterators
   ImageRegionConstIterator< TInputImage > inputIt(inputPtr, inputRegionForThread);
   ImageRegionIterator< TOutputImage >     outputIt(outputPtr, outputRegionForThread);
 
-  ProgressReporter progress( this, threadId, outputRegionForThread.GetNumberOfPixels() );
-
   inputIt.GoToBegin();
   outputIt.GoToBegin();
 
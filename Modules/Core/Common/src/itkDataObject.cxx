@@ -412,6 +412,23 @@ DataObject
     }
 }
 
+//----------------------------------------------------------------------------
+void
+DataObject
+::PrefetchRequestedRegion()
+{
+  // Only the regions PropagateRequestedRegion() passed on to the source
+  // are worth generating ahead.
+  if ( m_UpdateMTime < m_PipelineMTime || m_DataReleased
+       || this->RequestedRegionIsOutsideOfTheBufferedRegion() )
+    {
+    if ( m_Source )
+      {
+      m_Source->PrefetchRequestedRegion(this);
+      }
+    }
+}
+
 //----------------------------------------------------------------------------
 void
 DataObject
@@ -0,0 +1,268 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkImageBufferPool.h"
+#include "itkMutexLockHolder.h"
+#include "itkNumericTraits.h"
+#include "itksys/SystemInformation.hxx"
+#include "itksys/SystemTools.hxx"
+#include <algorithm>
+#include <stdlib.h>
+
+namespace itk
+{
+ImageBufferPool::Pointer ImageBufferPool:: m_GlobalDefaultPool = 0;
+bool                     ImageBufferPool:: m_GlobalDefaultPoolInitialized = false;
+SimpleFastMutexLock      ImageBufferPool:: m_GlobalDefaultPoolLock;
+
+void
+ImageBufferPool
+::SetGlobalDefaultPool(Self *pool)
+{
+  MutexLockHolder< SimpleFastMutexLock > holder(m_GlobalDefaultPoolLock);
+
+  m_GlobalDefaultPool = pool;
+  m_GlobalDefaultPoolInitialized = true;
+}
+
+ImageBufferPool::Pointer
+ImageBufferPool
+::GetGlobalDefaultPool()
+{
+  MutexLockHolder< SimpleFastMutexLock > holder(m_GlobalDefaultPoolLock);
+
+  if ( !m_GlobalDefaultPoolInitialized )
+    {
+    itksys_stl::string usePool;
+    if ( itksys::SystemTools::GetEnv("ITK_USE_IMAGE_BUFFER_POOL", usePool) )
+      {
+      usePool = itksys::SystemTools::UpperCase(usePool);
+      if ( !( usePool == "0" || usePool == "OFF" || usePool == "NO" || usePool == "FALSE" ) )
+        {
+        m_GlobalDefaultPool = Self::New();
+        }
+      }
+    m_GlobalDefaultPoolInitialized = true;
+    }
+  return m_GlobalDefaultPool;
+}
+
+ImageBufferPool
+::ImageBufferPool():
+  m_MaximumCachedBytes(0),
+  m_CachedBytes(0),
+  m_BytesInUse(0),
+  m_PeakBytes(0),
+  m_NumberOfHits(0),
+  m_NumberOfMisses(0)
+{
+  // Cache at most a quarter of the physical memory, so that blocks kept
+  // for reuse never crowd out the data of the application.
+  itksys::SystemInformation systemInformation;
+  systemInformation.RunMemoryCheck();
+  const SizeValueType megabytes = systemInformation.GetTotalPhysicalMemory();
+  const SizeValueType megabyte = 1024 * 1024;
+  if ( megabytes <= NumericTraits< SizeValueType >::max() / megabyte )
+    {
+    m_MaximumCachedBytes = megabytes * megabyte / 4;
+    }
+  else
+    {
+    m_MaximumCachedBytes = NumericTraits< SizeValueType >::max() / 4;
+    }
+}
+
+ImageBufferPool
+::~ImageBufferPool()
+{
+  this->ReleaseCachedBlocks();
+}
+
+SizeValueType
+ImageBufferPool
+::GetBucketSize(SizeValueType numberOfBytes)
+{
+  // Eight buckets per power of two, and multiples of 64 bytes for the
+  // smallest blocks.
+  SizeValueType powerOfTwo = 1;
+  while ( powerOfTwo <= numberOfBytes / 2 )
+    {
+    powerOfTwo *= 2;
+    }
+  const SizeValueType granularity = std::max< SizeValueType >(64, powerOfTwo / 8);
+  const SizeValueType numberOfGranules = numberOfBytes / granularity
+                                         + ( numberOfBytes % granularity != 0 ? 1 : 0 );
+
+  // Requests too close to the largest size are not rounded up.
+  if ( numberOfGranules > NumericTraits< SizeValueType >::max() / granularity )
+    {
+    return numberOfBytes;
+    }
+  return std::max< SizeValueType >(1, numberOfGranules) * granularity;
+}
+
+void *
+ImageBufferPool
+::AcquireBlock(SizeValueType numberOfBytes)
+{
+  const SizeValueType bucketSize = GetBucketSize(numberOfBytes);
+
+  {
+  MutexLockHolder< SimpleFastMutexLock > holder(m_Mutex);
+
+  CacheType::iterator bucket = m_Cache.find(bucketSize);
+  if ( bucket != m_Cache.end() && !bucket->second.empty() )
+    {
+    void *block = bucket->second.back();
+    bucket->second.pop_back();
+    m_CachedBytes -= bucketSize;
+    m_BytesInUse += bucketSize;
+    ++m_NumberOfHits;
+    return block;
+    }
+  ++m_NumberOfMisses;
+  }
+
+  // Allocate outside of the lock; this is the slow path.
+  void *block = malloc(bucketSize);
+  if ( block )
+    {
+    MutexLockHolder< SimpleFastMutexLock > holder(m_Mutex);
+    m_BytesInUse += bucketSize;
+    m_PeakBytes = std::max(m_PeakBytes, m_BytesInUse + m_CachedBytes);
+    }
+  return block;
+}
+
+void
+ImageBufferPool
+::ReleaseBlock(void *block, SizeValueType numberOfBytes)
+{
+  if ( !block )
+    {
+    return;
+    }
+
+  const SizeValueType bucketSize = GetBucketSize(numberOfBytes);
+  bool                cached = false;
+
+  {
+  MutexLockHolder< SimpleFastMutexLock > holder(m_Mutex);
+
+  m_BytesInUse -= bucketSize;
+  if ( bucketSize <= m_MaximumCachedBytes
+       && m_CachedBytes <= m_MaximumCachedBytes - bucketSize )
+    {
+    m_Cache[bucketSize].push_back(block);
+    m_CachedBytes += bucketSize;
+    cached = true;
+    }
+  }
+
+  if ( !cached )
+    {
+    free(block);
+    }
+}
+
+void
+ImageBufferPool
+::ReleaseCachedBlocks()
+{
+  CacheType blocks;
+
+  {
+  MutexLockHolder< SimpleFastMutexLock > holder(m_Mutex);
+  blocks.swap(m_Cache);
+  m_CachedBytes = 0;
+  }
+
+  for ( CacheType::iterator bucket = blocks.begin(); bucket != blocks.end(); ++bucket )
+    {
+    for ( std::vector< void * >::iterator it = bucket->second.begin();
+          it != bucket->second.end(); ++it )
+      {
+      free(*it);
+      }
+    }
+}
+
+SizeValueType
+ImageBufferPool
+::GetNumberOfHits() const
+{
+  MutexLockHolder< SimpleFastMutexLock > holder(m_Mutex);
+  return m_NumberOfHits;
+}
+
+SizeValueType
+ImageBufferPool
+::GetNumberOfMisses() const
+{
+  MutexLockHolder< SimpleFastMutexLock > holder(m_Mutex);
+  return m_NumberOfMisses;
+}
+
+SizeValueType
+ImageBufferPool
+::GetBytesInUse() const
+{
+  MutexLockHolder< SimpleFastMutexLock > holder(m_Mutex);
+  return m_BytesInUse;
+}
+
+SizeValueType
+ImageBufferPool
+::GetCachedBytes() const
+{
+  MutexLockHolder< SimpleFastMutexLock > holder(m_Mutex);
+  return m_CachedBytes;
+}
+
+SizeValueType
+ImageBufferPool
+::GetPeakBytes() const
+{
+  MutexLockHolder< SimpleFastMutexLock > holder(m_Mutex);
+  return m_PeakBytes;
+}
+
+void
+ImageBufferPool
+::ResetStatistics()
+{
+  MutexLockHolder< SimpleFastMutexLock > holder(m_Mutex);
+  m_NumberOfHits = 0;
+  m_NumberOfMisses = 0;
+  m_PeakBytes = m_BytesInUse + m_CachedBytes;
+}
+
+void
+ImageBufferPool
+::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  MutexLockHolder< SimpleFastMutexLock > holder(m_Mutex);
+  os << indent << "Maximum cached bytes: " << m_MaximumCachedBytes << std::endl;
+  os << indent << "Cached bytes: " << m_CachedBytes << std::endl;
+  os << indent << "Bytes in use: " << m_BytesInUse << std::endl;
+  os << indent << "Peak bytes: " << m_PeakBytes << std::endl;
+  os << indent << "Number of hits: " << m_NumberOfHits << std::endl;
+  os << indent << "Number of misses: " << m_NumberOfMisses << std::endl;
+}
+} // end namespace itk
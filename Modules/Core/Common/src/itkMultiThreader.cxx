@@ -48,22 +48,89 @@
 
 namespace itk
 {
+namespace
+{
+// Read an ON/OFF setting from the environment, returning defaultValue
+// when the variable is not set.
+bool GetBooleanEnvironmentVariable(const char *name, bool defaultValue)
+{
+  itksys_stl::string value;
+  if ( !itksys::SystemTools::GetEnv(name, value) )
+    {
+    return defaultValue;
+    }
+  value = itksys::SystemTools::UpperCase(value);
+  return !( value == "0" || value == "OFF" || value == "NO" || value == "FALSE" );
+}
+}
+
 // Initialize static member that controls global maximum number of threads.
 ThreadIdType MultiThreader:: m_GlobalMaximumNumberOfThreads = ITK_MAX_THREADS;
+bool         MultiThreader:: m_GlobalMaximumNumberOfThreadsHasBeenSet = false;
 
 // Initialize static member that controls global default number of threads : 0
 // => Not initialized.
 ThreadIdType MultiThreader:: m_GlobalDefaultNumberOfThreads = 0;
 
-void MultiThreader::SetGlobalMaximumNumberOfThreads(ThreadIdType val)
+// Initialize static members that control whether new MultiThreader
+// instances dispatch onto the thread pool.
+bool MultiThreader:: m_GlobalDefaultUseThreadPool = true;
+bool MultiThreader:: m_GlobalDefaultUseThreadPoolInitialized = false;
+
+void MultiThreader::SetGlobalDefaultUseThreadPool(bool useThreadPool)
 {
-  m_GlobalMaximumNumberOfThreads = val;
+  m_GlobalDefaultUseThreadPool = useThreadPool;
+  m_GlobalDefaultUseThreadPoolInitialized = true;
+}
+
+bool MultiThreader::GetGlobalDefaultUseThreadPool()
+{
+  if ( !m_GlobalDefaultUseThreadPoolInitialized )
+    {
+    m_GlobalDefaultUseThreadPool =
+      GetBooleanEnvironmentVariable("ITK_GLOBAL_DEFAULT_USE_THREAD_POOL",
+                                    m_GlobalDefaultUseThreadPool);
+    m_GlobalDefaultUseThreadPoolInitialized = true;
+    }
+  return m_GlobalDefaultUseThreadPool;
+}
 
-  // clamp between 1 and ITK_MAX_THREADS
-  m_GlobalMaximumNumberOfThreads = std::min( m_GlobalMaximumNumberOfThreads,
-                                             (ThreadIdType) ITK_MAX_THREADS );
-  m_GlobalMaximumNumberOfThreads = std::max( m_GlobalMaximumNumberOfThreads,
-                                             NumericTraits<ThreadIdType>::One );
+// Initialize static members that control whether new MultiThreader
+// instances bind their threads to processors.
+bool MultiThreader:: m_GlobalDefaultThreadAffinity = false;
+bool MultiThreader:: m_GlobalDefaultThreadAffinityInitialized = false;
+
+void MultiThreader::SetGlobalDefaultThreadAffinity(bool threadAffinity)
+{
+  m_GlobalDefaultThreadAffinity = threadAffinity;
+  m_GlobalDefaultThreadAffinityInitialized = true;
+}
+
+bool MultiThreader::GetGlobalDefaultThreadAffinity()
+{
+  if ( !m_GlobalDefaultThreadAffinityInitialized )
+    {
+    m_GlobalDefaultThreadAffinity =
+      GetBooleanEnvironmentVariable("ITK_GLOBAL_DEFAULT_THREAD_AFFINITY",
+                                    m_GlobalDefaultThreadAffinity);
+    m_GlobalDefaultThreadAffinityInitialized = true;
+    }
+  return m_GlobalDefaultThreadAffinity;
+}
+
+ThreadIdType MultiThreader::ClampNumberOfThreads(ThreadIdType numberOfThreads)
+{
+#if !defined(ITK_USE_PTHREADS) && !defined(ITK_USE_WIN32_THREADS)
+  // Without a threading library only the calling thread ever runs.
+  numberOfThreads = std::min( numberOfThreads, (ThreadIdType) ITK_MAX_THREADS );
+#endif
+  return std::max( numberOfThreads, NumericTraits<ThreadIdType>::One );
+}
+
+void MultiThreader::SetGlobalMaximumNumberOfThreads(ThreadIdType val)
+{
+  m_GlobalMaximumNumberOfThreads = ClampNumberOfThreads(val);
+  m_GlobalMaximumNumberOfThreadsHasBeenSet = true;
 
   // If necessary reset the default to be used from now on.
   m_GlobalDefaultNumberOfThreads = std::min ( m_GlobalDefaultNumberOfThreads,
@@ -102,6 +169,8 @@ void MultiThreader::SetNumberOfThreads(ThreadIdType numberOfThreads)
                                  m_GlobalMaximumNumberOfThreads );
   m_NumberOfThreads  = std::max( m_NumberOfThreads, NumericTraits<ThreadIdType>::One );
 
+  this->ResizeThreadArrays(m_NumberOfThreads);
+
 }
 
 
@@ -174,6 +243,14 @@ ThreadIdType MultiThreader::GetGlobalDefaultNumberOfThreads()
     m_GlobalDefaultNumberOfThreads = num;
     }
 
+  // let machines with more processors than ITK_MAX_THREADS use all of
+  // them, unless the application chose a maximum itself
+  if ( !m_GlobalMaximumNumberOfThreadsHasBeenSet )
+    {
+    m_GlobalMaximumNumberOfThreads = std::max( m_GlobalMaximumNumberOfThreads,
+                                               ClampNumberOfThreads(m_GlobalDefaultNumberOfThreads) );
+    }
+
   // limit the number of threads to m_GlobalMaximumNumberOfThreads
   m_GlobalDefaultNumberOfThreads  = std::min( m_GlobalDefaultNumberOfThreads,
                                               m_GlobalMaximumNumberOfThreads );
@@ -186,20 +263,13 @@ ThreadIdType MultiThreader::GetGlobalDefaultNumberOfThreads()
 }
 
 
-// Constructor. Default all the methods to NULL. Since the
-// ThreadInfoArray is static, the ThreadIDs can be initialized here
-// and will not change.
+// Constructor. Default all the methods to NULL. The per-thread arrays
+// only ever grow, so the ThreadIDs are initialized when entries are
+// added and will not change.
 MultiThreader::MultiThreader()
 {
   for ( ThreadIdType i = 0; i < ITK_MAX_THREADS; i++ )
     {
-    m_ThreadInfoArray[i].ThreadID           = i;
-    m_ThreadInfoArray[i].ActiveFlag         = 0;
-    m_ThreadInfoArray[i].ActiveFlagLock     = 0;
-
-    m_MultipleMethod[i]                     = 0;
-    m_MultipleData[i]                       = 0;
-
     m_SpawnedThreadActiveFlag[i]            = 0;
     m_SpawnedThreadActiveFlagLock[i]        = 0;
     m_SpawnedThreadInfoArray[i].ThreadID    = i;
@@ -208,6 +278,29 @@ MultiThreader::MultiThreader()
   m_SingleMethod = 0;
   m_SingleData = 0;
   m_NumberOfThreads = this->GetGlobalDefaultNumberOfThreads();
+  m_UseThreadPool = this->GetGlobalDefaultUseThreadPool();
+  m_ThreadAffinity = this->GetGlobalDefaultThreadAffinity();
+  this->ResizeThreadArrays(m_NumberOfThreads);
+}
+
+void MultiThreader::ResizeThreadArrays(ThreadIdType numberOfThreads)
+{
+  const ThreadIdType oldSize = static_cast< ThreadIdType >( m_ThreadInfoArray.size() );
+  if ( numberOfThreads <= oldSize )
+    {
+    return;
+    }
+
+  m_ThreadInfoArray.resize(numberOfThreads);
+  m_MultipleMethod.resize(numberOfThreads, 0);
+  m_MultipleData.resize(numberOfThreads, 0);
+  m_ThreadJobArray.resize(numberOfThreads);
+  for ( ThreadIdType i = oldSize; i < numberOfThreads; i++ )
+    {
+    m_ThreadInfoArray[i].ThreadID           = i;
+    m_ThreadInfoArray[i].ActiveFlag         = 0;
+    m_ThreadInfoArray[i].ActiveFlagLock     = 0;
+    }
 }
 
 MultiThreader::~MultiThreader()
@@ -242,8 +335,8 @@ void MultiThreader::SetMultipleMethod(ThreadIdType index, ThreadFunctionType f,
 // Execute the method set as the SingleMethod on NumberOfThreads threads.
 void MultiThreader::SingleMethodExecute()
 {
-  ThreadIdType                 thread_loop = 0;
-  ThreadProcessIDType process_id[ITK_MAX_THREADS];
+  ThreadIdType                       thread_loop = 0;
+  std::vector< ThreadProcessIDType > process_id(m_NumberOfThreads);
 
   if ( !m_SingleMethod )
     {
@@ -254,6 +347,14 @@ void MultiThreader::SingleMethodExecute()
   // obey the global maximum number of threads limit
   m_NumberOfThreads = std::min( m_GlobalMaximumNumberOfThreads, m_NumberOfThreads );
 
+  // The pool is only looked up when it is going to be used, so that
+  // purely single threaded programs never start any worker.
+  ThreadPool::Pointer threadPool;
+  if ( m_UseThreadPool && m_NumberOfThreads > 1 )
+    {
+    threadPool = ThreadPool::GetInstance();
+    }
+
   // Spawn a set of threads through the SingleMethodProxy. Exceptions
   // thrown from a thread will be caught by the SingleMethodProxy. A
   // naive mechanism is in place for determining whether a thread
@@ -263,6 +364,9 @@ void MultiThreader::SingleMethodExecute()
   // exceptions thrown by threads.
   bool        exceptionOccurred = false;
   std::string exceptionDetails;
+  // Number of threads (including the parent) actually started, which
+  // are the only ones that must be waited for.
+  ThreadIdType numberOfDispatchedThreads = 1;
   try
     {
     for ( thread_loop = 1; thread_loop < m_NumberOfThreads; thread_loop++ )
@@ -271,8 +375,19 @@ void MultiThreader::SingleMethodExecute()
       m_ThreadInfoArray[thread_loop].NumberOfThreads = m_NumberOfThreads;
       m_ThreadInfoArray[thread_loop].ThreadFunction = m_SingleMethod;
 
-      process_id[thread_loop] =
-        this->DispatchSingleMethodThread(&m_ThreadInfoArray[thread_loop]);
+      if ( threadPool )
+        {
+        m_ThreadJobArray[thread_loop].ThreadFunction =
+          m_ThreadAffinity ? this->AffinitySingleMethodProxy : this->SingleMethodProxy;
+        m_ThreadJobArray[thread_loop].UserData = &m_ThreadInfoArray[thread_loop];
+        threadPool->AssignWork(&m_ThreadJobArray[thread_loop]);
+        }
+      else
+        {
+        process_id[thread_loop] =
+          this->DispatchSingleMethodThread(&m_ThreadInfoArray[thread_loop]);
+        }
+      numberOfDispatchedThreads = thread_loop + 1;
       }
     }
   catch ( std::exception & e )
@@ -303,11 +418,18 @@ void MultiThreader::SingleMethodExecute()
     {
     // Need cleanup and rethrow ProcessAborted
     // close down other threads
-    for ( thread_loop = 1; thread_loop < m_NumberOfThreads; thread_loop++ )
+    for ( thread_loop = 1; thread_loop < numberOfDispatchedThreads; thread_loop++ )
       {
       try
         {
-        this->WaitForSingleMethodThread(process_id[thread_loop]);
+        if ( threadPool )
+          {
+          threadPool->WaitForJob(&m_ThreadJobArray[thread_loop]);
+          }
+        else
+          {
+          this->WaitForSingleMethodThread(process_id[thread_loop]);
+          }
         }
       catch ( ... )
               {}
@@ -332,11 +454,18 @@ void MultiThreader::SingleMethodExecute()
 
   // The parent thread has finished this->SingleMethod() - so now it
   // waits for each of the other processes to exit
-  for ( thread_loop = 1; thread_loop < m_NumberOfThreads; thread_loop++ )
+  for ( thread_loop = 1; thread_loop < numberOfDispatchedThreads; thread_loop++ )
     {
     try
       {
-      this->WaitForSingleMethodThread(process_id[thread_loop]);
+      if ( threadPool )
+        {
+        threadPool->WaitForJob(&m_ThreadJobArray[thread_loop]);
+        }
+      else
+        {
+        this->WaitForSingleMethodThread(process_id[thread_loop]);
+        }
       if ( m_ThreadInfoArray[thread_loop].ThreadExitCode
            != ThreadInfoStruct::SUCCESS )
         {
@@ -414,6 +543,12 @@ void MultiThreader::PrintSelf(std::ostream & os, Indent indent) const
      << m_GlobalMaximumNumberOfThreads << std::endl;
   os << indent << "Global Default Number Of Threads: "
      << m_GlobalDefaultNumberOfThreads << std::endl;
+  os << indent << "Use Thread Pool: " << m_UseThreadPool << std::endl;
+  os << indent << "Global Default Use Thread Pool: "
+     << m_GlobalDefaultUseThreadPool << std::endl;
+  os << indent << "Thread Affinity: " << m_ThreadAffinity << std::endl;
+  os << indent << "Global Default Thread Affinity: "
+     << m_GlobalDefaultThreadAffinity << std::endl;
 }
 
 
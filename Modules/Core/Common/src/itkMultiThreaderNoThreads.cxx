@@ -142,4 +142,12 @@ MultiThreader
   // No threading library specified.  Do nothing.  The computation
   // will be run by the main execution thread.
 }
+
+ITK_THREAD_RETURN_TYPE
+MultiThreader
+::AffinitySingleMethodProxy(void *arg)
+{
+  // No threading library specified.  There are no threads to bind.
+  return SingleMethodProxy(arg);
+}
 } // end namespace itk
@@ -35,6 +35,11 @@
 #include <sys/sysctl.h>
 #endif
 
+#ifdef __linux__
+#include <sched.h>
+#include <unistd.h>
+#endif
+
 namespace itk
 {
 extern "C"
@@ -78,7 +83,7 @@ void MultiThreader::MultipleMethodExecute()
 {
   ThreadIdType thread_loop;
 
-  pthread_t process_id[ITK_MAX_THREADS];
+  std::vector< pthread_t > process_id(m_NumberOfThreads);
 
   // obey the global maximum number of threads limit
   if ( m_NumberOfThreads > m_GlobalMaximumNumberOfThreads )
@@ -228,7 +233,9 @@ MultiThreader
 
   int threadError;
   threadError =
-    pthread_create( &threadHandle, &attr, reinterpret_cast< c_void_cast >( this->SingleMethodProxy ),
+    pthread_create( &threadHandle, &attr,
+                    reinterpret_cast< c_void_cast >( m_ThreadAffinity ? this->AffinitySingleMethodProxy
+                                                     : this->SingleMethodProxy ),
                     reinterpret_cast< void * >( threadInfo ) );
   if ( threadError != 0 )
     {
@@ -237,4 +244,46 @@ MultiThreader
     }
   return threadHandle;
 }
+
+ITK_THREAD_RETURN_TYPE
+MultiThreader
+::AffinitySingleMethodProxy(void *arg)
+{
+#if defined( __linux__ ) && defined( CPU_SET ) && defined( CPU_COUNT )
+  const ThreadInfoStruct *threadInfo = reinterpret_cast< ThreadInfoStruct * >( arg );
+
+  // Choose among the processors of the main thread, which is never
+  // bound and therefore reflects what the process may use.
+  cpu_set_t allowed;
+  cpu_set_t previous;
+  bool      bound = false;
+  if ( sched_getaffinity(getpid(), sizeof( allowed ), &allowed) == 0
+       && pthread_getaffinity_np(pthread_self(), sizeof( previous ), &previous) == 0
+       && CPU_COUNT(&allowed) > 0 )
+    {
+    int remaining = static_cast< int >( threadInfo->ThreadID % CPU_COUNT(&allowed) );
+    for ( int cpu = 0; cpu < CPU_SETSIZE; ++cpu )
+      {
+      if ( CPU_ISSET(cpu, &allowed) && remaining-- == 0 )
+        {
+        cpu_set_t processor;
+        CPU_ZERO(&processor);
+        CPU_SET(cpu, &processor);
+        bound = ( pthread_setaffinity_np(pthread_self(), sizeof( processor ), &processor) == 0 );
+        break;
+        }
+      }
+    }
+
+  SingleMethodProxy(arg);
+
+  if ( bound )
+    {
+    pthread_setaffinity_np(pthread_self(), sizeof( previous ), &previous);
+    }
+  return ITK_THREAD_RETURN_VALUE;
+#else
+  return SingleMethodProxy(arg);
+#endif
+}
 } // end namespace itk
@@ -48,7 +48,7 @@ void MultiThreader::MultipleMethodExecute()
   ThreadIdType thread_loop;
 
   DWORD  threadId;
-  HANDLE process_id[ITK_MAX_THREADS];
+  std::vector< HANDLE > process_id(m_NumberOfThreads);
 
   // obey the global maximum number of threads limit
   if ( m_NumberOfThreads > m_GlobalMaximumNumberOfThreads )
@@ -87,7 +87,7 @@ void MultiThreader::MultipleMethodExecute()
                                              ( (void *)( &m_ThreadInfoArray[thread_loop] ) ), 0,
                                              (unsigned int *)&threadId);
 
-    if ( process_id == 0 )
+    if ( process_id[thread_loop] == 0 )
       {
       itkExceptionMacro("Error in thread creation !!!");
       }
@@ -194,7 +194,9 @@ MultiThreader
   // Using _beginthreadex on a PC
   DWORD  threadId;
   HANDLE threadHandle =  (HANDLE)_beginthreadex(0, 0,
-                                                ( unsigned int (__stdcall *)(void *) ) this->SingleMethodProxy,
+                                                ( unsigned int (__stdcall *)(void *) )
+                                                ( m_ThreadAffinity ? this->AffinitySingleMethodProxy
+                                                  : this->SingleMethodProxy ),
                                                 ( (void *)threadInfo ), 0, (unsigned int *)&threadId);
   if ( threadHandle == NULL )
     {
@@ -202,4 +204,41 @@ MultiThreader
     }
   return threadHandle;
 }
+
+ITK_THREAD_RETURN_TYPE
+MultiThreader
+::AffinitySingleMethodProxy(void *arg)
+{
+  const ThreadInfoStruct *threadInfo = reinterpret_cast< ThreadInfoStruct * >( arg );
+
+  // Choose among the processors the process may run on.
+  DWORD_PTR processMask = 0;
+  DWORD_PTR systemMask = 0;
+  DWORD_PTR previousMask = 0;
+  if ( GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask) && processMask != 0 )
+    {
+    ThreadIdType numberOfProcessors = 0;
+    for ( DWORD_PTR mask = processMask; mask != 0; mask &= mask - 1 )
+      {
+      ++numberOfProcessors;
+      }
+    ThreadIdType remaining = threadInfo->ThreadID % numberOfProcessors;
+    for ( DWORD_PTR processor = 1; processor != 0; processor <<= 1 )
+      {
+      if ( ( processMask & processor ) && remaining-- == 0 )
+        {
+        previousMask = SetThreadAffinityMask(GetCurrentThread(), processor);
+        break;
+        }
+      }
+    }
+
+  SingleMethodProxy(arg);
+
+  if ( previousMask != 0 )
+    {
+    SetThreadAffinityMask(GetCurrentThread(), previousMask);
+    }
+  return ITK_THREAD_RETURN_VALUE;
+}
 } // end namespace itk
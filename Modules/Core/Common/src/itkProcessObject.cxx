@@ -59,6 +59,22 @@ ProcessObject
   m_NumberOfIndexedOutputs = 0;
 }
 
+void
+ProcessObject
+::SetNumberOfThreads(ThreadIdType numberOfThreads)
+{
+  numberOfThreads = std::max( numberOfThreads, static_cast< ThreadIdType >( 1 ) );
+#if !defined( ITK_USE_PTHREADS ) && !defined( ITK_USE_WIN32_THREADS )
+  numberOfThreads = std::min( numberOfThreads, static_cast< ThreadIdType >( ITK_MAX_THREADS ) );
+#endif
+  itkDebugMacro("setting NumberOfThreads to " << numberOfThreads);
+  if ( m_NumberOfThreads != numberOfThreads )
+    {
+    m_NumberOfThreads = numberOfThreads;
+    this->Modified();
+    }
+}
+
 /**
  * This is a default implementation to make sure we have something.
  * Once all the subclasses of ProcessObject provide an appopriate
@@ -1234,6 +1250,29 @@ ProcessObject
   m_Updating = false;
 }
 
+/**
+ * By default process objects cannot work ahead, but their inputs may.
+ */
+void
+ProcessObject
+::PrefetchRequestedRegion( DataObject *itkNotUsed(output) )
+{
+  if ( m_Updating )
+    {
+    return;
+    }
+
+  m_Updating = true;
+  for ( DataObjectPointerMap::iterator it=m_Inputs.begin(); it != m_Inputs.end(); it++ )
+    {
+    if ( it->second )
+      {
+      it->second->PrefetchRequestedRegion();
+      }
+    }
+  m_Updating = false;
+}
+
 /**
  * By default we require all the input to produce the output. This is
  * overridden in the subclasses since we can often produce the output with
@@ -0,0 +1,277 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkThreadPool.h"
+#include "itkMutexLockHolder.h"
+
+#if defined(ITK_USE_WIN32_THREADS)
+#include <process.h>
+#endif
+
+namespace itk
+{
+ThreadPool *        ThreadPool:: m_Instance = 0;
+SimpleMutexLock     ThreadPool:: m_InstanceMutex;
+
+#if defined(ITK_USE_PTHREADS)
+extern "C"
+{
+typedef void *( *c_void_cast )(void *);
+}
+#endif
+
+ThreadPool::Pointer
+ThreadPool
+::GetInstance()
+{
+  MutexLockHolder< SimpleMutexLock > holder(m_InstanceMutex);
+
+  if ( !ThreadPool::m_Instance )
+    {
+    // The reference from construction is kept until Shutdown().
+    ThreadPool::m_Instance = new ThreadPool;
+    }
+  return ThreadPool::m_Instance;
+}
+
+void
+ThreadPool
+::Shutdown()
+{
+  ThreadPool *pool;
+  {
+  MutexLockHolder< SimpleMutexLock > holder(m_InstanceMutex);
+  pool = ThreadPool::m_Instance;
+  ThreadPool::m_Instance = 0;
+  }
+
+  if ( pool )
+    {
+    pool->StopWorkers();
+    pool->UnRegister();
+    }
+}
+
+ThreadPool::Pointer
+ThreadPool
+::New()
+{
+  return GetInstance();
+}
+
+ThreadPool
+::ThreadPool():
+  m_NumberOfIdleThreads(0),
+  m_Stop(false)
+{
+  m_WorkAvailable = ConditionVariable::New();
+  m_JobCompleted = ConditionVariable::New();
+}
+
+ThreadPool
+::~ThreadPool()
+{
+  // Only reached through Shutdown(), or when a pool released by Shutdown()
+  // loses its last reference, so the workers are already joined.
+  this->StopWorkers();
+}
+
+void
+ThreadPool
+::StopWorkers()
+{
+  std::vector< ThreadProcessIDType > workers;
+
+  m_Mutex.Lock();
+  m_Stop = true;
+  m_WorkAvailable->Broadcast();
+  workers.swap(m_Workers);
+  m_Mutex.Unlock();
+
+  for ( std::vector< ThreadProcessIDType >::iterator it = workers.begin();
+        it != workers.end(); ++it )
+    {
+#if defined(ITK_USE_PTHREADS)
+    pthread_join(*it, 0);
+#elif defined(ITK_USE_WIN32_THREADS)
+    WaitForSingleObject(*it, INFINITE);
+    CloseHandle(*it);
+#endif
+    }
+}
+
+void
+ThreadPool
+::SpawnWorker()
+{
+#if defined(ITK_USE_PTHREADS)
+  pthread_attr_t attr;
+  pthread_t      threadHandle;
+
+  pthread_attr_init(&attr);
+#if !defined( __CYGWIN__ )
+  pthread_attr_setscope(&attr, PTHREAD_SCOPE_SYSTEM);
+#endif
+
+  const int threadError =
+    pthread_create( &threadHandle, &attr, reinterpret_cast< c_void_cast >( &ThreadPool::WorkerMain ),
+                    reinterpret_cast< void * >( this ) );
+  pthread_attr_destroy(&attr);
+  if ( threadError != 0 )
+    {
+    itkExceptionMacro(<< "Unable to create a thread.  pthread_create() returned "
+                      << threadError);
+    }
+  m_Workers.push_back(threadHandle);
+#elif defined(ITK_USE_WIN32_THREADS)
+  DWORD  threadId;
+  HANDLE threadHandle = (HANDLE)_beginthreadex(0, 0,
+                                               ( unsigned int (__stdcall *)(void *) ) &ThreadPool::WorkerMain,
+                                               reinterpret_cast< void * >( this ), 0, (unsigned int *)&threadId);
+  if ( threadHandle == NULL )
+    {
+    itkExceptionMacro("Error in thread creation !!!");
+    }
+  m_Workers.push_back(threadHandle);
+#endif
+}
+
+void
+ThreadPool
+::AddThreads(ThreadIdType count)
+{
+#if defined(ITK_USE_PTHREADS) || defined(ITK_USE_WIN32_THREADS)
+  MutexLockHolder< SimpleMutexLock > holder(m_Mutex);
+
+  while ( m_Workers.size() < count )
+    {
+    this->SpawnWorker();
+    }
+#else
+  (void)count;
+#endif
+}
+
+ThreadIdType
+ThreadPool
+::GetNumberOfThreads() const
+{
+  MutexLockHolder< SimpleMutexLock > holder(m_Mutex);
+
+  return static_cast< ThreadIdType >( m_Workers.size() );
+}
+
+void
+ThreadPool
+::AssignWork(ThreadJob *job)
+{
+  job->Done = false;
+
+#if defined(ITK_USE_PTHREADS) || defined(ITK_USE_WIN32_THREADS)
+  MutexLockHolder< SimpleMutexLock > holder(m_Mutex);
+
+  m_JobQueue.push_back(job);
+
+  // Every queued job needs a worker that is not already spoken for,
+  // otherwise a job that waits on work it submitted itself could
+  // deadlock the pool.
+  if ( m_NumberOfIdleThreads < m_JobQueue.size() )
+    {
+    try
+      {
+      this->SpawnWorker();
+      }
+    catch ( ... )
+      {
+      m_JobQueue.pop_back();
+      throw;
+      }
+    }
+  m_WorkAvailable->Signal();
+#else
+  // No threading library: run the job in the caller's thread.
+  ( *job->ThreadFunction )(job->UserData);
+  job->Done = true;
+#endif
+}
+
+void
+ThreadPool
+::WaitForJob(ThreadJob *job)
+{
+#if defined(ITK_USE_PTHREADS) || defined(ITK_USE_WIN32_THREADS)
+  MutexLockHolder< SimpleMutexLock > holder(m_Mutex);
+
+  while ( !job->Done )
+    {
+    m_JobCompleted->Wait(&m_Mutex);
+    }
+#else
+  (void)job;
+#endif
+}
+
+ITK_THREAD_RETURN_TYPE
+ThreadPool
+::WorkerMain(void *arg)
+{
+  ThreadPool *pool = reinterpret_cast< ThreadPool * >( arg );
+
+  pool->m_Mutex.Lock();
+  while ( true )
+    {
+    while ( pool->m_JobQueue.empty() && !pool->m_Stop )
+      {
+      ++pool->m_NumberOfIdleThreads;
+      pool->m_WorkAvailable->Wait(&pool->m_Mutex);
+      --pool->m_NumberOfIdleThreads;
+      }
+    if ( pool->m_JobQueue.empty() )
+      {
+      // m_Stop is set and nothing is left to do.
+      break;
+      }
+
+    ThreadJob *job = pool->m_JobQueue.front();
+    pool->m_JobQueue.pop_front();
+    pool->m_Mutex.Unlock();
+
+    // The function is expected to handle its own exceptions, as
+    // MultiThreader::SingleMethodProxy does.
+    ( *job->ThreadFunction )(job->UserData);
+
+    pool->m_Mutex.Lock();
+    job->Done = true;
+    pool->m_JobCompleted->Broadcast();
+    }
+  pool->m_Mutex.Unlock();
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+void
+ThreadPool
+::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  MutexLockHolder< SimpleMutexLock > holder(m_Mutex);
+  os << indent << "Number of threads: " << m_Workers.size() << std::endl;
+  os << indent << "Number of idle threads: " << m_NumberOfIdleThreads << std::endl;
+  os << indent << "Number of queued jobs: " << m_JobQueue.size() << std::endl;
+}
+} // end namespace itk
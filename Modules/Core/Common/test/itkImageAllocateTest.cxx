@@ -0,0 +1,189 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkImage.h"
+#include "itkVectorImage.h"
+#include "itkRGBAPixel.h"
+#include "itkAbsImageFilter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkTimeProbe.h"
+
+// Checks the optional alignment and initialization of image buffers,
+// and times allocating an image with and without initializing
+// it followed by the first filter that writes into a new buffer.  Pass
+// an edge length of 1024 for a 4 GB float image.
+
+namespace
+{
+template< class TImage >
+bool CheckAlignment(const TImage *image, const char *name)
+{
+  const size_t address = reinterpret_cast< size_t >( image->GetBufferPointer() );
+  if ( address % TImage::PixelContainer::BufferAlignment != 0 )
+    {
+    std::cerr << name << " buffer " << image->GetBufferPointer() << " is not aligned to "
+              << TImage::PixelContainer::BufferAlignment << " bytes" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+template< class TImage >
+bool CheckValue(const TImage *image, const typename TImage::PixelType & value, const char *name)
+{
+  itk::ImageRegionConstIterator< TImage > it( image, image->GetBufferedRegion() );
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    if ( it.Get() != value )
+      {
+      std::cerr << name << " pixel " << it.GetIndex() << " is " << it.Get()
+                << " instead of " << value << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+}
+
+int itkImageAllocateTest(int argc, char *argv[])
+{
+  typedef itk::Image< float, 3 >                      ImageType;
+  typedef itk::AbsImageFilter< ImageType, ImageType > FilterType;
+
+  unsigned int edgeLength = 64;
+  if ( argc > 1 )
+    {
+    edgeLength = atoi(argv[1]);
+    }
+
+  ImageType::SizeType size;
+  size.Fill(edgeLength);
+
+  // Buffers come from new[] unless aligned allocation is asked for.
+  ImageType::Pointer plain = ImageType::New();
+  plain->SetRegions(size);
+  plain->Allocate();
+  if ( plain->GetPixelContainer()->GetBufferIsAlignedBlock() )
+    {
+    std::cerr << "Default image buffer is an aligned block" << std::endl;
+    return EXIT_FAILURE;
+    }
+  plain = 0;
+
+  // Initialized allocation, also of a reused buffer.
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions(size);
+  image->GetPixelContainer()->UseAlignedAllocationOn();
+  itk::TimeProbe initializedProbe;
+  initializedProbe.Start();
+  image->Allocate(true);
+  initializedProbe.Stop();
+  if ( !CheckAlignment(image.GetPointer(), "float image")
+       || !CheckValue(image.GetPointer(), 0.0f, "initialized float image") )
+    {
+    return EXIT_FAILURE;
+    }
+  image->FillBuffer(-3.0f);
+  image->Allocate(true);
+  if ( !CheckValue(image.GetPointer(), 0.0f, "reinitialized float image") )
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Uninitialized allocation: the data of a reused buffer is kept.
+  image->FillBuffer(-3.0f);
+  image->Allocate();
+  if ( !CheckValue(image.GetPointer(), -3.0f, "reallocated float image") )
+    {
+    return EXIT_FAILURE;
+    }
+
+  ImageType::Pointer uninitialized = ImageType::New();
+  uninitialized->SetRegions(size);
+  uninitialized->GetPixelContainer()->UseAlignedAllocationOn();
+  itk::TimeProbe uninitializedProbe;
+  uninitializedProbe.Start();
+  uninitialized->Allocate();
+  uninitializedProbe.Stop();
+  if ( !CheckAlignment(uninitialized.GetPointer(), "uninitialized float image") )
+    {
+    return EXIT_FAILURE;
+    }
+  uninitialized = 0;
+
+  // Other pixel types and images.
+  typedef itk::Image< itk::RGBAPixel< unsigned char >, 2 > RGBAImageType;
+  RGBAImageType::Pointer rgba = RGBAImageType::New();
+  RGBAImageType::SizeType rgbaSize;
+  rgbaSize.Fill(17);
+  rgba->SetRegions(rgbaSize);
+  rgba->GetPixelContainer()->UseAlignedAllocationOn();
+  rgba->Allocate(true);
+  RGBAImageType::PixelType black;
+  black.Fill(0);
+  if ( !CheckAlignment(rgba.GetPointer(), "RGBA image")
+       || !CheckValue(rgba.GetPointer(), black, "RGBA image") )
+    {
+    return EXIT_FAILURE;
+    }
+
+  typedef itk::VectorImage< double, 2 > VectorImageType;
+  VectorImageType::Pointer vectorImage = VectorImageType::New();
+  VectorImageType::SizeType vectorSize;
+  vectorSize.Fill(13);
+  vectorImage->SetRegions(vectorSize);
+  vectorImage->SetVectorLength(3);
+  vectorImage->GetPixelContainer()->UseAlignedAllocationOn();
+  vectorImage->Allocate(true);
+  if ( !CheckAlignment(vectorImage.GetPointer(), "vector image") )
+    {
+    return EXIT_FAILURE;
+    }
+  for ( itk::SizeValueType i = 0; i < vectorImage->GetPixelContainer()->Size(); ++i )
+    {
+    if ( vectorImage->GetBufferPointer()[i] != 0.0 )
+      {
+      std::cerr << "Vector image component " << i << " is not initialized" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  // First filter on the image: its output buffer is newly allocated
+  // and left uninitialized by ImageSource::AllocateOutputs().
+  image->FillBuffer(-2.0f);
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput(image);
+  filter->GetOutput()->GetPixelContainer()->UseAlignedAllocationOn();
+  itk::TimeProbe filterProbe;
+  filterProbe.Start();
+  filter->Update();
+  filterProbe.Stop();
+  if ( !CheckAlignment(filter->GetOutput(), "filter output")
+       || !CheckValue(filter->GetOutput(), 2.0f, "filter output") )
+    {
+    return EXIT_FAILURE;
+    }
+
+  const double gigabytes = image->GetBufferedRegion().GetNumberOfPixels() * sizeof( float ) / 1e9;
+  std::cout << "Float image of " << edgeLength << "^3 pixels (" << gigabytes << " GB)" << std::endl;
+  std::cout << "  Allocate(true):  " << initializedProbe.GetTotal() << " s" << std::endl;
+  std::cout << "  Allocate():      " << uninitializedProbe.GetTotal() << " s" << std::endl;
+  std::cout << "  first filter:    " << filterProbe.GetTotal() << " s" << std::endl;
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,226 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkImageBufferPool.h"
+#include "itkImage.h"
+#include "itkAbsImageFilter.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkTimeProbe.h"
+#include <vector>
+
+#if !defined( _WIN32 )
+#include <sys/time.h>
+#include <sys/resource.h>
+#endif
+
+namespace
+{
+long GetNumberOfPageFaults()
+{
+#if !defined( _WIN32 )
+  struct rusage usage;
+  if ( getrusage(RUSAGE_SELF, &usage) == 0 )
+    {
+    return usage.ru_minflt + usage.ru_majflt;
+    }
+#endif
+  return -1;
+}
+
+typedef itk::Image< float, 3 >                      ImageType;
+typedef itk::AbsImageFilter< ImageType, ImageType > FilterType;
+
+// Update a chain of filters that release their outputs once consumed, so
+// that every update frees and allocates all the intermediate buffers.
+bool RunPipeline(itk::ImageBufferPool *pool, unsigned int edgeLength,
+                 unsigned int iterations, double & seconds, long & pageFaults)
+{
+  const unsigned int chainLength = 5;
+
+  ImageType::Pointer input = ImageType::New();
+  ImageType::SizeType size;
+  size.Fill(edgeLength);
+  input->SetRegions(size);
+  input->Allocate();
+  input->FillBuffer(-1.0f);
+
+  std::vector< FilterType::Pointer > chain;
+  for ( unsigned int i = 0; i < chainLength; ++i )
+    {
+    FilterType::Pointer filter = FilterType::New();
+    filter->SetInput( i == 0 ? input.GetPointer() : chain.back()->GetOutput() );
+    filter->SetBufferPool(pool);
+    if ( i + 1 < chainLength )
+      {
+      filter->ReleaseDataFlagOn();
+      }
+    chain.push_back(filter);
+    }
+
+  itk::TimeProbe probe;
+  const long     faultsBefore = GetNumberOfPageFaults();
+  for ( unsigned int i = 0; i < iterations; ++i )
+    {
+    chain.front()->Modified();
+    probe.Start();
+    chain.back()->Update();
+    probe.Stop();
+    }
+  pageFaults = GetNumberOfPageFaults() - faultsBefore;
+  seconds = probe.GetTotal();
+
+  itk::ImageRegionConstIterator< ImageType > it( chain.back()->GetOutput(),
+                                                 chain.back()->GetOutput()->GetBufferedRegion() );
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    if ( it.Get() != 1.0f )
+      {
+      std::cerr << "Wrong pipeline output " << it.Get() << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+}
+
+int itkImageBufferPoolTest(int argc, char *argv[])
+{
+  unsigned int edgeLength = 64;
+  unsigned int iterations = 100;
+  if ( argc > 1 )
+    {
+    edgeLength = atoi(argv[1]);
+    }
+  if ( argc > 2 )
+    {
+    iterations = atoi(argv[2]);
+    }
+
+  // Buckets.
+  typedef itk::ImageBufferPool PoolType;
+  if ( PoolType::GetBucketSize(1) != 64 || PoolType::GetBucketSize(64) != 64
+       || PoolType::GetBucketSize(65) != 128 || PoolType::GetBucketSize(1024) != 1024
+       || PoolType::GetBucketSize(1025) != 1152 )
+    {
+    std::cerr << "Unexpected bucket sizes" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Hits, misses and the cache limit.
+  PoolType::Pointer pool = PoolType::New();
+  if ( pool->GetMaximumCachedBytes() == itk::NumericTraits< itk::SizeValueType >::max() )
+    {
+    std::cerr << "The cache of a new pool is unbounded" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const itk::SizeValueType maximumCachedBytes = 1 << 30;
+  pool->SetMaximumCachedBytes(maximumCachedBytes);
+  void *block = pool->AcquireBlock(1000);
+  pool->ReleaseBlock(block, 1000);
+  void *again = pool->AcquireBlock(1010);
+  if ( again != block || pool->GetNumberOfHits() != 1 || pool->GetNumberOfMisses() != 1
+       || pool->GetBytesInUse() != PoolType::GetBucketSize(1000) )
+    {
+    std::cerr << "A cached block of the same bucket was not reused" << std::endl;
+    pool->Print(std::cerr);
+    return EXIT_FAILURE;
+    }
+  pool->SetMaximumCachedBytes(512);
+  pool->ReleaseBlock(again, 1010);
+  if ( pool->GetCachedBytes() != 0 || pool->GetBytesInUse() != 0 )
+    {
+    std::cerr << "A block larger than MaximumCachedBytes was cached" << std::endl;
+    pool->Print(std::cerr);
+    return EXIT_FAILURE;
+    }
+  pool->SetMaximumCachedBytes(maximumCachedBytes);
+  pool->ResetStatistics();
+
+  // Containers give their buffers back to the pool they came from.
+  ImageType::Pointer image = ImageType::New();
+  ImageType::SizeType size;
+  size.Fill(16);
+  image->SetRegions(size);
+  image->GetPixelContainer()->SetBufferPool(pool);
+  image->Allocate();
+  const itk::SizeValueType inUse = pool->GetBytesInUse();
+  if ( inUse < 16 * 16 * 16 * sizeof( float ) )
+    {
+    std::cerr << "The image buffer was not drawn from the pool" << std::endl;
+    return EXIT_FAILURE;
+    }
+  // Initialize() replaces the pixel container, releasing the buffer.
+  image->Initialize();
+  if ( pool->GetBytesInUse() != 0 || pool->GetCachedBytes() != inUse )
+    {
+    std::cerr << "The image buffer was not returned to the pool" << std::endl;
+    pool->Print(std::cerr);
+    return EXIT_FAILURE;
+    }
+  pool->ReleaseCachedBlocks();
+  if ( pool->GetCachedBytes() != 0 )
+    {
+    std::cerr << "ReleaseCachedBlocks() kept blocks" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // The global default pool.
+  PoolType::Pointer previousGlobalPool = PoolType::GetGlobalDefaultPool();
+  PoolType::SetGlobalDefaultPool(pool);
+  image->SetRegions(size);
+  image->Allocate();
+  if ( pool->GetBytesInUse() != inUse )
+    {
+    std::cerr << "The global default pool was not used" << std::endl;
+    return EXIT_FAILURE;
+    }
+  PoolType::SetGlobalDefaultPool(previousGlobalPool);
+  image = 0;
+
+  // Benchmark.
+  double systemSeconds = 0.0;
+  long   systemFaults = 0;
+  double pooledSeconds = 0.0;
+  long   pooledFaults = 0;
+  if ( !RunPipeline(0, edgeLength, iterations, systemSeconds, systemFaults) )
+    {
+    return EXIT_FAILURE;
+    }
+  pool->ResetStatistics();
+  if ( !RunPipeline(pool, edgeLength, iterations, pooledSeconds, pooledFaults) )
+    {
+    return EXIT_FAILURE;
+    }
+  if ( pool->GetNumberOfHits() == 0 )
+    {
+    std::cerr << "The pipeline never reused a pooled buffer" << std::endl;
+    pool->Print(std::cerr);
+    return EXIT_FAILURE;
+    }
+
+  std::cout << iterations << " updates of 5 filters on " << edgeLength << "^3 float images" << std::endl;
+  std::cout << "  system allocator: " << systemSeconds << " s, "
+            << systemFaults << " page faults" << std::endl;
+  std::cout << "  buffer pool:      " << pooledSeconds << " s, "
+            << pooledFaults << " page faults, "
+            << pool->GetNumberOfMisses() << " allocations, "
+            << pool->GetNumberOfHits() << " reuses, "
+            << pool->GetPeakBytes() << " peak bytes" << std::endl;
+
+  return EXIT_SUCCESS;
+}
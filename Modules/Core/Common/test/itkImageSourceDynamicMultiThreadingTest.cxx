@@ -0,0 +1,186 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkImageSource.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkImageRegionConstIterator.h"
+#include "itkTimeProbe.h"
+#include <cmath>
+
+namespace itk
+{
+/** An image source whose per-pixel cost is concentrated in the first
+ * few rows, to create load imbalance between the static slabs. */
+template< class TOutputImage >
+class ImbalancedImageSource:public ImageSource< TOutputImage >
+{
+public:
+  typedef ImbalancedImageSource         Self;
+  typedef ImageSource< TOutputImage >   Superclass;
+  typedef SmartPointer< Self >          Pointer;
+  typedef SmartPointer< const Self >    ConstPointer;
+
+  itkNewMacro(Self);
+  itkTypeMacro(ImbalancedImageSource, ImageSource);
+
+  typedef typename Superclass::OutputImageRegionType OutputImageRegionType;
+  typedef typename TOutputImage::SizeType            SizeType;
+
+  itkSetMacro(Size, SizeType);
+
+protected:
+  ImbalancedImageSource() { m_Size.Fill(64); }
+
+  void GenerateOutputInformation()
+  {
+    typename TOutputImage::RegionType region;
+    region.SetSize(m_Size);
+    this->GetOutput()->SetLargestPossibleRegion(region);
+  }
+
+  void ThreadedGenerateData(const OutputImageRegionType & region, ThreadIdType)
+  {
+    const unsigned int   lastAxis = TOutputImage::ImageDimension - 1;
+    const IndexValueType heavyRows = m_Size[lastAxis] / 8;
+
+    ImageRegionIteratorWithIndex< TOutputImage > it(this->GetOutput(), region);
+    for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+      {
+      const typename TOutputImage::IndexType index = it.GetIndex();
+      double value = index[0] + 1000.0 * index[lastAxis];
+      if ( index[lastAxis] < heavyRows )
+        {
+        for ( unsigned int k = 0; k < 2000; ++k )
+          {
+          value = std::sqrt(value * value + 1.0) - 1e-9;
+          }
+        }
+      it.Set( static_cast< typename TOutputImage::PixelType >( value ) );
+      }
+  }
+
+private:
+  ImbalancedImageSource(const Self &);
+  void operator=(const Self &);
+
+  SizeType m_Size;
+};
+}
+
+namespace
+{
+template< class TFilter >
+double ReportBusyTimes(const TFilter *filter, const char *label)
+{
+  typedef typename TFilter::ThreadBusyTimesType BusyTimesType;
+  const BusyTimesType & busy = filter->GetThreadBusyTimes();
+
+  double maximum = 0.0;
+  double sum = 0.0;
+  std::cout << label << " busy times (s):";
+  for ( typename BusyTimesType::const_iterator it = busy.begin(); it != busy.end(); ++it )
+    {
+    std::cout << " " << *it;
+    maximum = std::max(maximum, *it);
+    sum += *it;
+    }
+  const double mean = busy.empty() ? 0.0 : sum / busy.size();
+  const double imbalance = mean > 0.0 ? maximum / mean : 1.0;
+  std::cout << std::endl << label << " max/mean busy time: " << imbalance << std::endl;
+  return imbalance;
+}
+}
+
+int itkImageSourceDynamicMultiThreadingTest(int argc, char *argv[])
+{
+  typedef itk::Image< float, 3 >                     ImageType;
+  typedef itk::ImbalancedImageSource< ImageType >    SourceType;
+
+  itk::ThreadIdType numberOfThreads = 4;
+  if ( argc > 1 )
+    {
+    numberOfThreads = atoi(argv[1]);
+    }
+
+  SourceType::SizeType size;
+  size.Fill(64);
+
+  // static scheduling
+  SourceType::Pointer staticSource = SourceType::New();
+  staticSource->SetSize(size);
+  staticSource->SetNumberOfThreads(numberOfThreads);
+  itk::TimeProbe staticProbe;
+  staticProbe.Start();
+  staticSource->Update();
+  staticProbe.Stop();
+
+  // dynamic scheduling with the default and an explicit chunk size
+  SourceType::Pointer dynamicSource = SourceType::New();
+  dynamicSource->SetSize(size);
+  dynamicSource->SetNumberOfThreads(numberOfThreads);
+  dynamicSource->DynamicMultiThreadingOn();
+  if ( !dynamicSource->GetDynamicMultiThreading() )
+    {
+    std::cerr << "DynamicMultiThreadingOn() failed" << std::endl;
+    return EXIT_FAILURE;
+    }
+  itk::TimeProbe dynamicProbe;
+  dynamicProbe.Start();
+  dynamicSource->Update();
+  dynamicProbe.Stop();
+
+  SourceType::Pointer chunkedSource = SourceType::New();
+  chunkedSource->SetSize(size);
+  chunkedSource->SetNumberOfThreads(numberOfThreads);
+  chunkedSource->DynamicMultiThreadingOn();
+  chunkedSource->SetDynamicMultiThreadingChunkSize(64 * 64);
+  chunkedSource->Update();
+  chunkedSource->Print(std::cout);
+
+  // every mode must produce exactly the same pixels
+  itk::ImageRegionConstIterator< ImageType > sit( staticSource->GetOutput(),
+                                                  staticSource->GetOutput()->GetBufferedRegion() );
+  itk::ImageRegionConstIterator< ImageType > dit( dynamicSource->GetOutput(),
+                                                  dynamicSource->GetOutput()->GetBufferedRegion() );
+  itk::ImageRegionConstIterator< ImageType > cit( chunkedSource->GetOutput(),
+                                                  chunkedSource->GetOutput()->GetBufferedRegion() );
+  for ( ; !sit.IsAtEnd(); ++sit, ++dit, ++cit )
+    {
+    if ( sit.Get() != dit.Get() || sit.Get() != cit.Get() )
+      {
+      std::cerr << "Dynamic scheduling produced a different output" << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  if ( staticSource->GetThreadBusyTimes().size() !=
+       staticSource->GetMultiThreader()->GetNumberOfThreads() )
+    {
+    std::cerr << "Busy times are not reported for every thread" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  ReportBusyTimes(staticSource.GetPointer(), "static");
+  ReportBusyTimes(dynamicSource.GetPointer(), "dynamic");
+  ReportBusyTimes(chunkedSource.GetPointer(), "dynamic, 64x64 chunks");
+
+  std::cout << "static wall time:  " << staticProbe.GetTotal() << " s" << std::endl;
+  std::cout << "dynamic wall time: " << dynamicProbe.GetTotal() << " s" << std::endl;
+
+  return EXIT_SUCCESS;
+}
@@ -18,9 +18,12 @@
 
 #include "itkConfigure.h"
 #include "itkMultiThreader.h"
+#include "itkImage.h"
+#include "itkAbsImageFilter.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
 #include <stdlib.h>
 
-bool VerifyRange(int value, int min, int max, const char * msg)
+bool VerifyRange(itk::ThreadIdType value, itk::ThreadIdType min, itk::ThreadIdType max, const char * msg)
 {
   if( value < min )
     {
@@ -40,8 +43,15 @@ bool VerifyRange(int value, int min, int max, const char * msg)
 bool SetAndVerifyGlobalMaximumNumberOfThreads( int value )
 {
   itk::MultiThreader::SetGlobalMaximumNumberOfThreads( value );
+  // ITK_MAX_THREADS is only the default maximum; there is no upper bound
+  // anymore when a threading library is available.
+#if defined(ITK_USE_PTHREADS) || defined(ITK_USE_WIN32_THREADS)
+  const itk::ThreadIdType maximum = itk::NumericTraits< itk::ThreadIdType >::max();
+#else
+  const itk::ThreadIdType maximum = ITK_MAX_THREADS;
+#endif
   return VerifyRange( itk::MultiThreader::GetGlobalMaximumNumberOfThreads(),
-        1, ITK_MAX_THREADS, "Range error in MaximumNumberOfThreads");
+        1, maximum, "Range error in MaximumNumberOfThreads");
 }
 
 bool SetAndVerifyGlobalDefaultNumberOfThreads( int value )
@@ -63,6 +73,82 @@ bool SetAndVerifyNumberOfThreads( int value, itk::MultiThreader * threader )
 
 
 
+ITK_THREAD_RETURN_TYPE CountThreadsCallback( void * arg )
+{
+  itk::MultiThreader::ThreadInfoStruct * info =
+    static_cast< itk::MultiThreader::ThreadInfoStruct * >( arg );
+  std::vector< int > * visits = static_cast< std::vector< int > * >( info->UserData );
+  ( *visits )[info->ThreadID]++;
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+// Run a threaded method and a threaded filter with more threads than
+// the old compile time limit of ITK_MAX_THREADS.
+bool ExecuteWithMoreThreadsThanDefaultMaximum()
+{
+#if defined(ITK_USE_PTHREADS) || defined(ITK_USE_WIN32_THREADS)
+  const itk::ThreadIdType numberOfThreads = 2 * ITK_MAX_THREADS;
+  itk::MultiThreader::SetGlobalMaximumNumberOfThreads( numberOfThreads );
+
+  itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+  threader->SetNumberOfThreads( numberOfThreads );
+  if( threader->GetNumberOfThreads() != numberOfThreads )
+    {
+    std::cerr << "NumberOfThreads was clamped to " << threader->GetNumberOfThreads() << std::endl;
+    return false;
+    }
+
+  std::vector< int > visits( numberOfThreads, 0 );
+  threader->SetSingleMethod( CountThreadsCallback, &visits );
+  threader->SingleMethodExecute();
+  for( itk::ThreadIdType i = 0; i < numberOfThreads; ++i )
+    {
+    if( visits[i] != 1 )
+      {
+      std::cerr << "Thread " << i << " ran " << visits[i] << " times" << std::endl;
+      return false;
+      }
+    }
+
+  // one row per thread so that every thread gets a piece of the image
+  typedef itk::Image< float, 2 >                      ImageType;
+  typedef itk::AbsImageFilter< ImageType, ImageType > FilterType;
+
+  ImageType::SizeType size;
+  size[0] = 8;
+  size[1] = numberOfThreads;
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions( size );
+  image->Allocate();
+  image->FillBuffer( -3.0f );
+
+  FilterType::Pointer filter = FilterType::New();
+  filter->SetInput( image );
+  filter->SetNumberOfThreads( numberOfThreads );
+  filter->Update();
+
+  if( filter->GetMultiThreader()->GetNumberOfThreads() != numberOfThreads )
+    {
+    std::cerr << "Filter executed with " << filter->GetMultiThreader()->GetNumberOfThreads()
+              << " threads instead of " << numberOfThreads << std::endl;
+    return false;
+    }
+
+  itk::ImageRegionConstIteratorWithIndex< ImageType > it( filter->GetOutput(),
+                                                          filter->GetOutput()->GetBufferedRegion() );
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    if( it.Get() != 3.0f )
+      {
+      std::cerr << "Wrong output at " << it.GetIndex() << std::endl;
+      return false;
+      }
+    }
+  std::cout << "Executed a filter with " << numberOfThreads << " threads" << std::endl;
+#endif
+  return true;
+}
+
 int itkMultiThreaderTest(int argc, char* argv[])
 {
   // Choose a number of threads.
@@ -92,6 +178,18 @@ int itkMultiThreaderTest(int argc, char* argv[])
   result &= SetAndVerifyGlobalMaximumNumberOfThreads(  ITK_MAX_THREADS  );
   result &= SetAndVerifyGlobalMaximumNumberOfThreads(  ITK_MAX_THREADS - 1 );
   result &= SetAndVerifyGlobalMaximumNumberOfThreads(  ITK_MAX_THREADS + 1 );
+  result &= SetAndVerifyGlobalMaximumNumberOfThreads(  2 * ITK_MAX_THREADS );
+
+#if defined(ITK_USE_PTHREADS) || defined(ITK_USE_WIN32_THREADS)
+  if( itk::MultiThreader::GetGlobalMaximumNumberOfThreads() != 2 * ITK_MAX_THREADS )
+    {
+    std::cerr << "GlobalMaximumNumberOfThreads was clamped to "
+              << itk::MultiThreader::GetGlobalMaximumNumberOfThreads() << std::endl;
+    return EXIT_FAILURE;
+    }
+#endif
+
+  result &= SetAndVerifyGlobalMaximumNumberOfThreads(  ITK_MAX_THREADS + 1 );
 
   if( !result )
     {
@@ -127,6 +225,11 @@ int itkMultiThreaderTest(int argc, char* argv[])
 
   }
 
+  if( !ExecuteWithMoreThreadsThanDefaultMaximum() )
+    {
+    return EXIT_FAILURE;
+    }
+
   return EXIT_SUCCESS;
 }
 
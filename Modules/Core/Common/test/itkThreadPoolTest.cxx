@@ -0,0 +1,255 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkMultiThreader.h"
+#include "itkThreadPool.h"
+#include "itkTimeProbe.h"
+#include "itkImage.h"
+#include "itkAbsImageFilter.h"
+#include <vector>
+
+namespace
+{
+struct ThreadPoolTestData
+{
+  std::vector< int > m_Visits;
+  bool               m_Throw;
+  bool               m_Nested;
+};
+
+ITK_THREAD_RETURN_TYPE EmptyCallback(void *)
+{
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+ITK_THREAD_RETURN_TYPE CountingCallback(void *arg)
+{
+  itk::MultiThreader::ThreadInfoStruct *info =
+    static_cast< itk::MultiThreader::ThreadInfoStruct * >( arg );
+  ThreadPoolTestData *data = static_cast< ThreadPoolTestData * >( info->UserData );
+
+  // every thread writes its own slot only
+  data->m_Visits[info->ThreadID]++;
+
+  if ( data->m_Nested )
+    {
+    // Run a threaded method from within a pooled thread; the pool has
+    // to grow rather than deadlock.
+    itk::MultiThreader::Pointer inner = itk::MultiThreader::New();
+    inner->SetNumberOfThreads(info->NumberOfThreads);
+    inner->SetSingleMethod(EmptyCallback, 0);
+    inner->SingleMethodExecute();
+    }
+
+  if ( data->m_Throw && info->ThreadID == info->NumberOfThreads - 1 )
+    {
+    itkGenericExceptionMacro(<< "Expected exception from thread " << info->ThreadID);
+    }
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+bool RunAndCheck(itk::MultiThreader *threader, ThreadPoolTestData & data,
+                 unsigned int repetitions)
+{
+  const itk::ThreadIdType numberOfThreads = threader->GetNumberOfThreads();
+
+  data.m_Visits.assign(numberOfThreads, 0);
+  threader->SetSingleMethod(CountingCallback, &data);
+  for ( unsigned int i = 0; i < repetitions; ++i )
+    {
+    threader->SingleMethodExecute();
+    }
+  for ( itk::ThreadIdType t = 0; t < numberOfThreads; ++t )
+    {
+    if ( data.m_Visits[t] != static_cast< int >( repetitions ) )
+      {
+      std::cerr << "Thread " << t << " ran " << data.m_Visits[t]
+                << " times instead of " << repetitions << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+double TimeEmptyExecute(bool useThreadPool, itk::ThreadIdType numberOfThreads,
+                        unsigned int repetitions)
+{
+  itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+  threader->SetUseThreadPool(useThreadPool);
+  threader->SetNumberOfThreads(numberOfThreads);
+  threader->SetSingleMethod(EmptyCallback, 0);
+
+  itk::TimeProbe probe;
+  probe.Start();
+  for ( unsigned int i = 0; i < repetitions; ++i )
+    {
+    threader->SingleMethodExecute();
+    }
+  probe.Stop();
+  return probe.GetTotal();
+}
+
+double TimeFilterChain(bool useThreadPool, unsigned int chainLength,
+                       unsigned int repetitions)
+{
+  typedef itk::Image< float, 2 >                        ImageType;
+  typedef itk::AbsImageFilter< ImageType, ImageType >   FilterType;
+
+  itk::MultiThreader::SetGlobalDefaultUseThreadPool(useThreadPool);
+
+  ImageType::Pointer image = ImageType::New();
+  ImageType::SizeType size;
+  size.Fill(32);
+  image->SetRegions(size);
+  image->Allocate();
+  image->FillBuffer(-1.0f);
+
+  std::vector< FilterType::Pointer > chain;
+  for ( unsigned int i = 0; i < chainLength; ++i )
+    {
+    FilterType::Pointer filter = FilterType::New();
+    filter->SetInput( i == 0 ? image.GetPointer() : chain.back()->GetOutput() );
+    chain.push_back(filter);
+    }
+
+  itk::TimeProbe probe;
+  probe.Start();
+  for ( unsigned int i = 0; i < repetitions; ++i )
+    {
+    chain.front()->Modified();
+    chain.back()->Update();
+    }
+  probe.Stop();
+  return probe.GetTotal();
+}
+}
+
+int itkThreadPoolTest(int argc, char *argv[])
+{
+  itk::ThreadIdType numberOfThreads = 8;
+  unsigned int      repetitions = 1000;
+  if ( argc > 1 )
+    {
+    numberOfThreads = atoi(argv[1]);
+    }
+  if ( argc > 2 )
+    {
+    repetitions = atoi(argv[2]);
+    }
+
+  itk::ThreadPool::Pointer pool = itk::ThreadPool::GetInstance();
+  if ( pool != itk::ThreadPool::New() )
+    {
+    std::cerr << "ThreadPool::New() did not return the singleton" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  itk::MultiThreader::Pointer threader = itk::MultiThreader::New();
+  threader->SetNumberOfThreads(numberOfThreads);
+  threader->UseThreadPoolOn();
+  numberOfThreads = threader->GetNumberOfThreads();
+
+  ThreadPoolTestData data;
+  data.m_Throw = false;
+  data.m_Nested = false;
+
+  std::cout << "Pooled SingleMethodExecute..." << std::endl;
+  if ( !RunAndCheck(threader, data, 100) )
+    {
+    return EXIT_FAILURE;
+    }
+
+  std::cout << "Nested pooled SingleMethodExecute..." << std::endl;
+  data.m_Nested = true;
+  if ( !RunAndCheck(threader, data, 10) )
+    {
+    return EXIT_FAILURE;
+    }
+  data.m_Nested = false;
+
+  std::cout << "Exception from a pooled thread..." << std::endl;
+  data.m_Throw = true;
+  bool caught = false;
+  try
+    {
+    threader->SetSingleMethod(CountingCallback, &data);
+    threader->SingleMethodExecute();
+    }
+  catch ( itk::ExceptionObject & excp )
+    {
+    std::cout << "Caught expected exception" << std::endl;
+    std::cout << excp << std::endl;
+    caught = true;
+    }
+  if ( numberOfThreads > 1 && !caught )
+    {
+    std::cerr << "Exception thrown in a pooled thread was not reported" << std::endl;
+    return EXIT_FAILURE;
+    }
+  data.m_Throw = false;
+
+  // the pool must still be usable after a failure
+  if ( !RunAndCheck(threader, data, 10) )
+    {
+    return EXIT_FAILURE;
+    }
+
+  pool->Print(std::cout);
+
+  // Shutdown() joins the workers and releases the instance; the next
+  // execution starts a new pool.
+  itk::ThreadPool::Shutdown();
+  if ( pool->GetNumberOfThreads() != 0 )
+    {
+    std::cerr << "Shutdown() left " << pool->GetNumberOfThreads() << " workers" << std::endl;
+    return EXIT_FAILURE;
+    }
+  pool = 0;
+  if ( !RunAndCheck(threader, data, 10) )
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Benchmarks: dispatch overhead of empty executions, and a chain of
+  // tiny filters where thread creation used to dominate.
+  const double spawnTime = TimeEmptyExecute(false, numberOfThreads, repetitions);
+  const double poolTime = TimeEmptyExecute(true, numberOfThreads, repetitions);
+  std::cout << repetitions << " empty SingleMethodExecute with "
+            << numberOfThreads << " threads" << std::endl;
+  std::cout << "  spawned threads: " << spawnTime / repetitions * 1e6
+            << " us per call" << std::endl;
+  std::cout << "  thread pool:     " << poolTime / repetitions * 1e6
+            << " us per call" << std::endl;
+
+  const bool         defaultUseThreadPool = itk::MultiThreader::GetGlobalDefaultUseThreadPool();
+  const unsigned int chainLength = 30;
+  const unsigned int chainRepetitions = repetitions / 10 + 1;
+  const double spawnChainTime = TimeFilterChain(false, chainLength, chainRepetitions);
+  const double poolChainTime = TimeFilterChain(true, chainLength, chainRepetitions);
+  itk::MultiThreader::SetGlobalDefaultUseThreadPool(defaultUseThreadPool);
+  std::cout << chainRepetitions << " updates of a chain of " << chainLength
+            << " filters on a 32x32 image" << std::endl;
+  std::cout << "  spawned threads: " << spawnChainTime / chainRepetitions * 1e3
+            << " ms per update" << std::endl;
+  std::cout << "  thread pool:     " << poolChainTime / chainRepetitions * 1e3
+            << " ms per update" << std::endl;
+
+  itk::ThreadPool::Shutdown();
+
+  return EXIT_SUCCESS;
+}
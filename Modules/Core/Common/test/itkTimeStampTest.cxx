@@ -55,17 +55,17 @@ int itkTimeStampTest(int, char*[])
 
     // Set up the multithreader
     itk::MultiThreader::Pointer multithreader = itk::MultiThreader::New();
-    multithreader->SetNumberOfThreads( ITK_MAX_THREADS+10 );// this will be clamped
+    multithreader->SetNumberOfThreads( itk::MultiThreader::GetGlobalMaximumNumberOfThreads()+10 );// this will be clamped
     multithreader->SetSingleMethod( modified_function, &helper);
 
     // Test that the number of threads has actually been clamped
     const long int numberOfThreads =
       static_cast<long int>( multithreader->GetNumberOfThreads() );
 
-    if( numberOfThreads > ITK_MAX_THREADS )
+    if( numberOfThreads > static_cast<long int>( itk::MultiThreader::GetGlobalMaximumNumberOfThreads() ) )
       {
       std::cerr << "[TEST FAILED]" << std::endl;
-      std::cerr << "numberOfThreads > ITK_MAX_THREADS" << std::endl;
+      std::cerr << "numberOfThreads > GlobalMaximumNumberOfThreads" << std::endl;
       return EXIT_FAILURE;
       }
 
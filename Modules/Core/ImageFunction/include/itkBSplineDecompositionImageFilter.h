@@ -62,10 +62,19 @@ namespace itk
  *               Requires the same order of Spline for each dimension.
  *               Can only process LargestPossibleRegion
  *
+ * The coefficients are computed one dimension after the other, by
+ * filtering each line of the image along that dimension, and the threads
+ * share the lines of each dimension. When the output image stores its
+ * pixels in a single buffer, like itk::Image, the lines are filtered in
+ * blocks of LinesPerBlock adjacent lines, interleaved so that the
+ * recursions of all the lines of a block are computed together, which
+ * the compiler can vectorize. Each line gets the same computations as
+ * when it is filtered alone, so the coefficients do not depend on the
+ * number of threads.
+ *
  * \sa itkBSplineInterpolateImageFunction
  *
  * \ingroup ImageFilters
- * \ingroup SingleThreaded
  * \ingroup CannotBeStreamed
  * \ingroup ITKImageFunction
  */
@@ -91,6 +100,7 @@ public:
   typedef typename Superclass::InputImagePointer      InputImagePointer;
   typedef typename Superclass::InputImageConstPointer InputImageConstPointer;
   typedef typename Superclass::OutputImagePointer     OutputImagePointer;
+  typedef typename Superclass::OutputImageRegionType  OutputImageRegionType;
 
   typedef typename itk::NumericTraits< typename TOutputImage::PixelType >::RealType CoeffType;
 
@@ -108,6 +118,10 @@ public:
 
   itkGetConstMacro(SplineOrder, int);
 
+  /** Number of adjacent lines filtered together when the output image
+   * stores its pixels in a single buffer. */
+  itkStaticConstMacro(LinesPerBlock, unsigned int, 16);
+
 #ifdef ITK_USE_CONCEPT_CHECKING
   /** Begin concept checking */
   itkConceptMacro( DimensionCheck,
@@ -124,8 +138,20 @@ protected:
   virtual ~BSplineDecompositionImageFilter() {}
   void PrintSelf(std::ostream & os, Indent indent) const;
 
+  /** Filters the lines along each dimension in turn, with the
+   * threads sharing the lines of each dimension. */
   void GenerateData();
 
+  /** Filters the lines of the thread region along m_IteratorDirection,
+   * and first copies the input to the output in the first dimension. */
+  void ThreadedGenerateData(const OutputImageRegionType & outputRegionForThread,
+                            ThreadIdType threadId);
+
+  /** Splits the requested region along a dimension other than
+   * m_IteratorDirection, so that each thread gets whole lines. */
+  virtual unsigned int SplitRequestedRegion(unsigned int i, unsigned int num,
+                                            OutputImageRegionType & splitRegion);
+
   /** This filter requires all of the input image. */
   void GenerateInputRequestedRegion();
 
@@ -133,8 +159,6 @@ protected:
   void EnlargeOutputRequestedRegion(DataObject *output);
 
   /** These are needed by the smoothing spline routine. */
-  std::vector< CoeffType >           m_Scratch;   // temp storage for processing
-                                                  // of Coefficients
   typename TInputImage::SizeType m_DataLength;    // Image size
 
   unsigned int m_SplineOrder;                // User specified spline order (3rd
@@ -154,29 +178,41 @@ private:
   /** Determines the poles given the Spline Order. */
   virtual void SetPoles();
 
-  /** Converts a vector of data to a vector of Spline coefficients. */
-  virtual bool DataToCoefficients1D();
-
-  /** Converts an N-dimension image of data to an equivalent sized image
-   *    of spline coefficients. */
-  void DataToCoefficientsND();
+  /** Converts numberOfLines interleaved vectors of data to vectors of
+   * Spline coefficients: sample i of line l is at index
+   * i * numberOfLines + l of data. Returns false when the lines are too
+   * short to be filtered. */
+  bool DataToCoefficients1D(CoeffType *data, SizeValueType length,
+                            unsigned int numberOfLines) const;
 
   /** Determines the first coefficient for the causal filtering of the data. */
-  virtual void SetInitialCausalCoefficient(double z);
+  void SetInitialCausalCoefficient(double z, CoeffType *data, SizeValueType length,
+                                   unsigned int numberOfLines) const;
 
   /** Determines the first coefficient for the anti-causal filtering of the
     data. */
-  virtual void SetInitialAntiCausalCoefficient(double z);
+  void SetInitialAntiCausalCoefficient(double z, CoeffType *data, SizeValueType length,
+                                       unsigned int numberOfLines) const;
 
   /** Used to initialize the Coefficients image before calculation. */
-  void CopyImageToImage();
+  void CopyImageToImage(const OutputImageRegionType & region);
+
+  /** Filters the lines of the region in blocks of LinesPerBlock adjacent
+   * lines, reading and writing the output buffer directly. Returns
+   * false, without filtering, when the output image does not store its
+   * pixels in a single buffer or the region has no second dimension
+   * more than one pixel wide. */
+  bool DataToCoefficientsInBlocks(const OutputImageRegionType & region, ThreadIdType threadId);
+
+  /** Filters the lines of the region one at a time. */
+  void DataToCoefficientsByLine(const OutputImageRegionType & region, ThreadIdType threadId);
 
-  /** Copies a vector of data from the Coefficients image to the m_Scratch
+  /** Copies a vector of data from the Coefficients image to the scratch
     vector. */
-  void CopyCoefficientsToScratch(OutputLinearIterator &);
+  void CopyCoefficientsToScratch(OutputLinearIterator &, CoeffType *scratch);
 
-  /** Copies a vector of data from m_Scratch to the Coefficients image. */
-  void CopyScratchToCoefficients(OutputLinearIterator &);
+  /** Copies a vector of data from the scratch vector to the Coefficients image. */
+  void CopyScratchToCoefficients(OutputLinearIterator &, const CoeffType *scratch);
 };
 } // namespace itk
 
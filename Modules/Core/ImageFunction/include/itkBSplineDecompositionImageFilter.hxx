@@ -31,7 +31,9 @@
 #include "itkImageRegionConstIteratorWithIndex.h"
 #include "itkImageRegionIterator.h"
 #include "itkProgressReporter.h"
+#include "itkFunctorBatch.h"
 #include "itkVector.h"
+#include <algorithm>
 
 namespace itk
 {
@@ -66,14 +68,18 @@ BSplineDecompositionImageFilter< TInputImage, TOutputImage >
 template< class TInputImage, class TOutputImage >
 bool
 BSplineDecompositionImageFilter< TInputImage, TOutputImage >
-::DataToCoefficients1D()
+::DataToCoefficients1D(CoeffType *data, SizeValueType length, unsigned int numberOfLines) const
 {
   // See Unser, 1993, Part II, Equation 2.5,
   //   or Unser, 1999, Box 2. for an explaination.
 
+  // The loops over the lines are innermost, and each line gets the same
+  // computations, in the same order, as when it is filtered alone.
+  const unsigned int L = numberOfLines;
+
   double c0 = 1.0;
 
-  if ( m_DataLength[m_IteratorDirection] == 1 ) //Required by mirror boundaries
+  if ( length == 1 ) //Required by mirror boundaries
     {
     return false;
     }
@@ -86,28 +92,40 @@ BSplineDecompositionImageFilter< TInputImage, TOutputImage >
     }
 
   // apply the gain
-  for ( unsigned int n = 0; n < m_DataLength[m_IteratorDirection]; n++ )
+  for ( SizeValueType n = 0; n < length * L; n++ )
     {
-    m_Scratch[n] *= c0;
+    data[n] *= c0;
     }
 
   // loop over all poles
   for ( int k = 0; k < m_NumberOfPoles; k++ )
     {
+    const double z = m_SplinePoles[k];
+
     // causal initialization
-    this->SetInitialCausalCoefficient(m_SplinePoles[k]);
+    this->SetInitialCausalCoefficient(z, data, length, L);
     // causal recursion
-    for ( unsigned int n = 1; n < m_DataLength[m_IteratorDirection]; n++ )
+    for ( SizeValueType n = 1; n < length; n++ )
       {
-      m_Scratch[n] += m_SplinePoles[k] * m_Scratch[n - 1];
+      CoeffType       *c = data + n * L;
+      const CoeffType *p = c - L;
+      for ( unsigned int l = 0; l < L; l++ )
+        {
+        c[l] += z * p[l];
+        }
       }
 
     // anticausal initialization
-    this->SetInitialAntiCausalCoefficient(m_SplinePoles[k]);
+    this->SetInitialAntiCausalCoefficient(z, data, length, L);
     // anticausal recursion
-    for ( int n = m_DataLength[m_IteratorDirection] - 2; 0 <= n; n-- )
+    for ( SizeValueType n = length - 1; n > 0; n-- )
       {
-      m_Scratch[n] = m_SplinePoles[k] * ( m_Scratch[n + 1] - m_Scratch[n] );
+      CoeffType       *c = data + ( n - 1 ) * L;
+      const CoeffType *p = c + L;
+      for ( unsigned int l = 0; l < L; l++ )
+        {
+        c[l] = z * ( p[l] - c[l] );
+        }
       }
     }
   return true;
@@ -177,104 +195,210 @@ BSplineDecompositionImageFilter< TInputImage, TOutputImage >
 template< class TInputImage, class TOutputImage >
 void
 BSplineDecompositionImageFilter< TInputImage, TOutputImage >
-::SetInitialCausalCoefficient(double z)
+::SetInitialCausalCoefficient(double z, CoeffType *data, SizeValueType length,
+                              unsigned int numberOfLines) const
 {
   /* begining InitialCausalCoefficient */
   /* See Unser, 1999, Box 2 for explaination */
-  CoeffType     sum;
-  double        zn, z2n, iz;
-  typename TInputImage::SizeValueType horizon;
+  // The sums are accumulated in the first coefficient of each line.
+  const unsigned int L = numberOfLines;
+  double             zn, z2n, iz;
+  SizeValueType      horizon;
 
   /* this initialization corresponds to mirror boundaries */
-  horizon = m_DataLength[m_IteratorDirection];
+  horizon = length;
   zn = z;
   if ( m_Tolerance > 0.0 )
     {
-    horizon = (typename TInputImage::SizeValueType)
+    horizon = (SizeValueType)
       vcl_ceil( vcl_log(m_Tolerance) / vcl_log( vcl_fabs(z) ) );
     }
-  if ( horizon < m_DataLength[m_IteratorDirection] )
+  if ( horizon < length )
     {
     /* accelerated loop */
-    sum = m_Scratch[0];   // verify this
-    for ( unsigned int n = 1; n < horizon; n++ )
+    for ( SizeValueType n = 1; n < horizon; n++ )
       {
-      sum += zn * m_Scratch[n];
+      const CoeffType *d = data + n * L;
+      for ( unsigned int l = 0; l < L; l++ )
+        {
+        data[l] += zn * d[l];
+        }
       zn *= z;
       }
-    m_Scratch[0] = sum;
     }
   else
     {
     /* full loop */
     iz = 1.0 / z;
-    z2n = vcl_pow( z, (double)( m_DataLength[m_IteratorDirection] - 1L ) );
-    sum = m_Scratch[0] + z2n * m_Scratch[m_DataLength[m_IteratorDirection] - 1L];
+    z2n = vcl_pow( z, (double)( length - 1L ) );
+    const CoeffType *last = data + ( length - 1 ) * L;
+    for ( unsigned int l = 0; l < L; l++ )
+      {
+      data[l] = data[l] + z2n * last[l];
+      }
     z2n *= z2n * iz;
-    for ( unsigned int n = 1; n <= ( m_DataLength[m_IteratorDirection] - 2 ); n++ )
+    for ( SizeValueType n = 1; n <= ( length - 2 ); n++ )
       {
-      sum += ( zn + z2n ) * m_Scratch[n];
+      const CoeffType *d = data + n * L;
+      const double     w = zn + z2n;
+      for ( unsigned int l = 0; l < L; l++ )
+        {
+        data[l] += w * d[l];
+        }
       zn *= z;
       z2n *= iz;
       }
-    m_Scratch[0] = sum / ( 1.0 - zn * zn );
+    for ( unsigned int l = 0; l < L; l++ )
+      {
+      data[l] = data[l] / ( 1.0 - zn * zn );
+      }
     }
 }
 
 template< class TInputImage, class TOutputImage >
 void
 BSplineDecompositionImageFilter< TInputImage, TOutputImage >
-::SetInitialAntiCausalCoefficient(double z)
+::SetInitialAntiCausalCoefficient(double z, CoeffType *data, SizeValueType length,
+                                  unsigned int numberOfLines) const
 {
   // this initialization corresponds to mirror boundaries
   /* See Unser, 1999, Box 2 for explaination */
   //  Also see erratum at http://bigwww.epfl.ch/publications/unser9902.html
-  m_Scratch[m_DataLength[m_IteratorDirection] - 1] =
-    ( z / ( z * z - 1.0 ) )
-    * ( z * m_Scratch[m_DataLength[m_IteratorDirection] - 2] + m_Scratch[m_DataLength[m_IteratorDirection] - 1] );
+  const unsigned int L = numberOfLines;
+  CoeffType         *last = data + ( length - 1 ) * L;
+  const CoeffType   *previous = last - L;
+
+  for ( unsigned int l = 0; l < L; l++ )
+    {
+    last[l] = ( z / ( z * z - 1.0 ) ) * ( z * previous[l] + last[l] );
+    }
 }
 
+/**
+ * Filter the lines of the region in blocks of adjacent lines
+ */
 template< class TInputImage, class TOutputImage >
-void
+bool
 BSplineDecompositionImageFilter< TInputImage, TOutputImage >
-::DataToCoefficientsND()
+::DataToCoefficientsInBlocks(const OutputImageRegionType & region, ThreadIdType threadId)
 {
-  OutputImagePointer output = this->GetOutput();
+  typedef typename TOutputImage::PixelType OutputPixelType;
 
-  Size< ImageDimension > size = output->GetBufferedRegion().GetSize();
+  if ( !ContiguousPixelBuffer< TOutputImage >::Value )
+    {
+    return false;
+    }
 
-  unsigned int count = output->GetBufferedRegion().GetNumberOfPixels() / size[0] * ImageDimension;
+  // The lines of a block are adjacent along the fastest other dimension
+  // in which the region is more than one pixel wide.
+  unsigned int blockDimension = 0;
+  while ( blockDimension < ImageDimension
+          && ( blockDimension == m_IteratorDirection || region.GetSize(blockDimension) < 2 ) )
+    {
+    ++blockDimension;
+    }
+  if ( blockDimension == ImageDimension )
+    {
+    return false;
+    }
 
-  ProgressReporter progress(this, 0, count, 10);
+  TOutputImage    *outputImage = this->GetOutput();
+  OutputPixelType *outputBuffer = ContiguousPixelBuffer< TOutputImage >::GetBufferPointer(outputImage);
 
-  // Initialize coeffient array
-  this->CopyImageToImage();   // Coefficients are initialized to the input data
+  const OffsetValueType stride = outputImage->GetOffsetTable()[m_IteratorDirection];
+  const OffsetValueType lineStride = outputImage->GetOffsetTable()[blockDimension];
 
-  for ( unsigned int n = 0; n < ImageDimension; n++ )
-    {
-    m_IteratorDirection = n;
-    // Loop through each dimension
+  const SizeValueType ln = region.GetSize(m_IteratorDirection);
+  const unsigned int  L = LinesPerBlock;
+  const SizeValueType blockLength = region.GetSize(blockDimension);
+
+  std::vector< CoeffType > scratch(ln * L);
+
+  // the first pixel of each row of lines
+  OutputImageRegionType startRegion = region;
+  startRegion.SetSize(m_IteratorDirection, 1);
+  startRegion.SetSize(blockDimension, 1);
+  ImageRegionConstIteratorWithIndex< TOutputImage > startIterator(outputImage, startRegion);
+
+  ProgressReporter progress(this, threadId, region.GetNumberOfPixels() / ln, 10,
+                            m_IteratorDirection / static_cast< float >( ImageDimension ),
+                            1.0f / ImageDimension);
 
-    // Initialize iterators
-    OutputLinearIterator CIterator( output, output->GetBufferedRegion() );
-    CIterator.SetDirection(m_IteratorDirection);
-    // For each data vector
-    while ( !CIterator.IsAtEnd() )
+  for ( startIterator.GoToBegin(); !startIterator.IsAtEnd(); ++startIterator )
+    {
+    typename TOutputImage::IndexType index = startIterator.GetIndex();
+    for ( SizeValueType first = 0; first < blockLength; first += L )
       {
-      // Copy coefficients to scratch
-      this->CopyCoefficientsToScratch(CIterator);
-
-      // Perform 1D BSpline calculations
-      this->DataToCoefficients1D();
-
-      // Copy scratch back to coefficients.
-      // Brings us back to the end of the line we were working on.
-      CIterator.GoToBeginOfLine();
-      this->CopyScratchToCoefficients(CIterator);   // m_Scratch = m_Image;
-      CIterator.NextLine();
-      progress.CompletedPixel();
+      const unsigned int numberOfLines =
+        static_cast< unsigned int >( std::min< SizeValueType >(L, blockLength - first) );
+
+      OutputPixelType *output = outputBuffer + outputImage->ComputeOffset(index);
+      for ( SizeValueType i = 0; i < ln; i++ )
+        {
+        CoeffType   *s = &scratch[i * L];
+        unsigned int l = 0;
+        for (; l < numberOfLines; l++ )
+          {
+          s[l] = static_cast< CoeffType >( output[i * stride + l * lineStride] );
+          }
+        // the lines missing from the last block repeat its last line
+        for (; l < L; l++ )
+          {
+          s[l] = s[numberOfLines - 1];
+          }
+        }
+
+      this->DataToCoefficients1D(&scratch[0], ln, L);
+
+      for ( SizeValueType i = 0; i < ln; i++ )
+        {
+        const CoeffType *s = &scratch[i * L];
+        for ( unsigned int l = 0; l < numberOfLines; l++ )
+          {
+          output[i * stride + l * lineStride] = static_cast< OutputPixelType >( s[l] );
+          }
+        }
+
+      index[blockDimension] += L;
+      progress.CompletedPixels(numberOfLines);
       }
     }
+  return true;
+}
+
+/**
+ * Filter the lines of the region one at a time
+ */
+template< class TInputImage, class TOutputImage >
+void
+BSplineDecompositionImageFilter< TInputImage, TOutputImage >
+::DataToCoefficientsByLine(const OutputImageRegionType & region, ThreadIdType threadId)
+{
+  const SizeValueType      ln = region.GetSize(m_IteratorDirection);
+  std::vector< CoeffType > scratch(ln);
+
+  ProgressReporter progress(this, threadId, region.GetNumberOfPixels() / ln, 10,
+                            m_IteratorDirection / static_cast< float >( ImageDimension ),
+                            1.0f / ImageDimension);
+
+  OutputLinearIterator CIterator(this->GetOutput(), region);
+  CIterator.SetDirection(m_IteratorDirection);
+  // For each data vector
+  while ( !CIterator.IsAtEnd() )
+    {
+    // Copy coefficients to scratch
+    this->CopyCoefficientsToScratch(CIterator, &scratch[0]);
+
+    // Perform 1D BSpline calculations
+    this->DataToCoefficients1D(&scratch[0], ln, 1);
+
+    // Copy scratch back to coefficients.
+    // Brings us back to the end of the line we were working on.
+    CIterator.GoToBeginOfLine();
+    this->CopyScratchToCoefficients(CIterator, &scratch[0]);
+    CIterator.NextLine();
+    progress.CompletedPixel();
+    }
 }
 
 /**
@@ -283,17 +407,17 @@ BSplineDecompositionImageFilter< TInputImage, TOutputImage >
 template< class TInputImage, class TOutputImage >
 void
 BSplineDecompositionImageFilter< TInputImage, TOutputImage >
-::CopyImageToImage()
+::CopyImageToImage(const OutputImageRegionType & region)
 {
-  typedef ImageRegionConstIteratorWithIndex< TInputImage > InputIterator;
-  typedef ImageRegionIterator< TOutputImage >              OutputIterator;
-  typedef typename TOutputImage::PixelType                 OutputPixelType;
+  typedef ImageRegionConstIterator< TInputImage > InputIterator;
+  typedef ImageRegionIterator< TOutputImage >     OutputIterator;
+  typedef typename TOutputImage::PixelType        OutputPixelType;
 
-  InputIterator  inIt( this->GetInput(), this->GetInput()->GetBufferedRegion() );
-  OutputIterator outIt( this->GetOutput(), this->GetOutput()->GetBufferedRegion() );
+  InputIterator  inIt(this->GetInput(), region);
+  OutputIterator outIt(this->GetOutput(), region);
 
-  inIt = inIt.Begin();
-  outIt = outIt.Begin();
+  inIt.GoToBegin();
+  outIt.GoToBegin();
 
   while ( !outIt.IsAtEnd() )
     {
@@ -309,13 +433,13 @@ BSplineDecompositionImageFilter< TInputImage, TOutputImage >
 template< class TInputImage, class TOutputImage >
 void
 BSplineDecompositionImageFilter< TInputImage, TOutputImage >
-::CopyScratchToCoefficients(OutputLinearIterator & Iter)
+::CopyScratchToCoefficients(OutputLinearIterator & Iter, const CoeffType *scratch)
 {
   typedef typename TOutputImage::PixelType OutputPixelType;
   typename TOutputImage::SizeValueType j = 0;
   while ( !Iter.IsAtEndOfLine() )
     {
-    Iter.Set( static_cast< OutputPixelType >( m_Scratch[j] ) );
+    Iter.Set( static_cast< OutputPixelType >( scratch[j] ) );
     ++Iter;
     ++j;
     }
@@ -327,13 +451,13 @@ BSplineDecompositionImageFilter< TInputImage, TOutputImage >
 template< class TInputImage, class TOutputImage >
 void
 BSplineDecompositionImageFilter< TInputImage, TOutputImage >
-::CopyCoefficientsToScratch(OutputLinearIterator & Iter)
+::CopyCoefficientsToScratch(OutputLinearIterator & Iter, CoeffType *scratch)
 {
   typename TOutputImage::SizeValueType j = 0;
 
   while ( !Iter.IsAtEndOfLine() )
     {
-    m_Scratch[j] = static_cast< CoeffType >( Iter.Get() );
+    scratch[j] = static_cast< CoeffType >( Iter.Get() );
     ++Iter;
     ++j;
     }
@@ -377,6 +501,93 @@ BSplineDecompositionImageFilter< TInputImage, TOutputImage >
     }
 }
 
+template< class TInputImage, class TOutputImage >
+unsigned int
+BSplineDecompositionImageFilter< TInputImage, TOutputImage >
+::SplitRequestedRegion(unsigned int i, unsigned int num, OutputImageRegionType & splitRegion)
+{
+  // Get the output pointer
+  TOutputImage *outputPtr = this->GetOutput();
+
+  const typename TOutputImage::SizeType & requestedRegionSize =
+    outputPtr->GetRequestedRegion().GetSize();
+
+  int splitAxis;
+  typename TOutputImage::IndexType splitIndex;
+  typename TOutputImage::SizeType splitSize;
+
+  // Initialize the splitRegion to the output requested region
+  splitRegion = outputPtr->GetRequestedRegion();
+  splitIndex = splitRegion.GetIndex();
+  splitSize = splitRegion.GetSize();
+
+  // split on the outermost dimension available
+  // and avoid the current dimension
+  splitAxis = outputPtr->GetImageDimension() - 1;
+  while ( requestedRegionSize[splitAxis] == 1 || splitAxis == (int)m_IteratorDirection )
+    {
+    --splitAxis;
+    if ( splitAxis < 0 )
+      { // cannot split
+      itkDebugMacro("  Cannot Split");
+      return 1;
+      }
+    }
+
+  // determine the actual number of pieces that will be generated
+  typename TOutputImage::SizeType::SizeValueType range = requestedRegionSize[splitAxis];
+  unsigned int valuesPerThread = (unsigned int)vcl_ceil(range / (double)num);
+  unsigned int maxThreadIdUsed = (unsigned int)vcl_ceil(range / (double)valuesPerThread) - 1;
+
+  // Split the region
+  if ( i < maxThreadIdUsed )
+    {
+    splitIndex[splitAxis] += i * valuesPerThread;
+    splitSize[splitAxis] = valuesPerThread;
+    }
+  if ( i == maxThreadIdUsed )
+    {
+    splitIndex[splitAxis] += i * valuesPerThread;
+    // last thread needs to process the "rest" dimension being split
+    splitSize[splitAxis] = splitSize[splitAxis] - i * valuesPerThread;
+    }
+
+  // set the split region ivars
+  splitRegion.SetIndex(splitIndex);
+  splitRegion.SetSize(splitSize);
+
+  itkDebugMacro("  Split Piece: " << splitRegion);
+
+  return maxThreadIdUsed + 1;
+}
+
+/**
+ * ThreadedGenerateData
+ */
+template< class TInputImage, class TOutputImage >
+void
+BSplineDecompositionImageFilter< TInputImage, TOutputImage >
+::ThreadedGenerateData(const OutputImageRegionType & outputRegionForThread,
+                       ThreadIdType threadId)
+{
+  // Initialize coeffient array
+  if ( m_IteratorDirection == 0 )
+    {
+    // Coefficients are initialized to the input data
+    this->CopyImageToImage(outputRegionForThread);
+    }
+
+  if ( m_DataLength[m_IteratorDirection] == 1 ) //Required by mirror boundaries
+    {
+    return;
+    }
+
+  if ( !this->DataToCoefficientsInBlocks(outputRegionForThread, threadId) )
+    {
+    this->DataToCoefficientsByLine(outputRegionForThread, threadId);
+    }
+}
+
 /**
  * Generate data
  */
@@ -385,31 +596,30 @@ void
 BSplineDecompositionImageFilter< TInputImage, TOutputImage >
 ::GenerateData()
 {
-  // Allocate scratch memory
   InputImageConstPointer inputPtr = this->GetInput();
 
   m_DataLength = inputPtr->GetBufferedRegion().GetSize();
 
-  typename TOutputImage::SizeValueType maxLength = 0;
-  for ( unsigned int n = 0; n < ImageDimension; n++ )
-    {
-    if ( m_DataLength[n] > maxLength )
-      {
-      maxLength = m_DataLength[n];
-      }
-    }
-  m_Scratch.resize(maxLength);
-
   // Allocate memory for output image
   OutputImagePointer outputPtr = this->GetOutput();
   outputPtr->SetBufferedRegion( outputPtr->GetRequestedRegion() );
   outputPtr->Allocate();
 
-  // Calculate actual output
-  this->DataToCoefficientsND();
+  // Set up the multithreaded processing
+  typename Superclass::ThreadStruct str;
+  str.Filter = this;
 
-  // Clean up
-  m_Scratch.clear();
+  this->GetMultiThreader()->SetNumberOfThreads( this->GetNumberOfThreads() );
+  this->GetMultiThreader()->SetSingleMethod(this->ThreaderCallback, &str);
+
+  // Calculate actual output. The lines along a dimension are filtered
+  // after all the lines along the previous ones, so the threads are
+  // started for each dimension.
+  for ( unsigned int n = 0; n < ImageDimension; n++ )
+    {
+    m_IteratorDirection = n;
+    this->GetMultiThreader()->SingleMethodExecute();
+    }
 }
 } // namespace itk
 
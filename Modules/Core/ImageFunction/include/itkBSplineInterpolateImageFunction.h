@@ -59,7 +59,8 @@ namespace itk
  * And code obtained from bigwww.epfl.ch by Philippe Thevenaz
  *
  * The B spline coefficients are calculated through the
- * BSplineDecompositionImageFilter
+ * BSplineDecompositionImageFilter, which SetCoefficientFilter() can
+ * share between interpolators of the same image.
  *
  * Limitations:  Spline order must be between 0 and 5.
  *               Spline order must be set before setting the image.
@@ -107,7 +108,8 @@ public:
   itkStaticConstMacro(ImageDimension, unsigned int, Superclass::ImageDimension);
 
   /** Index typedef support. */
-  typedef typename Superclass::IndexType IndexType;
+  typedef typename Superclass::IndexType      IndexType;
+  typedef typename Superclass::IndexValueType IndexValueType;
 
   /** ContinuousIndex typedef support. */
   typedef typename Superclass::ContinuousIndexType ContinuousIndexType;
@@ -298,6 +300,17 @@ public:
   /** Set the input image.  This must be set by the user. */
   virtual void SetInputImage(const TImageType *inputData);
 
+  /** Set/Get the filter that computes the B-spline coefficients of the
+   * input image. Interpolators of the same input image, with the same
+   * spline order, can share one filter, so that the coefficients are
+   * computed only once: the filter does not execute again while its
+   * input and spline order do not change. The spline order of this
+   * interpolator is set on the filter, and its number of threads is
+   * the one used to compute the coefficients. Like the spline order,
+   * it must be set before the input image. */
+  virtual void SetCoefficientFilter(CoefficientFilter *filter);
+  itkGetObjectMacro(CoefficientFilter, CoefficientFilter);
+
   /** The UseImageDirection flag determines whether image derivatives are
    * computed with respect to the image grid or with respect to the physical
    * space. When this flag is ON the derivatives are computed with respect to
@@ -311,6 +324,21 @@ public:
   itkSetMacro(UseImageDirection, bool);
   itkGetConstMacro(UseImageDirection, bool);
   itkBooleanMacro(UseImageDirection);
+
+  /** The B-spline is separable: its samples are the coefficients of the
+   * SplineOrder + 1 nearest pixels along each dimension, with mirror
+   * boundary conditions. */
+  virtual unsigned int GetSeparableSupportSize() const
+  {
+    return m_SplineOrder + 1;
+  }
+
+  virtual void ComputeSeparableWeights(const TCoordRep & x, IndexValueType & firstIndex,
+                                       double *weights) const;
+
+  virtual void GetSeparableSamples(const IndexType & index, SizeValueType length,
+                                   double *samples) const;
+
 protected:
 
   /** The following methods take working space (evaluateIndex, weights, weightsDerivative)
@@ -373,6 +401,11 @@ private:
                                vnl_matrix< double > & weights,
                                unsigned int splineOrder) const;
 
+  /** Determines the weights along one dimension, where the region of
+   * support starts at firstIndex */
+  void SetInterpolationWeights(double x, long firstIndex, double *weights,
+                               unsigned int splineOrder) const;
+
   /** Determines the weights for the derivative portion of the value x */
   void SetDerivativeWeights(const ContinuousIndexType & x,
                             const vnl_matrix< long > & EvaluateIndex,
@@ -388,11 +421,17 @@ private:
                                 const ContinuousIndexType & x,
                                 unsigned int splineOrder) const;
 
+  /** Returns the first index of the region of support along one dimension */
+  long DetermineRegionOfSupport(TCoordRep x, unsigned int splineOrder) const;
+
   /** Set the indicies in evaluateIndex at the boundaries based on mirror
     * boundary conditions. */
   void ApplyMirrorBoundaryConditions(vnl_matrix< long > & evaluateIndex,
                                      unsigned int splineOrder) const;
 
+  /** Returns the index used for index along one dimension */
+  long ApplyMirrorBoundaryConditions(long index, unsigned int dimension) const;
+
   Iterator m_CIterator;                                    // Iterator for
                                                            // traversing spline
                                                            // coefficients.
@@ -96,6 +96,7 @@ BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
   os << indent << "UseImageDirection = "
      << ( this->m_UseImageDirection ? "On" : "Off" ) << std::endl;
   os << indent << "NumberOfThreads: " << m_NumberOfThreads  << std::endl;
+  os << indent << "CoefficientFilter: " << m_CoefficientFilter.GetPointer() << std::endl;
 }
 
 template< class TImageType, class TCoordRep, class TCoefficientType >
@@ -122,6 +123,24 @@ BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
     }
 }
 
+template< class TImageType, class TCoordRep, class TCoefficientType >
+void
+BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
+::SetCoefficientFilter(CoefficientFilter *filter)
+{
+  if ( filter == NULL )
+    {
+    itkExceptionMacro(<< "The coefficient filter cannot be NULL");
+    }
+  if ( filter == m_CoefficientFilter )
+    {
+    return;
+    }
+  m_CoefficientFilter = filter;
+  m_CoefficientFilter->SetSplineOrder(m_SplineOrder);
+  this->Modified();
+}
+
 template< class TImageType, class TCoordRep, class TCoefficientType >
 void
 BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
@@ -392,98 +411,87 @@ BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
                           const vnl_matrix< long > & EvaluateIndex,
                           vnl_matrix< double > & weights,
                           unsigned int splineOrder) const
+{
+  for ( unsigned int n = 0; n < ImageDimension; n++ )
+    {
+    this->SetInterpolationWeights(x[n], EvaluateIndex[n][0], weights[n], splineOrder);
+    }
+}
+
+template< class TImageType, class TCoordRep, class TCoefficientType >
+void
+BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
+::SetInterpolationWeights(double x, long firstIndex, double *weights,
+                          unsigned int splineOrder) const
 {
   // For speed improvements we could make each case a separate function and use
   // function pointers to reference the correct weight order.
   // Left as is for now for readability.
   double w, w2, w4, t, t0, t1;
 
+  // distance to the center of the region of support
+  w = x - (double)( firstIndex + (long)( splineOrder / 2 ) );
+
   switch ( splineOrder )
     {
     case 3:
       {
-      for ( unsigned int n = 0; n < ImageDimension; n++ )
-        {
-        w = x[n] - (double)EvaluateIndex[n][1];
-        weights[n][3] = ( 1.0 / 6.0 ) * w * w * w;
-        weights[n][0] = ( 1.0 / 6.0 ) + 0.5 * w * ( w - 1.0 ) - weights[n][3];
-        weights[n][2] = w + weights[n][0] - 2.0 * weights[n][3];
-        weights[n][1] = 1.0 - weights[n][0] - weights[n][2] - weights[n][3];
-        }
+      weights[3] = ( 1.0 / 6.0 ) * w * w * w;
+      weights[0] = ( 1.0 / 6.0 ) + 0.5 * w * ( w - 1.0 ) - weights[3];
+      weights[2] = w + weights[0] - 2.0 * weights[3];
+      weights[1] = 1.0 - weights[0] - weights[2] - weights[3];
       break;
       }
     case 0:
       {
-      for ( unsigned int n = 0; n < ImageDimension; n++ )
-        {
-        weights[n][0] = 1; // implements nearest neighbor
-        }
+      weights[0] = 1; // implements nearest neighbor
       break;
       }
     case 1:
       {
-      for ( unsigned int n = 0; n < ImageDimension; n++ )
-        {
-        w = x[n] - (double)EvaluateIndex[n][0];
-        weights[n][1] = w;
-        weights[n][0] = 1.0 - w;
-        }
+      weights[1] = w;
+      weights[0] = 1.0 - w;
       break;
       }
     case 2:
       {
-      for ( unsigned int n = 0; n < ImageDimension; n++ )
-        {
-        /* x */
-        w = x[n] - (double)EvaluateIndex[n][1];
-        weights[n][1] = 0.75 - w * w;
-        weights[n][2] = 0.5 * ( w - weights[n][1] + 1.0 );
-        weights[n][0] = 1.0 - weights[n][1] - weights[n][2];
-        }
+      weights[1] = 0.75 - w * w;
+      weights[2] = 0.5 * ( w - weights[1] + 1.0 );
+      weights[0] = 1.0 - weights[1] - weights[2];
       break;
       }
     case 4:
       {
-      for ( unsigned int n = 0; n < ImageDimension; n++ )
-        {
-        /* x */
-        w = x[n] - (double)EvaluateIndex[n][2];
-        w2 = w * w;
-        t = ( 1.0 / 6.0 ) * w2;
-        weights[n][0] = 0.5 - w;
-        weights[n][0] *= weights[n][0];
-        weights[n][0] *= ( 1.0 / 24.0 ) * weights[n][0];
-        t0 = w * ( t - 11.0 / 24.0 );
-        t1 = 19.0 / 96.0 + w2 * ( 0.25 - t );
-        weights[n][1] = t1 + t0;
-        weights[n][3] = t1 - t0;
-        weights[n][4] = weights[n][0] + t0 + 0.5 * w;
-        weights[n][2] = 1.0 - weights[n][0] - weights[n][1] - weights[n][3] - weights[n][4];
-        }
+      w2 = w * w;
+      t = ( 1.0 / 6.0 ) * w2;
+      weights[0] = 0.5 - w;
+      weights[0] *= weights[0];
+      weights[0] *= ( 1.0 / 24.0 ) * weights[0];
+      t0 = w * ( t - 11.0 / 24.0 );
+      t1 = 19.0 / 96.0 + w2 * ( 0.25 - t );
+      weights[1] = t1 + t0;
+      weights[3] = t1 - t0;
+      weights[4] = weights[0] + t0 + 0.5 * w;
+      weights[2] = 1.0 - weights[0] - weights[1] - weights[3] - weights[4];
       break;
       }
     case 5:
       {
-      for ( unsigned int n = 0; n < ImageDimension; n++ )
-        {
-        /* x */
-        w = x[n] - (double)EvaluateIndex[n][2];
-        w2 = w * w;
-        weights[n][5] = ( 1.0 / 120.0 ) * w * w2 * w2;
-        w2 -= w;
-        w4 = w2 * w2;
-        w -= 0.5;
-        t = w2 * ( w2 - 3.0 );
-        weights[n][0] = ( 1.0 / 24.0 ) * ( 1.0 / 5.0 + w2 + w4 ) - weights[n][5];
-        t0 = ( 1.0 / 24.0 ) * ( w2 * ( w2 - 5.0 ) + 46.0 / 5.0 );
-        t1 = ( -1.0 / 12.0 ) * w * ( t + 4.0 );
-        weights[n][2] = t0 + t1;
-        weights[n][3] = t0 - t1;
-        t0 = ( 1.0 / 16.0 ) * ( 9.0 / 5.0 - t );
-        t1 = ( 1.0 / 24.0 ) * w * ( w4 - w2 - 5.0 );
-        weights[n][1] = t0 + t1;
-        weights[n][4] = t0 - t1;
-        }
+      w2 = w * w;
+      weights[5] = ( 1.0 / 120.0 ) * w * w2 * w2;
+      w2 -= w;
+      w4 = w2 * w2;
+      w -= 0.5;
+      t = w2 * ( w2 - 3.0 );
+      weights[0] = ( 1.0 / 24.0 ) * ( 1.0 / 5.0 + w2 + w4 ) - weights[5];
+      t0 = ( 1.0 / 24.0 ) * ( w2 * ( w2 - 5.0 ) + 46.0 / 5.0 );
+      t1 = ( -1.0 / 12.0 ) * w * ( t + 4.0 );
+      weights[2] = t0 + t1;
+      weights[3] = t0 - t1;
+      t0 = ( 1.0 / 16.0 ) * ( 9.0 / 5.0 - t );
+      t1 = ( 1.0 / 24.0 ) * w * ( w4 - w2 - 5.0 );
+      weights[1] = t0 + t1;
+      weights[4] = t0 - t1;
       break;
       }
     default:
@@ -679,42 +687,75 @@ BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
 ::DetermineRegionOfSupport(vnl_matrix< long > & evaluateIndex,
                            const ContinuousIndexType & x,
                            unsigned int splineOrder) const
+{
+  // compute the interpolation indexes
+  for ( unsigned int n = 0; n < ImageDimension; n++ )
+    {
+    long indx = this->DetermineRegionOfSupport(x[n], splineOrder);
+    for ( unsigned int k = 0; k <= splineOrder; k++ )
+      {
+      evaluateIndex[n][k] = indx++;
+      }
+    }
+}
+
+template< class TImageType, class TCoordRep, class TCoefficientType >
+long
+BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
+::DetermineRegionOfSupport(TCoordRep x, unsigned int splineOrder) const
 {
   long indx;
 
-// compute the interpolation indexes
   if ( splineOrder & 1 )     // Use this index calculation for odd splineOrder
     {
-    for ( unsigned int n = 0; n < ImageDimension; n++ )
+    indx = (long)x;
+    if ( indx < 0 && (double)indx != (double)x )
       {
-      indx = (long)x[n];
-      if ( indx < 0 && (double)indx != (double)x[n] )
-        {
-        indx--;
-        }
-      indx -= splineOrder / 2;
-      for ( unsigned int k = 0; k <= splineOrder; k++ )
-        {
-        evaluateIndex[n][k] = indx++;
-        }
+      indx--;
       }
     }
   else                       // Use this index calculation for even splineOrder
     {
-    for ( unsigned int n = 0; n < ImageDimension; n++ )
+    indx = (long)( x + 0.5 );
+    if ( indx < 0 && (double)indx != (double)( x + 0.5 ) )
       {
-      indx = (long)( x[n] + 0.5 );
-      if ( indx < 0 && (double)indx != (double)( x[n] + 0.5 ) )
-        {
-        indx--;
-        }
-      indx -= splineOrder / 2;
-      for ( unsigned int k = 0; k <= splineOrder; k++ )
-        {
-        evaluateIndex[n][k] = indx++;
-        }
+      indx--;
       }
     }
+  return indx - splineOrder / 2;
+}
+
+template< class TImageType, class TCoordRep, class TCoefficientType >
+void
+BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
+::ComputeSeparableWeights(const TCoordRep & x, IndexValueType & firstIndex,
+                          double *weights) const
+{
+  firstIndex = this->DetermineRegionOfSupport(x, m_SplineOrder);
+  this->SetInterpolationWeights(x, firstIndex, weights, m_SplineOrder);
+}
+
+template< class TImageType, class TCoordRep, class TCoefficientType >
+void
+BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
+::GetSeparableSamples(const IndexType & index, SizeValueType length,
+                      double *samples) const
+{
+  // the row of coefficients, with the mirror boundary conditions
+  IndexType rowIndex;
+  rowIndex[0] = this->GetStartIndex()[0];
+  for ( unsigned int n = 1; n < ImageDimension; n++ )
+    {
+    rowIndex[n] = this->ApplyMirrorBoundaryConditions(index[n], n);
+    }
+  const CoefficientDataType *row = m_Coefficients->GetBufferPointer()
+                                   + m_Coefficients->ComputeOffset(rowIndex);
+
+  for ( SizeValueType i = 0; i < length; i++ )
+    {
+    const long x = this->ApplyMirrorBoundaryConditions(index[0] + static_cast< long >( i ), 0);
+    samples[i] = static_cast< double >( row[x - rowIndex[0]] );
+    }
 }
 
 template< class TImageType, class TCoordRep, class TCoefficientType >
@@ -723,39 +764,40 @@ BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
 ::ApplyMirrorBoundaryConditions(vnl_matrix< long > & evaluateIndex,
                                 unsigned int splineOrder) const
 {
-  const IndexType startIndex = this->GetStartIndex();
-  const IndexType endIndex = this->GetEndIndex();
-
   for ( unsigned int n = 0; n < ImageDimension; n++ )
     {
-    // apply the mirror boundary conditions
-    // TODO:  We could implement other boundary options beside mirror
-    if ( m_DataLength[n] == 1 )
-      {
-      for ( unsigned int k = 0; k <= splineOrder; k++ )
-        {
-        evaluateIndex[n][k] = 0;
-        }
-      }
-    else
+    for ( unsigned int k = 0; k <= splineOrder; k++ )
       {
-      for ( unsigned int k = 0; k <= splineOrder; k++ )
-        {
-        if ( evaluateIndex[n][k] < startIndex[n] )
-          {
-          evaluateIndex[n][k] = startIndex[n] +
-            ( startIndex[n] - evaluateIndex[n][k] );
-          }
-        if ( evaluateIndex[n][k] >= endIndex[n] )
-          {
-          evaluateIndex[n][k] = endIndex[n] -
-            ( evaluateIndex[n][k] - endIndex[n] );
-          }
-        }
+      evaluateIndex[n][k] = this->ApplyMirrorBoundaryConditions(evaluateIndex[n][k], n);
       }
     }
 }
 
+template< class TImageType, class TCoordRep, class TCoefficientType >
+long
+BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
+::ApplyMirrorBoundaryConditions(long index, unsigned int dimension) const
+{
+  const IndexValueType startIndex = this->GetStartIndex()[dimension];
+  const IndexValueType endIndex = this->GetEndIndex()[dimension];
+
+  // apply the mirror boundary conditions
+  // TODO:  We could implement other boundary options beside mirror
+  if ( m_DataLength[dimension] == 1 )
+    {
+    return 0;
+    }
+  if ( index < startIndex )
+    {
+    index = startIndex + ( startIndex - index );
+    }
+  if ( index >= endIndex )
+    {
+    index = endIndex - ( index - endIndex );
+    }
+  return index;
+}
+
 template< class TImageType, class TCoordRep, class TCoefficientType >
 typename
 BSplineInterpolateImageFunction< TImageType, TCoordRep, TCoefficientType >
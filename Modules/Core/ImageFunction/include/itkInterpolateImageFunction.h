@@ -123,6 +123,36 @@ public:
     return ( static_cast< RealType >( this->GetInputImage()->GetPixel(index) ) );
   }
 
+  /** Separable interpolators sum samples weighted by the product of one
+   * weight per dimension, which only depends on the continuous index
+   * along that dimension. They return the number of samples weighted
+   * along each dimension, and filters that evaluate them on a lattice,
+   * like ResampleImageFilter, may then compute the weights once per row
+   * of the lattice with ComputeSeparableWeights(), and sum the samples
+   * copied by GetSeparableSamples() themselves. The other interpolators
+   * return 0. */
+  virtual unsigned int GetSeparableSupportSize() const
+  {
+    return 0;
+  }
+
+  /** Computes the first index of the samples weighted along a dimension
+   * where the continuous index is x, and their GetSeparableSupportSize()
+   * weights. */
+  virtual void ComputeSeparableWeights(const TCoordRep & itkNotUsed(x),
+                                       IndexValueType & itkNotUsed(firstIndex),
+                                       double *itkNotUsed(weights) ) const
+  {}
+
+  /** Copies length samples, converted to double, from index along the
+   * first dimension. The samples may be the pixels of the input image, or
+   * coefficients computed from them. The samples outside the buffer
+   * follow the boundary conditions of the interpolator. */
+  virtual void GetSeparableSamples(const IndexType & itkNotUsed(index),
+                                   SizeValueType itkNotUsed(length),
+                                   double *itkNotUsed(samples) ) const
+  {}
+
 protected:
   InterpolateImageFunction(){}
   ~InterpolateImageFunction(){}
@@ -303,6 +303,20 @@ public:
   virtual OutputType EvaluateAtContinuousIndex(
     const ContinuousIndexType & index) const;
 
+  /** The windowed sinc is separable: its samples are the 2 * VRadius
+   * nearest pixels along each dimension, whose weights are not always
+   * zero, with the TBoundaryCondition boundary condition. */
+  virtual unsigned int GetSeparableSupportSize() const
+  {
+    return m_WindowSize;
+  }
+
+  virtual void ComputeSeparableWeights(const TCoordRep & x, IndexValueType & firstIndex,
+                                       double *weights) const;
+
+  virtual void GetSeparableSamples(const IndexType & index, SizeValueType length,
+                                   double *samples) const;
+
 protected:
   WindowedSincInterpolateImageFunction();
   virtual ~WindowedSincInterpolateImageFunction();
@@ -333,6 +347,10 @@ private:
   /** Index into the weights array for each offset */
   unsigned int **m_WeightOffsetTable;
 
+  /** Computes the weights of the neighbors along one dimension, where
+   * the continuous index is at distance from the pixel below it */
+  void ComputeWeights(double distance, double *weights) const;
+
   /** The sinc function */
   inline double Sinc(double x) const
   {
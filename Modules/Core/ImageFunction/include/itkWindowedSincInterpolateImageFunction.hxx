@@ -184,6 +184,101 @@ WindowedSincInterpolateImageFunction< TInputImage, VRadius,
   this->Superclass::PrintSelf(os, indent);
 }
 
+/** Compute the weights of the neighbors along one dimension */
+template< class TInputImage, unsigned int VRadius,
+          class TWindowFunction, class TBoundaryCondition, class TCoordRep >
+void
+WindowedSincInterpolateImageFunction< TInputImage, VRadius,
+                                      TWindowFunction, TBoundaryCondition, TCoordRep >
+::ComputeWeights(double distance, double *weights) const
+{
+  // x is the offset, hence the parameter of the kernel
+  double x = distance + VRadius;
+
+  // If distance is zero, i.e. the index falls precisely on the
+  // pixel boundary, the weights form a delta function.
+  if ( distance == 0.0 )
+    {
+    for ( unsigned int i = 0; i < m_WindowSize; i++ )
+      {
+      weights[i] = static_cast< int >( i ) == VRadius - 1 ? 1 : 0;
+      }
+    }
+  else
+    {
+    // i is the relative offset.
+    for ( unsigned int i = 0; i < m_WindowSize; i++ )
+      {
+      // Increment the offset, taking it through the range
+      // (dist + rad - 1, ..., dist - rad), i.e. all x
+      // such that vcl_abs(x) <= rad
+      x -= 1.0;
+
+      // Compute the weight for this m
+      weights[i] = m_WindowFunction(x) * Sinc(x);
+      }
+    }
+}
+
+/** Compute the weights along one dimension for separable evaluation */
+template< class TInputImage, unsigned int VRadius,
+          class TWindowFunction, class TBoundaryCondition, class TCoordRep >
+void
+WindowedSincInterpolateImageFunction< TInputImage, VRadius,
+                                      TWindowFunction, TBoundaryCondition, TCoordRep >
+::ComputeSeparableWeights(const TCoordRep & x, IndexValueType & firstIndex,
+                          double *weights) const
+{
+  const IndexValueType baseIndex = Math::Floor< IndexValueType >(x);
+
+  // the first weight is that of the offset 1 - VRadius, as the weight of
+  // the offset -VRadius is always zero
+  firstIndex = baseIndex + 1 - static_cast< IndexValueType >( VRadius );
+  this->ComputeWeights(x - static_cast< double >( baseIndex ), weights);
+}
+
+/** Copy the pixels along the first dimension for separable evaluation */
+template< class TInputImage, unsigned int VRadius,
+          class TWindowFunction, class TBoundaryCondition, class TCoordRep >
+void
+WindowedSincInterpolateImageFunction< TInputImage, VRadius,
+                                      TWindowFunction, TBoundaryCondition, TCoordRep >
+::GetSeparableSamples(const IndexType & index, SizeValueType length,
+                      double *samples) const
+{
+  const ImageType * image = this->GetInputImage();
+  const IndexType & startIndex = this->GetStartIndex();
+  const IndexType & endIndex = this->GetEndIndex();
+
+  // the pixels of rows outside the buffer, and those of rows inside it
+  // but outside the buffer along the first dimension, are given by the
+  // boundary condition
+  bool rowIsInside = true;
+  for ( unsigned int dim = 1; dim < ImageDimension; dim++ )
+    {
+    rowIsInside = rowIsInside && index[dim] >= startIndex[dim] && index[dim] <= endIndex[dim];
+    }
+  IndexType rowIndex = index;
+  rowIndex[0] = startIndex[0];
+  const typename ImageType::PixelType *row = rowIsInside ?
+                                             image->GetBufferPointer() + image->ComputeOffset(rowIndex) : 0;
+
+  TBoundaryCondition boundaryCondition;
+  IndexType          sampleIndex = index;
+  for ( SizeValueType i = 0; i < length; i++ )
+    {
+    sampleIndex[0] = index[0] + static_cast< IndexValueType >( i );
+    if ( rowIsInside && sampleIndex[0] >= startIndex[0] && sampleIndex[0] <= endIndex[0] )
+      {
+      samples[i] = static_cast< double >( row[sampleIndex[0] - startIndex[0]] );
+      }
+    else
+      {
+      samples[i] = static_cast< double >( boundaryCondition.GetPixel(sampleIndex, image) );
+      }
+    }
+}
+
 /** Evaluate at image index position */
 template< class TInputImage, unsigned int VRadius,
           class TWindowFunction, class TBoundaryCondition, class TCoordRep >
@@ -220,32 +315,7 @@ WindowedSincInterpolateImageFunction< TInputImage, VRadius,
   double xWeight[ImageDimension][2 * VRadius];
   for ( dim = 0; dim < ImageDimension; dim++ )
     {
-    // x is the offset, hence the parameter of the kernel
-    double x = distance[dim] + VRadius;
-
-    // If distance is zero, i.e. the index falls precisely on the
-    // pixel boundary, the weights form a delta function.
-    if ( distance[dim] == 0.0 )
-      {
-      for ( unsigned int i = 0; i < m_WindowSize; i++ )
-        {
-        xWeight[dim][i] = static_cast< int >( i ) == VRadius - 1 ? 1 : 0;
-        }
-      }
-    else
-      {
-      // i is the relative offset in dimension dim.
-      for ( unsigned int i = 0; i < m_WindowSize; i++ )
-        {
-        // Increment the offset, taking it through the range
-        // (dist + rad - 1, ..., dist - rad), i.e. all x
-        // such that vcl_abs(x) <= rad
-        x -= 1.0;
-
-        // Compute the weight for this m
-        xWeight[dim][i] = m_WindowFunction(x) * Sinc(x);
-        }
-      }
+    this->ComputeWeights(distance[dim], xWeight[dim]);
     }
 
   // Iterate over the neighborhood, taking the correct set
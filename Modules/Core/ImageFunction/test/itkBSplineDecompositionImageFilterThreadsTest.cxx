@@ -0,0 +1,213 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkBSplineDecompositionImageFilter.h"
+#include "itkBSplineInterpolateImageFunction.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMultiThreader.h"
+#include "itkTimeProbe.h"
+#include <iomanip>
+
+// Computes the B-spline coefficients of float and short images, with
+// spline orders from 0 to 5, including images one pixel wide along some
+// dimensions, with one and several threads, and checks that the
+// coefficients do not depend on the number of threads, and that a
+// B-spline interpolator gives back the pixel values at the pixels. It
+// also checks that two interpolators can share the coefficients of the
+// same image. It then reports the time taken by the interpolator to
+// compute the coefficients of a float volume with 1 to the default
+// number of threads. Pass a larger edge length, e.g. 512, to use it as a
+// benchmark.
+
+namespace
+{
+template< class TImage >
+typename TImage::Pointer MakeImage(const typename TImage::SizeType & size)
+{
+  typename TImage::Pointer image = TImage::New();
+  typename TImage::IndexType index;
+  for ( unsigned int d = 0; d < TImage::ImageDimension; ++d )
+    {
+    index[d] = 3 - 2 * static_cast< int >( d );
+    }
+  typename TImage::RegionType region(index, size);
+  image->SetRegions(region);
+  image->Allocate();
+  unsigned int random = 1;
+  itk::ImageRegionIterator< TImage > it(image, region);
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    random = random * 1103515245 + 12345;
+    it.Set( static_cast< typename TImage::PixelType >( ( random >> 8 ) % 1000 ) );
+    }
+  return image;
+}
+
+template< class TImage >
+bool TestImage(const char *name, const typename TImage::SizeType & size)
+{
+  typedef itk::Image< double, TImage::ImageDimension >                   CoefficientImageType;
+  typedef itk::BSplineDecompositionImageFilter< TImage, CoefficientImageType > FilterType;
+  typedef itk::BSplineInterpolateImageFunction< TImage, double, double >       InterpolatorType;
+
+  typename TImage::Pointer input = MakeImage< TImage >(size);
+
+  for ( unsigned int order = 0; order <= 5; ++order )
+    {
+    typename FilterType::Pointer filter = FilterType::New();
+    filter->SetInput(input);
+    filter->SetSplineOrder(order);
+    filter->SetNumberOfThreads(1);
+    filter->Update();
+    typename CoefficientImageType::Pointer expected = filter->GetOutput();
+    expected->DisconnectPipeline();
+
+    for ( unsigned int threads = 2; threads <= 5; threads += 3 )
+      {
+      filter->SetNumberOfThreads(threads);
+      filter->Update();
+      itk::ImageRegionConstIteratorWithIndex< CoefficientImageType > it( filter->GetOutput(),
+                                                                         input->GetLargestPossibleRegion() );
+      itk::ImageRegionConstIterator< CoefficientImageType > eit( expected, input->GetLargestPossibleRegion() );
+      for ( it.GoToBegin(), eit.GoToBegin(); !it.IsAtEnd(); ++it, ++eit )
+        {
+        if ( it.Get() != eit.Get() )
+          {
+          std::cerr << name << ", order " << order << ": coefficient " << it.GetIndex() << " is "
+                    << it.Get() << " with " << threads << " threads instead of " << eit.Get()
+                    << std::endl;
+          return false;
+          }
+        }
+      }
+
+    typename InterpolatorType::Pointer interpolator = InterpolatorType::New();
+    interpolator->SetSplineOrder(order);
+    interpolator->SetInputImage(input);
+    itk::ImageRegionConstIteratorWithIndex< TImage > it( input, input->GetLargestPossibleRegion() );
+    for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+      {
+      const double value = interpolator->EvaluateAtIndex( it.GetIndex() );
+      if ( vcl_abs( value - static_cast< double >( it.Get() ) ) > 1e-3 )
+        {
+        std::cerr << name << ", order " << order << ": the interpolation at " << it.GetIndex() << " is "
+                  << value << " instead of " << static_cast< double >( it.Get() ) << std::endl;
+        return false;
+        }
+      }
+    }
+  return true;
+}
+
+// Checks that two interpolators of the same image can share their
+// coefficients.
+bool TestSharedFilter()
+{
+  typedef itk::Image< float, 3 >                                          ImageType;
+  typedef itk::BSplineInterpolateImageFunction< ImageType, double, double > InterpolatorType;
+
+  ImageType::SizeType size;
+  size.Fill(10);
+  ImageType::Pointer input = MakeImage< ImageType >(size);
+
+  InterpolatorType::Pointer interpolator1 = InterpolatorType::New();
+  interpolator1->SetInputImage(input);
+  InterpolatorType::Pointer interpolator2 = InterpolatorType::New();
+  interpolator2->SetCoefficientFilter( interpolator1->GetCoefficientFilter() );
+  const unsigned long updateTime = interpolator1->GetCoefficientFilter()->GetOutput()->GetUpdateMTime();
+  interpolator2->SetInputImage(input);
+
+  if ( interpolator1->GetCoefficientFilter()->GetOutput()->GetUpdateMTime() != updateTime )
+    {
+    std::cerr << "The shared coefficients were computed again" << std::endl;
+    return false;
+    }
+
+  InterpolatorType::ContinuousIndexType index;
+  index.Fill(4.3);
+  if ( interpolator1->EvaluateAtContinuousIndex(index) != interpolator2->EvaluateAtContinuousIndex(index) )
+    {
+    std::cerr << "The interpolators sharing their coefficients give "
+              << interpolator1->EvaluateAtContinuousIndex(index) << " and "
+              << interpolator2->EvaluateAtContinuousIndex(index) << std::endl;
+    return false;
+    }
+  return true;
+}
+}
+
+int itkBSplineDecompositionImageFilterThreadsTest(int argc, char *argv[])
+{
+  unsigned int edgeLength = 32;
+  if ( argc > 1 )
+    {
+    edgeLength = atoi(argv[1]);
+    }
+
+  typedef itk::Image< float, 3 > FloatImageType;
+  typedef itk::Image< short, 2 > ShortImageType;
+
+  FloatImageType::SizeType size3D;
+  size3D[0] = 23;
+  size3D[1] = 17;
+  size3D[2] = 12;
+  FloatImageType::SizeType flatSize3D;
+  flatSize3D[0] = 1;
+  flatSize3D[1] = 19;
+  flatSize3D[2] = 1;
+  ShortImageType::SizeType size2D;
+  size2D[0] = 41;
+  size2D[1] = 36;
+  ShortImageType::SizeType lineSize2D;
+  lineSize2D[0] = 57;
+  lineSize2D[1] = 1;
+
+  if ( !TestImage< FloatImageType >("float 3D", size3D)
+       || !TestImage< FloatImageType >("float 3D, one pixel wide", flatSize3D)
+       || !TestImage< ShortImageType >("short 2D", size2D)
+       || !TestImage< ShortImageType >("short 2D, one pixel wide", lineSize2D)
+       || !TestSharedFilter() )
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Benchmark.
+  FloatImageType::SizeType size;
+  size.Fill(edgeLength);
+  FloatImageType::Pointer input = MakeImage< FloatImageType >(size);
+
+  typedef itk::BSplineInterpolateImageFunction< FloatImageType, double, double > InterpolatorType;
+
+  const itk::ThreadIdType maximumThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+  std::cout << "Computing the cubic B-spline coefficients of a " << edgeLength
+            << "^3 float volume, s:" << std::endl;
+  std::cout << "  threads        time" << std::endl;
+  for ( itk::ThreadIdType threads = 1; threads <= maximumThreads; ++threads )
+    {
+    InterpolatorType::Pointer interpolator = InterpolatorType::New();
+    interpolator->GetCoefficientFilter()->SetNumberOfThreads(threads);
+
+    itk::TimeProbe probe;
+    probe.Start();
+    interpolator->SetInputImage(input);
+    probe.Stop();
+    std::cout << "  " << std::setw(7) << threads << std::setw(12) << probe.GetTotal() << std::endl;
+    }
+
+  return EXIT_SUCCESS;
+}
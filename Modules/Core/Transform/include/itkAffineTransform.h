@@ -304,6 +304,19 @@ protected:
   /** Print contents of an AffineTransform */
   void PrintSelf(std::ostream & s, Indent indent) const;
 
+  /** TransformPoint and ComputeJacobianWithRespectToParameters are the
+   * ones of MatrixOffsetTransformBase for an object of exactly this
+   * class. */
+  virtual bool HasMatrixOffsetTransformPoint() const
+  {
+    return typeid( *this ) == typeid( Self );
+  }
+
+  virtual bool HasMatrixOffsetJacobian() const
+  {
+    return typeid( *this ) == typeid( Self );
+  }
+
 private:
 
   AffineTransform(const Self & other);
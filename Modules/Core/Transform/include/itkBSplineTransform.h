@@ -294,6 +294,13 @@ public:
   virtual void TransformPoint( const InputPointType & inputPoint, OutputPointType & outputPoint,
     WeightsType & weights, ParameterIndexArrayType & indices, bool & inside ) const;
 
+  /** Transform an array of points by a BSpline deformable transformation.
+   * The interpolation weights and the parameter indices are allocated once
+   * for all the points. Subclasses, which may override TransformPoint,
+   * call TransformPoint for each point instead. */
+  virtual void TransformPoints( const InputPointType *inputPoints, OutputPointType *outputPoints,
+    SizeValueType numberOfPoints ) const;
+
   /** Get number of weights. */
   unsigned long GetNumberOfWeights() const
   {
@@ -333,6 +340,14 @@ public:
 
   virtual void ComputeJacobianWithRespectToParameters( const InputPointType &, JacobianType & ) const;
 
+  /** Compute the Jacobians with respect to the parameters at an array of
+   * points. The interpolation weights, the grid sizes and the parameter
+   * offsets of the support region are set up once for all the points.
+   * Subclasses call ComputeJacobianWithRespectToParameters for each point
+   * instead. */
+  virtual void ComputeJacobiansWithRespectToParameters( const InputPointType *points,
+    JacobianType *jacobians, SizeValueType numberOfPoints ) const;
+
   virtual void ComputeJacobianWithRespectToPosition( const InputPointType &, JacobianType & ) const
   {
     itkExceptionMacro( << "ComputeJacobianWithRespectToPosition not yet implemented "
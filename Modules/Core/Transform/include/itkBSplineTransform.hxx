@@ -23,6 +23,8 @@
 #include "itkContinuousIndex.h"
 #include "itkImageRegionIterator.h"
 #include "itkImageRegionConstIteratorWithIndex.h"
+#include <typeinfo>
+#include <vector>
 
 namespace itk
 {
@@ -775,6 +777,32 @@ BSplineTransform<TScalarType, NDimensions, VSplineOrder>
   return outputPoint;
 }
 
+// Transform an array of points
+template <class TScalarType, unsigned int NDimensions, unsigned int VSplineOrder>
+void
+BSplineTransform<TScalarType, NDimensions, VSplineOrder>
+::TransformPoints( const InputPointType *inputPoints, OutputPointType *outputPoints,
+  SizeValueType numberOfPoints ) const
+{
+  if( typeid( *this ) != typeid( Self ) )
+    {
+    Superclass::TransformPoints( inputPoints, outputPoints, numberOfPoints );
+    return;
+    }
+
+  WeightsType             weights( this->m_WeightsFunction->GetNumberOfWeights() );
+  ParameterIndexArrayType indices( this->m_WeightsFunction->GetNumberOfWeights() );
+  OutputPointType         outputPoint;
+  bool                    inside;
+
+  // The output point is computed apart, since the arrays may be the same.
+  for( SizeValueType i = 0; i < numberOfPoints; i++ )
+    {
+    this->TransformPoint( inputPoints[i], outputPoint, weights, indices, inside );
+    outputPoints[i] = outputPoint;
+    }
+}
+
 // Compute the Jacobian in one position
 template <class TScalarType, unsigned int NDimensions, unsigned int VSplineOrder>
 void
@@ -841,6 +869,95 @@ BSplineTransform<TScalarType, NDimensions, VSplineOrder>
     }
 }
 
+// Compute the Jacobians at an array of points
+template <class TScalarType, unsigned int NDimensions, unsigned int VSplineOrder>
+void
+BSplineTransform<TScalarType, NDimensions, VSplineOrder>
+::ComputeJacobiansWithRespectToParameters( const InputPointType *points,
+  JacobianType *jacobians, SizeValueType numberOfPoints ) const
+{
+  if( typeid( *this ) != typeid( Self ) )
+    {
+    Superclass::ComputeJacobiansWithRespectToParameters( points, jacobians, numberOfPoints );
+    return;
+    }
+
+  const NumberOfParametersType numberOfParameters = this->GetNumberOfParameters();
+  const unsigned long          numberOfWeights = this->m_WeightsFunction->GetNumberOfWeights();
+
+  WeightsType weights( numberOfWeights );
+
+  const IndexType startIndex =
+    this->m_CoefficientImages[0]->GetLargestPossibleRegion().GetIndex();
+
+  SizeType cumulativeGridSizes;
+  cumulativeGridSizes[0] = ( this->m_TransformDomainMeshSize[0] + SplineOrder );
+  for( unsigned int d = 1; d < SpaceDimension; d++ )
+    {
+    cumulativeGridSizes[d] = cumulativeGridSizes[d-1] *
+      ( this->m_TransformDomainMeshSize[d] + SplineOrder );
+    }
+
+  // Parameter offset of each node of the support region from its first
+  // node, in the order of ComputeJacobianWithRespectToParameters, i.e. the
+  // order of the weights.
+  std::vector<unsigned long>     supportOffsets( numberOfWeights );
+  typename ImageType::OffsetType supportOffset;
+  supportOffset.Fill( 0 );
+  for( unsigned long counter = 0; counter < numberOfWeights; counter++ )
+    {
+    unsigned long number = supportOffset[0];
+    for( unsigned int d = 1; d < SpaceDimension; d++ )
+      {
+      number += ( supportOffset[d] * cumulativeGridSizes[d-1] );
+      }
+    supportOffsets[counter] = number;
+
+    for( unsigned int d = 0; d < SpaceDimension; d++ )
+      {
+      if( ++supportOffset[d] <= static_cast<OffsetValueType>( SplineOrder ) )
+        {
+        break;
+        }
+      supportOffset[d] = 0;
+      }
+    }
+
+  ContinuousIndexType index;
+  IndexType           supportIndex;
+  for( SizeValueType i = 0; i < numberOfPoints; i++ )
+    {
+    JacobianType & jacobian = jacobians[i];
+    jacobian.SetSize( SpaceDimension, numberOfParameters );
+    jacobian.Fill( 0.0 );
+
+    this->m_CoefficientImages[0]->
+      TransformPhysicalPointToContinuousIndex( points[i], index );
+
+    if( !this->InsideValidRegion( index ) )
+      {
+      continue;
+      }
+
+    this->m_WeightsFunction->Evaluate( index, weights, supportIndex );
+
+    unsigned long firstNumber = supportIndex[0] - startIndex[0];
+    for( unsigned int d = 1; d < SpaceDimension; d++ )
+      {
+      firstNumber += ( ( supportIndex[d] - startIndex[d] ) * cumulativeGridSizes[d-1] );
+      }
+
+    for( unsigned long counter = 0; counter < numberOfWeights; counter++ )
+      {
+      const unsigned long number = firstNumber + supportOffsets[counter];
+      for( unsigned int d = 0; d < SpaceDimension; d++ )
+        {
+        jacobian( d, number ) = weights[counter];
+        }
+      }
+    }
+}
+
 /** Get Jacobian at a point. A very specialized function just for BSplines */
 template <class TScalarType, unsigned int NDimensions, unsigned int VSplineOrder>
 void
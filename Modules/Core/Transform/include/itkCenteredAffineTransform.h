@@ -114,6 +114,14 @@ protected:
 
   /** Destroy an CenteredAffineTransform object */
   virtual ~CenteredAffineTransform();
+
+  /** TransformPoint is the one of MatrixOffsetTransformBase for an object
+   * of exactly this class. */
+  virtual bool HasMatrixOffsetTransformPoint() const
+  {
+    return typeid( *this ) == typeid( Self );
+  }
+
 private:
   CenteredAffineTransform(const Self & other);
   const Self & operator=(const Self &);
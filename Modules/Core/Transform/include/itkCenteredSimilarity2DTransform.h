@@ -172,6 +172,13 @@ protected:
   }
   void PrintSelf(std::ostream & os, Indent indent) const;
 
+  /** TransformPoint is the one of MatrixOffsetTransformBase for an object
+   * of exactly this class. */
+  virtual bool HasMatrixOffsetTransformPoint() const
+  {
+    return typeid( *this ) == typeid( Self );
+  }
+
 private:
   CenteredSimilarity2DTransform(const Self &); // purposely not implemented
   void operator=(const Self &);                // purposely not implemented
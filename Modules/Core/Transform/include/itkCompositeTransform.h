@@ -298,6 +298,14 @@ public:
   */
   virtual OutputPointType TransformPoint( const InputPointType & inputPoint ) const;
 
+  /** Transform an array of points, by applying each sub transform to all
+   * the points in turn, so that each sub transform is looked up and called
+   * once for all the points. Subclasses, which may override TransformPoint,
+   * call TransformPoint for each point instead. */
+  virtual void TransformPoints( const InputPointType *inputPoints,
+                                OutputPointType *outputPoints,
+                                SizeValueType numberOfPoints ) const;
+
   /* Note: why was the 'isInsideTransformRegion' flag used below?
   {
     bool isInside = true;
@@ -335,6 +343,16 @@ public:
    */
   virtual void ComputeJacobianWithRespectToParameters(const InputPointType  & p, JacobianType & j) const;
 
+  /**
+   * Compute the Jacobians with respect to the parameters at an array of
+   * points. The sub transforms and the intermediate Jacobians are looked up
+   * and allocated once for all the points. Subclasses call
+   * ComputeJacobianWithRespectToParameters for each point instead.
+   */
+  virtual void ComputeJacobiansWithRespectToParameters(const InputPointType *points,
+                                                       JacobianType *jacobians,
+                                                       SizeValueType numberOfPoints) const;
+
   virtual void ComputeJacobianWithRespectToPosition(const InputPointType &,
                                                     JacobianType &) const
   {
@@ -20,6 +20,8 @@
 
 #include "itkCompositeTransform.h"
 #include <string.h> // for memcpy on some platforms
+#include <algorithm>
+#include <typeinfo>
 
 namespace itk
 {
@@ -90,6 +92,40 @@ CompositeTransform<TScalar, NDimensions>
   return outputPoint;
 }
 
+/**
+ * Transform points
+ */
+template
+<class TScalar, unsigned int NDimensions>
+void
+CompositeTransform<TScalar, NDimensions>
+::TransformPoints( const InputPointType *inputPoints,
+                   OutputPointType *outputPoints,
+                   SizeValueType numberOfPoints ) const
+{
+  if( typeid( *this ) != typeid( Self ) )
+    {
+    Superclass::TransformPoints( inputPoints, outputPoints, numberOfPoints );
+    return;
+    }
+
+  if( outputPoints != inputPoints )
+    {
+    std::copy( inputPoints, inputPoints + numberOfPoints, outputPoints );
+    }
+
+  typename TransformQueueType::const_iterator it;
+  /* Apply in reverse queue order, in place.  */
+  it = this->m_TransformQueue.end();
+
+  do
+    {
+    it--;
+    (*it)->TransformPoints( outputPoints, outputPoints, numberOfPoints );
+    }
+  while( it != this->m_TransformQueue.begin() );
+}
+
 /**
  * return an inverse transformation
  */
@@ -277,6 +313,88 @@ CompositeTransform<TScalar, NDimensions>
   return;
 }
 
+template
+<class TScalar, unsigned int NDimensions>
+void
+CompositeTransform<TScalar, NDimensions>
+::ComputeJacobiansWithRespectToParameters( const InputPointType *points,
+                                           JacobianType *jacobians,
+                                           SizeValueType numberOfPoints ) const
+{
+  if( typeid( *this ) != typeid( Self ) )
+    {
+    Superclass::ComputeJacobiansWithRespectToParameters( points, jacobians, numberOfPoints );
+    return;
+    }
+
+  /* Same computation as ComputeJacobianWithRespectToParameters, with the
+   * loop over the points inside the loop over the sub transforms. */
+  if( numberOfPoints == 0 )
+    {
+    return;
+    }
+
+  const NumberOfParametersType numberOfLocalParameters =
+    this->GetNumberOfLocalParameters();
+  for( SizeValueType i = 0; i < numberOfPoints; i++ )
+    {
+    jacobians[i].SetSize( NDimensions, numberOfLocalParameters );
+    }
+
+  std::vector<OutputPointType> transformedPoints( points, points + numberOfPoints );
+
+  typename TransformType::JacobianType current_jacobian;
+  JacobianType                         j1;
+  j1.SetSize(NDimensions, NDimensions);
+
+  NumberOfParametersType offset = NumericTraits< NumberOfParametersType >::Zero;
+
+  for( signed long tind = (signed long) this->GetNumberOfTransforms() - 1;
+       tind >= 0; tind-- )
+    {
+    TransformTypePointer transform = this->GetNthTransform( tind );
+
+    const NumberOfParametersType offsetLast = offset;
+    const bool                   optimize = this->GetNthTransformToOptimize( tind );
+
+    if( optimize )
+      {
+      current_jacobian.SetSize(
+        NDimensions, transform->GetNumberOfLocalParameters() );
+      }
+
+    for( SizeValueType i = 0; i < numberOfPoints; i++ )
+      {
+      if( optimize )
+        {
+        transform->ComputeJacobianWithRespectToParameters(
+          transformedPoints[i], current_jacobian );
+
+        jacobians[i].update( current_jacobian, 0, offset );
+        }
+
+      // update every old term by left multiplying dTk / dT{k-1}
+      if( offsetLast > 0 )
+        {
+        JacobianType old_j = jacobians[i].extract(NDimensions, offsetLast, 0, 0);
+
+        transform->ComputeJacobianWithRespectToPosition(transformedPoints[i], j1);
+
+        jacobians[i].update(j1 * old_j, 0, 0);
+        }
+      }
+
+    if( optimize )
+      {
+      offset += transform->GetNumberOfLocalParameters();
+      }
+
+    /* Transform the points so they're ready for next transform's Jacobian */
+    transform->TransformPoints( &transformedPoints[0], &transformedPoints[0],
+                                numberOfPoints );
+    }
+}
+
 template
 <class TScalar, unsigned int NDimensions>
 const typename CompositeTransform<TScalar, NDimensions>::ParametersType
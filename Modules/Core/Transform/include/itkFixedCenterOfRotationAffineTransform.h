@@ -106,6 +106,20 @@ protected:
 
   /** Destroy an FixedCenterOfRotationAffineTransform object   */
   virtual ~FixedCenterOfRotationAffineTransform();
+
+  /** TransformPoint and ComputeJacobianWithRespectToParameters are the
+   * ones of MatrixOffsetTransformBase for an object of exactly this
+   * class. */
+  virtual bool HasMatrixOffsetTransformPoint() const
+  {
+    return typeid( *this ) == typeid( Self );
+  }
+
+  virtual bool HasMatrixOffsetJacobian() const
+  {
+    return typeid( *this ) == typeid( Self );
+  }
+
 private:
   FixedCenterOfRotationAffineTransform(const Self & other);
   const Self & operator=(const Self &);
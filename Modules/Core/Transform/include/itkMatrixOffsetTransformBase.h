@@ -19,6 +19,7 @@
 #define __itkMatrixOffsetTransformBase_h
 
 #include <iostream>
+#include <typeinfo>
 
 #include "itkMatrix.h"
 #include "itkTransform.h"
@@ -100,6 +101,7 @@ public:
   /** Parameters Type   */
   typedef typename Superclass::ParametersType      ParametersType;
   typedef typename Superclass::ParametersValueType ParametersValueType;
+  typedef typename Superclass::NumberOfParametersType NumberOfParametersType;
 
   /** Jacobian Type   */
   typedef typename Superclass::JacobianType JacobianType;
@@ -336,6 +338,14 @@ public:
 
   OutputPointType       TransformPoint(const InputPointType & point) const;
 
+  /** Transform an array of points by the affine transformation, without
+   * a virtual call for each point. This is done only when
+   * HasMatrixOffsetTransformPoint() is true. Otherwise TransformPoint is
+   * called for each point. */
+  virtual void TransformPoints(const InputPointType *inputPoints,
+                               OutputPointType *outputPoints,
+                               SizeValueType numberOfPoints) const;
+
   using Superclass::TransformVector;
   OutputVectorType      TransformVector(const InputVectorType & vector) const;
 
@@ -411,6 +421,14 @@ public:
    */
   virtual void ComputeJacobianWithRespectToParameters(const InputPointType  & x, JacobianType & j) const;
 
+  /** Compute the Jacobians with respect to the parameters at an array of
+   * points, without a virtual call for each point. This is done only when
+   * HasMatrixOffsetJacobian() is true. Otherwise
+   * ComputeJacobianWithRespectToParameters is called for each point. */
+  virtual void ComputeJacobiansWithRespectToParameters(const InputPointType *points,
+                                                       JacobianType *jacobians,
+                                                       SizeValueType numberOfPoints) const;
+
   /** Get the jacobian with respect to position. This simply returns
    * the current Matrix. jac will be resized as needed, but it's
    * more efficient if it's already properly sized. */
@@ -471,6 +489,27 @@ protected:
   /** Print contents of an MatrixOffsetTransformBase */
   void PrintSelf(std::ostream & s, Indent indent) const;
 
+  /** Whether TransformPoint is the one of MatrixOffsetTransformBase, so
+   * that TransformPoints may skip the virtual call for each point. The
+   * subclasses that do not override TransformPoint override this method
+   * to check that the object is of exactly their class: an object of
+   * one of their own subclasses, which may override TransformPoint, is
+   * then transformed point by point. */
+  virtual bool HasMatrixOffsetTransformPoint() const
+  {
+    return typeid( *this ) == typeid( Self );
+  }
+
+  /** Whether ComputeJacobianWithRespectToParameters is the one of
+   * MatrixOffsetTransformBase, so that
+   * ComputeJacobiansWithRespectToParameters may skip the virtual call for
+   * each point. Overridden as HasMatrixOffsetTransformPoint is, by the
+   * subclasses that do not override ComputeJacobianWithRespectToParameters. */
+  virtual bool HasMatrixOffsetJacobian() const
+  {
+    return typeid( *this ) == typeid( Self );
+  }
+
   const InverseMatrixType & GetVarInverseMatrix(void) const
   {
     return m_InverseMatrix;
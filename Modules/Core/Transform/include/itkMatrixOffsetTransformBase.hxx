@@ -185,6 +185,38 @@ MatrixOffsetTransformBase<TScalarType, NInputDimensions, NOutputDimensions>
   return m_Matrix * point + m_Offset;
 }
 
+// Transform an array of points
+template <class TScalarType, unsigned int NInputDimensions,
+          unsigned int NOutputDimensions>
+void
+MatrixOffsetTransformBase<TScalarType, NInputDimensions, NOutputDimensions>
+::TransformPoints(const InputPointType *inputPoints,
+                  OutputPointType *outputPoints,
+                  SizeValueType numberOfPoints) const
+{
+  if( !this->HasMatrixOffsetTransformPoint() )
+    {
+    Superclass::TransformPoints( inputPoints, outputPoints, numberOfPoints );
+    return;
+    }
+
+  // Same operations as m_Matrix * point + m_Offset. The input point is
+  // copied, since the arrays may be the same.
+  for( SizeValueType i = 0; i < numberOfPoints; i++ )
+    {
+    const InputPointType point = inputPoints[i];
+    for( unsigned int r = 0; r < NOutputDimensions; r++ )
+      {
+      TScalarType sum = NumericTraits<TScalarType>::Zero;
+      for( unsigned int c = 0; c < NInputDimensions; c++ )
+        {
+        sum += m_Matrix(r, c) * point[c];
+        }
+      outputPoints[i][r] = sum + m_Offset[r];
+      }
+    }
+}
+
 // Transform a vector
 template <class TScalarType, unsigned int NInputDimensions,
           unsigned int NOutputDimensions>
@@ -651,6 +683,49 @@ MatrixOffsetTransformBase<TScalarType, NInputDimensions, NOutputDimensions>
   return;
 }
 
+// Compute the Jacobians at an array of points
+template <class TScalarType, unsigned int NInputDimensions,
+          unsigned int NOutputDimensions>
+void
+MatrixOffsetTransformBase<TScalarType, NInputDimensions, NOutputDimensions>
+::ComputeJacobiansWithRespectToParameters(const InputPointType *points,
+                                          JacobianType *jacobians,
+                                          SizeValueType numberOfPoints) const
+{
+  if( !this->HasMatrixOffsetJacobian() )
+    {
+    Superclass::ComputeJacobiansWithRespectToParameters( points, jacobians, numberOfPoints );
+    return;
+    }
+
+  // Same operations as ComputeJacobianWithRespectToParameters
+  const NumberOfParametersType numberOfLocalParameters = this->GetNumberOfLocalParameters();
+  const InputPointType &       center = this->GetCenter();
+  for( SizeValueType i = 0; i < numberOfPoints; i++ )
+    {
+    JacobianType & jacobian = jacobians[i];
+    jacobian.SetSize( NOutputDimensions, numberOfLocalParameters );
+    jacobian.Fill(0.0);
+
+    const InputVectorType v = points[i] - center;
+
+    unsigned int blockOffset = 0;
+    for( unsigned int block = 0; block < NInputDimensions; block++ )
+      {
+      for( unsigned int dim = 0; dim < NOutputDimensions; dim++ )
+        {
+        jacobian(block, blockOffset + dim) = v[dim];
+        }
+
+      blockOffset += NInputDimensions;
+      }
+    for( unsigned int dim = 0; dim < NOutputDimensions; dim++ )
+      {
+      jacobian(dim, blockOffset + dim) = 1.0;
+      }
+    }
+}
+
 // Return jacobian with respect to position.
 template <class TScalarType, unsigned int NInputDimensions,
           unsigned int NOutputDimensions>
@@ -264,6 +264,14 @@ protected:
   {
     m_Angle = angle;
   }
+
+  /** TransformPoint is the one of MatrixOffsetTransformBase for an object
+   * of exactly this class. */
+  virtual bool HasMatrixOffsetTransformPoint() const
+  {
+    return typeid( *this ) == typeid( Self );
+  }
+
 private:
   Rigid2DTransform(const Self &); // purposely not implemented
   void operator=(const Self &);   // purposely not implemented
@@ -203,6 +203,19 @@ protected:
    */
   void PrintSelf(std::ostream & os, Indent indent) const;
 
+  /** TransformPoint and ComputeJacobianWithRespectToParameters are the
+   * ones of MatrixOffsetTransformBase for an object of exactly this
+   * class. */
+  virtual bool HasMatrixOffsetTransformPoint() const
+  {
+    return typeid( *this ) == typeid( Self );
+  }
+
+  virtual bool HasMatrixOffsetJacobian() const
+  {
+    return typeid( *this ) == typeid( Self );
+  }
+
 private:
   Rigid3DTransform(const Self &); //purposely not implemented
   void operator=(const Self &);   //purposely not implemented
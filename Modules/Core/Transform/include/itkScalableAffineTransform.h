@@ -160,6 +160,20 @@ protected:
 
   void SetVarScale(const double *scale)
   { for ( int i = 0; i < InputSpaceDimension; i++ ) { m_Scale[i] = scale[i]; } }
+
+  /** TransformPoint and ComputeJacobianWithRespectToParameters are the
+   * ones of MatrixOffsetTransformBase for an object of exactly this
+   * class. */
+  virtual bool HasMatrixOffsetTransformPoint() const
+  {
+    return typeid( *this ) == typeid( Self );
+  }
+
+  virtual bool HasMatrixOffsetJacobian() const
+  {
+    return typeid( *this ) == typeid( Self );
+  }
+
 private:
 
   ScalableAffineTransform(const Self & other);
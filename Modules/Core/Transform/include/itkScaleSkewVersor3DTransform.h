@@ -158,6 +158,13 @@ protected:
 
   void ComputeMatrixParameters(void);
 
+  /** TransformPoint is the one of MatrixOffsetTransformBase for an object
+   * of exactly this class. */
+  virtual bool HasMatrixOffsetTransformPoint() const
+  {
+    return typeid( *this ) == typeid( Self );
+  }
+
 private:
   ScaleSkewVersor3DTransform(const Self &); // purposely not implemented
   void operator=(const Self &);             // purposely not implemented
@@ -138,6 +138,13 @@ protected:
 
   void ComputeMatrixParameters(void);
 
+  /** TransformPoint is the one of MatrixOffsetTransformBase for an object
+   * of exactly this class. */
+  virtual bool HasMatrixOffsetTransformPoint() const
+  {
+    return typeid( *this ) == typeid( Self );
+  }
+
 private:
   ScaleVersor3DTransform(const Self &); // purposely not implemented
   void operator=(const Self &);         // purposely not implemented
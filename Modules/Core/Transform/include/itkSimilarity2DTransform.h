@@ -216,6 +216,14 @@ protected:
   {
     m_Scale = scale;
   }
+
+  /** TransformPoint is the one of MatrixOffsetTransformBase for an object
+   * of exactly this class. */
+  virtual bool HasMatrixOffsetTransformPoint() const
+  {
+    return typeid( *this ) == typeid( Self );
+  }
+
 private:
   Similarity2DTransform(const Self &); // purposely not implemented
   void operator=(const Self &);        // purposely not implemented
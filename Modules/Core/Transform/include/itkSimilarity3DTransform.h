@@ -137,6 +137,13 @@ protected:
   /** Computes the parameters from an input matrix. */
   void ComputeMatrixParameters();
 
+  /** TransformPoint is the one of MatrixOffsetTransformBase for an object
+   * of exactly this class. */
+  virtual bool HasMatrixOffsetTransformPoint() const
+  {
+    return typeid( *this ) == typeid( Self );
+  }
+
 private:
   Similarity3DTransform(const Self &); // purposely not implemented
   void operator=(const Self &);        // purposely not implemented
@@ -195,6 +195,25 @@ public:
    */
   virtual OutputPointType TransformPoint(const InputPointType  &) const = 0;
 
+  /** Method to transform an array of points, e.g. the points of a scanline.
+   * The default implementation calls TransformPoint for each point.
+   * MatrixOffsetTransformBase, ScaleTransform, BSplineTransform,
+   * DisplacementFieldTransform and CompositeTransform override it to do
+   * their per-call set up, and the virtual call, once for all the points,
+   * but only for the classes known to keep their TransformPoint: for
+   * other subclasses, which may override TransformPoint, they call
+   * TransformPoint for each point too. A subclass that overrides
+   * TransformPoints must make it give the results of TransformPoint, and
+   * so must its subclasses. When the input and output spaces have the
+   * same dimension, \c outputPoints may be the same array as
+   * \c inputPoints.
+   * \warning This method must be thread-safe. See, e.g., its use
+   * in ResampleImageFilter and ImageToImageObjectMetric.
+   */
+  virtual void TransformPoints(const InputPointType *inputPoints,
+                               OutputPointType *outputPoints,
+                               SizeValueType numberOfPoints) const;
+
   /**  Method to transform a vector. */
   virtual OutputVectorType  TransformVector(const InputVectorType &) const = 0;
 
@@ -420,6 +439,20 @@ public:
    *  already set. */
   virtual void ComputeJacobianWithRespectToParameters(const InputPointType  & p, JacobianType & jacobian) const = 0;
 
+  /** Compute the Jacobians with respect to the parameters at an array of
+   * points, as ComputeJacobianWithRespectToParameters does at each point.
+   * \c jacobians must hold \c numberOfPoints thread-local Jacobians. The
+   * default implementation calls ComputeJacobianWithRespectToParameters
+   * for each point. MatrixOffsetTransformBase, BSplineTransform,
+   * DisplacementFieldTransform and CompositeTransform override it, under
+   * the same condition as TransformPoints, to do their per-call set up once
+   * for all the points.
+   * \warning This method must be thread-safe. See, e.g., its use
+   * in ImageToImageObjectMetric. */
+  virtual void ComputeJacobiansWithRespectToParameters(const InputPointType *points,
+                                                       JacobianType *jacobians,
+                                                       SizeValueType numberOfPoints) const;
+
   /** This provides the ability to get a local jacobian value
    *  in a dense/local transform, e.g. DisplacementFieldTransform. For such
    *  transforms it would be unclear what parameters would refer to.
@@ -77,6 +77,42 @@ std::string Transform<TScalarType, NInputDimensions, NOutputDimensions>
   return n.str();
 }
 
+/**
+ * TransformPoints
+ */
+template <class TScalarType,
+          unsigned int NInputDimensions,
+          unsigned int NOutputDimensions>
+void
+Transform<TScalarType, NInputDimensions, NOutputDimensions>
+::TransformPoints(const InputPointType *inputPoints,
+                  OutputPointType *outputPoints,
+                  SizeValueType numberOfPoints) const
+{
+  for( SizeValueType i = 0; i < numberOfPoints; i++ )
+    {
+    outputPoints[i] = this->TransformPoint( inputPoints[i] );
+    }
+}
+
+/**
+ * ComputeJacobiansWithRespectToParameters
+ */
+template <class TScalarType,
+          unsigned int NInputDimensions,
+          unsigned int NOutputDimensions>
+void
+Transform<TScalarType, NInputDimensions, NOutputDimensions>
+::ComputeJacobiansWithRespectToParameters(const InputPointType *points,
+                                          JacobianType *jacobians,
+                                          SizeValueType numberOfPoints) const
+{
+  for( SizeValueType i = 0; i < numberOfPoints; i++ )
+    {
+    this->ComputeJacobianWithRespectToParameters( points[i], jacobians[i] );
+    }
+}
+
 #if 0
 /**
  * SetDirectionChange
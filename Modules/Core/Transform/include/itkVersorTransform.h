@@ -157,6 +157,13 @@ protected:
 
   void ComputeMatrixParameters(void);
 
+  /** TransformPoint is the one of MatrixOffsetTransformBase for an object
+   * of exactly this class. */
+  virtual bool HasMatrixOffsetTransformPoint() const
+  {
+    return typeid( *this ) == typeid( Self );
+  }
+
 private:
   /** Copy a VersorTransform object */
   VersorTransform(const Self & other); // Not implemented
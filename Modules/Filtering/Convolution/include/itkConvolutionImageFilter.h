@@ -42,6 +42,24 @@ namespace itk
  * The kernel can optionally be normalized to sum to 1 using
  * NormalizeOn(). Normalization is off by default.
  *
+ * The convolution is computed either in the spatial domain, with a
+ * NeighborhoodOperatorImageFilter, at a cost proportional to the number
+ * of pixels of the kernel for each output pixel, or with Fast Fourier
+ * Transforms, at a cost nearly independent of the kernel size. By
+ * default, the FFT is used for kernels of at least
+ * FFTMinimumKernelSize pixels; SetConvolutionMethod() forces either.
+ * The FFT convolution is computed on blocks of the output, one at a
+ * time: each block is transformed together with the input pixels the
+ * kernel reaches around it, taken from the boundary condition outside
+ * the image, so that only the complex transforms of a block and of the
+ * kernel are held in memory, whatever the size of the image. With
+ * integer output pixel types, the FFT results are truncated like those
+ * of the spatial convolution, after results within rounding errors of
+ * an integer are set to that integer, so that both methods give the
+ * same output, but for normalized results that the spatial
+ * convolution computes just below an integer. The AUTOMATIC method
+ * therefore uses the FFT only for real output pixel types.
+ *
  * \warning This filter ignores the spacing, origin, and orientation
  * of the kernel image and treats them as identical to those in the
  * input image.
@@ -136,6 +154,39 @@ public:
   virtual void SetOutputRegionModeToSame();
   virtual void SetOutputRegionModeToValid();
 
+  typedef enum
+  {
+    AUTOMATIC = 0,
+    SPATIAL,
+    FFT
+  } ConvolutionMethodType;
+
+  /** Sets how the convolution is computed. If set to SPATIAL, the
+   * flipped kernel is applied at each pixel. If set to FFT, the image
+   * and the kernel are multiplied in the Fourier domain. If set to
+   * AUTOMATIC, the FFT is used when the kernel has at least
+   * FFTMinimumKernelSize pixels and the output pixel type is not an
+   * integer type. Default method is AUTOMATIC. */
+  itkSetEnumMacro(ConvolutionMethod, ConvolutionMethodType);
+  itkGetEnumMacro(ConvolutionMethod, ConvolutionMethodType);
+  virtual void SetConvolutionMethodToAutomatic();
+  virtual void SetConvolutionMethodToSpatial();
+  virtual void SetConvolutionMethodToFFT();
+
+  /** Set/get the number of pixels of the kernel from which the
+   * AUTOMATIC convolution method uses the FFT. Default is 64, an 8x8 or
+   * a 4x4x4 kernel, about the size from which the FFT is faster. */
+  itkSetMacro(FFTMinimumKernelSize, SizeValueType);
+  itkGetConstMacro(FFTMinimumKernelSize, SizeValueType);
+
+  /** Set/get the length, in each dimension, of the blocks of the output
+   * computed by each FFT. The transforms are this length plus the
+   * kernel size minus one, rounded up to a size the FFT supports. 0,
+   * the default, chooses blocks of about equal lengths whose transforms
+   * have about 2^22 pixels, or are four times the kernel size. */
+  itkSetMacro(FFTBlockSize, SizeValueType);
+  itkGetConstMacro(FFTBlockSize, SizeValueType);
+
   /** ConvolutionImageFilter needs the entire image kernel, which in
    * general is going to be a different size then the output requested
    * region. As such, this filter needs to provide an implementation
@@ -172,6 +223,10 @@ protected:
   /** Get the valid region of the convolution. */
   OutputRegionType GetValidRegion() const;
 
+  /** Tells whether the convolution is computed with the FFT, according
+   * to the convolution method and the kernel size. */
+  bool GetUseFFT() const;
+
   /** Default superclass implementation ensures that input images
    * occupy same physical space. This is not needed for this filter. */
   virtual void VerifyInputInformation() {};
@@ -184,12 +239,20 @@ private:
   void ComputeConvolution( const TImage *kernelImage,
                            ProgressAccumulator *progress );
 
+  template< class TImage >
+  void ComputeConvolutionWithFFT( const TImage *kernelImage,
+                                  float initialProgress );
+
   bool m_Normalize;
 
   DefaultBoundaryConditionType m_DefaultBoundaryCondition;
   BoundaryConditionPointerType m_BoundaryCondition;
 
   OutputRegionModeType m_OutputRegionMode;
+
+  ConvolutionMethodType m_ConvolutionMethod;
+  SizeValueType         m_FFTMinimumKernelSize;
+  SizeValueType         m_FFTBlockSize;
 };
 }
 
@@ -24,10 +24,17 @@
 #include "itkConstantPadImageFilter.h"
 #include "itkCropImageFilter.h"
 #include "itkFlipImageFilter.h"
+#include "itkHalfHermitianToRealInverseFFTImageFilter.h"
 #include "itkImageBase.h"
 #include "itkImageKernelOperator.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMultiplyImageFilter.h"
 #include "itkNeighborhoodOperatorImageFilter.h"
 #include "itkNormalizeToConstantImageFilter.h"
+#include "itkProgressReporter.h"
+#include "itkRealToHalfHermitianForwardFFTImageFilter.h"
+#include "itkVnlFFTCommon.h"
 
 namespace itk
 {
@@ -38,6 +45,9 @@ ConvolutionImageFilter< TInputImage, TKernelImage, TOutputImage >
   m_Normalize = false;
   m_BoundaryCondition = &m_DefaultBoundaryCondition;
   m_OutputRegionMode = Self::SAME;
+  m_ConvolutionMethod = Self::AUTOMATIC;
+  m_FFTMinimumKernelSize = 64;
+  m_FFTBlockSize = 0;
 }
 
 template< class TInputImage, class TKernelImage, class TOutputImage >
@@ -85,6 +95,12 @@ ConvolutionImageFilter< TInputImage, TKernelImage, TOutputImage >
 ::ComputeConvolution( const TImage * kernelImage,
                       ProgressAccumulator * progress )
 {
+  if ( this->GetUseFFT() )
+    {
+    this->ComputeConvolutionWithFFT( kernelImage, m_Normalize ? 0.1f : 0.0f );
+    return;
+    }
+
   typedef typename TImage::PixelType KernelImagePixelType;
   typedef ImageKernelOperator< KernelImagePixelType, ImageDimension > KernelOperatorType;
   KernelOperatorType kernelOperator;
@@ -196,6 +212,206 @@ ConvolutionImageFilter< TInputImage, TKernelImage, TOutputImage >
     }
 }
 
+template< class TInputImage, class TKernelImage, class TOutputImage >
+template< class TImage >
+void
+ConvolutionImageFilter< TInputImage, TKernelImage, TOutputImage >
+::ComputeConvolutionWithFFT( const TImage * kernelImage,
+                             float initialProgress )
+{
+  typedef typename NumericTraits< InputPixelType >::RealType           RealPixelType;
+  typedef Image< RealPixelType, ImageDimension >                       RealImageType;
+  typedef typename RealImageType::RegionType                           RealRegionType;
+  typedef typename RealImageType::IndexType                            RealIndexType;
+  typedef RealToHalfHermitianForwardFFTImageFilter< RealImageType >    ForwardFFTType;
+  typedef typename ForwardFFTType::OutputImageType                     ComplexImageType;
+  typedef HalfHermitianToRealInverseFFTImageFilter< ComplexImageType, RealImageType >
+                                                                       InverseFFTType;
+  typedef MultiplyImageFilter< ComplexImageType, ComplexImageType, ComplexImageType >
+                                                                       MultiplyType;
+
+  const InputImageType  *input = this->GetInput();
+  OutputImageType       *output = this->GetOutput();
+  const InputRegionType  inputRegion = input->GetLargestPossibleRegion();
+  const OutputRegionType outputRegion = output->GetRequestedRegion();
+
+  const typename TImage::RegionType kernelRegion = kernelImage->GetLargestPossibleRegion();
+  const KernelSizeType              kernelSize = kernelRegion.GetSize();
+  const KernelSizeType              radius = this->GetKernelRadius( kernelImage );
+
+  if ( outputRegion.GetNumberOfPixels() == 0 )
+    {
+    return;
+    }
+
+  // Each output block is computed from a tile of the input extending
+  // kernelSize - 1 pixels further, with a circular convolution of the
+  // size of the FFT: the pixels of the block are those it does not
+  // wrap around for. By default, the blocks have about equal lengths,
+  // and their FFT about 2^22 pixels, or four times the kernel size.
+  const SizeValueType defaultFFTLength = static_cast< SizeValueType >(
+    vcl_floor( vcl_pow( 4194304.0, 1.0 / ImageDimension ) + 0.5 ) );
+  typename RealImageType::SizeType fftSize;
+  OutputSizeType                   blockSize;
+  SizeValueType                    numberOfBlocks = 1;
+  for ( unsigned int i = 0; i < ImageDimension; ++i )
+    {
+    const SizeValueType halo = kernelSize[i] - 1;
+    const SizeValueType outputLength = outputRegion.GetSize(i);
+    SizeValueType       length = m_FFTBlockSize;
+    if ( length == 0 )
+      {
+      const SizeValueType maximumLength = std::max< SizeValueType >( defaultFFTLength, 4 * halo ) - halo;
+      const SizeValueType blocks = ( outputLength + maximumLength - 1 ) / maximumLength;
+      length = ( outputLength + blocks - 1 ) / blocks;
+      }
+    length = std::min< SizeValueType >( length, outputLength );
+    fftSize[i] = length + halo;
+    while ( !VnlFFTCommon::IsDimensionSizeLegal( fftSize[i] ) )
+      {
+      ++fftSize[i];
+      }
+    blockSize[i] = fftSize[i] - halo;
+    numberOfBlocks *= ( outputLength + blockSize[i] - 1 ) / blockSize[i];
+    }
+  RealRegionType fftRegion;
+  fftRegion.SetSize( fftSize );
+
+  ProgressReporter progress( this, 0, numberOfBlocks + 1, 100, initialProgress, 1.0f - initialProgress );
+
+  // Transform the kernel, zero padded to the size of the FFT.
+  typename RealImageType::Pointer paddedKernel = RealImageType::New();
+  paddedKernel->SetRegions( fftRegion );
+  paddedKernel->Allocate();
+  paddedKernel->FillBuffer( NumericTraits< RealPixelType >::ZeroValue() );
+  ImageRegionConstIteratorWithIndex< TImage > kernelIt( kernelImage, kernelRegion );
+  for ( kernelIt.GoToBegin(); !kernelIt.IsAtEnd(); ++kernelIt )
+    {
+    RealIndexType index;
+    for ( unsigned int i = 0; i < ImageDimension; ++i )
+      {
+      index[i] = kernelIt.GetIndex()[i] - kernelRegion.GetIndex(i);
+      }
+    paddedKernel->SetPixel( index, static_cast< RealPixelType >( kernelIt.Get() ) );
+    }
+
+  typename ForwardFFTType::Pointer kernelFFT = ForwardFFTType::New();
+  kernelFFT->SetInput( paddedKernel );
+  kernelFFT->SetNumberOfThreads( this->GetNumberOfThreads() );
+  kernelFFT->Update();
+  typename ComplexImageType::Pointer kernelSpectrum = kernelFFT->GetOutput();
+  kernelSpectrum->DisconnectPipeline();
+  kernelFFT = 0;
+  paddedKernel = 0;
+  progress.CompletedPixel();
+
+  // The pipeline convolving a tile, run again for each block.
+  typename RealImageType::Pointer tile = RealImageType::New();
+  tile->SetRegions( fftRegion );
+  tile->Allocate();
+
+  typename ForwardFFTType::Pointer forwardFFT = ForwardFFTType::New();
+  forwardFFT->SetInput( tile );
+  forwardFFT->SetNumberOfThreads( this->GetNumberOfThreads() );
+
+  typename MultiplyType::Pointer multiply = MultiplyType::New();
+  multiply->SetInput1( forwardFFT->GetOutput() );
+  multiply->SetInput2( kernelSpectrum );
+  multiply->SetNumberOfThreads( this->GetNumberOfThreads() );
+  multiply->InPlaceOn();
+
+  typename InverseFFTType::Pointer inverseFFT = InverseFFTType::New();
+  inverseFFT->SetInput( multiply->GetOutput() );
+  inverseFFT->SetActualXDimensionIsOdd( fftSize[0] % 2 != 0 );
+  inverseFFT->SetNumberOfThreads( this->GetNumberOfThreads() );
+
+  OutputIndexType blockIndex = outputRegion.GetIndex();
+  for ( SizeValueType b = 0; b < numberOfBlocks; ++b )
+    {
+    OutputRegionType block( blockIndex, blockSize );
+    block.Crop( outputRegion );
+
+    // The first pixel of the tile is the lowest one the kernel reaches
+    // from the first pixel of the block, the last one, the highest one
+    // it reaches from its last pixel; the rest of the tile is zero.
+    InputIndexType tileIndex;
+    RealIndexType  tileEnd;
+    for ( unsigned int i = 0; i < ImageDimension; ++i )
+      {
+      tileIndex[i] = blockIndex[i] + static_cast< IndexValueType >( radius[i] )
+                     - static_cast< IndexValueType >( kernelSize[i] - 1 );
+      tileEnd[i] = static_cast< IndexValueType >( block.GetSize(i) + kernelSize[i] - 1 );
+      }
+    ImageRegionIteratorWithIndex< RealImageType > tileIt( tile, fftRegion );
+    for ( tileIt.GoToBegin(); !tileIt.IsAtEnd(); ++tileIt )
+      {
+      const RealIndexType & tilePosition = tileIt.GetIndex();
+      InputIndexType        index;
+      bool                  inTile = true;
+      for ( unsigned int i = 0; i < ImageDimension; ++i )
+        {
+        inTile = inTile && tilePosition[i] < tileEnd[i];
+        index[i] = tileIndex[i] + tilePosition[i];
+        }
+      if ( !inTile )
+        {
+        tileIt.Set( NumericTraits< RealPixelType >::ZeroValue() );
+        }
+      else if ( inputRegion.IsInside( index ) )
+        {
+        tileIt.Set( static_cast< RealPixelType >( input->GetPixel( index ) ) );
+        }
+      else
+        {
+        tileIt.Set( static_cast< RealPixelType >( m_BoundaryCondition->GetPixel( index, input ) ) );
+        }
+      }
+    tile->Modified();
+    inverseFFT->Update();
+
+    // Copy the pixels of the block, which follow the kernelSize - 1
+    // first pixels of the convolved tile.  Integer outputs are truncated,
+    // as by the spatial convolution, once the rounding errors of the
+    // transforms are removed from results that are integers, which would
+    // otherwise be truncated to the integer below.
+    const RealPixelType  integerTolerance = vcl_sqrt( NumericTraits< RealPixelType >::epsilon() );
+    const RealImageType *convolved = inverseFFT->GetOutput();
+    ImageRegionIteratorWithIndex< OutputImageType > outputIt( output, block );
+    for ( outputIt.GoToBegin(); !outputIt.IsAtEnd(); ++outputIt )
+      {
+      RealIndexType index;
+      for ( unsigned int i = 0; i < ImageDimension; ++i )
+        {
+        index[i] = outputIt.GetIndex()[i] - blockIndex[i] + static_cast< IndexValueType >( kernelSize[i] - 1 );
+        }
+      RealPixelType value = convolved->GetPixel( index );
+      if ( NumericTraits< OutputPixelType >::is_integer )
+        {
+        const RealPixelType nearest = vcl_floor( value + 0.5 );
+        if ( vcl_abs(value - nearest) <= integerTolerance * std::max( NumericTraits< RealPixelType >::One,
+                                                                       vcl_abs(nearest) ) )
+          {
+          value = nearest;
+          }
+        }
+      outputIt.Set( static_cast< OutputPixelType >( value ) );
+      }
+
+    // Next block.
+    for ( unsigned int i = 0; i < ImageDimension; ++i )
+      {
+      blockIndex[i] += static_cast< IndexValueType >( blockSize[i] );
+      if ( blockIndex[i] < outputRegion.GetIndex(i) + static_cast< IndexValueType >( outputRegion.GetSize(i) ) )
+        {
+        break;
+        }
+      blockIndex[i] = outputRegion.GetIndex(i);
+      }
+
+    progress.CompletedPixel();
+    }
+}
+
 template< class TInputImage, class TKernelImage, class TOutputImage >
 void
 ConvolutionImageFilter< TInputImage, TKernelImage, TOutputImage >
@@ -314,6 +530,32 @@ ConvolutionImageFilter< TInputImage, TKernelImage, TOutputImage >
   return validRegion;
 }
 
+template< class TInputImage, class TKernelImage, class TOutputImage >
+bool
+ConvolutionImageFilter< TInputImage, TKernelImage, TOutputImage >
+::GetUseFFT() const
+{
+  switch ( m_ConvolutionMethod )
+    {
+    case SPATIAL:
+      return false;
+
+    case FFT:
+      return true;
+
+    default:
+      // Normalized integer results may still differ by one between the
+      // methods, so the output of integer images does not depend on the
+      // kernel size unless the FFT is asked for.
+      if ( NumericTraits< OutputPixelType >::is_integer )
+        {
+        return false;
+        }
+      return this->GetKernelImage()->GetLargestPossibleRegion().GetNumberOfPixels()
+             >= m_FFTMinimumKernelSize;
+    }
+}
+
 template< class TInputImage, class TKernelImage, class TOutputImage >
 void
 ConvolutionImageFilter< TInputImage, TKernelImage, TOutputImage >
@@ -330,6 +572,30 @@ ConvolutionImageFilter< TInputImage, TKernelImage, TOutputImage >
   this->SetOutputRegionMode( Self::VALID );
 }
 
+template< class TInputImage, class TKernelImage, class TOutputImage >
+void
+ConvolutionImageFilter< TInputImage, TKernelImage, TOutputImage >
+::SetConvolutionMethodToAutomatic()
+{
+  this->SetConvolutionMethod( Self::AUTOMATIC );
+}
+
+template< class TInputImage, class TKernelImage, class TOutputImage >
+void
+ConvolutionImageFilter< TInputImage, TKernelImage, TOutputImage >
+::SetConvolutionMethodToSpatial()
+{
+  this->SetConvolutionMethod( Self::SPATIAL );
+}
+
+template< class TInputImage, class TKernelImage, class TOutputImage >
+void
+ConvolutionImageFilter< TInputImage, TKernelImage, TOutputImage >
+::SetConvolutionMethodToFFT()
+{
+  this->SetConvolutionMethod( Self::FFT );
+}
+
 template< class TInputImage, class TKernelImage, class TOutputImage >
 void
 ConvolutionImageFilter< TInputImage, TKernelImage, TOutputImage >
@@ -400,6 +666,28 @@ ConvolutionImageFilter< TInputImage, TKernelImage, TOutputImage >
       break;
     }
   os << std::endl;
+  os << indent << "ConvolutionMethod: ";
+  switch ( m_ConvolutionMethod )
+    {
+    case AUTOMATIC:
+      os << "AUTOMATIC";
+      break;
+
+    case SPATIAL:
+      os << "SPATIAL";
+      break;
+
+    case FFT:
+      os << "FFT";
+      break;
+
+    default:
+      os << "unknown";
+      break;
+    }
+  os << std::endl;
+  os << indent << "FFTMinimumKernelSize: " << m_FFTMinimumKernelSize << std::endl;
+  os << indent << "FFTBlockSize: " << m_FFTBlockSize << std::endl;
 }
 }
 #endif
@@ -0,0 +1,257 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkConstantBoundaryCondition.h"
+#include "itkConvolutionImageFilter.h"
+#include "itkImageRegionIterator.h"
+#include "itkTimeProbe.h"
+#include <iomanip>
+
+// Convolves images with kernels of odd and even sizes, in both output
+// region modes, with and without normalization, with the default and a
+// constant boundary condition, over the whole image and over a smaller
+// requested region, and with blocks smaller than the image, and checks
+// that the FFT gives the same results as the spatial convolution, up to
+// rounding errors for float images and exactly for integer images,
+// unless normalized, as the spatial convolution then computes some
+// integer results just below the integer, which it truncates. It then reports the time taken by both methods to
+// convolve a float volume with cubic kernels from 3 to 65 pixels wide,
+// to choose the kernel size from which the FFT is used. Pass a larger
+// edge length, e.g. 128, to use it as a benchmark.
+
+namespace
+{
+unsigned int random = 1;
+
+template< class TImage >
+typename TImage::Pointer MakeImage(const typename TImage::IndexType & index,
+                                   const typename TImage::SizeType & size, int maximum)
+{
+  typename TImage::Pointer image = TImage::New();
+  typename TImage::RegionType region(index, size);
+  image->SetRegions(region);
+  image->Allocate();
+  itk::ImageRegionIterator< TImage > it(image, region);
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    random = random * 1103515245 + 12345;
+    it.Set( static_cast< typename TImage::PixelType >( ( random >> 8 ) % ( maximum + 1 ) ) );
+    }
+  return image;
+}
+
+template< class TImage >
+typename TImage::Pointer Convolve(TImage *input, TImage *kernel, bool useFFT, bool normalize,
+                                  bool valid, itk::ImageBoundaryCondition< TImage > *boundaryCondition,
+                                  const typename TImage::RegionType *requestedRegion,
+                                  itk::SizeValueType blockSize)
+{
+  typedef itk::ConvolutionImageFilter< TImage > FilterType;
+  typename FilterType::Pointer filter = FilterType::New();
+  filter->SetInput(input);
+  filter->SetKernelImage(kernel);
+  filter->SetNormalize(normalize);
+  if ( useFFT )
+    {
+    filter->SetConvolutionMethodToFFT();
+    }
+  else
+    {
+    filter->SetConvolutionMethodToSpatial();
+    }
+  if ( valid )
+    {
+    filter->SetOutputRegionModeToValid();
+    }
+  if ( boundaryCondition )
+    {
+    filter->SetBoundaryCondition(boundaryCondition);
+    }
+  filter->SetFFTBlockSize(blockSize);
+  filter->UpdateOutputInformation();
+  if ( requestedRegion )
+    {
+    filter->GetOutput()->SetRequestedRegion(*requestedRegion);
+    }
+  else
+    {
+    filter->GetOutput()->SetRequestedRegionToLargestPossibleRegion();
+    }
+  filter->Update();
+  return filter->GetOutput();
+}
+
+template< class TImage >
+bool Compare(const char *name, TImage *input, TImage *kernel, double tolerance,
+             double normalizedTolerance)
+{
+  typedef typename TImage::RegionType RegionType;
+
+  itk::ConstantBoundaryCondition< TImage > constantBoundaryCondition;
+  constantBoundaryCondition.SetConstant(7);
+
+  RegionType subregion = input->GetLargestPossibleRegion();
+  for ( unsigned int i = 0; i < TImage::ImageDimension; ++i )
+    {
+    subregion.SetIndex(i, subregion.GetIndex(i) + 4);
+    subregion.SetSize(i, subregion.GetSize(i) - 9);
+    }
+
+  for ( unsigned int test = 0; test < 12; ++test )
+    {
+    const bool normalize = ( test & 1 ) != 0;
+    const bool valid = ( test & 2 ) != 0;
+    const bool useConstant = test >= 8;
+    const bool useSubregion = test >= 4 && test < 8;
+    itk::ImageBoundaryCondition< TImage > *boundaryCondition = 0;
+    if ( useConstant )
+      {
+      boundaryCondition = &constantBoundaryCondition;
+      }
+    const RegionType *requestedRegion = useSubregion && !valid ? &subregion : 0;
+    // small blocks, so that the image takes several of them
+    const itk::SizeValueType blockSize = test % 3 == 0 ? 0 : 7;
+
+    typename TImage::Pointer expected =
+      Convolve< TImage >(input, kernel, false, normalize, valid, boundaryCondition, requestedRegion, 0);
+    typename TImage::Pointer output =
+      Convolve< TImage >(input, kernel, true, normalize, valid, boundaryCondition, requestedRegion, blockSize);
+
+    const RegionType region = requestedRegion ? *requestedRegion : expected->GetLargestPossibleRegion();
+    if ( output->GetLargestPossibleRegion() != expected->GetLargestPossibleRegion()
+         || !output->GetBufferedRegion().IsInside(region) )
+      {
+      std::cerr << name << ": the FFT output has regions " << output->GetLargestPossibleRegion()
+                << output->GetBufferedRegion() << " instead of " << expected->GetLargestPossibleRegion()
+                << region << std::endl;
+      return false;
+      }
+    itk::ImageRegionConstIterator< TImage > it(output, region);
+    itk::ImageRegionConstIterator< TImage > eit(expected, region);
+    for ( it.GoToBegin(), eit.GoToBegin(); !it.IsAtEnd(); ++it, ++eit )
+      {
+      if ( vcl_abs( static_cast< double >( it.Get() ) - static_cast< double >( eit.Get() ) )
+           > ( normalize ? normalizedTolerance : tolerance ) )
+        {
+        std::cerr << name << " (normalize " << normalize << ", valid " << valid << ", constant boundary "
+                  << useConstant << ", block size " << blockSize << "): pixel " << it.GetIndex() << " is "
+                  << static_cast< double >( it.Get() ) << " with the FFT instead of "
+                  << static_cast< double >( eit.Get() ) << std::endl;
+        return false;
+        }
+      }
+    }
+  return true;
+}
+}
+
+int itkConvolutionImageFilterFFTTest(int argc, char *argv[])
+{
+  unsigned int edgeLength = 32;
+  if ( argc > 1 )
+    {
+    edgeLength = atoi(argv[1]);
+    }
+
+  typedef itk::Image< float, 2 > Float2DImageType;
+  typedef itk::Image< float, 3 > Float3DImageType;
+  typedef itk::Image< short, 2 > ShortImageType;
+
+  Float2DImageType::IndexType index2D;
+  index2D[0] = 3;
+  index2D[1] = -2;
+  Float2DImageType::SizeType size2D;
+  size2D[0] = 45;
+  size2D[1] = 38;
+  Float2DImageType::IndexType kernelIndex2D;
+  kernelIndex2D[0] = -1;
+  kernelIndex2D[1] = 5;
+  Float2DImageType::SizeType oddKernelSize2D;
+  oddKernelSize2D.Fill(5);
+  Float2DImageType::SizeType evenKernelSize2D;
+  evenKernelSize2D[0] = 4;
+  evenKernelSize2D[1] = 7;
+
+  Float3DImageType::IndexType index3D;
+  index3D.Fill(0);
+  Float3DImageType::SizeType size3D;
+  size3D[0] = 20;
+  size3D[1] = 17;
+  size3D[2] = 15;
+  Float3DImageType::SizeType kernelSize3D;
+  kernelSize3D[0] = 6;
+  kernelSize3D[1] = 5;
+  kernelSize3D[2] = 3;
+
+  Float2DImageType::Pointer image2D = MakeImage< Float2DImageType >(index2D, size2D, 1000);
+  Float3DImageType::Pointer image3D = MakeImage< Float3DImageType >(index3D, size3D, 1000);
+  ShortImageType::Pointer   shortImage = MakeImage< ShortImageType >(index2D, size2D, 100);
+
+  if ( !Compare< Float2DImageType >( "float 2D, odd kernel", image2D,
+                                     MakeImage< Float2DImageType >(kernelIndex2D, oddKernelSize2D, 10), 1e-2, 1e-4 )
+       || !Compare< Float2DImageType >( "float 2D, even kernel", image2D,
+                                        MakeImage< Float2DImageType >(kernelIndex2D, evenKernelSize2D, 10), 1e-2, 1e-4 )
+       || !Compare< Float3DImageType >( "float 3D", image3D,
+                                        MakeImage< Float3DImageType >(index3D, kernelSize3D, 10), 1e-1, 1e-3 )
+       || !Compare< ShortImageType >( "short 2D", shortImage,
+                                      MakeImage< ShortImageType >(kernelIndex2D, evenKernelSize2D, 3), 0.0, 1.0 ) )
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Benchmark.
+  Float3DImageType::SizeType size;
+  size.Fill(edgeLength);
+  Float3DImageType::Pointer input = MakeImage< Float3DImageType >(index3D, size, 1000);
+
+  std::cout << "Convolving a " << edgeLength << "^3 float volume, s:" << std::endl;
+  std::cout << "  kernel      spatial         FFT" << std::endl;
+  const unsigned int kernelWidths[] = { 3, 5, 7, 9, 11, 13, 17, 25, 33, 49, 65 };
+  for ( unsigned int k = 0; k < sizeof( kernelWidths ) / sizeof( kernelWidths[0] ); ++k )
+    {
+    Float3DImageType::SizeType kernelSize;
+    kernelSize.Fill(kernelWidths[k]);
+    Float3DImageType::Pointer kernel = MakeImage< Float3DImageType >(index3D, kernelSize, 10);
+
+    std::cout << "  " << std::setw(2) << kernelWidths[k] << "^3";
+    // the spatial convolution of the largest kernels takes too long,
+    // and does not support kernels wider than the image
+    if ( static_cast< double >( kernel->GetLargestPossibleRegion().GetNumberOfPixels() )
+         * input->GetLargestPossibleRegion().GetNumberOfPixels() < 2e8
+         && kernelWidths[k] <= edgeLength )
+      {
+      itk::TimeProbe spatialProbe;
+      spatialProbe.Start();
+      Convolve< Float3DImageType >(input, kernel, false, true, false, 0, 0, 0);
+      spatialProbe.Stop();
+      std::cout << std::setw(12) << spatialProbe.GetTotal();
+      }
+    else
+      {
+      std::cout << std::setw(12) << "-";
+      }
+
+    itk::TimeProbe fftProbe;
+    fftProbe.Start();
+    Convolve< Float3DImageType >(input, kernel, true, true, false, 0, 0, 0);
+    fftProbe.Stop();
+    std::cout << std::setw(12) << fftProbe.GetTotal() << std::endl;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -210,6 +210,14 @@ public:
   virtual OutputPointType TransformPoint( const InputPointType& thisPoint )
   const;
 
+  /**  Method to transform an array of points. Each point is mapped to a
+   * continuous index of the displacement field only once. Subclasses,
+   * which may override TransformPoint, call TransformPoint for each point
+   * instead. */
+  virtual void TransformPoints( const InputPointType *inputPoints,
+                                OutputPointType *outputPoints,
+                                SizeValueType numberOfPoints ) const;
+
   /**  Method to transform a vector. */
   virtual OutputVectorType TransformVector(const InputVectorType &) const
   {
@@ -346,6 +354,16 @@ public:
     j = this->m_IdentityJacobian;
   }
 
+  /**
+   * Compute the jacobians with respect to the parameters at an array of
+   * points. Simply returns identity matrices, without a virtual call for
+   * each point. Subclasses call ComputeJacobianWithRespectToParameters
+   * for each point instead.
+   */
+  virtual void ComputeJacobiansWithRespectToParameters(const InputPointType *points,
+                                                       JacobianType *jacobians,
+                                                       SizeValueType numberOfPoints) const;
+
   /**
    * Compute the jacobian with respect to the position, by point.
    * \c j will be resized as needed.
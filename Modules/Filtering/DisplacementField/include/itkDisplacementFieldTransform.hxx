@@ -24,6 +24,7 @@
 #include "itkImageRegionIteratorWithIndex.h"
 #include "vnl/algo/vnl_symmetric_eigensystem.h"
 #include "vnl/algo/vnl_matrix_inverse.h"
+#include <typeinfo>
 
 namespace itk
 {
@@ -115,6 +116,52 @@ DisplacementFieldTransform<TScalar, NDimensions>
   return outputPoint;
 }
 
+/**
+ * Transform points
+ */
+template <class TScalar, unsigned int NDimensions>
+void
+DisplacementFieldTransform<TScalar, NDimensions>
+::TransformPoints( const InputPointType *inputPoints,
+                   OutputPointType *outputPoints,
+                   SizeValueType numberOfPoints ) const
+{
+  if( typeid( *this ) != typeid( Self ) )
+    {
+    Superclass::TransformPoints( inputPoints, outputPoints, numberOfPoints );
+    return;
+    }
+
+  if( !this->m_DisplacementField )
+    {
+    itkExceptionMacro( "No displacement field is specified." );
+    }
+  if( !this->m_Interpolator )
+    {
+    itkExceptionMacro( "No interpolator is specified." );
+    }
+
+  typename InterpolatorType::ContinuousIndexType cidx;
+  typename InterpolatorType::PointType point;
+
+  for( SizeValueType i = 0; i < numberOfPoints; i++ )
+    {
+    point.CastFrom( inputPoints[i] );
+    outputPoints[i].CastFrom( inputPoints[i] );
+
+    // Same test as IsInsideBuffer( point ), which maps the point to the
+    // same continuous index.
+    this->m_DisplacementField->
+    TransformPhysicalPointToContinuousIndex( point, cidx );
+    if( this->m_Interpolator->IsInsideBuffer( cidx ) )
+      {
+      typename InterpolatorType::OutputType displacement =
+        this->m_Interpolator->EvaluateAtContinuousIndex( cidx );
+      outputPoints[i] += displacement;
+      }
+    }
+}
+
 /**
  * Transform covariant vector
  */
@@ -486,6 +533,25 @@ DisplacementFieldTransform<TScalar, NDimensions>
  * ComputeJacobianWithRespectToParameters methods
  */
 
+template <class TScalar, unsigned int NDimensions>
+void
+DisplacementFieldTransform<TScalar, NDimensions>
+::ComputeJacobiansWithRespectToParameters( const InputPointType *points,
+                                           JacobianType *jacobians,
+                                           SizeValueType numberOfPoints ) const
+{
+  if( typeid( *this ) != typeid( Self ) )
+    {
+    Superclass::ComputeJacobiansWithRespectToParameters( points, jacobians, numberOfPoints );
+    return;
+    }
+
+  for( SizeValueType i = 0; i < numberOfPoints; i++ )
+    {
+    jacobians[i] = this->m_IdentityJacobian;
+    }
+}
+
 template <class TScalar, unsigned int NDimensions>
 void
 DisplacementFieldTransform<TScalar, NDimensions>
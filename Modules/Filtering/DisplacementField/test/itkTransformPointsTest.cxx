@@ -0,0 +1,412 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkAffineTransform.h"
+#include "itkScaleTransform.h"
+#include "itkEuler3DTransform.h"
+#include "itkSimilarity3DTransform.h"
+#include "itkBSplineTransform.h"
+#include "itkDisplacementFieldTransform.h"
+#include "itkCompositeTransform.h"
+#include "itkImageRegionIterator.h"
+#include "itkTimeProbe.h"
+#include <iomanip>
+
+// Maps points, some of them outside the support of the deformable
+// transforms, with affine, scale, rigid, similarity, B-spline,
+// displacement field and composite transforms, and with subclasses of
+// them that override TransformPoint and
+// ComputeJacobianWithRespectToParameters, and checks that TransformPoints,
+// out of place and in place, gives exactly the results of TransformPoint,
+// and ComputeJacobiansWithRespectToParameters exactly the results of
+// ComputeJacobianWithRespectToParameters.
+// It then reports the number of points mapped per second, point by point
+// and in batches, for the points of a volume with the given edge length.
+// Pass a larger edge length, e.g. 128, to use it as a benchmark.
+
+namespace
+{
+const unsigned int Dimension = 3;
+
+typedef itk::Transform< double, Dimension, Dimension > TransformType;
+typedef TransformType::InputPointType                  PointType;
+typedef std::vector< PointType >                       PointArrayType;
+typedef TransformType::JacobianType                    JacobianType;
+typedef std::vector< JacobianType >                    JacobianArrayType;
+
+typedef itk::AffineTransform< double, Dimension >             AffineType;
+typedef itk::ScaleTransform< double, Dimension >              ScaleType;
+typedef itk::Euler3DTransform< double >                       Euler3DType;
+typedef itk::Similarity3DTransform< double >                  Similarity3DType;
+typedef itk::BSplineTransform< double, Dimension, 3 >         BSplineType;
+typedef itk::DisplacementFieldTransform< double, Dimension >  DisplacementFieldTransformType;
+typedef itk::CompositeTransform< double, Dimension >          CompositeType;
+
+unsigned int random = 1;
+
+double Random(double minimum, double maximum)
+{
+  random = random * 1103515245 + 12345;
+  return minimum + ( maximum - minimum ) * ( ( random >> 8 ) % 10000 ) / 10000.0;
+}
+
+void RandomizeParameters(TransformType *transform, double minimum, double maximum)
+{
+  TransformType::ParametersType parameters( transform->GetNumberOfParameters() );
+  for ( unsigned int i = 0; i < parameters.Size(); ++i )
+    {
+    parameters[i] = Random(minimum, maximum);
+    }
+  transform->SetParametersByValue(parameters);
+}
+
+// A transform that shifts the points mapped by TTransform along x, and
+// scales the first element of its Jacobians.
+template< class TTransform >
+class ShiftedTransform:public TTransform
+{
+public:
+  typedef ShiftedTransform           Self;
+  typedef TTransform                 Superclass;
+  typedef itk::SmartPointer< Self >  Pointer;
+
+  itkNewMacro(Self);
+
+  typedef typename Superclass::InputPointType  InputPointType;
+  typedef typename Superclass::OutputPointType OutputPointType;
+  typedef typename Superclass::JacobianType    JacobianType;
+
+  using Superclass::TransformPoint;
+  virtual OutputPointType TransformPoint(const InputPointType & point) const
+  {
+    OutputPointType mapped = Superclass::TransformPoint(point);
+    mapped[0] += 1.0;
+    return mapped;
+  }
+
+  using Superclass::ComputeJacobianWithRespectToParameters;
+  virtual void ComputeJacobianWithRespectToParameters(const InputPointType & point,
+                                                      JacobianType & jacobian) const
+  {
+    Superclass::ComputeJacobianWithRespectToParameters(point, jacobian);
+    jacobian(0, 0) = 2.0 * jacobian(0, 0) + 1.0;
+  }
+};
+
+// The transforms act on [0, 10]^3.
+template< class TAffine >
+TransformType::Pointer MakeAffine()
+{
+  typedef TAffine AffineType;
+  typename AffineType::Pointer affine = AffineType::New();
+  typename AffineType::ParametersType parameters( affine->GetNumberOfParameters() );
+  for ( unsigned int i = 0; i < parameters.Size(); ++i )
+    {
+    parameters[i] = ( i % ( Dimension + 1 ) == 0 ? 1.0 : 0.0 ) + Random(-0.1, 0.1);
+    }
+  affine->SetParameters(parameters);
+  return affine.GetPointer();
+}
+
+template< class TScale >
+TransformType::Pointer MakeScale()
+{
+  typedef TScale ScaleType;
+  typename ScaleType::Pointer scale = ScaleType::New();
+  typename ScaleType::ScaleType      factors;
+  typename ScaleType::InputPointType center;
+  for ( unsigned int d = 0; d < Dimension; ++d )
+    {
+    factors[d] = Random(0.8, 1.2);
+    center[d] = Random(4.0, 6.0);
+    }
+  scale->SetScale(factors);
+  scale->SetCenter(center);
+  return scale.GetPointer();
+}
+
+// Rigid and similarity transforms, with small rotations about the center
+// of [0, 10]^3.
+template< class TRigid >
+TransformType::Pointer MakeRigid()
+{
+  typedef TRigid RigidType;
+  typename RigidType::Pointer rigid = RigidType::New();
+  typename RigidType::InputPointType center;
+  center.Fill(5.0);
+  rigid->SetCenter(center);
+  typename RigidType::ParametersType parameters = rigid->GetParameters();
+  for ( unsigned int i = 0; i < parameters.Size(); ++i )
+    {
+    parameters[i] += Random(-0.2, 0.2);
+    }
+  rigid->SetParameters(parameters);
+  return rigid.GetPointer();
+}
+
+template< class TBSpline >
+TransformType::Pointer MakeBSpline()
+{
+  typedef TBSpline BSplineType;
+  typename BSplineType::Pointer bspline = BSplineType::New();
+  typename BSplineType::OriginType             origin;
+  typename BSplineType::PhysicalDimensionsType dimensions;
+  typename BSplineType::MeshSizeType           meshSize;
+  typename BSplineType::DirectionType          direction;
+  origin.Fill(1.0);
+  dimensions.Fill(8.0);
+  meshSize.Fill(4);
+  direction.SetIdentity();
+  bspline->SetTransformDomainOrigin(origin);
+  bspline->SetTransformDomainPhysicalDimensions(dimensions);
+  bspline->SetTransformDomainMeshSize(meshSize);
+  bspline->SetTransformDomainDirection(direction);
+  RandomizeParameters(bspline, -0.5, 0.5);
+  return bspline.GetPointer();
+}
+
+template< class TDisplacementFieldTransform >
+TransformType::Pointer MakeDisplacementField()
+{
+  typedef TDisplacementFieldTransform                                    DisplacementFieldTransformType;
+  typedef typename DisplacementFieldTransformType::DisplacementFieldType FieldType;
+
+  typename FieldType::Pointer field = FieldType::New();
+  typename FieldType::SizeType size;
+  size.Fill(8);
+  typename FieldType::SpacingType spacing;
+  spacing.Fill(1.0);
+  typename FieldType::PointType origin;
+  origin.Fill(1.5);
+  field->SetRegions(size);
+  field->SetSpacing(spacing);
+  field->SetOrigin(origin);
+  field->Allocate();
+  itk::ImageRegionIterator< FieldType > it( field, field->GetLargestPossibleRegion() );
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    typename FieldType::PixelType displacement;
+    for ( unsigned int d = 0; d < Dimension; ++d )
+      {
+      displacement[d] = Random(-0.5, 0.5);
+      }
+    it.Set(displacement);
+    }
+
+  typename DisplacementFieldTransformType::Pointer transform = DisplacementFieldTransformType::New();
+  transform->SetDisplacementField(field);
+  return transform.GetPointer();
+}
+
+template< class TComposite >
+TransformType::Pointer MakeComposite()
+{
+  typedef TComposite CompositeType;
+  typename CompositeType::Pointer composite = CompositeType::New();
+  composite->AddTransform( MakeAffine< AffineType >() );
+  composite->AddTransform( MakeDisplacementField< DisplacementFieldTransformType >() );
+  composite->SetAllTransformsToOptimizeOn();
+  return composite.GetPointer();
+}
+
+PointArrayType RandomPoints(unsigned int numberOfPoints)
+{
+  PointArrayType points(numberOfPoints);
+  for ( unsigned int i = 0; i < numberOfPoints; ++i )
+    {
+    for ( unsigned int d = 0; d < Dimension; ++d )
+      {
+      points[i][d] = Random(-1.0, 11.0);
+      }
+    }
+  return points;
+}
+
+bool SamePoints(const char *name, const char *what, const PointArrayType & points,
+                const PointArrayType & expected)
+{
+  for ( unsigned int i = 0; i < points.size(); ++i )
+    {
+    for ( unsigned int d = 0; d < Dimension; ++d )
+      {
+      if ( points[i][d] != expected[i][d] )
+        {
+        std::cerr << name << ": point " << i << " mapped " << what << " is " << points[i]
+                  << " instead of " << expected[i] << std::endl;
+        return false;
+        }
+      }
+    }
+  return true;
+}
+
+bool SameJacobians(const char *name, const JacobianArrayType & jacobians,
+                   const JacobianArrayType & expected)
+{
+  for ( unsigned int i = 0; i < jacobians.size(); ++i )
+    {
+    if ( jacobians[i].rows() != expected[i].rows() || jacobians[i].cols() != expected[i].cols() )
+      {
+      std::cerr << name << ": Jacobian " << i << " is " << jacobians[i].rows() << "x"
+                << jacobians[i].cols() << " instead of " << expected[i].rows() << "x"
+                << expected[i].cols() << std::endl;
+      return false;
+      }
+    for ( unsigned int r = 0; r < expected[i].rows(); ++r )
+      {
+      for ( unsigned int c = 0; c < expected[i].cols(); ++c )
+        {
+        if ( jacobians[i](r, c) != expected[i](r, c) )
+          {
+          std::cerr << name << ": Jacobian " << i << " is " << jacobians[i](r, c) << " at ("
+                    << r << ", " << c << ") instead of " << expected[i](r, c) << std::endl;
+          return false;
+          }
+        }
+      }
+    }
+  return true;
+}
+
+bool TestTransform(const char *name, const TransformType *transform)
+{
+  const PointArrayType inputPoints = RandomPoints(1000);
+  const unsigned int   numberOfPoints = inputPoints.size();
+
+  PointArrayType expected(numberOfPoints);
+  for ( unsigned int i = 0; i < numberOfPoints; ++i )
+    {
+    expected[i] = transform->TransformPoint(inputPoints[i]);
+    }
+
+  PointArrayType outputPoints(numberOfPoints);
+  transform->TransformPoints(&inputPoints[0], &outputPoints[0], numberOfPoints);
+  PointArrayType inPlacePoints = inputPoints;
+  transform->TransformPoints(&inPlacePoints[0], &inPlacePoints[0], numberOfPoints);
+  transform->TransformPoints(&inputPoints[0], &outputPoints[0], 0);
+  if ( !SamePoints(name, "out of place", outputPoints, expected)
+       || !SamePoints(name, "in place", inPlacePoints, expected) )
+    {
+    return false;
+    }
+
+  // The Jacobians of fewer points, since those of the B-spline transform
+  // hold all its parameters.
+  const unsigned int numberOfJacobians = 100;
+  JacobianArrayType  expectedJacobians(numberOfJacobians);
+  for ( unsigned int i = 0; i < numberOfJacobians; ++i )
+    {
+    transform->ComputeJacobianWithRespectToParameters(inputPoints[i], expectedJacobians[i]);
+    }
+  JacobianArrayType jacobians(numberOfJacobians);
+  transform->ComputeJacobiansWithRespectToParameters(&inputPoints[0], &jacobians[0], numberOfJacobians);
+  if ( !SameJacobians(name, jacobians, expectedJacobians) )
+    {
+    return false;
+    }
+
+  std::cout << name << ": passed" << std::endl;
+  return true;
+}
+
+void Benchmark(const char *name, const TransformType *transform, unsigned int edgeLength)
+{
+  // The points of a volume spanning the support of the transforms,
+  // mapped one scanline at a time.
+  PointArrayType inputPoints(edgeLength);
+  PointArrayType outputPoints(edgeLength);
+  const double   spacing = 10.0 / edgeLength;
+
+  itk::TimeProbe pointProbe;
+  itk::TimeProbe batchProbe;
+  for ( unsigned int k = 0; k < edgeLength; ++k )
+    {
+    for ( unsigned int j = 0; j < edgeLength; ++j )
+      {
+      for ( unsigned int i = 0; i < edgeLength; ++i )
+        {
+        inputPoints[i][0] = i * spacing;
+        inputPoints[i][1] = j * spacing;
+        inputPoints[i][2] = k * spacing;
+        }
+
+      pointProbe.Start();
+      for ( unsigned int i = 0; i < edgeLength; ++i )
+        {
+        outputPoints[i] = transform->TransformPoint(inputPoints[i]);
+        }
+      pointProbe.Stop();
+
+      batchProbe.Start();
+      transform->TransformPoints(&inputPoints[0], &outputPoints[0], edgeLength);
+      batchProbe.Stop();
+      }
+    }
+
+  const double numberOfPoints = static_cast< double >( edgeLength ) * edgeLength * edgeLength;
+  std::cout << "  " << std::left << std::setw(28) << name << std::right
+            << std::setw(14) << numberOfPoints / pointProbe.GetTotal() / 1.0e6
+            << std::setw(14) << numberOfPoints / batchProbe.GetTotal() / 1.0e6 << std::endl;
+}
+}
+
+int itkTransformPointsTest(int argc, char *argv[])
+{
+  unsigned int edgeLength = 32;
+  if ( argc > 1 )
+    {
+    edgeLength = atoi(argv[1]);
+    }
+
+  const char *names[] = { "affine", "scale", "rigid", "similarity", "B-spline",
+                          "displacement field", "composite",
+                          "shifted affine", "shifted scale", "shifted rigid", "shifted similarity",
+                          "shifted B-spline", "shifted displacement field", "shifted composite" };
+  TransformType::Pointer transforms[] = { MakeAffine< AffineType >(), MakeScale< ScaleType >(),
+                                          MakeRigid< Euler3DType >(),
+                                          MakeRigid< Similarity3DType >(),
+                                          MakeBSpline< BSplineType >(),
+                                          MakeDisplacementField< DisplacementFieldTransformType >(),
+                                          MakeComposite< CompositeType >(),
+                                          MakeAffine< ShiftedTransform< AffineType > >(),
+                                          MakeScale< ShiftedTransform< ScaleType > >(),
+                                          MakeRigid< ShiftedTransform< Euler3DType > >(),
+                                          MakeRigid< ShiftedTransform< Similarity3DType > >(),
+                                          MakeBSpline< ShiftedTransform< BSplineType > >(),
+                                          MakeDisplacementField< ShiftedTransform<
+                                                                   DisplacementFieldTransformType > >(),
+                                          MakeComposite< ShiftedTransform< CompositeType > >() };
+  const unsigned int numberOfTransforms = sizeof( names ) / sizeof( names[0] );
+
+  for ( unsigned int t = 0; t < numberOfTransforms; ++t )
+    {
+    if ( !TestTransform(names[t], transforms[t]) )
+      {
+      return EXIT_FAILURE;
+      }
+    }
+
+  std::cout << "Mapping the points of a " << edgeLength << "^3 volume, million points/s:" << std::endl;
+  std::cout << "  transform                            point         batch" << std::endl;
+  for ( unsigned int t = 0; t < numberOfTransforms; ++t )
+    {
+    Benchmark(names[t], transforms[t], edgeLength);
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -52,6 +52,14 @@ namespace itk
  * Danielsson, Per-Erik.  Euclidean Distance Mapping.  Computer
  * Graphics and Image Processing 14, 227-248 (1980).
  *
+ * When only the distance map is needed, UseMaurerAlgorithm computes it
+ * instead with SignedMaurerDistanceMapImageFilter, which is exact, linear
+ * in the number of pixels and multithreaded, and is much faster on large
+ * images. The Voronoi map and the vector map are then left empty, and
+ * getting them, or updating a pipeline from them, throws an exception.
+ *
+ * \sa SignedMaurerDistanceMapImageFilter
+ *
  * \ingroup ImageFeatureExtraction
  * \ingroup ITKDistanceMap
  */
@@ -160,11 +168,23 @@ public:
   /** Set On/Off whether spacing is used. */
   itkBooleanMacro(UseImageSpacing);
 
+  /** Set whether the distance map is computed with the algorithm of
+   * SignedMaurerDistanceMapImageFilter. Its distances are exact, where
+   * those of the Danielsson algorithm may be slightly larger than the
+   * Euclidean distance. The Voronoi map and the vector map are then not
+   * computed: GetVoronoiMap() and GetVectorDistanceMap() throw an
+   * exception, and so does updating them through a pipeline. Default is
+   * false. */
+  itkSetMacro(UseMaurerAlgorithm, bool);
+  itkGetConstReferenceMacro(UseMaurerAlgorithm, bool);
+  itkBooleanMacro(UseMaurerAlgorithm);
+
   /** Get Voronoi Map
    * This map shows for each pixel what object is closest to it.
    * Each object should be labeled by a number (larger than 0),
    * so the map has a value for each pixel corresponding to the label
-   * of the closest object.  */
+   * of the closest object. Throws an exception when UseMaurerAlgorithm
+   * is set. */
   VoronoiImageType * GetVoronoiMap(void);
 
   /** Get Distance map image.  The distance map is shown as a gray
@@ -177,7 +197,8 @@ public:
    * considered). */
   OutputImageType * GetDistanceMap(void);
 
-  /** Get vector field of distances. */
+  /** Get vector field of distances. Throws an exception when
+   * UseMaurerAlgorithm is set. */
   VectorImageType * GetVectorDistanceMap(void);
 
   /** Standard itk::ProcessObject subclass method. */
@@ -210,12 +231,20 @@ protected:
   /** Compute Danielsson distance map and Voronoi Map. */
   void GenerateData();
 
+  /** Throws an exception when the Voronoi map or the vector map are
+   * updated while UseMaurerAlgorithm is set, as they are not computed. */
+  virtual void EnlargeOutputRequestedRegion(DataObject *output);
+
   /** Prepare data. */
   void PrepareData();
 
   /**  Compute Voronoi Map. */
   void ComputeVoronoiMap();
 
+  /** Compute the distance map with SignedMaurerDistanceMapImageFilter.
+   * Used by GenerateData() when UseMaurerAlgorithm is set. */
+  void ComputeMaurerDistanceMap();
+
   /** Update distance map locally.  Used by GenerateData(). */
   void UpdateLocalDistance(VectorImageType *,
                            const IndexType &,
@@ -228,6 +257,7 @@ private:
   bool m_SquaredDistance;
   bool m_InputIsBinary;
   bool m_UseImageSpacing;
+  bool m_UseMaurerAlgorithm;
 }; // end of DanielssonDistanceMapImageFilter class
 } //end namespace itk
 
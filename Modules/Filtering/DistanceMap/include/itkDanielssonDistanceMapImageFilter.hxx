@@ -23,6 +23,8 @@
 #include "itkDanielssonDistanceMapImageFilter.h"
 #include "itkReflectiveImageRegionConstIterator.h"
 #include "itkImageRegionConstIteratorWithIndex.h"
+#include "itkSignedMaurerDistanceMapImageFilter.h"
+#include "itkProgressAccumulator.h"
 
 namespace itk
 {
@@ -47,6 +49,7 @@ DanielssonDistanceMapImageFilter< TInputImage, TOutputImage, TVoronoiImage >
   m_SquaredDistance     = false;
   m_InputIsBinary       = false;
   m_UseImageSpacing     = true;
+  m_UseMaurerAlgorithm  = false;
 }
 
 template< class TInputImage, class TOutputImage, class TVoronoiImage >
@@ -91,6 +94,10 @@ DanielssonDistanceMapImageFilter< TInputImage, TOutputImage, TVoronoiImage >::Vo
 DanielssonDistanceMapImageFilter< TInputImage, TOutputImage, TVoronoiImage >
 ::GetVoronoiMap(void)
 {
+  if ( m_UseMaurerAlgorithm )
+    {
+    itkExceptionMacro(<< "The Voronoi map is not computed when UseMaurerAlgorithm is set");
+    }
   return dynamic_cast< VoronoiImageType* >(
            this->ProcessObject::GetOutput(1) );
 }
@@ -104,10 +111,31 @@ DanielssonDistanceMapImageFilter< TInputImage, TOutputImage, TVoronoiImage >::Ve
 DanielssonDistanceMapImageFilter< TInputImage, TOutputImage, TVoronoiImage >
 ::GetVectorDistanceMap(void)
 {
+  if ( m_UseMaurerAlgorithm )
+    {
+    itkExceptionMacro(<< "The vector distance map is not computed when UseMaurerAlgorithm is set");
+    }
   return dynamic_cast< VectorImageType * >(
            this->ProcessObject::GetOutput(2) );
 }
 
+/**
+ *  Refuse to update the maps that the Maurer algorithm does not compute
+ */
+template< class TInputImage, class TOutputImage, class TVoronoiImage >
+void
+DanielssonDistanceMapImageFilter< TInputImage, TOutputImage, TVoronoiImage >
+::EnlargeOutputRequestedRegion(DataObject *output)
+{
+  Superclass::EnlargeOutputRequestedRegion(output);
+
+  if ( m_UseMaurerAlgorithm && output != this->ProcessObject::GetOutput(0) )
+    {
+    itkExceptionMacro(<< "The Voronoi map and the vector distance map are not computed when "
+                      << "UseMaurerAlgorithm is set");
+    }
+}
+
 /**
  *  Prepare data for computation
  */
@@ -352,6 +380,15 @@ void
 DanielssonDistanceMapImageFilter< TInputImage, TOutputImage, TVoronoiImage >
 ::GenerateData()
 {
+  if ( m_UseMaurerAlgorithm )
+    {
+    // empty the maps of a previous update, which are not computed
+    this->ProcessObject::GetOutput(1)->Initialize();
+    this->ProcessObject::GetOutput(2)->Initialize();
+    this->ComputeMaurerDistanceMap();
+    return;
+    }
+
   this->PrepareData();
 
   // Specify images and regions.
@@ -441,6 +478,69 @@ DanielssonDistanceMapImageFilter< TInputImage, TOutputImage, TVoronoiImage >
   this->ComputeVoronoiMap();
 } // end GenerateData()
 
+/**
+ *  Compute the distance map with the Maurer algorithm
+ */
+template< class TInputImage, class TOutputImage, class TVoronoiImage >
+void
+DanielssonDistanceMapImageFilter< TInputImage, TOutputImage, TVoronoiImage >
+::ComputeMaurerDistanceMap()
+{
+  itkDebugMacro(<< "ComputeMaurerDistanceMap Start");
+  InputImagePointer inputImage  =
+    dynamic_cast< const InputImageType * >( ProcessObject::GetInput(0) );
+
+  // the distances are signed, and the output pixel type may not be
+  typedef Image< float, InputImageDimension >                                 RealImageType;
+  typedef SignedMaurerDistanceMapImageFilter< InputImageType, RealImageType > MaurerFilterType;
+
+  ProgressAccumulator::Pointer progressAcc = ProgressAccumulator::New();
+  progressAcc->SetMiniPipelineFilter(this);
+
+  typename MaurerFilterType::Pointer maurer = MaurerFilterType::New();
+  maurer->SetInput(inputImage);
+  maurer->SetBackgroundValue( NumericTraits< InputPixelType >::Zero );
+  maurer->SetInsideIsPositive(false);
+  maurer->SetSquaredDistance(m_SquaredDistance);
+  maurer->SetUseImageSpacing(m_UseImageSpacing);
+  maurer->SetNumberOfThreads( this->GetNumberOfThreads() );
+  progressAcc->RegisterInternalFilter(maurer, 1.0f);
+  maurer->GetOutput()->SetRequestedRegion( inputImage->GetRequestedRegion() );
+  maurer->Update();
+
+  OutputImagePointer distanceMap = this->GetDistanceMap();
+
+  distanceMap->SetLargestPossibleRegion(
+    inputImage->GetLargestPossibleRegion() );
+
+  distanceMap->SetBufferedRegion(
+    inputImage->GetBufferedRegion() );
+
+  distanceMap->SetRequestedRegion(
+    inputImage->GetRequestedRegion() );
+
+  distanceMap->Allocate();
+
+  // the objects are inside, at distance zero
+  RegionType region = distanceMap->GetRequestedRegion();
+  ImageRegionConstIterator< RealImageType >   it(maurer->GetOutput(), region);
+  ImageRegionIterator< OutputImageType >      dt(distanceMap,          region);
+  const double maximum = static_cast< double >( NumericTraits< OutputPixelType >::max() );
+  for ( it.GoToBegin(), dt.GoToBegin(); !dt.IsAtEnd(); ++it, ++dt )
+    {
+    const double distance = it.Get();
+    if ( distance <= 0.0 )
+      {
+      dt.Set(NumericTraits< OutputPixelType >::Zero);
+      }
+    else
+      {
+      dt.Set( static_cast< OutputPixelType >( vnl_math_min(distance, maximum) ) );
+      }
+    }
+  itkDebugMacro(<< "ComputeMaurerDistanceMap End");
+}
+
 /**
  *  Print Self
  */
@@ -455,6 +555,7 @@ DanielssonDistanceMapImageFilter< TInputImage, TOutputImage, TVoronoiImage >
   os << indent << "Input Is Binary   : " << m_InputIsBinary << std::endl;
   os << indent << "Use Image Spacing : " << m_UseImageSpacing << std::endl;
   os << indent << "Squared Distance  : " << m_SquaredDistance << std::endl;
+  os << indent << "Use Maurer Algorithm : " << m_UseMaurerAlgorithm << std::endl;
 }
 } // end namespace itk
 
@@ -49,6 +49,16 @@ namespace itk
  *  the itk::DanielssonDistanceImageFilter class except it does not return
  *  the Voronoi map.
  *
+ *  \par Multithreading and streaming
+ *  Each dimension is processed in turn, and the lines along that dimension
+ *  are independent, so they are split among the threads. By default the
+ *  filter computes the exact distances over the whole image, and requires
+ *  the whole input. When MaximumDistance is set to a positive value, the
+ *  distances larger than MaximumDistance are clamped to it, and the filter
+ *  only requires the input within MaximumDistance of the output requested
+ *  region, so that a StreamingImageFilter can process a large image in
+ *  slabs. The clamped distances do not depend on how the image is split.
+ *
  *  Reference:
  *  C. R. Maurer, Jr., R. Qi, and V. Raghavan, "A Linear Time Algorithm
  *  for Computing Exact Euclidean Distance Transforms of Binary Images in
@@ -153,6 +163,16 @@ public:
    */
   itkSetMacro(BackgroundValue, InputPixelType);
   itkGetConstReferenceMacro(BackgroundValue, InputPixelType);
+
+  /**
+   * Set the largest distance that is computed exactly, in physical units
+   * if UseImageSpacing is on and in pixels otherwise. Larger distances are
+   * clamped to it, and the output requested region is only enlarged by
+   * this distance instead of to the whole image. Zero, the default, computes
+   * all the distances.
+   */
+  itkSetMacro(MaximumDistance, double);
+  itkGetConstMacro(MaximumDistance, double);
 protected:
 
   SignedMaurerDistanceMapImageFilter();
@@ -163,6 +183,13 @@ protected:
 
   void GenerateData();
 
+  /** The distances in the output requested region depend on the input
+   * within MaximumDistance of it, or on the whole input if MaximumDistance
+   * is zero. The output requested region is enlarged to that region, so
+   * that the input requested region is the same.
+   * \sa ProcessObject::EnlargeOutputRequestedRegion() */
+  void EnlargeOutputRequestedRegion(DataObject *data);
+
   unsigned int SplitRequestedRegion(unsigned int i, unsigned int num,
     OutputImageRegionType & splitRegion);
 
@@ -174,7 +201,7 @@ private:
   SignedMaurerDistanceMapImageFilter(const Self &); //purposely not implemented
   void operator=(const Self &);                     //purposely not implemented
 
-  void Voronoi(unsigned int, OutputIndexType );
+  void Voronoi(unsigned int, const OutputIndexType &, OutputPixelType *, OutputPixelType *);
   bool Remove(OutputPixelType, OutputPixelType, OutputPixelType,
               OutputPixelType, OutputPixelType, OutputPixelType);
 
@@ -183,6 +210,9 @@ private:
 
   unsigned int m_CurrentDimension;
 
+  double          m_MaximumDistance;
+  OutputPixelType m_MaximumSquaredDistance;
+
   bool m_InsideIsPositive;
   bool m_UseImageSpacing;
   bool m_SquaredDistance;
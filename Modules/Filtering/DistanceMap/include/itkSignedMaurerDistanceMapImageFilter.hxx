@@ -24,8 +24,8 @@
 #include "itkBinaryContourImageFilter.h"
 #include "itkProgressReporter.h"
 #include "itkProgressAccumulator.h"
-#include "vnl/vnl_vector.h"
 #include "vnl/vnl_math.h"
+#include <vector>
 
 namespace itk
 {
@@ -36,13 +36,54 @@ SignedMaurerDistanceMapImageFilter< TInputImage, TOutputImage >
   m_InsideIsPositive(false),
   m_UseImageSpacing(true),
   m_SquaredDistance(false)
-{}
+{
+  m_MaximumDistance = 0.0;
+  m_MaximumSquaredDistance = NumericTraits< OutputPixelType >::max();
+}
 
 template< class TInputImage, class TOutputImage >
 SignedMaurerDistanceMapImageFilter< TInputImage, TOutputImage >
 ::~SignedMaurerDistanceMapImageFilter()
 {}
 
+template< class TInputImage, class TOutputImage >
+void
+SignedMaurerDistanceMapImageFilter< TInputImage, TOutputImage >
+::EnlargeOutputRequestedRegion(DataObject *data)
+{
+  OutputImageType *output = dynamic_cast< OutputImageType * >( data );
+
+  if ( !output )
+    {
+    return;
+    }
+
+  if ( m_MaximumDistance <= 0.0 )
+    {
+    output->SetRequestedRegion( output->GetLargestPossibleRegion() );
+    return;
+    }
+
+  // The nearest boundary pixel of the pixels whose distance is below the
+  // maximum distance is within the maximum distance, and one more pixel
+  // tells whether it is on the boundary.
+  OutputSizeType radius;
+  for ( unsigned int d = 0; d < ImageDimension; d++ )
+    {
+    double pixels = m_MaximumDistance;
+    if ( m_UseImageSpacing )
+      {
+      pixels /= vcl_abs( output->GetSpacing()[d] );
+      }
+    radius[d] = static_cast< OutputSizeValueType >( vcl_ceil(pixels) ) + 1;
+    }
+
+  OutputRegionType region = output->GetRequestedRegion();
+  region.PadByRadius(radius);
+  region.Crop( output->GetLargestPossibleRegion() );
+  output->SetRequestedRegion(region);
+}
+
 template< class TInputImage, class TOutputImage >
 unsigned int
 SignedMaurerDistanceMapImageFilter< TInputImage, TOutputImage >
@@ -115,6 +156,13 @@ SignedMaurerDistanceMapImageFilter< TInputImage, TOutputImage >
   this->AllocateOutputs();
   this->m_Spacing = this->GetOutput()->GetSpacing();
 
+  m_MaximumSquaredDistance = NumericTraits< OutputPixelType >::max();
+  if ( m_MaximumDistance > 0.0 )
+    {
+    m_MaximumSquaredDistance =
+      static_cast< OutputPixelType >( m_MaximumDistance * m_MaximumDistance );
+    }
+
   // store the binary image in an image with a pixel type as small as possible
   // instead of keeping the native input pixel type to avoid using too much
   // memory.
@@ -150,6 +198,7 @@ SignedMaurerDistanceMapImageFilter< TInputImage, TOutputImage >
   borderFilter->SetFullyConnected( true );
   borderFilter->SetNumberOfThreads( nbthreads );
   progressAcc->RegisterInternalFilter( borderFilter, 0.23f );
+  borderFilter->GetOutput()->SetRequestedRegion( this->GetOutput()->GetRequestedRegion() );
   borderFilter->Update();
 
   this->GraftOutput( borderFilter->GetOutput() );
@@ -176,26 +225,10 @@ SignedMaurerDistanceMapImageFilter< TInputImage, TOutputImage >
 ::ThreadedGenerateData(const OutputImageRegionType & outputRegionForThread,
                        ThreadIdType threadId)
 {
-  vnl_vector< unsigned int > k(InputImageDimension - 1);
-
-  InputRegionType region = outputRegionForThread;
-  InputSizeType   size   = region.GetSize();
-  InputIndexType  startIndex = outputRegionForThread.GetIndex();
-
-  // compute the number of rows first, so we can setup a progress reporter
-  std::vector< InputSizeValueType > NumberOfRows;
-
-  for ( unsigned int i = 0; i < InputImageDimension; i++ )
-    {
-    NumberOfRows.push_back(1);
-    for ( unsigned int d = 0; d < InputImageDimension; d++ )
-      {
-      if ( d != i )
-        {
-        NumberOfRows[i] *= size[d];
-        }
-      }
-    }
+  // the lines along the current dimension start on the first slice of
+  // the region along it
+  OutputRegionType lineStarts = outputRegionForThread;
+  lineStarts.SetSize(m_CurrentDimension, 1);
 
   // set the progress reporter. Use a pointer to be able to destroy it before
   // the creation of progress2
@@ -208,44 +241,20 @@ SignedMaurerDistanceMapImageFilter< TInputImage, TOutputImage >
   ProgressReporter *progress =
       new ProgressReporter(this,
                            threadId,
-                           NumberOfRows[m_CurrentDimension],
+                           lineStarts.GetNumberOfPixels(),
                            30,
                            0.33f + static_cast< float >( m_CurrentDimension * progressPerDimension ),
                            progressPerDimension);
 
-  OutputIndexType idx;
-  idx.Fill(0);
-
-  k[0] = 1;
-  unsigned int count = 1;
-
-  for ( unsigned int d = m_CurrentDimension + 2;
-       d < m_CurrentDimension + InputImageDimension;
-       d++ )
-    {
-    k[count] = k[count - 1] * size[d % InputImageDimension];
-    count++;
-    }
-  k.flip();
-
-  InputSizeValueType index;
-  InputSizeValueType tempRow = NumberOfRows[m_CurrentDimension];
+  // the lower envelope of the parabolas of a line, shared by all the lines
+  const OutputSizeValueType nd = outputRegionForThread.GetSize()[m_CurrentDimension];
+  std::vector< OutputPixelType > g(nd);
+  std::vector< OutputPixelType > h(nd);
 
-  for ( InputSizeValueType n = 0; n < tempRow; n++ )
+  ImageRegionConstIteratorWithIndex< OutputImageType > lineIt(this->GetOutput(), lineStarts);
+  for ( lineIt.GoToBegin(); !lineIt.IsAtEnd(); ++lineIt )
     {
-    index = n;
-    count = 0;
-    for ( unsigned int d = m_CurrentDimension + 1;
-         d < m_CurrentDimension + InputImageDimension; d++ )
-      {
-      idx[d % InputImageDimension] =
-        static_cast< OutputIndexValueType >( static_cast< double >( index ) / static_cast< double >( k[count] ) )
-        + static_cast< OutputIndexValueType >( startIndex[d % InputImageDimension] );
-
-      index %= k[count];
-      count++;
-      }
-    this->Voronoi(m_CurrentDimension, idx);
+    this->Voronoi(m_CurrentDimension, lineIt.GetIndex(), &g[0], &h[0]);
     progress->CompletedPixel();
     }
   delete progress;
@@ -310,64 +319,60 @@ SignedMaurerDistanceMapImageFilter< TInputImage, TOutputImage >
 template< class TInputImage, class TOutputImage >
 void
 SignedMaurerDistanceMapImageFilter< TInputImage, TOutputImage >
-::Voronoi(unsigned int d, OutputIndexType idx)
+::Voronoi(unsigned int d, const OutputIndexType & idx, OutputPixelType *g, OutputPixelType *h)
 {
-  OutputImagePointer    output = this->GetOutput();
-  OutputRegionType      oRegion = output->GetRequestedRegion();
-  OutputSizeValueType   nd = oRegion.GetSize()[d];
+  OutputImageType *     output = this->GetOutput();
+  const InputImageType *input = this->GetInput();
 
-  vnl_vector< OutputPixelType > g(nd, 0 );
-  vnl_vector< OutputPixelType > h(nd, 0 );
+  const OutputRegionType & oRegion = output->GetRequestedRegion();
+  const OutputSizeValueType nd = oRegion.GetSize()[d];
 
-  InputImageConstPointer input = this->GetInput();
-  InputRegionType iRegion = input->GetRequestedRegion();
-  InputIndexType startIndex = iRegion.GetIndex();
+  // the positions along the line start from the first pixel of the image,
+  // so that they do not depend on the requested region
+  const OffsetValueType first = oRegion.GetIndex()[d] - output->GetLargestPossibleRegion().GetIndex()[d];
 
-  OutputPixelType di;
+  OutputPixelType *     outputLine = output->GetBufferPointer() + output->ComputeOffset(idx);
+  const InputPixelType *inputLine = input->GetBufferPointer() + input->ComputeOffset(idx);
+  const OffsetValueType outputStride = output->GetOffsetTable()[d];
+  const OffsetValueType inputStride = input->GetOffsetTable()[d];
+
+  const bool            useImageSpacing = this->GetUseImageSpacing();
+  const double          spacing = this->m_Spacing[d];
+  const OutputPixelType maximumSquaredDistance = m_MaximumSquaredDistance;
+  const bool            clamp = m_MaximumDistance > 0.0;
 
   int l = -1;
 
-  for ( unsigned int i = 0; i < nd; i++ )
+  for ( OutputSizeValueType i = 0; i < nd; i++ )
     {
-    idx[d] = i + startIndex[d];
-
-    di = output->GetPixel(idx);
-
-    OutputPixelType iw;
-
-    if ( this->GetUseImageSpacing() )
-      {
-      iw = static_cast< OutputPixelType >( i ) *
-           static_cast< OutputPixelType >( this->m_Spacing[d] );
-      }
-    else
-      {
-      iw  = static_cast< OutputPixelType >( i );
-      }
+    const OutputPixelType di = outputLine[i * outputStride];
 
     if ( di != NumericTraits< OutputPixelType >::max() )
       {
-      if ( l < 1 )
+      OutputPixelType iw;
+
+      if ( useImageSpacing )
         {
-        l++;
-        g(l) = di;
-        h(l) = iw;
+        iw = static_cast< OutputPixelType >( first + i ) *
+             static_cast< OutputPixelType >( spacing );
         }
       else
         {
-        while ( ( l >= 1 )
-                && this->Remove(g(l - 1), g(l), di, h(l - 1), h(l), iw) )
-          {
-          l--;
-          }
-        l++;
-        g(l) = di;
-        h(l) = iw;
+        iw  = static_cast< OutputPixelType >( first + i );
+        }
+
+      while ( ( l >= 1 )
+              && this->Remove(g[l - 1], g[l], di, h[l - 1], h[l], iw) )
+        {
+        l--;
         }
+      l++;
+      g[l] = di;
+      h[l] = iw;
       }
     }
 
-  if ( l == -1 )
+  if ( l == -1 && !clamp )
     {
     return;
     }
@@ -376,55 +381,64 @@ SignedMaurerDistanceMapImageFilter< TInputImage, TOutputImage >
 
   l = 0;
 
-  for ( unsigned int i = 0; i < nd; i++ )
+  for ( OutputSizeValueType i = 0; i < nd; i++ )
     {
-    OutputPixelType iw;
+    OutputPixelType d1 = maximumSquaredDistance;
 
-    if ( this->GetUseImageSpacing() )
+    if ( ns >= 0 )
       {
-      iw = static_cast< OutputPixelType >( i * this->m_Spacing[d] );
-      }
-    else
-      {
-      iw = static_cast< OutputPixelType >( i );
-      }
+      OutputPixelType iw;
 
-    OutputPixelType d1 = vnl_math_abs( g(l) ) + ( h(l) - iw ) * ( h(l) - iw );
+      if ( useImageSpacing )
+        {
+        iw = static_cast< OutputPixelType >( ( first + i ) * spacing );
+        }
+      else
+        {
+        iw = static_cast< OutputPixelType >( first + i );
+        }
 
-    while ( l < ns )
-      {
-      // be sure to compute d2 *only* if l < ns
-      OutputPixelType d2 = vnl_math_abs( g(l + 1) ) + ( h(l + 1) - iw ) * ( h(l + 1) - iw );
-      // then compare d1 and d2
-      if ( d1 <= d2 )
+      d1 = vnl_math_abs( g[l] ) + ( h[l] - iw ) * ( h[l] - iw );
+
+      while ( l < ns )
         {
-        break;
+        // be sure to compute d2 *only* if l < ns
+        OutputPixelType d2 = vnl_math_abs( g[l + 1] ) + ( h[l + 1] - iw ) * ( h[l + 1] - iw );
+        // then compare d1 and d2
+        if ( d1 <= d2 )
+          {
+          break;
+          }
+        l++;
+        d1 = d2;
+        }
+
+      if ( clamp && d1 > maximumSquaredDistance )
+        {
+        d1 = maximumSquaredDistance;
         }
-      l++;
-      d1 = d2;
       }
-    idx[d] = i + startIndex[d];
 
-    if ( this->GetInput()->GetPixel(idx) != this->m_BackgroundValue )
+    if ( inputLine[i * inputStride] != this->m_BackgroundValue )
       {
       if ( this->m_InsideIsPositive )
         {
-        output->SetPixel(idx,  d1);
+        outputLine[i * outputStride] = d1;
         }
       else
         {
-        output->SetPixel(idx, -d1);
+        outputLine[i * outputStride] = -d1;
         }
       }
     else
       {
       if ( this->m_InsideIsPositive )
         {
-        output->SetPixel(idx, -d1);
+        outputLine[i * outputStride] = -d1;
         }
       else
         {
-        output->SetPixel(idx,  d1);
+        outputLine[i * outputStride] = d1;
         }
       }
     }
@@ -466,6 +480,8 @@ SignedMaurerDistanceMapImageFilter< TInputImage, TOutputImage >
      << this->m_UseImageSpacing << std::endl;
   os << indent << "Squared distance: "
      << this->m_SquaredDistance << std::endl;
+  os << indent << "Maximum distance: "
+     << this->m_MaximumDistance << std::endl;
 }
 } // end namespace itk
 
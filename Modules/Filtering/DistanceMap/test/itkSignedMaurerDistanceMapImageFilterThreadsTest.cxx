@@ -0,0 +1,344 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkSignedMaurerDistanceMapImageFilter.h"
+#include "itkDanielssonDistanceMapImageFilter.h"
+#include "itkStreamingImageFilter.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMultiThreader.h"
+#include "itkTimeProbe.h"
+#include <iomanip>
+
+// Computes the signed distance maps of masks made of random balls, with
+// integer and real distances, with and without the image spacing, with
+// several threads, and with a StreamingImageFilter over slabs, with and
+// without a maximum distance, and checks them against the distances to
+// the boundary pixels computed one by one. It also checks the distance
+// map of DanielssonDistanceMapImageFilter when it uses the Maurer
+// algorithm, and that its Voronoi and vector maps can then be neither
+// got nor updated. It then reports the time taken to compute the distance map
+// of a volume with 1 to the default number of threads, and in slabs with
+// a maximum distance. Pass a larger edge length, e.g. 1024, to use it as
+// a benchmark.
+
+namespace
+{
+typedef itk::Image< unsigned char, 3 > MaskType;
+typedef itk::Image< double, 3 >        RealImageType;
+typedef itk::Image< int, 3 >           IntImageType;
+
+// Balls of random centers and radii, which do not touch the border.
+MaskType::Pointer MakeMask(const MaskType::SizeType & size, unsigned int numberOfBalls)
+{
+  MaskType::Pointer  image = MaskType::New();
+  MaskType::IndexType index;
+  index[0] = 3;
+  index[1] = -2;
+  index[2] = 0;
+  MaskType::RegionType region(index, size);
+  image->SetRegions(region);
+  image->Allocate();
+  image->FillBuffer(0);
+
+  unsigned int random = 1;
+  for ( unsigned int ball = 0; ball < numberOfBalls; ++ball )
+    {
+    MaskType::IndexType center;
+    for ( unsigned int d = 0; d < 3; ++d )
+      {
+      random = random * 1103515245 + 12345;
+      center[d] = index[d] + 1 + static_cast< long >( ( random >> 8 ) % ( size[d] - 2 ) );
+      }
+    random = random * 1103515245 + 12345;
+    const long radius = static_cast< long >( ( random >> 8 ) % ( size[0] / 8 + 1 ) );
+
+    itk::ImageRegionIteratorWithIndex< MaskType > it(image, region);
+    for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+      {
+      long distance = 0;
+      bool onBorder = false;
+      for ( unsigned int d = 0; d < 3; ++d )
+        {
+        const long x = it.GetIndex()[d];
+        distance += ( x - center[d] ) * ( x - center[d] );
+        onBorder = onBorder || x == index[d] || x == index[d] + static_cast< long >( size[d] ) - 1;
+        }
+      if ( distance <= radius * radius && !onBorder )
+        {
+        it.Set(1);
+        }
+      }
+    }
+  return image;
+}
+
+// The squared distances to the nearest boundary pixel of the objects,
+// computed one by one.
+std::vector< double > ReferenceDistances(const MaskType *mask, bool useImageSpacing)
+{
+  const MaskType::RegionType region = mask->GetLargestPossibleRegion();
+  std::vector< MaskType::IndexType > boundary;
+  itk::ImageRegionConstIteratorWithIndex< MaskType > it(mask, region);
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    if ( !it.Get() )
+      {
+      continue;
+      }
+    bool onBoundary = false;
+    for ( unsigned int n = 0; n < 27 && !onBoundary; ++n )
+      {
+      MaskType::IndexType neighbor = it.GetIndex();
+      neighbor[0] += static_cast< long >( n % 3 ) - 1;
+      neighbor[1] += static_cast< long >( ( n / 3 ) % 3 ) - 1;
+      neighbor[2] += static_cast< long >( n / 9 ) - 1;
+      onBoundary = region.IsInside(neighbor) && !mask->GetPixel(neighbor);
+      }
+    if ( onBoundary )
+      {
+      boundary.push_back( it.GetIndex() );
+      }
+    }
+
+  std::vector< double > distances;
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    double minimum = itk::NumericTraits< double >::max();
+    for ( unsigned int b = 0; b < boundary.size(); ++b )
+      {
+      double distance = 0.0;
+      for ( unsigned int d = 0; d < 3; ++d )
+        {
+        const double component = ( it.GetIndex()[d] - boundary[b][d] )
+                                 * ( useImageSpacing ? mask->GetSpacing()[d] : 1.0 );
+        distance += component * component;
+        }
+      minimum = std::min(minimum, distance);
+      }
+    distances.push_back(minimum);
+    }
+  return distances;
+}
+
+template< class TOutputImage >
+typename TOutputImage::Pointer Distance(MaskType *mask, bool squared, bool useImageSpacing,
+                                        double maximumDistance, unsigned int numberOfThreads,
+                                        unsigned int numberOfStreamDivisions)
+{
+  typedef itk::SignedMaurerDistanceMapImageFilter< MaskType, TOutputImage > FilterType;
+  typename FilterType::Pointer filter = FilterType::New();
+  filter->SetInput(mask);
+  filter->SetSquaredDistance(squared);
+  filter->SetUseImageSpacing(useImageSpacing);
+  filter->SetMaximumDistance(maximumDistance);
+  filter->SetNumberOfThreads(numberOfThreads);
+  if ( numberOfStreamDivisions == 0 )
+    {
+    filter->Update();
+    return filter->GetOutput();
+    }
+  typedef itk::StreamingImageFilter< TOutputImage, TOutputImage > StreamingType;
+  typename StreamingType::Pointer streaming = StreamingType::New();
+  streaming->SetInput( filter->GetOutput() );
+  streaming->SetNumberOfStreamDivisions(numberOfStreamDivisions);
+  streaming->Update();
+  return streaming->GetOutput();
+}
+
+// Checks a signed distance map, or an unsigned one, against the reference
+// squared distances.
+template< class TOutputImage >
+bool Check(const char *name, const MaskType *mask, const TOutputImage *output,
+           const std::vector< double > & reference, bool squared, bool isSigned,
+           double maximumDistance, double tolerance)
+{
+  itk::ImageRegionConstIteratorWithIndex< MaskType > it( mask, mask->GetLargestPossibleRegion() );
+  itk::ImageRegionConstIterator< TOutputImage >      ot( output, mask->GetLargestPossibleRegion() );
+  unsigned int                                       i = 0;
+  for ( it.GoToBegin(), ot.GoToBegin(); !it.IsAtEnd(); ++it, ++ot, ++i )
+    {
+    double expected = reference[i];
+    if ( maximumDistance > 0.0 )
+      {
+      expected = std::min(expected, maximumDistance * maximumDistance);
+      }
+    if ( !squared )
+      {
+      expected = vcl_sqrt(expected);
+      }
+    if ( it.Get() )
+      {
+      expected = isSigned ? -expected : 0.0;
+      }
+    if ( vcl_abs( static_cast< double >( ot.Get() ) - expected ) > tolerance )
+      {
+      std::cerr << name << ": the distance at " << it.GetIndex() << " is "
+                << static_cast< double >( ot.Get() ) << " instead of " << expected << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+template< class TOutputImage >
+bool TestDistance(const char *name, MaskType *mask, bool squared, bool useImageSpacing, double tolerance)
+{
+  const std::vector< double > reference = ReferenceDistances(mask, useImageSpacing);
+
+  for ( unsigned int threads = 1; threads <= 5; threads += 2 )
+    {
+    if ( !Check< TOutputImage >( name, mask,
+                                 Distance< TOutputImage >(mask, squared, useImageSpacing, 0.0, threads, 0).GetPointer(),
+                                 reference, squared, true, 0.0, tolerance ) )
+      {
+      std::cerr << "  with " << threads << " threads" << std::endl;
+      return false;
+      }
+    }
+
+  const double maximumDistances[] = { 0.0, 3.0, 5.0 };
+  for ( unsigned int m = 0; m < 3; ++m )
+    {
+    for ( unsigned int divisions = 1; divisions <= 5; divisions += 4 )
+      {
+      if ( !Check< TOutputImage >( name, mask,
+                                   Distance< TOutputImage >(mask, squared, useImageSpacing, maximumDistances[m], 2,
+                                                            divisions).GetPointer(),
+                                   reference, squared, true, maximumDistances[m], tolerance ) )
+        {
+        std::cerr << "  with a maximum distance of " << maximumDistances[m] << " in " << divisions
+                  << " slabs" << std::endl;
+        return false;
+        }
+      }
+    }
+  return true;
+}
+
+template< class TOutputImage >
+bool TestDanielsson(const char *name, MaskType *mask, bool squared, bool useImageSpacing, double tolerance)
+{
+  typedef itk::DanielssonDistanceMapImageFilter< MaskType, TOutputImage > FilterType;
+  typename FilterType::Pointer filter = FilterType::New();
+  filter->SetInput(mask);
+  filter->SetSquaredDistance(squared);
+  filter->SetUseImageSpacing(useImageSpacing);
+  filter->SetUseMaurerAlgorithm(true);
+  filter->Update();
+  if ( !Check< TOutputImage >(name, mask, filter->GetDistanceMap(), ReferenceDistances(mask, useImageSpacing),
+                              squared, false, 0.0, tolerance) )
+    {
+    return false;
+    }
+
+  // the Voronoi map, got before the option is set, is not updated
+  typename FilterType::Pointer voronoiFilter = FilterType::New();
+  voronoiFilter->SetInput(mask);
+  typename FilterType::VoronoiImageType::Pointer voronoiMap = voronoiFilter->GetVoronoiMap();
+  voronoiFilter->SetUseMaurerAlgorithm(true);
+  bool updated = true;
+  try
+    {
+    voronoiMap->Update();
+    }
+  catch ( itk::ExceptionObject & )
+    {
+    updated = false;
+    }
+  bool got = true;
+  try
+    {
+    filter->GetVoronoiMap();
+    }
+  catch ( itk::ExceptionObject & )
+    {
+    try
+      {
+      filter->GetVectorDistanceMap();
+      }
+    catch ( itk::ExceptionObject & )
+      {
+      got = false;
+      }
+    }
+  if ( updated || got )
+    {
+    std::cerr << name << ": the Voronoi or the vector map is available with the Maurer algorithm" << std::endl;
+    return false;
+    }
+  return true;
+}
+}
+
+int itkSignedMaurerDistanceMapImageFilterThreadsTest(int argc, char *argv[])
+{
+  unsigned int edgeLength = 32;
+  if ( argc > 1 )
+    {
+    edgeLength = atoi(argv[1]);
+    }
+
+  MaskType::SizeType size;
+  size[0] = 23;
+  size[1] = 19;
+  size[2] = 14;
+  MaskType::Pointer mask = MakeMask(size, 6);
+  MaskType::SpacingType spacing;
+  spacing[0] = 0.8;
+  spacing[1] = 1.0;
+  spacing[2] = 1.7;
+  mask->SetSpacing(spacing);
+
+  typedef itk::Image< unsigned short, 3 > UShortImageType;
+  typedef itk::Image< float, 3 >          FloatImageType;
+
+  if ( !TestDistance< IntImageType >("int, squared", mask, true, false, 0.0)
+       || !TestDistance< RealImageType >("double, with spacing", mask, false, true, 1e-6)
+       || !TestDistance< RealImageType >("double, squared", mask, true, false, 1e-6)
+       || !TestDanielsson< UShortImageType >("Danielsson, unsigned short, squared", mask, true, false, 0.0)
+       || !TestDanielsson< FloatImageType >("Danielsson, float, with spacing", mask, false, true, 1e-4) )
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Benchmark.
+  MaskType::SizeType benchmarkSize;
+  benchmarkSize.Fill(edgeLength);
+  MaskType::Pointer benchmarkMask = MakeMask(benchmarkSize, 20);
+
+  const unsigned int maximumThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+  std::cout << "Computing the distance map of a " << edgeLength << "^3 mask, s:" << std::endl;
+  std::cout << "  threads       whole  8 slabs, maximum distance 10" << std::endl;
+  for ( unsigned int threads = 1; threads <= maximumThreads; ++threads )
+    {
+    itk::TimeProbe probe;
+    probe.Start();
+    Distance< FloatImageType >(benchmarkMask, false, true, 0.0, threads, 0);
+    probe.Stop();
+
+    itk::TimeProbe streamingProbe;
+    streamingProbe.Start();
+    Distance< FloatImageType >(benchmarkMask, false, true, 10.0, threads, 8);
+    streamingProbe.Stop();
+
+    std::cout << "  " << std::setw(7) << threads << std::setw(12) << probe.GetTotal()
+              << std::setw(30) << streamingProbe.GetTotal() << std::endl;
+    }
+
+  return EXIT_SUCCESS;
+}
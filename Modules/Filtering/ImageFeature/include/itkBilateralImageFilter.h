@@ -52,6 +52,34 @@ namespace itk
  * Manduchi (Bilateral Filtering for Gray and ColorImages. IEEE
  * ICCV. 1998.)
  *
+ * The EXACT filtering method, the default, evaluates the domain and
+ * range Gaussians over the whole neighborhood of each pixel, which
+ * takes a time proportional to the volume of the domain kernel. The
+ * BILATERAL_GRID method approximates the filter in a bilateral grid
+ * (Chen, Paris and Durand, Real-time Edge-Aware Image Processing with
+ * the Bilateral Grid. ACM SIGGRAPH. 2007.), whose cells are
+ * GridSamplingFactor times the domain sigma along each direction and
+ * the range sigma along the intensity axis: the pixels and their
+ * weights are accumulated in the grid cells nearest to their positions
+ * and intensities, the grid is blurred with the domain and range
+ * Gaussians, and each output pixel is interpolated in the blurred grid
+ * at its position and intensity. Its time does not depend on the
+ * domain sigma, but its memory is proportional to the number of pixels
+ * divided by the volume of the domain sigma, times the dynamic range of
+ * the image divided by the range sigma. When the grid would take more
+ * than MaximumGridSizeInBytes, its cells are made larger along the
+ * intensity axis, up to the range sigma, and if it still does not fit,
+ * the EXACT method is used instead.
+ *
+ * On noisy piecewise constant images, with the default
+ * GridSamplingFactor of 0.5 and a domain sigma of at least two pixels,
+ * the mean absolute difference between the two methods is below 2% of
+ * the range sigma, and no pixel differs by more than half the range
+ * sigma; a factor of 1 is several times faster, and its mean
+ * difference is below 5% of the range sigma. Most of the difference is
+ * near edges and near the borders of the image, where the grid
+ * replicates its border cells instead of the border pixels.
+ *
  * \sa GaussianOperator
  * \sa RecursiveGaussianImageFilter
  * \sa DiscreteGaussianImageFilter
@@ -124,6 +152,11 @@ public:
   typedef typename KernelType::Iterator      KernelIteratorType;
   typedef typename KernelType::ConstIterator KernelConstIteratorType;
 
+  /** Dimension of the bilateral grid: the image directions and the
+   * intensity. */
+  itkStaticConstMacro(GridDimension, unsigned int,
+                      TOutputImage::ImageDimension + 1);
+
   /** Gaussian image type */
   typedef
   Image< double, itkGetStaticConstMacro(ImageDimension) > GaussianImageType;
@@ -167,6 +200,34 @@ public:
   itkSetMacro(NumberOfRangeGaussianSamples, unsigned long);
   itkGetConstMacro(NumberOfRangeGaussianSamples, unsigned long);
 
+  typedef enum {
+    EXACT = 0,
+    BILATERAL_GRID
+  } FilteringMethodType;
+
+  /** Sets how the filter is computed. If set to EXACT, the domain and
+   * range Gaussians are evaluated over the neighborhood of each pixel.
+   * If set to BILATERAL_GRID, the filter is approximated in a
+   * downsampled bilateral grid. Default method is EXACT. */
+  itkSetEnumMacro(FilteringMethod, FilteringMethodType);
+  itkGetEnumMacro(FilteringMethod, FilteringMethodType);
+  virtual void SetFilteringMethodToExact();
+  virtual void SetFilteringMethodToBilateralGrid();
+
+  /** Set/Get the size of the cells of the bilateral grid, in units of
+   * the domain sigma along each direction, but at least one pixel, and
+   * in units of the range sigma along the intensity axis. Default is
+   * 0.5. */
+  itkSetMacro(GridSamplingFactor, double);
+  itkGetConstMacro(GridSamplingFactor, double);
+
+  /** Set/Get the largest memory, in bytes, that the bilateral grid may
+   * take. Larger grids are coarsened along the intensity axis, to cells
+   * of at most one range sigma, and the EXACT method is used when that
+   * is not enough. Default is 256 MB. */
+  itkSetMacro(MaximumGridSizeInBytes, SizeValueType);
+  itkGetConstMacro(MaximumGridSizeInBytes, SizeValueType);
+
 #ifdef ITK_USE_CONCEPT_CHECKING
   /** Begin concept checking */
   itkConceptMacro( OutputHasNumericTraitsCheck,
@@ -189,6 +250,10 @@ protected:
     m_DomainMu = 2.5;  // keep small to keep kernels small
     m_RangeMu = 4.0;   // can be bigger then DomainMu since we only
                        // index into a single table
+    m_FilteringMethod = EXACT;
+    m_GridSamplingFactor = 0.5;
+    m_MaximumGridSizeInBytes = 256 * 1024 * 1024;
+    m_UseBilateralGrid = false;
   }
 
   virtual ~BilateralImageFilter() {}
@@ -202,6 +267,39 @@ protected:
   void ThreadedGenerateData(const OutputImageRegionType & outputRegionForThread,
                             ThreadIdType threadId);
 
+  /** Release the bilateral grid. */
+  void AfterThreadedGenerateData();
+
+  /** Accumulate the input requested region, whose intensities are
+   * between minimum and maximum, in the bilateral grid and blur it.
+   * Returns false, without allocating the grid, when it does not fit in
+   * MaximumGridSizeInBytes. */
+  bool ComputeBilateralGrid(double minimum, double maximum);
+
+  /** Thread-Data Structure for the bilateral grid, with the blurred axis
+   * and its kernel. */
+  struct BilateralGridThreadStruct
+  {
+    BilateralImageFilter *Filter;
+    unsigned int Axis;
+    std::vector< float > Kernel;
+  };
+
+  /** Accumulate the pixels of the slabs of the grid, along its last
+   * image direction, assigned to threadId. */
+  static ITK_THREAD_RETURN_TYPE AccumulateBilateralGridThreaderCallback(void *arg);
+  void ThreadedAccumulateBilateralGrid(ThreadIdType threadId, ThreadIdType numberOfThreads);
+
+  /** Blur the lines of the grid, along an axis, assigned to threadId. */
+  static ITK_THREAD_RETURN_TYPE BlurBilateralGridThreaderCallback(void *arg);
+  void ThreadedBlurBilateralGrid(const BilateralGridThreadStruct & str, ThreadIdType threadId,
+                                 ThreadIdType numberOfThreads);
+
+  /** Interpolate the output pixels of outputRegionForThread in the
+   * blurred bilateral grid. */
+  void ThreadedGenerateDataWithBilateralGrid(const OutputImageRegionType & outputRegionForThread,
+                                             ThreadIdType threadId);
+
   /** BilateralImageFilter needs a larger input requested region than
    * the output requested region (larger by the size of the domain
    * Gaussian kernel).  As such, BilateralImageFilter needs to provide
@@ -241,6 +339,25 @@ private:
   double                m_DynamicRange;
   double                m_DynamicRangeUsed;
   std::vector< double > m_RangeGaussianTable;
+
+  FilteringMethodType m_FilteringMethod;
+  double              m_GridSamplingFactor;
+  SizeValueType       m_MaximumGridSizeInBytes;
+
+  /** Whether this update uses the bilateral grid. */
+  bool m_UseBilateralGrid;
+
+  /** The bilateral grid, with the sum of the pixels and the sum of
+   * their weights in each cell, the cell sizes in pixels and in
+   * intensity, with the intensity last, and the grid origin. */
+  typedef FixedArray< SizeValueType, itkGetStaticConstMacro(GridDimension) > GridSizeType;
+  typedef FixedArray< double, itkGetStaticConstMacro(GridDimension) >        GridSpacingType;
+  std::vector< float >                 m_Grid;
+  GridSizeType                         m_GridSize;
+  GridSizeType                         m_GridStride;
+  GridSpacingType                      m_GridSpacing;
+  typename TInputImage::IndexType      m_GridIndex;
+  double                               m_GridMinimum;
 };
 } // end namespace itk
 
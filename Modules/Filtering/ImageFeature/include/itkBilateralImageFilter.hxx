@@ -20,6 +20,7 @@
 
 #include "itkBilateralImageFilter.h"
 #include "itkImageRegionIterator.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
 #include "itkGaussianImageSource.h"
 #include "itkNeighborhoodAlgorithm.h"
 #include "itkZeroFluxNeumannBoundaryCondition.h"
@@ -36,6 +37,22 @@ BilateralImageFilter< TInputImage, TOutputImage >
   m_Radius.Fill(i);
 }
 
+template< class TInputImage, class TOutputImage >
+void
+BilateralImageFilter< TInputImage, TOutputImage >
+::SetFilteringMethodToExact()
+{
+  this->SetFilteringMethod(EXACT);
+}
+
+template< class TInputImage, class TOutputImage >
+void
+BilateralImageFilter< TInputImage, TOutputImage >
+::SetFilteringMethodToBilateralGrid()
+{
+  this->SetFilteringMethod(BILATERAL_GRID);
+}
+
 template< class TInputImage, class TOutputImage >
 void
 BilateralImageFilter< TInputImage, TOutputImage >
@@ -227,6 +244,245 @@ BilateralImageFilter< TInputImage, TOutputImage >
     {
     m_RangeGaussianTable[i] = vcl_exp(-0.5 * v * v / rangeVariance) / rangeGaussianDenom;
     }
+
+  m_UseBilateralGrid = m_FilteringMethod == BILATERAL_GRID
+                       && this->ComputeBilateralGrid( static_cast< double >( statistics->GetMinimum() ),
+                                                      static_cast< double >( statistics->GetMaximum() ) );
+}
+
+template< class TInputImage, class TOutputImage >
+void
+BilateralImageFilter< TInputImage, TOutputImage >
+::AfterThreadedGenerateData()
+{
+  std::vector< float >().swap(m_Grid);
+}
+
+template< class TInputImage, class TOutputImage >
+bool
+BilateralImageFilter< TInputImage, TOutputImage >
+::ComputeBilateralGrid(double minimum, double maximum)
+{
+  const InputImageType *                     inputImage = this->GetInput();
+  const typename InputImageType::RegionType  region = inputImage->GetRequestedRegion();
+  const typename InputImageType::SpacingType inputSpacing = inputImage->GetSpacing();
+  const SizeType                             radius = m_GaussianKernel.GetRadius();
+  unsigned int                               d;
+
+  if ( m_GridSamplingFactor <= 0.0 || m_RangeSigma <= 0.0 )
+    {
+    itkExceptionMacro(<< "The GridSamplingFactor and the RangeSigma must be positive");
+    }
+
+  // The cells are centered on every m_GridSpacing pixels from the
+  // region index, and on every m_GridSpacing intensities from the
+  // minimum. The grid has an extra cell along each axis, so that the
+  // pixels can be interpolated between two cells.
+  m_GridIndex = region.GetIndex();
+  m_GridMinimum = minimum;
+  double numberOfImageCells = 1.0;
+  for ( d = 0; d < ImageDimension; d++ )
+    {
+    m_GridSpacing[d] = std::max(1.0, m_GridSamplingFactor * m_DomainSigma[d] / inputSpacing[d]);
+    m_GridSize[d] = Math::Round< SizeValueType >( ( region.GetSize(d) - 1 ) / m_GridSpacing[d] ) + 2;
+    numberOfImageCells *= m_GridSize[d];
+    }
+
+  // coarsen the intensity axis, up to cells of one range sigma, when
+  // the grid does not fit in the memory allowed for it
+  const double cellSize = 2.0 * sizeof( float );
+  const double maximumNumberOfIntensities =
+    vcl_floor(m_MaximumGridSizeInBytes / ( cellSize * numberOfImageCells ) ) - 2.0;
+  m_GridSpacing[ImageDimension] = m_GridSamplingFactor * m_RangeSigma;
+  double numberOfIntensities = vcl_floor( ( maximum - minimum ) / m_GridSpacing[ImageDimension] + 0.5 );
+  if ( numberOfIntensities > maximumNumberOfIntensities )
+    {
+    if ( maximumNumberOfIntensities < 1.0
+         || ( maximum - minimum ) / maximumNumberOfIntensities > m_RangeSigma )
+      {
+      itkDebugMacro(<< "The bilateral grid does not fit in " << m_MaximumGridSizeInBytes
+                    << " bytes, using the exact filter");
+      return false;
+      }
+    m_GridSpacing[ImageDimension] = ( maximum - minimum ) / maximumNumberOfIntensities;
+    numberOfIntensities = maximumNumberOfIntensities;
+    }
+  m_GridSize[ImageDimension] = static_cast< SizeValueType >( numberOfIntensities ) + 2;
+
+  // the intensity varies fastest in the grid
+  SizeValueType numberOfCells = m_GridSize[ImageDimension];
+  m_GridStride[ImageDimension] = 1;
+  for ( d = 0; d < ImageDimension; d++ )
+    {
+    m_GridStride[d] = numberOfCells;
+    numberOfCells *= m_GridSize[d];
+    }
+  m_Grid.assign(2 * numberOfCells, 0.0f);
+
+  BilateralGridThreadStruct str;
+  str.Filter = this;
+  this->GetMultiThreader()->SetNumberOfThreads( this->GetNumberOfThreads() );
+  this->GetMultiThreader()->SetSingleMethod(this->AccumulateBilateralGridThreaderCallback, &str);
+  this->GetMultiThreader()->SingleMethodExecute();
+
+  // blur the grid along each axis with the domain and range Gaussians,
+  // truncated like the exact filter
+  this->GetMultiThreader()->SetSingleMethod(this->BlurBilateralGridThreaderCallback, &str);
+  for ( str.Axis = 0; str.Axis < GridDimension; str.Axis++ )
+    {
+    double       sigma;
+    unsigned int kernelRadius;
+    if ( str.Axis < ImageDimension )
+      {
+      sigma = m_DomainSigma[str.Axis] / ( inputSpacing[str.Axis] * m_GridSpacing[str.Axis] );
+      kernelRadius = static_cast< unsigned int >( vcl_ceil(radius[str.Axis] / m_GridSpacing[str.Axis]) );
+      }
+    else
+      {
+      sigma = m_RangeSigma / m_GridSpacing[str.Axis];
+      kernelRadius = static_cast< unsigned int >( vcl_ceil(m_RangeMu * sigma) );
+      }
+    str.Kernel.resize(2 * kernelRadius + 1);
+    for ( unsigned int k = 0; k < str.Kernel.size(); k++ )
+      {
+      const double x = static_cast< double >( k ) - kernelRadius;
+      str.Kernel[k] = static_cast< float >( vcl_exp(-0.5 * x * x / ( sigma * sigma ) ) );
+      }
+    this->GetMultiThreader()->SingleMethodExecute();
+    }
+  return true;
+}
+
+template< class TInputImage, class TOutputImage >
+ITK_THREAD_RETURN_TYPE
+BilateralImageFilter< TInputImage, TOutputImage >
+::AccumulateBilateralGridThreaderCallback(void *arg)
+{
+  const ThreadIdType threadId = ( (MultiThreader::ThreadInfoStruct *)( arg ) )->ThreadID;
+  const ThreadIdType threadCount = ( (MultiThreader::ThreadInfoStruct *)( arg ) )->NumberOfThreads;
+
+  BilateralGridThreadStruct *str =
+    (BilateralGridThreadStruct *)( ( (MultiThreader::ThreadInfoStruct *)( arg ) )->UserData );
+
+  str->Filter->ThreadedAccumulateBilateralGrid(threadId, threadCount);
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template< class TInputImage, class TOutputImage >
+void
+BilateralImageFilter< TInputImage, TOutputImage >
+::ThreadedAccumulateBilateralGrid(ThreadIdType threadId, ThreadIdType numberOfThreads)
+{
+  // Each thread accumulates the pixels whose nearest cells are in its
+  // slabs of the grid along the last image direction, so that no two
+  // threads write to the same cell.
+  const unsigned int  last = ImageDimension - 1;
+  const SizeValueType firstSlab = m_GridSize[last] * threadId / numberOfThreads;
+  const SizeValueType endSlab = m_GridSize[last] * ( threadId + 1 ) / numberOfThreads;
+
+  typename InputImageType::RegionType region = this->GetInput()->GetRequestedRegion();
+  SizeValueType                       begin = 0;
+  while ( begin < region.GetSize(last)
+          && Math::Round< SizeValueType >( begin / m_GridSpacing[last] ) < firstSlab )
+    {
+    begin++;
+    }
+  SizeValueType end = begin;
+  while ( end < region.GetSize(last)
+          && Math::Round< SizeValueType >( end / m_GridSpacing[last] ) < endSlab )
+    {
+    end++;
+    }
+  if ( begin == end )
+    {
+    return;
+    }
+  region.SetIndex(last, region.GetIndex(last) + begin);
+  region.SetSize(last, end - begin);
+
+  ImageRegionConstIteratorWithIndex< InputImageType > it(this->GetInput(), region);
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    const typename InputImageType::IndexType index = it.GetIndex();
+    const double                             pixel = static_cast< double >( it.Get() );
+    SizeValueType                            cell =
+      Math::Round< SizeValueType >( ( pixel - m_GridMinimum ) / m_GridSpacing[ImageDimension] );
+    for ( unsigned int d = 0; d < ImageDimension; d++ )
+      {
+      cell += Math::Round< SizeValueType >( ( index[d] - m_GridIndex[d] ) / m_GridSpacing[d] ) * m_GridStride[d];
+      }
+    m_Grid[2 * cell] += static_cast< float >( pixel );
+    m_Grid[2 * cell + 1] += 1.0f;
+    }
+}
+
+template< class TInputImage, class TOutputImage >
+ITK_THREAD_RETURN_TYPE
+BilateralImageFilter< TInputImage, TOutputImage >
+::BlurBilateralGridThreaderCallback(void *arg)
+{
+  const ThreadIdType threadId = ( (MultiThreader::ThreadInfoStruct *)( arg ) )->ThreadID;
+  const ThreadIdType threadCount = ( (MultiThreader::ThreadInfoStruct *)( arg ) )->NumberOfThreads;
+
+  BilateralGridThreadStruct *str =
+    (BilateralGridThreadStruct *)( ( (MultiThreader::ThreadInfoStruct *)( arg ) )->UserData );
+
+  str->Filter->ThreadedBlurBilateralGrid(*str, threadId, threadCount);
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template< class TInputImage, class TOutputImage >
+void
+BilateralImageFilter< TInputImage, TOutputImage >
+::ThreadedBlurBilateralGrid(const BilateralGridThreadStruct & str, ThreadIdType threadId,
+                            ThreadIdType numberOfThreads)
+{
+  const std::vector< float > & kernel = str.Kernel;
+  const unsigned int           axis = str.Axis;
+  const unsigned int           kernelRadius = ( kernel.size() - 1 ) / 2;
+  const SizeValueType          length = m_GridSize[axis];
+  const SizeValueType          stride = m_GridStride[axis];
+
+  // each thread blurs its share of the lines along the axis
+  const SizeValueType numberOfLines = m_Grid.size() / ( 2 * length );
+  const SizeValueType firstLine = numberOfLines * threadId / numberOfThreads;
+  const SizeValueType endLine = numberOfLines * ( threadId + 1 ) / numberOfThreads;
+
+  std::vector< float > line(2 * length);
+  for ( SizeValueType l = firstLine; l < endLine; l++ )
+    {
+    float *cells = &m_Grid[2 * ( ( l / stride ) * length * stride + l % stride )];
+    for ( SizeValueType j = 0; j < length; j++ )
+      {
+      line[2 * j] = cells[2 * j * stride];
+      line[2 * j + 1] = cells[2 * j * stride + 1];
+      }
+    for ( SizeValueType j = 0; j < length; j++ )
+      {
+      float sum = 0.0f;
+      float weight = 0.0f;
+      for ( unsigned int k = 0; k < kernel.size(); k++ )
+        {
+        OffsetValueType source = static_cast< OffsetValueType >( j + k ) - kernelRadius;
+        if ( source < 0 || source >= static_cast< OffsetValueType >( length ) )
+          {
+          // replicate the border cells along the image directions,
+          // and ignore the intensities out of the grid
+          if ( axis == ImageDimension )
+            {
+            continue;
+            }
+          source = source < 0 ? 0 : length - 1;
+          }
+        sum += kernel[k] * line[2 * source];
+        weight += kernel[k] * line[2 * source + 1];
+        }
+      cells[2 * j * stride] = sum;
+      cells[2 * j * stride + 1] = weight;
+      }
+    }
 }
 
 template< class TInputImage, class TOutputImage >
@@ -235,6 +491,12 @@ BilateralImageFilter< TInputImage, TOutputImage >
 ::ThreadedGenerateData(const OutputImageRegionType & outputRegionForThread,
                        ThreadIdType threadId)
 {
+  if ( m_UseBilateralGrid )
+    {
+    this->ThreadedGenerateDataWithBilateralGrid(outputRegionForThread, threadId);
+    return;
+    }
+
   typename TInputImage::ConstPointer input = this->GetInput();
   typename TOutputImage::Pointer output = this->GetOutput();
   typename TInputImage::IndexValueType i;
@@ -330,6 +592,66 @@ BilateralImageFilter< TInputImage, TOutputImage >
     }
 }
 
+template< class TInputImage, class TOutputImage >
+void
+BilateralImageFilter< TInputImage, TOutputImage >
+::ThreadedGenerateDataWithBilateralGrid(const OutputImageRegionType & outputRegionForThread,
+                                        ThreadIdType threadId)
+{
+  ImageRegionConstIteratorWithIndex< InputImageType > it(this->GetInput(), outputRegionForThread);
+  ImageRegionIterator< OutputImageType >              o_iter(this->GetOutput(), outputRegionForThread);
+
+  ProgressReporter progress( this, threadId, outputRegionForThread.GetNumberOfPixels() );
+
+  const unsigned int numberOfCorners = 1 << GridDimension;
+  GridSpacingType    fraction;
+  for ( it.GoToBegin(), o_iter.GoToBegin(); !it.IsAtEnd(); ++it, ++o_iter )
+    {
+    const typename InputImageType::IndexType index = it.GetIndex();
+    const double                             pixel = static_cast< double >( it.Get() );
+
+    // find the cell below the pixel position and intensity, and the
+    // position of the pixel in that cell
+    SizeValueType cell = 0;
+    for ( unsigned int d = 0; d < GridDimension; d++ )
+      {
+      const double position = d < ImageDimension
+                              ? ( index[d] - m_GridIndex[d] ) / m_GridSpacing[d]
+                              : ( pixel - m_GridMinimum ) / m_GridSpacing[d];
+      const SizeValueType below =
+        std::min( Math::Floor< SizeValueType >(position), m_GridSize[d] - 2 );
+      fraction[d] = position - below;
+      cell += below * m_GridStride[d];
+      }
+
+    // interpolate linearly between the cells around it
+    double sum = 0.0;
+    double weight = 0.0;
+    for ( unsigned int corner = 0; corner < numberOfCorners; corner++ )
+      {
+      SizeValueType cornerCell = cell;
+      double        cornerWeight = 1.0;
+      for ( unsigned int d = 0; d < GridDimension; d++ )
+        {
+        if ( corner & ( 1 << d ) )
+          {
+          cornerCell += m_GridStride[d];
+          cornerWeight *= fraction[d];
+          }
+        else
+          {
+          cornerWeight *= 1.0 - fraction[d];
+          }
+        }
+      sum += cornerWeight * m_Grid[2 * cornerCell];
+      weight += cornerWeight * m_Grid[2 * cornerCell + 1];
+      }
+
+    o_iter.Set( static_cast< OutputPixelType >( weight > 0.0 ? sum / weight : pixel ) );
+    progress.CompletedPixel();
+    }
+}
+
 template< class TInputImage, class TOutputImage >
 void
 BilateralImageFilter< TInputImage, TOutputImage >
@@ -345,6 +667,9 @@ BilateralImageFilter< TInputImage, TOutputImage >
   os << indent << "Amount of dynamic range used: " << m_DynamicRangeUsed << std::endl;
   os << indent << "AutomaticKernelSize: " << m_AutomaticKernelSize << std::endl;
   os << indent << "Radius: " << m_Radius << std::endl;
+  os << indent << "FilteringMethod: " << m_FilteringMethod << std::endl;
+  os << indent << "GridSamplingFactor: " << m_GridSamplingFactor << std::endl;
+  os << indent << "MaximumGridSizeInBytes: " << m_MaximumGridSizeInBytes << std::endl;
 }
 } // end namespace itk
 
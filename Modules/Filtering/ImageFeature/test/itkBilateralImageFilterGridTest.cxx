@@ -0,0 +1,256 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkBilateralImageFilter.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkTimeProbe.h"
+#include <iomanip>
+
+// Filters noisy piecewise constant images, with edges between regions
+// of different intensities, with the exact filter and with the
+// bilateral grid, with several domain sigmas and with anisotropic
+// spacings, over the whole image and over a smaller requested region,
+// and checks that their mean absolute difference is below 2% of the
+// range sigma, and their largest difference below half the range
+// sigma, as documented, and that the grid gives the same results with
+// several threads. It checks that a grid larger than
+// MaximumGridSizeInBytes is coarsened, with a mean difference below 5%
+// of the range sigma, or replaced by the exact filter. It then reports
+// the time taken by both methods to filter a 16 bit volume with domain
+// sigmas from 2 to 10 pixels. Pass a larger edge length, e.g. 64, to
+// use it as a benchmark.
+
+namespace
+{
+const double RangeSigma = 100.0;
+
+// Spheres of different intensities in a background, with noise.
+template< class TImage >
+typename TImage::Pointer MakeImage(const typename TImage::SizeType & size)
+{
+  typename TImage::Pointer image = TImage::New();
+  typename TImage::IndexType index;
+  index.Fill(-5);
+  typename TImage::RegionType region(index, size);
+  image->SetRegions(region);
+  image->Allocate();
+  unsigned int random = 1;
+  itk::ImageRegionIteratorWithIndex< TImage > it(image, region);
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    double value = 1000.0;
+    for ( unsigned int sphere = 0; sphere < 3; ++sphere )
+      {
+      double distance = 0.0;
+      for ( unsigned int d = 0; d < TImage::ImageDimension; ++d )
+        {
+        const double center = index[d] + size[d] * ( 0.3 + 0.2 * sphere );
+        distance += ( it.GetIndex()[d] - center ) * ( it.GetIndex()[d] - center );
+        }
+      if ( distance < size[0] * size[0] * 0.04 )
+        {
+        value = 1500.0 + 800.0 * sphere;
+        }
+      }
+    double noise = 0.0;
+    for ( unsigned int i = 0; i < 4; ++i )
+      {
+      random = random * 1103515245 + 12345;
+      noise += ( ( random >> 8 ) % 1000 ) / 1000.0 - 0.5;
+      }
+    it.Set( static_cast< typename TImage::PixelType >( value + 60.0 * noise ) );
+    }
+  return image;
+}
+
+template< class TImage >
+typename TImage::Pointer Filter(TImage *input, double domainSigma, bool useGrid,
+                                const typename TImage::RegionType & region,
+                                itk::ThreadIdType numberOfThreads = 1,
+                                itk::SizeValueType maximumGridSize = 256 * 1024 * 1024)
+{
+  typedef itk::BilateralImageFilter< TImage, TImage > FilterType;
+  typename FilterType::Pointer filter = FilterType::New();
+  filter->SetInput(input);
+  filter->SetDomainSigma(domainSigma);
+  filter->SetRangeSigma(RangeSigma);
+  filter->SetNumberOfThreads(numberOfThreads);
+  filter->SetMaximumGridSizeInBytes(maximumGridSize);
+  if ( useGrid )
+    {
+    filter->SetFilteringMethodToBilateralGrid();
+    }
+  else
+    {
+    filter->SetFilteringMethodToExact();
+    }
+  filter->GetOutput()->SetRequestedRegion(region);
+  filter->Update();
+  return filter->GetOutput();
+}
+
+// Returns the mean absolute difference, and the largest one in maximum.
+template< class TImage >
+double Difference(const TImage *image1, const TImage *image2,
+                  const typename TImage::RegionType & region, double & maximum)
+{
+  itk::ImageRegionConstIterator< TImage > it1(image1, region);
+  itk::ImageRegionConstIterator< TImage > it2(image2, region);
+  double                                  sum = 0.0;
+  maximum = 0.0;
+  for ( it1.GoToBegin(), it2.GoToBegin(); !it1.IsAtEnd(); ++it1, ++it2 )
+    {
+    const double difference = vcl_abs( static_cast< double >( it1.Get() ) - static_cast< double >( it2.Get() ) );
+    sum += difference;
+    maximum = std::max(maximum, difference);
+    }
+  return sum / region.GetNumberOfPixels();
+}
+
+template< class TImage >
+bool Compare(const char *name, TImage *input, double domainSigma,
+             const typename TImage::RegionType & region)
+{
+  double                   maximum;
+  typename TImage::Pointer output = Filter< TImage >(input, domainSigma, true, region);
+  const double             mean = Difference< TImage >( output.GetPointer(),
+                                                        Filter< TImage >(input, domainSigma, false, region).GetPointer(),
+                                                        region, maximum );
+  std::cout << name << ", domain sigma " << domainSigma << ": mean difference " << mean
+            << ", largest difference " << maximum << std::endl;
+  if ( mean > 0.02 * RangeSigma || maximum > 0.5 * RangeSigma )
+    {
+    std::cerr << name << ", domain sigma " << domainSigma
+              << ": the bilateral grid is too far from the exact filter" << std::endl;
+    return false;
+    }
+  Difference< TImage >( output.GetPointer(),
+                        Filter< TImage >(input, domainSigma, true, region, 3).GetPointer(), region, maximum );
+  if ( maximum != 0.0 )
+    {
+    std::cerr << name << ", domain sigma " << domainSigma
+              << ": the bilateral grid differs with three threads" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+// Filters with the grid limited to maximumGridSize bytes, and returns
+// the mean absolute difference with the exact filter.
+template< class TImage >
+double LimitedGridDifference(TImage *input, itk::SizeValueType maximumGridSize)
+{
+  const typename TImage::RegionType region = input->GetLargestPossibleRegion();
+  double                            maximum;
+  return Difference< TImage >( Filter< TImage >(input, 2.0, true, region, 2, maximumGridSize).GetPointer(),
+                               Filter< TImage >(input, 2.0, false, region).GetPointer(),
+                               region, maximum );
+}
+}
+
+int itkBilateralImageFilterGridTest(int argc, char *argv[])
+{
+  unsigned int edgeLength = 20;
+  if ( argc > 1 )
+    {
+    edgeLength = atoi(argv[1]);
+    }
+
+  typedef itk::Image< unsigned short, 3 > UShortImageType;
+  typedef itk::Image< float, 2 >          FloatImageType;
+
+  UShortImageType::SizeType size3D;
+  size3D[0] = 27;
+  size3D[1] = 24;
+  size3D[2] = 21;
+  UShortImageType::Pointer image3D = MakeImage< UShortImageType >(size3D);
+  UShortImageType::RegionType region3D = image3D->GetLargestPossibleRegion();
+  UShortImageType::RegionType subregion3D = region3D;
+  subregion3D.PadByRadius(-5);
+
+  FloatImageType::SizeType size2D;
+  size2D[0] = 80;
+  size2D[1] = 70;
+  FloatImageType::Pointer image2D = MakeImage< FloatImageType >(size2D);
+  FloatImageType::SpacingType spacing2D;
+  spacing2D[0] = 0.5;
+  spacing2D[1] = 1.5;
+  image2D->SetSpacing(spacing2D);
+  FloatImageType::RegionType region2D = image2D->GetLargestPossibleRegion();
+
+  if ( !Compare< UShortImageType >("unsigned short 3D", image3D, 2.0, region3D)
+       || !Compare< UShortImageType >("unsigned short 3D", image3D, 3.0, region3D)
+       || !Compare< UShortImageType >("unsigned short 3D subregion", image3D, 2.5, subregion3D)
+       || !Compare< FloatImageType >("float 2D", image2D, 2.0, region2D)
+       || !Compare< FloatImageType >("float 2D", image2D, 6.0, region2D) )
+    {
+    return EXIT_FAILURE;
+    }
+
+  // The grid of the 3D image, with a domain sigma of 2, has 28x25x22
+  // cells of 8 bytes along the image directions, and about 49 along the
+  // intensity axis, which spans about 2300: 34 fit in 4 MB, with cells
+  // of less than the range sigma, but 17 in 2 MB are not enough.
+  const double coarsenedMean = LimitedGridDifference< UShortImageType >(image3D, 4 * 1024 * 1024);
+  const double exactMean = LimitedGridDifference< UShortImageType >(image3D, 2 * 1024 * 1024);
+  std::cout << "unsigned short 3D, grid of 4 MB: mean difference " << coarsenedMean << std::endl;
+  std::cout << "unsigned short 3D, grid of 2 MB: mean difference " << exactMean << std::endl;
+  if ( coarsenedMean == 0.0 || coarsenedMean > 0.05 * RangeSigma || exactMean != 0.0 )
+    {
+    std::cerr << "The grid is not coarsened, or replaced by the exact filter, as documented" << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  // Benchmark.
+  UShortImageType::SizeType size;
+  size.Fill(edgeLength);
+  UShortImageType::Pointer    input = MakeImage< UShortImageType >(size);
+  UShortImageType::RegionType region = input->GetLargestPossibleRegion();
+
+  std::cout << "Filtering a " << edgeLength << "^3 unsigned short volume, s:" << std::endl;
+  std::cout << "  domain sigma       exact        grid  mean difference" << std::endl;
+  for ( unsigned int sigma = 2; sigma <= 10; sigma += 2 )
+    {
+    itk::TimeProbe gridProbe;
+    gridProbe.Start();
+    UShortImageType::Pointer output = Filter< UShortImageType >(input, sigma, true, region);
+    gridProbe.Stop();
+
+    std::cout << "  " << std::setw(12) << sigma;
+    // the exact filter is too slow with the largest kernels
+    const double kernelWidth = 2.0 * vcl_ceil(2.5 * sigma) + 1.0;
+    if ( kernelWidth * kernelWidth * kernelWidth * region.GetNumberOfPixels() < 2e8 )
+      {
+      itk::TimeProbe exactProbe;
+      exactProbe.Start();
+      UShortImageType::Pointer expected = Filter< UShortImageType >(input, sigma, false, region);
+      exactProbe.Stop();
+      double maximum;
+      std::cout << std::setw(12) << exactProbe.GetTotal() << std::setw(12) << gridProbe.GetTotal()
+                << std::setw(17)
+                << Difference< UShortImageType >(output.GetPointer(), expected.GetPointer(), region, maximum)
+                << std::endl;
+      }
+    else
+      {
+      std::cout << std::setw(12) << "-" << std::setw(12) << gridProbe.GetTotal() << std::endl;
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -20,6 +20,7 @@
 
 #include "itkInPlaceImageFilter.h"
 #include "itkSimpleDataObjectDecorator.h"
+#include "itkFunctorBatch.h"
 
 namespace itk
 {
@@ -36,6 +37,9 @@ namespace itk
  * the pipeline. The SetConstant() and GetConstant() methods are provided as shortcuts
  * to set or get the constant value without manipulating the decorator.
  *
+ * Images are processed a span of contiguous pixels at a time through
+ * Functor::BinaryBatch< TFunction >, see UnaryFunctorImageFilter.
+ *
  * \sa UnaryFunctorImageFilter TernaryFunctorImageFilter
  *
  * \ingroup IntensityImageFilters   MultiThreaded
@@ -214,6 +214,68 @@ BinaryFunctorImageFilter< TInputImage1, TInputImage2, TOutputImage, TFunction >
     dynamic_cast< const TInputImage2 * >( ProcessObject::GetInput(1) );
   OutputImagePointer outputPtr = this->GetOutput(0);
 
+  ProgressReporter progress( this, threadId, outputRegionForThread.GetNumberOfPixels() );
+
+  // Pixels stored in plain arrays are processed a span at a time.
+  if( ContiguousPixelBuffer< TInputImage1 >::Value && ContiguousPixelBuffer< TInputImage2 >::Value
+      && ContiguousPixelBuffer< TOutputImage >::Value && ( inputPtr1 || inputPtr2 ) )
+    {
+    typedef Functor::BinaryBatch< FunctorType > BatchType;
+
+    ScanlineSpanIterator< itkGetStaticConstMacro(OutputImageDimension) > span(outputRegionForThread);
+    const unsigned int output = span.AddBuffer( outputPtr->GetBufferedRegion() );
+    unsigned int       input1 = 0;
+    unsigned int       input2 = 0;
+    const Input1ImagePixelType *inputBuffer1 = 0;
+    const Input2ImagePixelType *inputBuffer2 = 0;
+    const Input1ImagePixelType *input1Value = 0;
+    const Input2ImagePixelType *input2Value = 0;
+    if( inputPtr1 )
+      {
+      input1 = span.AddBuffer( inputPtr1->GetBufferedRegion() );
+      inputBuffer1 = ContiguousPixelBuffer< TInputImage1 >::GetBufferPointer( inputPtr1.GetPointer() );
+      }
+    else
+      {
+      input1Value = &this->GetConstant1();
+      }
+    if( inputPtr2 )
+      {
+      input2 = span.AddBuffer( inputPtr2->GetBufferedRegion() );
+      inputBuffer2 = ContiguousPixelBuffer< TInputImage2 >::GetBufferPointer( inputPtr2.GetPointer() );
+      }
+    else
+      {
+      input2Value = &this->GetConstant2();
+      }
+    OutputImagePixelType *outputBuffer =
+      ContiguousPixelBuffer< TOutputImage >::GetBufferPointer( outputPtr.GetPointer() );
+
+    for( span.GoToBegin(); !span.IsAtEnd(); ++span )
+      {
+      if( inputPtr1 && inputPtr2 )
+        {
+        BatchType::Evaluate( m_Functor, inputBuffer1 + span.GetOffset(input1),
+                             inputBuffer2 + span.GetOffset(input2),
+                             outputBuffer + span.GetOffset(output), span.GetLength() );
+        }
+      else if( inputPtr1 )
+        {
+        BatchType::EvaluateWithConstant2( m_Functor, inputBuffer1 + span.GetOffset(input1),
+                                          *input2Value,
+                                          outputBuffer + span.GetOffset(output), span.GetLength() );
+        }
+      else
+        {
+        BatchType::EvaluateWithConstant1( m_Functor, *input1Value,
+                                          inputBuffer2 + span.GetOffset(input2),
+                                          outputBuffer + span.GetOffset(output), span.GetLength() );
+        }
+      progress.CompletedPixels( span.GetLength() ); // potential exception thrown here
+      }
+    return;
+    }
+
   if( inputPtr1 && inputPtr2 )
     {
     ImageRegionConstIterator< TInputImage1 > inputIt1(inputPtr1, outputRegionForThread);
@@ -221,8 +283,6 @@ BinaryFunctorImageFilter< TInputImage1, TInputImage2, TOutputImage, TFunction >
 
     ImageRegionIterator< TOutputImage > outputIt(outputPtr, outputRegionForThread);
 
-    ProgressReporter progress( this, threadId, outputRegionForThread.GetNumberOfPixels() );
-
     inputIt1.GoToBegin();
     inputIt2.GoToBegin();
     outputIt.GoToBegin();
@@ -241,8 +301,6 @@ BinaryFunctorImageFilter< TInputImage1, TInputImage2, TOutputImage, TFunction >
     ImageRegionConstIterator< TInputImage1 > inputIt1(inputPtr1, outputRegionForThread);
     ImageRegionIterator< TOutputImage > outputIt(outputPtr, outputRegionForThread);
     const Input2ImagePixelType & input2Value = this->GetConstant2();
-    ProgressReporter progress( this, threadId, outputRegionForThread.GetNumberOfPixels() );
-
     inputIt1.GoToBegin();
     outputIt.GoToBegin();
 
@@ -259,8 +317,6 @@ BinaryFunctorImageFilter< TInputImage1, TInputImage2, TOutputImage, TFunction >
     ImageRegionConstIterator< TInputImage2 > inputIt2(inputPtr2, outputRegionForThread);
     ImageRegionIterator< TOutputImage > outputIt(outputPtr, outputRegionForThread);
     const Input1ImagePixelType & input1Value = this->GetConstant1();
-    ProgressReporter progress( this, threadId, outputRegionForThread.GetNumberOfPixels() );
-
     inputIt2.GoToBegin();
     outputIt.GoToBegin();
 
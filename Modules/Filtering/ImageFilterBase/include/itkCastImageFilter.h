@@ -83,6 +83,58 @@ public:
     return static_cast< TOutput >( A );
   }
 };
+
+#ifdef ITK_USE_SSE2_FUNCTOR_BATCH
+// float and unsigned short images are converted with SSE2 instructions
+template< >
+class UnaryBatch< Cast< float, unsigned short > >:
+  public ScalarUnaryBatch< Cast< float, unsigned short > >
+{
+public:
+  using ScalarUnaryBatch< Cast< float, unsigned short > >::Evaluate;
+
+  static void Evaluate(const Cast< float, unsigned short > & functor, const float *input,
+                       unsigned short *output, SizeValueType length)
+  {
+    SizeValueType i = 0;
+    for ( ; i + 8 <= length; i += 8 )
+      {
+      _mm_storeu_si128( reinterpret_cast< __m128i * >( output + i ),
+                        SSE2ConvertToUnsignedShort( _mm_loadu_ps(input + i), _mm_loadu_ps(input + i + 4) ) );
+      }
+    for ( ; i < length; ++i )
+      {
+      output[i] = functor(input[i]);
+      }
+  }
+};
+
+template< >
+class UnaryBatch< Cast< unsigned short, float > >:
+  public ScalarUnaryBatch< Cast< unsigned short, float > >
+{
+public:
+  using ScalarUnaryBatch< Cast< unsigned short, float > >::Evaluate;
+
+  static void Evaluate(const Cast< unsigned short, float > & functor, const unsigned short *input,
+                       float *output, SizeValueType length)
+  {
+    SizeValueType i = 0;
+    for ( ; i + 8 <= length; i += 8 )
+      {
+      __m128 low;
+      __m128 high;
+      SSE2ConvertToFloat(_mm_loadu_si128( reinterpret_cast< const __m128i * >( input + i ) ), low, high);
+      _mm_storeu_ps(output + i, low);
+      _mm_storeu_ps(output + i + 4, high);
+      }
+    for ( ; i < length; ++i )
+      {
+      output[i] = functor(input[i]);
+      }
+  }
+};
+#endif
 }
 
 template< class TInputImage, class TOutputImage >
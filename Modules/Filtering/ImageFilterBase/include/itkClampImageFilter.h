@@ -79,6 +79,35 @@ public:
     return static_cast< TOutput >( A );
   }
 };
+
+#ifdef ITK_USE_SSE2_FUNCTOR_BATCH
+// float images are clamped to unsigned short with SSE2 instructions
+template< >
+class UnaryBatch< Clamp< float, unsigned short > >:
+  public ScalarUnaryBatch< Clamp< float, unsigned short > >
+{
+public:
+  using ScalarUnaryBatch< Clamp< float, unsigned short > >::Evaluate;
+
+  static void Evaluate(const Clamp< float, unsigned short > & functor, const float *input,
+                       unsigned short *output, SizeValueType length)
+  {
+    const __m128  minimum = _mm_setzero_ps();
+    const __m128  maximum = _mm_set1_ps(65535.0f);
+    SizeValueType i = 0;
+    for ( ; i + 8 <= length; i += 8 )
+      {
+      const __m128 low = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(input + i), minimum), maximum);
+      const __m128 high = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(input + i + 4), minimum), maximum);
+      _mm_storeu_si128( reinterpret_cast< __m128i * >( output + i ), SSE2ConvertToUnsignedShort(low, high) );
+      }
+    for ( ; i < length; ++i )
+      {
+      output[i] = functor(input[i]);
+      }
+  }
+};
+#endif
 }
 
 template <class TInputImage, class TOutputImage>
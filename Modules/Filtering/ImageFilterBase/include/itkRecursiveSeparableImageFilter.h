@@ -43,6 +43,15 @@ namespace itk
  * G. Farneback & C.-F. Westin, "On Implementation of Recursive Gaussian
  * Filters", so far unpublished.
  *
+ * When both images store their pixels in a single buffer, like
+ * itk::Image, the lines are by default filtered in blocks of
+ * LinesPerBlock adjacent lines: a tile of the block is gathered with
+ * the lines interleaved, so that the pixels read together are close in
+ * memory even along the slow dimensions, and the recursions of all the
+ * lines are computed together, which the compiler can vectorize. The
+ * results are the same as filtering one line at a time, which
+ * UseLineBlocksOff() restores.
+ *
  * \ingroup ImageFilters
  * \ingroup ITKImageFilterBase
  */
@@ -87,6 +96,17 @@ public:
   /** Set the direction in which the filter is to be applied. */
   itkSetMacro(Direction, unsigned int);
 
+  /** Number of adjacent lines filtered together when UseLineBlocks
+   * is on. */
+  itkStaticConstMacro(LinesPerBlock, unsigned int, 16);
+
+  /** Set/Get whether to filter blocks of LinesPerBlock adjacent lines
+   * at once, instead of one line at a time. This only applies when the
+   * input and output images are itk::Image. Default is on. */
+  itkSetMacro(UseLineBlocks, bool);
+  itkGetConstMacro(UseLineBlocks, bool);
+  itkBooleanMacro(UseLineBlocks);
+
   /** Set Input Image. */
   void SetInputImage(const TInputImage *);
 
@@ -130,6 +150,21 @@ protected:
   void FilterDataArray(RealType *outs, const RealType *data, RealType *scratch,
                        unsigned int ln);
 
+  /** Apply the Recursive Filter to LinesPerBlock lines at once, like
+   * FilterDataArray() to each of them. The lines are interleaved in
+   * the arrays: sample i of line l is at index i * LinesPerBlock + l,
+   * and the arrays hold ln * LinesPerBlock values. */
+  void FilterDataBlock(RealType *outs, const RealType *data, RealType *scratch,
+                       unsigned int ln);
+
+  /** Filter the lines of the thread region in blocks of LinesPerBlock
+   * adjacent lines, reading and writing the image buffers directly.
+   * Returns false, without filtering, when the images do not store
+   * their pixels in a single buffer or the region has no second
+   * dimension to take blocks of lines from. */
+  bool ThreadedGenerateDataInBlocks(const OutputImageRegionType & outputRegionForThread,
+                                    ThreadIdType threadId);
+
 protected:
   /** Causal coefficients that multiply the input data. */
   ScalarRealType m_N0;
@@ -169,6 +204,8 @@ private:
   /** Direction in which the filter is to be applied
    * this should be in the range [0,ImageDimension-1]. */
   unsigned int m_Direction;
+
+  bool m_UseLineBlocks;
 };
 } // end namespace itk
 
@@ -21,7 +21,10 @@
 #include "itkRecursiveSeparableImageFilter.h"
 #include "itkObjectFactory.h"
 #include "itkImageLinearIteratorWithIndex.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
 #include "itkProgressReporter.h"
+#include "itkFunctorBatch.h"
+#include <algorithm>
 #include <new>
 
 namespace itk
@@ -31,6 +34,7 @@ RecursiveSeparableImageFilter< TInputImage, TOutputImage >
 ::RecursiveSeparableImageFilter()
 {
   m_Direction = 0;
+  m_UseLineBlocks = true;
   this->SetNumberOfRequiredOutputs(1);
   this->SetNumberOfRequiredInputs(1);
 
@@ -152,6 +156,138 @@ RecursiveSeparableImageFilter< TInputImage, TOutputImage >
     }
 }
 
+/**
+ * Apply Recursive Filter to a block of interleaved lines
+ */
+template< typename TInputImage, typename TOutputImage >
+void
+RecursiveSeparableImageFilter< TInputImage, TOutputImage >
+::FilterDataBlock(RealType *outs, const RealType *data,
+                  RealType *scratch, unsigned int ln)
+{
+  // The computations are those of FilterDataArray(), in the same order
+  // for each line, so that the results are the same. The loops over the
+  // lines of the block are innermost and have a constant length, so
+  // that they can be vectorized.
+  const unsigned int L = LinesPerBlock;
+
+  /**
+   * Causal direction pass
+   */
+  for ( unsigned int l = 0; l < L; l++ )
+    {
+    const RealType *d = data + l;
+    RealType       *s = scratch + l;
+
+    // this value is assumed to exist from the border to infinity.
+    const RealType outV1 = d[0];
+
+    /**
+     * Initialize borders
+     */
+    s[0]     = RealType(outV1    * m_N0 + outV1    * m_N1 + outV1 * m_N2 + outV1 * m_N3);
+    s[L]     = RealType(d[L]     * m_N0 + outV1    * m_N1 + outV1 * m_N2 + outV1 * m_N3);
+    s[2 * L] = RealType(d[2 * L] * m_N0 + d[L]     * m_N1 + outV1 * m_N2 + outV1 * m_N3);
+    s[3 * L] = RealType(d[3 * L] * m_N0 + d[2 * L] * m_N1 + d[L]  * m_N2 + outV1 * m_N3);
+
+    // note that the outV1 value is multiplied by the Boundary coefficients m_BNi
+    s[0]     -= RealType(outV1    * m_BN1 + outV1 * m_BN2 + outV1 * m_BN3 + outV1 * m_BN4);
+    s[L]     -= RealType(s[0]     * m_D1  + outV1 * m_BN2 + outV1 * m_BN3 + outV1 * m_BN4);
+    s[2 * L] -= RealType(s[L]     * m_D1  + s[0]  * m_D2  + outV1 * m_BN3 + outV1 * m_BN4);
+    s[3 * L] -= RealType(s[2 * L] * m_D1  + s[L]  * m_D2  + s[0]  * m_D3  + outV1 * m_BN4);
+    }
+
+  /**
+   * Recursively filter the rest
+   */
+  for ( unsigned int i = 4; i < ln; i++ )
+    {
+    const RealType *d0 = data + i * L;
+    const RealType *d1 = d0 - L;
+    const RealType *d2 = d1 - L;
+    const RealType *d3 = d2 - L;
+    RealType       *s0 = scratch + i * L;
+    const RealType *s1 = s0 - L;
+    const RealType *s2 = s1 - L;
+    const RealType *s3 = s2 - L;
+    const RealType *s4 = s3 - L;
+    for ( unsigned int l = 0; l < L; l++ )
+      {
+      s0[l]  = RealType(d0[l] * m_N0 + d1[l] * m_N1 + d2[l] * m_N2 + d3[l] * m_N3);
+      s0[l] -= RealType(s1[l] * m_D1 + s2[l] * m_D2 + s3[l] * m_D3 + s4[l] * m_D4);
+      }
+    }
+
+  /**
+   * Store the causal result
+   */
+  for ( unsigned int k = 0; k < ln * L; k++ )
+    {
+    outs[k] = scratch[k];
+    }
+
+  /**
+   * AntiCausal direction pass
+   */
+  for ( unsigned int l = 0; l < L; l++ )
+    {
+    // the last samples of the line
+    const RealType *d0 = data + ( ln - 1 ) * L + l;
+    const RealType *d1 = d0 - L;
+    const RealType *d2 = d1 - L;
+    RealType       *s0 = scratch + ( ln - 1 ) * L + l;
+    RealType       *s1 = s0 - L;
+    RealType       *s2 = s1 - L;
+    RealType       *s3 = s2 - L;
+
+    // this value is assumed to exist from the border to infinity.
+    const RealType outV2 = *d0;
+
+    /**
+     * Initialize borders
+     */
+    *s0 = RealType(outV2 * m_M1 + outV2 * m_M2 + outV2 * m_M3 + outV2 * m_M4);
+    *s1 = RealType(*d0   * m_M1 + outV2 * m_M2 + outV2 * m_M3 + outV2 * m_M4);
+    *s2 = RealType(*d1   * m_M1 + *d0   * m_M2 + outV2 * m_M3 + outV2 * m_M4);
+    *s3 = RealType(*d2   * m_M1 + *d1   * m_M2 + *d0   * m_M3 + outV2 * m_M4);
+
+    // note that the outV2value is multiplied by the Boundary coefficients m_BMi
+    *s0 -= RealType(outV2 * m_BM1 + outV2 * m_BM2 + outV2 * m_BM3 + outV2 * m_BM4);
+    *s1 -= RealType(*s0   * m_D1  + outV2 * m_BM2 + outV2 * m_BM3 + outV2 * m_BM4);
+    *s2 -= RealType(*s1   * m_D1  + *s0   * m_D2  + outV2 * m_BM3 + outV2 * m_BM4);
+    *s3 -= RealType(*s2   * m_D1  + *s1   * m_D2  + *s0   * m_D3  + outV2 * m_BM4);
+    }
+
+  /**
+   * Recursively filter the rest
+   */
+  for ( unsigned int i = ln - 4; i > 0; i-- )
+    {
+    const RealType *d0 = data + i * L;
+    const RealType *d1 = d0 + L;
+    const RealType *d2 = d1 + L;
+    const RealType *d3 = d2 + L;
+    RealType       *s0 = scratch + ( i - 1 ) * L;
+    const RealType *s1 = s0 + L;
+    const RealType *s2 = s1 + L;
+    const RealType *s3 = s2 + L;
+    const RealType *s4 = s3 + L;
+    for ( unsigned int l = 0; l < L; l++ )
+      {
+      s0[l]  = RealType(d0[l] * m_M1 + d1[l] * m_M2 + d2[l] * m_M3 + d3[l] * m_M4);
+      s0[l] -= RealType(s1[l] * m_D1 + s2[l] * m_D2 + s3[l] * m_D3 + s4[l] * m_D4);
+      }
+    }
+
+  /**
+   * Roll the antiCausal part into the output
+   */
+  for ( unsigned int k = 0; k < ln * L; k++ )
+    {
+    outs[k] += scratch[k];
+    }
+}
+
 //
 // we need all of the image in just the "Direction" we are separated into
 //
@@ -292,6 +428,11 @@ RecursiveSeparableImageFilter< TInputImage, TOutputImage >
 
   typedef ImageRegion< TInputImage::ImageDimension > RegionType;
 
+  if ( m_UseLineBlocks && this->ThreadedGenerateDataInBlocks(outputRegionForThread, threadId) )
+    {
+    return;
+    }
+
   typename TInputImage::ConstPointer inputImage( this->GetInputImage () );
   typename TOutputImage::Pointer     outputImage( this->GetOutput() );
 
@@ -397,6 +538,136 @@ RecursiveSeparableImageFilter< TInputImage, TOutputImage >
   delete[] scratch;
 }
 
+/**
+ * Compute Recursive filter
+ * block of lines by block of lines in one of the dimensions
+ */
+template< typename TInputImage, typename TOutputImage >
+bool
+RecursiveSeparableImageFilter< TInputImage, TOutputImage >
+::ThreadedGenerateDataInBlocks(const OutputImageRegionType & outputRegionForThread, ThreadIdType threadId)
+{
+  typedef typename TOutputImage::PixelType OutputPixelType;
+
+  typedef ImageRegion< TInputImage::ImageDimension > RegionType;
+
+  if ( !ContiguousPixelBuffer< TInputImage >::Value || !ContiguousPixelBuffer< TOutputImage >::Value )
+    {
+    return false;
+    }
+
+  const RegionType region = outputRegionForThread;
+
+  // The lines of a block are adjacent along the fastest other dimension
+  // in which the region is more than one pixel wide.
+  unsigned int blockDimension = 0;
+  while ( blockDimension < TInputImage::ImageDimension
+          && ( blockDimension == m_Direction || region.GetSize(blockDimension) < 2 ) )
+    {
+    ++blockDimension;
+    }
+  if ( blockDimension == TInputImage::ImageDimension )
+    {
+    return false;
+    }
+
+  const TInputImage *inputImage = this->GetInputImage();
+  TOutputImage      *outputImage = this->GetOutput();
+
+  const InputPixelType *inputBuffer = ContiguousPixelBuffer< TInputImage >::GetBufferPointer(inputImage);
+  OutputPixelType      *outputBuffer = ContiguousPixelBuffer< TOutputImage >::GetBufferPointer(outputImage);
+
+  const OffsetValueType inputStride = inputImage->GetOffsetTable()[m_Direction];
+  const OffsetValueType inputLineStride = inputImage->GetOffsetTable()[blockDimension];
+  const OffsetValueType outputStride = outputImage->GetOffsetTable()[m_Direction];
+  const OffsetValueType outputLineStride = outputImage->GetOffsetTable()[blockDimension];
+
+  const unsigned int  ln = region.GetSize()[m_Direction];
+  const unsigned int  L = LinesPerBlock;
+  const SizeValueType blockLength = region.GetSize()[blockDimension];
+
+  RealType *inps = 0;
+
+  try
+    {
+    inps = new RealType[3 * ln * L];
+    }
+  catch ( std::bad_alloc & )
+    {
+    itkExceptionMacro("Problem allocating memory for internal computations");
+    }
+
+  RealType *outs = inps + ln * L;
+  RealType *scratch = outs + ln * L;
+
+  // the first pixel of each row of lines
+  RegionType startRegion = region;
+  startRegion.SetSize(m_Direction, 1);
+  startRegion.SetSize(blockDimension, 1);
+  ImageRegionConstIteratorWithIndex< TInputImage > startIterator(inputImage, startRegion);
+
+  ProgressReporter progress(this, threadId, region.GetNumberOfPixels() / ln, 10);
+
+  try  // this try is intended to catch an eventual AbortException.
+    {
+    for ( startIterator.GoToBegin(); !startIterator.IsAtEnd(); ++startIterator )
+      {
+      typename TInputImage::IndexType index = startIterator.GetIndex();
+      for ( SizeValueType first = 0; first < blockLength; first += L )
+        {
+        const unsigned int numberOfLines = static_cast< unsigned int >( std::min< SizeValueType >(L, blockLength - first) );
+
+        const InputPixelType *input = inputBuffer + inputImage->ComputeOffset(index);
+        for ( unsigned int i = 0; i < ln; i++ )
+          {
+          RealType *inp = inps + i * L;
+          unsigned int l = 0;
+          for (; l < numberOfLines; l++ )
+            {
+            inp[l] = input[i * inputStride + l * inputLineStride];
+            }
+          // the lines missing from the last block repeat its last line
+          for (; l < L; l++ )
+            {
+            inp[l] = inp[numberOfLines - 1];
+            }
+          }
+
+        this->FilterDataBlock(outs, inps, scratch, ln);
+
+        OutputPixelType *output = outputBuffer + outputImage->ComputeOffset(index);
+        for ( unsigned int i = 0; i < ln; i++ )
+          {
+          const RealType *out = outs + i * L;
+          for ( unsigned int l = 0; l < numberOfLines; l++ )
+            {
+            output[i * outputStride + l * outputLineStride] = static_cast< OutputPixelType >( out[l] );
+            }
+          }
+
+        index[blockDimension] += L;
+
+        // Although the method name is CompletedPixels(),
+        // this is being called after each block of lines is processed
+        progress.CompletedPixels(numberOfLines);
+        }
+      }
+    }
+  catch ( ProcessAborted  & )
+    {
+    // release locally allocated memory
+    delete[] inps;
+    // Throw the final exception.
+    ProcessAborted e(__FILE__, __LINE__);
+    e.SetDescription("Process aborted.");
+    e.SetLocation(ITK_LOCATION);
+    throw e;
+    }
+
+  delete[] inps;
+  return true;
+}
+
 template< typename TInputImage, typename TOutputImage >
 void
 RecursiveSeparableImageFilter< TInputImage, TOutputImage >
@@ -405,6 +676,7 @@ RecursiveSeparableImageFilter< TInputImage, TOutputImage >
   Superclass::PrintSelf(os, indent);
 
   os << indent << "Direction: " << m_Direction << std::endl;
+  os << indent << "UseLineBlocks: " << m_UseLineBlocks << std::endl;
 }
 } // end namespace itk
 
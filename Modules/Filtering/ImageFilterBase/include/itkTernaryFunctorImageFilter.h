@@ -20,6 +20,7 @@
 
 #include "itkInPlaceImageFilter.h"
 #include "itkImageRegionIteratorWithIndex.h"
+#include "itkFunctorBatch.h"
 
 namespace itk
 {
@@ -30,6 +31,9 @@ namespace itk
  * and the type of the output image.  It is also parameterized by the
  * operation to be applied, using a Functor style.
  *
+ * Images are processed a span of contiguous pixels at a time through
+ * Functor::TernaryBatch< TFunction >, see UnaryFunctorImageFilter.
+ *
  * \sa BinaryFunctorImageFilter UnaryFunctorImageFilter
  *
  * \ingroup IntensityImageFilters MultiThreaded
@@ -120,13 +120,44 @@ TernaryFunctorImageFilter< TInputImage1, TInputImage2, TInputImage3, TOutputImag
     dynamic_cast< const TInputImage3 * >( ( ProcessObject::GetInput(2) ) );
   OutputImagePointer outputPtr = this->GetOutput(0);
 
+  ProgressReporter progress( this, threadId, outputRegionForThread.GetNumberOfPixels() );
+
+  // Pixels stored in plain arrays are processed a span at a time.
+  if ( ContiguousPixelBuffer< TInputImage1 >::Value && ContiguousPixelBuffer< TInputImage2 >::Value
+       && ContiguousPixelBuffer< TInputImage3 >::Value && ContiguousPixelBuffer< TOutputImage >::Value )
+    {
+    const Input1ImagePixelType *inputBuffer1 =
+      ContiguousPixelBuffer< TInputImage1 >::GetBufferPointer( inputPtr1.GetPointer() );
+    const Input2ImagePixelType *inputBuffer2 =
+      ContiguousPixelBuffer< TInputImage2 >::GetBufferPointer( inputPtr2.GetPointer() );
+    const Input3ImagePixelType *inputBuffer3 =
+      ContiguousPixelBuffer< TInputImage3 >::GetBufferPointer( inputPtr3.GetPointer() );
+    OutputImagePixelType *outputBuffer =
+      ContiguousPixelBuffer< TOutputImage >::GetBufferPointer( outputPtr.GetPointer() );
+
+    ScanlineSpanIterator< itkGetStaticConstMacro(OutputImageDimension) > span(outputRegionForThread);
+    span.AddBuffer( inputPtr1->GetBufferedRegion() );
+    span.AddBuffer( inputPtr2->GetBufferedRegion() );
+    span.AddBuffer( inputPtr3->GetBufferedRegion() );
+    span.AddBuffer( outputPtr->GetBufferedRegion() );
+    for ( span.GoToBegin(); !span.IsAtEnd(); ++span )
+      {
+      Functor::TernaryBatch< FunctorType >::Evaluate( m_Functor,
+                                                      inputBuffer1 + span.GetOffset(0),
+                                                      inputBuffer2 + span.GetOffset(1),
+                                                      inputBuffer3 + span.GetOffset(2),
+                                                      outputBuffer + span.GetOffset(3),
+                                                      span.GetLength() );
+      progress.CompletedPixels( span.GetLength() ); // potential exception thrown here
+      }
+    return;
+    }
+
   ImageRegionConstIterator< TInputImage1 > inputIt1(inputPtr1, outputRegionForThread);
   ImageRegionConstIterator< TInputImage2 > inputIt2(inputPtr2, outputRegionForThread);
   ImageRegionConstIterator< TInputImage3 > inputIt3(inputPtr3, outputRegionForThread);
   ImageRegionIterator< TOutputImage >      outputIt(outputPtr, outputRegionForThread);
 
-  ProgressReporter progress( this, threadId, outputRegionForThread.GetNumberOfPixels() );
-
   inputIt1.GoToBegin();
   inputIt2.GoToBegin();
   inputIt3.GoToBegin();
@@ -11,8 +11,10 @@ itk_module(ITKImageFilterBase
   TEST_DEPENDS
     ITKTestKernel
     ITKImageIntensity
+    ITKThresholding
   DESCRIPTION
     "${DOCUMENTATION}"
 )
 
 # Extra test dependency is introduced by itkMaskNeighborhoodOperatorImageFilterTest.
+# Extra test dependency on ITKThresholding is introduced by itkFunctorImageFilterBatchTest.
@@ -0,0 +1,392 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkAddImageFilter.h"
+#include "itkSubtractImageFilter.h"
+#include "itkMultiplyImageFilter.h"
+#include "itkTernaryAddImageFilter.h"
+#include "itkCastImageFilter.h"
+#include "itkClampImageFilter.h"
+#include "itkBinaryThresholdImageFilter.h"
+#include "itkImageRegionIterator.h"
+#include "itkTimeProbe.h"
+#include <iomanip>
+
+// Runs the unary, binary and ternary functor filters, which process
+// the pixels a span at a time, over float and unsigned short images,
+// with several threads, and over a region of the output smaller than
+// the inputs, so that the spans are single scanlines, and checks that
+// they compute the same pixels as the former loop of pixel iterators
+// calling the functor for each pixel.  It then reports the throughput
+// of both in a single thread, counting the bytes read and written.
+// Pass a larger edge length, e.g. 256, to use it as a benchmark.
+
+namespace
+{
+const unsigned int Dimension = 3;
+
+typedef itk::Image< float, Dimension >          FloatImageType;
+typedef itk::Image< unsigned short, Dimension > UShortImageType;
+typedef itk::Image< unsigned char, Dimension >  UCharImageType;
+typedef FloatImageType::RegionType              RegionType;
+
+RegionType wholeRegion;
+RegionType innerRegion;
+unsigned int repetitions = 3;
+
+template< class TImage >
+typename TImage::Pointer MakeImage(double minimum, double maximum, unsigned int seed)
+{
+  typename TImage::Pointer image = TImage::New();
+  image->SetRegions(wholeRegion);
+  image->Allocate();
+  unsigned int random = seed;
+  itk::ImageRegionIterator< TImage > it( image, wholeRegion );
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    random = random * 1103515245 + 12345;
+    it.Set( static_cast< typename TImage::PixelType >( minimum + ( maximum - minimum ) * ( random >> 8 ) / 16777216.0 ) );
+    }
+  return image;
+}
+
+// The former loops of the functor filters.
+template< class TInputImage, class TOutputImage, class TFunctor >
+void IterateUnary(const TFunctor & functor, const TInputImage *input, TOutputImage *output,
+                  const RegionType & region)
+{
+  itk::ImageRegionConstIterator< TInputImage > inputIt(input, region);
+  itk::ImageRegionIterator< TOutputImage >     outputIt(output, region);
+  for ( inputIt.GoToBegin(), outputIt.GoToBegin(); !inputIt.IsAtEnd(); ++inputIt, ++outputIt )
+    {
+    outputIt.Set( functor( inputIt.Get() ) );
+    }
+}
+
+template< class TInputImage1, class TInputImage2, class TOutputImage, class TFunctor >
+void IterateBinary(const TFunctor & functor, const TInputImage1 *input1, const TInputImage2 *input2,
+                   TOutputImage *output, const RegionType & region)
+{
+  itk::ImageRegionConstIterator< TInputImage1 > inputIt1(input1, region);
+  itk::ImageRegionConstIterator< TInputImage2 > inputIt2(input2, region);
+  itk::ImageRegionIterator< TOutputImage >      outputIt(output, region);
+  for ( inputIt1.GoToBegin(), inputIt2.GoToBegin(), outputIt.GoToBegin();
+        !inputIt1.IsAtEnd(); ++inputIt1, ++inputIt2, ++outputIt )
+    {
+    outputIt.Set( functor( inputIt1.Get(), inputIt2.Get() ) );
+    }
+}
+
+template< class TInputImage1, class TInputImage2, class TOutputImage, class TFunctor >
+void IterateBinaryWithConstant(const TFunctor & functor, const TInputImage1 *input1,
+                               const typename TInputImage2::PixelType & input2,
+                               TOutputImage *output, const RegionType & region)
+{
+  itk::ImageRegionConstIterator< TInputImage1 > inputIt1(input1, region);
+  itk::ImageRegionIterator< TOutputImage >      outputIt(output, region);
+  for ( inputIt1.GoToBegin(), outputIt.GoToBegin(); !inputIt1.IsAtEnd(); ++inputIt1, ++outputIt )
+    {
+    outputIt.Set( functor( inputIt1.Get(), input2 ) );
+    }
+}
+
+template< class TInputImage1, class TInputImage2, class TInputImage3, class TOutputImage, class TFunctor >
+void IterateTernary(const TFunctor & functor, const TInputImage1 *input1, const TInputImage2 *input2,
+                    const TInputImage3 *input3, TOutputImage *output, const RegionType & region)
+{
+  itk::ImageRegionConstIterator< TInputImage1 > inputIt1(input1, region);
+  itk::ImageRegionConstIterator< TInputImage2 > inputIt2(input2, region);
+  itk::ImageRegionConstIterator< TInputImage3 > inputIt3(input3, region);
+  itk::ImageRegionIterator< TOutputImage >      outputIt(output, region);
+  for ( inputIt1.GoToBegin(), inputIt2.GoToBegin(), inputIt3.GoToBegin(), outputIt.GoToBegin();
+        !inputIt1.IsAtEnd(); ++inputIt1, ++inputIt2, ++inputIt3, ++outputIt )
+    {
+    outputIt.Set( functor( inputIt1.Get(), inputIt2.Get(), inputIt3.Get() ) );
+    }
+}
+
+// Computes the output of a filter with the former loop.
+template< class TFilter >
+struct UnaryReference {
+  static void Compute(TFilter *filter, typename TFilter::OutputImageType *output, const RegionType & region)
+  {
+    IterateUnary(filter->GetFunctor(), filter->GetInput(), output, region);
+  }
+};
+
+template< class TFilter >
+struct BinaryReference {
+  typedef typename TFilter::Input1ImageType Input1ImageType;
+  typedef typename TFilter::Input2ImageType Input2ImageType;
+
+  static void Compute(TFilter *filter, typename TFilter::OutputImageType *output, const RegionType & region)
+  {
+    const Input1ImageType *input1 = dynamic_cast< const Input1ImageType * >( filter->GetInputs()[0].GetPointer() );
+    const Input2ImageType *input2 = dynamic_cast< const Input2ImageType * >( filter->GetInputs()[1].GetPointer() );
+    if ( input2 )
+      {
+      IterateBinary(filter->GetFunctor(), input1, input2, output, region);
+      }
+    else
+      {
+      IterateBinaryWithConstant< Input1ImageType, Input2ImageType >( filter->GetFunctor(), input1,
+                                                                     filter->GetConstant2(), output, region );
+      }
+  }
+};
+
+template< class TFilter >
+struct TernaryReference {
+  static void Compute(TFilter *filter, typename TFilter::OutputImageType *output, const RegionType & region)
+  {
+    IterateTernary( filter->GetFunctor(),
+                    dynamic_cast< const typename TFilter::Input1ImageType * >( filter->GetInputs()[0].GetPointer() ),
+                    dynamic_cast< const typename TFilter::Input2ImageType * >( filter->GetInputs()[1].GetPointer() ),
+                    dynamic_cast< const typename TFilter::Input3ImageType * >( filter->GetInputs()[2].GetPointer() ),
+                    output, region );
+  }
+};
+
+// Checks the filter in several threads over the whole and the inner
+// region, then reports the throughput of the filter and of the former
+// loop in one thread.
+template< class TFilter, class TReference >
+bool TestFilter(const char *name, TFilter *filter, unsigned int bytesPerPixel)
+{
+  typedef typename TFilter::OutputImageType OutputImageType;
+
+  const RegionType regions[] = { wholeRegion, innerRegion };
+  for ( unsigned int r = 0; r < 2; ++r )
+    {
+    filter->SetNumberOfThreads(3);
+    filter->UpdateOutputInformation();
+    filter->GetOutput()->SetRequestedRegion(regions[r]);
+    filter->Modified();
+    filter->Update();
+
+    typename OutputImageType::Pointer expected = OutputImageType::New();
+    expected->SetRegions(regions[r]);
+    expected->Allocate();
+    TReference::Compute(filter, expected, regions[r]);
+
+    itk::ImageRegionConstIterator< OutputImageType > it( filter->GetOutput(), regions[r] );
+    itk::ImageRegionConstIterator< OutputImageType > eit( expected, regions[r] );
+    for ( it.GoToBegin(), eit.GoToBegin(); !it.IsAtEnd(); ++it, ++eit )
+      {
+      if ( it.Get() != eit.Get() )
+        {
+        std::cerr << name << ": pixel " << it.GetIndex() << " is "
+                  << static_cast< double >( it.Get() ) << " instead of "
+                  << static_cast< double >( eit.Get() ) << std::endl;
+        return false;
+        }
+      }
+    }
+
+  // Benchmark.
+  typename OutputImageType::Pointer expected = OutputImageType::New();
+  expected->SetRegions(wholeRegion);
+  expected->Allocate();
+  filter->SetNumberOfThreads(1);
+  filter->GetOutput()->SetRequestedRegion(wholeRegion);
+  itk::TimeProbe spanProbe;
+  itk::TimeProbe pixelProbe;
+  for ( unsigned int i = 0; i < repetitions; ++i )
+    {
+    filter->Modified();
+    spanProbe.Start();
+    filter->Update();
+    spanProbe.Stop();
+
+    pixelProbe.Start();
+    TReference::Compute(filter, expected, wholeRegion);
+    pixelProbe.Stop();
+    }
+  const double gigabytes = wholeRegion.GetNumberOfPixels() * static_cast< double >( bytesPerPixel ) / 1e9;
+  std::cout << "  " << std::left << std::setw(40) << name << std::right << std::fixed << std::setprecision(2)
+            << std::setw(10) << gigabytes / pixelProbe.GetMean()
+            << std::setw(10) << gigabytes / spanProbe.GetMean()
+            << std::setw(10) << pixelProbe.GetMean() / spanProbe.GetMean() << std::endl;
+  return true;
+}
+
+template< class TFilter, class TInputImage1, class TInputImage2 >
+bool TestBinary(const char *name, TInputImage1 *input1, TInputImage2 *input2)
+{
+  typename TFilter::Pointer filter = TFilter::New();
+  filter->SetInput1(input1);
+  filter->SetInput2(input2);
+  return TestFilter< TFilter, BinaryReference< TFilter > >( name, filter,
+                                                           sizeof( typename TInputImage1::PixelType )
+                                                           + sizeof( typename TInputImage2::PixelType )
+                                                           + sizeof( typename TFilter::OutputImageType::PixelType ) );
+}
+
+template< class TFilter, class TInputImage1 >
+bool TestBinaryWithConstant(const char *name, TInputImage1 *input1,
+                            const typename TFilter::Input2ImagePixelType & input2)
+{
+  typename TFilter::Pointer filter = TFilter::New();
+  filter->SetInput1(input1);
+  filter->SetConstant2(input2);
+  return TestFilter< TFilter, BinaryReference< TFilter > >( name, filter,
+                                                           sizeof( typename TInputImage1::PixelType )
+                                                           + sizeof( typename TFilter::OutputImageType::PixelType ) );
+}
+
+template< class TFilter >
+bool TestUnary(const char *name, TFilter *filter)
+{
+  return TestFilter< TFilter, UnaryReference< TFilter > >( name, filter,
+                                                          sizeof( typename TFilter::InputImageType::PixelType )
+                                                          + sizeof( typename TFilter::OutputImageType::PixelType ) );
+}
+}
+
+int itkFunctorImageFilterBatchTest(int argc, char *argv[])
+{
+  unsigned int edgeLength = 64;
+  if ( argc > 1 )
+    {
+    edgeLength = atoi(argv[1]);
+    }
+
+  // scanlines whose length is not a multiple of the SIMD widths
+  RegionType::SizeType size;
+  size[0] = edgeLength + 3;
+  size[1] = edgeLength;
+  size[2] = edgeLength;
+  wholeRegion.SetSize(size);
+  RegionType::IndexType innerIndex;
+  RegionType::SizeType  innerSize;
+  for ( unsigned int d = 0; d < Dimension; ++d )
+    {
+    innerIndex[d] = 3 + d;
+    innerSize[d] = size[d] - 7 - 2 * d;
+    }
+  innerRegion.SetIndex(innerIndex);
+  innerRegion.SetSize(innerSize);
+
+  FloatImageType::Pointer  float1 = MakeImage< FloatImageType >(-1000.0, 70000.0, 1);
+  FloatImageType::Pointer  float2 = MakeImage< FloatImageType >(-1000.0, 70000.0, 2);
+  FloatImageType::Pointer  float3 = MakeImage< FloatImageType >(-1000.0, 70000.0, 3);
+  FloatImageType::Pointer  floatInRange = MakeImage< FloatImageType >(0.0, 65535.99, 4);
+  UShortImageType::Pointer ushort1 = MakeImage< UShortImageType >(0.0, 65535.99, 5);
+  UShortImageType::Pointer ushort2 = MakeImage< UShortImageType >(0.0, 65535.99, 6);
+
+  std::cout << "Images of " << size[0] << "x" << size[1] << "x" << size[2] << " pixels, GB/s:" << std::endl;
+  std::cout << "  " << std::left << std::setw(40) << "" << std::right << std::setw(10) << "pixels"
+            << std::setw(10) << "spans" << std::setw(10) << "speedup" << std::endl;
+
+  typedef itk::AddImageFilter< FloatImageType >                          AddFloatType;
+  typedef itk::SubtractImageFilter< FloatImageType >                     SubtractFloatType;
+  typedef itk::MultiplyImageFilter< FloatImageType >                     MultiplyFloatType;
+  typedef itk::TernaryAddImageFilter< FloatImageType, FloatImageType,
+                                      FloatImageType, FloatImageType >   TernaryAddFloatType;
+  typedef itk::AddImageFilter< UShortImageType >                         AddUShortType;
+  typedef itk::SubtractImageFilter< UShortImageType >                    SubtractUShortType;
+  typedef itk::MultiplyImageFilter< UShortImageType >                    MultiplyUShortType;
+  typedef itk::CastImageFilter< FloatImageType, UShortImageType >        CastFloatType;
+  typedef itk::CastImageFilter< UShortImageType, FloatImageType >        CastUShortType;
+  typedef itk::ClampImageFilter< FloatImageType, UShortImageType >       ClampFloatType;
+  typedef itk::BinaryThresholdImageFilter< FloatImageType, UCharImageType >  ThresholdFloatType;
+  typedef itk::BinaryThresholdImageFilter< UShortImageType, UCharImageType > ThresholdUShortType;
+
+  if ( !TestBinary< AddFloatType >("Add float", float1.GetPointer(), float2.GetPointer())
+       || !TestBinaryWithConstant< AddFloatType >("Add float constant", float1.GetPointer(), 0.1f)
+       || !TestBinary< SubtractFloatType >("Subtract float", float1.GetPointer(), float2.GetPointer())
+       || !TestBinary< MultiplyFloatType >("Multiply float", float1.GetPointer(), float2.GetPointer())
+       || !TestBinary< AddUShortType >("Add unsigned short", ushort1.GetPointer(), ushort2.GetPointer())
+       || !TestBinaryWithConstant< AddUShortType >("Add unsigned short constant", ushort1.GetPointer(), 40000)
+       || !TestBinary< SubtractUShortType >("Subtract unsigned short", ushort1.GetPointer(), ushort2.GetPointer())
+       || !TestBinary< MultiplyUShortType >("Multiply unsigned short", ushort1.GetPointer(), ushort2.GetPointer()) )
+    {
+    return EXIT_FAILURE;
+    }
+
+  CastFloatType::Pointer castFloat = CastFloatType::New();
+  castFloat->SetInput(floatInRange);
+  CastUShortType::Pointer castUShort = CastUShortType::New();
+  castUShort->SetInput(ushort1);
+  ClampFloatType::Pointer clampFloat = ClampFloatType::New();
+  clampFloat->SetInput(float1);
+  ThresholdFloatType::Pointer thresholdFloat = ThresholdFloatType::New();
+  thresholdFloat->SetInput(float1);
+  thresholdFloat->SetLowerThreshold(1000.5f);
+  thresholdFloat->SetUpperThreshold(30000.0f);
+  thresholdFloat->SetInsideValue(200);
+  thresholdFloat->SetOutsideValue(7);
+  ThresholdUShortType::Pointer thresholdUShort = ThresholdUShortType::New();
+  thresholdUShort->SetInput(ushort1);
+  thresholdUShort->SetLowerThreshold(1000);
+  thresholdUShort->SetUpperThreshold(40000);
+  thresholdUShort->SetInsideValue(255);
+  thresholdUShort->SetOutsideValue(0);
+
+  if ( !TestUnary("Cast float to unsigned short", castFloat.GetPointer())
+       || !TestUnary("Cast unsigned short to float", castUShort.GetPointer())
+       || !TestUnary("Clamp float to unsigned short", clampFloat.GetPointer())
+       || !TestUnary("BinaryThreshold float", thresholdFloat.GetPointer())
+       || !TestUnary("BinaryThreshold unsigned short", thresholdUShort.GetPointer()) )
+    {
+    return EXIT_FAILURE;
+    }
+
+  TernaryAddFloatType::Pointer ternaryAdd = TernaryAddFloatType::New();
+  ternaryAdd->SetInput1(float1);
+  ternaryAdd->SetInput2(float2);
+  ternaryAdd->SetInput3(float3);
+  if ( !TestFilter< TernaryAddFloatType, TernaryReference< TernaryAddFloatType > >(
+         "TernaryAdd float", ternaryAdd, 4 * sizeof( float ) ) )
+    {
+    return EXIT_FAILURE;
+    }
+
+  // in place, the output overwriting the first input
+  FloatImageType::Pointer expected = FloatImageType::New();
+  expected->SetRegions(wholeRegion);
+  expected->Allocate();
+  AddFloatType::Pointer addInPlace = AddFloatType::New();
+  IterateBinary(addInPlace->GetFunctor(), float1.GetPointer(), float2.GetPointer(), expected.GetPointer(),
+                wholeRegion);
+  addInPlace->SetInput1(float1);
+  addInPlace->SetInput2(float2);
+  addInPlace->InPlaceOn();
+  addInPlace->SetNumberOfThreads(3);
+  const float *input1Buffer = float1->GetBufferPointer();
+  addInPlace->Update();
+  FloatImageType::Pointer output = addInPlace->GetOutput();
+  if ( output->GetBufferPointer() != input1Buffer )
+    {
+    std::cerr << "AddImageFilter did not run in place" << std::endl;
+    return EXIT_FAILURE;
+    }
+  itk::ImageRegionConstIterator< FloatImageType > it(output, wholeRegion);
+  itk::ImageRegionConstIterator< FloatImageType > eit(expected, wholeRegion);
+  for ( it.GoToBegin(), eit.GoToBegin(); !it.IsAtEnd(); ++it, ++eit )
+    {
+    if ( it.Get() != eit.Get() )
+      {
+      std::cerr << "Add float in place: pixel " << it.GetIndex() << " is " << it.Get()
+                << " instead of " << eit.Get() << std::endl;
+      return EXIT_FAILURE;
+      }
+    }
+
+  return EXIT_SUCCESS;
+}
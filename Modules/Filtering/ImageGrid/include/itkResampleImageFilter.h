@@ -259,6 +259,19 @@ public:
   itkBooleanMacro(UseReferenceImage);
   itkGetConstMacro(UseReferenceImage, bool);
 
+  /** When the transform maps each axis of the output image to an axis of
+   * the input image, e.g. a scaling and translation, and the interpolator
+   * is separable, like BSplineInterpolateImageFunction and
+   * WindowedSincInterpolateImageFunction, the interpolation weights only
+   * depend on the index along each axis. They are then computed once per
+   * row, column and slice of the output region, and each output row is
+   * computed by weighting the rows of samples along the other axes, then
+   * the samples along the row. The results only differ from those of the
+   * interpolator by rounding errors. The default is On. */
+  itkSetMacro(UseSeparableInterpolation, bool);
+  itkBooleanMacro(UseSeparableInterpolation);
+  itkGetConstMacro(UseSeparableInterpolation, bool);
+
   /** ResampleImageFilter produces an image which is a different size
    * than its input.  As such, it needs to provide an implementation
    * for GenerateOutputInformation() in order to inform the pipeline
@@ -328,6 +341,18 @@ protected:
                                   outputRegionForThread,
                                   ThreadIdType threadId);
 
+  /** Implementation for resampling with separable interpolators and
+   *  transformations that map each output axis to an input axis.
+   *  \sa SetUseSeparableInterpolation()
+   */
+  virtual void SeparableThreadedGenerateData(const OutputImageRegionType &
+                                             outputRegionForThread,
+                                             ThreadIdType threadId);
+
+  /** Returns whether the continuous index in the input image along each
+   * axis only depends on the output index along the same axis. */
+  bool IsIndexMappingAxisAligned() const;
+
   virtual PixelType CastPixelWithBoundsChecking( const InterpolatorOutputType value,
                                                  const ComponentType minComponent,
                                                  const ComponentType maxComponent) const;
@@ -350,6 +375,7 @@ private:
   DirectionType   m_OutputDirection;           // output image direction cosines
   IndexType       m_OutputStartIndex;          // output image start index
   bool            m_UseReferenceImage;
+  bool            m_UseSeparableInterpolation;
 
 };
 } // end namespace itk
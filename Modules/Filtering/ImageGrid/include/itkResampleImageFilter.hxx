@@ -43,6 +43,7 @@ ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType >
   m_OutputDirection.SetIdentity();
 
   m_UseReferenceImage = false;
+  m_UseSeparableInterpolation = true;
 
   m_Size.Fill(0);
   m_OutputStartIndex.Fill(0);
@@ -87,6 +88,8 @@ ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType >
   os << indent << "Extrapolator: " << m_Extrapolator.GetPointer() << std::endl;
   os << indent << "UseReferenceImage: " << ( m_UseReferenceImage ? "On" : "Off" )
      << std::endl;
+  os << indent << "UseSeparableInterpolation: " << ( m_UseSeparableInterpolation ? "On" : "Off" )
+     << std::endl;
   return;
 }
 
@@ -235,6 +238,15 @@ ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType >
   // to the IsLinear() call.
   if ( m_Transform->IsLinear() )
     {
+    // Separable interpolators can further reuse their weights when each
+    // output axis is mapped to an input axis.
+    if ( m_UseSeparableInterpolation
+         && m_Interpolator->GetSeparableSupportSize() > 0
+         && this->IsIndexMappingAxisAligned() )
+      {
+      this->SeparableThreadedGenerateData(outputRegionForThread, threadId);
+      return;
+      }
     this->LinearThreadedGenerateData(outputRegionForThread, threadId);
     return;
     }
@@ -301,14 +313,17 @@ ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType >
   // Get ths input pointers
   InputImageConstPointer inputPtr = this->GetInput();
 
-  // Create an iterator that will walk the output region for this thread.
-  typedef ImageRegionIteratorWithIndex< TOutputImage > OutputIterator;
+  // Create an iterator that will walk the output region for this thread,
+  // one scanline at a time.
+  typedef ImageLinearIteratorWithIndex< TOutputImage > OutputIterator;
   OutputIterator outIt(outputPtr, outputRegionForThread);
+  outIt.SetDirection(0);
 
-  // Define a few indices that will be used to translate from an input pixel
-  // to an output pixel
-  PointType outputPoint;         // Coordinates of current output pixel
-  PointType inputPoint;          // Coordinates of current input pixel
+  // The points of a scanline are transformed together, so that the
+  // transform is called once per scanline.
+  const SizeValueType      scanlineLength = outputRegionForThread.GetSize(0);
+  std::vector< PointType > outputPoints(scanlineLength); // Coordinates of the output pixels
+  std::vector< PointType > inputPoints(scanlineLength);  // Coordinates of the input pixels
 
   ContinuousInputIndexType inputIndex;
 
@@ -331,38 +346,48 @@ ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType >
 
   while ( !outIt.IsAtEnd() )
     {
-    // Determine the index of the current output pixel
-    outputPtr->TransformIndexToPhysicalPoint(outIt.GetIndex(), outputPoint);
-
-    // Compute corresponding input pixel position
-    inputPoint = this->m_Transform->TransformPoint(outputPoint);
-    inputPtr->TransformPhysicalPointToContinuousIndex(inputPoint, inputIndex);
-
-    PixelType        pixval;
-    OutputType       value;
-    // Evaluate input at right position and copy to the output
-    if ( m_Interpolator->IsInsideBuffer(inputIndex) )
+    // Determine the coordinates of the output pixels of the scanline
+    IndexType index = outIt.GetIndex();
+    for ( SizeValueType i = 0; i < scanlineLength; ++i )
       {
-      value = m_Interpolator ->EvaluateAtContinuousIndex(inputIndex);
-      pixval = this->CastPixelWithBoundsChecking( value, minOutputValue, maxOutputValue );
-      outIt.Set(pixval);
+      outputPtr->TransformIndexToPhysicalPoint(index, outputPoints[i]);
+      ++index[0];
       }
-    else
+
+    // Compute corresponding input pixel positions
+    this->m_Transform->TransformPoints(&outputPoints[0], &inputPoints[0], scanlineLength);
+
+    for ( SizeValueType i = 0; i < scanlineLength; ++i )
       {
-      if( m_Extrapolator.IsNull() )
+      inputPtr->TransformPhysicalPointToContinuousIndex(inputPoints[i], inputIndex);
+
+      PixelType        pixval;
+      OutputType       value;
+      // Evaluate input at right position and copy to the output
+      if ( m_Interpolator->IsInsideBuffer(inputIndex) )
         {
-        outIt.Set( m_DefaultPixelValue ); // default background value
+        value = m_Interpolator ->EvaluateAtContinuousIndex(inputIndex);
+        pixval = this->CastPixelWithBoundsChecking( value, minOutputValue, maxOutputValue );
+        outIt.Set(pixval);
         }
       else
         {
-        value = m_Extrapolator->EvaluateAtContinuousIndex( inputIndex );
-        pixval = this->CastPixelWithBoundsChecking( value, minOutputValue, maxOutputValue );
-        outIt.Set(pixval);
+        if( m_Extrapolator.IsNull() )
+          {
+          outIt.Set( m_DefaultPixelValue ); // default background value
+          }
+        else
+          {
+          value = m_Extrapolator->EvaluateAtContinuousIndex( inputIndex );
+          pixval = this->CastPixelWithBoundsChecking( value, minOutputValue, maxOutputValue );
+          outIt.Set(pixval);
+          }
         }
-      }
 
-    progress.CompletedPixel();
-    ++outIt;
+      progress.CompletedPixel();
+      ++outIt;
+      }
+    outIt.NextLine();
     }
 
   return;
@@ -507,6 +532,240 @@ ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType >
   return;
 }
 
+/**
+ * IsIndexMappingAxisAligned
+ */
+template< class TInputImage,
+          class TOutputImage,
+          class TInterpolatorPrecisionType >
+bool
+ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType >
+::IsIndexMappingAxisAligned() const
+{
+  const OutputImageType *outputPtr = this->GetOutput();
+  const InputImageType * inputPtr = this->GetInput();
+  const OutputImageRegionType &region = outputPtr->GetLargestPossibleRegion();
+
+  PointType                outputPoint;
+  ContinuousInputIndexType inputIndex;
+  IndexType                index = region.GetIndex();
+
+  outputPtr->TransformIndexToPhysicalPoint(index, outputPoint);
+  inputPtr->TransformPhysicalPointToContinuousIndex(m_Transform->TransformPoint(outputPoint), inputIndex);
+
+  for ( unsigned int j = 0; j < ImageDimension; j++ )
+    {
+    ContinuousInputIndexType nextInputIndex;
+    ++index[j];
+    outputPtr->TransformIndexToPhysicalPoint(index, outputPoint);
+    inputPtr->TransformPhysicalPointToContinuousIndex(m_Transform->TransformPoint(outputPoint), nextInputIndex);
+    --index[j];
+
+    // Axes are mapped to each other when moving along an axis of the
+    // output region moves the continuous index along the other axes by
+    // less than 1e-6 pixels.
+    for ( unsigned int i = 0; i < ImageDimension; i++ )
+      {
+      if ( i != j
+           && vcl_abs(nextInputIndex[i] - inputIndex[i]) * region.GetSize(j) > 1e-6 )
+        {
+        return false;
+        }
+      }
+    }
+  return true;
+}
+
+/**
+ * SeparableThreadedGenerateData
+ */
+template< class TInputImage,
+          class TOutputImage,
+          class TInterpolatorPrecisionType >
+void
+ResampleImageFilter< TInputImage, TOutputImage, TInterpolatorPrecisionType >
+::SeparableThreadedGenerateData(const OutputImageRegionType &
+                                outputRegionForThread,
+                                ThreadIdType threadId)
+{
+  // Get the output pointers
+  OutputImagePointer outputPtr = this->GetOutput();
+
+  // Get ths input pointers
+  InputImageConstPointer inputPtr = this->GetInput();
+
+  // Support for progress methods/callbacks
+  ProgressReporter progress( this,
+                             threadId,
+                             outputRegionForThread.GetNumberOfPixels() );
+
+  typedef typename InterpolatorType::OutputType OutputType;
+
+  // Min/max values of the output pixel type AND these values
+  // represented as the output type of the interpolator
+  const PixelComponentType minValue =  NumericTraits< PixelComponentType >::NonpositiveMin();
+  const PixelComponentType maxValue =  NumericTraits< PixelComponentType >::max();
+
+  const ComponentType minOutputValue = static_cast< ComponentType >( minValue );
+  const ComponentType maxOutputValue = static_cast< ComponentType >( maxValue );
+
+  const unsigned int             support = m_Interpolator->GetSeparableSupportSize();
+  const ContinuousInputIndexType startContinuousIndex = m_Interpolator->GetStartContinuousIndex();
+  const ContinuousInputIndexType endContinuousIndex = m_Interpolator->GetEndContinuousIndex();
+
+  const IndexType & regionIndex = outputRegionForThread.GetIndex();
+  const SizeType &  regionSize = outputRegionForThread.GetSize();
+
+  // Along each axis of the output region, tabulate the continuous index
+  // in the input image, whether it is inside the buffer, and the first
+  // sample weighted by the interpolator and the weights.
+  std::vector< TInterpolatorPrecisionType > position[ImageDimension];
+  std::vector< bool >                       inside[ImageDimension];
+  std::vector< IndexValueType >             first[ImageDimension];
+  std::vector< double >                     weights[ImageDimension];
+
+  PointType                outputPoint;
+  ContinuousInputIndexType inputIndex;
+  for ( unsigned int d = 0; d < ImageDimension; d++ )
+    {
+    position[d].resize(regionSize[d]);
+    first[d].resize(regionSize[d]);
+    weights[d].resize(regionSize[d] * support);
+    inside[d].resize(regionSize[d]);
+
+    IndexType index = regionIndex;
+    for ( SizeValueType o = 0; o < regionSize[d]; o++ )
+      {
+      index[d] = regionIndex[d] + static_cast< IndexValueType >( o );
+      outputPtr->TransformIndexToPhysicalPoint(index, outputPoint);
+      inputPtr->TransformPhysicalPointToContinuousIndex(m_Transform->TransformPoint(outputPoint), inputIndex);
+
+      const TInterpolatorPrecisionType x = inputIndex[d];
+      position[d][o] = x;
+      // same test as ImageFunction::IsInsideBuffer(), which catches NaN's
+      inside[d][o] = x >= startContinuousIndex[d] && x < endContinuousIndex[d];
+      if ( inside[d][o] )
+        {
+        m_Interpolator->ComputeSeparableWeights(x, first[d][o], &weights[d][o * support]);
+        }
+      }
+    }
+
+  // The range of samples weighted along the first axis by the pixels of
+  // an output row.
+  IndexValueType firstSample = NumericTraits< IndexValueType >::max();
+  IndexValueType lastSample = NumericTraits< IndexValueType >::NonpositiveMin();
+  for ( SizeValueType o = 0; o < regionSize[0]; o++ )
+    {
+    if ( inside[0][o] )
+      {
+      firstSample = std::min(firstSample, first[0][o]);
+      lastSample = std::max(lastSample, first[0][o] + static_cast< IndexValueType >( support ) - 1);
+      }
+    }
+  const SizeValueType numberOfSamples = lastSample >= firstSample ? lastSample - firstSample + 1 : 0;
+
+  // The sums of the samples weighted along the other axes, and a row of
+  // samples.
+  std::vector< double > partialSums(numberOfSamples);
+  std::vector< double > samples(numberOfSamples);
+  SizeValueType         numberOfSampleRows = 1;
+  for ( unsigned int d = 1; d < ImageDimension; d++ )
+    {
+    numberOfSampleRows *= support;
+    }
+
+  // Walk the output region, one row at a time.
+  typedef ImageLinearIteratorWithIndex< TOutputImage > OutputIterator;
+  OutputIterator outIt(outputPtr, outputRegionForThread);
+  outIt.SetDirection(0);
+
+  while ( !outIt.IsAtEnd() )
+    {
+    const IndexType index = outIt.GetIndex();
+
+    bool rowIsInside = true;
+    for ( unsigned int d = 1; d < ImageDimension; d++ )
+      {
+      const SizeValueType o = index[d] - regionIndex[d];
+      rowIsInside = rowIsInside && inside[d][o];
+      inputIndex[d] = position[d][o];
+      }
+
+    if ( rowIsInside && numberOfSamples > 0 )
+      {
+      // Weight the rows of samples along the other axes.
+      std::fill(partialSums.begin(), partialSums.end(), 0.0);
+      IndexType    sampleIndex;
+      unsigned int k[ImageDimension];
+      sampleIndex[0] = firstSample;
+      for ( unsigned int d = 1; d < ImageDimension; d++ )
+        {
+        k[d] = 0;
+        }
+      for ( SizeValueType r = 0; r < numberOfSampleRows; r++ )
+        {
+        double weight = 1.0;
+        for ( unsigned int d = 1; d < ImageDimension; d++ )
+          {
+          const SizeValueType o = index[d] - regionIndex[d];
+          weight *= weights[d][o * support + k[d]];
+          sampleIndex[d] = first[d][o] + k[d];
+          }
+        // the weights of windowed sinc interpolators form a delta
+        // function at input pixels
+        if ( weight != 0.0 )
+          {
+          m_Interpolator->GetSeparableSamples(sampleIndex, numberOfSamples, &samples[0]);
+          for ( SizeValueType i = 0; i < numberOfSamples; i++ )
+            {
+            partialSums[i] += weight * samples[i];
+            }
+          }
+        for ( unsigned int d = 1; d < ImageDimension; d++ )
+          {
+          if ( ++k[d] < support )
+            {
+            break;
+            }
+          k[d] = 0;
+          }
+        }
+      }
+
+    for ( SizeValueType o = 0; !outIt.IsAtEndOfLine(); o++, ++outIt )
+      {
+      OutputType value;
+      if ( rowIsInside && inside[0][o] )
+        {
+        // Weight the partial sums along the first axis.
+        const double *weight = &weights[0][o * support];
+        const double *partialSum = &partialSums[first[0][o] - firstSample];
+        double        sum = 0.0;
+        for ( unsigned int i = 0; i < support; i++ )
+          {
+          sum += weight[i] * partialSum[i];
+          }
+        InterpolatorConvertType::SetNthComponent( 0, value, static_cast< ComponentType >( sum ) );
+        }
+      else if ( m_Extrapolator.IsNull() )
+        {
+        outIt.Set(m_DefaultPixelValue); // default background value
+        continue;
+        }
+      else
+        {
+        inputIndex[0] = position[0][o];
+        value = m_Extrapolator->EvaluateAtContinuousIndex(inputIndex);
+        }
+      outIt.Set( this->CastPixelWithBoundsChecking(value, minOutputValue, maxOutputValue) );
+      }
+
+    progress.CompletedPixels(regionSize[0]);
+    outIt.NextLine();
+    }
+}
+
 /**
  * Inform pipeline of necessary input image region
  *
@@ -0,0 +1,280 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkResampleImageFilter.h"
+#include "itkAffineTransform.h"
+#include "itkBSplineInterpolateImageFunction.h"
+#include "itkWindowedSincInterpolateImageFunction.h"
+#include "itkNearestNeighborExtrapolateImageFunction.h"
+#include "itkImageRegionIterator.h"
+#include "itkTimeProbe.h"
+#include <iomanip>
+
+// Resamples float and short images with B-spline interpolators of
+// several orders and with a windowed sinc interpolator, with scalings,
+// translations by fractions and whole numbers of pixels, and flips,
+// over output regions larger than the input image, with and without an
+// extrapolator, with several threads, over the whole output image and
+// over a smaller requested region, and checks that the separable
+// interpolation gives the same results as the interpolator, up to
+// rounding errors. It also checks that rotations, which cannot use the
+// separable interpolation, still give the same results. It then reports
+// the time taken by both methods to resample a float volume with a
+// cubic B-spline and a windowed sinc, in one thread. Pass a larger edge
+// length, e.g. 512, to use it as a benchmark.
+
+namespace
+{
+template< class TImage >
+typename TImage::Pointer MakeImage(const typename TImage::SizeType & size)
+{
+  typename TImage::Pointer image = TImage::New();
+  typename TImage::IndexType index;
+  typename TImage::SpacingType spacing;
+  typename TImage::PointType origin;
+  for ( unsigned int d = 0; d < TImage::ImageDimension; ++d )
+    {
+    index[d] = 2 - 3 * static_cast< int >( d );
+    spacing[d] = 1.0 + 0.2 * d;
+    origin[d] = 10.0 - 4.0 * d;
+    }
+  typename TImage::RegionType region(index, size);
+  image->SetRegions(region);
+  image->SetSpacing(spacing);
+  image->SetOrigin(origin);
+  image->Allocate();
+  unsigned int random = 1;
+  itk::ImageRegionIterator< TImage > it(image, region);
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    random = random * 1103515245 + 12345;
+    it.Set( static_cast< typename TImage::PixelType >( ( random >> 8 ) % 1000 ) );
+    }
+  return image;
+}
+
+template< class TImage >
+typename TImage::Pointer Resample(const TImage *input,
+                                  itk::InterpolateImageFunction< TImage, double > *interpolator,
+                                  const itk::Transform< double, TImage::ImageDimension,
+                                                        TImage::ImageDimension > *transform,
+                                  double scale, double shift, int margin, bool extrapolate,
+                                  bool useSeparable, bool useSubregion, unsigned int numberOfThreads)
+{
+  typedef itk::ResampleImageFilter< TImage, TImage > FilterType;
+  typename FilterType::Pointer filter = FilterType::New();
+  filter->SetInput(input);
+  filter->SetInterpolator(interpolator);
+  filter->SetTransform(transform);
+  if ( extrapolate )
+    {
+    typedef itk::NearestNeighborExtrapolateImageFunction< TImage, double > ExtrapolatorType;
+    filter->SetExtrapolator( ExtrapolatorType::New() );
+    }
+  filter->SetDefaultPixelValue(7);
+
+  // Scale the spacing, and cover margin more pixels than the input image
+  // on each side.
+  const typename TImage::RegionType & inputRegion = input->GetLargestPossibleRegion();
+  typename TImage::SizeType    size;
+  typename TImage::SpacingType spacing;
+  typename TImage::PointType   origin;
+  typename TImage::IndexType   index;
+  for ( unsigned int d = 0; d < TImage::ImageDimension; ++d )
+    {
+    spacing[d] = input->GetSpacing()[d] * scale;
+    origin[d] = input->GetOrigin()[d] + ( inputRegion.GetIndex(d) - margin + shift ) * input->GetSpacing()[d];
+    size[d] = static_cast< itk::SizeValueType >( ( inputRegion.GetSize(d) + 2 * margin ) / scale );
+    index[d] = d;
+    }
+  filter->SetSize(size);
+  filter->SetOutputSpacing(spacing);
+  filter->SetOutputOrigin(origin);
+  filter->SetOutputStartIndex(index);
+  filter->SetUseSeparableInterpolation(useSeparable);
+  filter->SetNumberOfThreads(numberOfThreads);
+  filter->UpdateOutputInformation();
+  typename TImage::RegionType region = filter->GetOutput()->GetLargestPossibleRegion();
+  if ( useSubregion )
+    {
+    region.PadByRadius(-3);
+    }
+  filter->GetOutput()->SetRequestedRegion(region);
+  filter->Update();
+  return filter->GetOutput();
+}
+
+template< class TImage >
+bool Compare(const char *name, const TImage *input,
+             itk::InterpolateImageFunction< TImage, double > *interpolator, double tolerance)
+{
+  const unsigned int Dimension = TImage::ImageDimension;
+  typedef itk::AffineTransform< double, Dimension > TransformType;
+
+  // flip the first axis around the center of the image
+  typename TransformType::Pointer flip = TransformType::New();
+  typename TransformType::MatrixType matrix;
+  matrix.SetIdentity();
+  matrix[0][0] = -1.0;
+  typename TransformType::InputPointType center;
+  input->TransformIndexToPhysicalPoint(input->GetLargestPossibleRegion().GetIndex(), center);
+  flip->SetCenter(center);
+  flip->SetMatrix(matrix);
+
+  typename TransformType::Pointer rotation = TransformType::New();
+  rotation->SetCenter(center);
+  rotation->Rotate(0, 1, 0.3);
+
+  typename TransformType::Pointer identity = TransformType::New();
+
+  // The continuous indices never fall halfway between pixels, where
+  // rounding errors could change the nearest pixel, or whether they are
+  // inside the image.
+  const double scales[] = { 1.0, 0.55, 1.65, 1.0, 0.45, 1.0 };
+  const double shifts[] = { 0.0, -0.37, 0.23, 2.0, 0.11, 0.6 };
+  const TransformType *transforms[] = { identity, identity, identity, flip, flip, rotation };
+  for ( unsigned int test = 0; test < 12; ++test )
+    {
+    const unsigned int t = test % 6;
+    const bool         extrapolate = test >= 6;
+    const bool         useSubregion = ( test & 1 ) != 0;
+
+    typename TImage::Pointer expected =
+      Resample< TImage >(input, interpolator, transforms[t], scales[t], shifts[t], 3, extrapolate, false,
+                         useSubregion, 3);
+    typename TImage::Pointer output =
+      Resample< TImage >(input, interpolator, transforms[t], scales[t], shifts[t], 3, extrapolate, true,
+                         useSubregion, 3);
+
+    itk::ImageRegionConstIterator< TImage > it( output, output->GetRequestedRegion() );
+    itk::ImageRegionConstIterator< TImage > eit( expected, expected->GetRequestedRegion() );
+    for ( it.GoToBegin(), eit.GoToBegin(); !it.IsAtEnd(); ++it, ++eit )
+      {
+      if ( vcl_abs( static_cast< double >( it.Get() ) - static_cast< double >( eit.Get() ) ) > tolerance )
+        {
+        std::cerr << name << " (scale " << scales[t] << ", shift " << shifts[t] << ", transform " << t
+                  << ", extrapolate " << extrapolate << ", subregion " << useSubregion << "): pixel "
+                  << it.GetIndex() << " is " << static_cast< double >( it.Get() )
+                  << " with the separable interpolation instead of "
+                  << static_cast< double >( eit.Get() ) << std::endl;
+        return false;
+        }
+      }
+    }
+  return true;
+}
+
+template< class TImage >
+bool TestImage(const char *name, const typename TImage::SizeType & size, double tolerance)
+{
+  typename TImage::Pointer input = MakeImage< TImage >(size);
+
+  for ( unsigned int order = 0; order <= 5; ++order )
+    {
+    typedef itk::BSplineInterpolateImageFunction< TImage, double > BSplineType;
+    typename BSplineType::Pointer bspline = BSplineType::New();
+    bspline->SetSplineOrder(order);
+    if ( !Compare< TImage >(name, input, bspline, tolerance) )
+      {
+      std::cerr << "  with a B-spline of order " << order << std::endl;
+      return false;
+      }
+    }
+
+  typedef itk::WindowedSincInterpolateImageFunction< TImage, 3 > SincType;
+  typename SincType::Pointer sinc = SincType::New();
+  if ( !Compare< TImage >(name, input, sinc, tolerance) )
+    {
+    std::cerr << "  with a windowed sinc" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+template< class TImage >
+double Benchmark(const TImage *input, itk::InterpolateImageFunction< TImage, double > *interpolator,
+                 const itk::Transform< double, TImage::ImageDimension, TImage::ImageDimension > *transform,
+                 double scale, bool useSeparable)
+{
+  itk::TimeProbe probe;
+  probe.Start();
+  Resample< TImage >(input, interpolator, transform, scale, 0.3, 0, false, useSeparable, false, 1);
+  probe.Stop();
+  return probe.GetTotal();
+}
+}
+
+int itkResampleImageFilterSeparableTest(int argc, char *argv[])
+{
+  unsigned int edgeLength = 32;
+  if ( argc > 1 )
+    {
+    edgeLength = atoi(argv[1]);
+    }
+
+  typedef itk::Image< float, 3 > FloatImageType;
+  typedef itk::Image< short, 2 > ShortImageType;
+
+  FloatImageType::SizeType size3D;
+  size3D[0] = 13;
+  size3D[1] = 11;
+  size3D[2] = 9;
+  ShortImageType::SizeType size2D;
+  size2D[0] = 31;
+  size2D[1] = 26;
+
+  // rounding may change which side of an integer the short results fall
+  if ( !TestImage< FloatImageType >("float 3D", size3D, 1e-3)
+       || !TestImage< ShortImageType >("short 2D", size2D, 1.0) )
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Benchmark.
+  FloatImageType::SizeType size;
+  size.Fill(edgeLength);
+  FloatImageType::Pointer input = MakeImage< FloatImageType >(size);
+
+  typedef itk::AffineTransform< double, 3 > TransformType;
+  TransformType::Pointer identity = TransformType::New();
+
+  typedef itk::BSplineInterpolateImageFunction< FloatImageType, double > BSplineType;
+  BSplineType::Pointer bspline = BSplineType::New();
+  typedef itk::WindowedSincInterpolateImageFunction< FloatImageType, 3 > SincType;
+  SincType::Pointer sinc = SincType::New();
+
+  std::cout << "Resampling a " << edgeLength << "^3 float volume, s:" << std::endl;
+  std::cout << "  interpolator   scale  interpolator   separable" << std::endl;
+  const double scales[] = { 2.0, 1.0, 0.8 };
+  for ( unsigned int s = 0; s < 3; ++s )
+    {
+    std::cout << "  cubic B-spline" << std::setw(8) << scales[s]
+              << std::setw(14) << Benchmark< FloatImageType >(input, bspline, identity, scales[s], false)
+              << std::setw(12) << Benchmark< FloatImageType >(input, bspline, identity, scales[s], true)
+              << std::endl;
+    }
+  for ( unsigned int s = 0; s < 3; ++s )
+    {
+    std::cout << "  windowed sinc " << std::setw(8) << scales[s]
+              << std::setw(14) << Benchmark< FloatImageType >(input, sinc, identity, scales[s], false)
+              << std::setw(12) << Benchmark< FloatImageType >(input, sinc, identity, scales[s], true)
+              << std::endl;
+    }
+
+  return EXIT_SUCCESS;
+}
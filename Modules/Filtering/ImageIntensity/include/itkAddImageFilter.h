@@ -54,6 +54,19 @@ public:
     return static_cast< TOutput >( sum + B );
   }
 };
+
+#ifdef ITK_USE_SSE2_FUNCTOR_BATCH
+// float and unsigned short images are processed with SSE2 instructions
+template< >
+class BinaryBatch< Add2< float, float, float > >:
+  public SSE2BinaryBatch< Add2< float, float, float >, SSE2Add >
+{};
+
+template< >
+class BinaryBatch< Add2< unsigned short, unsigned short, unsigned short > >:
+  public SSE2BinaryBatch< Add2< unsigned short, unsigned short, unsigned short >, SSE2Add >
+{};
+#endif
 }
 /** \class AddImageFilter
  * \brief Pixel-wise addition of two images.
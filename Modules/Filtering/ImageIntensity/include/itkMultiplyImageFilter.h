@@ -48,6 +48,19 @@ public:
   inline TOutput operator()(const TInput1 & A, const TInput2 & B) const
   { return (TOutput)( A * B ); }
 };
+
+#ifdef ITK_USE_SSE2_FUNCTOR_BATCH
+// float and unsigned short images are processed with SSE2 instructions
+template< >
+class BinaryBatch< Mult< float, float, float > >:
+  public SSE2BinaryBatch< Mult< float, float, float >, SSE2Multiply >
+{};
+
+template< >
+class BinaryBatch< Mult< unsigned short, unsigned short, unsigned short > >:
+  public SSE2BinaryBatch< Mult< unsigned short, unsigned short, unsigned short >, SSE2Multiply >
+{};
+#endif
 }
 /** \class MultiplyImageFilter
  * \brief Pixel-wise multiplication of two images.
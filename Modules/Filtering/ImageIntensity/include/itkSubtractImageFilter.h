@@ -48,6 +48,19 @@ public:
   inline TOutput operator()(const TInput1 & A, const TInput2 & B) const
   { return (TOutput)( A - B ); }
 };
+
+#ifdef ITK_USE_SSE2_FUNCTOR_BATCH
+// float and unsigned short images are processed with SSE2 instructions
+template< >
+class BinaryBatch< Sub2< float, float, float > >:
+  public SSE2BinaryBatch< Sub2< float, float, float >, SSE2Subtract >
+{};
+
+template< >
+class BinaryBatch< Sub2< unsigned short, unsigned short, unsigned short > >:
+  public SSE2BinaryBatch< Sub2< unsigned short, unsigned short, unsigned short >, SSE2Subtract >
+{};
+#endif
 }
 /** \class SubtractImageFilter
  * \brief Pixel-wise subtraction of two images.
@@ -155,7 +155,7 @@ public:
   virtual void Initialize();
 
   /**  */
-  virtual void Allocate();
+  virtual void Allocate(bool initializePixels = false);
 
   virtual void Graft(const DataObject *data);
 
@@ -0,0 +1,253 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkMedianHistogram_h
+#define __itkMedianHistogram_h
+
+#include <vector>
+#include <algorithm>
+#include "itkIntTypes.h"
+#include "itkNumericTraits.h"
+
+namespace itk
+{
+namespace Function
+{
+/** \class MedianHistogram
+ * \brief Median of a sliding window of 8 or 16 bit integer values.
+ *
+ * Counts the values of the window in a histogram with one bin per
+ * possible value, and in a coarse histogram of blocks of bins, and
+ * tracks the median as pixels are added to and removed from the window
+ * (Huang, Yang and Tang, 1979). The median only moves by a few bins
+ * between neighboring pixels, and the coarse histogram lets it skip
+ * the empty parts of the histogram of 16 bit values.
+ *
+ * Pixels are added and removed with AddPixel() and RemovePixel(), in
+ * any order as long as a pixel is only removed while it is in the
+ * window, and GetValue() returns the value of rank windowSize / 2, like
+ * std::nth_element() on the window. MedianWindowTraits selects it for
+ * the pixel types it supports.
+ *
+ * \sa MedianImageFilter, MedianSortedWindow
+ * \ingroup ITKSmoothing
+ */
+template< class TInputPixel >
+class MedianHistogram
+{
+public:
+  MedianHistogram(SizeValueType windowSize)
+  {
+    m_Histogram.resize(NumberOfBins, 0);
+    m_BlockHistogram.resize(NumberOfBins >> BlockShift, 0);
+    m_Rank = windowSize / 2;
+    m_Median = 0;
+    m_LessThanMedian = 0;
+  }
+
+  inline void AddPixel(const TInputPixel & p)
+  {
+    const unsigned int bin = GetBin(p);
+    ++m_Histogram[bin];
+    ++m_BlockHistogram[bin >> BlockShift];
+    if ( bin < m_Median )
+      {
+      ++m_LessThanMedian;
+      }
+  }
+
+  inline void RemovePixel(const TInputPixel & p)
+  {
+    const unsigned int bin = GetBin(p);
+    --m_Histogram[bin];
+    --m_BlockHistogram[bin >> BlockShift];
+    if ( bin < m_Median )
+      {
+      --m_LessThanMedian;
+      }
+  }
+
+  inline TInputPixel GetValue()
+  {
+    // move the median down, one block at a time while possible
+    while ( m_LessThanMedian > m_Rank )
+      {
+      const unsigned int block = m_Median >> BlockShift;
+      if ( ( m_Median & BlockMask ) == 0
+           && m_LessThanMedian - m_BlockHistogram[block - 1] > m_Rank )
+        {
+        m_LessThanMedian -= m_BlockHistogram[block - 1];
+        m_Median -= BlockMask + 1;
+        }
+      else
+        {
+        --m_Median;
+        m_LessThanMedian -= m_Histogram[m_Median];
+        }
+      }
+    // or up
+    while ( m_LessThanMedian + m_Histogram[m_Median] <= m_Rank )
+      {
+      const unsigned int block = m_Median >> BlockShift;
+      if ( ( m_Median & BlockMask ) == 0
+           && m_LessThanMedian + m_BlockHistogram[block] <= m_Rank )
+        {
+        m_LessThanMedian += m_BlockHistogram[block];
+        m_Median += BlockMask + 1;
+        }
+      else
+        {
+        m_LessThanMedian += m_Histogram[m_Median];
+        ++m_Median;
+        }
+      }
+    return static_cast< TInputPixel >( static_cast< int >( m_Median )
+                                       + static_cast< int >( NumericTraits< TInputPixel >::NonpositiveMin() ) );
+  }
+
+private:
+  itkStaticConstMacro(NumberOfBits, unsigned int, 8 * sizeof( TInputPixel ));
+  itkStaticConstMacro(NumberOfBins, unsigned int, 1U << NumberOfBits);
+  itkStaticConstMacro(BlockShift, unsigned int, NumberOfBits / 2);
+  itkStaticConstMacro(BlockMask, unsigned int, ( 1U << BlockShift ) - 1);
+
+  static inline unsigned int GetBin(const TInputPixel & p)
+  {
+    return static_cast< unsigned int >( static_cast< int >( p )
+                                        - static_cast< int >( NumericTraits< TInputPixel >::NonpositiveMin() ) );
+  }
+
+  std::vector< SizeValueType > m_Histogram;
+  std::vector< SizeValueType > m_BlockHistogram;
+  SizeValueType                m_Rank;
+  // the bin of the median, and the number of pixels in the bins below it
+  unsigned int                 m_Median;
+  SizeValueType                m_LessThanMedian;
+};
+
+/** \class MedianSortedWindow
+ * \brief Median of a sliding window of values of any ordered type.
+ *
+ * Keeps the values of the window sorted. The pixels added and removed
+ * between two calls to GetValue() are sorted and merged with the
+ * window in a single pass, which only takes a time linear in the size
+ * of the window when few pixels change, instead of sorting or
+ * partitioning the whole window again.
+ *
+ * \sa MedianImageFilter, MedianHistogram
+ * \ingroup ITKSmoothing
+ */
+template< class TInputPixel >
+class MedianSortedWindow
+{
+public:
+  MedianSortedWindow(SizeValueType windowSize)
+  {
+    m_Window.reserve(windowSize);
+    m_Merged.reserve(windowSize);
+    m_Rank = windowSize / 2;
+  }
+
+  inline void AddPixel(const TInputPixel & p)
+  {
+    m_Added.push_back(p);
+  }
+
+  inline void RemovePixel(const TInputPixel & p)
+  {
+    m_Removed.push_back(p);
+  }
+
+  TInputPixel GetValue()
+  {
+    if ( !m_Added.empty() || !m_Removed.empty() )
+      {
+      std::sort( m_Added.begin(), m_Added.end() );
+      std::sort( m_Removed.begin(), m_Removed.end() );
+      m_Merged.clear();
+      typename PixelVectorType::iterator wit = m_Window.begin();
+      typename PixelVectorType::iterator ait = m_Added.begin();
+      typename PixelVectorType::iterator rit = m_Removed.begin();
+      while ( wit != m_Window.end() )
+        {
+        // drop the removed pixels; the sorted removed pixels are matched
+        // in the same order as they appear in the sorted window
+        if ( rit != m_Removed.end() && !( *rit < *wit ) && !( *wit < *rit ) )
+          {
+          ++rit;
+          ++wit;
+          continue;
+          }
+        while ( ait != m_Added.end() && *ait < *wit )
+          {
+          m_Merged.push_back(*ait);
+          ++ait;
+          }
+        m_Merged.push_back(*wit);
+        ++wit;
+        }
+      m_Merged.insert( m_Merged.end(), ait, m_Added.end() );
+
+      // values that are not ordered by operator<(), like NaN, may not be
+      // matched, and give an undefined median as with std::nth_element(),
+      // but the window must keep its size
+      m_Merged.resize( m_Merged.size() - ( m_Removed.end() - rit ) );
+      m_Window.swap(m_Merged);
+      m_Added.clear();
+      m_Removed.clear();
+      }
+    return m_Window[m_Rank];
+  }
+
+private:
+  typedef std::vector< TInputPixel > PixelVectorType;
+
+  PixelVectorType m_Window;
+  PixelVectorType m_Merged;
+  PixelVectorType m_Added;
+  PixelVectorType m_Removed;
+  SizeValueType   m_Rank;
+};
+
+/** \class MedianWindowTraits
+ * \brief Selects the sliding window used to compute a median of pixels
+ * of type TInputPixel: a MedianHistogram for 8 and 16 bit integers, and
+ * a MedianSortedWindow otherwise.
+ * \ingroup ITKSmoothing
+ */
+template< class TInputPixel >
+struct MedianWindowTraits {
+  typedef MedianSortedWindow< TInputPixel > WindowType;
+};
+
+#define itkMedianHistogramWindowTraitsMacro(T)       \
+  template< >                                        \
+  struct MedianWindowTraits< T > {                   \
+    typedef MedianHistogram< T > WindowType;         \
+  };
+
+itkMedianHistogramWindowTraitsMacro(char)
+itkMedianHistogramWindowTraitsMacro(signed char)
+itkMedianHistogramWindowTraitsMacro(unsigned char)
+itkMedianHistogramWindowTraitsMacro(short)
+itkMedianHistogramWindowTraitsMacro(unsigned short)
+
+#undef itkMedianHistogramWindowTraitsMacro
+} // end namespace Function
+} // end namespace itk
+
+#endif
@@ -35,6 +35,18 @@ namespace itk
  * This filter requires that the input pixel type provides an operator<()
  * (LessThan Comparable).
  *
+ * By default, the neighborhood slides along the lines of the image and
+ * only the pixels entering and leaving it are processed: the median of
+ * 8 and 16 bit integer images is tracked in a histogram of the
+ * neighborhood (see Function::MedianHistogram), and the neighborhood of
+ * other pixel types is kept sorted (see Function::MedianSortedWindow).
+ * UseSlidingWindowOff() copies and partially sorts the whole
+ * neighborhood of each pixel instead; both give the same results.
+ * Either way, pixels outside the image take the value of the nearest
+ * pixel inside, as with ZeroFluxNeumannBoundaryCondition, whereas
+ * MovingHistogramImageFilter leaves them out of the neighborhood.
+ *
+ * \sa MovingHistogramImageFilter
  * \sa Image
  * \sa Neighborhood
  * \sa NeighborhoodOperator
@@ -65,7 +77,7 @@ public:
 
   /** Standard class typedefs. */
   typedef MedianImageFilter                                     Self;
-  typedef ImageToImageFilter< InputImageType, OutputImageType > Superclass;
+  typedef BoxImageFilter< InputImageType, OutputImageType >     Superclass;
   typedef SmartPointer< Self >                                  Pointer;
   typedef SmartPointer< const Self >                            ConstPointer;
 
@@ -84,6 +96,13 @@ public:
 
   typedef typename InputImageType::SizeType InputSizeType;
 
+  /** Set/Get whether the neighborhood slides along the lines of the
+   * image, and is updated with the pixels entering and leaving it,
+   * instead of being read entirely for each pixel. Defaults to true. */
+  itkSetMacro(UseSlidingWindow, bool);
+  itkGetConstMacro(UseSlidingWindow, bool);
+  itkBooleanMacro(UseSlidingWindow);
+
 #ifdef ITK_USE_CONCEPT_CHECKING
   /** Begin concept checking */
   itkConceptMacro( SameDimensionCheck,
@@ -111,9 +130,19 @@ protected:
   void ThreadedGenerateData(const OutputImageRegionType & outputRegionForThread,
                             ThreadIdType threadId);
 
+  /** Computes the median of each pixel of outputRegionForThread with a
+   * TWindow sliding along the direction of the largest radius. */
+  template< class TWindow >
+  void ThreadedGenerateDataWithSlidingWindow(const OutputImageRegionType & outputRegionForThread,
+                                             ThreadIdType threadId);
+
+  void PrintSelf(std::ostream & os, Indent indent) const;
+
 private:
   MedianImageFilter(const Self &); //purposely not implemented
   void operator=(const Self &);    //purposely not implemented
+
+  bool m_UseSlidingWindow;
 };
 } // end namespace itk
 
@@ -22,6 +22,8 @@
 #include "itkConstNeighborhoodIterator.h"
 #include "itkNeighborhoodInnerProduct.h"
 #include "itkImageRegionIterator.h"
+#include "itkImageLinearIteratorWithIndex.h"
+#include "itkMedianHistogram.h"
 #include "itkNeighborhoodAlgorithm.h"
 #include "itkOffset.h"
 #include "itkProgressReporter.h"
@@ -34,7 +36,9 @@ namespace itk
 template< class TInputImage, class TOutputImage >
 MedianImageFilter< TInputImage, TOutputImage >
 ::MedianImageFilter()
-{}
+{
+  m_UseSlidingWindow = true;
+}
 
 template< class TInputImage, class TOutputImage >
 void
@@ -42,6 +46,13 @@ MedianImageFilter< TInputImage, TOutputImage >
 ::ThreadedGenerateData(const OutputImageRegionType & outputRegionForThread,
                        ThreadIdType threadId)
 {
+  if ( m_UseSlidingWindow )
+    {
+    typedef typename Function::MedianWindowTraits< InputPixelType >::WindowType WindowType;
+    this->template ThreadedGenerateDataWithSlidingWindow< WindowType >(outputRegionForThread, threadId);
+    return;
+    }
+
   // Allocate output
   typename OutputImageType::Pointer output = this->GetOutput();
   typename  InputImageType::ConstPointer input  = this->GetInput();
@@ -94,6 +105,145 @@ MedianImageFilter< TInputImage, TOutputImage >
       }
     }
 }
+
+template< class TInputImage, class TOutputImage >
+template< class TWindow >
+void
+MedianImageFilter< TInputImage, TOutputImage >
+::ThreadedGenerateDataWithSlidingWindow(const OutputImageRegionType & outputRegionForThread,
+                                        ThreadIdType threadId)
+{
+  typename OutputImageType::Pointer output = this->GetOutput();
+  typename InputImageType::ConstPointer input = this->GetInput();
+  const InputSizeType radius = this->GetRadius();
+
+  ProgressReporter progress( this, threadId, outputRegionForThread.GetNumberOfPixels() );
+
+  // Slide along the direction of the largest radius, where the fewest
+  // pixels enter and leave the neighborhood.
+  unsigned int direction = 0;
+  for ( unsigned int d = 1; d < InputImageDimension; ++d )
+    {
+    if ( radius[d] > radius[direction] )
+      {
+      direction = d;
+      }
+    }
+
+  // The pixels outside the buffer are replaced by the nearest pixel
+  // of the buffer, like the ZeroFluxNeumannBoundaryCondition does.
+  const InputImageRegionType bufferedRegion = input->GetBufferedRegion();
+  const OffsetValueType *    offsetTable = input->GetOffsetTable();
+  const InputPixelType *     buffer = input->GetBufferPointer();
+
+  // The offsets of the pixels of the slices of the neighborhood
+  // orthogonal to the direction, without the offset along the direction.
+  SizeValueType sliceSize = 1;
+  for ( unsigned int d = 0; d < InputImageDimension; ++d )
+    {
+    if ( d != direction )
+      {
+      sliceSize *= 2 * radius[d] + 1;
+      }
+    }
+  std::vector< OffsetValueType > slice(sliceSize);
+  const OffsetValueType          sliceRadius = static_cast< OffsetValueType >( radius[direction] );
+  const OffsetValueType          lowest = bufferedRegion.GetIndex(direction);
+  const OffsetValueType          highest = lowest + static_cast< OffsetValueType >( bufferedRegion.GetSize(direction) ) - 1;
+  const OffsetValueType          stride = offsetTable[direction];
+
+  TWindow window( sliceSize * ( 2 * radius[direction] + 1 ) );
+
+  ImageLinearIteratorWithIndex< OutputImageType > it(output, outputRegionForThread);
+  it.SetDirection(direction);
+  for ( it.GoToBegin(); !it.IsAtEnd(); it.NextLine() )
+    {
+    const typename OutputImageType::IndexType lineStart = it.GetIndex();
+
+    // build the offsets of the slice one direction at a time
+    slice[0] = 0;
+    SizeValueType filled = 1;
+    for ( unsigned int d = 0; d < InputImageDimension; ++d )
+      {
+      if ( d == direction )
+        {
+        continue;
+        }
+      const OffsetValueType low = bufferedRegion.GetIndex(d);
+      const OffsetValueType high = low + static_cast< OffsetValueType >( bufferedRegion.GetSize(d) ) - 1;
+      const OffsetValueType r = static_cast< OffsetValueType >( radius[d] );
+      // write the copy at -r, over the offsets found so far, last
+      for ( OffsetValueType k = r; k >= -r; --k )
+        {
+        const OffsetValueType offset =
+          ( std::min( std::max( lineStart[d] + k, low ), high ) - low ) * offsetTable[d];
+        OffsetValueType *copy = &slice[0] + ( k + r ) * filled;
+        for ( SizeValueType i = 0; i < filled; ++i )
+          {
+          copy[i] = slice[i] + offset;
+          }
+        }
+      filled *= 2 * r + 1;
+      }
+
+    // fill the neighborhood of the first pixel of the line
+    const OffsetValueType first = lineStart[direction];
+    for ( OffsetValueType k = first - sliceRadius; k <= first + sliceRadius; ++k )
+      {
+      const InputPixelType *s = buffer + ( std::min( std::max( k, lowest ), highest ) - lowest ) * stride;
+      for ( SizeValueType i = 0; i < sliceSize; ++i )
+        {
+        window.AddPixel(s[slice[i]]);
+        }
+      }
+
+    OffsetValueType position = first;
+    while ( true )
+      {
+      it.Set( static_cast< OutputPixelType >( window.GetValue() ) );
+      ++it;
+      if ( it.IsAtEndOfLine() )
+        {
+        break;
+        }
+      ++position;
+      // add the slice entering the neighborhood before removing the one
+      // leaving it, so that the window is never empty
+      const InputPixelType *added =
+        buffer + ( std::min( std::max( position + sliceRadius, lowest ), highest ) - lowest ) * stride;
+      const InputPixelType *removed =
+        buffer + ( std::min( std::max( position - sliceRadius - 1, lowest ), highest ) - lowest ) * stride;
+      for ( SizeValueType i = 0; i < sliceSize; ++i )
+        {
+        window.AddPixel(added[slice[i]]);
+        }
+      for ( SizeValueType i = 0; i < sliceSize; ++i )
+        {
+        window.RemovePixel(removed[slice[i]]);
+        }
+      }
+
+    // empty the window for the next line
+    for ( OffsetValueType k = position - sliceRadius; k <= position + sliceRadius; ++k )
+      {
+      const InputPixelType *s = buffer + ( std::min( std::max( k, lowest ), highest ) - lowest ) * stride;
+      for ( SizeValueType i = 0; i < sliceSize; ++i )
+        {
+        window.RemovePixel(s[slice[i]]);
+        }
+      }
+    progress.CompletedPixels( position - first + 1 );
+    }
+}
+
+template< class TInputImage, class TOutputImage >
+void
+MedianImageFilter< TInputImage, TOutputImage >
+::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+  os << indent << "UseSlidingWindow: " << m_UseSlidingWindow << std::endl;
+}
 } // end namespace itk
 
 #endif
@@ -0,0 +1,230 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkMedianImageFilter.h"
+#include "itkImageRegionIterator.h"
+#include "itkTimeProbe.h"
+#include <iomanip>
+
+// Filters images of 8 and 16 bit integers, which use a histogram, and
+// of floats and 32 bit integers, which use a sorted window, with
+// isotropic and anisotropic radii, with several threads, over the whole
+// image and over a smaller requested region, and checks that sliding
+// the neighborhood gives the same results as reading the whole
+// neighborhood of each pixel. It then reports the time taken by both methods to
+// filter 8 and 16 bit volumes with radii from 1 to 7, in one thread.
+// Pass a larger edge length, e.g. 128, to use it as a benchmark.
+
+namespace
+{
+unsigned int NextRandom(unsigned int & random)
+{
+  random = random * 1103515245 + 12345;
+  return random >> 8;
+}
+
+template< class TPixel >
+void SetRandom(TPixel & pixel, unsigned int & random, int minimum, int maximum)
+{
+  pixel = static_cast< TPixel >( minimum + static_cast< int >( NextRandom(random) % ( maximum - minimum + 1 ) ) );
+}
+
+template< class TImage >
+typename TImage::Pointer MakeImage(const typename TImage::SizeType & size, int minimum, int maximum)
+{
+  typename TImage::Pointer image = TImage::New();
+  typename TImage::IndexType index;
+  index.Fill(-3);
+  typename TImage::RegionType region(index, size);
+  image->SetRegions(region);
+  image->Allocate();
+  unsigned int random = 1;
+  itk::ImageRegionIterator< TImage > it(image, region);
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    SetRandom(it.Value(), random, minimum, maximum);
+    }
+  return image;
+}
+
+template< class TImage >
+typename TImage::Pointer Filter(TImage *input, const typename TImage::SizeType & radius,
+                                bool useSlidingWindow, const typename TImage::RegionType & region,
+                                unsigned int numberOfThreads)
+{
+  typedef itk::MedianImageFilter< TImage, TImage > FilterType;
+  typename FilterType::Pointer filter = FilterType::New();
+  filter->SetInput(input);
+  filter->SetRadius(radius);
+  filter->SetUseSlidingWindow(useSlidingWindow);
+  filter->SetNumberOfThreads(numberOfThreads);
+  filter->GetOutput()->SetRequestedRegion(region);
+  filter->Update();
+  return filter->GetOutput();
+}
+
+template< class TImage >
+bool SameImages(const char *name, const TImage *image1, const TImage *image2,
+                const typename TImage::RegionType & region, const typename TImage::SizeType & radius)
+{
+  itk::ImageRegionConstIterator< TImage > it1(image1, region);
+  itk::ImageRegionConstIterator< TImage > it2(image2, region);
+  for ( it1.GoToBegin(), it2.GoToBegin(); !it1.IsAtEnd(); ++it1, ++it2 )
+    {
+    if ( it1.Get() != it2.Get() )
+      {
+      std::cerr << name << ", radius " << radius << ": pixel " << it1.GetIndex() << " is "
+                << static_cast< typename itk::NumericTraits< typename TImage::PixelType >::PrintType >( it1.Get() )
+                << " with a sliding window instead of "
+                << static_cast< typename itk::NumericTraits< typename TImage::PixelType >::PrintType >( it2.Get() )
+                << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+// Checks several radii over the whole image and over a smaller region.
+template< class TImage >
+bool TestImage(const char *name, int minimum, int maximum)
+{
+  const unsigned int Dimension = TImage::ImageDimension;
+  typename TImage::SizeType size;
+  typename TImage::RegionType region;
+  for ( unsigned int d = 0; d < Dimension; ++d )
+    {
+    size[d] = 17 + 2 * d;
+    region.SetIndex(d, 1);
+    region.SetSize(d, 9 + d);
+    }
+  typename TImage::Pointer input = MakeImage< TImage >(size, minimum, maximum);
+  const typename TImage::RegionType wholeRegion = input->GetLargestPossibleRegion();
+
+  for ( unsigned int test = 0; test < 5; ++test )
+    {
+    typename TImage::SizeType radius;
+    for ( unsigned int d = 0; d < Dimension; ++d )
+      {
+      switch ( test )
+        {
+        case 0:
+          radius[d] = 1;
+          break;
+        case 1:
+          radius[d] = 3;
+          break;
+        case 2:
+          // slides along the last direction
+          radius[d] = d;
+          break;
+        case 3:
+          // as wide as the image
+          radius[d] = 8;
+          break;
+        default:
+          radius[d] = d == 0 ? 2 : 0;
+          break;
+        }
+      }
+    if ( !SameImages( name,
+                      Filter< TImage >(input, radius, true, wholeRegion, 3).GetPointer(),
+                      Filter< TImage >(input, radius, false, wholeRegion, 3).GetPointer(),
+                      wholeRegion, radius )
+         || !SameImages( name,
+                         Filter< TImage >(input, radius, true, region, 2).GetPointer(),
+                         Filter< TImage >(input, radius, false, region, 2).GetPointer(),
+                         region, radius ) )
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+// Reports the time taken to filter a volume with radii from 1 to 7.
+template< class TImage >
+bool Benchmark(const char *name, unsigned int edgeLength, int maximum)
+{
+  typename TImage::SizeType size;
+  size.Fill(edgeLength);
+  typename TImage::Pointer input = MakeImage< TImage >(size, 0, maximum);
+  const typename TImage::RegionType region = input->GetLargestPossibleRegion();
+
+  std::cout << "Filtering a " << edgeLength << "^3 " << name << " volume, s:" << std::endl;
+  std::cout << "  radius  neighborhood  sliding window" << std::endl;
+  for ( unsigned int r = 1; r <= 7; ++r )
+    {
+    typename TImage::SizeType radius;
+    radius.Fill(r);
+
+    itk::TimeProbe neighborhoodProbe;
+    neighborhoodProbe.Start();
+    typename TImage::Pointer expected = Filter< TImage >(input, radius, false, region, 1);
+    neighborhoodProbe.Stop();
+
+    itk::TimeProbe windowProbe;
+    windowProbe.Start();
+    typename TImage::Pointer output = Filter< TImage >(input, radius, true, region, 1);
+    windowProbe.Stop();
+
+    if ( !SameImages(name, output.GetPointer(), expected.GetPointer(), region, radius) )
+      {
+      return false;
+      }
+    std::cout << "  " << r << std::setw(18) << neighborhoodProbe.GetTotal()
+              << std::setw(16) << windowProbe.GetTotal() << std::endl;
+    }
+  return true;
+}
+}
+
+int itkMedianImageFilterSlidingWindowTest(int argc, char *argv[])
+{
+  unsigned int edgeLength = 16;
+  if ( argc > 1 )
+    {
+    edgeLength = atoi(argv[1]);
+    }
+
+  typedef itk::Image< unsigned char, 3 >  UCharImageType;
+  typedef itk::Image< unsigned short, 3 > UShortImageType;
+  typedef itk::Image< short, 2 >          ShortImageType;
+  typedef itk::Image< signed char, 2 >    SCharImageType;
+  typedef itk::Image< float, 3 >          FloatImageType;
+  typedef itk::Image< int, 2 >            IntImageType;
+
+  if ( !TestImage< UCharImageType >("unsigned char", 0, 255)
+       || !TestImage< UCharImageType >("unsigned char, few values", 100, 103)
+       || !TestImage< UShortImageType >("unsigned short", 0, 65535)
+       || !TestImage< UShortImageType >("unsigned short, sparse values", 1000, 1200)
+       || !TestImage< ShortImageType >("short", -32768, 32767)
+       || !TestImage< SCharImageType >("signed char", -128, 127)
+       || !TestImage< FloatImageType >("float", -1000, 1000)
+       || !TestImage< IntImageType >("int, few values", -2, 2) )
+    {
+    return EXIT_FAILURE;
+    }
+
+  if ( !Benchmark< UCharImageType >("unsigned char", edgeLength, 255)
+       || !Benchmark< UShortImageType >("unsigned short", edgeLength, 4095) )
+    {
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,203 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkRecursiveGaussianImageFilter.h"
+#include "itkImageRegionIterator.h"
+#include "itkTimeProbe.h"
+#include "itkVector.h"
+
+// Filters float and vector images along each direction with the
+// Gaussian and its derivatives, in blocks of lines and one line at a
+// time, with several threads, over the whole image and over a region
+// whose width is not a multiple of the block size, and in place, and
+// checks that the results are the same. It then reports the time taken
+// to smooth a float volume along each axis both ways, in one thread.
+// Pass a larger edge length, e.g. 512, to use it as a benchmark.
+
+namespace
+{
+float NextRandom(unsigned int & random)
+{
+  random = random * 1103515245 + 12345;
+  return static_cast< float >( ( random >> 8 ) % 1000 );
+}
+
+void SetRandom(float & pixel, unsigned int & random)
+{
+  pixel = NextRandom(random);
+}
+
+void SetRandom(itk::Vector< float, 2 > & pixel, unsigned int & random)
+{
+  pixel[0] = NextRandom(random);
+  pixel[1] = NextRandom(random);
+}
+
+template< class TImage >
+typename TImage::Pointer MakeImage(const typename TImage::RegionType & region)
+{
+  typename TImage::Pointer image = TImage::New();
+  image->SetRegions(region);
+  image->Allocate();
+  unsigned int random = 1;
+  itk::ImageRegionIterator< TImage > it(image, region);
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    SetRandom(it.Value(), random);
+    }
+  return image;
+}
+
+template< class TImage >
+bool SameImages(const char *name, const TImage *image1, const TImage *image2,
+                const typename TImage::RegionType & region)
+{
+  itk::ImageRegionConstIterator< TImage > it1(image1, region);
+  itk::ImageRegionConstIterator< TImage > it2(image2, region);
+  for ( it1.GoToBegin(), it2.GoToBegin(); !it1.IsAtEnd(); ++it1, ++it2 )
+    {
+    if ( it1.Get() != it2.Get() )
+      {
+      std::cerr << name << ": pixel " << it1.GetIndex() << " is " << it1.Get()
+                << " in blocks of lines instead of " << it2.Get() << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+template< class TImage >
+typename TImage::Pointer Filter(TImage *input, unsigned int direction, unsigned int order,
+                                bool useLineBlocks, const typename TImage::RegionType & region,
+                                bool inPlace, unsigned int numberOfThreads)
+{
+  typedef itk::RecursiveGaussianImageFilter< TImage, TImage > FilterType;
+  typename FilterType::Pointer filter = FilterType::New();
+  filter->SetInput(input);
+  filter->SetDirection(direction);
+  filter->SetSigma(2.0);
+  filter->SetOrder( static_cast< typename FilterType::OrderEnumType >( order ) );
+  filter->SetUseLineBlocks(useLineBlocks);
+  filter->SetInPlace(inPlace);
+  filter->SetNumberOfThreads(numberOfThreads);
+  filter->GetOutput()->SetRequestedRegion(region);
+  filter->Update();
+  return filter->GetOutput();
+}
+
+// Checks every direction and order over the whole image, over region,
+// and in place.
+template< class TImage >
+bool TestImage(const char *name, const typename TImage::RegionType & wholeRegion,
+               const typename TImage::RegionType & region)
+{
+  for ( unsigned int direction = 0; direction < TImage::ImageDimension; ++direction )
+    {
+    for ( unsigned int order = 0; order < 3; ++order )
+      {
+      typename TImage::Pointer input = MakeImage< TImage >(wholeRegion);
+      if ( !SameImages( name,
+                        Filter< TImage >(input, direction, order, true, wholeRegion, false, 3).GetPointer(),
+                        Filter< TImage >(input, direction, order, false, wholeRegion, false, 3).GetPointer(),
+                        wholeRegion )
+           || !SameImages( name,
+                           Filter< TImage >(input, direction, order, true, region, false, 3).GetPointer(),
+                           Filter< TImage >(input, direction, order, false, region, false, 3).GetPointer(),
+                           region ) )
+        {
+        std::cerr << "  filtering along direction " << direction << " with order " << order << std::endl;
+        return false;
+        }
+
+      typename TImage::Pointer expected = Filter< TImage >(input, direction, order, false, wholeRegion, false, 3);
+      typename TImage::Pointer output = Filter< TImage >(input, direction, order, true, wholeRegion, true, 3);
+      if ( !SameImages(name, output.GetPointer(), expected.GetPointer(), wholeRegion) )
+        {
+        std::cerr << "  filtering in place along direction " << direction << " with order " << order << std::endl;
+        return false;
+        }
+      }
+    }
+  return true;
+}
+}
+
+int itkRecursiveGaussianImageFilterLineBlocksTest(int argc, char *argv[])
+{
+  unsigned int edgeLength = 48;
+  if ( argc > 1 )
+    {
+    edgeLength = atoi(argv[1]);
+    }
+
+  typedef itk::Image< float, 3 >                      FloatImageType;
+  typedef itk::Image< itk::Vector< float, 2 >, 2 >    VectorImageType;
+
+  FloatImageType::RegionType wholeRegion;
+  FloatImageType::RegionType region;
+  for ( unsigned int d = 0; d < 3; ++d )
+    {
+    wholeRegion.SetSize(d, 19 + d);
+    region.SetIndex(d, 2);
+    region.SetSize(d, 13 + d);
+    }
+  VectorImageType::RegionType wholeVectorRegion;
+  VectorImageType::RegionType vectorRegion;
+  for ( unsigned int d = 0; d < 2; ++d )
+    {
+    wholeVectorRegion.SetSize(d, 37 - d);
+    vectorRegion.SetIndex(d, 1 + d);
+    vectorRegion.SetSize(d, 30 - d);
+    }
+
+  if ( !TestImage< FloatImageType >("float", wholeRegion, region)
+       || !TestImage< VectorImageType >("vector", wholeVectorRegion, vectorRegion) )
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Benchmark.
+  FloatImageType::SizeType size;
+  size.Fill(edgeLength);
+  wholeRegion.SetSize(size);
+  FloatImageType::Pointer input = MakeImage< FloatImageType >(wholeRegion);
+
+  std::cout << "Smoothing a " << edgeLength << "^3 float volume, s:" << std::endl;
+  std::cout << "  direction     lines    blocks" << std::endl;
+  for ( unsigned int direction = 0; direction < 3; ++direction )
+    {
+    itk::TimeProbe linesProbe;
+    linesProbe.Start();
+    FloatImageType::Pointer expected = Filter< FloatImageType >(input, direction, 0, false, wholeRegion, false, 1);
+    linesProbe.Stop();
+
+    itk::TimeProbe blocksProbe;
+    blocksProbe.Start();
+    FloatImageType::Pointer output = Filter< FloatImageType >(input, direction, 0, true, wholeRegion, false, 1);
+    blocksProbe.Stop();
+
+    if ( !SameImages("float", output.GetPointer(), expected.GetPointer(), wholeRegion) )
+      {
+      return EXIT_FAILURE;
+      }
+    std::cout << "  " << direction << "       " << linesProbe.GetTotal()
+              << "    " << blocksProbe.GetTotal() << std::endl;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -85,6 +85,15 @@ public:
   void SetOutsideValue(const TOutput & value)
   { m_OutsideValue = value; }
 
+  const TInput & GetLowerThreshold() const
+  { return m_LowerThreshold; }
+  const TInput & GetUpperThreshold() const
+  { return m_UpperThreshold; }
+  const TOutput & GetInsideValue() const
+  { return m_InsideValue; }
+  const TOutput & GetOutsideValue() const
+  { return m_OutsideValue; }
+
   bool operator!=(const BinaryThreshold & other) const
   {
     if ( m_LowerThreshold != other.m_LowerThreshold
@@ -117,6 +126,85 @@ private:
   TOutput m_InsideValue;
   TOutput m_OutsideValue;
 };
+
+#ifdef ITK_USE_SSE2_FUNCTOR_BATCH
+// float and unsigned short images are thresholded into unsigned char
+// images with SSE2 instructions
+template< >
+class UnaryBatch< BinaryThreshold< float, unsigned char > >:
+  public ScalarUnaryBatch< BinaryThreshold< float, unsigned char > >
+{
+public:
+  using ScalarUnaryBatch< BinaryThreshold< float, unsigned char > >::Evaluate;
+
+  static void Evaluate(const BinaryThreshold< float, unsigned char > & functor, const float *input,
+                       unsigned char *output, SizeValueType length)
+  {
+    const __m128  lower = _mm_set1_ps( functor.GetLowerThreshold() );
+    const __m128  upper = _mm_set1_ps( functor.GetUpperThreshold() );
+    const __m128i inside = _mm_set1_epi8( static_cast< char >( functor.GetInsideValue() ) );
+    const __m128i outside = _mm_set1_epi8( static_cast< char >( functor.GetOutsideValue() ) );
+    SizeValueType i = 0;
+    for ( ; i + 16 <= length; i += 16 )
+      {
+      __m128i masks[4];
+      for ( unsigned int j = 0; j < 4; ++j )
+        {
+        const __m128 x = _mm_loadu_ps(input + i + 4 * j);
+        masks[j] = _mm_castps_si128( _mm_and_ps( _mm_cmple_ps(lower, x), _mm_cmple_ps(x, upper) ) );
+        }
+      // the masks of all ones or zeros saturate to bytes of all ones or zeros
+      const __m128i mask = _mm_packs_epi16( _mm_packs_epi32(masks[0], masks[1]),
+                                            _mm_packs_epi32(masks[2], masks[3]) );
+      _mm_storeu_si128( reinterpret_cast< __m128i * >( output + i ),
+                        _mm_or_si128( _mm_and_si128(mask, inside), _mm_andnot_si128(mask, outside) ) );
+      }
+    for ( ; i < length; ++i )
+      {
+      output[i] = functor(input[i]);
+      }
+  }
+};
+
+template< >
+class UnaryBatch< BinaryThreshold< unsigned short, unsigned char > >:
+  public ScalarUnaryBatch< BinaryThreshold< unsigned short, unsigned char > >
+{
+public:
+  using ScalarUnaryBatch< BinaryThreshold< unsigned short, unsigned char > >::Evaluate;
+
+  static void Evaluate(const BinaryThreshold< unsigned short, unsigned char > & functor,
+                       const unsigned short *input, unsigned char *output, SizeValueType length)
+  {
+    // SSE2 only compares signed integers, so the values are shifted
+    // into the range of short
+    const __m128i bias = _mm_set1_epi16(-32768);
+    const __m128i lower = _mm_xor_si128( _mm_set1_epi16( static_cast< short >( functor.GetLowerThreshold() ) ), bias );
+    const __m128i upper = _mm_xor_si128( _mm_set1_epi16( static_cast< short >( functor.GetUpperThreshold() ) ), bias );
+    const __m128i inside = _mm_set1_epi8( static_cast< char >( functor.GetInsideValue() ) );
+    const __m128i outside = _mm_set1_epi8( static_cast< char >( functor.GetOutsideValue() ) );
+    SizeValueType i = 0;
+    for ( ; i + 16 <= length; i += 16 )
+      {
+      __m128i masks[2];
+      for ( unsigned int j = 0; j < 2; ++j )
+        {
+        const __m128i x = _mm_xor_si128( _mm_loadu_si128( reinterpret_cast< const __m128i * >( input + i + 8 * j ) ),
+                                         bias );
+        // outside where lower > x or x > upper
+        masks[j] = _mm_or_si128( _mm_cmpgt_epi16(lower, x), _mm_cmpgt_epi16(x, upper) );
+        }
+      const __m128i mask = _mm_packs_epi16(masks[0], masks[1]);
+      _mm_storeu_si128( reinterpret_cast< __m128i * >( output + i ),
+                        _mm_or_si128( _mm_andnot_si128(mask, inside), _mm_and_si128(mask, outside) ) );
+      }
+    for ( ; i < length; ++i )
+      {
+      output[i] = functor(input[i]);
+      }
+  }
+};
+#endif
 }
 
 template< class TInputImage, class TOutputImage >
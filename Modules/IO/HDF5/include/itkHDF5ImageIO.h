@@ -79,6 +79,17 @@ class MetaDataDictionary;
  *                             in the MetaDataDictionary
  * re-arrangement.
  *
+ * The voxel data is stored in chunks, blocks of ChunkSize voxels that
+ * HDF5 reads, writes and compresses as units, so that reading a region
+ * only reads and decompresses the chunks intersecting it.  By default
+ * the chunks hold about 1 MB, with the same length along every
+ * dimension.  Each chunk is compressed with deflate at CompressionLevel,
+ * after its bytes are shuffled to group those of the same significance,
+ * unless UseShuffleFilter is off.  UseCompression is ignored: set
+ * CompressionLevel to 0 to store the data uncompressed.
+ * ChunkCacheSize sets the size of the cache HDF5 keeps decompressed
+ * chunks in, so that regions read one after the other which share
+ * chunks do not decompress them again.
  *
  */
 
@@ -129,6 +140,40 @@ public:
    * that the IORegions has been set properly. */
   virtual void Write(const void *buffer);
 
+  /** Set/Get the number of voxels along each dimension of the chunks
+   * written, fastest moving dimension first.  Missing or zero lengths
+   * take the default, and lengths larger than the image are reduced to
+   * it.  The components of a voxel are never split. */
+  void SetChunkSize(const std::vector< SizeValueType > & chunkSize)
+  {
+    if ( chunkSize != m_ChunkSize )
+      {
+      m_ChunkSize = chunkSize;
+      this->Modified();
+      }
+  }
+  const std::vector< SizeValueType > & GetChunkSize() const
+  {
+    return m_ChunkSize;
+  }
+
+  /** Set/Get the deflate level of the chunks, from 1 to 9, or 0 to leave
+   * them uncompressed.  Defaults to 5. */
+  itkSetClampMacro(CompressionLevel, int, 0, 9);
+  itkGetConstMacro(CompressionLevel, int);
+
+  /** Set/Get whether compressed chunks are shuffled first, which helps
+   * to compress multi-byte components.  Defaults to on. */
+  itkSetMacro(UseShuffleFilter, bool);
+  itkGetConstMacro(UseShuffleFilter, bool);
+  itkBooleanMacro(UseShuffleFilter);
+
+  /** Set/Get the size in bytes of the cache of decompressed chunks of
+   * the voxel data, used for reading and writing.  0, the default,
+   * leaves the HDF5 default of 1 MB. */
+  itkSetMacro(ChunkCacheSize, SizeValueType);
+  itkGetConstMacro(ChunkCacheSize, SizeValueType);
+
 protected:
   HDF5ImageIO();
   ~HDF5ImageIO();
@@ -186,9 +231,21 @@ private:
                        unsigned long numElements);
   void SetupStreaming(H5::DataSpace *imageSpace,
                       H5::DataSpace *slabSpace);
+
+  /** Open m_VoxelDataSet, with the chunk cache size set. */
+  void OpenVoxelDataSet();
+
+  /** Close m_VoxelDataSet and m_H5File, if open. */
+  void CloseH5File();
+
   H5::H5File  *m_H5File;
   H5::DataSet *m_VoxelDataSet;
   bool         m_ImageInformationWritten;
+
+  std::vector< SizeValueType > m_ChunkSize;
+  int                          m_CompressionLevel;
+  bool                         m_UseShuffleFilter;
+  SizeValueType                m_ChunkCacheSize;
 };
 } // end namespace itk
 
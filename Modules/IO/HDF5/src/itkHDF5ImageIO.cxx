@@ -27,8 +27,10 @@
 #include "itk_H5Cpp.h"
 #include "itk_hdf5.h"
 #include <typeinfo>
+#include <algorithm>
 #include <stdio.h>
 #include <stdlib.h>
+#include <math.h>
 #include <vector>
 
 namespace itk
@@ -36,21 +38,33 @@ namespace itk
 
 HDF5ImageIO::HDF5ImageIO() : m_H5File(0),
                              m_VoxelDataSet(0),
-                             m_ImageInformationWritten(false)
+                             m_ImageInformationWritten(false),
+                             m_CompressionLevel(5),
+                             m_UseShuffleFilter(true),
+                             m_ChunkCacheSize(0)
 {
 }
 
 HDF5ImageIO::~HDF5ImageIO()
+{
+  this->CloseH5File();
+}
+
+void
+HDF5ImageIO
+::CloseH5File()
 {
   if(this->m_VoxelDataSet != 0)
     {
     m_VoxelDataSet->close();
     delete m_VoxelDataSet;
+    this->m_VoxelDataSet = 0;
     }
   if(this->m_H5File != 0)
     {
     this->m_H5File->close();
     delete this->m_H5File;
+    this->m_H5File = 0;
     }
 }
 
@@ -61,6 +75,15 @@ HDF5ImageIO
   Superclass::PrintSelf(os, indent);
   // just prints out the pointer value.
   os << indent << "H5File: " << this->m_H5File << std::endl;
+  os << indent << "ChunkSize: [";
+  for(unsigned i = 0; i < this->m_ChunkSize.size(); i++)
+    {
+    os << (i == 0 ? "" : ", ") << this->m_ChunkSize[i];
+    }
+  os << "]" << std::endl;
+  os << indent << "CompressionLevel: " << this->m_CompressionLevel << std::endl;
+  os << indent << "UseShuffleFilter: " << this->m_UseShuffleFilter << std::endl;
+  os << indent << "ChunkCacheSize: " << this->m_ChunkCacheSize << std::endl;
 }
 
 //
@@ -78,6 +101,41 @@ const std::string VoxelType("/VoxelType");
 const std::string VoxelData("/VoxelData");
 const std::string MetaDataName("/MetaData");
 
+// size of the chunks written when ChunkSize does not say otherwise.
+const double DefaultChunkBytes(1024.0 * 1024.0);
+
+// smallest prime not less than n, the number of slots of the chunk
+// cache hash table being best a prime.
+size_t NextPrime(size_t n)
+{
+  for(;; n++)
+    {
+    size_t d = 2;
+    while(d * d <= n && n % d != 0)
+      {
+      d++;
+      }
+    if(n > 1 && d * d > n)
+      {
+      return n;
+      }
+    }
+}
+
+// Dataset access property list setting the size of the chunk cache to
+// cacheBytes, for chunks of chunkBytes bytes.  The caller closes it.
+hid_t CreateChunkCacheAccessPropertyList(size_t cacheBytes,size_t chunkBytes)
+{
+  // the HDF5 documentation advises about 100 times as many slots as
+  // chunks fitting in the cache, to avoid collisions.
+  const size_t chunksInCache = cacheBytes / (chunkBytes > 0 ? chunkBytes : 1);
+  const size_t nslots = NextPrime(std::max< size_t >(521,100 * chunksInCache));
+  hid_t dapl = H5Pcreate(H5P_DATASET_ACCESS);
+  // chunks read in full are evicted first
+  H5Pset_chunk_cache(dapl,nslots,cacheBytes,0.75);
+  return dapl;
+}
+
 template <typename TScalar>
 H5::PredType GetType()
 {
@@ -646,6 +704,8 @@ HDF5ImageIO
 {
   try
     {
+    // the file may have been opened by an earlier call
+    this->CloseH5File();
     this->m_H5File = new H5::H5File(this->GetFileName(),
                                     H5F_ACC_RDONLY);
     std::string fileVersion =
@@ -919,6 +979,52 @@ HDF5ImageIO
   delete [] offset;
 }
 
+void
+HDF5ImageIO
+::OpenVoxelDataSet()
+{
+  std::string VoxelDataName(ImageGroup);
+  VoxelDataName += "/0";
+  VoxelDataName += VoxelData;
+  this->m_VoxelDataSet = new H5::DataSet();
+  *(this->m_VoxelDataSet) = this->m_H5File->openDataSet(VoxelDataName);
+
+  H5::DSetCreatPropList plist = this->m_VoxelDataSet->getCreatePlist();
+  if(this->m_ChunkCacheSize == 0 || plist.getLayout() != H5D_CHUNKED)
+    {
+    return;
+    }
+  //
+  // the cache size can only be given when opening the data set, so it
+  // is opened again, knowing the size of its chunks.  It has to be
+  // closed first, as all the identifiers of an open data set share the
+  // cache it was opened with.
+  const int numDims = this->m_VoxelDataSet->getSpace().getSimpleExtentNdims();
+  std::vector<hsize_t> chunkDims(numDims);
+  plist.getChunk(numDims,&chunkDims[0]);
+  size_t chunkBytes = this->m_VoxelDataSet->getDataType().getSize();
+  for(int i = 0; i < numDims; i++)
+    {
+    chunkBytes *= chunkDims[i];
+    }
+  this->m_VoxelDataSet->close();
+  delete this->m_VoxelDataSet;
+  this->m_VoxelDataSet = 0;
+
+  hid_t dapl = CreateChunkCacheAccessPropertyList(this->m_ChunkCacheSize,
+                                                  chunkBytes);
+  hid_t dataSetId = H5Dopen2(this->m_H5File->getId(),
+                             VoxelDataName.c_str(),dapl);
+  H5Pclose(dapl);
+  if(dataSetId < 0)
+    {
+    itkExceptionMacro(<< "Can't open " << VoxelDataName
+                      << " in " << this->GetFileName());
+    }
+  // the DataSet takes over the identifier
+  this->m_VoxelDataSet = new H5::DataSet(dataSetId);
+}
+
 void
 HDF5ImageIO
 ::Read(void *buffer)
@@ -934,8 +1040,7 @@ HDF5ImageIO
   VoxelDataName += VoxelData;
   if(this->m_VoxelDataSet == 0)
     {
-    this->m_VoxelDataSet = new H5::DataSet();
-    *(this->m_VoxelDataSet) = this->m_H5File->openDataSet(VoxelDataName);
+    this->OpenVoxelDataSet();
     }
   H5::DataType voxelType = this->m_VoxelDataSet->getDataType();
   H5::DataSpace imageSpace = this->m_VoxelDataSet->getSpace();
@@ -1226,21 +1331,76 @@ HDF5ImageIO
     VoxelDataName += "/0";
     VoxelDataName += VoxelData;
     // set up properties for chunked, compressed writes.
-    // in this case, set the chunk size to be the N-1 dimension
-    // region
+    // chunk lengths not given are such that the chunks hold about
+    // DefaultChunkBytes, with equal lengths along all dimensions, and
+    // the components of a voxel are kept in the same chunk.
+    const int imageDims = this->GetNumberOfDimensions();
+    const double pixelBytes =
+      static_cast<double>(this->GetComponentSize()) * numComponents;
+    const double defaultLength =
+      floor(pow(DefaultChunkBytes / pixelBytes,1.0 / imageDims) + 0.5);
+    std::vector<hsize_t> chunkDims(numDims,numComponents);
+    for(int i(0), j(imageDims-1); i < imageDims; i++, j--)
+      {
+      double length = defaultLength;
+      if(i < static_cast<int>(this->m_ChunkSize.size()) &&
+         this->m_ChunkSize[i] > 0)
+        {
+        length = this->m_ChunkSize[i];
+        }
+      chunkDims[j] = static_cast<hsize_t>(
+        std::max(1.0,std::min(length,static_cast<double>(dims[j]))));
+      }
     H5::DSetCreatPropList plist;
-    plist.setDeflate(5);
-    dims[0] = 1;
-    plist.setChunk(numDims,dims);
+    plist.setChunk(numDims,&chunkDims[0]);
+    // voxel data is compressed at CompressionLevel, whatever
+    // UseCompression says
+    if(this->m_CompressionLevel > 0)
+      {
+      // the shuffle filter has to come before deflate
+      if(this->m_UseShuffleFilter)
+        {
+        plist.setShuffle();
+        }
+      plist.setDeflate(this->m_CompressionLevel);
+      }
 
     //
     // Create DataSet Once, potentially write to it many times
     if(this->m_VoxelDataSet == 0)
       {
-      this->m_VoxelDataSet = new H5::DataSet();
-      *(this->m_VoxelDataSet) = this->m_H5File->createDataSet(VoxelDataName,
-                                                              dataType,
-                                                              imageSpace,plist);
+      if(this->m_ChunkCacheSize == 0)
+        {
+        this->m_VoxelDataSet = new H5::DataSet();
+        *(this->m_VoxelDataSet) =
+          this->m_H5File->createDataSet(VoxelDataName,
+                                        dataType,
+                                        imageSpace,plist);
+        }
+      else
+        {
+        // the cache size can only be given through the C API
+        size_t chunkBytes = this->GetComponentSize();
+        for(int i = 0; i < numDims; i++)
+          {
+          chunkBytes *= chunkDims[i];
+          }
+        hid_t dapl = CreateChunkCacheAccessPropertyList(this->m_ChunkCacheSize,
+                                                        chunkBytes);
+        hid_t dataSetId = H5Dcreate2(this->m_H5File->getId(),
+                                     VoxelDataName.c_str(),
+                                     dataType.getId(),
+                                     imageSpace.getId(),
+                                     H5P_DEFAULT,plist.getId(),dapl);
+        H5Pclose(dapl);
+        if(dataSetId < 0)
+          {
+          delete [] dims;
+          itkExceptionMacro(<< "Can't create " << VoxelDataName
+                            << " in " << this->GetFileName());
+          }
+        this->m_VoxelDataSet = new H5::DataSet(dataSetId);
+        }
       }
     H5::DataSpace dspace;
     this->SetupStreaming(&imageSpace,&dspace);
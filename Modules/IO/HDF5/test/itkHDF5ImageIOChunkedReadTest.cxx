@@ -0,0 +1,236 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkHDF5ImageIO.h"
+#include "itkHDF5ImageIOFactory.h"
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkImageSource.h"
+#include "itkImageRegionIterator.h"
+#include "itkTimeProbe.h"
+#include "itk_H5Cpp.h"
+#include <algorithm>
+
+// Writes a compressed float volume with chunks of single slices, the
+// former layout, and with the default cubic chunks, checks the chunks
+// and filters stored, then reads random 64^3 regions of it through
+// ImageFileReader, checking their pixels, and reports the time taken.
+// The volume is generated and written in slabs, so it need not fit in
+// memory: pass a larger edge length, e.g. 2048, and number of regions
+// to use it as a benchmark.
+
+namespace
+{
+typedef itk::Image< float, 3 > ImageType;
+
+float ExpectedValue(const ImageType::IndexType & index)
+{
+  return static_cast< float >( index[0] + 3 * index[1] + 7 * index[2] );
+}
+
+// Generates the requested region of a ramp volume.
+class RampImageSource:public itk::ImageSource< ImageType >
+{
+public:
+  typedef RampImageSource                 Self;
+  typedef itk::ImageSource< ImageType >   Superclass;
+  typedef itk::SmartPointer< Self >       Pointer;
+
+  itkNewMacro(Self);
+  itkTypeMacro(RampImageSource, ImageSource);
+
+  itkSetMacro(Size, ImageType::SizeType);
+
+protected:
+  RampImageSource() { m_Size.Fill(1); }
+
+  virtual void GenerateOutputInformation()
+  {
+    Superclass::GenerateOutputInformation();
+    ImageType::RegionType region;
+    region.SetSize(m_Size);
+    this->GetOutput()->SetLargestPossibleRegion(region);
+  }
+
+  virtual void ThreadedGenerateData(const OutputImageRegionType & region, itk::ThreadIdType)
+  {
+    itk::ImageRegionIterator< ImageType > it(this->GetOutput(), region);
+    for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+      {
+      it.Set( ExpectedValue( it.GetIndex() ) );
+      }
+  }
+
+private:
+  ImageType::SizeType m_Size;
+};
+
+bool Write(const std::string & fileName, unsigned int edgeLength,
+           const std::vector< itk::SizeValueType > & chunkSize,
+           const hsize_t expectedChunk[3])
+{
+  RampImageSource::Pointer source = RampImageSource::New();
+  ImageType::SizeType      size;
+  size.Fill(edgeLength);
+  source->SetSize(size);
+
+  itk::HDF5ImageIO::Pointer io = itk::HDF5ImageIO::New();
+  io->SetChunkSize(chunkSize);
+
+  typedef itk::ImageFileWriter< ImageType > WriterType;
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetInput( source->GetOutput() );
+  writer->SetImageIO(io);
+  writer->SetFileName(fileName);
+  // the chunks are compressed even though UseCompression is off
+  // slabs holding whole cubic chunks
+  writer->SetNumberOfStreamDivisions( std::max(1u, edgeLength / 64) );
+  writer->Update();
+  writer = 0;
+
+  H5::H5File           file(fileName, H5F_ACC_RDONLY);
+  H5::DataSet          dataSet = file.openDataSet("/ITKImage/0/VoxelData");
+  H5::DSetCreatPropList plist = dataSet.getCreatePlist();
+  hsize_t              chunk[3];
+  plist.getChunk(3, chunk);
+  if ( plist.getLayout() != H5D_CHUNKED
+       || !std::equal(chunk, chunk + 3, expectedChunk)
+       || plist.getNfilters() != 2 )
+    {
+    std::cerr << fileName << " has chunks of " << chunk[2] << "x" << chunk[1] << "x" << chunk[0]
+              << " and " << plist.getNfilters() << " filters instead of " << expectedChunk[2]
+              << "x" << expectedChunk[1] << "x" << expectedChunk[0] << " and 2" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+// Reads the regions with a single reader, so that the chunk cache is
+// kept between them, returning the time taken, or a negative time on
+// failure.
+double ReadRegions(const std::string & fileName, const std::vector< ImageType::RegionType > & regions,
+                   itk::SizeValueType chunkCacheSize)
+{
+  itk::HDF5ImageIO::Pointer io = itk::HDF5ImageIO::New();
+  io->SetChunkCacheSize(chunkCacheSize);
+
+  typedef itk::ImageFileReader< ImageType > ReaderType;
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetImageIO(io);
+  reader->SetFileName(fileName);
+
+  double totalTime = 0.0;
+  for ( unsigned int r = 0; r < regions.size(); ++r )
+    {
+    itk::TimeProbe probe;
+    probe.Start();
+    reader->GetOutput()->SetRequestedRegion(regions[r]);
+    reader->Update();
+    probe.Stop();
+    totalTime += probe.GetTotal();
+
+    ImageType *output = reader->GetOutput();
+    if ( !output->GetBufferedRegion().IsInside(regions[r]) )
+      {
+      std::cerr << fileName << ": region " << regions[r] << " was not read" << std::endl;
+      return -1.0;
+      }
+    itk::ImageRegionConstIterator< ImageType > it(output, regions[r]);
+    for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+      {
+      if ( it.Get() != ExpectedValue( it.GetIndex() ) )
+        {
+        std::cerr << fileName << ": pixel " << it.GetIndex() << " is " << it.Get()
+                  << " instead of " << ExpectedValue( it.GetIndex() ) << std::endl;
+        return -1.0;
+        }
+      }
+    }
+  return totalTime;
+}
+}
+
+int itkHDF5ImageIOChunkedReadTest(int argc, char *argv[])
+{
+  if ( argc < 2 )
+    {
+    std::cerr << "Usage: " << argv[0] << " outputDirectory [edgeLength numberOfRegions]" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const std::string directory = argv[1];
+  unsigned int      edgeLength = 128;
+  unsigned int      numberOfRegions = 20;
+  if ( argc > 3 )
+    {
+    edgeLength = atoi(argv[2]);
+    numberOfRegions = atoi(argv[3]);
+    }
+  const unsigned int regionLength = std::min(64u, edgeLength);
+
+  itk::ObjectFactoryBase::RegisterFactory( itk::HDF5ImageIOFactory::New() );
+
+  const std::string                   slicesFileName = directory + "/HDF5ChunkedReadTestSlices.hdf5";
+  const std::string                   cubesFileName = directory + "/HDF5ChunkedReadTestCubes.hdf5";
+  std::vector< itk::SizeValueType >   sliceChunks(3, edgeLength);
+  sliceChunks[2] = 1;
+  const hsize_t                       expectedSliceChunk[3] = { 1, edgeLength, edgeLength };
+  // 1 MB of floats by default
+  const hsize_t                       cubeEdge = std::min(64u, edgeLength);
+  const hsize_t                       expectedCubeChunk[3] = { cubeEdge, cubeEdge, cubeEdge };
+  try
+    {
+    if ( !Write(slicesFileName, edgeLength, sliceChunks, expectedSliceChunk)
+         || !Write(cubesFileName, edgeLength, std::vector< itk::SizeValueType >(), expectedCubeChunk) )
+      {
+      return EXIT_FAILURE;
+      }
+    }
+  catch ( H5::Exception & error )
+    {
+    std::cerr << error.getCDetailMsg() << std::endl;
+    return EXIT_FAILURE;
+    }
+
+  std::vector< ImageType::RegionType > regions(numberOfRegions);
+  unsigned int                         random = 12345;
+  for ( unsigned int r = 0; r < numberOfRegions; ++r )
+    {
+    for ( unsigned int i = 0; i < 3; ++i )
+      {
+      random = random * 1103515245 + 12345;
+      regions[r].SetIndex( i, ( random >> 8 ) % ( edgeLength - regionLength + 1 ) );
+      regions[r].SetSize(i, regionLength);
+      }
+    }
+
+  // Benchmark.
+  const double slices = ReadRegions(slicesFileName, regions, 0);
+  const double cubes = ReadRegions(cubesFileName, regions, 0);
+  const double cubesCached = ReadRegions(cubesFileName, regions, 64 * 1024 * 1024);
+  if ( slices < 0.0 || cubes < 0.0 || cubesCached < 0.0 )
+    {
+    return EXIT_FAILURE;
+    }
+
+  std::cout << numberOfRegions << " random " << regionLength << "^3 regions of a compressed "
+            << edgeLength << "^3 float volume" << std::endl;
+  std::cout << "  slice chunks:                  " << slices << " s" << std::endl;
+  std::cout << "  cubic chunks:                  " << cubes << " s" << std::endl;
+  std::cout << "  cubic chunks, 64 MB cache:     " << cubesCached << " s" << std::endl;
+
+  return EXIT_SUCCESS;
+}
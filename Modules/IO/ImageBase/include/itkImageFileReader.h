@@ -24,6 +24,9 @@
 #include "itkImageRegion.h"
 #include "itkDefaultConvertPixelTraits.h"
 #include "itkSimpleDataObjectDecorator.h"
+#include "itkMultiThreader.h"
+#include "itkConditionVariable.h"
+#include <list>
 
 namespace itk
 {
@@ -77,6 +80,19 @@ public:
  * raw binary format) have no accepted suffix, so you will have to
  * manually create the ImageIO instance of the write type.
  *
+ * With UseMemoryMapping on, the reader maps the pixels of the file into
+ * memory when the ImageIO can provide them as they are (see
+ * ImageIOBase::MapIORegion()) and they need no conversion: the output
+ * image then points directly into the mapping, and its pixels are only
+ * read from disk when they are first accessed.  Pixels whose components
+ * are not aligned in the file, as after a header of arbitrary length,
+ * are read as usual.
+ *
+ * The reader can also read regions ahead of the updates asking for them,
+ * see PrefetchRequestedRegion().  A downstream StreamingImageFilter with
+ * NumberOfPrefetchedDivisions set makes it read the next pieces on a
+ * background thread while the current piece is being processed.
+ *
  * \sa ImageSeriesReader
  * \sa ImageIOBase
  *
@@ -121,6 +137,9 @@ public:
   /** The pixel type of the output image. */
   typedef typename TOutputImage::InternalPixelType OutputImagePixelType;
 
+  /** The pixel container of the output image. */
+  typedef typename TOutputImage::PixelContainer PixelContainerType;
+
   /** Specify the file to read. This is forwarded to the IO instance. */
   itkSetGetDecoratedInputMacro(FileName, std::string);
 
@@ -145,10 +164,31 @@ public:
    * enlarge the RequestedRegion to the size of the image on disk. */
   virtual void EnlargeOutputRequestedRegion(DataObject *output);
 
+  /** Start reading the requested region of the output on a background
+   * thread, so that the GenerateData() for that region only has to wait
+   * for the read to finish.  The regions are read in the order they were
+   * requested, with an ImageIO of the class of GetImageIO() which reads
+   * the header of the file itself; when that header does not match, as
+   * for ImageIOs set up by hand like RawImageIO, or the read fails, the
+   * region is read again in GenerateData().  Regions that are not asked
+   * for are released when a later one is.  Nothing is prefetched when
+   * UseMemoryMapping is on, or when the ImageIO does not declare that
+   * it can read on a background thread, see
+   * ImageIOBase::CanPrefetchRead(). */
+  virtual void PrefetchRequestedRegion(DataObject *output);
+
   /** Set the stream On or Off */
   itkSetMacro(UseStreaming, bool);
   itkGetConstReferenceMacro(UseStreaming, bool);
   itkBooleanMacro(UseStreaming);
+
+  /** Set/Get whether the output may point into a copy-on-write memory
+   * mapping of the file, instead of a buffer the pixels are read into.
+   * The file should then not be modified while the output exists.
+   * Default is off. */
+  itkSetMacro(UseMemoryMapping, bool);
+  itkGetConstReferenceMacro(UseMemoryMapping, bool);
+  itkBooleanMacro(UseMemoryMapping);
 protected:
   ImageFileReader();
   ~ImageFileReader();
@@ -167,12 +207,19 @@ protected:
   /** Does the real work. */
   virtual void GenerateData();
 
+  /** Make the output buffer point into a memory mapping of the file
+   * provided by the ImageIO.  Returns false, leaving the output
+   * untouched, if the pixels must be read instead. */
+  virtual bool MapOutputBuffer();
+
   ImageIOBase::Pointer m_ImageIO;
 
   bool m_UserSpecifiedImageIO; // keep track whether the
                                // ImageIO is user specified
 
   bool m_UseStreaming;
+
+  bool m_UseMemoryMapping;
 private:
   ImageFileReader(const Self &); //purposely not implemented
   void operator=(const Self &);  //purposely not implemented
@@ -182,6 +229,56 @@ private:
   // The region that the ImageIO class will return when we ask to
   // produce the requested region.
   ImageIORegion m_ActualIORegion;
+
+  /** A region read, or to be read, ahead on the prefetching thread.  The
+   * pixels go into a pixel container the output can take over when they
+   * need no conversion, and into a load buffer otherwise. */
+  struct PrefetchedRegion {
+    PrefetchedRegion():
+      UseStreaming(true), ComponentType(ImageIOBase::UNKNOWNCOMPONENTTYPE),
+      NumberOfComponents(0), NumberOfBytes(0), Bytes(0),
+      Reading(false), Done(false), Succeeded(false)
+    {}
+    ~PrefetchedRegion() { delete[] Bytes; }
+
+    std::string                          FileName;
+    ImageIOBase::Pointer                 ImageIO;
+    bool                                 UseStreaming;
+    ImageIORegion                        IORegion;
+    ImageRegionType                      Region;
+    ImageIOBase::IOComponentType         ComponentType;
+    unsigned int                         NumberOfComponents;
+    std::vector< SizeValueType >         Dimensions;
+    SizeValueType                        NumberOfBytes;
+    typename PixelContainerType::Pointer Pixels;
+    char *                               Bytes;
+    bool                                 Reading;
+    bool                                 Done;
+    bool                                 Succeeded;
+  };
+  typedef std::list< PrefetchedRegion * > PrefetchedRegionListType;
+
+  /** Body of the prefetching thread. */
+  static ITK_THREAD_RETURN_TYPE PrefetchThreadCallback(void *arg);
+
+  /** Read a region on the prefetching thread. */
+  static void ReadPrefetchedRegion(PrefetchedRegion *region);
+
+  /** Remove the region matching the current request from the prefetched
+   * ones, waiting for it to be read, and release those before it.  Returns
+   * null if it was not prefetched. */
+  PrefetchedRegion * TakePrefetchedRegion();
+
+  /** Release all prefetched regions, waiting for the one being read. */
+  void ClearPrefetchedRegions();
+
+  MultiThreader::Pointer     m_PrefetchThreader;
+  int                        m_PrefetchThreadId;
+  bool                       m_StopPrefetching;
+  SimpleMutexLock            m_PrefetchLock;
+  ConditionVariable::Pointer m_PrefetchCondition;
+  PrefetchedRegionListType   m_PrefetchedRegions;
+  ImageIOBase::Pointer       m_PrefetchImageIO;
 };
 } //namespace ITK
 
@@ -24,6 +24,7 @@
 #include "itkConvertPixelBuffer.h"
 #include "itkPixelTraits.h"
 #include "itkVectorImage.h"
+#include "itkMutexLockHolder.h"
 
 #include "itksys/SystemTools.hxx"
 #include <fstream>
@@ -38,12 +39,28 @@ ImageFileReader< TOutputImage, ConvertPixelTraits >
   this->SetFileName("");
   m_UserSpecifiedImageIO = false;
   m_UseStreaming = true;
+  m_UseMemoryMapping = false;
+
+  // the prefetching thread is started with the first prefetched region
+  m_PrefetchThreadId = -1;
+  m_StopPrefetching = false;
+  m_PrefetchCondition = ConditionVariable::New();
 }
 
 template< class TOutputImage, class ConvertPixelTraits >
 ImageFileReader< TOutputImage, ConvertPixelTraits >
 ::~ImageFileReader()
-{}
+{
+  this->ClearPrefetchedRegions();
+  if ( m_PrefetchThreadId >= 0 )
+    {
+    m_PrefetchLock.Lock();
+    m_StopPrefetching = true;
+    m_PrefetchCondition->Broadcast();
+    m_PrefetchLock.Unlock();
+    m_PrefetchThreader->TerminateThread(m_PrefetchThreadId);
+    }
+}
 
 template< class TOutputImage, class ConvertPixelTraits >
 void ImageFileReader< TOutputImage, ConvertPixelTraits >
@@ -63,6 +80,8 @@ void ImageFileReader< TOutputImage, ConvertPixelTraits >
 
   os << indent << "UserSpecifiedImageIO flag: " << m_UserSpecifiedImageIO << "\n";
   os << indent << "m_UseStreaming: " << m_UseStreaming << "\n";
+  os << indent << "m_UseMemoryMapping: " << m_UseMemoryMapping << "\n";
+  os << indent << "Number of prefetched regions: " << m_PrefetchedRegions.size() << "\n";
 }
 
 template< class TOutputImage, class ConvertPixelTraits >
@@ -88,6 +107,11 @@ ImageFileReader< TOutputImage, ConvertPixelTraits >
 
   itkDebugMacro(<< "Reading file for GenerateOutputInformation()" << this->GetFileName());
 
+  // the regions read ahead may be of another file, or of an older
+  // version of it
+  this->ClearPrefetchedRegions();
+  m_PrefetchImageIO = 0;
+
   // Check to see if we can read the file given the name or prefix
   //
   if ( this->GetFileName() == "" )
@@ -357,8 +381,53 @@ void ImageFileReader< TOutputImage, ConvertPixelTraits >
                  << "Allocating the buffer with the EnlargedRequestedRegion \n"
                  << output->GetRequestedRegion() << "\n");
 
+  // use the pixels of the file where they are, if possible
+  if ( m_UseMemoryMapping )
+    {
+    m_ImageIO->SetFileName( this->GetFileName().c_str() );
+    m_ImageIO->SetIORegion(m_ActualIORegion);
+    if ( this->MapOutputBuffer() )
+      {
+      return;
+      }
+    }
+
+  // use the pixels read ahead on the prefetching thread, if any
+  char             *loadBuffer = 0;
+  PrefetchedRegion *prefetched = this->TakePrefetchedRegion();
+  if ( prefetched )
+    {
+    if ( !prefetched->Succeeded )
+      {
+      itkDebugMacro(<< "Reading again the prefetched region " << m_ActualIORegion);
+      }
+    else if ( prefetched->Pixels )
+      {
+      itkDebugMacro(<< "Using the prefetched region " << m_ActualIORegion);
+      output->SetBufferedRegion( output->GetRequestedRegion() );
+      output->SetPixelContainer(prefetched->Pixels);
+      delete prefetched;
+      return;
+      }
+    else
+      {
+      // take over the load buffer, which is converted below
+      loadBuffer = prefetched->Bytes;
+      prefetched->Bytes = 0;
+      }
+    delete prefetched;
+    }
+
   // allocated the output image to the size of the enlarge requested region
-  this->AllocateOutputs();
+  try
+    {
+    this->AllocateOutputs();
+    }
+  catch ( ... )
+    {
+    delete[] loadBuffer;
+    throw;
+    }
 
   // Test if the file exists and if it can be opened.
   // An exception will be thrown otherwise, since we can't
@@ -382,7 +451,6 @@ void ImageFileReader< TOutputImage, ConvertPixelTraits >
   itkDebugMacro (<< "Setting imageIO IORegion to: " << m_ActualIORegion);
   m_ImageIO->SetIORegion(m_ActualIORegion);
 
-  char *loadBuffer = 0;
   // the size of the buffer is computed based on the actual number of
   // pixels to be read and the actual size of the pixels to be read
   // (as opposed to the sizes of the output)
@@ -409,8 +477,11 @@ void ImageFileReader< TOutputImage, ConvertPixelTraits >
                      << " m_ImageIO->NumComponents "
                      << m_ImageIO->GetNumberOfComponents() );
 
-      loadBuffer = new char[sizeOfActualIORegion];
-      m_ImageIO->Read( static_cast< void * >( loadBuffer ) );
+      if ( !loadBuffer )
+        {
+        loadBuffer = new char[sizeOfActualIORegion];
+        m_ImageIO->Read( static_cast< void * >( loadBuffer ) );
+        }
 
       // See note below as to why the buffered region is needed and
       // not actualIOregion
@@ -429,8 +500,11 @@ void ImageFileReader< TOutputImage, ConvertPixelTraits >
 
       OutputImagePixelType *outputBuffer = output->GetPixelContainer()->GetBufferPointer();
 
-      loadBuffer = new char[sizeOfActualIORegion];
-      m_ImageIO->Read( static_cast< void * >( loadBuffer ) );
+      if ( !loadBuffer )
+        {
+        loadBuffer = new char[sizeOfActualIORegion];
+        m_ImageIO->Read( static_cast< void * >( loadBuffer ) );
+        }
 
       // we use std::copy here as it should be optimized to memcpy for
       // plain old data, but still is oop
@@ -444,7 +518,15 @@ void ImageFileReader< TOutputImage, ConvertPixelTraits >
       itkDebugMacro(<< "No buffer conversion required.");
 
       OutputImagePixelType *outputBuffer = output->GetPixelContainer()->GetBufferPointer();
-      m_ImageIO->Read(outputBuffer);
+      if ( loadBuffer )
+        {
+        std::copy(loadBuffer, loadBuffer + sizeOfActualIORegion,
+                  reinterpret_cast< char * >( outputBuffer ) );
+        }
+      else
+        {
+        m_ImageIO->Read(outputBuffer);
+        }
       }
     }
   catch ( ... )
@@ -470,6 +552,284 @@ void ImageFileReader< TOutputImage, ConvertPixelTraits >
     }
 }
 
+template< class TOutputImage, class ConvertPixelTraits >
+bool
+ImageFileReader< TOutputImage, ConvertPixelTraits >
+::MapOutputBuffer()
+{
+  typedef typename PixelContainerType::Element ElementType;
+
+  typename TOutputImage::Pointer output = this->GetOutput();
+
+  // the pixels of the file must not need any conversion, nor copying
+  // into an image of lower dimension
+  const ImageIOBase::IOComponentType ioType =
+    ImageIOBase::MapPixelType< typename ConvertPixelTraits::ComponentType >::CType;
+  const SizeValueType numberOfBytes = m_ActualIORegion.GetNumberOfPixels()
+                                      * m_ImageIO->GetComponentSize() * m_ImageIO->GetNumberOfComponents();
+  if ( m_ImageIO->GetComponentType() != ioType
+       || m_ImageIO->GetNumberOfComponents() != ConvertPixelTraits::GetNumberOfComponents()
+       || m_ActualIORegion.GetNumberOfPixels() != output->GetRequestedRegion().GetNumberOfPixels()
+       || numberOfBytes % sizeof( ElementType ) != 0 )
+    {
+    return false;
+    }
+
+  MemoryMappedFileRegion::Pointer mapping = m_ImageIO->MapIORegion();
+  if ( !mapping )
+    {
+    return false;
+    }
+
+  // the components must be aligned in memory, which depends on where
+  // the data starts in the file
+  const size_t address = reinterpret_cast< size_t >( mapping->GetBufferPointer() );
+  if ( address % m_ImageIO->GetComponentSize() != 0 )
+    {
+    itkDebugMacro(<< "Not using the mapping of " << this->GetFileName()
+                  << " since its pixels are not aligned");
+    return false;
+    }
+
+  itkDebugMacro(<< "Using a memory mapping of " << m_ActualIORegion << " of " << this->GetFileName());
+
+  output->SetBufferedRegion( output->GetRequestedRegion() );
+  PixelContainerType *container = output->GetPixelContainer();
+  container->SetImportPointer(static_cast< ElementType * >( mapping->GetBufferPointer() ),
+                              numberOfBytes / sizeof( ElementType ), false);
+  container->SetImportPointerOwner(mapping);
+  return true;
+}
+
+template< class TOutputImage, class ConvertPixelTraits >
+void
+ImageFileReader< TOutputImage, ConvertPixelTraits >
+::PrefetchRequestedRegion(DataObject *output)
+{
+  TOutputImage *out = dynamic_cast< TOutputImage * >( output );
+
+  // mapped files are not read, ImageIOs that may not read on another
+  // thread are not used there, and there is nothing to read ahead of an
+  // empty region
+  if ( m_UseMemoryMapping || m_ImageIO.IsNull() || !m_ImageIO->CanPrefetchRead() || !out
+       || out->GetRequestedRegion().GetNumberOfPixels() == 0 )
+    {
+    return;
+    }
+
+  // the prefetching thread reads with its own ImageIO, never used by
+  // this one
+  if ( m_PrefetchImageIO.IsNull() )
+    {
+    m_PrefetchImageIO = dynamic_cast< ImageIOBase * >( m_ImageIO->CreateAnother().GetPointer() );
+    if ( m_PrefetchImageIO.IsNull() )
+      {
+      return;
+      }
+    }
+
+  PrefetchedRegion *region = new PrefetchedRegion;
+  region->FileName = this->GetFileName();
+  region->ImageIO = m_PrefetchImageIO;
+  region->UseStreaming = m_UseStreaming;
+  region->IORegion = m_ActualIORegion;
+  region->Region = out->GetRequestedRegion();
+  region->ComponentType = m_ImageIO->GetComponentType();
+  region->NumberOfComponents = m_ImageIO->GetNumberOfComponents();
+  for ( unsigned int i = 0; i < m_ImageIO->GetNumberOfDimensions(); ++i )
+    {
+    region->Dimensions.push_back( m_ImageIO->GetDimensions(i) );
+    }
+  region->NumberOfBytes = m_ActualIORegion.GetNumberOfPixels()
+                          * m_ImageIO->GetComponentSize() * m_ImageIO->GetNumberOfComponents();
+
+  // pixels needing no conversion are read straight into a pixel
+  // container for the output, as GenerateData() would
+  const ImageIOBase::IOComponentType ioType =
+    ImageIOBase::MapPixelType< typename ConvertPixelTraits::ComponentType >::CType;
+  if ( region->ComponentType == ioType
+       && region->NumberOfComponents == ConvertPixelTraits::GetNumberOfComponents()
+       && m_ActualIORegion.GetNumberOfPixels() == region->Region.GetNumberOfPixels()
+       && region->NumberOfBytes % sizeof( typename PixelContainerType::Element ) == 0 )
+    {
+    region->Pixels = PixelContainerType::New();
+    }
+
+  m_PrefetchLock.Lock();
+  for ( typename PrefetchedRegionListType::const_iterator it = m_PrefetchedRegions.begin();
+        it != m_PrefetchedRegions.end(); ++it )
+    {
+    if ( ( *it )->FileName == region->FileName && ( *it )->IORegion == region->IORegion
+         && ( *it )->Region == region->Region )
+      {
+      // already on its way
+      m_PrefetchLock.Unlock();
+      delete region;
+      return;
+      }
+    }
+  itkDebugMacro(<< "Prefetching " << region->IORegion);
+  m_PrefetchedRegions.push_back(region);
+  m_PrefetchCondition->Broadcast();
+  m_PrefetchLock.Unlock();
+
+  if ( m_PrefetchThreadId < 0 )
+    {
+    m_PrefetchThreader = MultiThreader::New();
+    m_PrefetchThreadId = m_PrefetchThreader->SpawnThread(Self::PrefetchThreadCallback, this);
+    }
+}
+
+template< class TOutputImage, class ConvertPixelTraits >
+ITK_THREAD_RETURN_TYPE
+ImageFileReader< TOutputImage, ConvertPixelTraits >
+::PrefetchThreadCallback(void *arg)
+{
+  MultiThreader::ThreadInfoStruct *threadInfo = static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  Self *                           reader = static_cast< Self * >( threadInfo->UserData );
+
+  reader->m_PrefetchLock.Lock();
+  while ( !reader->m_StopPrefetching )
+    {
+    // the regions are read in the order they were requested
+    PrefetchedRegion *region = 0;
+    for ( typename PrefetchedRegionListType::const_iterator it = reader->m_PrefetchedRegions.begin();
+          it != reader->m_PrefetchedRegions.end() && !region; ++it )
+      {
+      if ( !( *it )->Done )
+        {
+        region = *it;
+        }
+      }
+    if ( !region )
+      {
+      reader->m_PrefetchCondition->Wait(&reader->m_PrefetchLock);
+      continue;
+      }
+
+    region->Reading = true;
+    reader->m_PrefetchLock.Unlock();
+    Self::ReadPrefetchedRegion(region);
+    reader->m_PrefetchLock.Lock();
+    region->Reading = false;
+    region->Done = true;
+    reader->m_PrefetchCondition->Broadcast();
+    }
+  reader->m_PrefetchLock.Unlock();
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template< class TOutputImage, class ConvertPixelTraits >
+void
+ImageFileReader< TOutputImage, ConvertPixelTraits >
+::ReadPrefetchedRegion(PrefetchedRegion *region)
+{
+  ImageIOBase *io = region->ImageIO;
+
+  try
+    {
+    if ( region->FileName != io->GetFileName() )
+      {
+      io->SetFileName( region->FileName.c_str() );
+      io->ReadImageInformation();
+      }
+
+    // the header read here must describe the pixels the reader expects
+    bool sameHeader = io->GetComponentType() == region->ComponentType
+                      && io->GetNumberOfComponents() == region->NumberOfComponents
+                      && io->GetNumberOfDimensions() == region->Dimensions.size();
+    for ( unsigned int i = 0; sameHeader && i < region->Dimensions.size(); ++i )
+      {
+      sameHeader = io->GetDimensions(i) == region->Dimensions[i];
+      }
+    if ( !sameHeader )
+      {
+      return;
+      }
+
+    io->SetUseStreamedReading(region->UseStreaming);
+    io->SetIORegion(region->IORegion);
+    if ( region->Pixels )
+      {
+      region->Pixels->Reserve( region->NumberOfBytes / sizeof( typename PixelContainerType::Element ) );
+      io->Read( region->Pixels->GetBufferPointer() );
+      }
+    else
+      {
+      region->Bytes = new char[region->NumberOfBytes];
+      io->Read(region->Bytes);
+      }
+    region->Succeeded = true;
+    }
+  catch ( ... )
+    {
+    // GenerateData() reads the region again, and reports the error
+    }
+}
+
+template< class TOutputImage, class ConvertPixelTraits >
+typename ImageFileReader< TOutputImage, ConvertPixelTraits >::PrefetchedRegion *
+ImageFileReader< TOutputImage, ConvertPixelTraits >
+::TakePrefetchedRegion()
+{
+  const ImageRegionType & requestedRegion = this->GetOutput()->GetRequestedRegion();
+  const std::string       fileName = this->GetFileName();
+
+  MutexLockHolder< SimpleMutexLock > holder(m_PrefetchLock);
+
+  typename PrefetchedRegionListType::iterator match = m_PrefetchedRegions.begin();
+  while ( match != m_PrefetchedRegions.end()
+          && !( ( *match )->FileName == fileName && ( *match )->IORegion == m_ActualIORegion
+                && ( *match )->Region == requestedRegion ) )
+    {
+    ++match;
+    }
+  if ( match == m_PrefetchedRegions.end() )
+    {
+    return 0;
+    }
+
+  PrefetchedRegion *region = *match;
+  while ( !region->Done )
+    {
+    m_PrefetchCondition->Wait(&m_PrefetchLock);
+    }
+
+  // the regions before it were read first, and will not be asked for
+  ++match;
+  for ( typename PrefetchedRegionListType::iterator it = m_PrefetchedRegions.begin(); it != match; ++it )
+    {
+    if ( *it != region )
+      {
+      delete *it;
+      }
+    }
+  m_PrefetchedRegions.erase(m_PrefetchedRegions.begin(), match);
+  return region;
+}
+
+template< class TOutputImage, class ConvertPixelTraits >
+void
+ImageFileReader< TOutputImage, ConvertPixelTraits >
+::ClearPrefetchedRegions()
+{
+  MutexLockHolder< SimpleMutexLock > holder(m_PrefetchLock);
+
+  // once out of the list, the regions are not picked up by the
+  // prefetching thread anymore
+  PrefetchedRegionListType regions;
+  regions.swap(m_PrefetchedRegions);
+  for ( typename PrefetchedRegionListType::iterator it = regions.begin(); it != regions.end(); ++it )
+    {
+    while ( ( *it )->Reading )
+      {
+      m_PrefetchCondition->Wait(&m_PrefetchLock);
+      }
+    delete *it;
+    }
+}
+
 template< class TOutputImage, class ConvertPixelTraits >
 void
 ImageFileReader< TOutputImage, ConvertPixelTraits >
@@ -23,6 +23,7 @@
 #include "itkLightProcessObject.h"
 #include "itkIndent.h"
 #include "itkImageIORegion.h"
+#include "itkMemoryMappedFileRegion.h"
 #include "itkRGBPixel.h"
 #include "itkRGBAPixel.h"
 #include "itkVariableLengthVector.h"
@@ -315,6 +316,16 @@ public:
     return false;
   }
 
+  /** Determine if another instance of this ImageIO may read on a
+   * background thread while this one is in use, as ImageFileReader does
+   * to prefetch regions.  That is the case only if reading touches no
+   * state shared between instances, such as the global state of some
+   * third party libraries.  Default is false. */
+  virtual bool CanPrefetchRead()
+  {
+    return false;
+  }
+
   /** Read the spacing and dimentions of the image.
    * Assumes SetFileName has been called with a valid file name. */
   virtual void ReadImageInformation() = 0;
@@ -322,6 +333,15 @@ public:
   /** Reads the data from disk into the memory buffer provided. */
   virtual void Read(void *buffer) = 0;
 
+  /** Map the pixels of the IORegion into memory instead of reading
+   * them, if they are stored in the file exactly as Read() would return
+   * them: uncompressed, in the byte order of this system, and
+   * contiguously.  The mapping is copy-on-write, so its pixels may be
+   * modified; the file is left untouched.  Returns null if the pixels
+   * cannot be mapped, in which case Read() must be used.  The default
+   * implementation always returns null. */
+  virtual MemoryMappedFileRegion::Pointer MapIORegion();
+
   /*-------- This part of the interfaces deals with writing data ----- */
 
   /** Determine the file type. Returns true if this ImageIO can read the
@@ -621,6 +641,14 @@ protected:
   /** Convenient method to read a buffer as binary. Return true on success. */
   bool ReadBufferAsBinary(std::istream & os, void *buffer, SizeType numberOfBytesToBeRead);
 
+  /** Convenient method to map the IORegion of a binary file whose pixels
+   * start at byte dataPosition and are stored without padding, the
+   * first dimension varying fastest.  Returns null if the pixels of the
+   * IORegion are not contiguous in the file, or the file cannot be
+   * mapped.  Callers are responsible for checking that the pixels need
+   * no other conversion, such as byte swapping or decompression. */
+  MemoryMappedFileRegion::Pointer MapIORegionOfFile(const std::string & fileName, SizeType dataPosition);
+
   /** Insert an extension to the list of supported extensions for reading. */
   void AddSupportedReadExtension(const char *extension);
 
@@ -0,0 +1,99 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkMemoryMappedFileRegion_h
+#define __itkMemoryMappedFileRegion_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkIntTypes.h"
+#include <string>
+
+namespace itk
+{
+/** \class MemoryMappedFileRegion
+ * \brief A range of bytes of a file mapped into memory.
+ *
+ * The range is mapped copy-on-write: its pages are read from the file
+ * the first time they are accessed, and writing to them modifies a
+ * private copy, never the file.  The mapping is released when the
+ * object is destroyed.
+ *
+ * ImageIO objects use it to hand out the pixels of uncompressed files
+ * without reading them into a buffer of their own, see
+ * ImageIOBase::MapIORegion().  The file should not be truncated while
+ * it is mapped.
+ *
+ * \sa ImageIOBase ImageFileReader
+ * \ingroup IOFilters
+ * \ingroup ITKIOImageBase
+ */
+class ITK_EXPORT MemoryMappedFileRegion:public Object
+{
+public:
+  /** Standard class typedefs. */
+  typedef MemoryMappedFileRegion     Self;
+  typedef Object                     Superclass;
+  typedef SmartPointer< Self >       Pointer;
+  typedef SmartPointer< const Self > ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(MemoryMappedFileRegion, Object);
+
+  /** Type for sizes of, and positions in, files. */
+  typedef ::itk::intmax_t SizeType;
+
+  /** Map numberOfBytes bytes of fileName, starting at byte offset,
+   * releasing any previous mapping.  Returns false, leaving nothing
+   * mapped, if the file cannot be opened or mapped, or is shorter than
+   * offset + numberOfBytes. */
+  bool Map(const std::string & fileName, SizeType offset, SizeType numberOfBytes);
+
+  /** Release the mapping. */
+  void Unmap();
+
+  /** Pointer to the first mapped byte, the one at the offset given to
+   * Map(), or null if nothing is mapped. */
+  void * GetBufferPointer() { return m_BufferPointer; }
+
+  /** Number of bytes mapped. */
+  itkGetConstMacro(NumberOfBytes, SizeType);
+
+protected:
+  MemoryMappedFileRegion();
+  ~MemoryMappedFileRegion();
+  void PrintSelf(std::ostream & os, Indent indent) const;
+
+private:
+  MemoryMappedFileRegion(const Self &); //purposely not implemented
+  void operator=(const Self &);         //purposely not implemented
+
+  /** Start and length of the mapping, which begins at a multiple of the
+   * mapping granularity at or before the requested offset. */
+  void *   m_MappingStart;
+  SizeType m_MappingLength;
+
+  void *      m_BufferPointer;
+  SizeType    m_NumberOfBytes;
+  std::string m_FileName;
+};
+} // end namespace itk
+
+#endif
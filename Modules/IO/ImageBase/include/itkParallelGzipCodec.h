@@ -0,0 +1,131 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#ifndef __itkParallelGzipCodec_h
+#define __itkParallelGzipCodec_h
+
+#include "itkObject.h"
+#include "itkObjectFactory.h"
+#include "itkMultiThreader.h"
+#include <vector>
+
+namespace itk
+{
+/** \class ParallelGzipCodec
+ * \brief Compresses and decompresses gzip streams with several threads.
+ *
+ * Compress() splits the data into blocks of BlockSize bytes and deflates
+ * each one on its own, in parallel.  The blocks are flushed to a byte
+ * boundary and concatenated into a single gzip member, so the result is
+ * an ordinary gzip stream that any zlib based reader, gunzip included,
+ * inflates as usual.  The compressed size of every block is recorded in
+ * an extra field of the gzip header, which Decompress() uses to inflate
+ * the blocks in parallel as well.
+ *
+ * Decompress() also accepts gzip and zlib streams written by other
+ * programs, which it inflates in a single thread.
+ *
+ * Compressing blocks independently costs a little compression, since
+ * matches cannot reach back into the previous block; with the default
+ * block size of 1 MB the streams are typically less than 1% larger.
+ *
+ * \ingroup IOFilters
+ * \ingroup ITKIOImageBase
+ */
+class ITK_EXPORT ParallelGzipCodec:public Object
+{
+public:
+  /** Standard class typedefs. */
+  typedef ParallelGzipCodec          Self;
+  typedef Object                     Superclass;
+  typedef SmartPointer< Self >       Pointer;
+  typedef SmartPointer< const Self > ConstPointer;
+
+  /** Method for creation through the object factory. */
+  itkNewMacro(Self);
+
+  /** Run-time type information (and related methods). */
+  itkTypeMacro(ParallelGzipCodec, Object);
+
+  /** Type for sizes of, and positions in, data and streams. */
+  typedef size_t SizeType;
+
+  /** Type of the compressed streams. */
+  typedef std::vector< unsigned char > StreamType;
+
+  /** Set/Get the number of threads compressing or decompressing blocks,
+   * at most MultiThreader::GetGlobalMaximumNumberOfThreads().  Defaults
+   * to MultiThreader::GetGlobalDefaultNumberOfThreads(). */
+  itkSetClampMacro(NumberOfThreads, ThreadIdType, 1, MultiThreader::GetGlobalMaximumNumberOfThreads());
+  itkGetConstMacro(NumberOfThreads, ThreadIdType);
+
+  /** Set/Get the number of bytes compressed into each block.  It is
+   * increased for data too large to be indexed in blocks of this size.
+   * Defaults to 1 MB. */
+  itkSetClampMacro(BlockSize, SizeType, 1024, 1 << 30);
+  itkGetConstMacro(BlockSize, SizeType);
+
+  /** Set/Get the zlib compression level, from 0 for no compression to 9
+   * for the best one.  Defaults to 6, the zlib default. */
+  itkSetClampMacro(CompressionLevel, int, 0, 9);
+  itkGetConstMacro(CompressionLevel, int);
+
+  /** Compress numberOfBytes bytes of data into an indexed gzip stream,
+   * replacing the contents of stream. */
+  void Compress(const void *data, SizeType numberOfBytes, StreamType & stream) const;
+
+  /** Compress prefixSize bytes of prefix followed by dataSize bytes of
+   * data into an indexed gzip stream, as if they were contiguous,
+   * replacing the contents of stream.  This compresses, e.g., a file
+   * header with the image data without copying them together first. */
+  void Compress(const void *prefix, SizeType prefixSize,
+                const void *data, SizeType dataSize, StreamType & stream) const;
+
+  /** Decompress the numberOfBytes bytes starting at byte offset of the
+   * uncompressed data of a gzip or zlib stream into data.  Only the
+   * blocks of indexed streams holding these bytes are inflated.  Throws
+   * an exception if the stream is corrupt or holds fewer bytes. */
+  void Decompress(const void *stream, SizeType streamSize,
+                  void *data, SizeType numberOfBytes, SizeType offset = 0) const;
+
+  /** Whether the first streamSize bytes of stream start an indexed gzip
+   * stream, written by Compress(). */
+  static bool IsIndexed(const void *stream, SizeType streamSize);
+
+protected:
+  ParallelGzipCodec();
+  ~ParallelGzipCodec() {}
+  void PrintSelf(std::ostream & os, Indent indent) const;
+
+private:
+  ParallelGzipCodec(const Self &); //purposely not implemented
+  void operator=(const Self &);    //purposely not implemented
+
+  /** Inflate a stream without an index, in this thread. */
+  void DecompressSerial(const void *stream, SizeType streamSize,
+                        void *data, SizeType numberOfBytes, SizeType offset) const;
+
+  static ITK_THREAD_RETURN_TYPE CompressThreaderCallback(void *arg);
+  static ITK_THREAD_RETURN_TYPE DecompressThreaderCallback(void *arg);
+
+  ThreadIdType m_NumberOfThreads;
+  SizeType     m_BlockSize;
+  int          m_CompressionLevel;
+};
+} // end namespace itk
+
+#endif
@@ -83,6 +83,13 @@ public:
                                                          const ImageIORegion & pasteRegion,
                                                          const ImageIORegion & largestPossibleRegion);
 
+  // see super class for documentation
+  //
+  // Maps the IORegion of binary files in the byte order of this system,
+  // assuming the pixels start at GetDataPosition(). Subclasses that
+  // store binary data in any other way must override it.
+  virtual MemoryMappedFileRegion::Pointer MapIORegion();
+
 protected:
   StreamingImageIOBase();
   // virtual ~StreamingImageIOBase(); not needed
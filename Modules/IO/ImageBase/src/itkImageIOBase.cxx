@@ -330,6 +330,48 @@ ImageIOBase
   return true;
 }
 
+MemoryMappedFileRegion::Pointer
+ImageIOBase
+::MapIORegion()
+{
+  return 0;
+}
+
+MemoryMappedFileRegion::Pointer
+ImageIOBase
+::MapIORegionOfFile(const std::string & fileName, ImageIOBase::SizeType dataPosition)
+{
+  // The pixels of the region are contiguous in the file if it spans
+  // the whole file in all dimensions but the last one it extends along.
+  SizeType firstPixel = 0;
+  SizeType pixelStride = 1;
+  bool     partial = false;
+
+  for ( unsigned int i = 0; i < m_IORegion.GetImageDimension(); ++i )
+    {
+    const SizeType dimension = i < m_NumberOfDimensions ? m_Dimensions[i] : 1;
+    const SizeType size = m_IORegion.GetSize(i);
+    if ( partial && size > 1 )
+      {
+      itkDebugMacro(<< "Cannot map " << m_IORegion << " since its pixels are not contiguous");
+      return 0;
+      }
+    partial = partial || size != dimension;
+    firstPixel += pixelStride * m_IORegion.GetIndex(i);
+    pixelStride *= dimension;
+    }
+
+  const SizeType pixelSize = this->GetPixelSize();
+  MemoryMappedFileRegion::Pointer mapping = MemoryMappedFileRegion::New();
+  if ( !mapping->Map( fileName, dataPosition + firstPixel * pixelSize,
+                      static_cast< SizeType >( m_IORegion.GetNumberOfPixels() ) * pixelSize ) )
+    {
+    itkDebugMacro(<< "Cannot map " << m_IORegion << " of " << fileName);
+    return 0;
+    }
+  return mapping;
+}
+
 unsigned int ImageIOBase::GetPixelSize() const
 {
   if ( m_ComponentType == UNKNOWNCOMPONENTTYPE
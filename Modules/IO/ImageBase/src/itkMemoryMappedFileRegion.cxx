@@ -0,0 +1,204 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkMemoryMappedFileRegion.h"
+
+#if defined( _WIN32 )
+#include <windows.h>
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace itk
+{
+MemoryMappedFileRegion::MemoryMappedFileRegion():
+  m_MappingStart(0),
+  m_MappingLength(0),
+  m_BufferPointer(0),
+  m_NumberOfBytes(0)
+{}
+
+MemoryMappedFileRegion::~MemoryMappedFileRegion()
+{
+  this->Unmap();
+}
+
+#if defined( _WIN32 )
+
+bool MemoryMappedFileRegion::Map(const std::string & fileName, SizeType offset, SizeType numberOfBytes)
+{
+  this->Unmap();
+
+  if ( offset < 0 || numberOfBytes <= 0 )
+    {
+    return false;
+    }
+
+  HANDLE file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if ( file == INVALID_HANDLE_VALUE )
+    {
+    itkDebugMacro(<< "Could not open " << fileName);
+    return false;
+    }
+
+  LARGE_INTEGER fileSize;
+  if ( !GetFileSizeEx(file, &fileSize) || fileSize.QuadPart - offset < numberOfBytes )
+    {
+    itkDebugMacro(<< fileName << " is shorter than " << offset + numberOfBytes << " bytes");
+    CloseHandle(file);
+    return false;
+    }
+
+  // The mapping object holds its own reference to the file, and the
+  // view holds one to the mapping object.
+  HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+  CloseHandle(file);
+  if ( mapping == NULL )
+    {
+    itkDebugMacro(<< "Could not create a mapping of " << fileName);
+    return false;
+    }
+
+  SYSTEM_INFO systemInfo;
+  GetSystemInfo(&systemInfo);
+  const SizeType granularity = systemInfo.dwAllocationGranularity;
+  const SizeType mappingOffset = offset - offset % granularity;
+  const SizeType mappingLength = numberOfBytes + offset % granularity;
+
+  void *start = 0;
+  if ( static_cast< SizeType >( static_cast< SIZE_T >( mappingLength ) ) == mappingLength )
+    {
+    start = MapViewOfFile( mapping, FILE_MAP_COPY,
+                           static_cast< DWORD >( static_cast< ::itk::uint64_t >( mappingOffset ) >> 32 ),
+                           static_cast< DWORD >( mappingOffset & 0xFFFFFFFF ),
+                           static_cast< SIZE_T >( mappingLength ) );
+    }
+  CloseHandle(mapping);
+  if ( start == NULL )
+    {
+    itkDebugMacro(<< "Could not map " << numberOfBytes << " bytes of " << fileName);
+    return false;
+    }
+
+  m_MappingStart = start;
+  m_MappingLength = mappingLength;
+  m_BufferPointer = static_cast< char * >( start ) + offset % granularity;
+  m_NumberOfBytes = numberOfBytes;
+  m_FileName = fileName;
+  return true;
+}
+
+void MemoryMappedFileRegion::Unmap()
+{
+  if ( m_MappingStart )
+    {
+    UnmapViewOfFile(m_MappingStart);
+    }
+  m_MappingStart = 0;
+  m_MappingLength = 0;
+  m_BufferPointer = 0;
+  m_NumberOfBytes = 0;
+  m_FileName = "";
+}
+
+#else
+
+bool MemoryMappedFileRegion::Map(const std::string & fileName, SizeType offset, SizeType numberOfBytes)
+{
+  this->Unmap();
+
+  if ( offset < 0 || numberOfBytes <= 0 )
+    {
+    return false;
+    }
+
+  const SizeType granularity = sysconf(_SC_PAGESIZE);
+  const SizeType mappingOffset = offset - offset % granularity;
+  const SizeType mappingLength = numberOfBytes + offset % granularity;
+
+  // off_t and size_t may be too small on 32 bit systems
+  if ( static_cast< SizeType >( static_cast< off_t >( mappingOffset ) ) != mappingOffset
+       || static_cast< SizeType >( static_cast< size_t >( mappingLength ) ) != mappingLength )
+    {
+    itkDebugMacro(<< "Cannot map " << numberOfBytes << " bytes at " << offset << " on this system");
+    return false;
+    }
+
+  const int file = open(fileName.c_str(), O_RDONLY);
+  if ( file < 0 )
+    {
+    itkDebugMacro(<< "Could not open " << fileName);
+    return false;
+    }
+
+  // Accessing mapped pages past the end of the file raises SIGBUS.
+  struct stat fileStatus;
+  if ( fstat(file, &fileStatus) != 0
+       || static_cast< SizeType >( fileStatus.st_size ) - offset < numberOfBytes )
+    {
+    itkDebugMacro(<< fileName << " is shorter than " << offset + numberOfBytes << " bytes");
+    close(file);
+    return false;
+    }
+
+  // The mapping keeps its own reference to the file.
+  void *start = mmap(0, static_cast< size_t >( mappingLength ), PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE, file, static_cast< off_t >( mappingOffset ) );
+  close(file);
+  if ( start == MAP_FAILED )
+    {
+    itkDebugMacro(<< "Could not map " << numberOfBytes << " bytes of " << fileName);
+    return false;
+    }
+
+  m_MappingStart = start;
+  m_MappingLength = mappingLength;
+  m_BufferPointer = static_cast< char * >( start ) + offset % granularity;
+  m_NumberOfBytes = numberOfBytes;
+  m_FileName = fileName;
+  return true;
+}
+
+void MemoryMappedFileRegion::Unmap()
+{
+  if ( m_MappingStart )
+    {
+    munmap( m_MappingStart, static_cast< size_t >( m_MappingLength ) );
+    }
+  m_MappingStart = 0;
+  m_MappingLength = 0;
+  m_BufferPointer = 0;
+  m_NumberOfBytes = 0;
+  m_FileName = "";
+}
+
+#endif
+
+void MemoryMappedFileRegion::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "FileName: " << m_FileName << std::endl;
+  os << indent << "BufferPointer: " << m_BufferPointer << std::endl;
+  os << indent << "NumberOfBytes: " << m_NumberOfBytes << std::endl;
+}
+} // end namespace itk
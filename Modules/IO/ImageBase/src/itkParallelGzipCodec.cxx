@@ -0,0 +1,557 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+#include "itkParallelGzipCodec.h"
+#include "itk_zlib.h"
+#include <algorithm>
+#include <string.h>
+
+// An indexed stream is a single gzip member (RFC 1952) whose header has
+// an extra field with one subfield, identified by 'I' 'T', holding
+//
+//   uncompressed size       8 bytes, little endian
+//   block size              4 bytes, little endian
+//   compressed block sizes  4 bytes each, little endian
+//
+// The deflate data is the concatenation of the blocks.  Every block but
+// the last one ends with a sync flush, which aligns it to a byte
+// boundary without marking it final, and none refers to data of another
+// block, so that each one can be inflated on its own.
+
+namespace itk
+{
+namespace
+{
+const unsigned char IndexSubfieldId1 = 'I';
+const unsigned char IndexSubfieldId2 = 'T';
+
+// Fixed part of the gzip header, length of the extra field, and fixed
+// part of the index subfield.
+const size_t GzipHeaderLength = 10 + 2 + 4 + 12;
+
+// The extra field, and so the index, must fit in 65535 bytes.
+const size_t MaximumNumberOfBlocks = ( 65535 - 4 - 12 ) / 4;
+
+// Bytes inflated at a time when skipping to an offset in a stream
+// without index.
+const size_t SkipBufferSize = 1 << 16;
+
+void PutLittleEndian(unsigned char *bytes, ::itk::uint64_t value, unsigned int numberOfBytes)
+{
+  for ( unsigned int i = 0; i < numberOfBytes; ++i )
+    {
+    bytes[i] = static_cast< unsigned char >( value >> ( 8 * i ) );
+    }
+}
+
+::itk::uint64_t GetLittleEndian(const unsigned char *bytes, unsigned int numberOfBytes)
+{
+  ::itk::uint64_t value = 0;
+  for ( unsigned int i = numberOfBytes; i > 0; --i )
+    {
+    value = ( value << 8 ) | bytes[i - 1];
+    }
+  return value;
+}
+
+// The index of an indexed stream.
+struct IndexType {
+  size_t                HeaderLength;
+  ::itk::uint64_t       UncompressedSize;
+  size_t                BlockSize;
+  std::vector< size_t > CompressedBlockSizes;
+};
+
+// Reads the index of a stream, returning false if it has none.
+bool ReadIndex(const unsigned char *stream, size_t streamSize, IndexType *index)
+{
+  // magic number, deflate method and only the FEXTRA flag, the header
+  // of an indexed stream having no file name or comment
+  if ( streamSize < 12 || stream[0] != 0x1f || stream[1] != 0x8b
+       || stream[2] != 8 || stream[3] != 0x04 )
+    {
+    return false;
+    }
+  const size_t extraLength = static_cast< size_t >( GetLittleEndian(stream + 10, 2) );
+  if ( streamSize < 12 + extraLength )
+    {
+    return false;
+    }
+
+  size_t position = 12;
+  while ( position + 4 <= 12 + extraLength )
+    {
+    const size_t subfieldLength = static_cast< size_t >( GetLittleEndian(stream + position + 2, 2) );
+    if ( position + 4 + subfieldLength > 12 + extraLength )
+      {
+      return false;
+      }
+    if ( stream[position] == IndexSubfieldId1 && stream[position + 1] == IndexSubfieldId2 )
+      {
+      if ( subfieldLength < 16 || ( subfieldLength - 12 ) % 4 != 0 )
+        {
+        return false;
+        }
+      if ( index )
+        {
+        const unsigned char *subfield = stream + position + 4;
+        index->HeaderLength = 12 + extraLength;
+        index->UncompressedSize = GetLittleEndian(subfield, 8);
+        index->BlockSize = static_cast< size_t >( GetLittleEndian(subfield + 8, 4) );
+        index->CompressedBlockSizes.resize( ( subfieldLength - 12 ) / 4 );
+        for ( size_t b = 0; b < index->CompressedBlockSizes.size(); ++b )
+          {
+          index->CompressedBlockSizes[b] =
+            static_cast< size_t >( GetLittleEndian(subfield + 12 + 4 * b, 4) );
+          }
+        }
+      return true;
+      }
+    position += 4 + subfieldLength;
+    }
+  return false;
+}
+
+// A block being compressed or decompressed.  When compressing, the
+// input of a block may start with the end of a prefix of the data.
+struct BlockType {
+  const unsigned char *        Prefix;
+  size_t                       PrefixSize;
+  const unsigned char *        Input;
+  size_t                       InputSize;
+  std::vector< unsigned char > Output;
+  unsigned char *              OutputPointer;
+  size_t                       OutputSize;
+  bool                         Last;
+  uLong                        CRC;
+  bool                         Succeeded;
+};
+
+struct ThreadStruct {
+  std::vector< BlockType > *Blocks;
+  int                       CompressionLevel;
+  // range of the uncompressed data wanted when decompressing
+  size_t                    BlockSize;
+  size_t                    Offset;
+  size_t                    NumberOfBytes;
+  unsigned char *           Data;
+};
+
+void DeflateBlock(BlockType & block, int compressionLevel)
+{
+  z_stream z;
+  memset( &z, 0, sizeof( z ) );
+  block.Succeeded = false;
+  block.CRC = crc32(0L, Z_NULL, 0);
+  if ( block.PrefixSize > 0 )
+    {
+    block.CRC = crc32( block.CRC, block.Prefix, static_cast< uInt >( block.PrefixSize ) );
+    }
+  if ( block.InputSize > 0 )
+    {
+    block.CRC = crc32( block.CRC, block.Input, static_cast< uInt >( block.InputSize ) );
+    }
+
+  // raw deflate, without zlib header or trailer
+  if ( deflateInit2(&z, compressionLevel, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK )
+    {
+    return;
+    }
+  block.Output.resize( deflateBound( &z, static_cast< uLong >( block.PrefixSize + block.InputSize ) ) + 16 );
+  z.next_out = &block.Output[0];
+  z.avail_out = static_cast< uInt >( block.Output.size() );
+
+  // the prefix, if any, then the input, flushed at its end
+  for ( unsigned int part = block.PrefixSize > 0 ? 0 : 1; part < 2; ++part )
+    {
+    z.next_in = const_cast< Bytef * >( part == 0 ? block.Prefix : block.Input );
+    z.avail_in = static_cast< uInt >( part == 0 ? block.PrefixSize : block.InputSize );
+
+    const int flush = part == 0 ? Z_NO_FLUSH : ( block.Last ? Z_FINISH : Z_SYNC_FLUSH );
+    for (;; )
+      {
+      if ( z.avail_out == 0 )
+        {
+        const size_t used = block.Output.size();
+        block.Output.resize(2 * used);
+        z.next_out = &block.Output[used];
+        z.avail_out = static_cast< uInt >( used );
+        }
+      const int result = deflate(&z, flush);
+      if ( result == Z_STREAM_ERROR )
+        {
+        deflateEnd(&z);
+        return;
+        }
+      if ( flush == Z_NO_FLUSH ? z.avail_in == 0
+           : ( block.Last ? result == Z_STREAM_END : z.avail_out != 0 ) )
+        {
+        break;
+        }
+      }
+    }
+  block.Output.resize(z.total_out);
+  deflateEnd(&z);
+  block.Succeeded = true;
+}
+
+void InflateBlock(BlockType & block)
+{
+  z_stream z;
+  memset( &z, 0, sizeof( z ) );
+  block.Succeeded = false;
+
+  if ( inflateInit2(&z, -MAX_WBITS) != Z_OK )
+    {
+    return;
+    }
+  z.next_in = const_cast< Bytef * >( block.Input );
+  z.avail_in = static_cast< uInt >( block.InputSize );
+  z.next_out = block.OutputPointer;
+  z.avail_out = static_cast< uInt >( block.OutputSize );
+  const int result = inflate(&z, Z_SYNC_FLUSH);
+  inflateEnd(&z);
+
+  // the blocks before the last one end with a sync flush, not with the
+  // end of the stream
+  if ( z.total_out != block.OutputSize
+       || ( block.Last ? result != Z_STREAM_END : result != Z_OK && result != Z_BUF_ERROR && result != Z_STREAM_END ) )
+    {
+    return;
+    }
+  block.CRC = crc32( crc32(0L, Z_NULL, 0), block.OutputPointer, static_cast< uInt >( block.OutputSize ) );
+  block.Succeeded = true;
+}
+} // end anonymous namespace
+
+ParallelGzipCodec::ParallelGzipCodec():
+  m_NumberOfThreads( MultiThreader::GetGlobalDefaultNumberOfThreads() ),
+  m_BlockSize(1 << 20),
+  m_CompressionLevel(6)
+{}
+
+void ParallelGzipCodec::Compress(const void *data, SizeType numberOfBytes, StreamType & stream) const
+{
+  this->Compress(0, 0, data, numberOfBytes, stream);
+}
+
+void ParallelGzipCodec::Compress(const void *prefix, SizeType prefixSize,
+                                 const void *data, SizeType dataSize, StreamType & stream) const
+{
+  const unsigned char *prefixInput = static_cast< const unsigned char * >( prefix );
+  const unsigned char *input = static_cast< const unsigned char * >( data );
+  const SizeType       numberOfBytes = prefixSize + dataSize;
+
+  SizeType blockSize = m_BlockSize;
+  if ( numberOfBytes / blockSize >= MaximumNumberOfBlocks )
+    {
+    blockSize = numberOfBytes / MaximumNumberOfBlocks + 1;
+    }
+  if ( blockSize > ( static_cast< SizeType >( 1 ) << 30 ) )
+    {
+    itkExceptionMacro(<< "Cannot compress " << numberOfBytes << " bytes in one stream");
+    }
+  const SizeType numberOfBlocks = numberOfBytes == 0 ? 1 : ( numberOfBytes + blockSize - 1 ) / blockSize;
+
+  std::vector< BlockType > blocks(numberOfBlocks);
+  for ( SizeType b = 0; b < numberOfBlocks; ++b )
+    {
+    // the part of the prefix, then the part of the data, in the block
+    const SizeType start = b * blockSize;
+    const SizeType end = std::min(start + blockSize, numberOfBytes);
+    const SizeType prefixEnd = std::min(end, prefixSize);
+    blocks[b].Prefix = prefixInput + std::min(start, prefixSize);
+    blocks[b].PrefixSize = start < prefixEnd ? prefixEnd - start : 0;
+    blocks[b].Input = input + ( std::max(start, prefixSize) - prefixSize );
+    blocks[b].InputSize = end > std::max(start, prefixSize) ? end - std::max(start, prefixSize) : 0;
+    blocks[b].Last = b + 1 == numberOfBlocks;
+    }
+
+  ThreadStruct str;
+  str.Blocks = &blocks;
+  str.CompressionLevel = m_CompressionLevel;
+
+  MultiThreader::Pointer threader = MultiThreader::New();
+  threader->SetNumberOfThreads( static_cast< ThreadIdType >(
+                                  std::min( static_cast< SizeType >( m_NumberOfThreads ), numberOfBlocks ) ) );
+  threader->SetSingleMethod(Self::CompressThreaderCallback, &str);
+  threader->SingleMethodExecute();
+
+  // header, with the index
+  stream.resize(GzipHeaderLength + 4 * numberOfBlocks);
+  unsigned char *header = &stream[0];
+  memset(header, 0, stream.size());
+  header[0] = 0x1f;
+  header[1] = 0x8b;
+  header[2] = 8;    // deflate
+  header[3] = 0x04; // FEXTRA
+  header[8] = m_CompressionLevel == 9 ? 2 : ( m_CompressionLevel == 1 ? 4 : 0 );
+  header[9] = 255;  // unknown operating system
+  PutLittleEndian(header + 10, 4 + 12 + 4 * numberOfBlocks, 2);
+  header[12] = IndexSubfieldId1;
+  header[13] = IndexSubfieldId2;
+  PutLittleEndian(header + 14, 12 + 4 * numberOfBlocks, 2);
+  PutLittleEndian(header + 16, numberOfBytes, 8);
+  PutLittleEndian(header + 24, blockSize, 4);
+
+  SizeType compressedSize = 0;
+  uLong    crc = crc32(0L, Z_NULL, 0);
+  for ( SizeType b = 0; b < numberOfBlocks; ++b )
+    {
+    if ( !blocks[b].Succeeded )
+      {
+      itkExceptionMacro(<< "Could not compress block " << b);
+      }
+    PutLittleEndian(&stream[GzipHeaderLength + 4 * b], blocks[b].Output.size(), 4);
+    compressedSize += blocks[b].Output.size();
+    crc = crc32_combine( crc, blocks[b].CRC,
+                         static_cast< z_off_t >( blocks[b].PrefixSize + blocks[b].InputSize ) );
+    }
+
+  // blocks and trailer
+  SizeType position = stream.size();
+  stream.resize(position + compressedSize + 8);
+  for ( SizeType b = 0; b < numberOfBlocks; ++b )
+    {
+    if ( !blocks[b].Output.empty() )
+      {
+      memcpy(&stream[position], &blocks[b].Output[0], blocks[b].Output.size());
+      }
+    position += blocks[b].Output.size();
+    }
+  PutLittleEndian(&stream[position], crc, 4);
+  PutLittleEndian(&stream[position + 4], numberOfBytes, 4);
+}
+
+ITK_THREAD_RETURN_TYPE ParallelGzipCodec::CompressThreaderCallback(void *arg)
+{
+  MultiThreader::ThreadInfoStruct *info = static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  ThreadStruct *str = static_cast< ThreadStruct * >( info->UserData );
+  std::vector< BlockType > & blocks = *str->Blocks;
+
+  for ( SizeType b = info->ThreadID; b < blocks.size(); b += info->NumberOfThreads )
+    {
+    DeflateBlock(blocks[b], str->CompressionLevel);
+    }
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+bool ParallelGzipCodec::IsIndexed(const void *stream, SizeType streamSize)
+{
+  return ReadIndex(static_cast< const unsigned char * >( stream ), streamSize, 0);
+}
+
+void ParallelGzipCodec::Decompress(const void *stream, SizeType streamSize,
+                                   void *data, SizeType numberOfBytes, SizeType offset) const
+{
+  const unsigned char *input = static_cast< const unsigned char * >( stream );
+  IndexType            index;
+
+  if ( !ReadIndex(input, streamSize, &index) )
+    {
+    this->DecompressSerial(stream, streamSize, data, numberOfBytes, offset);
+    return;
+    }
+
+  const SizeType numberOfBlocks = index.CompressedBlockSizes.size();
+  if ( index.BlockSize == 0
+       || numberOfBlocks != ( index.UncompressedSize == 0 ? 1
+                              : ( index.UncompressedSize + index.BlockSize - 1 ) / index.BlockSize ) )
+    {
+    itkExceptionMacro(<< "The index of the stream is corrupt");
+    }
+  if ( offset + numberOfBytes > index.UncompressedSize )
+    {
+    itkExceptionMacro(<< "The stream holds " << index.UncompressedSize << " bytes, not "
+                      << offset + numberOfBytes);
+    }
+
+  std::vector< BlockType > blocks(numberOfBlocks);
+  SizeType                 position = index.HeaderLength;
+  for ( SizeType b = 0; b < numberOfBlocks; ++b )
+    {
+    blocks[b].Input = input + position;
+    blocks[b].InputSize = index.CompressedBlockSizes[b];
+    blocks[b].OutputSize = static_cast< SizeType >(
+      std::min( static_cast< ::itk::uint64_t >( index.BlockSize ), index.UncompressedSize - b * index.BlockSize ) );
+    blocks[b].Last = b + 1 == numberOfBlocks;
+    blocks[b].CRC = 0;
+    blocks[b].Succeeded = false;
+    position += blocks[b].InputSize;
+    }
+  if ( position + 8 > streamSize )
+    {
+    itkExceptionMacro(<< "The stream is truncated");
+    }
+
+  ThreadStruct str;
+  str.Blocks = &blocks;
+  str.BlockSize = index.BlockSize;
+  str.Offset = offset;
+  str.NumberOfBytes = numberOfBytes;
+  str.Data = static_cast< unsigned char * >( data );
+
+  MultiThreader::Pointer threader = MultiThreader::New();
+  threader->SetNumberOfThreads( static_cast< ThreadIdType >(
+                                  std::min( static_cast< SizeType >( m_NumberOfThreads ), numberOfBlocks ) ) );
+  threader->SetSingleMethod(Self::DecompressThreaderCallback, &str);
+  threader->SingleMethodExecute();
+
+  // The checksum can only be verified when all blocks were inflated.
+  bool allInflated = true;
+  uLong crc = crc32(0L, Z_NULL, 0);
+  for ( SizeType b = 0; b < numberOfBlocks; ++b )
+    {
+    const SizeType blockStart = b * index.BlockSize;
+    const bool     wanted = numberOfBytes > 0 && blockStart < offset + numberOfBytes
+                            && blockStart + blocks[b].OutputSize > offset;
+    if ( wanted && !blocks[b].Succeeded )
+      {
+      itkExceptionMacro(<< "Could not decompress block " << b << " of the stream");
+      }
+    allInflated = allInflated && wanted;
+    crc = crc32_combine( crc, blocks[b].CRC, static_cast< z_off_t >( blocks[b].OutputSize ) );
+    }
+  if ( allInflated && ( crc != GetLittleEndian(input + position, 4)
+                        || ( index.UncompressedSize & 0xffffffff ) != GetLittleEndian(input + position + 4, 4) ) )
+    {
+    itkExceptionMacro(<< "The checksum of the stream does not match its data");
+    }
+}
+
+ITK_THREAD_RETURN_TYPE ParallelGzipCodec::DecompressThreaderCallback(void *arg)
+{
+  MultiThreader::ThreadInfoStruct *info = static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  ThreadStruct *str = static_cast< ThreadStruct * >( info->UserData );
+  std::vector< BlockType > & blocks = *str->Blocks;
+  const SizeType             end = str->Offset + str->NumberOfBytes;
+
+  for ( SizeType b = info->ThreadID; b < blocks.size(); b += info->NumberOfThreads )
+    {
+    BlockType &    block = blocks[b];
+    const SizeType blockStart = b * str->BlockSize;
+    const SizeType blockEnd = blockStart + block.OutputSize;
+    if ( str->NumberOfBytes == 0 || blockStart >= end || blockEnd <= str->Offset )
+      {
+      continue;
+      }
+    // blocks partially wanted are inflated aside
+    if ( blockStart >= str->Offset && blockEnd <= end )
+      {
+      block.OutputPointer = str->Data + ( blockStart - str->Offset );
+      InflateBlock(block);
+      }
+    else
+      {
+      block.Output.resize(block.OutputSize);
+      block.OutputPointer = &block.Output[0];
+      InflateBlock(block);
+      if ( block.Succeeded )
+        {
+        const SizeType first = std::max(blockStart, str->Offset);
+        const SizeType last = std::min(blockEnd, end);
+        memcpy(str->Data + ( first - str->Offset ), &block.Output[first - blockStart], last - first);
+        }
+      }
+    }
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+void ParallelGzipCodec::DecompressSerial(const void *stream, SizeType streamSize,
+                                         void *data, SizeType numberOfBytes, SizeType offset) const
+{
+  z_stream z;
+  memset( &z, 0, sizeof( z ) );
+
+  // allow both gzip and zlib headers
+  if ( inflateInit2(&z, MAX_WBITS + 32) != Z_OK )
+    {
+    itkExceptionMacro(<< "Could not initialize zlib");
+    }
+  z.next_in = static_cast< Bytef * >( const_cast< void * >( stream ) );
+  SizeType remainingInput = streamSize;
+
+  std::vector< unsigned char > skipBuffer;
+  SizeType                     skipped = 0;
+  SizeType                     written = 0;
+  int                          result = Z_OK;
+  while ( written < numberOfBytes )
+    {
+    // zlib counts in unsigned int
+    if ( z.avail_in == 0 )
+      {
+      z.avail_in = static_cast< uInt >( std::min( remainingInput, static_cast< SizeType >( 1 << 30 ) ) );
+      remainingInput -= z.avail_in;
+      }
+    uInt available;
+    if ( skipped < offset )
+      {
+      skipBuffer.resize(SkipBufferSize);
+      available = static_cast< uInt >( std::min(offset - skipped, SkipBufferSize) );
+      z.next_out = &skipBuffer[0];
+      }
+    else
+      {
+      available = static_cast< uInt >( std::min( numberOfBytes - written, static_cast< SizeType >( 1 << 30 ) ) );
+      z.next_out = static_cast< Bytef * >( data ) + written;
+      }
+    z.avail_out = available;
+
+    result = inflate(&z, Z_NO_FLUSH);
+    const SizeType produced = available - z.avail_out;
+    if ( skipped < offset )
+      {
+      skipped += produced;
+      }
+    else
+      {
+      written += produced;
+      }
+
+    if ( result == Z_STREAM_END )
+      {
+      // concatenated gzip members
+      if ( z.avail_in == 0 && remainingInput == 0 )
+        {
+        break;
+        }
+      inflateReset(&z);
+      }
+    else if ( result != Z_OK )
+      {
+      break;
+      }
+    }
+  inflateEnd(&z);
+
+  if ( written < numberOfBytes )
+    {
+    itkExceptionMacro(<< "Could not decompress " << offset + numberOfBytes << " bytes of the stream: "
+                      << ( result == Z_STREAM_END || result == Z_BUF_ERROR ? "the stream is too short"
+                           : "the stream is corrupt" ) );
+    }
+}
+
+void ParallelGzipCodec::PrintSelf(std::ostream & os, Indent indent) const
+{
+  Superclass::PrintSelf(os, indent);
+
+  os << indent << "NumberOfThreads: " << m_NumberOfThreads << std::endl;
+  os << indent << "BlockSize: " << m_BlockSize << std::endl;
+  os << indent << "CompressionLevel: " << m_CompressionLevel << std::endl;
+}
+} // end namespace itk
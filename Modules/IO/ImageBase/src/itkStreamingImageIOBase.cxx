@@ -16,6 +16,7 @@
  *
  *=========================================================================*/
 #include "itkStreamingImageIOBase.h"
+#include "itkByteSwapper.h"
 
 #include "itksys/SystemTools.hxx"
 
@@ -299,6 +300,18 @@ void StreamingImageIOBase::OpenFileForWriting(std::ofstream & os, const char *fi
     }
 }
 
+MemoryMappedFileRegion::Pointer StreamingImageIOBase::MapIORegion()
+{
+  const ByteOrder systemByteOrder = ByteSwapper< int >::SystemIsBigEndian() ? BigEndian : LittleEndian;
+
+  if ( m_FileType != Binary
+       || ( this->GetComponentSize() > 1 && m_ByteOrder != systemByteOrder ) )
+    {
+    return 0;
+    }
+  return this->MapIORegionOfFile( m_FileName, this->GetDataPosition() );
+}
+
 bool StreamingImageIOBase::CanStreamRead(void)
 {
   return true;
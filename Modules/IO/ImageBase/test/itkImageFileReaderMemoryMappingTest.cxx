@@ -0,0 +1,258 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkStreamingImageFilter.h"
+#include "itkImageRegionIterator.h"
+#include "itkTimeProbe.h"
+#include <fstream>
+
+#if !defined( _WIN32 )
+#include <unistd.h>
+#endif
+
+// Writes MetaImage, NRRD and VTK files, reads them with and without
+// memory mapping, in one piece and streamed, and checks that the mapped
+// images have the right pixels, that they are the ones mapped, and that
+// modifying them does not modify the files.  Data attached to a header
+// can only be mapped when the header length keeps the pixels aligned, so
+// only files with detached data are required to be mapped.  For the
+// MetaImage file with detached data it also reports the time to the first pixel and the resident memory
+// after the read.  Pass a larger edge length, e.g. 1024 for a 4 GB
+// file, to use it as a benchmark.
+
+namespace
+{
+// Resident memory of the process in bytes, or -1 if unknown.
+double GetResidentBytes()
+{
+#if defined( __linux__ )
+  std::ifstream statm("/proc/self/statm");
+  double        size = 0;
+  double        resident = 0;
+  if ( statm >> size >> resident )
+    {
+    return resident * sysconf(_SC_PAGESIZE);
+    }
+#endif
+  return -1.0;
+}
+
+template< class TImage >
+typename TImage::PixelType ExpectedValue(itk::SizeValueType offset)
+{
+  return static_cast< typename TImage::PixelType >( offset % 251 );
+}
+
+template< class TImage >
+bool CheckPixels(const TImage *image, const char *what)
+{
+  itk::ImageRegionConstIterator< TImage > it( image, image->GetBufferedRegion() );
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    const typename TImage::IndexType index = it.GetIndex();
+    const typename TImage::SizeType  size = image->GetLargestPossibleRegion().GetSize();
+    const itk::SizeValueType         linear = index[0] + size[0] * ( index[1] + size[1] * index[2] );
+    if ( it.Get() != ExpectedValue< TImage >(linear) )
+      {
+      std::cerr << what << ": pixel " << index << " is " << static_cast< double >( it.Get() )
+                << " instead of " << static_cast< double >( ExpectedValue< TImage >(linear) ) << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+template< class TImage >
+bool IsMapped(TImage *image)
+{
+  return dynamic_cast< itk::MemoryMappedFileRegion * >(
+    image->GetPixelContainer()->GetImportPointerOwner() ) != 0;
+}
+
+template< class TImage >
+bool WriteAndReadMapped(const std::string & fileName, unsigned int edgeLength, bool requireMapped)
+{
+  typedef itk::ImageFileReader< TImage >   ReaderType;
+  typedef itk::ImageFileWriter< TImage >   WriterType;
+  typedef itk::StreamingImageFilter< TImage, TImage > StreamerType;
+
+  typename TImage::Pointer image = TImage::New();
+  typename TImage::SizeType size;
+  size.Fill(edgeLength);
+  image->SetRegions(size);
+  image->Allocate();
+  itk::SizeValueType linear = 0;
+  itk::ImageRegionIterator< TImage > it( image, image->GetBufferedRegion() );
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it, ++linear )
+    {
+    it.Set( ExpectedValue< TImage >(linear) );
+    }
+
+  typename WriterType::Pointer writer = WriterType::New();
+  writer->SetInput(image);
+  writer->SetFileName(fileName);
+  writer->UseCompressionOff();
+  writer->Update();
+
+  // in one piece
+  typename ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName(fileName);
+  reader->UseMemoryMappingOn();
+  reader->Update();
+  typename TImage::Pointer mapped = reader->GetOutput();
+  std::cout << fileName << ( IsMapped( mapped.GetPointer() ) ? " mapped" : " read" ) << std::endl;
+  if ( requireMapped && !IsMapped( mapped.GetPointer() ) )
+    {
+    std::cerr << fileName << " was not mapped" << std::endl;
+    return false;
+    }
+  if ( !CheckPixels(mapped.GetPointer(), fileName.c_str()) )
+    {
+    return false;
+    }
+
+  // the file is mapped copy-on-write
+  mapped->GetBufferPointer()[0] = ExpectedValue< TImage >(1);
+  typename ReaderType::Pointer plainReader = ReaderType::New();
+  plainReader->SetFileName(fileName);
+  plainReader->Update();
+  if ( !CheckPixels(plainReader->GetOutput(), "file after modifying the mapped image") )
+    {
+    return false;
+    }
+  reader = 0;
+  mapped = 0;
+
+  // streamed, each piece of the reader being mapped on its own
+  reader = ReaderType::New();
+  reader->SetFileName(fileName);
+  reader->UseMemoryMappingOn();
+  typename StreamerType::Pointer streamer = StreamerType::New();
+  streamer->SetInput( reader->GetOutput() );
+  streamer->SetNumberOfStreamDivisions(4);
+  streamer->Update();
+  if ( !CheckPixels(streamer->GetOutput(), "streamed mapped image") )
+    {
+    return false;
+    }
+  return true;
+}
+
+struct ReadStatistics {
+  double FirstPixelSeconds;
+  double ResidentBytes;
+  double TotalSeconds;
+};
+
+// Time to the first pixel and resident memory added by reading the
+// whole file, and the time to visit all of its pixels.
+template< class TImage >
+ReadStatistics TimeRead(const std::string & fileName, bool useMemoryMapping)
+{
+  typedef itk::ImageFileReader< TImage > ReaderType;
+
+  ReadStatistics statistics;
+  const double   residentBefore = GetResidentBytes();
+  itk::TimeProbe firstPixelProbe;
+  itk::TimeProbe totalProbe;
+
+  firstPixelProbe.Start();
+  totalProbe.Start();
+  typename ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName(fileName);
+  reader->SetUseMemoryMapping(useMemoryMapping);
+  reader->Update();
+  volatile double sum = reader->GetOutput()->GetBufferPointer()[0];
+  firstPixelProbe.Stop();
+  statistics.ResidentBytes = GetResidentBytes() - residentBefore;
+
+  itk::ImageRegionConstIterator< TImage > it( reader->GetOutput(),
+                                              reader->GetOutput()->GetBufferedRegion() );
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    sum = sum + it.Get();
+    }
+  totalProbe.Stop();
+
+  statistics.FirstPixelSeconds = firstPixelProbe.GetTotal();
+  statistics.TotalSeconds = totalProbe.GetTotal();
+  return statistics;
+}
+}
+
+int itkImageFileReaderMemoryMappingTest(int argc, char *argv[])
+{
+  if ( argc < 2 )
+    {
+    std::cerr << "Usage: " << argv[0] << " outputDirectory [edgeLength]" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const std::string directory = argv[1];
+  unsigned int      edgeLength = 64;
+  if ( argc > 2 )
+    {
+    edgeLength = atoi(argv[2]);
+    }
+
+  typedef itk::Image< float, 3 >         FloatImageType;
+  typedef itk::Image< unsigned char, 3 > UCharImageType;
+
+  // VTK files are big endian, so only single byte pixels can be mapped
+  // on all systems.
+  if ( !WriteAndReadMapped< FloatImageType >(directory + "/MemoryMappingTest.mha", edgeLength, false)
+       || !WriteAndReadMapped< FloatImageType >(directory + "/MemoryMappingTest.mhd", edgeLength, true)
+       || !WriteAndReadMapped< FloatImageType >(directory + "/MemoryMappingTest.nrrd", edgeLength, false)
+       || !WriteAndReadMapped< FloatImageType >(directory + "/MemoryMappingTestDetached.nhdr", edgeLength, true)
+       || !WriteAndReadMapped< UCharImageType >(directory + "/MemoryMappingTestUChar.mha", edgeLength, true)
+       || !WriteAndReadMapped< UCharImageType >(directory + "/MemoryMappingTest.vtk", edgeLength, true) )
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Mapping is only used when the pixels need no conversion.
+  typedef itk::ImageFileReader< itk::Image< double, 3 > > DoubleReaderType;
+  DoubleReaderType::Pointer doubleReader = DoubleReaderType::New();
+  doubleReader->SetFileName(directory + "/MemoryMappingTest.mhd");
+  doubleReader->UseMemoryMappingOn();
+  doubleReader->Update();
+  if ( IsMapped( doubleReader->GetOutput() ) )
+    {
+    std::cerr << "Pixels needing conversion were mapped" << std::endl;
+    return EXIT_FAILURE;
+    }
+  doubleReader = 0;
+
+  // Benchmark.
+  const std::string fileName = directory + "/MemoryMappingTest.mhd";
+  const ReadStatistics read = TimeRead< FloatImageType >(fileName, false);
+  const ReadStatistics mapped = TimeRead< FloatImageType >(fileName, true);
+
+  std::cout << "Float image of " << edgeLength << "^3 pixels ("
+            << edgeLength * edgeLength * static_cast< double >( edgeLength ) * sizeof( float ) / 1e9
+            << " GB)" << std::endl;
+  std::cout << "  read:   first pixel after " << read.FirstPixelSeconds << " s, "
+            << read.ResidentBytes / 1e6 << " MB resident, all pixels after "
+            << read.TotalSeconds << " s" << std::endl;
+  std::cout << "  mapped: first pixel after " << mapped.FirstPixelSeconds << " s, "
+            << mapped.ResidentBytes / 1e6 << " MB resident, all pixels after "
+            << mapped.TotalSeconds << " s" << std::endl;
+
+  return EXIT_SUCCESS;
+}
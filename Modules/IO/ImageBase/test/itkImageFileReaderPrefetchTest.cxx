@@ -0,0 +1,239 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkStreamingImageFilter.h"
+#include "itkMetaImageIO.h"
+#include "itkImageAlgorithm.h"
+#include "itkImageRegionIterator.h"
+#include "itkTimeProbe.h"
+#include "itksys/SystemTools.hxx"
+
+// Streams a MetaImage file through a filter with StreamingImageFilter,
+// with and without prefetching, and checks the pixels and that the
+// reader read the pieces after the first one ahead, unless its ImageIO
+// does not declare that it can read on a background thread.  The file is read
+// through an ImageIO that waits before each read, like a slow disk, and
+// the filter waits as long for each piece, so that the reported times
+// show how much of the reading is hidden behind the processing.
+
+namespace
+{
+unsigned int readLatency = 0;    // milliseconds
+unsigned int computeLatency = 0; // milliseconds
+
+// A MetaImageIO reading from a slow disk.
+class ThrottledMetaImageIO:public itk::MetaImageIO
+{
+public:
+  typedef ThrottledMetaImageIO          Self;
+  typedef itk::MetaImageIO              Superclass;
+  typedef itk::SmartPointer< Self >     Pointer;
+
+  itkNewMacro(Self);
+  itkTypeMacro(ThrottledMetaImageIO, MetaImageIO);
+
+  itkGetConstMacro(NumberOfReads, unsigned int);
+
+  itkSetMacro(PrefetchSafe, bool);
+
+  virtual bool CanPrefetchRead()
+  {
+    return m_PrefetchSafe;
+  }
+
+  virtual void Read(void *buffer)
+  {
+    itksys::SystemTools::Delay(readLatency);
+    ++m_NumberOfReads;
+    Superclass::Read(buffer);
+  }
+
+protected:
+  ThrottledMetaImageIO():m_NumberOfReads(0), m_PrefetchSafe(true) {}
+
+private:
+  unsigned int m_NumberOfReads;
+  bool         m_PrefetchSafe;
+};
+
+// A filter taking some time to process each piece.
+template< class TImage >
+class SlowCopyImageFilter:public itk::ImageToImageFilter< TImage, TImage >
+{
+public:
+  typedef SlowCopyImageFilter                         Self;
+  typedef itk::ImageToImageFilter< TImage, TImage >   Superclass;
+  typedef itk::SmartPointer< Self >                   Pointer;
+
+  itkNewMacro(Self);
+  itkTypeMacro(SlowCopyImageFilter, ImageToImageFilter);
+
+protected:
+  SlowCopyImageFilter() {}
+
+  virtual void GenerateData()
+  {
+    this->AllocateOutputs();
+    itksys::SystemTools::Delay(computeLatency);
+    itk::ImageAlgorithm::Copy( this->GetInput(), this->GetOutput(),
+                               this->GetOutput()->GetRequestedRegion(),
+                               this->GetOutput()->GetRequestedRegion() );
+  }
+};
+
+template< class TImage >
+bool CheckPixels(const TImage *image)
+{
+  const typename TImage::SizeType size = image->GetLargestPossibleRegion().GetSize();
+
+  itk::ImageRegionConstIterator< TImage > it( image, image->GetLargestPossibleRegion() );
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    const typename TImage::IndexType index = it.GetIndex();
+    const itk::SizeValueType         linear = index[0] + size[0] * ( index[1] + size[1] * index[2] );
+    if ( it.Get() != static_cast< typename TImage::PixelType >( linear % 251 ) )
+      {
+      std::cerr << "Pixel " << index << " is " << static_cast< double >( it.Get() ) << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+// Streams the file, returning the time it took, or a negative time on
+// failure.
+template< class TImage >
+double Stream(const std::string & fileName, unsigned int divisions, unsigned int prefetchedDivisions,
+              bool prefetchSafe = true)
+{
+  typedef itk::ImageFileReader< TImage >              ReaderType;
+  typedef SlowCopyImageFilter< TImage >               FilterType;
+  typedef itk::StreamingImageFilter< TImage, TImage > StreamerType;
+
+  typename ReaderType::Pointer reader = ReaderType::New();
+  ThrottledMetaImageIO::Pointer io = ThrottledMetaImageIO::New();
+  io->SetPrefetchSafe(prefetchSafe);
+  reader->SetImageIO(io);
+  reader->SetFileName(fileName);
+
+  typename FilterType::Pointer filter = FilterType::New();
+  filter->SetInput( reader->GetOutput() );
+
+  typename StreamerType::Pointer streamer = StreamerType::New();
+  streamer->SetInput( filter->GetOutput() );
+  streamer->SetNumberOfStreamDivisions(divisions);
+  streamer->SetNumberOfPrefetchedDivisions(prefetchedDivisions);
+
+  itk::TimeProbe probe;
+  probe.Start();
+  streamer->Update();
+  probe.Stop();
+
+  if ( !CheckPixels( streamer->GetOutput() ) )
+    {
+    return -1.0;
+    }
+
+  // all pieces after the first are read by the prefetching thread, if
+  // the ImageIO allows it
+  const unsigned int expectedReads = prefetchedDivisions > 0 && prefetchSafe ? 1 : divisions;
+  if ( io->GetNumberOfReads() != expectedReads )
+    {
+    std::cerr << "The reader's ImageIO read " << io->GetNumberOfReads()
+              << " pieces instead of " << expectedReads << std::endl;
+    return -1.0;
+    }
+  return probe.GetTotal();
+}
+}
+
+int itkImageFileReaderPrefetchTest(int argc, char *argv[])
+{
+  if ( argc < 2 )
+    {
+    std::cerr << "Usage: " << argv[0]
+              << " outputDirectory [edgeLength readLatency computeLatency]" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const std::string fileName = std::string(argv[1]) + "/PrefetchTest.mha";
+  unsigned int      edgeLength = 64;
+  readLatency = 20;
+  computeLatency = 20;
+  if ( argc > 4 )
+    {
+    edgeLength = atoi(argv[2]);
+    readLatency = atoi(argv[3]);
+    computeLatency = atoi(argv[4]);
+    }
+  const unsigned int divisions = 8;
+
+  typedef itk::Image< float, 3 >  FloatImageType;
+  typedef itk::Image< double, 3 > DoubleImageType;
+
+  FloatImageType::Pointer image = FloatImageType::New();
+  FloatImageType::SizeType size;
+  size.Fill(edgeLength);
+  image->SetRegions(size);
+  image->Allocate();
+  itk::SizeValueType linear = 0;
+  itk::ImageRegionIterator< FloatImageType > it( image, image->GetBufferedRegion() );
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it, ++linear )
+    {
+    it.Set( linear % 251 );
+    }
+
+  typedef itk::ImageFileWriter< FloatImageType > WriterType;
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetInput(image);
+  writer->SetFileName(fileName);
+  writer->UseCompressionOff();
+  writer->Update();
+
+  // pixels needing a conversion are prefetched too
+  if ( Stream< DoubleImageType >(fileName, divisions, 2) < 0.0 )
+    {
+    return EXIT_FAILURE;
+    }
+
+  // nothing is prefetched with an ImageIO that may not read on another
+  // thread
+  if ( Stream< FloatImageType >(fileName, divisions, 2, false) < 0.0 )
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Benchmark.
+  const double sequential = Stream< FloatImageType >(fileName, divisions, 0);
+  const double prefetchOne = Stream< FloatImageType >(fileName, divisions, 1);
+  const double prefetchTwo = Stream< FloatImageType >(fileName, divisions, 2);
+  if ( sequential < 0.0 || prefetchOne < 0.0 || prefetchTwo < 0.0 )
+    {
+    return EXIT_FAILURE;
+    }
+
+  std::cout << divisions << " pieces of a " << edgeLength << "^3 float image, "
+            << readLatency << " ms to read and " << computeLatency
+            << " ms to process each" << std::endl;
+  std::cout << "  sequential:              " << sequential << " s" << std::endl;
+  std::cout << "  1 prefetched division:   " << prefetchOne << " s" << std::endl;
+  std::cout << "  2 prefetched divisions:  " << prefetchTwo << " s" << std::endl;
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,441 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkParallelGzipCodec.h"
+#include "itkImageFileReader.h"
+#include "itkImageFileWriter.h"
+#include "itkMetaImageIO.h"
+#include "itkNiftiImageIO.h"
+#include "itkNrrdImageIO.h"
+#include "itkImageRegionIterator.h"
+#include "itkTimeProbe.h"
+#include "itk_zlib.h"
+#include <algorithm>
+#include <fstream>
+
+// Compresses data, alone or after a prefix, with ParallelGzipCodec and
+// checks that it decompresses all or part of it, that zlib alone inflates
+// the streams, and that it decompresses streams written by zlib and
+// rejects damaged ones.  Checks that MetaImageIO, NiftiImageIO and
+// NrrdImageIO compress in parallel only when asked to, and that they
+// read such files by themselves otherwise.  Then writes compressed
+// MetaImage, NIfTI and NRRD files in parallel, reads them back, and
+// reports the write and read throughput for 1, 2, 4 ... threads.
+// Pass a larger edge length, e.g. 512, to use it as a benchmark.
+
+namespace
+{
+typedef itk::ParallelGzipCodec::StreamType ByteArrayType;
+
+// Moderately compressible bytes, like those of a smooth image.
+ByteArrayType MakeData(size_t numberOfBytes)
+{
+  ByteArrayType data(numberOfBytes);
+  unsigned int  random = 12345;
+  for ( size_t i = 0; i < numberOfBytes; ++i )
+    {
+    random = random * 1103515245 + 12345;
+    data[i] = static_cast< unsigned char >( ( i / 1000 ) % 200 + ( random >> 29 ) );
+    }
+  return data;
+}
+
+// Inflates a gzip stream with zlib alone, as other programs do.
+bool InflateWithZlib(const ByteArrayType & stream, ByteArrayType & data)
+{
+  z_stream z;
+  memset( &z, 0, sizeof( z ) );
+  inflateInit2(&z, MAX_WBITS + 16);
+  z.next_in = const_cast< Bytef * >( &stream[0] );
+  z.avail_in = static_cast< uInt >( stream.size() );
+  unsigned char dummy;
+  z.next_out = data.empty() ? &dummy : &data[0];
+  z.avail_out = static_cast< uInt >( data.size() );
+  const int result = inflate(&z, Z_FINISH);
+  inflateEnd(&z);
+  return result == Z_STREAM_END && z.total_out == data.size() && z.avail_in == 0;
+}
+
+bool TestCodec(size_t numberOfBytes, size_t blockSize, itk::ThreadIdType numberOfThreads)
+{
+  std::cout << "Codec with " << numberOfBytes << " bytes in blocks of " << blockSize
+            << " with " << numberOfThreads << " threads" << std::endl;
+
+  const ByteArrayType data = MakeData(numberOfBytes);
+
+  itk::ParallelGzipCodec::Pointer codec = itk::ParallelGzipCodec::New();
+  codec->SetBlockSize(blockSize);
+  codec->SetNumberOfThreads(numberOfThreads);
+  ByteArrayType stream;
+  codec->Compress(data.empty() ? 0 : &data[0], data.size(), stream);
+
+  if ( !itk::ParallelGzipCodec::IsIndexed( &stream[0], stream.size() ) )
+    {
+    std::cerr << "The stream has no index" << std::endl;
+    return false;
+    }
+
+  ByteArrayType inflated(numberOfBytes);
+  if ( !InflateWithZlib(stream, inflated) || inflated != data )
+    {
+    std::cerr << "zlib does not inflate the stream" << std::endl;
+    return false;
+    }
+
+  // all of it, and ranges starting and ending within blocks
+  const size_t offsets[] = { 0, 1, blockSize - 1, blockSize + 7, numberOfBytes / 2 };
+  for ( unsigned int i = 0; i < sizeof( offsets ) / sizeof( offsets[0] ); ++i )
+    {
+    if ( offsets[i] > numberOfBytes )
+      {
+      continue;
+      }
+    const size_t  length = i == 0 ? numberOfBytes : ( numberOfBytes - offsets[i] ) / 2 + 1;
+    const size_t  count = std::min(length, numberOfBytes - offsets[i]);
+    ByteArrayType part(count + 1, 0xAB);
+    codec->Decompress(&stream[0], stream.size(), &part[0], count, offsets[i]);
+    if ( !std::equal( data.begin() + offsets[i], data.begin() + offsets[i] + count, part.begin() )
+         || part[count] != 0xAB )
+      {
+      std::cerr << "Bytes " << offsets[i] << " to " << offsets[i] + count
+                << " were not decompressed correctly" << std::endl;
+      return false;
+      }
+    }
+
+  // more than the stream holds
+  ByteArrayType tooMany(numberOfBytes + 1);
+  try
+    {
+    codec->Decompress(&stream[0], stream.size(), &tooMany[0], tooMany.size());
+    std::cerr << "Decompressing more bytes than the stream holds did not throw" << std::endl;
+    return false;
+    }
+  catch ( itk::ExceptionObject & )
+    {}
+
+  // damaged data
+  if ( numberOfBytes > 0 )
+    {
+    ByteArrayType damaged = stream;
+    damaged[damaged.size() - 9] ^= 0x55;
+    try
+      {
+      codec->Decompress(&damaged[0], damaged.size(), &inflated[0], inflated.size());
+      std::cerr << "Decompressing a damaged stream did not throw" << std::endl;
+      return false;
+      }
+    catch ( itk::ExceptionObject & )
+      {}
+    }
+  return true;
+}
+
+bool TestPrefix(size_t prefixSize, size_t numberOfBytes, size_t blockSize)
+{
+  std::cout << "Codec with a prefix of " << prefixSize << " bytes and " << numberOfBytes
+            << " bytes in blocks of " << blockSize << std::endl;
+
+  const ByteArrayType data = MakeData(prefixSize + numberOfBytes);
+
+  itk::ParallelGzipCodec::Pointer codec = itk::ParallelGzipCodec::New();
+  codec->SetBlockSize(blockSize);
+  codec->SetNumberOfThreads(3);
+  ByteArrayType stream;
+  codec->Compress(&data[0], prefixSize, &data[prefixSize], numberOfBytes, stream);
+
+  ByteArrayType inflated( data.size() );
+  ByteArrayType decompressed( data.size() );
+  codec->Decompress(&stream[0], stream.size(), &decompressed[0], decompressed.size());
+  if ( !InflateWithZlib(stream, inflated) || inflated != data || decompressed != data )
+    {
+    std::cerr << "The prefix and the data were not compressed together" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+bool TestZlibStream()
+{
+  std::cout << "Codec with a zlib stream" << std::endl;
+
+  const ByteArrayType data = MakeData(100000);
+  uLongf              compressedSize = compressBound( static_cast< uLong >( data.size() ) );
+  ByteArrayType       stream(compressedSize);
+  compress(&stream[0], &compressedSize, &data[0], static_cast< uLong >( data.size() ) );
+  stream.resize(compressedSize);
+
+  if ( itk::ParallelGzipCodec::IsIndexed( &stream[0], stream.size() ) )
+    {
+    std::cerr << "A zlib stream is taken for an indexed one" << std::endl;
+    return false;
+    }
+
+  itk::ParallelGzipCodec::Pointer codec = itk::ParallelGzipCodec::New();
+  ByteArrayType                   part(5000);
+  codec->Decompress(&stream[0], stream.size(), &part[0], part.size(), 70000);
+  if ( !std::equal( part.begin(), part.end(), data.begin() + 70000 ) )
+    {
+    std::cerr << "The zlib stream was not decompressed correctly" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+typedef itk::Image< float, 3 > ImageType;
+
+bool HasIndexedStream(const std::string & fileName)
+{
+  std::ifstream file(fileName.c_str(), std::ios::in | std::ios::binary);
+  std::string   contents( ( std::istreambuf_iterator< char >(file) ), std::istreambuf_iterator< char >() );
+  // the stream follows the header, if any
+  for ( size_t position = contents.find("\x1f\x8b"); position != std::string::npos;
+        position = contents.find("\x1f\x8b", position + 1) )
+    {
+    if ( itk::ParallelGzipCodec::IsIndexed(contents.data() + position, contents.size() - position) )
+      {
+      return true;
+      }
+    }
+  return false;
+}
+
+bool SamePixels(const ImageType *image, const ImageType *readImage, const std::string & fileName)
+{
+  itk::ImageRegionConstIterator< ImageType > it( image, image->GetBufferedRegion() );
+  itk::ImageRegionConstIterator< ImageType > rit( readImage, image->GetBufferedRegion() );
+  for ( it.GoToBegin(), rit.GoToBegin(); !it.IsAtEnd(); ++it, ++rit )
+    {
+    if ( it.Get() != rit.Get() )
+      {
+      std::cerr << fileName << ": pixel " << it.GetIndex() << " is " << rit.Get()
+                << " instead of " << it.Get() << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+// Checks that defaultIO writes fileName without an indexed stream, that
+// parallelIO writes one, and that defaultIO reads it.
+bool TestOptIn(ImageType *image, const std::string & fileName,
+               itk::ImageIOBase *defaultIO, itk::ImageIOBase *parallelIO)
+{
+  typedef itk::ImageFileWriter< ImageType > WriterType;
+  typedef itk::ImageFileReader< ImageType > ReaderType;
+
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetInput(image);
+  writer->SetFileName(fileName);
+  writer->UseCompressionOn();
+  writer->SetImageIO(defaultIO);
+  writer->Update();
+  if ( HasIndexedStream(fileName) )
+    {
+    std::cerr << fileName << " was compressed in parallel by default" << std::endl;
+    return false;
+    }
+
+  writer->SetImageIO(parallelIO);
+  writer->Update();
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName(fileName);
+  reader->SetImageIO(defaultIO);
+  reader->Update();
+  return HasIndexedStream(fileName) && SamePixels(image, reader->GetOutput(), fileName);
+}
+
+// Writes and reads the image with io, returning the times
+// taken, or negative times on failure.
+void WriteAndRead(ImageType *image, const std::string & fileName, itk::ImageIOBase *io,
+                  double & writeTime, double & readTime)
+{
+  typedef itk::ImageFileWriter< ImageType > WriterType;
+  typedef itk::ImageFileReader< ImageType > ReaderType;
+
+  writeTime = -1.0;
+  readTime = -1.0;
+
+  itk::TimeProbe writeProbe;
+  writeProbe.Start();
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetInput(image);
+  writer->SetFileName(fileName);
+  writer->UseCompressionOn();
+  writer->SetImageIO(io);
+  writer->Update();
+  writeProbe.Stop();
+
+  if ( !HasIndexedStream(fileName) )
+    {
+    std::cerr << fileName << " was not compressed in parallel" << std::endl;
+    return;
+    }
+
+  itk::TimeProbe readProbe;
+  readProbe.Start();
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName(fileName);
+  reader->SetImageIO(io);
+  reader->Update();
+  readProbe.Stop();
+
+  if ( !SamePixels(image, reader->GetOutput(), fileName) )
+    {
+    return;
+    }
+  writeTime = writeProbe.GetTotal();
+  readTime = readProbe.GetTotal();
+}
+}
+
+int itkParallelGzipCodecTest(int argc, char *argv[])
+{
+  if ( argc < 2 )
+    {
+    std::cerr << "Usage: " << argv[0] << " outputDirectory [edgeLength]" << std::endl;
+    return EXIT_FAILURE;
+    }
+  const std::string directory = argv[1];
+  unsigned int      edgeLength = 128;
+  if ( argc > 2 )
+    {
+    edgeLength = atoi(argv[2]);
+    }
+
+  if ( !TestCodec(0, 1024, 2)
+       || !TestCodec(1, 1024, 2)
+       || !TestCodec(1024, 1024, 3)
+       || !TestCodec(100000, 1024, 1)
+       || !TestCodec(100000, 1024, 4)
+       || !TestCodec(3000000, 1 << 20, 4)
+       || !TestPrefix(352, 100000, 1024)
+       || !TestPrefix(3000, 100000, 1024)
+       || !TestPrefix(2048, 0, 1024)
+       || !TestZlibStream() )
+    {
+    return EXIT_FAILURE;
+    }
+
+  ImageType::Pointer  image = ImageType::New();
+  ImageType::SizeType size;
+  size.Fill(edgeLength);
+  image->SetRegions(size);
+  image->Allocate();
+  unsigned int                          random = 12345;
+  itk::ImageRegionIterator< ImageType > it( image, image->GetBufferedRegion() );
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    const ImageType::IndexType index = it.GetIndex();
+    random = random * 1103515245 + 12345;
+    it.Set( static_cast< float >( index[0] + index[1] + index[2] + ( random >> 28 ) ) );
+    }
+
+  // MetaImageIO leaves compression to MetaIO unless asked otherwise, and
+  // MetaIO reads the indexed streams written when asked.
+  typedef itk::ImageFileWriter< ImageType > WriterType;
+  typedef itk::ImageFileReader< ImageType > ReaderType;
+  const std::string   metaFileName = directory + "/ParallelGzipCodecTest.mha";
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetInput(image);
+  writer->SetFileName(metaFileName);
+  writer->UseCompressionOn();
+  writer->SetImageIO( itk::MetaImageIO::New() );
+  writer->Update();
+  if ( HasIndexedStream(metaFileName) )
+    {
+    std::cerr << "MetaImageIO compressed in parallel by default" << std::endl;
+    return EXIT_FAILURE;
+    }
+  itk::MetaImageIO::Pointer parallelMetaIO = itk::MetaImageIO::New();
+  parallelMetaIO->UseParallelCompressionOn();
+  writer->SetImageIO(parallelMetaIO);
+  writer->Update();
+  ReaderType::Pointer reader = ReaderType::New();
+  reader->SetFileName(metaFileName);
+  reader->SetImageIO( itk::MetaImageIO::New() );
+  reader->Update();
+  if ( !HasIndexedStream(metaFileName) || !SamePixels(image, reader->GetOutput(), metaFileName) )
+    {
+    return EXIT_FAILURE;
+    }
+
+  // the same with the data in a file of its own
+  const std::string headerFileName = directory + "/ParallelGzipCodecTest.mhd";
+  writer->SetFileName(headerFileName);
+  writer->Update();
+  reader->SetFileName(headerFileName);
+  reader->Update();
+  if ( !HasIndexedStream(directory + "/ParallelGzipCodecTest.zraw")
+       || !SamePixels(image, reader->GetOutput(), headerFileName) )
+    {
+    return EXIT_FAILURE;
+    }
+  reader->SetImageIO(parallelMetaIO);
+  reader->Update();
+  if ( !SamePixels(image, reader->GetOutput(), headerFileName) )
+    {
+    return EXIT_FAILURE;
+    }
+
+  // NIfTI and NRRD likewise
+  itk::NiftiImageIO::Pointer parallelNiftiIO = itk::NiftiImageIO::New();
+  parallelNiftiIO->UseParallelCompressionOn();
+  itk::NrrdImageIO::Pointer parallelNrrdIO = itk::NrrdImageIO::New();
+  parallelNrrdIO->UseParallelCompressionOn();
+  if ( !TestOptIn(image, directory + "/ParallelGzipCodecTest.nii.gz",
+                  itk::NiftiImageIO::New(), parallelNiftiIO)
+       || !TestOptIn(image, directory + "/ParallelGzipCodecTest.nrrd",
+                     itk::NrrdImageIO::New(), parallelNrrdIO) )
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Benchmark.
+  const char *extensions[] = { ".mha", ".nii.gz", ".nrrd" };
+  itk::ImageIOBase::Pointer ios[] = { parallelMetaIO.GetPointer(), parallelNiftiIO.GetPointer(),
+                                      parallelNrrdIO.GetPointer() };
+  const itk::ThreadIdType maximumNumberOfThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+  const double            megabytes = image->GetPixelContainer()->Size() * sizeof( float ) / 1e6;
+
+  std::cout << "Float image of " << edgeLength << "^3 pixels (" << megabytes << " MB)" << std::endl;
+  for ( unsigned int e = 0; e < sizeof( extensions ) / sizeof( extensions[0] ); ++e )
+    {
+    const std::string fileName = directory + "/ParallelGzipCodecTest" + extensions[e];
+    for ( itk::ThreadIdType threads = 1; ; threads = std::min(2 * threads, maximumNumberOfThreads) )
+      {
+      itk::MultiThreader::SetGlobalDefaultNumberOfThreads(threads);
+      double writeTime;
+      double readTime;
+      WriteAndRead(image, fileName, ios[e], writeTime, readTime);
+      if ( writeTime < 0.0 )
+        {
+        return EXIT_FAILURE;
+        }
+      std::cout << "  " << extensions[e] << " with " << threads << " threads: write "
+                << megabytes / writeTime << " MB/s, read " << megabytes / readTime << " MB/s" << std::endl;
+      if ( threads == maximumNumberOfThreads )
+        {
+        break;
+        }
+      }
+    itk::MultiThreader::SetGlobalDefaultNumberOfThreads(maximumNumberOfThreads);
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -30,6 +30,10 @@ namespace itk
  *
  *  \brief Read MetaImage file format.
  *
+ *  With UseParallelCompression on, compressed element data is written as
+ *  a gzip stream compressed, and read back, with several threads by
+ *  ParallelGzipCodec.
+ *
  *  \ingroup IOFilters
  * \ingroup ITKIOMeta
  */
@@ -69,6 +73,11 @@ public:
   /** Reads the data from disk into the memory buffer provided. */
   virtual void Read(void *buffer);
 
+  /** Maps the pixels of uncompressed binary data stored in a single file,
+   * either the header file or a separate one, in the byte order of this
+   * system. */
+  virtual MemoryMappedFileRegion::Pointer MapIORegion();
+
   MetaImage * GetMetaImagePointer(void);
 
   /*-------- This part of the interfaces deals with writing data. ----- */
@@ -126,6 +135,14 @@ public:
     return true;
   }
 
+  /** Determine if another instance of the ImageIO may read on a
+   *  background thread while this one is in use.  MetaIO keeps no
+   *  state shared between MetaImage objects. */
+  virtual bool CanPrefetchRead()
+  {
+    return true;
+  }
+
   /** Determine if the ImageIO can stream writing to this
    *  file. Only time cannot stream read/write is if compression is used.
    *  Assumes file passes a CanRead call and its pixels are of the same
@@ -145,6 +162,18 @@ public:
    * \warning this is only used when streaming is on. */
   itkSetMacro(SubSamplingFactor, unsigned int);
   itkGetConstMacro(SubSamplingFactor, unsigned int);
+
+  /** Set/Get whether compressed images are written, and read, with
+   *  several threads by ParallelGzipCodec.  Images are then written as
+   *  indexed gzip streams, which MetaIO and zlib inflate like any other,
+   *  and indexed streams are read by inflating their blocks in parallel,
+   *  after reading the whole compressed data into memory.  Off by
+   *  default, in which case MetaIO compresses images as zlib streams and
+   *  inflates all streams itself.  Images streamed or split into several
+   *  data files are always left to MetaIO. */
+  itkSetMacro(UseParallelCompression, bool);
+  itkGetConstMacro(UseParallelCompression, bool);
+  itkBooleanMacro(UseParallelCompression);
 protected:
   MetaImageIO();
   ~MetaImageIO();
@@ -152,12 +181,28 @@ protected:
 
 private:
 
-  MetaImage m_MetaImage;
+  /** A MetaImage that can also write element data compressed beforehand. */
+  class PrecompressedMetaImage:public MetaImage
+  {
+public:
+    /** Write the header and the compressedDataSize bytes of compressed
+     *  element data, naming the files as Write() does. */
+    bool WriteCompressed(const char *headName, const void *compressedData,
+                         METAIO_STL::streamoff compressedDataSize);
+  };
+
+  /** Read the element data of the whole image into buffer, inflating it
+   *  with several threads, if it is a single indexed gzip stream.
+   *  Returns false, having read nothing, otherwise. */
+  bool ReadIndexedGzipElements(void *buffer);
+
+  PrecompressedMetaImage m_MetaImage;
 
   MetaImageIO(const Self &);    //purposely not implemented
   void operator=(const Self &); //purposely not implemented
 
   unsigned int m_SubSamplingFactor;
+  bool         m_UseParallelCompression;
 };
 } // end namespace itk
 
@@ -23,14 +23,70 @@
 #include "itkSpatialOrientationAdapter.h"
 #include "itkMetaDataObject.h"
 #include "itkIOCommon.h"
+#include "itkParallelGzipCodec.h"
 #include "itksys/SystemTools.hxx"
 
 namespace itk
 {
+namespace
+{
+// Returns the position of the first byte after the ElementDataFile line
+// of the header, where the data of LOCAL files starts, or -1.
+ImageIOBase::SizeType GetLocalDataPosition(const std::string & fileName)
+{
+  std::ifstream file(fileName.c_str(), std::ios::in | std::ios::binary);
+  std::string   line;
+
+  while ( std::getline(file, line) )
+    {
+    std::istringstream key( line.substr( 0, line.find('=') ) );
+    std::string        keyword;
+    std::string        rest;
+    if ( key >> keyword && keyword == "ElementDataFile" && !( key >> rest )
+         && line.find('=') != std::string::npos )
+      {
+      return static_cast< ImageIOBase::SizeType >( file.tellg() );
+      }
+    }
+  return -1;
+}
+
+// Returns the name of the file holding the element data of a MetaImage
+// read from headerFileName, found the way MetaImage::M_ReadElements()
+// does, or an empty string if the data is split into several files.
+// Sets local to whether the data follows the header.
+std::string GetDataFileName(const MetaImage & metaImage, const std::string & headerFileName,
+                            bool & local)
+{
+  std::string dataFileName = metaImage.ElementDataFileName();
+  if ( dataFileName.compare(0, 4, "LIST") == 0
+       || dataFileName.find('%') != std::string::npos )
+    {
+    return std::string();
+    }
+
+  local = itksys::SystemTools::UpperCase(dataFileName) == "LOCAL";
+  if ( local )
+    {
+    dataFileName = headerFileName;
+    }
+  else if ( !itksys::SystemTools::FileIsFullPath( dataFileName.c_str() ) )
+    {
+    const std::string path = itksys::SystemTools::GetFilenamePath(headerFileName);
+    if ( !path.empty() )
+      {
+      dataFileName = path + "/" + dataFileName;
+      }
+    }
+  return dataFileName;
+}
+}
+
 MetaImageIO::MetaImageIO()
 {
   m_FileType = Binary;
   m_SubSamplingFactor = 1;
+  m_UseParallelCompression = false;
   if ( MET_SystemByteOrderMSB() )
     {
     m_ByteOrder = BigEndian;
@@ -55,6 +111,7 @@ void MetaImageIO::PrintSelf(std::ostream & os, Indent indent) const
   Superclass::PrintSelf(os, indent);
   m_MetaImage.PrintInfo();
   os << indent << "SubSamplingFactor: " << m_SubSamplingFactor << "\n";
+  os << indent << "UseParallelCompression: " << m_UseParallelCompression << "\n";
 }
 
 void MetaImageIO::SetDataFileName(const char *filename)
@@ -476,7 +533,8 @@ void MetaImageIO::Read(void *buffer)
     }
   else
     {
-    if ( !m_MetaImage.Read(m_FileName.c_str(), true, buffer) )
+    if ( !( m_UseParallelCompression && this->ReadIndexedGzipElements(buffer) )
+         && !m_MetaImage.Read(m_FileName.c_str(), true, buffer) )
       {
       itkExceptionMacro( "File cannot be read: "
                          << this->GetFileName() << " for reading."
@@ -490,6 +548,152 @@ void MetaImageIO::Read(void *buffer)
     }
 }
 
+MemoryMappedFileRegion::Pointer MetaImageIO::MapIORegion()
+{
+  if ( !m_MetaImage.BinaryData()
+       || m_MetaImage.CompressedData()
+       || m_SubSamplingFactor != 1
+       || ( this->GetComponentSize() > 1
+            && m_MetaImage.BinaryDataByteOrderMSB() != MET_SystemByteOrderMSB() ) )
+    {
+    return 0;
+    }
+
+  // data split into several files, one per slice or volume, cannot be
+  // mapped at once
+  bool              local = false;
+  const std::string dataFileName = GetDataFileName(m_MetaImage, m_FileName, local);
+  if ( dataFileName.empty() )
+    {
+    return 0;
+    }
+
+  SizeType dataPosition = 0;
+  if ( m_MetaImage.HeaderSize() > 0 )
+    {
+    dataPosition = m_MetaImage.HeaderSize();
+    }
+  else if ( m_MetaImage.HeaderSize() == -1 )
+    {
+    // the data is at the end of the file
+    dataPosition = static_cast< SizeType >( itksys::SystemTools::FileLength( dataFileName.c_str() ) )
+                   - static_cast< SizeType >( this->GetImageSizeInBytes() );
+    }
+  else if ( local )
+    {
+    dataPosition = GetLocalDataPosition(dataFileName);
+    }
+
+  if ( dataPosition < 0 )
+    {
+    return 0;
+    }
+  return this->MapIORegionOfFile(dataFileName, dataPosition);
+}
+
+bool MetaImageIO::ReadIndexedGzipElements(void *buffer)
+{
+  // the data must be a single indexed stream, following the header or
+  // alone in its file
+  bool              local = false;
+  const std::string dataFileName = GetDataFileName(m_MetaImage, m_FileName, local);
+  if ( !m_MetaImage.BinaryData() || !m_MetaImage.CompressedData()
+       || m_MetaImage.HeaderSize() != 0 || dataFileName.empty() )
+    {
+    return false;
+    }
+  const SizeType dataPosition = local ? GetLocalDataPosition(dataFileName) : 0;
+  if ( dataPosition < 0 )
+    {
+    return false;
+    }
+
+  std::ifstream file(dataFileName.c_str(), std::ios::in | std::ios::binary);
+  if ( !file.seekg(0, std::ios::end) )
+    {
+    return false;
+    }
+  const SizeType fileLength = static_cast< SizeType >( file.tellg() );
+  if ( fileLength <= dataPosition )
+    {
+    return false;
+    }
+  ParallelGzipCodec::StreamType stream( static_cast< size_t >( fileLength - dataPosition ) );
+  file.seekg(dataPosition, std::ios::beg);
+  if ( !file.read( reinterpret_cast< char * >( &stream[0] ), stream.size() )
+       || !ParallelGzipCodec::IsIndexed( &stream[0], stream.size() ) )
+    {
+    return false;
+    }
+
+  ParallelGzipCodec::Pointer codec = ParallelGzipCodec::New();
+  codec->Decompress( &stream[0], stream.size(), buffer,
+                     static_cast< ParallelGzipCodec::SizeType >( this->GetImageSizeInBytes() ) );
+
+  // let ElementByteOrderFix() swap the pixels read
+  m_MetaImage.ElementData(buffer, false);
+  return true;
+}
+
+bool MetaImageIO::PrecompressedMetaImage
+::WriteCompressed(const char *headName, const void *compressedData,
+                  METAIO_STL::streamoff compressedDataSize)
+{
+  FileName(headName);
+
+  // name the data file as MetaImage::Write() does
+  const bool userDataFileName = strlen(m_ElementDataFileName) > 0;
+  if ( !userDataFileName )
+    {
+    int suffixPosition = 0;
+    MET_GetFileSuffixPtr(m_FileName, &suffixPosition);
+    if ( !strcmp(&m_FileName[suffixPosition], "mha") )
+      {
+      ElementDataFileName("LOCAL");
+      }
+    else
+      {
+      MET_SetFileSuffix(m_FileName, "mhd");
+      strcpy(m_ElementDataFileName, m_FileName);
+      MET_SetFileSuffix(m_ElementDataFileName, "zraw");
+      }
+    }
+  MET_SetFileSuffix(m_FileName, strcmp(m_ElementDataFileName, "LOCAL") ? "mhd" : "mha");
+
+  char pathName[sizeof( m_FileName )];
+  if ( MET_GetFilePath(m_FileName, pathName) )
+    {
+    char elementPathName[sizeof( m_ElementDataFileName )];
+    MET_GetFilePath(m_ElementDataFileName, elementPathName);
+    if ( !strcmp(pathName, elementPathName) )
+      {
+      strcpy(elementPathName, &m_ElementDataFileName[strlen(pathName)]);
+      strcpy(m_ElementDataFileName, elementPathName);
+      }
+    }
+
+  METAIO_STREAM::ofstream stream(m_FileName, METAIO_STREAM::ios::binary | METAIO_STREAM::ios::out);
+  const bool              opened = stream.is_open();
+  if ( opened )
+    {
+    // the header records the size of the compressed data, which follows
+    // it or goes to the data file
+    m_WriteStream = &stream;
+    m_CompressedDataSize = compressedDataSize;
+    M_SetupWriteFields();
+    M_Write();
+    M_WriteElements(&stream, compressedData, compressedDataSize);
+    m_CompressedDataSize = 0;
+    m_WriteStream = NULL;
+    }
+
+  if ( !userDataFileName )
+    {
+    ElementDataFileName("");
+    }
+  return opened && !stream.fail();
+}
+
 MetaImage * MetaImageIO::GetMetaImagePointer(void)
 {
   return &m_MetaImage;
@@ -1076,7 +1280,22 @@ MetaImageIO
     }
   else
     {
-    if ( !m_MetaImage.Write( m_FileName.c_str() ) )
+    bool written;
+    if ( m_UseCompression && m_UseParallelCompression && m_MetaImage.BinaryData()
+         && std::string( m_MetaImage.ElementDataFileName() ).find('%') == std::string::npos )
+      {
+      ParallelGzipCodec::StreamType stream;
+      ParallelGzipCodec::Pointer    codec = ParallelGzipCodec::New();
+      codec->Compress(buffer, static_cast< ParallelGzipCodec::SizeType >( this->GetImageSizeInBytes() ),
+                      stream);
+      written = m_MetaImage.WriteCompressed( m_FileName.c_str(), &stream[0],
+                                             static_cast< METAIO_STL::streamoff >( stream.size() ) );
+      }
+    else
+      {
+      written = m_MetaImage.Write( m_FileName.c_str() );
+      }
+    if ( !written )
       {
       itkExceptionMacro( "File cannot be written: "
                          << this->GetFileName()
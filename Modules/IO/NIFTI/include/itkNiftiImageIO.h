@@ -38,6 +38,9 @@ namespace itk
  * \brief Class that defines how to read Nifti file format.
  * Nifti IMAGE FILE FORMAT - As much information as I can determine from sourceforge.net/projects/Niftilib
  *
+ * With UseParallelCompression on, single .nii.gz files are compressed,
+ * and read back, with several threads by ParallelGzipCodec.
+ *
  * \ingroup IOFilters
  * \ingroup ITKIONIFTI
  */
@@ -100,6 +103,16 @@ public:
     */
   itkSetMacro(LegacyAnalyze75Mode, bool);
   itkGetConstMacro(LegacyAnalyze75Mode, bool);
+
+  /** Set/Get whether single .nii.gz files without extensions are written,
+   *  and read, with several threads by ParallelGzipCodec.  They are then
+   *  written as indexed gzip streams, which nifti and zlib inflate like
+   *  any other, and indexed streams are read by inflating their blocks in
+   *  parallel, after reading the whole compressed file into memory.  Off
+   *  by default, in which case nifti writes and reads all files. */
+  itkSetMacro(UseParallelCompression, bool);
+  itkGetConstMacro(UseParallelCompression, bool);
+  itkBooleanMacro(UseParallelCompression);
 protected:
   NiftiImageIO();
   ~NiftiImageIO();
@@ -117,6 +130,20 @@ private:
 
   void  SetImageIOMetadataFromNIfTI();
 
+  /** Loads the data of a single .nii.gz file that holds an indexed
+   * stream of ParallelGzipCodec, inflating its blocks with several
+   * threads.  The whole compressed file is first read into memory with
+   * ReadFileStart(), so reading takes that much memory on top of the
+   * image.  Returns false, having loaded nothing, for other files,
+   * which nifti then loads. */
+  bool  LoadIndexedGzipImage();
+
+  /** Writes single .nii.gz files without extensions with several
+   * threads if UseParallelCompression is on, and lets nifti write other
+   * files.  The header is compressed with the data, which is not
+   * copied. */
+  void  WriteNiftiImage();
+
   nifti_image *m_NiftiImage;
 
   double m_RescaleSlope;
@@ -126,6 +153,8 @@ private:
 
   bool m_LegacyAnalyze75Mode;
 
+  bool m_UseParallelCompression;
+
   NiftiImageIO(const Self &);   //purposely not implemented
   void operator=(const Self &); //purposely not implemented
 };
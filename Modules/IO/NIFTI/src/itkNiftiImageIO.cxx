@@ -21,6 +21,7 @@
 #include "itkMetaDataObject.h"
 #include "itkSpatialOrientationAdapter.h"
 #include "itkNumericTraits.h"
+#include "itkParallelGzipCodec.h"
 #include "itksys/SystemTools.hxx"
 #include "vnl/vnl_math.h"
 #include "itk_zlib.h"
@@ -360,7 +361,8 @@ NiftiImageIO::NiftiImageIO():
   m_RescaleSlope(1.0),
   m_RescaleIntercept(0.0),
   m_OnDiskComponentType(UNKNOWNCOMPONENTTYPE),
-  m_LegacyAnalyze75Mode(true)
+  m_LegacyAnalyze75Mode(true),
+  m_UseParallelCompression(false)
 {
   this->SetNumberOfDimensions(3);
   nifti_set_debug_level(0); // suppress error messages
@@ -391,6 +393,7 @@ NiftiImageIO
 {
   Superclass::PrintSelf(os, indent);
   os << indent << "LegacyAnalyze75Mode: " << this->m_LegacyAnalyze75Mode << std::endl;
+  os << indent << "UseParallelCompression: " << this->m_UseParallelCompression << std::endl;
 }
 
 bool
@@ -502,7 +505,8 @@ void NiftiImageIO::Read(void *buffer)
   // all data as a block
   if ( i == this->GetNumberOfDimensions() )
     {
-    if ( nifti_image_load(this->m_NiftiImage) == -1 )
+    if ( !( this->m_UseParallelCompression && this->LoadIndexedGzipImage() )
+         && nifti_image_load(this->m_NiftiImage) == -1 )
       {
       itkExceptionMacro( << "nifti_image_load failed for file: "
                          << this->GetFileName() );
@@ -1853,6 +1857,134 @@ NiftiImageIO::SetNIfTIOrientationFromImageIO(unsigned short int origdims, unsign
   //  this->m_NiftiImage->sform_code = 0;
 }
 
+namespace
+{
+// Sets non-finite values to 0, as nifti does when reading.
+template< class TValue >
+void ReplaceNonFiniteValues(void *data, size_t numberOfBytes)
+{
+  TValue *values = static_cast< TValue * >( data );
+  const size_t numberOfValues = numberOfBytes / sizeof( TValue );
+  for ( size_t i = 0; i < numberOfValues; ++i )
+    {
+    if ( !vnl_math_isfinite(values[i]) )
+      {
+      values[i] = 0;
+      }
+    }
+}
+
+// Reads at most length bytes of a file from its start, or all of them
+// if length is 0.
+bool ReadFileStart(const char *fileName, ParallelGzipCodec::StreamType & bytes, size_t length)
+{
+  std::ifstream file(fileName, std::ios::in | std::ios::binary);
+  if ( !file.seekg(0, std::ios::end) )
+    {
+    return false;
+    }
+  const std::streamoff fileLength = file.tellg();
+  if ( fileLength <= 0 )
+    {
+    return false;
+    }
+  bytes.resize( length > 0 && static_cast< std::streamoff >( length ) < fileLength
+                ? length : static_cast< size_t >( fileLength ) );
+  file.seekg(0, std::ios::beg);
+  return !!file.read( reinterpret_cast< char * >( &bytes[0] ), bytes.size() );
+}
+}
+
+bool
+NiftiImageIO
+::LoadIndexedGzipImage()
+{
+  nifti_image *nim = this->m_NiftiImage;
+  if ( nim->nifti_type != NIFTI_FTYPE_NIFTI1_1 || nim->iname == NULL
+       || !nifti_is_gzfile(nim->iname) || nim->iname_offset < 0 )
+    {
+    return false;
+    }
+
+  // only read the whole stream if its header has the index
+  ParallelGzipCodec::StreamType stream;
+  if ( !ReadFileStart(nim->iname, stream, 12 + 65535)
+       || !ParallelGzipCodec::IsIndexed( &stream[0], stream.size() )
+       || !ReadFileStart(nim->iname, stream, 0) )
+    {
+    return false;
+    }
+
+  // malloc, since nifti frees it
+  const size_t numberOfBytes = nifti_get_volsize(nim);
+  void *       data = malloc(numberOfBytes);
+  if ( data == NULL )
+    {
+    itkExceptionMacro(<< "Could not allocate " << numberOfBytes << " bytes for "
+                      << this->GetFileName() );
+    }
+  try
+    {
+    ParallelGzipCodec::Pointer codec = ParallelGzipCodec::New();
+    codec->Decompress(&stream[0], stream.size(), data, numberOfBytes, nim->iname_offset);
+    }
+  catch ( ExceptionObject & )
+    {
+    free(data);
+    throw;
+    }
+
+  // byte swap and fix bad floats, as nifti_read_buffer() does
+  if ( nim->swapsize > 1 && nim->byteorder != nifti_short_order() )
+    {
+    nifti_swap_Nbytes(numberOfBytes / nim->swapsize, nim->swapsize, data);
+    }
+  switch ( nim->datatype )
+    {
+    case NIFTI_TYPE_FLOAT32:
+    case NIFTI_TYPE_COMPLEX64:
+      ReplaceNonFiniteValues< float >(data, numberOfBytes);
+      break;
+    case NIFTI_TYPE_FLOAT64:
+    case NIFTI_TYPE_COMPLEX128:
+      ReplaceNonFiniteValues< double >(data, numberOfBytes);
+      break;
+    }
+  nim->data = data;
+  return true;
+}
+
+void
+NiftiImageIO
+::WriteNiftiImage()
+{
+  nifti_image *nim = this->m_NiftiImage;
+  if ( !this->m_UseParallelCompression
+       || nim->nifti_type != NIFTI_FTYPE_NIFTI1_1 || !nifti_is_gzfile(nim->fname)
+       || ( nim->num_ext > 0 && nim->ext_list != NULL ) )
+    {
+    nifti_image_write(nim);
+    return;
+    }
+
+  // the header and an extender announcing no extensions, followed by
+  // the data
+  nifti_set_iname_offset(nim);
+  const struct nifti_1_header header = nifti_convert_nim2nhdr(nim);
+  std::vector< char >         headerBytes(nim->iname_offset, 0);
+  memcpy( &headerBytes[0], &header, sizeof( header ) );
+
+  ParallelGzipCodec::Pointer    codec = ParallelGzipCodec::New();
+  ParallelGzipCodec::StreamType stream;
+  codec->Compress(&headerBytes[0], headerBytes.size(), nim->data, nifti_get_volsize(nim), stream);
+
+  std::ofstream file(nim->fname, std::ios::out | std::ios::binary);
+  if ( !file.write( reinterpret_cast< const char * >( &stream[0] ), stream.size() ) )
+    {
+    itkExceptionMacro(<< "Could not write " << nim->fname);
+    }
+}
+
 /**
  * Write the image Information before writing data
  */
@@ -1870,7 +2002,7 @@ NiftiImageIO
     // Need a const cast here so that we don't have to copy the memory
     // for writing.
     this->m_NiftiImage->data = const_cast< void * >( buffer );
-    nifti_image_write(this->m_NiftiImage);
+    this->WriteNiftiImage();
     this->m_NiftiImage->data = 0; // if left pointing to data buffer
     // nifti_image_free will try and free this memory
     }
@@ -1952,7 +2084,7 @@ NiftiImageIO
     //Need a const cast here so that we don't have to copy the memory for
     //writing.
     this->m_NiftiImage->data = (void *)nifti_buf;
-    nifti_image_write(this->m_NiftiImage);
+    this->WriteNiftiImage();
     this->m_NiftiImage->data = 0; // if left pointing to data buffer
     delete[] nifti_buf;
     }
@@ -31,6 +31,10 @@ namespace itk
  * The Nrrd format was developed as part of the Teem package
  * (teem.sourceforge.net).
  *
+ * With UseParallelCompression on, gzip compressed data attached to the
+ * header is compressed, and read back, with several threads by
+ * ParallelGzipCodec.
+ *
  *  \ingroup IOFilters
  * \ingroup ITKIONRRD
  */
@@ -65,6 +69,11 @@ public:
   /** Reads the data from disk into the memory buffer provided. */
   virtual void Read(void *buffer);
 
+  /** Maps the pixels of raw encoded data stored in a single file, either
+   * the header file or a detached one, in the byte order of this system
+   * and with the pixel components on the fastest axis. */
+  virtual MemoryMappedFileRegion::Pointer MapIORegion();
+
   /** Determine the file type. Returns true if this ImageIO can write the
    * file specified. */
   virtual bool CanWriteFile(const char *);
@@ -76,6 +85,17 @@ public:
    * that the IORegions has been set properly. */
   virtual void Write(const void *buffer);
 
+  /** Set/Get whether gzip compressed data is written, and read, with
+   *  several threads by ParallelGzipCodec.  Data attached to the header
+   *  is then written as an indexed gzip stream, which nrrd and zlib
+   *  inflate like any other, and indexed streams attached to the header
+   *  or in a single detached file are read by inflating their blocks in
+   *  parallel, after reading the whole compressed data into memory.  Off
+   *  by default, in which case nrrd writes and reads all data. */
+  itkSetMacro(UseParallelCompression, bool);
+  itkGetConstMacro(UseParallelCompression, bool);
+  itkBooleanMacro(UseParallelCompression);
+
 protected:
   NrrdImageIO();
   ~NrrdImageIO();
@@ -87,9 +107,16 @@ protected:
 
   ImageIOBase::IOComponentType NrrdToITKComponentType(const int) const;
 
+  /** Reads gzip encoded data written with several threads, as an indexed
+   * stream of ParallelGzipCodec, with as many.  Returns false, having
+   * read nothing, for data stored otherwise. */
+  bool ReadIndexedGzipData(void *buffer);
+
 private:
   NrrdImageIO(const Self &);    //purposely not implemented
   void operator=(const Self &); //purposely not implemented
+
+  bool m_UseParallelCompression;
 };
 } // end namespace itk
 
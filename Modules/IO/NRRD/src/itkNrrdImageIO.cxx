@@ -17,10 +17,13 @@
  *=========================================================================*/
 
 #include <string>
+#include <algorithm>
 #include "itkNrrdImageIO.h"
 #include "itkMetaDataObject.h"
 #include "itkIOCommon.h"
 #include "itkFloatingPointExceptions.h"
+#include "itkParallelGzipCodec.h"
+#include "itksys/SystemTools.hxx"
 
 namespace itk
 {
@@ -28,6 +31,7 @@ namespace itk
 
 NrrdImageIO::NrrdImageIO()
 {
+  m_UseParallelCompression = false;
   this->SetNumberOfDimensions(3);
   this->AddSupportedWriteExtension(".nrrd");
   this->AddSupportedReadExtension(".nrrd");
@@ -54,6 +58,7 @@ bool NrrdImageIO::SupportsDimension(unsigned long dim)
 void NrrdImageIO::PrintSelf(std::ostream & os, Indent indent) const
 {
   Superclass::PrintSelf(os, indent);
+  os << indent << "UseParallelCompression: " << m_UseParallelCompression << "\n";
 }
 
 ImageIOBase::IOComponentType
@@ -684,8 +689,187 @@ void NrrdImageIO::ReadImageInformation()
   nio = nrrdIoStateNix(nio);
 }
 
+MemoryMappedFileRegion::Pointer NrrdImageIO::MapIORegion()
+{
+  if ( ImageIOBase::SYMMETRICSECONDRANKTENSOR == this->GetPixelType() )
+    {
+    return 0;
+    }
+
+  Nrrd *       nrrd = nrrdNew();
+  NrrdIoState *nio = nrrdIoStateNew();
+
+  // nrrd causes exceptions on purpose, so mask them
+  bool saveFPEState( FloatingPointExceptions::GetExceptionAction() );
+  FloatingPointExceptions::Disable();
+
+  // read the header again, keeping the data file open and positioned
+  // at the start of the data, after any line and byte skipping
+  nrrdIoStateSet(nio, nrrdIoStateSkipData, 1);
+  nrrdIoStateSet(nio, nrrdIoStateKeepNrrdDataFileOpen, 1);
+  const int loadError = nrrdLoad(nrrd, this->GetFileName(), nio);
+
+  // restore state
+  FloatingPointExceptions::SetEnabled(saveFPEState);
+
+  if ( loadError )
+    {
+    biffDone(NRRD);
+    }
+
+  std::string dataFileName;
+  SizeType    dataPosition = -1;
+  if ( !loadError && nio->dataFile )
+    {
+    unsigned int rangeAxisIdx[NRRD_DIM_MAX];
+    const unsigned int rangeAxisNum = nrrdRangeAxesGet(nrrd, rangeAxisIdx);
+    const bool         nativeEndian = nio->endian == airEndianUnknown || nio->endian == AIR_ENDIAN
+                                      || nrrdElementSize(nrrd) == 1;
+
+    if ( nio->format == nrrdFormatNRRD
+         && nio->encoding == nrrdEncodingRaw
+         && nativeEndian
+         && ( rangeAxisNum == 0 || ( rangeAxisNum == 1 && rangeAxisIdx[0] == 0 ) ) )
+      {
+      // the data file is the header file itself, or the only detached
+      // one, which may be given relative to the header
+      if ( nio->dataFNArr->len == 0 )
+        {
+        dataFileName = this->GetFileName();
+        }
+      else if ( nio->dataFNArr->len == 1 && !nio->dataFNFormat )
+        {
+        dataFileName = nio->dataFN[0];
+        if ( !itksys::SystemTools::FileIsFullPath( dataFileName.c_str() ) && airStrlen(nio->path) )
+          {
+          dataFileName = std::string(nio->path) + "/" + dataFileName;
+          }
+        }
+      if ( !dataFileName.empty() )
+        {
+        dataPosition = static_cast< SizeType >( ftell(nio->dataFile) );
+        }
+      }
+    }
+
+  if ( nio->dataFile )
+    {
+    nio->dataFile = airFclose(nio->dataFile);
+    }
+  nrrd = nrrdNix(nrrd);
+  nio = nrrdIoStateNix(nio);
+
+  if ( dataPosition < 0 )
+    {
+    return 0;
+    }
+  return this->MapIORegionOfFile(dataFileName, dataPosition);
+}
+
+bool NrrdImageIO::ReadIndexedGzipData(void *buffer)
+{
+  if ( ImageIOBase::SYMMETRICSECONDRANKTENSOR == this->GetPixelType() )
+    {
+    return false;
+    }
+
+  Nrrd *       nrrd = nrrdNew();
+  NrrdIoState *nio = nrrdIoStateNew();
+
+  // nrrd causes exceptions on purpose, so mask them
+  bool saveFPEState( FloatingPointExceptions::GetExceptionAction() );
+  FloatingPointExceptions::Disable();
+
+  // read the header again, keeping the data file open and positioned
+  // at the start of the compressed data, after any line skipping
+  nrrdIoStateSet(nio, nrrdIoStateSkipData, 1);
+  nrrdIoStateSet(nio, nrrdIoStateKeepNrrdDataFileOpen, 1);
+  const int loadError = nrrdLoad(nrrd, this->GetFileName(), nio);
+
+  // restore state
+  FloatingPointExceptions::SetEnabled(saveFPEState);
+
+  if ( loadError )
+    {
+    biffDone(NRRD);
+    }
+
+  ParallelGzipCodec::StreamType stream;
+  const SizeType                numberOfBytes = this->GetImageSizeInBytes();
+  long                          byteSkip = 0;
+  if ( !loadError && nio->dataFile )
+    {
+    unsigned int rangeAxisIdx[NRRD_DIM_MAX];
+    const unsigned int rangeAxisNum = nrrdRangeAxesGet(nrrd, rangeAxisIdx);
+    const bool         nativeEndian = nio->endian == airEndianUnknown || nio->endian == AIR_ENDIAN
+                                      || nrrdElementSize(nrrd) == 1;
+
+    // bytes are skipped within the decompressed data
+    byteSkip = nio->byteSkip;
+    if ( nio->format == nrrdFormatNRRD
+         && nio->encoding == nrrdEncodingGzip
+         && nativeEndian
+         && byteSkip >= 0
+         && ( rangeAxisNum == 0 || ( rangeAxisNum == 1 && rangeAxisIdx[0] == 0 ) )
+         && static_cast< SizeType >( nrrdElementSize(nrrd) * nrrdElementNumber(nrrd) ) == numberOfBytes )
+      {
+      const long position = ftell(nio->dataFile);
+      if ( position >= 0 && fseek(nio->dataFile, 0, SEEK_END) == 0 )
+        {
+        const long end = ftell(nio->dataFile);
+        fseek(nio->dataFile, position, SEEK_SET);
+
+        // only read the whole stream if its header has the index
+        const size_t headerSize = std::min(end - position, 12L + 65535L);
+        if ( end > position )
+          {
+          stream.resize(headerSize);
+          if ( fread(&stream[0], 1, headerSize, nio->dataFile) != headerSize
+               || !ParallelGzipCodec::IsIndexed( &stream[0], headerSize ) )
+            {
+            stream.clear();
+            }
+          }
+        if ( !stream.empty() )
+          {
+          stream.resize(end - position);
+          if ( stream.size() > headerSize
+               && fread(&stream[headerSize], 1, stream.size() - headerSize, nio->dataFile)
+               != stream.size() - headerSize )
+            {
+            stream.clear();
+            }
+          }
+        }
+      }
+    }
+
+  if ( nio->dataFile )
+    {
+    nio->dataFile = airFclose(nio->dataFile);
+    }
+  nrrd = nrrdNix(nrrd);
+  nio = nrrdIoStateNix(nio);
+
+  if ( stream.empty() )
+    {
+    return false;
+    }
+
+  ParallelGzipCodec::Pointer codec = ParallelGzipCodec::New();
+  codec->Decompress(&stream[0], stream.size(), buffer, static_cast< size_t >( numberOfBytes ),
+                    static_cast< size_t >( byteSkip ) );
+  return true;
+}
+
 void NrrdImageIO::Read(void *buffer)
 {
+  // data compressed with several threads is read with as many
+  if ( m_UseParallelCompression && this->ReadIndexedGzipData(buffer) )
+    {
+    return;
+    }
+
   Nrrd *       nrrd = nrrdNew();
   unsigned int baseDim;
   bool         nrrdAllocated;
@@ -1100,6 +1284,18 @@ void NrrdImageIO::Write(const void *buffer)
       break;
     }
 
+  // If asked, gzip compressed data attached to the header is compressed
+  // with several threads: nrrd writes the header alone, and the data is
+  // appended to it as an indexed gzip stream, which nrrd reads as any
+  // other.
+  const bool compressInParallel = m_UseParallelCompression
+                                  && nio->encoding == nrrdEncodingGzip
+                                  && !airEndsWith(this->GetFileName(), NRRD_EXT_NHDR);
+  if ( compressInParallel )
+    {
+    nrrdIoStateSet(nio, nrrdIoStateSkipData, 1);
+    }
+
   // Write the nrrd to file.
   if ( nrrdSave(this->GetFileName(), nrrd, nio) )
     {
@@ -1108,6 +1304,20 @@ void NrrdImageIO::Write(const void *buffer)
                       << this->GetFileName() << ":\n" << err);
     }
 
+  if ( compressInParallel )
+    {
+    ParallelGzipCodec::Pointer    codec = ParallelGzipCodec::New();
+    ParallelGzipCodec::StreamType stream;
+    codec->Compress(buffer, nrrdElementSize(nrrd) * nrrdElementNumber(nrrd), stream);
+
+    std::ofstream file(this->GetFileName(), std::ios::out | std::ios::binary | std::ios::app);
+    if ( !file.write( reinterpret_cast< const char * >( &stream[0] ), stream.size() ) )
+      {
+      itkExceptionMacro("Write: Error writing the data of "
+                        << this->GetFileName() );
+      }
+    }
+
   // Free the nrrd struct but don't touch nrrd->data
   nrrd = nrrdNix(nrrd);
   nio = nrrdIoStateNix(nio);
@@ -71,6 +71,13 @@ public:
   // overidden to return true only when supported
   virtual bool CanStreamRead(void);
 
+  // see super class for documentation
+  //
+  // overidden to return true: reading only uses streams of the instance
+  virtual bool CanPrefetchRead(void)
+  {
+    return true;
+  }
 
   /*-------- This part of the interface deals with reading data. ------ */
 
@@ -84,6 +91,10 @@ public:
   /** Reads the data from disk into the memory buffer provided. */
   virtual void Read(void *buffer);
 
+  /** Maps the pixels of binary files, which are stored big endian, on big
+   * endian systems, and those with one byte components on all systems. */
+  virtual MemoryMappedFileRegion::Pointer MapIORegion();
+
   /*-------- This part of the interfaces deals with writing data. ----- */
 
   /** Determine the file type. Returns true if this ImageIO can read the
@@ -594,6 +594,20 @@ void VTKImageIO::Read(void *buffer)
     }
 }
 
+MemoryMappedFileRegion::Pointer VTKImageIO::MapIORegion()
+{
+  // the file is always big endian, whatever m_ByteOrder says, and
+  // symmetric tensors are stored with all their nine components
+  if ( m_FileType == ASCII
+       || this->GetPixelType() == ImageIOBase::SYMMETRICSECONDRANKTENSOR
+       || ( this->GetComponentSize() > 1 && !ByteSwapper< int >::SystemIsBigEndian() )
+       || this->GetHeaderSize() == 0 )
+    {
+    return 0;
+    }
+  return this->MapIORegionOfFile( m_FileName, this->GetHeaderSize() );
+}
+
 void VTKImageIO::ReadImageInformation()
 {
   std::ifstream file;
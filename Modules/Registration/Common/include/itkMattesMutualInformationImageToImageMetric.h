@@ -23,6 +23,7 @@
 #include "itkIndex.h"
 #include "itkBSplineDerivativeKernelFunction.h"
 #include "itkArray2D.h"
+#include <vector>
 
 
 namespace itk
@@ -91,6 +92,10 @@ namespace itk
  * 1. This class returns the negative mutual information value.
  * 2. This class in not thread safe due the private data structures
  *     used to the store the sampled points and the marginal and joint pdfs.
+ * 3. With a BSplineTransform and UseExplicitPDFDerivatives on, the Joint
+ *     PDF derivatives are stored sparsely by default, and
+ *     GetJointPDFDerivatives() then throws an exception. Call
+ *     UseSparsePDFDerivativesOff() before Initialize() to get them.
  *
  * References:
  * [1] "Nonrigid multimodality image registration"
@@ -209,11 +214,30 @@ public:
    * method an extra 2D array is used for storing the weights of each one of
    * the PDF bins. This is an array of doubles with size equals to (number of
    * histogram bins)^2. This method is well suited for Transforms with a large
-   * number of parameters, such as, BSplineTransforms. */
+   * number of parameters, such as, BSplineTransforms.
+   *
+   * With a BSplineTransform, UseExplicitPDFDerivatives = True stores the
+   * derivatives sparsely, unless UseSparsePDFDerivatives is False. */
   itkSetMacro(UseExplicitPDFDerivatives, bool);
   itkGetConstReferenceMacro(UseExplicitPDFDerivatives, bool);
   itkBooleanMacro(UseExplicitPDFDerivatives);
 
+  /** This variable selects whether the Joint PDF derivatives are stored
+   * sparsely when UseExplicitPDFDerivatives is True and the Transform is a
+   * BSplineTransform. Each sample only affects the parameters of the
+   * BSpline nodes around it, in one row of fixed image bins, so each thread
+   * only stores, for the nodes it affects, the rows of moving image bins of
+   * the fixed image bins where their derivatives are not zero.
+   * The memory required grows with the number of rows affected instead of
+   * with the number of threads times the (number of histogram bins)^2 times
+   * the number of transform parameters. The contributions of the threads
+   * are combined with the bin-specific weights over ranges of parameters,
+   * in parallel. The Joint PDF derivatives are then not available:
+   * GetJointPDFDerivatives() throws an exception. The default is True. */
+  itkSetMacro(UseSparsePDFDerivatives, bool);
+  itkGetConstReferenceMacro(UseSparsePDFDerivatives, bool);
+  itkBooleanMacro(UseSparsePDFDerivatives);
+
   /** The marginal PDFs are stored as std::vector. */
   typedef float PDFValueType;
 
@@ -221,7 +245,19 @@ public:
   typedef Image< PDFValueType, 2 >            JointPDFType;
   typedef Image< PDFValueType, 3 >            JointPDFDerivativesType;
   itkGetConstReferenceMacro(JointPDF,typename JointPDFType::Pointer);
-  itkGetConstReferenceMacro(JointPDFDerivatives,typename JointPDFDerivativesType::Pointer);
+
+  /** Get the Joint PDF derivatives, computed with UseExplicitPDFDerivatives
+   * on. Throws an exception if they are stored sparsely instead, see
+   * UseSparsePDFDerivatives. */
+  const typename JointPDFDerivativesType::Pointer & GetJointPDFDerivatives() const
+  {
+    if( this->m_SparsePDFDerivatives )
+      {
+      itkExceptionMacro(<< "The Joint PDF derivatives are stored sparsely;"
+                        << " call UseSparsePDFDerivativesOff() before Initialize() to get them");
+      }
+    return this->m_JointPDFDerivatives;
+  }
 protected:
 
   MattesMutualInformationImageToImageMetric();
@@ -267,6 +303,28 @@ private:
 
   typename JointPDFDerivativesType::Pointer m_JointPDFDerivatives;
 
+  /** The Joint PDF derivatives computed by one thread, stored sparsely.
+   * The derivatives with respect to the parameters of a BSpline node are
+   * stored in rows of FixedImageDimension times NumberOfHistogramBins
+   * values, one per fixed image bin where they are not zero, chained from
+   * FirstRow[node] through NextRow. */
+  struct SparsePDFDerivativesType {
+    std::vector< int >                          FirstRow;
+    std::vector< int >                          NextRow;
+    std::vector< unsigned int >                 RowFixedIndex;
+    std::vector< JointPDFDerivativesValueType > Values;
+    /** The nodes which have rows, to reset FirstRow. */
+    std::vector< unsigned int > Nodes;
+  };
+
+  mutable std::vector< SparsePDFDerivativesType > m_ThreaderSparsePDFDerivatives;
+
+  /** Data passed to the threads which combine the sparse derivatives. */
+  struct SparseDerivativeThreadStruct {
+    const Self *Metric;
+    DerivativeType *Derivative;
+  };
+
   SizeValueType m_JointPDFDerivativesBufferSize;
 
   /** Variables to define the marginal and joint histograms. */
@@ -302,6 +360,21 @@ private:
                                      double cubicBSplineDerivativeValue
                                      ) const;
 
+  /** Compute the PDF derivative contributions of a sample, for the four
+   * moving image bins from pdfMovingIndex, to the sparse derivatives of the
+   * thread. */
+  virtual void ComputeSparsePDFDerivatives(unsigned int threadID,
+                                           unsigned int sampleNumber,
+                                           int pdfMovingIndex,
+                                           const ImageDerivativesType
+                                           &  movingImageGradientValue,
+                                           const double *cubicBSplineDerivativeValues
+                                           ) const;
+
+  /** Combine the sparse derivatives of the threads with the pRatios, over
+   * a range of nodes per thread. */
+  static ITK_THREAD_RETURN_TYPE ComputeSparseDerivativeThreaderCallback(void *arg);
+
   PDFValueType *m_ThreaderFixedImageMarginalPDF;
 
   typename JointPDFType::Pointer              * m_ThreaderJointPDF;
@@ -315,6 +388,9 @@ private:
   mutable double m_JointPDFSum;
 
   bool         m_UseExplicitPDFDerivatives;
+  bool         m_UseSparsePDFDerivatives;
+  /** Whether the sparse derivatives are used, set by Initialize(). */
+  bool         m_SparsePDFDerivatives;
   mutable bool m_ImplicitDerivativesSecondPass;
 
   virtual inline void GetValueThreadPreProcess(unsigned int threadID,
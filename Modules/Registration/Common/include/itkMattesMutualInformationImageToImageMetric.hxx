@@ -72,6 +72,8 @@ MattesMutualInformationImageToImageMetric<TFixedImage, TMovingImage>
   m_JointPDFSum(0.0),
 
   m_UseExplicitPDFDerivatives(true),
+  m_UseSparsePDFDerivatives(true),
+  m_SparsePDFDerivatives(false),
   m_ImplicitDerivativesSecondPass(false)
 {
   this->SetComputeGradient(false); // don't use the default gradient for now
@@ -165,6 +167,8 @@ MattesMutualInformationImageToImageMetric<TFixedImage, TMovingImage>
   os << this->m_MovingImageBinSize << std::endl;
   os << indent << "UseExplicitPDFDerivatives: ";
   os << this->m_UseExplicitPDFDerivatives << std::endl;
+  os << indent << "UseSparsePDFDerivatives: ";
+  os << this->m_UseSparsePDFDerivatives << std::endl;
   os << indent << "ImplicitDerivativesSecondPass: ";
   os << this->m_ImplicitDerivativesSecondPass << std::endl;
   if( this->m_JointPDF.IsNotNull() )
@@ -311,7 +315,9 @@ throw ( ExceptionObject )
   //
   // Now allocate memory according to the user-selected method.
   //
-  if( this->m_UseExplicitPDFDerivatives )
+  this->m_SparsePDFDerivatives = this->m_UseExplicitPDFDerivatives
+    && this->m_UseSparsePDFDerivatives && this->m_TransformIsBSpline;
+  if( this->m_UseExplicitPDFDerivatives && !this->m_SparsePDFDerivatives )
     {
     // Deallocate the memory that may have been allocated for
     // previous runs of the metric.
@@ -351,10 +357,12 @@ throw ( ExceptionObject )
     // Deallocate the memory that may have been allocated for
     // previous runs of the metric.
     this->m_JointPDFDerivatives = NULL; // Not needed if m_UseExplicitPDFDerivatives=false
+                                        // or with sparse derivatives
 
     /** Allocate memory for helper array that will contain the pRatios
      *  for each bin of the joint histogram. This is part of the effort
-     *  for flattening the computation of the PDF Jacobians.
+     *  for flattening the computation of the PDF Jacobians. The sparse
+     *  derivatives are also combined with them.
      */
     this->m_PRatioArray.SetSize(this->m_NumberOfHistogramBins, this->m_NumberOfHistogramBins);
     this->m_MetricDerivative = DerivativeType( this->GetNumberOfParameters() );
@@ -464,7 +472,19 @@ throw ( ExceptionObject )
     }
   m_ThreaderMetricDerivative = NULL;
 
-  if( this->m_UseExplicitPDFDerivatives )
+  m_ThreaderSparsePDFDerivatives.clear();
+
+  if( this->m_SparsePDFDerivatives )
+    {
+    // Every thread, including the first one, has its sparse derivatives.
+    m_ThreaderSparsePDFDerivatives.resize(this->m_NumberOfThreads);
+    for( ThreadIdType threadID = 0; threadID < this->m_NumberOfThreads; threadID++ )
+      {
+      m_ThreaderSparsePDFDerivatives[threadID].FirstRow.assign(
+        this->m_BSplineTransform->GetNumberOfParametersPerDimension(), -1);
+      }
+    }
+  else if( this->m_UseExplicitPDFDerivatives )
     {
     m_ThreaderJointPDFDerivatives = new typename
       JointPDFDerivativesType::Pointer[this->m_NumberOfThreads - 1];
@@ -810,7 +830,7 @@ MattesMutualInformationImageToImageMetric<TFixedImage, TMovingImage>
             0,
             m_NumberOfHistogramBins * sizeof( PDFValueType ) );
 
-    if( this->m_UseExplicitPDFDerivatives )
+    if( this->m_UseExplicitPDFDerivatives && !this->m_SparsePDFDerivatives )
       {
       memset(m_ThreaderJointPDFDerivatives[threadID - 1]->GetBufferPointer(),
              0,
@@ -826,13 +846,28 @@ MattesMutualInformationImageToImageMetric<TFixedImage, TMovingImage>
             0,
             m_NumberOfHistogramBins * sizeof( PDFValueType ) );
 
-    if( this->m_UseExplicitPDFDerivatives )
+    if( this->m_UseExplicitPDFDerivatives && !this->m_SparsePDFDerivatives )
       {
       memset(m_JointPDFDerivatives->GetBufferPointer(),
              0,
              m_JointPDFDerivativesBufferSize);
       }
     }
+
+  if( this->m_SparsePDFDerivatives )
+    {
+    // Remove the rows, keeping their memory for this evaluation.
+    SparsePDFDerivativesType & sparse = m_ThreaderSparsePDFDerivatives[threadID];
+    for( std::vector<unsigned int>::const_iterator it = sparse.Nodes.begin();
+         it != sparse.Nodes.end(); ++it )
+      {
+      sparse.FirstRow[*it] = -1;
+      }
+    sparse.Nodes.clear();
+    sparse.NextRow.clear();
+    sparse.RowFixedIndex.clear();
+    sparse.Values.clear();
+    }
 }
 
 template <class TFixedImage, class TMovingImage>
@@ -934,13 +969,23 @@ MattesMutualInformationImageToImageMetric<TFixedImage, TMovingImage>
   double movingImageParzenWindowArg = static_cast<double>( pdfMovingIndex )
     - static_cast<double>( movingImageParzenWindowTerm );
 
+  // With sparse derivatives, the contributions to the four bins are
+  // computed together, for one lookup of the rows of each parameter.
+  const int pdfMovingIndexMin = pdfMovingIndex;
+  double    cubicBSplineDerivativeValues[4];
+
   while( pdfMovingIndex <= pdfMovingIndexMax )
     {
     *( pdfPtr++ ) += static_cast<PDFValueType>( m_CubicBSplineKernel
                                                 ->Evaluate(
                                                   movingImageParzenWindowArg) );
 
-    if( this->m_UseExplicitPDFDerivatives || this->m_ImplicitDerivativesSecondPass )
+    if( this->m_SparsePDFDerivatives )
+      {
+      cubicBSplineDerivativeValues[pdfMovingIndex - pdfMovingIndexMin] =
+        m_CubicBSplineDerivativeKernel->Evaluate(movingImageParzenWindowArg);
+      }
+    else if( this->m_UseExplicitPDFDerivatives || this->m_ImplicitDerivativesSecondPass )
       {
       // Compute the cubicBSplineDerivative for later repeated use.
       const double cubicBSplineDerivativeValue =
@@ -958,6 +1003,15 @@ MattesMutualInformationImageToImageMetric<TFixedImage, TMovingImage>
     ++pdfMovingIndex;
     }
 
+  if( this->m_SparsePDFDerivatives )
+    {
+    this->ComputeSparsePDFDerivatives(threadID,
+                                      fixedImageSample,
+                                      pdfMovingIndexMin,
+                                      movingImageGradientValue,
+                                      cubicBSplineDerivativeValues);
+    }
+
   return true;
 }
 
@@ -969,7 +1023,7 @@ MattesMutualInformationImageToImageMetric<TFixedImage, TMovingImage>
 {
   this->GetValueThreadPostProcess(threadID, withinSampleThread);
 
-  if( this->m_UseExplicitPDFDerivatives )
+  if( this->m_UseExplicitPDFDerivatives && !this->m_SparsePDFDerivatives )
     {
     const unsigned int rowSize = this->m_NumberOfParameters * m_NumberOfHistogramBins;
 
@@ -1029,6 +1083,10 @@ MattesMutualInformationImageToImageMetric<TFixedImage, TMovingImage>
     memset( derivative.data_block(),
             0,
             this->m_NumberOfParameters * sizeof( double ) );
+    if( this->m_SparsePDFDerivatives )
+      {
+      this->m_PRatioArray.Fill(0.0);
+      }
     }
   else
     {
@@ -1131,7 +1189,7 @@ MattesMutualInformationImageToImageMetric<TFixedImage, TMovingImage>
           sum += jointPDFValue * ( pRatio - vcl_log(fixedImagePDFValue) );
           }
 
-        if( this->m_UseExplicitPDFDerivatives )
+        if( this->m_UseExplicitPDFDerivatives && !this->m_SparsePDFDerivatives )
           {
           // move joint pdf derivative pointer to the right position
           JointPDFValueType const * derivPtr = m_JointPDFDerivatives->GetBufferPointer()
@@ -1151,7 +1209,17 @@ MattesMutualInformationImageToImageMetric<TFixedImage, TMovingImage>
       }   // end for-loop over moving index
     }     // end for-loop over fixed index
 
-  if( !( this->m_UseExplicitPDFDerivatives ) )
+  if( this->m_SparsePDFDerivatives )
+    {
+    // Combine the sparse derivatives of all the threads with the pRatios,
+    // each thread over a range of parameters.
+    SparseDerivativeThreadStruct str;
+    str.Metric = this;
+    str.Derivative = &derivative;
+    this->m_Threader->SetSingleMethod(ComputeSparseDerivativeThreaderCallback, &str);
+    this->m_Threader->SingleMethodExecute();
+    }
+  else if( !( this->m_UseExplicitPDFDerivatives ) )
     {
     // Second pass: This one is done for accumulating the contributions
     //              to the derivative array.
@@ -1372,6 +1440,154 @@ MattesMutualInformationImageToImageMetric<TFixedImage, TMovingImage>
     }     // end if-block transform is BSpline
 }
 
+/**
+ * Compute the sparse PDF derivatives contribution of a sample
+ */
+template <class TFixedImage, class TMovingImage>
+void
+MattesMutualInformationImageToImageMetric<TFixedImage, TMovingImage>
+::ComputeSparsePDFDerivatives(ThreadIdType threadID,
+                              unsigned int sampleNumber,
+                              int pdfMovingIndex,
+                              const ImageDerivativesType & movingImageGradientValue,
+                              const double *cubicBSplineDerivativeValues) const
+{
+  SparsePDFDerivativesType & sparse = m_ThreaderSparsePDFDerivatives[threadID];
+
+  const unsigned int pdfFixedIndex = this->m_FixedImageSamples[sampleNumber].valueIndex;
+
+  const WeightsValueType *weights;
+  const IndexValueType *  indices;
+
+  if( this->m_UseCachingOfBSplineWeights )
+    {
+    weights = this->m_BSplineTransformWeightsArray[sampleNumber];
+    indices = this->m_BSplineTransformIndicesArray[sampleNumber];
+    }
+  else
+    {
+    BSplineTransformWeightsType *   weightsHelper;
+    BSplineTransformIndexArrayType *indicesHelper;
+    if( threadID > 0 )
+      {
+      weightsHelper = &( this->m_ThreaderBSplineTransformWeights[threadID - 1] );
+      indicesHelper = &( this->m_ThreaderBSplineTransformIndices[threadID - 1] );
+      }
+    else
+      {
+      weightsHelper = &( this->m_BSplineTransformWeights );
+      indicesHelper = &( this->m_BSplineTransformIndices );
+      }
+
+    /** Get Jacobian at a point. A very specialized function just for BSplines */
+    this->m_BSplineTransform->ComputeJacobianFromBSplineWeightsWithRespectToPosition(
+      this->m_FixedImageSamples[sampleNumber].point,
+      *weightsHelper, *indicesHelper);
+    weights = weightsHelper->data_block();
+    indices = indicesHelper->data_block();
+    }
+
+  const SizeValueType rowSize = Superclass::FixedImageDimension * m_NumberOfHistogramBins;
+  for( unsigned int mu = 0; mu < this->m_NumBSplineWeights; mu++ )
+    {
+    const unsigned int node = indices[mu];
+
+    // Look for the row of the fixed image bin, and move it to the front of
+    // the chain, since the next samples around the node often fall in the
+    // same bin.
+    int previous = -1;
+    int row = sparse.FirstRow[node];
+    while( row >= 0 && sparse.RowFixedIndex[row] != pdfFixedIndex )
+      {
+      previous = row;
+      row = sparse.NextRow[row];
+      }
+    if( row < 0 )
+      {
+      if( sparse.FirstRow[node] < 0 )
+        {
+        sparse.Nodes.push_back(node);
+        }
+      row = static_cast<int>( sparse.RowFixedIndex.size() );
+      sparse.RowFixedIndex.push_back(pdfFixedIndex);
+      sparse.NextRow.push_back(sparse.FirstRow[node]);
+      sparse.FirstRow[node] = row;
+      sparse.Values.resize(sparse.Values.size() + rowSize, 0.0);
+      }
+    else if( previous >= 0 )
+      {
+      sparse.NextRow[previous] = sparse.NextRow[row];
+      sparse.NextRow[row] = sparse.FirstRow[node];
+      sparse.FirstRow[node] = row;
+      }
+
+    /* The Jacobian of the parameter of the node along each dimension is
+     * the weight of the node, which is multiplied by the moving image
+     * gradient. */
+    JointPDFDerivativesValueType *derivPtr = &( sparse.Values[row * rowSize + pdfMovingIndex] );
+    for( unsigned int dim = 0; dim < Superclass::FixedImageDimension; dim++ )
+      {
+      const double innerProduct = movingImageGradientValue[dim] * weights[mu];
+      for( unsigned int bin = 0; bin < 4; ++bin )
+        {
+        derivPtr[bin] -= innerProduct * cubicBSplineDerivativeValues[bin];
+        }
+      derivPtr += m_NumberOfHistogramBins;
+      }
+    }
+}
+
+/**
+ * Combine the sparse PDF derivatives with the pRatios
+ */
+template <class TFixedImage, class TMovingImage>
+ITK_THREAD_RETURN_TYPE
+MattesMutualInformationImageToImageMetric<TFixedImage, TMovingImage>
+::ComputeSparseDerivativeThreaderCallback(void *arg)
+{
+  MultiThreader::ThreadInfoStruct *info = static_cast<MultiThreader::ThreadInfoStruct *>( arg );
+  SparseDerivativeThreadStruct *   str = static_cast<SparseDerivativeThreadStruct *>( info->UserData );
+  const Self *                     metric = str->Metric;
+
+  const SizeValueType numberOfNodes = metric->m_BSplineTransform->GetNumberOfParametersPerDimension();
+  const SizeValueType first = numberOfNodes * info->ThreadID / info->NumberOfThreads;
+  const SizeValueType last = numberOfNodes * ( info->ThreadID + 1 ) / info->NumberOfThreads;
+  const SizeValueType numberOfBins = metric->m_NumberOfHistogramBins;
+
+  for( SizeValueType node = first; node < last; ++node )
+    {
+    double sum[Superclass::FixedImageDimension];
+    for( unsigned int dim = 0; dim < Superclass::FixedImageDimension; dim++ )
+      {
+      sum[dim] = 0.0;
+      }
+    for( unsigned int t = 0; t < metric->m_ThreaderSparsePDFDerivatives.size(); t++ )
+      {
+      const SparsePDFDerivativesType & sparse = metric->m_ThreaderSparsePDFDerivatives[t];
+      for( int row = sparse.FirstRow[node]; row >= 0; row = sparse.NextRow[row] )
+        {
+        const PRatioType *const             pRatio = metric->m_PRatioArray[sparse.RowFixedIndex[row]];
+        JointPDFDerivativesValueType const *derivPtr =
+          &( sparse.Values[row * Superclass::FixedImageDimension * numberOfBins] );
+        for( unsigned int dim = 0; dim < Superclass::FixedImageDimension; dim++ )
+          {
+          for( SizeValueType bin = 0; bin < numberOfBins; ++bin )
+            {
+            sum[dim] += ( *derivPtr++ ) * pRatio[bin];
+            }
+          }
+        }
+      }
+    for( unsigned int dim = 0; dim < Superclass::FixedImageDimension; dim++ )
+      {
+      // Ref: eqn 23 of Thevenaz & Unser paper [3]
+      ( *str->Derivative )[node + metric->m_BSplineParametersOffset[dim]] -= sum[dim];
+      }
+    }
+
+  return ITK_THREAD_RETURN_VALUE;
+}
+
 } // end namespace itk
 
 #endif
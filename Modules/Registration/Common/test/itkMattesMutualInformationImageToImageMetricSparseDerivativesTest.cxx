@@ -0,0 +1,316 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkMattesMutualInformationImageToImageMetric.h"
+#include "itkLinearInterpolateImageFunction.h"
+#include "itkAffineTransform.h"
+#include "itkBSplineTransform.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMultiThreader.h"
+#include "itkMemoryProbe.h"
+#include "itkTimeProbe.h"
+#include <iomanip>
+
+// Computes the derivatives of the Mattes mutual information of two
+// volumes, with a BSplineTransform, with sparse Joint PDF derivatives,
+// with dense ones and without explicit ones, with and without the caching
+// of the BSpline weights, with random samples and with all the pixels,
+// and with several numbers of threads, and checks that they agree. It
+// also checks that GetJointPDFDerivatives() throws with the sparse
+// derivatives, and that they do not change the derivatives with an
+// AffineTransform. It then reports the time taken by an
+// iteration, and the memory used, with an AffineTransform and with a
+// BSplineTransform with a grid of 20^3 nodes, with the default number of
+// threads. Pass a larger edge length, e.g. 128, to use it as a benchmark.
+
+namespace
+{
+typedef itk::Image< float, 3 >                                                ImageType;
+typedef itk::MattesMutualInformationImageToImageMetric< ImageType, ImageType > MetricType;
+typedef itk::AffineTransform< double, 3 >                                     AffineTransformType;
+typedef itk::BSplineTransform< double, 3, 3 >                                 BSplineTransformType;
+
+// Smooth intensities, the moving ones through a nonlinear mapping.
+ImageType::Pointer MakeImage(const ImageType::SizeType & size, bool moving)
+{
+  ImageType::Pointer image = ImageType::New();
+  image->SetRegions(size);
+  image->Allocate();
+  itk::ImageRegionIteratorWithIndex< ImageType > it( image, image->GetLargestPossibleRegion() );
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    const ImageType::IndexType index = it.GetIndex();
+    const double               shift = moving ? 1.5 : 0.0;
+    double                     value = 100.0 + 60.0 * vcl_sin( ( index[0] + shift ) / 5.0 ) * vcl_cos(index[1] / 7.0)
+                                       + 30.0 * vcl_sin( ( index[2] - shift ) / 4.0 );
+    if ( moving )
+      {
+      value = value * value / 200.0;
+      }
+    it.Set( static_cast< float >( value ) );
+    }
+  return image;
+}
+
+BSplineTransformType::Pointer MakeBSplineTransform(const ImageType *image, unsigned int meshSize)
+{
+  BSplineTransformType::PhysicalDimensionsType dimensions;
+  for ( unsigned int d = 0; d < 3; ++d )
+    {
+    dimensions[d] = image->GetSpacing()[d] * ( image->GetLargestPossibleRegion().GetSize()[d] - 1 );
+    }
+  BSplineTransformType::MeshSizeType mesh;
+  mesh.Fill(meshSize);
+
+  BSplineTransformType::Pointer transform = BSplineTransformType::New();
+  transform->SetTransformDomainPhysicalDimensions(dimensions);
+  transform->SetTransformDomainOrigin( image->GetOrigin() );
+  transform->SetTransformDomainDirection( image->GetDirection() );
+  transform->SetTransformDomainMeshSize(mesh);
+  return transform;
+}
+
+// Small random displacements of the nodes.
+MetricType::ParametersType MakeBSplineParameters(unsigned int numberOfParameters)
+{
+  MetricType::ParametersType parameters(numberOfParameters);
+  unsigned int               random = 1;
+  for ( unsigned int p = 0; p < numberOfParameters; ++p )
+    {
+    random = random * 1103515245 + 12345;
+    parameters[p] = ( ( random >> 8 ) % 1000 ) / 500.0 - 1.0;
+    }
+  return parameters;
+}
+
+MetricType::Pointer MakeMetric(ImageType *fixed, ImageType *moving, MetricType::TransformType *transform,
+                               bool explicitDerivatives, bool sparseDerivatives, bool caching,
+                               unsigned int numberOfSamples, unsigned int numberOfThreads)
+{
+  typedef itk::LinearInterpolateImageFunction< ImageType, double > InterpolatorType;
+  InterpolatorType::Pointer interpolator = InterpolatorType::New();
+  interpolator->SetInputImage(moving);
+
+  MetricType::Pointer metric = MetricType::New();
+  metric->SetFixedImage(fixed);
+  metric->SetMovingImage(moving);
+  metric->SetInterpolator(interpolator);
+  metric->SetTransform(transform);
+  metric->SetFixedImageRegion( fixed->GetBufferedRegion() );
+  metric->SetNumberOfHistogramBins(32);
+  metric->SetUseExplicitPDFDerivatives(explicitDerivatives);
+  metric->SetUseSparsePDFDerivatives(sparseDerivatives);
+  metric->SetUseCachingOfBSplineWeights(caching);
+  metric->SetNumberOfThreads(numberOfThreads);
+  if ( numberOfSamples > 0 )
+    {
+    metric->SetNumberOfSpatialSamples(numberOfSamples);
+    metric->ReinitializeSeed(7);
+    }
+  else
+    {
+    metric->UseAllPixelsOn();
+    }
+  metric->Initialize();
+  return metric;
+}
+
+bool Check(const char *name, double value, const MetricType::DerivativeType & derivative,
+           double expectedValue, const MetricType::DerivativeType & expected)
+{
+  double scale = 0.0;
+  for ( unsigned int p = 0; p < expected.GetSize(); ++p )
+    {
+    scale = std::max( scale, vcl_abs(expected[p]) );
+    }
+  if ( vcl_abs(value - expectedValue) > 1e-6 * vcl_abs(expectedValue) )
+    {
+    std::cerr << name << ": the value is " << value << " instead of " << expectedValue << std::endl;
+    return false;
+    }
+  for ( unsigned int p = 0; p < expected.GetSize(); ++p )
+    {
+    if ( vcl_abs(derivative[p] - expected[p]) > 1e-4 * scale )
+      {
+      std::cerr << name << ": the derivative " << p << " is " << derivative[p] << " instead of "
+                << expected[p] << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+double TimeIteration(MetricType *metric, const MetricType::ParametersType & parameters)
+{
+  MetricType::MeasureType    value;
+  MetricType::DerivativeType derivative;
+  itk::TimeProbe             probe;
+  for ( unsigned int i = 0; i < 3; ++i )
+    {
+    probe.Start();
+    metric->GetValueAndDerivative(parameters, value, derivative);
+    probe.Stop();
+    }
+  return probe.GetMean();
+}
+
+void Benchmark(const char *name, ImageType *fixed, ImageType *moving, MetricType::TransformType *transform,
+               const MetricType::ParametersType & parameters, unsigned int numberOfSamples)
+{
+  const unsigned int numberOfThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+
+  std::cout << "  " << std::setw(8) << name;
+  for ( unsigned int mode = 0; mode < 3; ++mode )
+    {
+    const bool explicitDerivatives = mode < 2;
+    const bool sparseDerivatives = mode == 1;
+
+    // Skip the dense derivatives when they would not fit in memory.
+    const double denseBytes = 32.0 * 32.0 * parameters.GetSize() * sizeof( float ) * numberOfThreads;
+    if ( explicitDerivatives && !sparseDerivatives && denseBytes > 2e9 )
+      {
+      std::cout << std::setw(12) << "-" << std::setw(12) << "-";
+      continue;
+      }
+
+    itk::MemoryProbe memory;
+    memory.Start();
+    MetricType::Pointer metric = MakeMetric(fixed, moving, transform, explicitDerivatives, sparseDerivatives, true,
+                                            numberOfSamples, numberOfThreads);
+    const double time = TimeIteration(metric, parameters);
+    memory.Stop();
+    std::cout << std::setw(12) << time << std::setw(12) << memory.GetMean() / 1024.0;
+    }
+  std::cout << std::endl;
+}
+}
+
+int itkMattesMutualInformationImageToImageMetricSparseDerivativesTest(int argc, char *argv[])
+{
+  unsigned int edgeLength = 32;
+  if ( argc > 1 )
+    {
+    edgeLength = atoi(argv[1]);
+    }
+
+  ImageType::SizeType size;
+  size[0] = 23;
+  size[1] = 19;
+  size[2] = 17;
+  ImageType::Pointer fixed = MakeImage(size, false);
+  ImageType::Pointer moving = MakeImage(size, true);
+
+  BSplineTransformType::Pointer bspline = MakeBSplineTransform(fixed, 4);
+  const MetricType::ParametersType bsplineParameters =
+    MakeBSplineParameters( bspline->GetNumberOfParameters() );
+
+  AffineTransformType::Pointer affine = AffineTransformType::New();
+  MetricType::ParametersType   affineParameters = affine->GetParameters();
+  affineParameters[0] = 1.02;
+  affineParameters[9] = 0.7;
+  affineParameters[11] = -0.4;
+
+  for ( unsigned int test = 0; test < 4; ++test )
+    {
+    const bool         caching = ( test & 1 ) == 0;
+    const unsigned int numberOfSamples = test < 2 ? 2000 : 0;
+
+    // The derivatives without explicit Joint PDF derivatives, with one
+    // thread, are the reference.
+    MetricType::MeasureType    expectedValue;
+    MetricType::DerivativeType expected;
+    MakeMetric(fixed, moving, bspline, false, false, caching, numberOfSamples, 1)
+      ->GetValueAndDerivative(bsplineParameters, expectedValue, expected);
+
+    for ( unsigned int threads = 1; threads <= 5; threads += 2 )
+      {
+      for ( unsigned int sparse = 0; sparse < 2; ++sparse )
+        {
+        MetricType::Pointer metric =
+          MakeMetric(fixed, moving, bspline, true, sparse != 0, caching, numberOfSamples, threads);
+        bool sparseGetThrew = false;
+        try
+          {
+          if ( metric->GetJointPDFDerivatives().IsNull() )
+            {
+            std::cerr << "The Joint PDF derivatives are not allocated" << std::endl;
+            return EXIT_FAILURE;
+            }
+          }
+        catch ( itk::ExceptionObject & )
+          {
+          sparseGetThrew = true;
+          }
+        if ( sparseGetThrew != ( sparse != 0 ) )
+          {
+          std::cerr << "GetJointPDFDerivatives() " << ( sparse ? "did not throw" : "threw" )
+                    << " with " << ( sparse ? "sparse" : "dense" ) << " derivatives" << std::endl;
+          return EXIT_FAILURE;
+          }
+
+        // evaluate twice, to check that the sparse derivatives are reset
+        MetricType::MeasureType    value;
+        MetricType::DerivativeType derivative;
+        metric->GetValueAndDerivative(bsplineParameters, value, derivative);
+        metric->GetValueAndDerivative(bsplineParameters, value, derivative);
+        if ( !Check(sparse ? "sparse" : "dense", value, derivative, expectedValue, expected) )
+          {
+          std::cerr << "  with " << threads << " threads, caching " << caching << ", "
+                    << numberOfSamples << " samples" << std::endl;
+          return EXIT_FAILURE;
+          }
+        }
+      }
+    }
+
+  // The sparse derivatives are only used with a BSplineTransform.
+  MetricType::MeasureType    expectedValue;
+  MetricType::DerivativeType expected;
+  MakeMetric(fixed, moving, affine, true, false, true, 0, 2)
+    ->GetValueAndDerivative(affineParameters, expectedValue, expected);
+  MetricType::Pointer affineMetric = MakeMetric(fixed, moving, affine, true, true, true, 0, 2);
+  MetricType::MeasureType    value;
+  MetricType::DerivativeType derivative;
+  affineMetric->GetValueAndDerivative(affineParameters, value, derivative);
+  if ( affineMetric->GetJointPDFDerivatives().IsNull()
+       || !Check("affine", value, derivative, expectedValue, expected) )
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Benchmark.
+  ImageType::SizeType benchmarkSize;
+  benchmarkSize.Fill(edgeLength);
+  ImageType::Pointer benchmarkFixed = MakeImage(benchmarkSize, false);
+  ImageType::Pointer benchmarkMoving = MakeImage(benchmarkSize, true);
+  const unsigned int numberOfSamples = benchmarkFixed->GetLargestPossibleRegion().GetNumberOfPixels() / 10;
+
+  // A mesh of 17^3 cells has 20^3 nodes with a cubic BSpline.
+  BSplineTransformType::Pointer benchmarkBSpline = MakeBSplineTransform(benchmarkFixed, 17);
+
+  std::cout << "Computing the derivatives of the mutual information of " << edgeLength << "^3 volumes with "
+            << numberOfSamples << " samples and " << itk::MultiThreader::GetGlobalDefaultNumberOfThreads()
+            << " threads, s and MB:" << std::endl;
+  std::cout << "                   dense                  sparse                implicit" << std::endl;
+  std::cout << " transform        time      memory        time      memory        time      memory" << std::endl;
+  Benchmark("affine", benchmarkFixed, benchmarkMoving, affine, affineParameters, numberOfSamples);
+  Benchmark("BSpline", benchmarkFixed, benchmarkMoving, benchmarkBSpline,
+            MakeBSplineParameters( benchmarkBSpline->GetNumberOfParameters() ), numberOfSamples);
+
+  return EXIT_SUCCESS;
+}
@@ -19,9 +19,8 @@
 #define __itkANTSNeighborhoodCorrelationImageToImageObjectMetric_h
 
 #include "itkImageToImageObjectMetric.h"
-#include "itkConstNeighborhoodIterator.h"
 
-#include <deque>
+#include <vector>
 
 namespace itk {
 
@@ -52,8 +51,23 @@ namespace itk {
  * the evaluation up considerably and works well in practice. This assumption
  * is the main differentiattion of this approach from a more generic one.
  *
- * 2) The evaluation uses on-the-fly queues with multi-threading and a sliding
- * neighborhood window. This is described in the above paper and specifically
+ * 2) The sums over the neighborhood windows are computed separably, one
+ * image dimension after the other, from sums over blocks of the window
+ * length, so their cost per voxel does not depend on the radius. Each
+ * thread splits its sub-region in chunks. It evaluates the fixed and moving
+ * images at each voxel of a chunk padded by the radius, and then replaces
+ * these values by their sums over the windows. The chunks are split along
+ * the outermost dimension and, when its slices are too large, along the
+ * next outermost ones too, so that a padded chunk has at most 2^20 voxels,
+ * i.e. 48 MB of sums per thread, unless the radius alone makes a chunk one
+ * voxel thick larger. The padding voxels are evaluated again by the
+ * neighboring chunks: the chunks are kept at least a window long where
+ * this limit allows it, so that the number of evaluations is at most
+ * doubled along each split dimension, but thread sub-regions thinner than
+ * a window, in images split over many threads, are evaluated up to 2r+1
+ * times. The blocks are aligned on the virtual domain, so that the sums do
+ * not depend on the number of threads or on the chunks. This replaces the
+ * sliding windows described in the above paper, and is specifically
  * optimized for dense registration.
  *
  *  Example of usage:
@@ -181,24 +195,28 @@ public:
 protected:
 
   // interested values here updated during scanning
-  typedef InternalComputationValueType                 QueueRealType;
-  typedef std::deque<QueueRealType>                    SumQueueType;
-  typedef ConstNeighborhoodIterator<VirtualImageType>  ScanningIteratorType;
+  typedef InternalComputationValueType                 SumRealType;
+  typedef std::vector<SumRealType>                     SumBufferType;
   // one ScanMemType for each thread
   typedef struct ScanMemType {
-    // queues used in the scanning
-    SumQueueType Qsuma2;
-    SumQueueType Qsumb2;
-    SumQueueType Qsuma;
-    SumQueueType Qsumb;
-    SumQueueType Qsumab;
-    SumQueueType Qcount;
-
-    QueueRealType Ia;
-    QueueRealType Ja;
-    QueueRealType sfm;
-    QueueRealType sff;
-    QueueRealType smm;
+    // sums over the neighborhood windows of the voxels of the padded chunk,
+    // in the order of its buffer
+    SumBufferType suma2;
+    SumBufferType sumb2;
+    SumBufferType suma;
+    SumBufferType sumb;
+    SumBufferType sumab;
+    SumBufferType count;
+    // sums along a line from the beginning of each block of the line, and
+    // up to its end
+    SumBufferType prefix;
+    SumBufferType suffix;
+
+    SumRealType Ia;
+    SumRealType Ja;
+    SumRealType sfm;
+    SumRealType sff;
+    SumRealType smm;
 
     FixedImageGradientType gradI;
     MovingImageGradientType gradJ;
@@ -210,47 +228,42 @@ protected:
   typedef struct ScanParaType {
     // const values during scanning
     ImageRegionType scan_region;
-    SizeValueType number_of_fill_zero; // for each queue
-    SizeValueType window_length; // number of voxels in the scanning window
-    IndexValueType scan_region_begin_index_dim0;
-
-    typename FixedImageType::ConstPointer I;
-    typename MovingImageType::ConstPointer J;
-    typename VirtualImageType::ConstPointer V;
+    RadiusType chunk_size; // size of the chunks, the last ones may be smaller
     RadiusType r;
 
+    // values of the current chunk
+    ImageRegionType padded_region; // chunk padded by r, within the domain
+    OffsetValueType padded_strides[VirtualImageDimension];
+
   } ScanParaType;
 
   // computation routines for normalized cross correlation
 
   void InitializeScanning(const ImageRegionType &scan_region,
-    ScanningIteratorType &scan_it, ScanMemType &scan_mem,
-    ScanParaType &scan_para ) const;
+    ScanMemType &scan_mem, ScanParaType &scan_para ) const;
 
-  void UpdateQueuesAtBeginingOfLine(
-    const ScanningIteratorType &scan_it, ScanMemType &scan_mem,
-    const ScanParaType &scan_para,
+  // Evaluate the images over the chunk padded by the radius, and compute
+  // the sums over the neighborhood window of each of its voxels.
+  void ComputeWindowSums(const ImageRegionType &chunk_region,
+    ScanMemType &scan_mem, ScanParaType &scan_para,
     const ThreadIdType threadID) const;
 
-  // Increment the iterator and check to see if we're at the end of the
-  // line.  If so, go to the next line.  Otherwise, add the
-  // the values for the next hyperplane.
-  void UpdateQueuesToNextScanWindow(
-    const ScanningIteratorType &scan_it, ScanMemType &scan_mem,
-    const ScanParaType &scan_para,
-    const ThreadIdType threadID) const;
-
-  void UpdateQueues(const ScanningIteratorType &scan_it,
-    ScanMemType &scan_mem, const ScanParaType &scan_para,
-    ThreadIdType threadID) const;
-
-  bool ComputeInformationFromQueues(
-    const ScanningIteratorType &scan_it, ScanMemType &scan_mem,
+  // Replace the values of a line of a sum buffer by their sums over the
+  // window of the given radius along the line. The line is split in blocks
+  // of the length of the window, the first of which begins \c phase values
+  // before the line, and each window sum is the sum of a suffix of a block
+  // and of a prefix of the next one.
+  static void ComputeWindowSumsAlongLine(SumRealType *values,
+    SizeValueType length, OffsetValueType stride, SizeValueType radius,
+    SizeValueType phase, ScanMemType &scan_mem);
+
+  bool ComputeInformationFromWindowSums(
+    const IndexType &index, ScanMemType &scan_mem,
     const ScanParaType &scan_para,
     const ThreadIdType threadID) const;
 
  void ComputeMovingTransformDerivative(
-    const ScanningIteratorType &scan_it, ScanMemType &scan_mem,
+    ScanMemType &scan_mem,
     const ScanParaType &scan_para, DerivativeType &deriv,
     MeasureType &local_cc, const ThreadIdType threadID) const;
 
@@ -20,6 +20,7 @@
 
 #include "itkANTSNeighborhoodCorrelationImageToImageObjectMetric.h"
 #include "itkNumericTraits.h"
+#include "itkImageRegionConstIteratorWithIndex.h"
 
 namespace itk
 {
@@ -96,45 +97,49 @@ ANTSNeighborhoodCorrelationImageToImageObjectMetric<TFixedImage,
 {
   Self *dataHolder = dynamic_cast<Self *>(dataHolderA);
 
-  VirtualPointType virtualPoint;
-  FixedOutputPointType mappedFixedPoint;
-  FixedImageGradientType fixedImageGradient;
-  MovingOutputPointType mappedMovingPoint;
-  MovingImageGradientType movingImageGradient;
   bool pointIsValid;
   MeasureType metricValueResult;
   MeasureType metricValueSum = 0;
 
   DerivativeType & localDerivativeResult = dataHolder->m_LocalDerivativesPerThread[threadID];
 
-  typedef Self MetricType;
-
-  ScanningIteratorType scan_it;
   ScanParaType scan_para;
   ScanMemType scan_mem;
 
-  /* Create an iterator over the virtual sub region */
-  dataHolder->InitializeScanning(virtualImageSubRegion, scan_it, scan_mem,
-      scan_para );
+  dataHolder->InitializeScanning(virtualImageSubRegion, scan_mem, scan_para );
 
-  /* Iterate over the sub region */
-  scan_it.GoToBegin();
-  while (!scan_it.IsAtEnd())
+  /* Iterate over the sub region, one chunk at a time, with the first
+   * dimension varying fastest */
+  const IndexType begin = virtualImageSubRegion.GetIndex();
+  const IndexType end = virtualImageSubRegion.GetUpperIndex();
+  IndexType chunk_index = begin;
+  bool chunksLeft = virtualImageSubRegion.GetNumberOfPixels() > 0;
+  ImageRegionType chunk_region;
+  while( chunksLeft )
     {
-    /* Get the virtual point */
-    dataHolder->m_VirtualDomainImage->TransformIndexToPhysicalPoint(
-        scan_it.GetIndex(), virtualPoint);
+    for( unsigned int d = 0; d < VirtualImageDimension; d++ )
+      {
+      chunk_region.SetIndex(d, chunk_index[d]);
+      chunk_region.SetSize(d, std::min( scan_para.chunk_size[d],
+        static_cast<SizeValueType>( end[d] - chunk_index[d] + 1 ) ) );
+      }
+    chunksLeft = false;
+    for( unsigned int d = 0; d < VirtualImageDimension && !chunksLeft; d++ )
+      {
+      chunk_index[d] += static_cast<IndexValueType>( scan_para.chunk_size[d] );
+      chunksLeft = chunk_index[d] <= end[d];
+      if( !chunksLeft )
+        {
+        chunk_index[d] = begin[d];
+        }
+      }
 
     /* Call the user method in derived classes to do the specific
      * calculations for value and derivative. */
     try
       {
-      dataHolder->UpdateQueues(scan_it, scan_mem, scan_para, threadID);
-      pointIsValid = dataHolder->ComputeInformationFromQueues(scan_it,
-          scan_mem, scan_para, threadID);
-      dataHolder->ComputeMovingTransformDerivative(scan_it, scan_mem,
-          scan_para, localDerivativeResult, metricValueResult,
-          threadID );
+      dataHolder->ComputeWindowSums(chunk_region, scan_mem, scan_para,
+        threadID);
       }
     catch (ExceptionObject & exc)
       {
@@ -145,19 +150,41 @@ ANTSNeighborhoodCorrelationImageToImageObjectMetric<TFixedImage,
       throw err;
       }
 
-    /* Assign the results */
-    if (pointIsValid)
+    ImageRegionConstIteratorWithIndex<VirtualImageType>
+      it( dataHolder->m_VirtualDomainImage, chunk_region );
+    for( it.GoToBegin(); !it.IsAtEnd(); ++it )
       {
-      dataHolder->m_NumberOfValidPointsPerThread[threadID]++;
-      metricValueSum += metricValueResult;
-      /* Store the result. This depends on what type of
-       * transform is being used. */
-      dataHolder->StoreDerivativeResult(localDerivativeResult,
-          scan_it.GetIndex(), threadID);
-      }
+      try
+        {
+        pointIsValid = dataHolder->ComputeInformationFromWindowSums(
+          it.GetIndex(), scan_mem, scan_para, threadID);
+        if (pointIsValid)
+          {
+          dataHolder->ComputeMovingTransformDerivative(scan_mem,
+            scan_para, localDerivativeResult, metricValueResult,
+            threadID );
+          }
+        }
+      catch (ExceptionObject & exc)
+        {
+        //NOTE: there must be a cleaner way to do this:
+        std::string msg("Caught exception: \n");
+        msg += exc.what();
+        ExceptionObject err(__FILE__, __LINE__, msg);
+        throw err;
+        }
 
-    //next index
-    ++scan_it;
+      /* Assign the results */
+      if (pointIsValid)
+        {
+        dataHolder->m_NumberOfValidPointsPerThread[threadID]++;
+        metricValueSum += metricValueResult;
+        /* Store the result. This depends on what type of
+         * transform is being used. */
+        dataHolder->StoreDerivativeResult(localDerivativeResult,
+            it.GetIndex(), threadID);
+        }
+      }
     }
 
   /* Store metric value result for this thread. */
@@ -168,311 +195,289 @@ template<class TFixedImage, class TMovingImage, class TVirtualImage>
 void ANTSNeighborhoodCorrelationImageToImageObjectMetric<TFixedImage,
 TMovingImage, TVirtualImage>
 ::InitializeScanning(
-    const ImageRegionType &scan_region, ScanningIteratorType &scan_it,
+    const ImageRegionType &scan_region,
     ScanMemType &, ScanParaType &scan_para ) const
 {
   scan_para.scan_region = scan_region;
-  scan_para.I = this->m_FixedImage;
-  scan_para.J = this->m_MovingImage;
-  scan_para.V = this->m_VirtualDomainImage;
   scan_para.r = this->GetRadius();
 
-  OffsetValueType nb_fill_zero = scan_para.V->GetBufferedRegion().GetIndex(0)
-      - (scan_region.GetIndex(0) - scan_para.r[0]);
-  if (nb_fill_zero < NumericTraits<OffsetValueType>::ZeroValue())
-    nb_fill_zero = NumericTraits<OffsetValueType>::ZeroValue();
-  scan_para.number_of_fill_zero = nb_fill_zero;
-
-  scan_it = ScanningIteratorType(scan_para.r, scan_para.I, scan_region);
-  scan_para.window_length = scan_it.Size();
-  scan_para.scan_region_begin_index_dim0 = scan_it.GetBeginIndex()[0];
+  // Limit the padded chunks to 2^20 voxels. Split the outermost dimension
+  // first, into chunks at least a window long, so that the voxels of the
+  // padding are not evaluated more often than those of the chunk, and
+  // split the next dimension too when even these are too large.
+  const ImageRegionType domain = this->GetVirtualDomainRegion();
+  const double maximumPaddedVoxels = 1 << 20;
+  double paddedSize[VirtualImageDimension];
+  for( unsigned int d = 0; d < VirtualImageDimension; d++ )
+    {
+    scan_para.chunk_size[d] = scan_region.GetSize(d);
+    paddedSize[d] = std::min( scan_region.GetSize(d) + 2 * scan_para.r[d],
+      domain.GetSize(d) );
+    }
+  for( unsigned int d = VirtualImageDimension; d-- > 0; )
+    {
+    double otherPaddedVoxels = 1.0;
+    for( unsigned int k = 0; k < VirtualImageDimension; k++ )
+      {
+      if( k != d )
+        {
+        otherPaddedVoxels *= paddedSize[k];
+        }
+      }
+    if( otherPaddedVoxels * paddedSize[d] <= maximumPaddedVoxels )
+      {
+      break;
+      }
+    const double diameter = 2.0 * scan_para.r[d];
+    const double length = vcl_floor( maximumPaddedVoxels / otherPaddedVoxels )
+      - diameter;
+    if( length >= diameter + 1.0 || d == 0 )
+      {
+      scan_para.chunk_size[d] = static_cast<SizeValueType>(
+        std::max( length, 1.0 ) );
+      break;
+      }
+    scan_para.chunk_size[d] = std::min( scan_para.chunk_size[d],
+      static_cast<SizeValueType>( diameter ) + 1 );
+    paddedSize[d] = std::min( scan_para.chunk_size[d] + diameter,
+      static_cast<double>( domain.GetSize(d) ) );
+    }
 }
 
 template<class TFixedImage, class TMovingImage, class TVirtualImage>
 void ANTSNeighborhoodCorrelationImageToImageObjectMetric<TFixedImage,
 TMovingImage, TVirtualImage>
-::UpdateQueuesAtBeginingOfLine(
-    const ScanningIteratorType &scan_it, ScanMemType &scan_mem,
-    const ScanParaType &scan_para, const ThreadIdType ) const
+::ComputeWindowSums(
+    const ImageRegionType &chunk_region, ScanMemType &scan_mem,
+    ScanParaType &scan_para, const ThreadIdType ) const
 {
-  SizeValueType nb_fill_zero = scan_para.number_of_fill_zero;
-  SizeValueType hoodlen = scan_para.window_length;
-
-  InternalComputationValueType zero
-    = NumericTraits<InternalComputationValueType>::ZeroValue();
-  scan_mem.Qsuma2 = SumQueueType(nb_fill_zero, zero);
-  scan_mem.Qsumb2 = SumQueueType(nb_fill_zero, zero);
-  scan_mem.Qsuma = SumQueueType(nb_fill_zero, zero);
-  scan_mem.Qsumb = SumQueueType(nb_fill_zero, zero);
-  scan_mem.Qsumab = SumQueueType(nb_fill_zero, zero);
-  scan_mem.Qcount = SumQueueType(nb_fill_zero, zero);
+  const ImageRegionType domain = this->GetVirtualDomainRegion();
+  ImageRegionType padded_region = chunk_region;
+  padded_region.PadByRadius(scan_para.r);
+  padded_region.Crop(domain);
+  scan_para.padded_region = padded_region;
+
+  OffsetValueType stride = 1;
+  for( unsigned int d = 0; d < VirtualImageDimension; d++ )
+    {
+    scan_para.padded_strides[d] = stride;
+    stride *= padded_region.GetSize(d);
+    }
+  const SizeValueType numberOfVoxels = padded_region.GetNumberOfPixels();
 
   typedef InternalComputationValueType LocalRealType;
+  const LocalRealType localZero = NumericTraits<LocalRealType>::ZeroValue();
 
-  // Now add the rest of the values from each hyperplane
-  SizeValueType diameter = static_cast<SizeValueType>(2) * scan_para.r[0];
+  scan_mem.suma2.resize(numberOfVoxels);
+  scan_mem.sumb2.resize(numberOfVoxels);
+  scan_mem.suma.resize(numberOfVoxels);
+  scan_mem.sumb.resize(numberOfVoxels);
+  scan_mem.sumab.resize(numberOfVoxels);
+  scan_mem.count.resize(numberOfVoxels);
 
-  for (SizeValueType i = nb_fill_zero;
-        i < ( diameter + NumericTraits<SizeValueType>::OneValue() ); i++)
+  // Evaluate each voxel of the padded chunk once.
+  VirtualPointType virtualPoint;
+  FixedOutputPointType mappedFixedPoint;
+  FixedImagePixelType fixedImageValue;
+  FixedImageGradientType fixedImageGradient;
+  MovingOutputPointType mappedMovingPoint;
+  MovingImagePixelType movingImageValue;
+  MovingImageGradientType movingImageGradient;
+  bool pointIsValid;
+
+  ImageRegionConstIteratorWithIndex<VirtualImageType>
+    it( this->m_VirtualDomainImage, padded_region );
+  SizeValueType n = 0;
+  for( it.GoToBegin(); !it.IsAtEnd(); ++it, ++n )
     {
-    LocalRealType localZero = NumericTraits<LocalRealType>::ZeroValue();
-    LocalRealType suma2 = localZero;
-    LocalRealType sumb2 = localZero;
-    LocalRealType suma = localZero;
-    LocalRealType sumb = localZero;
-    LocalRealType sumab = localZero;
-    LocalRealType count = localZero;
-
-    for ( SizeValueType indct = i; indct < hoodlen;
-          indct += ( diameter + NumericTraits<SizeValueType>::OneValue() ) )
+    const IndexType & index = it.GetIndex();
+    this->m_VirtualDomainImage->TransformIndexToPhysicalPoint(index,
+        virtualPoint);
+
+    this->TransformAndEvaluateFixedPoint( index,
+                      virtualPoint,
+                      false/*compute gradient*/,
+                      mappedFixedPoint,
+                      fixedImageValue,
+                      fixedImageGradient,
+                      pointIsValid );
+    if (pointIsValid)
       {
+      this->TransformAndEvaluateMovingPoint(index,
+                        virtualPoint,
+                        false/*compute gradient*/,
+                        mappedMovingPoint,
+                        movingImageValue,
+                        movingImageGradient,
+                        pointIsValid );
+      }
 
-      bool isInBounds = true;
-      scan_it.GetPixel(indct, isInBounds);
-
-      typename VirtualImageType::IndexType index = scan_it.GetIndex(indct);
-
-      if (!isInBounds)
-        {
-        // std::cout << "DEBUG: error" << std::endl;
-        continue;
-        }
-
-      VirtualPointType virtualPoint;
-      FixedOutputPointType mappedFixedPoint;
-      FixedImagePixelType fixedImageValue;
-      FixedImageGradientType fixedImageGradient;
-      MovingOutputPointType mappedMovingPoint;
-      MovingImagePixelType movingImageValue;
-      MovingImageGradientType movingImageGradient;
-      bool pointIsValid;
-
-      this->m_VirtualDomainImage->TransformIndexToPhysicalPoint(index,
-          virtualPoint);
+    if (pointIsValid)
+      {
+      LocalRealType a = fixedImageValue;
+      LocalRealType b = movingImageValue;
+      scan_mem.suma2[n] = a * a;
+      scan_mem.sumb2[n] = b * b;
+      scan_mem.suma[n] = a;
+      scan_mem.sumb[n] = b;
+      scan_mem.sumab[n] = a * b;
+      scan_mem.count[n] = NumericTraits<LocalRealType>::OneValue();
+      }
+    else
+      {
+      scan_mem.suma2[n] = localZero;
+      scan_mem.sumb2[n] = localZero;
+      scan_mem.suma[n] = localZero;
+      scan_mem.sumb[n] = localZero;
+      scan_mem.sumab[n] = localZero;
+      scan_mem.count[n] = localZero;
+      }
+    }
 
-      try
+  // Replace the values by their sums over the windows, one dimension after
+  // the other. The chunk is padded along every dimension, so that the sums
+  // along the first dimensions are complete over the padding of the next
+  // ones.
+  SumBufferType * const buffers[6] = { &scan_mem.suma2, &scan_mem.sumb2,
+    &scan_mem.suma, &scan_mem.sumb, &scan_mem.sumab, &scan_mem.count };
+  for( unsigned int d = 0; d < VirtualImageDimension; d++ )
+    {
+    const SizeValueType length = padded_region.GetSize(d);
+    const OffsetValueType lineStride = scan_para.padded_strides[d];
+    const SizeValueType numberOfOuterLines = numberOfVoxels
+      / ( length * lineStride );
+    const SizeValueType phase = static_cast<SizeValueType>(
+      padded_region.GetIndex(d) - domain.GetIndex(d) )
+      % ( 2 * scan_para.r[d] + 1 );
+    for( unsigned int b = 0; b < 6; b++ )
+      {
+      SumRealType *values = &( ( *buffers[b] )[0] );
+      for( SizeValueType outer = 0; outer < numberOfOuterLines; outer++ )
         {
-        this->TransformAndEvaluateFixedPoint( index,
-                          virtualPoint,
-                          false/*compute gradient*/,
-                          mappedFixedPoint,
-                          fixedImageValue,
-                          fixedImageGradient,
-                          pointIsValid );
-        if (pointIsValid)
+        for( OffsetValueType inner = 0; inner < lineStride; inner++ )
           {
-          this->TransformAndEvaluateMovingPoint(index,
-                            virtualPoint,
-                            false/*compute gradient*/,
-                            mappedMovingPoint,
-                            movingImageValue,
-                            movingImageGradient,
-                            pointIsValid );
+          ComputeWindowSumsAlongLine(
+            values + outer * length * lineStride + inner, length,
+            lineStride, scan_para.r[d], phase, scan_mem);
           }
         }
-      catch (ExceptionObject & exc)
-        {
-        //NOTE: there must be a cleaner way to do this:
-        std::string msg("Caught exception: \n");
-        msg += exc.what();
-        ExceptionObject err(__FILE__, __LINE__, msg);
-        throw err;
-        }
-
-
-      if (pointIsValid)
-        {
-        LocalRealType a = fixedImageValue; //scan_para.I->GetPixel(index);
-        LocalRealType b = movingImageValue; // scan_para.J->GetPixel(index);
-        suma2 += a * a;
-        sumb2 += b * b;
-        suma += a;
-        sumb += b;
-        sumab += a * b;
-        count += NumericTraits<LocalRealType>::OneValue();
-        }
-      }//for indct
-
-    scan_mem.Qsuma2.push_back(suma2);
-    scan_mem.Qsumb2.push_back(sumb2);
-    scan_mem.Qsuma.push_back(suma);
-    scan_mem.Qsumb.push_back(sumb);
-    scan_mem.Qsumab.push_back(sumab);
-    scan_mem.Qcount.push_back(count);
+      }
     }
 }
 
 template<class TFixedImage, class TMovingImage, class TVirtualImage>
 void ANTSNeighborhoodCorrelationImageToImageObjectMetric<TFixedImage,
 TMovingImage, TVirtualImage>
-::UpdateQueuesToNextScanWindow(
-    const ScanningIteratorType &scan_it, ScanMemType &scan_mem,
-    const ScanParaType &scan_para, const ThreadIdType ) const
+::ComputeWindowSumsAlongLine(SumRealType *values, SizeValueType length,
+  OffsetValueType stride, SizeValueType radius, SizeValueType phase,
+  ScanMemType &scan_mem)
 {
-  const SizeValueType hoodlen = scan_para.window_length;
-
-  typedef InternalComputationValueType LocalRealType;
-
-  LocalRealType localZero = NumericTraits<LocalRealType>::ZeroValue();
-
-  LocalRealType suma2 = localZero;
-  LocalRealType sumb2 = localZero;
-  LocalRealType suma = localZero;
-  LocalRealType sumb = localZero;
-  LocalRealType sumab = localZero;
-  LocalRealType count = localZero;
-
-  SizeValueType diameter = static_cast<SizeValueType>(2) * scan_para.r[0];
-
-  for ( SizeValueType indct = diameter; indct < hoodlen;
-    indct += (diameter + NumericTraits<SizeValueType>::OneValue()))
+  if( radius == 0 )
     {
-    bool isInBounds = true;
-
-    scan_it.GetPixel(indct, isInBounds);
-    typename VirtualImageType::IndexType index = scan_it.GetIndex(indct);
-
-    if (!isInBounds)
+    return;
+    }
+  const SizeValueType window = 2 * radius + 1;
+  SumBufferType & prefix = scan_mem.prefix;
+  SumBufferType & suffix = scan_mem.suffix;
+  prefix.resize(length);
+  suffix.resize(length);
+
+  // Sums from the beginning of the blocks, and up to their end. Within the
+  // line, these only depend on the values of the windows they are used for.
+  for( SizeValueType p = 0; p < length; p++ )
     {
-    continue;
+    prefix[p] = values[p * stride];
+    if( p > 0 && ( p + phase ) % window != 0 )
+      {
+      prefix[p] += prefix[p - 1];
+      }
+    }
+  for( SizeValueType p = length; p-- > 0; )
+    {
+    suffix[p] = values[p * stride];
+    if( p + 1 < length && ( p + 1 + phase ) % window != 0 )
+      {
+      suffix[p] += suffix[p + 1];
+      }
     }
 
-    VirtualPointType virtualPoint;
-    FixedOutputPointType mappedFixedPoint;
-    FixedImagePixelType fixedImageValue;
-    FixedImageGradientType fixedImageGradient;
-    MovingOutputPointType mappedMovingPoint;
-    MovingImagePixelType movingImageValue;
-    MovingImageGradientType movingImageGradient;
-    bool pointIsValid;
-
-    this->m_VirtualDomainImage->TransformIndexToPhysicalPoint(index, virtualPoint);
-    try
+  for( SizeValueType p = 0; p < length; p++ )
+    {
+    const SizeValueType lo = ( p > radius ) ? p - radius : 0;
+    const SizeValueType hi = std::min( p + radius, length - 1 );
+    if( ( lo + phase ) / window != ( hi + phase ) / window )
       {
-      this->TransformAndEvaluateFixedPoint( index,
-            virtualPoint,
-            false/*compute gradient*/,
-            mappedFixedPoint,
-            fixedImageValue,
-            fixedImageGradient,
-            pointIsValid );
-      if (pointIsValid)
-        {
-        this->TransformAndEvaluateMovingPoint( index,
-              virtualPoint,
-             false/*compute gradient*/,
-             mappedMovingPoint,
-             movingImageValue,
-             movingImageGradient,
-             pointIsValid );
-        }
+      values[p * stride] = suffix[lo] + prefix[hi];
       }
-    catch (ExceptionObject & exc)
+    else if( ( lo + phase ) % window == 0 )
       {
-      //NOTE: there must be a cleaner way to do this:
-      std::string msg("Caught exception: \n");
-      msg += exc.what();
-      ExceptionObject err(__FILE__, __LINE__, msg);
-      throw err;
+      values[p * stride] = prefix[hi];
       }
-    if (pointIsValid)
+    else
       {
-      LocalRealType a = fixedImageValue; //scan_para.I->GetPixel(index);
-      LocalRealType b = movingImageValue; // scan_para.J->GetPixel(index);
-
-      suma2 += a * a;
-      sumb2 += b * b;
-      suma += a;
-      sumb += b;
-      sumab += a * b;
-      count += NumericTraits<LocalRealType>::OneValue();
+      values[p * stride] = suffix[lo];
       }
     }
-    scan_mem.Qsuma2.push_back(suma2);
-    scan_mem.Qsumb2.push_back(sumb2);
-    scan_mem.Qsuma.push_back(suma);
-    scan_mem.Qsumb.push_back(sumb);
-    scan_mem.Qsumab.push_back(sumab);
-    scan_mem.Qcount.push_back(count);
-
-    scan_mem.Qsuma2.pop_front();
-    scan_mem.Qsumb2.pop_front();
-    scan_mem.Qsuma.pop_front();
-    scan_mem.Qsumb.pop_front();
-    scan_mem.Qsumab.pop_front();
-    scan_mem.Qcount.pop_front();
-}
-
-template<class TFixedImage, class TMovingImage, class TVirtualImage>
-void ANTSNeighborhoodCorrelationImageToImageObjectMetric<TFixedImage,
-TMovingImage, TVirtualImage>
-::UpdateQueues( const ScanningIteratorType &scan_it, ScanMemType &scan_mem,
-                const ScanParaType &scan_para, const ThreadIdType threadID) const
-{
-  if (scan_it.GetIndex()[0] == scan_para.scan_region_begin_index_dim0)
-    {
-    UpdateQueuesAtBeginingOfLine(scan_it, scan_mem, scan_para, threadID);
-    }
-  else
-    {
-    UpdateQueuesToNextScanWindow(scan_it, scan_mem, scan_para, threadID);
-    }
 }
 
 template<class TFixedImage, class TMovingImage, class TVirtualImage>
 bool ANTSNeighborhoodCorrelationImageToImageObjectMetric<TFixedImage,
 TMovingImage, TVirtualImage>
-::ComputeInformationFromQueues( const ScanningIteratorType &scan_it, ScanMemType &scan_mem, const ScanParaType &, const ThreadIdType ) const
+::ComputeInformationFromWindowSums( const IndexType &oindex,
+  ScanMemType &scan_mem, const ScanParaType &scan_para,
+  const ThreadIdType ) const
 {
-  // Test to see if there are any voxels we need to handle in the current
-  // window.
-
-  typedef InternalComputationValueType LocalRealType;
-
-  LocalRealType localZero = NumericTraits<LocalRealType>::ZeroValue();
+  VirtualPointType virtualPoint;
+  FixedOutputPointType mappedFixedPoint;
+  FixedImagePixelType fixedImageValue;
+  FixedImageGradientType fixedImageGradient;
+  MovingOutputPointType mappedMovingPoint;
+  MovingImagePixelType movingImageValue;
+  MovingImageGradientType movingImageGradient;
+  bool pointIsValid;
 
-  LocalRealType suma2 = localZero;
-  LocalRealType sumb2 = localZero;
-  LocalRealType suma = localZero;
-  LocalRealType sumb = localZero;
-  LocalRealType sumab = localZero;
-  LocalRealType count = localZero;
+  this->m_VirtualDomainImage->TransformIndexToPhysicalPoint(oindex, virtualPoint);
 
-  typename SumQueueType::iterator itcount = scan_mem.Qcount.begin();
-  while (itcount != scan_mem.Qcount.end())
+  this->TransformAndEvaluateFixedPoint( oindex,
+          virtualPoint,
+          this->GetGradientSourceIncludesFixed(),
+          mappedFixedPoint,
+          fixedImageValue,
+          fixedImageGradient,
+          pointIsValid );
+  if (pointIsValid)
     {
-    count += *itcount;
-    ++itcount;
+    this->TransformAndEvaluateMovingPoint( oindex,
+           virtualPoint,
+           true/*compute gradient*/,
+           mappedMovingPoint,
+           movingImageValue,
+           movingImageGradient,
+           pointIsValid );
     }
 
-  if (count < localZero)
+  // The window of a valid voxel contains at least this voxel.
+  if (!pointIsValid)
     {
-    // no points avaiable in the queue, perhapse out of image region
     return false;
     }
 
-  // If there are values, we need to calculate the different quantities
-  typename SumQueueType::iterator ita2 = scan_mem.Qsuma2.begin();
-  typename SumQueueType::iterator itb2 = scan_mem.Qsumb2.begin();
-  typename SumQueueType::iterator ita = scan_mem.Qsuma.begin();
-  typename SumQueueType::iterator itb = scan_mem.Qsumb.begin();
-  typename SumQueueType::iterator itab = scan_mem.Qsumab.begin();
-
-  while (ita2 != scan_mem.Qsuma2.end())
+  OffsetValueType offset = 0;
+  for( unsigned int d = 0; d < VirtualImageDimension; d++ )
     {
-    suma2 += *ita2;
-    sumb2 += *itb2;
-    suma += *ita;
-    sumb += *itb;
-    sumab += *itab;
-
-    ++ita2;
-    ++itb2;
-    ++ita;
-    ++itb;
-    ++itab;
+    offset += ( oindex[d] - scan_para.padded_region.GetIndex(d) )
+      * scan_para.padded_strides[d];
     }
 
+  typedef InternalComputationValueType LocalRealType;
+
+  const LocalRealType suma2 = scan_mem.suma2[offset];
+  const LocalRealType sumb2 = scan_mem.sumb2[offset];
+  const LocalRealType suma = scan_mem.suma[offset];
+  const LocalRealType sumb = scan_mem.sumb[offset];
+  const LocalRealType sumab = scan_mem.sumab[offset];
+  const LocalRealType count = scan_mem.count[offset];
+
   LocalRealType fixedMean = suma / count;
   LocalRealType movingMean = sumb / count;
 
@@ -483,72 +488,26 @@ TMovingImage, TVirtualImage>
   LocalRealType sfm = sumab - movingMean * suma - fixedMean * sumb
     + count * movingMean * fixedMean;
 
-  typename VirtualImageType::IndexType oindex = scan_it.GetIndex();
+  float val = fixedImageValue - fixedMean;
+  float val1 = movingImageValue - movingMean;
+  scan_mem.Ia = val;
+  scan_mem.Ja = val1;
+  scan_mem.sfm = sfm;
+  scan_mem.sff = sff;
+  scan_mem.smm = smm;
 
-  VirtualPointType virtualPoint;
-  FixedOutputPointType mappedFixedPoint;
-  FixedImagePixelType fixedImageValue;
-  FixedImageGradientType fixedImageGradient;
-  MovingOutputPointType mappedMovingPoint;
-  MovingImagePixelType movingImageValue;
-  MovingImageGradientType movingImageGradient;
-  bool pointIsValid;
-
-  this->m_VirtualDomainImage->TransformIndexToPhysicalPoint(oindex, virtualPoint);
-
-  try
-    {
-    this->TransformAndEvaluateFixedPoint( oindex,
-            virtualPoint,
-            true/*compute gradient*/,
-            mappedFixedPoint,
-            fixedImageValue,
-            fixedImageGradient,
-            pointIsValid );
-    if (pointIsValid)
-      {
-      this->TransformAndEvaluateMovingPoint( oindex,
-             virtualPoint,
-             true/*compute gradient*/,
-             mappedMovingPoint,
-             movingImageValue,
-             movingImageGradient,
-             pointIsValid );
-      }
-    }
-  catch (ExceptionObject & exc)
-    {
-    //NOTE: there must be a cleaner way to do this:
-    std::string msg("Caught exception: \n");
-    msg += exc.what();
-    ExceptionObject err(__FILE__, __LINE__, msg);
-    throw err;
-    }
+  scan_mem.gradI = fixedImageGradient;
+  scan_mem.gradJ = movingImageGradient;
 
-  if (pointIsValid)
-    {
-    float val = fixedImageValue - fixedMean; // scan_para.I->GetPixel(oindex) - fixedMean;
-    float val1 = movingImageValue - movingMean; // scan_para.J->GetPixel(oindex) - movingMean;
-    scan_mem.Ia = val;
-    scan_mem.Ja = val1;
-    scan_mem.sfm = sfm;
-    scan_mem.sff = sff;
-    scan_mem.smm = smm;
-
-    scan_mem.gradI = fixedImageGradient;
-    scan_mem.gradJ = movingImageGradient;
-
-    scan_mem.mappedMovingPoint = mappedMovingPoint;
-    }
+  scan_mem.mappedMovingPoint = mappedMovingPoint;
 
   return true;
 }
-
 template<class TFixedImage, class TMovingImage, class TVirtualImage>
 void ANTSNeighborhoodCorrelationImageToImageObjectMetric<TFixedImage,
 TMovingImage, TVirtualImage>
 ::ComputeMovingTransformDerivative(
-  const ScanningIteratorType &, ScanMemType &scan_mem,
+  ScanMemType &scan_mem,
   const ScanParaType &, DerivativeType &deriv,
   MeasureType &local_cc, const ThreadIdType threadID) const
 {
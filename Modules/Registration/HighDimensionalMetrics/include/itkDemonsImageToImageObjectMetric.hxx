@@ -90,12 +90,9 @@ DemonsImageToImageObjectMetric<TFixedImage,TMovingImage,TVirtualImage>
   metricValueReturn =
     vcl_fabs( diff  ) / static_cast<MeasureType>( this->FixedImageDimension );
 
-  /* Use a pre-allocated jacobian object for efficiency */
-  typedef typename Superclass::JacobianType &   JacobianReferenceType;
-  JacobianReferenceType jacobian = this->m_MovingTransformJacobianPerThread[threadID];
-
   /** For dense transforms, this returns identity */
-  this->m_MovingTransform->ComputeJacobianWithRespectToParameters( mappedMovingPoint, jacobian);
+  const JacobianType & jacobian =
+    this->GetMovingTransformJacobian( mappedMovingPoint, threadID );
 
   typedef typename DerivativeType::ValueType    DerivativeValueType;
   DerivativeValueType floatingpointcorrectionresolution = 10000.0;
@@ -102,6 +102,19 @@ class Array1DToData;
  * Generally it is not recommended to use different image gradient methods for
  * the fixed and moving images because the methods return different results.
  *
+ * Fixed sample cache:
+ * Since the fixed transform and the fixed image are assumed not to change
+ * between calls to \c Initialize, the mapped fixed point, the fixed image
+ * value and, when the metric uses the fixed image gradients, the fixed image
+ * gradient at each pixel of the virtual domain can be computed once in
+ * \c Initialize and reused at every iteration, by setting
+ * \c UseFixedSampleCache. This costs about the size of the virtual domain
+ * times the size of a point, a pixel and a gradient, and the cache is not
+ * built, the values being computed at each iteration instead, when this
+ * exceeds \c FixedSampleCacheMemoryLimit. The cache is not used with a
+ * fixed sampled point set, whose points are not at the virtual domain
+ * pixel centers. It is disabled by default.
+ *
  * Image masks are supported using SetMovingImageMask or SetFixedImageMask.
  *
  * Random sampling or user-supplied point lists are not yet supported, except
@@ -486,6 +499,21 @@ public:
   itkGetConstObjectMacro( MovingWarpedImage, MovingImageType );
   itkGetConstObjectMacro( FixedWarpedImage, FixedImageType );
 
+  /** Set/Get caching of the fixed domain values at the virtual domain
+   * pixels during \c Initialize. See the class documentation. */
+  itkSetMacro(UseFixedSampleCache, bool);
+  itkGetConstReferenceMacro(UseFixedSampleCache, bool);
+  itkBooleanMacro(UseFixedSampleCache);
+
+  /** Set/Get the largest number of bytes the fixed sample cache may use.
+   * The default is 1 GiB. */
+  itkSetMacro(FixedSampleCacheMemoryLimit, SizeValueType);
+  itkGetConstMacro(FixedSampleCacheMemoryLimit, SizeValueType);
+
+  /** Get whether the fixed sample cache was built during the last call
+   * to \c Initialize, and is used in the evaluations. */
+  itkGetConstMacro(FixedSampleCacheInUse, bool);
+
   /** Get number of threads to use.
    * \warning This value can change during Initialize, if the threader
    * determines that fewer threads would be more efficient. The default
@@ -570,9 +598,13 @@ protected:
    * and calls the derived class' user worker method to calculate
    * value and derivative.
    * Iterates over a range of samples and calls derived class for calculations.
+   * The samples are mapped to the moving space in batches of \c batchLength
+   * points, e.g. the scanlines of an image sub region, with a single call
+   * to the moving transform for each batch.
    */
   void GetValueAndDerivativeProcessPointRange(
                                       SamplingIteratorHelper & samplingIterator,
+                                      SizeValueType batchLength,
                                       ThreadIdType threadID,
                                       Self * self);
 
@@ -624,6 +656,20 @@ protected:
         DerivativeType &                  localDerivativeReturn,
         const ThreadIdType                threadID ) const;
 
+  /** Get the Jacobian of the moving transform with respect to its
+   * parameters at \c mappedMovingPoint, for use by
+   * GetValueAndDerivativeProcessPoint, which must pass the point it was
+   * given. Called from GetValueAndDerivativeProcessPointRange, the
+   * Jacobians of the whole batch of points are computed by one call to
+   * Transform::ComputeJacobiansWithRespectToParameters, unless they would
+   * take too much memory. Otherwise the Jacobian is computed in the
+   * pre-allocated Jacobian of the thread.
+   * \warning  This is called from the threader, and thus must be thread-safe.
+   */
+  const JacobianType & GetMovingTransformJacobian(
+        const MovingImagePointType &      mappedMovingPoint,
+        const ThreadIdType                threadID ) const;
+
   /** Perform any initialization required before each evaluation of
    * value and derivative. This is distinct from Initialize, which
    * is called only once before a number of iterations, e.g. before
@@ -662,6 +708,17 @@ protected:
                            MovingImageGradientType & mappedMovingImageGradient,
                            bool & pointIsValid ) const;
 
+  /** Evaluate a point already mapped to the MovingImage domain, as
+   * TransformAndEvaluateMovingPoint does after the mapping. This allows
+   * the points to be mapped in batches, see Transform::TransformPoints. */
+  virtual void EvaluateMovingPoint(
+                           const VirtualIndexType & index,
+                           const MovingImagePointType & mappedMovingPoint,
+                           const bool computeImageGradient,
+                           MovingImagePixelType & mappedMovingPixelValue,
+                           MovingImageGradientType & mappedMovingImageGradient,
+                           bool & pointIsValid ) const;
+
   /** Compute image derivatives for a Fixed point.
    * NOTE: This doesn't transform result into virtual space. For that,
    * see TransformAndEvaluateFixedPoint
@@ -687,6 +744,12 @@ protected:
                                     const VirtualIndexType & index,
                                     MovingImageGradientType & gradient ) const;
 
+  /** Build the fixed sample cache when \c UseFixedSampleCache is set,
+   * dense sampling is used and the cache fits in
+   * \c FixedSampleCacheMemoryLimit, or free it otherwise.
+   * Called at the end of \c Initialize. */
+  virtual void InitializeFixedSampleCache(void);
+
   /** Computes the gradients of the fixed image, using the
    * GradientFilter, assigning the output to
    * to m_FixedImageGradientImage. It will use either the original
@@ -763,6 +826,20 @@ protected:
   mutable FixedImagePointer   m_FixedWarpedImage;
   mutable MovingImagePointer  m_MovingWarpedImage;
 
+  /** Fixed sample cache options and state. */
+  bool                               m_UseFixedSampleCache;
+  SizeValueType                      m_FixedSampleCacheMemoryLimit;
+  bool                               m_FixedSampleCacheInUse;
+
+  /** Fixed sample cache, indexed by the offset of the virtual index in
+   * the virtual domain region it was built for. The gradients are only
+   * stored when the metric uses the fixed image gradients. */
+  VirtualRegionType                      m_FixedSampleCacheRegion;
+  std::vector< FixedImagePointType >     m_FixedSampleCachePoints;
+  std::vector< FixedImagePixelType >     m_FixedSampleCacheValues;
+  std::vector< FixedImageGradientType >  m_FixedSampleCacheGradients;
+  std::vector< unsigned char >           m_FixedSampleCacheValidPoints;
+
   /** Resample image filters for pre-warping images */
   MovingWarpResampleImageFilterPointer    m_MovingWarpResampleImageFilter;
   FixedWarpResampleImageFilterPointer     m_FixedWarpResampleImageFilter;
@@ -869,6 +946,25 @@ protected:
   typename SampledValueAndDerivativeThreaderType::Pointer
                                               m_SampledValueAndDerivativeThreader;
 
+  /** Type of the threader used to clear the derivatives before each
+   * evaluation, and to sum the per-thread derivatives of global transforms
+   * after it. Each thread processes a range of parameters, for all of the
+   * per-thread derivatives, so the sums are the same as when they are
+   * accumulated one thread after the other. */
+  typedef Array1DToData<Self> DerivativeReductionThreaderType;
+
+  /** Threader used to clear and sum the derivatives. */
+  typename DerivativeReductionThreaderType::Pointer
+                                              m_DerivativeReductionThreader;
+
+  /** Whether the sums of the derivatives are averaged, for the threads
+   * summing them. */
+  mutable bool                                m_DerivativeReductionDoAverage;
+
+  /** Threader used to build the fixed sample cache. */
+  typename DenseValueAndDerivativeThreaderType::Pointer
+                                              m_FixedSampleCacheThreader;
+
   /** Intermediary threaded metric value storage. */
   mutable std::vector<InternalComputationValueType>  m_MeasurePerThread;
   mutable std::vector< DerivativeType >              m_DerivativesPerThread;
@@ -879,6 +975,25 @@ protected:
    * classes for efficiency. */
   mutable std::vector<JacobianType>           m_MovingTransformJacobianPerThread;
 
+  /** The batch of points that GetValueAndDerivativeProcessPointRange is
+   * processing in a thread, and their transform Jacobians, computed on the
+   * first call to GetMovingTransformJacobian. \c Points is set only while
+   * GetValueAndDerivativeProcessPoint is called. */
+  struct MovingTransformJacobianBatchType
+    {
+    MovingTransformJacobianBatchType() :
+      Points( NULL ), NumberOfPoints( 0 ), CurrentPoint( 0 ), Computed( false )
+      {}
+
+    const MovingOutputPointType * Points;
+    SizeValueType                 NumberOfPoints;
+    SizeValueType                 CurrentPoint;
+    bool                          Computed;
+    std::vector<JacobianType>     Jacobians;
+    };
+  mutable std::vector<MovingTransformJacobianBatchType>
+                                              m_MovingTransformJacobianBatchPerThread;
+
   ImageToImageObjectMetric();
   virtual ~ImageToImageObjectMetric();
 
@@ -912,6 +1027,27 @@ private:
                         ThreadIdType threadId,
                         Self * dataHolder);
 
+  /** Derivative reduction threader callbacks. Clear the derivative result,
+   * and the per-thread derivatives of global transforms, or add the
+   * per-thread derivatives to the derivative result, over a range of
+   * parameters. */
+  static void ClearDerivativesThreadedCallback(
+                        const SampledThreaderInputObjectType& parameterRange,
+                        ThreadIdType threadId,
+                        Self * dataHolder);
+  static void SumDerivativesThreadedCallback(
+                        const SampledThreaderInputObjectType& parameterRange,
+                        ThreadIdType threadId,
+                        Self * dataHolder);
+
+  /** Fixed sample cache threader callback. Evaluates the fixed domain
+   * values over a sub-region of the virtual domain and stores them in the
+   * cache. */
+  static void FixedSampleCacheThreadedCallback(
+                        const DenseThreaderInputObjectType& virtualImageSubRegion,
+                        ThreadIdType threadId,
+                        Self * dataHolder);
+
   /** Map the fixed point set samples to the virtual domain */
   void MapFixedSampledPointSetToVirtual( void );
 
@@ -48,6 +48,18 @@ ImageToImageObjectMetric<TFixedImage, TMovingImage, TVirtualImage >
     Self::SampledGetValueAndDerivativeThreadedCallback );
   this->m_SampledValueAndDerivativeThreader->SetHolder( this );
 
+  /* Instantiate the threader used to clear and sum the derivatives. Its
+   * callback is set before each use. */
+  this->m_DerivativeReductionThreader = DerivativeReductionThreaderType::New();
+  this->m_DerivativeReductionThreader->SetHolder( this );
+  this->m_DerivativeReductionDoAverage = false;
+
+  /* Instantiate the threader used to build the fixed sample cache. */
+  this->m_FixedSampleCacheThreader = DenseValueAndDerivativeThreaderType::New();
+  this->m_FixedSampleCacheThreader->SetThreadedGenerateData(
+    Self::FixedSampleCacheThreadedCallback );
+  this->m_FixedSampleCacheThreader->SetHolder( this );
+
   this->m_ThreadingMemoryHasBeenInitialized = false;
 
   /* Both transforms default to an identity transform */
@@ -100,6 +112,11 @@ ImageToImageObjectMetric<TFixedImage, TMovingImage, TVirtualImage >
   this->m_UseMovingImageGradientFilter = true;
   this->m_UseFixedSampledPointSet = false;
 
+  /* The fixed sample cache is opt-in */
+  this->m_UseFixedSampleCache = false;
+  this->m_FixedSampleCacheMemoryLimit = 1024 * 1024 * 1024;
+  this->m_FixedSampleCacheInUse = false;
+
   this->m_UserHasProvidedVirtualDomainImage = false;
   this->m_NumberOfThreadsHasBeenInitialized = false;
 }
@@ -324,6 +341,102 @@ ImageToImageObjectMetric<TFixedImage, TMovingImage, TVirtualImage >
     itkDebugMacro("Initialize: ComputeMovingImageGradientFilterImage");
     this->ComputeMovingImageGradientFilterImage();
     }
+
+  /* Cache the fixed domain values last, once the fixed image is pre-warped
+   * and its gradients are computed. */
+  this->InitializeFixedSampleCache();
+}
+
+template<class TFixedImage,class TMovingImage,class TVirtualImage>
+void
+ImageToImageObjectMetric<TFixedImage, TMovingImage, TVirtualImage >
+::InitializeFixedSampleCache()
+{
+  /* Free the cache of a previous run. It must also not be used while
+   * it is rebuilt. */
+  this->m_FixedSampleCacheInUse = false;
+  std::vector< FixedImagePointType >().swap( this->m_FixedSampleCachePoints );
+  std::vector< FixedImagePixelType >().swap( this->m_FixedSampleCacheValues );
+  std::vector< FixedImageGradientType >().swap(
+                                          this->m_FixedSampleCacheGradients );
+  std::vector< unsigned char >().swap( this->m_FixedSampleCacheValidPoints );
+
+  if( ! this->m_UseFixedSampleCache || this->m_UseFixedSampledPointSet )
+    {
+    return;
+    }
+
+  const VirtualRegionType region = this->GetVirtualDomainRegion();
+  const SizeValueType numberOfPixels = region.GetNumberOfPixels();
+  const bool cacheGradients = this->GetGradientSourceIncludesFixed();
+  SizeValueType bytesPerPixel = sizeof( FixedImagePointType )
+                                + sizeof( FixedImagePixelType )
+                                + sizeof( unsigned char );
+  if( cacheGradients )
+    {
+    bytesPerPixel += sizeof( FixedImageGradientType );
+    }
+  if( numberOfPixels > this->m_FixedSampleCacheMemoryLimit / bytesPerPixel )
+    {
+    itkDebugMacro("InitializeFixedSampleCache: " << numberOfPixels
+                  << " pixels exceed the memory limit of "
+                  << this->m_FixedSampleCacheMemoryLimit
+                  << " bytes. The fixed domain values will be computed at "
+                  << "each iteration.");
+    return;
+    }
+
+  this->m_FixedSampleCacheRegion = region;
+  this->m_FixedSampleCachePoints.resize( numberOfPixels );
+  this->m_FixedSampleCacheValues.resize( numberOfPixels );
+  if( cacheGradients )
+    {
+    this->m_FixedSampleCacheGradients.resize( numberOfPixels );
+    }
+  this->m_FixedSampleCacheValidPoints.resize( numberOfPixels );
+
+  this->m_FixedSampleCacheThreader->SetOverallObject( region );
+  this->m_FixedSampleCacheThreader->SetNumberOfThreads(
+                                                  this->GetNumberOfThreads() );
+  this->m_FixedSampleCacheThreader->StartThreadedExecution();
+
+  this->m_FixedSampleCacheInUse = true;
+}
+
+template<class TFixedImage,class TMovingImage,class TVirtualImage>
+void
+ImageToImageObjectMetric<TFixedImage, TMovingImage, TVirtualImage >
+::FixedSampleCacheThreadedCallback(
+                const DenseThreaderInputObjectType & subRegion,
+                ThreadIdType itkNotUsed(threadID),
+                Self * self)
+{
+  const bool cacheGradients = ! self->m_FixedSampleCacheGradients.empty();
+  VirtualPointType        virtualPoint;
+  VirtualIndexType        virtualIndex;
+  FixedImagePixelType     mappedFixedPixelValue;
+  FixedImageGradientType  mappedFixedImageGradient;
+  bool                    pointIsValid;
+
+  SamplingIteratorHelper  iterator( self->m_VirtualDomainImage, subRegion );
+  while( iterator.GetNext( virtualIndex, virtualPoint ) )
+    {
+    const OffsetValueType offset =
+      self->m_VirtualDomainImage->ComputeOffset( virtualIndex );
+    self->TransformAndEvaluateFixedPoint( virtualIndex,
+                                          virtualPoint,
+                                          cacheGradients,
+                                          self->m_FixedSampleCachePoints[offset],
+                                          mappedFixedPixelValue,
+                                          mappedFixedImageGradient,
+                                          pointIsValid );
+    self->m_FixedSampleCacheValues[offset] = mappedFixedPixelValue;
+    if( cacheGradients && pointIsValid )
+      {
+      self->m_FixedSampleCacheGradients[offset] = mappedFixedImageGradient;
+      }
+    self->m_FixedSampleCacheValidPoints[offset] = pointIsValid;
+    }
 }
 
 template<class TFixedImage,class TMovingImage,class TVirtualImage>
@@ -333,9 +446,12 @@ ImageToImageObjectMetric<TFixedImage, TMovingImage, TVirtualImage >
 {
   //Initialize threading memory if this is the first time
   // in here since a call to Initialize, or if user has passed
-  // in a different object for the results (why might they do that?).
+  // in a different object for the results (why might they do that?),
+  // or one that was resized since.
   if( ! this->m_ThreadingMemoryHasBeenInitialized ||
-      &derivativeReturn != this->m_DerivativeResult )
+      &derivativeReturn != this->m_DerivativeResult ||
+      derivativeReturn.GetSize() !=
+        this->m_MovingTransform->GetNumberOfParameters() )
     {
     this->InitializeThreadingMemory( derivativeReturn );
     }
@@ -380,6 +496,8 @@ ImageToImageObjectMetric<TFixedImage, TMovingImage, TVirtualImage >
   this->m_LocalDerivativesPerThread.resize( this->GetNumberOfThreads() );
   /* Per-thread pre-allocated Jacobian objects for efficiency */
   this->m_MovingTransformJacobianPerThread.resize( this->GetNumberOfThreads() );
+  this->m_MovingTransformJacobianBatchPerThread.resize(
+                                              this->GetNumberOfThreads() );
 
   /* This size always comes from the moving image */
   NumberOfParametersType globalDerivativeSize =
@@ -423,6 +541,19 @@ ImageToImageObjectMetric<TFixedImage, TMovingImage, TVirtualImage >
         this->m_DerivativesPerThread[i].SetSize( globalDerivativeSize );
       }
     }
+
+  /* The derivatives are cleared and summed over ranges of parameters.
+   * Transforms without parameters, e.g. IdentityTransform, have none. */
+  if( globalDerivativeSize > 0 )
+    {
+    typename DerivativeReductionThreaderType::IndexRangeType parameterRange;
+    parameterRange[0] = 0;
+    parameterRange[1] = globalDerivativeSize - 1;
+    this->m_DerivativeReductionThreader->SetOverallIndexRange( parameterRange );
+    this->m_DerivativeReductionThreader->SetNumberOfThreads(
+                                                  this->GetNumberOfThreads() );
+    }
+
   /* This will be true until next call to Initialize */
   this->m_ThreadingMemoryHasBeenInitialized = true;
 }
@@ -438,18 +569,19 @@ ImageToImageObjectMetric<TFixedImage, TMovingImage, TVirtualImage >
     {
     this->m_NumberOfValidPointsPerThread[i] = 0;
     this->m_MeasurePerThread[i] = 0;
-    if ( ! this->m_MovingTransform->HasLocalSupport() )
-      {
-      /* Be sure to init to 0 here, because the threader may not use
-       * all the threads if the region is better split into fewer
-       * subregions. */
-      this->m_DerivativesPerThread[i].Fill( 0 );
-      }
     }
 
-  /* Clear derivative final result. This will
+  /* Clear derivative final result, and for global transforms the
+   * per-thread derivatives. Be sure to init these to 0 here, because the
+   * threader may not use all the threads if the region is better split
+   * into fewer subregions. Clearing the final result will
    * require an option to skip for use with multivariate metric. */
-  this->m_DerivativeResult->Fill( 0 );
+  if( this->m_DerivativeResult->GetSize() > 0 )
+    {
+    this->m_DerivativeReductionThreader->SetThreadedGenerateData(
+      Self::ClearDerivativesThreadedCallback );
+    this->m_DerivativeReductionThreader->StartThreadedExecution();
+    }
 
   /* Pre-warp the moving image if set to do so. Then we have
    * to recompute the image gradients if ImageFilter option is set.
@@ -490,13 +622,16 @@ void
 ImageToImageObjectMetric<TFixedImage, TMovingImage, TVirtualImage >
 ::GetValueAndDerivativeThreadedPostProcess( bool doAverage ) const
 {
-  /* For global transforms, sum the derivatives from each region. */
-  if ( ! this->m_MovingTransform->HasLocalSupport() )
+  /* For global transforms, sum the derivatives from each region, and
+   * average them, over ranges of parameters in parallel. Transforms with
+   * local support already have their derivatives in the result. */
+  if ( ! this->m_MovingTransform->HasLocalSupport()
+       && this->m_DerivativeResult->GetSize() > 0 )
     {
-    for (ThreadIdType i=0; i<this->GetNumberOfThreads(); i++)
-      {
-      *(this->m_DerivativeResult) += this->m_DerivativesPerThread[i];
-      }
+    this->m_DerivativeReductionDoAverage = doAverage;
+    this->m_DerivativeReductionThreader->SetThreadedGenerateData(
+      Self::SumDerivativesThreadedCallback );
+    this->m_DerivativeReductionThreader->StartThreadedExecution();
     }
 
   /* Accumulate the metric value from threads and store */
@@ -509,11 +644,60 @@ ImageToImageObjectMetric<TFixedImage, TMovingImage, TVirtualImage >
 
   if( doAverage )
     {
-    if ( ! this->m_MovingTransform->HasLocalSupport() )
+    this->m_Value /= this->m_NumberOfValidPoints;
+    }
+}
+
+template<class TFixedImage,class TMovingImage,class TVirtualImage>
+void
+ImageToImageObjectMetric<TFixedImage, TMovingImage, TVirtualImage >
+::ClearDerivativesThreadedCallback(
+                const SampledThreaderInputObjectType & parameterRange,
+                ThreadIdType itkNotUsed(threadID),
+                Self * self)
+{
+  const SizeValueType first = parameterRange[0];
+  const SizeValueType count = parameterRange[1] - parameterRange[0] + 1;
+
+  std::fill_n( self->m_DerivativeResult->data_block() + first, count,
+               NumericTraits< typename DerivativeType::ValueType >::Zero );
+  if ( ! self->m_MovingTransform->HasLocalSupport() )
+    {
+    for (ThreadIdType i=0; i<self->m_DerivativesPerThread.size(); i++)
       {
-      *(this->m_DerivativeResult) /= this->m_NumberOfValidPoints;
+      std::fill_n( self->m_DerivativesPerThread[i].data_block() + first, count,
+                   NumericTraits< typename DerivativeType::ValueType >::Zero );
+      }
+    }
+}
+
+template<class TFixedImage,class TMovingImage,class TVirtualImage>
+void
+ImageToImageObjectMetric<TFixedImage, TMovingImage, TVirtualImage >
+::SumDerivativesThreadedCallback(
+                const SampledThreaderInputObjectType & parameterRange,
+                ThreadIdType itkNotUsed(threadID),
+                Self * self)
+{
+  typedef typename DerivativeType::ValueType DerivativeValueType;
+
+  DerivativeValueType * const result = self->m_DerivativeResult->data_block();
+  const SizeValueType last = parameterRange[1];
+  for (ThreadIdType i=0; i<self->m_DerivativesPerThread.size(); i++)
+    {
+    const DerivativeValueType * const derivative =
+                                  self->m_DerivativesPerThread[i].data_block();
+    for (SizeValueType p = parameterRange[0]; p <= last; p++)
+      {
+      result[p] += derivative[p];
+      }
+    }
+  if ( self->m_DerivativeReductionDoAverage )
+    {
+    for (SizeValueType p = parameterRange[0]; p <= last; p++)
+      {
+      result[p] /= self->m_NumberOfValidPoints;
       }
-    this->m_Value /= this->m_NumberOfValidPoints;
     }
 }
 
@@ -526,7 +710,9 @@ ImageToImageObjectMetric<TFixedImage, TMovingImage, TVirtualImage >
                 Self * self)
 {
   SamplingIteratorHelper  iterator( self->m_VirtualDomainImage, subRegion );
-  self->GetValueAndDerivativeProcessPointRange( iterator, threadID, self );
+  // Map the points one scanline at a time.
+  self->GetValueAndDerivativeProcessPointRange( iterator, subRegion.GetSize(0),
+                                                threadID, self );
 }
 
 template<class TFixedImage,class TMovingImage,class TVirtualImage>
@@ -539,7 +725,9 @@ ImageToImageObjectMetric<TFixedImage, TMovingImage, TVirtualImage >
 {
   SamplingIteratorHelper iterator( self->m_VirtualDomainImage,
                                    self->m_VirtualSampledPointSet, sampledRange );
-  self->GetValueAndDerivativeProcessPointRange( iterator, threadID, self );
+  const SizeValueType batchLength = 256;
+  self->GetValueAndDerivativeProcessPointRange( iterator, batchLength,
+                                                threadID, self );
 }
 
 template<class TFixedImage,class TMovingImage,class TVirtualImage>
@@ -547,6 +735,7 @@ void
 ImageToImageObjectMetric<TFixedImage, TMovingImage, TVirtualImage >
 ::GetValueAndDerivativeProcessPointRange(
                 SamplingIteratorHelper & samplingIterator,
+                SizeValueType batchLength,
                 ThreadIdType threadID,
                 Self * self)
 {
@@ -555,7 +744,6 @@ ImageToImageObjectMetric<TFixedImage, TMovingImage, TVirtualImage >
   FixedOutputPointType        mappedFixedPoint;
   FixedImagePixelType         mappedFixedPixelValue;
   FixedImageGradientType      mappedFixedImageGradient;
-  MovingOutputPointType       mappedMovingPoint;
   MovingImagePixelType        mappedMovingPixelValue;
   MovingImageGradientType     mappedMovingImageGradient;
   bool                        pointIsValid = false;
@@ -568,17 +756,75 @@ ImageToImageObjectMetric<TFixedImage, TMovingImage, TVirtualImage >
   DerivativeType & localDerivativeResult =
                                    self->m_LocalDerivativesPerThread[threadID];
 
-  /* Iterate over the sub region */
-  while( samplingIterator.GetNext( virtualIndex, virtualPoint ) )
+  /* The current batch of samples and their mapping into moving space */
+  if( batchLength == 0 )
+    {
+    batchLength = 1;
+    }
+  std::vector<VirtualIndexType>       virtualIndices;
+  std::vector<VirtualPointType>       virtualPoints;
+  std::vector<MovingOutputPointType>  mappedMovingPoints( batchLength );
+  virtualIndices.reserve( batchLength );
+  virtualPoints.reserve( batchLength );
+
+  /* The Jacobians of the moving transform are computed for a whole batch
+   * when derived classes ask for them, unless they would take more than
+   * a megabyte, e.g. for a B-spline transform with many parameters. */
+  MovingTransformJacobianBatchType & jacobianBatch =
+                       self->m_MovingTransformJacobianBatchPerThread[threadID];
+  const SizeValueType maximumJacobianBatchSize = 1024 * 1024;
+  const bool          useJacobianBatch =
+    static_cast<SizeValueType>( self->GetNumberOfLocalParameters() )
+      * self->MovingImageDimension * batchLength
+      * sizeof( typename JacobianType::element_type )
+      <= maximumJacobianBatchSize;
+
+  /* Iterate over the sub region, one batch at a time */
+  bool morePoints = true;
+  while( morePoints )
   {
-    /* Transform the point into fixed and moving spaces, and evaluate.
+    virtualIndices.clear();
+    virtualPoints.clear();
+    while( virtualPoints.size() < batchLength
+           && ( morePoints =
+                samplingIterator.GetNext( virtualIndex, virtualPoint ) ) )
+      {
+      virtualIndices.push_back( virtualIndex );
+      virtualPoints.push_back( virtualPoint );
+      }
+    const SizeValueType numberOfPoints = virtualPoints.size();
+    if( numberOfPoints == 0 )
+      {
+      break;
+      }
+
+    /* Map the whole batch into moving space at once. */
+    try
+      {
+      self->m_MovingTransform->TransformPoints( &virtualPoints[0],
+                                                &mappedMovingPoints[0],
+                                                numberOfPoints );
+      }
+    catch( ExceptionObject & exc )
+      {
+      std::string msg("Caught exception: \n");
+      msg += exc.what();
+      ExceptionObject err(__FILE__, __LINE__, msg);
+      throw err;
+      }
+    jacobianBatch.NumberOfPoints = numberOfPoints;
+    jacobianBatch.Computed = false;
+
+    for( SizeValueType i = 0; i < numberOfPoints; i++ )
+    {
+    /* Transform the point into fixed space, and evaluate both images.
      * Different behavior with pre-warping enabled is handled transparently.
      * Do this in a try block to catch exceptions and print more useful info
      * then we otherwise get when exceptions are caught in MultiThreader. */
     try
       {
-      self->TransformAndEvaluateFixedPoint( virtualIndex,
-                                        virtualPoint,
+      self->TransformAndEvaluateFixedPoint( virtualIndices[i],
+                                        virtualPoints[i],
                                         self->GetGradientSourceIncludesFixed(),
                                         mappedFixedPoint,
                                         mappedFixedPixelValue,
@@ -601,13 +847,12 @@ ImageToImageObjectMetric<TFixedImage, TMovingImage, TVirtualImage >
 
     try
       {
-      self->TransformAndEvaluateMovingPoint( virtualIndex,
-                                      virtualPoint,
-                                      self->GetGradientSourceIncludesMoving(),
-                                      mappedMovingPoint,
-                                      mappedMovingPixelValue,
-                                      mappedMovingImageGradient,
-                                      pointIsValid );
+      self->EvaluateMovingPoint( virtualIndices[i],
+                                 mappedMovingPoints[i],
+                                 self->GetGradientSourceIncludesMoving(),
+                                 mappedMovingPixelValue,
+                                 mappedMovingImageGradient,
+                                 pointIsValid );
       }
     catch( ExceptionObject & exc )
       {
@@ -624,19 +869,27 @@ ImageToImageObjectMetric<TFixedImage, TMovingImage, TVirtualImage >
 
     /* Call the user method in derived classes to do the specific
      * calculations for value and derivative. */
+    if( useJacobianBatch )
+      {
+      jacobianBatch.Points = &mappedMovingPoints[0];
+      jacobianBatch.CurrentPoint = i;
+      }
     try
       {
       pointIsValid = self->GetValueAndDerivativeProcessPoint(
-                                     virtualPoint,
+                                     virtualPoints[i],
                                      mappedFixedPoint, mappedFixedPixelValue,
                                      mappedFixedImageGradient,
-                                     mappedMovingPoint, mappedMovingPixelValue,
+                                     mappedMovingPoints[i],
+                                     mappedMovingPixelValue,
                                      mappedMovingImageGradient,
                                      metricValueResult, localDerivativeResult,
                                      threadID );
+      jacobianBatch.Points = NULL;
       }
     catch( ExceptionObject & exc )
       {
+      jacobianBatch.Points = NULL;
       //NOTE: there must be a cleaner way to do this:
       std::string msg("Exception in GetValueAndDerivativeProcessPoint:\n");
       msg += exc.what();
@@ -655,13 +908,44 @@ ImageToImageObjectMetric<TFixedImage, TMovingImage, TVirtualImage >
     /* Store the result. The behavior depends on what type of
      * transform is being used. */
     self->StoreDerivativeResult( localDerivativeResult,
-                                 virtualIndex, threadID );
+                                 virtualIndices[i], threadID );
+    } //loop over batch
   } //loop over region
 
   /* Store metric value result for this thread. */
   self->m_MeasurePerThread[threadID] = metricValueSum;
 }
 
+template<class TFixedImage,class TMovingImage,class TVirtualImage>
+const typename ImageToImageObjectMetric<TFixedImage, TMovingImage, TVirtualImage >::JacobianType &
+ImageToImageObjectMetric<TFixedImage, TMovingImage, TVirtualImage >
+::GetMovingTransformJacobian( const MovingImagePointType & mappedMovingPoint,
+                              const ThreadIdType threadID ) const
+{
+  MovingTransformJacobianBatchType & jacobianBatch =
+                       this->m_MovingTransformJacobianBatchPerThread[threadID];
+  if( jacobianBatch.Points != NULL )
+    {
+    if( !jacobianBatch.Computed )
+      {
+      jacobianBatch.Jacobians.resize( jacobianBatch.NumberOfPoints );
+      this->m_MovingTransform->ComputeJacobiansWithRespectToParameters(
+                                            jacobianBatch.Points,
+                                            &jacobianBatch.Jacobians[0],
+                                            jacobianBatch.NumberOfPoints );
+      jacobianBatch.Computed = true;
+      }
+    return jacobianBatch.Jacobians[jacobianBatch.CurrentPoint];
+    }
+
+  /* Use a pre-allocated jacobian object for efficiency */
+  JacobianType & jacobian = this->m_MovingTransformJacobianPerThread[threadID];
+  this->m_MovingTransform->ComputeJacobianWithRespectToParameters(
+                                                            mappedMovingPoint,
+                                                            jacobian );
+  return jacobian;
+}
+
 template<class TFixedImage,class TMovingImage,class TVirtualImage>
 void
 ImageToImageObjectMetric<TFixedImage, TMovingImage, TVirtualImage >
@@ -719,51 +1003,83 @@ ImageToImageObjectMetric<TFixedImage, TMovingImage, TVirtualImage >
   pointIsValid = true;
   mappedFixedPixelValue = NumericTraits<FixedImagePixelType>::Zero;
 
-  // map the point into fixed space
-  mappedFixedPoint = this->m_FixedTransform->TransformPoint( virtualPoint );
-
-  // check against the mask if one is assigned
-  if ( this->m_FixedImageMask )
+  if( this->m_FixedSampleCacheInUse &&
+      this->m_FixedSampleCacheRegion.IsInside( index ) )
     {
-    // Check if mapped point is within the support region of the fixed image
-    // mask
-    pointIsValid = this->m_FixedImageMask->IsInside( mappedFixedPoint );
+    // use the values cached during Initialize
+    const OffsetValueType offset =
+      this->m_VirtualDomainImage->ComputeOffset( index );
+    mappedFixedPoint = this->m_FixedSampleCachePoints[offset];
+    pointIsValid = this->m_FixedSampleCacheValidPoints[offset] != 0;
     if( ! pointIsValid )
       {
       return;
       }
+    mappedFixedPixelValue = this->m_FixedSampleCacheValues[offset];
+    if( ! computeImageGradient )
+      {
+      return;
+      }
+    if( ! this->m_FixedSampleCacheGradients.empty() )
+      {
+      mappedFixedImageGradient = this->m_FixedSampleCacheGradients[offset];
+      return;
+      }
     }
-
-  // Check if mapped point is inside image buffer
-  pointIsValid = this->m_FixedInterpolator->IsInsideBuffer(mappedFixedPoint);
-  if( ! pointIsValid )
+  else
     {
-    return;
+    // map the point into fixed space
+    mappedFixedPoint = this->m_FixedTransform->TransformPoint( virtualPoint );
+
+    // check against the mask if one is assigned
+    if ( this->m_FixedImageMask )
+      {
+      // Check if mapped point is within the support region of the fixed image
+      // mask
+      pointIsValid = this->m_FixedImageMask->IsInside( mappedFixedPoint );
+      if( ! pointIsValid )
+        {
+        return;
+        }
+      }
+
+    // Check if mapped point is inside image buffer
+    pointIsValid = this->m_FixedInterpolator->IsInsideBuffer(mappedFixedPoint);
+    if( ! pointIsValid )
+      {
+      return;
+      }
+
+    if( this->m_DoFixedImagePreWarp )
+      {
+      /* Get the pixel values at this index */
+      mappedFixedPixelValue = this->m_FixedWarpedImage->GetPixel( index );
+      }
+    else
+      {
+      mappedFixedPixelValue =
+        this->m_FixedInterpolator->Evaluate(mappedFixedPoint);
+      }
+    if( ! computeImageGradient )
+      {
+      return;
+      }
     }
 
   if( this->m_DoFixedImagePreWarp )
     {
-    /* Get the pixel values at this index */
-    mappedFixedPixelValue = this->m_FixedWarpedImage->GetPixel( index );
-    if( computeImageGradient )
-      {
-      ComputeFixedImageGradientAtIndex( index, mappedFixedImageGradient );
-      }
+    ComputeFixedImageGradientAtIndex( index, mappedFixedImageGradient );
     }
   else
     {
-    mappedFixedPixelValue = this->m_FixedInterpolator->Evaluate(mappedFixedPoint);
-    if( computeImageGradient )
-      {
-      this->ComputeFixedImageGradientAtPoint( mappedFixedPoint,
-                                       mappedFixedImageGradient );
-      //Transform the gradient into the virtual domain. We compute gradient
-      // in the fixed and moving domains and then transform to virtual.
-      mappedFixedImageGradient =
-        this->m_FixedTransform->TransformCovariantVector(
-                                                      mappedFixedImageGradient,
-                                                      mappedFixedPoint );
-      }
+    this->ComputeFixedImageGradientAtPoint( mappedFixedPoint,
+                                     mappedFixedImageGradient );
+    //Transform the gradient into the virtual domain. We compute gradient
+    // in the fixed and moving domains and then transform to virtual.
+    mappedFixedImageGradient =
+      this->m_FixedTransform->TransformCovariantVector(
+                                                    mappedFixedImageGradient,
+                                                    mappedFixedPoint );
     }
 }
 
@@ -779,12 +1095,28 @@ ImageToImageObjectMetric<TFixedImage, TMovingImage, TVirtualImage >
                          MovingImageGradientType & mappedMovingImageGradient,
                          bool & pointIsValid ) const
 {
-  pointIsValid = true;
-  mappedMovingPixelValue = NumericTraits<MovingImagePixelType>::Zero;
-
   // map the point into moving space
   mappedMovingPoint = this->m_MovingTransform->TransformPoint( virtualPoint );
 
+  this->EvaluateMovingPoint( index, mappedMovingPoint, computeImageGradient,
+                             mappedMovingPixelValue, mappedMovingImageGradient,
+                             pointIsValid );
+}
+
+template<class TFixedImage,class TMovingImage,class TVirtualImage>
+void
+ImageToImageObjectMetric<TFixedImage, TMovingImage, TVirtualImage >
+::EvaluateMovingPoint(
+                         const VirtualIndexType & index,
+                         const MovingImagePointType & mappedMovingPoint,
+                         const bool computeImageGradient,
+                         MovingImagePixelType & mappedMovingPixelValue,
+                         MovingImageGradientType & mappedMovingImageGradient,
+                         bool & pointIsValid ) const
+{
+  pointIsValid = true;
+  mappedMovingPixelValue = NumericTraits<MovingImagePixelType>::Zero;
+
   // check against the mask if one is assigned
   if ( this->m_MovingImageMask )
     {
@@ -1514,6 +1846,13 @@ ImageToImageObjectMetric<TFixedImage, TMovingImage, TVirtualImage >
                << "DoFixedImagePreWarp: " << this->GetDoFixedImagePreWarp()
                << std::endl
                << "DoMovingImagePreWarp: " << this->GetDoMovingImagePreWarp()
+               << std::endl
+               << "UseFixedSampleCache: " << this->GetUseFixedSampleCache()
+               << std::endl
+               << "FixedSampleCacheMemoryLimit: "
+               << this->GetFixedSampleCacheMemoryLimit()
+               << std::endl
+               << "FixedSampleCacheInUse: " << this->GetFixedSampleCacheInUse()
                << std::endl;
 
   if( this->m_NumberOfThreadsHasBeenInitialized )
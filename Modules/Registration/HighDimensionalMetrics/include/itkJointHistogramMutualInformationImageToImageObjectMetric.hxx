@@ -329,13 +329,23 @@ JointHistogramMutualInformationImageToImageObjectMetric<TFixedImage,TMovingImage
       ExceptionObject err(__FILE__, __LINE__, msg);
       throw err;
       }
-    /** add the paired intensity points to the joint histogram */
+    /** add the paired intensity points to the joint histogram, skipping
+     * the points outside the images or the masks, whose values are not
+     * those of the images, and may fall outside of the histogram */
+    if( ! pointIsValid )
+      {
+      continue;
+      }
     JointPDFPointType jointPDFpoint;
     this->ComputeJointPDFPoint(fixedImageValue,movingImageValue, jointPDFpoint,0);
     JointPDFIndexType  jointPDFIndex;
     jointPDFIndex.Fill( 0 );
-    this->m_JointPDF->TransformPhysicalPointToIndex( jointPDFpoint, jointPDFIndex);
-    this->m_JointPDF->SetPixel( jointPDFIndex, this->m_JointPDF->GetPixel(jointPDFIndex)+1);
+    if( this->m_JointPDF->TransformPhysicalPointToIndex( jointPDFpoint,
+                                                         jointPDFIndex ) )
+      {
+      this->m_JointPDF->SetPixel( jointPDFIndex,
+                                  this->m_JointPDF->GetPixel(jointPDFIndex)+1);
+      }
     }
 
   delete iterator;
@@ -511,14 +521,9 @@ JointHistogramMutualInformationImageToImageObjectMetric<TFixedImage, TMovingImag
     scalingfactor = 0;
     }
 
-  /* Use a pre-allocated jacobian object for efficiency */
-  FixedTransformJacobianType & jacobian =
-    const_cast< FixedTransformJacobianType &   >(this->m_MovingTransformJacobianPerThread[threadID]);
-
   /** For dense transforms, this returns identity */
-  this->m_MovingTransform->ComputeJacobianWithRespectToParameters(
-                                                            mappedMovingPoint,
-                                                            jacobian);
+  const MovingTransformJacobianType & jacobian =
+    this->GetMovingTransformJacobian( mappedMovingPoint, threadID );
 
   // this correction is necessary for consistent derivatives across N threads
   typedef typename DerivativeType::ValueType    DerivativeValueType;
@@ -0,0 +1,390 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkANTSNeighborhoodCorrelationImageToImageObjectMetric.h"
+#include "itkDisplacementFieldTransform.h"
+#include "itkAffineTransform.h"
+#include "itkTranslationTransform.h"
+#include "itkDiscreteGaussianImageFilter.h"
+#include "itkImageRegionIterator.h"
+#include "itkMultiThreader.h"
+#include "itkTimeProbe.h"
+#include <iomanip>
+
+//FIXME We need these as long as we have to define ImageToData and
+// Array1DToData as a fwd-declare in itkImageToImageObjectMetric.h
+#include "itkImageToData.h"
+#include "itkArray1DToData.h"
+
+// Evaluates the neighborhood correlation of two smoothed noise volumes,
+// with a translated fixed image, with several radii, with a displacement
+// field and with an affine transform, and with several numbers of
+// threads, and checks the value and the derivative against sums over the
+// windows of each voxel computed one by one. It also does so for volumes
+// whose slices, a window thick, exceed the 2^20 voxels of the chunks, so
+// that they are split along two dimensions. It then reports the time
+// taken by an evaluation with radii 2 to 8. Pass a larger edge length,
+// e.g. 256, to use it as a benchmark.
+
+namespace
+{
+const unsigned int Dimension = 3;
+typedef itk::Image< double, Dimension >                                                  ImageType;
+typedef itk::ANTSNeighborhoodCorrelationImageToImageObjectMetric< ImageType, ImageType > MetricType;
+typedef itk::TranslationTransform< double, Dimension >                                   TranslationTransformType;
+typedef itk::AffineTransform< double, Dimension >                                        AffineTransformType;
+typedef itk::DisplacementFieldTransform< double, Dimension >                             DisplacementTransformType;
+
+// Computes the value and the derivative from the sums over the window of
+// each voxel, one voxel at a time.
+class ReferenceMetric : public MetricType
+{
+public:
+  typedef ReferenceMetric                 Self;
+  typedef MetricType                      Superclass;
+  typedef itk::SmartPointer< Self >       Pointer;
+  typedef itk::SmartPointer< const Self > ConstPointer;
+
+  itkNewMacro(Self);
+
+  // Must be called after an evaluation, which allocates the per-thread
+  // memory.
+  void ComputeReference(MeasureType & value, DerivativeType & derivative) const
+  {
+    const ImageRegionType domain = this->GetVirtualDomainRegion();
+    derivative.SetSize( this->m_MovingTransform->GetNumberOfParameters() );
+    derivative.Fill(0.0);
+    DerivativeType localDerivative( this->GetNumberOfLocalParameters() );
+    ScanMemType    scan_mem;
+    ScanParaType   scan_para;
+
+    value = 0.0;
+    unsigned int                                        numberOfValidPoints = 0;
+    itk::ImageRegionConstIteratorWithIndex< ImageType > it(this->m_VirtualDomainImage, domain);
+    for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+      {
+      double                  a, b;
+      FixedImageGradientType  fixedGradient;
+      MovingImageGradientType movingGradient;
+      MovingOutputPointType   mappedMovingPoint;
+      if ( !this->Evaluate(it.GetIndex(), true, a, b, fixedGradient, movingGradient, mappedMovingPoint) )
+        {
+        continue;
+        }
+
+      ImageRegionType::SizeType one;
+      one.Fill(1);
+      ImageRegionType window(it.GetIndex(), one);
+      window.PadByRadius( this->GetRadius() );
+      window.Crop(domain);
+      double suma2 = 0.0, sumb2 = 0.0, suma = 0.0, sumb = 0.0, sumab = 0.0, count = 0.0;
+      itk::ImageRegionConstIteratorWithIndex< ImageType > wit(this->m_VirtualDomainImage, window);
+      for ( wit.GoToBegin(); !wit.IsAtEnd(); ++wit )
+        {
+        double                  wa, wb;
+        FixedImageGradientType  windowFixedGradient;
+        MovingImageGradientType windowMovingGradient;
+        MovingOutputPointType   windowMappedMovingPoint;
+        if ( this->Evaluate(wit.GetIndex(), false, wa, wb, windowFixedGradient, windowMovingGradient,
+                            windowMappedMovingPoint) )
+          {
+          suma2 += wa * wa;
+          sumb2 += wb * wb;
+          suma += wa;
+          sumb += wb;
+          sumab += wa * wb;
+          count += 1.0;
+          }
+        }
+
+      const double fixedMean = suma / count;
+      const double movingMean = sumb / count;
+      scan_mem.sff = suma2 - 2.0 * fixedMean * suma + count * fixedMean * fixedMean;
+      scan_mem.smm = sumb2 - 2.0 * movingMean * sumb + count * movingMean * movingMean;
+      scan_mem.sfm = sumab - movingMean * suma - fixedMean * sumb + count * movingMean * fixedMean;
+      scan_mem.Ia = static_cast< float >( a - fixedMean );
+      scan_mem.Ja = static_cast< float >( b - movingMean );
+      scan_mem.gradJ = movingGradient;
+      scan_mem.mappedMovingPoint = mappedMovingPoint;
+
+      MeasureType localValue;
+      this->ComputeMovingTransformDerivative(scan_mem, scan_para, localDerivative, localValue, 0);
+      value += localValue;
+      ++numberOfValidPoints;
+      if ( this->m_MovingTransform->HasLocalSupport() )
+        {
+        const unsigned int offset = this->m_VirtualDomainImage->ComputeOffset( it.GetIndex() )
+                                    * localDerivative.Size();
+        for ( unsigned int p = 0; p < localDerivative.Size(); ++p )
+          {
+          derivative[offset + p] += localDerivative[p];
+          }
+        }
+      else
+        {
+        derivative += localDerivative;
+        }
+      }
+    value /= numberOfValidPoints;
+    if ( !this->m_MovingTransform->HasLocalSupport() )
+      {
+      derivative /= numberOfValidPoints;
+      }
+  }
+
+protected:
+  ReferenceMetric() {}
+
+private:
+  bool Evaluate(const IndexType & index, bool computeGradients, double & a, double & b,
+                FixedImageGradientType & fixedGradient, MovingImageGradientType & movingGradient,
+                MovingOutputPointType & mappedMovingPoint) const
+  {
+    VirtualPointType     virtualPoint;
+    FixedOutputPointType mappedFixedPoint;
+    FixedImagePixelType  fixedValue;
+    MovingImagePixelType movingValue;
+    bool                 pointIsValid;
+    this->m_VirtualDomainImage->TransformIndexToPhysicalPoint(index, virtualPoint);
+    this->TransformAndEvaluateFixedPoint(index, virtualPoint, false, mappedFixedPoint, fixedValue,
+                                         fixedGradient, pointIsValid);
+    if ( pointIsValid )
+      {
+      this->TransformAndEvaluateMovingPoint(index, virtualPoint, computeGradients, mappedMovingPoint,
+                                            movingValue, movingGradient, pointIsValid);
+      }
+    a = fixedValue;
+    b = movingValue;
+    return pointIsValid;
+  }
+
+  ReferenceMetric(const Self &); //purposely not implemented
+  void operator=(const Self &);  //purposely not implemented
+};
+
+ImageType::Pointer MakeImage(const ImageType::SizeType & size, unsigned int seed)
+{
+  ImageType::Pointer noise = ImageType::New();
+  noise->SetRegions(size);
+  noise->Allocate();
+  unsigned int random = seed;
+  itk::ImageRegionIterator< ImageType > it( noise, noise->GetLargestPossibleRegion() );
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    random = random * 1103515245 + 12345;
+    it.Set( ( random >> 8 ) % 1000 );
+    }
+  typedef itk::DiscreteGaussianImageFilter< ImageType, ImageType > GaussianType;
+  GaussianType::Pointer gaussian = GaussianType::New();
+  gaussian->SetInput(noise);
+  gaussian->SetVariance(2.0);
+  gaussian->Update();
+  return gaussian->GetOutput();
+}
+
+MetricType::MovingTransformType::Pointer MakeMovingTransform(bool displacementField, const ImageType *image)
+{
+  if ( !displacementField )
+    {
+    AffineTransformType::Pointer transform = AffineTransformType::New();
+    AffineTransformType::ParametersType parameters = transform->GetParameters();
+    parameters[0] = 1.02;
+    parameters[1] = 0.03;
+    parameters[5] = -0.02;
+    parameters[9] = 0.4;
+    parameters[10] = -0.3;
+    AffineTransformType::CenterType center;
+    for ( unsigned int d = 0; d < Dimension; ++d )
+      {
+      center[d] = image->GetLargestPossibleRegion().GetSize()[d] / 2.0;
+      }
+    transform->SetCenter(center);
+    transform->SetParameters(parameters);
+    return transform.GetPointer();
+    }
+
+  typedef DisplacementTransformType::DisplacementFieldType FieldType;
+  FieldType::Pointer field = FieldType::New();
+  field->SetRegions( image->GetLargestPossibleRegion() );
+  field->SetSpacing( image->GetSpacing() );
+  field->SetOrigin( image->GetOrigin() );
+  field->SetDirection( image->GetDirection() );
+  field->Allocate();
+  unsigned int random = 3;
+  itk::ImageRegionIterator< FieldType > it( field, field->GetLargestPossibleRegion() );
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    FieldType::PixelType displacement;
+    for ( unsigned int d = 0; d < Dimension; ++d )
+      {
+      random = random * 1103515245 + 12345;
+      displacement[d] = ( ( random >> 8 ) % 1000 ) / 1000.0 - 0.5;
+      }
+    it.Set(displacement);
+    }
+  DisplacementTransformType::Pointer transform = DisplacementTransformType::New();
+  transform->SetDisplacementField(field);
+  return transform.GetPointer();
+}
+
+void SetUp(MetricType *metric, ImageType *fixedImage, ImageType *movingImage, bool displacementField,
+           const MetricType::RadiusType & radius, unsigned int numberOfThreads)
+{
+  TranslationTransformType::Pointer fixedTransform = TranslationTransformType::New();
+  TranslationTransformType::OutputVectorType translation;
+  translation[0] = 0.3;
+  translation[1] = -1.6;
+  translation[2] = 0.2;
+  fixedTransform->Translate(translation);
+
+  metric->SetRadius(radius);
+  metric->SetFixedImage(fixedImage);
+  metric->SetMovingImage(movingImage);
+  metric->SetFixedTransform(fixedTransform);
+  metric->SetMovingTransform( MakeMovingTransform(displacementField, fixedImage) );
+  metric->SetNumberOfThreads(numberOfThreads);
+  metric->Initialize();
+}
+
+bool TestMetric(ImageType *fixedImage, ImageType *movingImage, bool displacementField,
+                const MetricType::RadiusType & radius)
+{
+  std::ostringstream name;
+  name << ( displacementField ? "displacement field" : "affine" ) << ", radius " << radius;
+
+  ReferenceMetric::Pointer reference = ReferenceMetric::New();
+  SetUp(reference, fixedImage, movingImage, displacementField, radius, 1);
+  MetricType::MeasureType    expectedValue;
+  MetricType::DerivativeType expectedDerivative;
+  reference->GetValueAndDerivative(expectedValue, expectedDerivative);
+  reference->ComputeReference(expectedValue, expectedDerivative);
+  std::cout << name.str() << ": " << expectedValue << std::endl;
+
+  // The local derivatives are truncated to multiples of 1e-4.
+  const double tolerance = displacementField ? 1.00001e-4 : 1e-6;
+  MetricType::DerivativeType firstDerivative;
+  for ( unsigned int threads = 1; threads <= 5; threads += 2 )
+    {
+    MetricType::Pointer metric = MetricType::New();
+    SetUp(metric, fixedImage, movingImage, displacementField, radius, threads);
+    MetricType::MeasureType    value;
+    MetricType::DerivativeType derivative;
+    metric->GetValueAndDerivative(value, derivative);
+    if ( vcl_abs(value - expectedValue) > 1e-10 )
+      {
+      std::cerr << name.str() << ": the value is " << value << " instead of " << expectedValue << " with "
+                << threads << " threads" << std::endl;
+      return false;
+      }
+    for ( unsigned int p = 0; p < derivative.Size(); ++p )
+      {
+      if ( vcl_abs(derivative[p] - expectedDerivative[p]) > tolerance )
+        {
+        std::cerr << name.str() << ": the derivative of parameter " << p << " is " << derivative[p]
+                  << " instead of " << expectedDerivative[p] << " with " << threads << " threads" << std::endl;
+        return false;
+        }
+      }
+
+    // The window sums do not depend on the number of threads, so neither
+    // do the local derivatives.
+    if ( threads == 1 )
+      {
+      firstDerivative = derivative;
+      }
+    else if ( displacementField && derivative != firstDerivative )
+      {
+      std::cerr << name.str() << ": the results with " << threads << " threads differ from those with 1 thread"
+                << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+}
+
+int itkANTSNeighborhoodCorrelationImageToImageObjectMetricWindowTest(int argc, char *argv[])
+{
+  unsigned int edgeLength = 32;
+  if ( argc > 1 )
+    {
+    edgeLength = atoi(argv[1]);
+    }
+
+  ImageType::SizeType size;
+  size[0] = 11;
+  size[1] = 9;
+  size[2] = 13;
+  ImageType::Pointer fixedImage = MakeImage(size, 1);
+  ImageType::Pointer movingImage = MakeImage(size, 2);
+
+  MetricType::RadiusType radii[3];
+  radii[0].Fill(1);
+  radii[1][0] = 2;
+  radii[1][1] = 0;
+  radii[1][2] = 3;
+  radii[2][0] = 3;
+  radii[2][1] = 4;
+  radii[2][2] = 7;
+  for ( unsigned int r = 0; r < 3; ++r )
+    {
+    if ( !TestMetric(fixedImage, movingImage, true, radii[r])
+         || !TestMetric(fixedImage, movingImage, false, radii[r]) )
+      {
+      return EXIT_FAILURE;
+      }
+    }
+
+  // 1000x300x4 voxels, in padded chunks of 1000x262x4 voxels.
+  ImageType::SizeType largeSize;
+  largeSize[0] = 1000;
+  largeSize[1] = 300;
+  largeSize[2] = 4;
+  ImageType::Pointer largeFixedImage = MakeImage(largeSize, 1);
+  ImageType::Pointer largeMovingImage = MakeImage(largeSize, 2);
+  if ( !TestMetric(largeFixedImage, largeMovingImage, false, radii[0]) )
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Benchmark.
+  ImageType::SizeType benchmarkSize;
+  benchmarkSize.Fill(edgeLength);
+  ImageType::Pointer benchmarkFixedImage = MakeImage(benchmarkSize, 1);
+  ImageType::Pointer benchmarkMovingImage = MakeImage(benchmarkSize, 2);
+  std::cout << "Evaluating the metric of " << edgeLength << "^3 volumes with a displacement field, s:"
+            << std::endl;
+  std::cout << "   radius        time" << std::endl;
+  for ( unsigned int radius = 2; radius <= 8; radius += 2 )
+    {
+    MetricType::RadiusType benchmarkRadius;
+    benchmarkRadius.Fill(radius);
+    MetricType::Pointer metric = MetricType::New();
+    SetUp(metric, benchmarkFixedImage, benchmarkMovingImage, true, benchmarkRadius,
+          itk::MultiThreader::GetGlobalDefaultNumberOfThreads());
+    MetricType::MeasureType    value;
+    MetricType::DerivativeType derivative;
+    itk::TimeProbe probe;
+    probe.Start();
+    metric->GetValueAndDerivative(value, derivative);
+    probe.Stop();
+    std::cout << "  " << std::setw(7) << radius << std::setw(12) << probe.GetTotal() << std::endl;
+    }
+
+  return EXIT_SUCCESS;
+}
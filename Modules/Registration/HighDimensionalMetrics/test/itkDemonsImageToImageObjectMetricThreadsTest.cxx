@@ -0,0 +1,236 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkDemonsImageToImageObjectMetric.h"
+#include "itkDisplacementFieldTransform.h"
+#include "itkAffineTransform.h"
+#include "itkIdentityTransform.h"
+#include "itkImageRegionIterator.h"
+#include "itkMultiThreader.h"
+#include "itkTimeProbe.h"
+#include <iomanip>
+
+//FIXME We need these as long as we have to define ImageToData and
+// Array1DToData as a fwd-declare in itkImageToImageObjectMetric.h
+#include "itkImageToData.h"
+#include "itkArray1DToData.h"
+
+// Evaluates the Demons metric of two noise volumes, with a displacement
+// field transform, with an affine transform and with an identity
+// transform, which has no parameters, with several numbers of
+// threads, and checks that the value and the derivative do not depend on
+// the number of threads, and that they do not depend on the previous
+// evaluation. It then reports the time taken by an evaluation with a
+// displacement field transform, and with an affine transform, with 1 to
+// the default number of threads. Pass a larger edge length, e.g. 256, to
+// use it as a benchmark.
+
+namespace
+{
+const unsigned int Dimension = 3;
+typedef itk::Image< double, Dimension >                                        ImageType;
+typedef itk::DemonsImageToImageObjectMetric< ImageType, ImageType, ImageType > MetricType;
+typedef itk::DisplacementFieldTransform< double, Dimension >                   DisplacementTransformType;
+typedef itk::AffineTransform< double, Dimension >                              AffineTransformType;
+typedef itk::IdentityTransform< double, Dimension >                            IdentityTransformType;
+
+ImageType::Pointer MakeImage(unsigned int edgeLength, unsigned int seed)
+{
+  ImageType::Pointer image = ImageType::New();
+  ImageType::SizeType size;
+  size.Fill(edgeLength);
+  image->SetRegions(size);
+  image->Allocate();
+  unsigned int random = seed;
+  itk::ImageRegionIterator< ImageType > it( image, image->GetLargestPossibleRegion() );
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    random = random * 1103515245 + 12345;
+    it.Set( ( random >> 8 ) % 1000 );
+    }
+  return image;
+}
+
+DisplacementTransformType::Pointer MakeDisplacementTransform(const ImageType *image)
+{
+  typedef DisplacementTransformType::DisplacementFieldType FieldType;
+  FieldType::Pointer field = FieldType::New();
+  field->SetRegions( image->GetLargestPossibleRegion() );
+  field->SetSpacing( image->GetSpacing() );
+  field->SetOrigin( image->GetOrigin() );
+  field->SetDirection( image->GetDirection() );
+  field->Allocate();
+  unsigned int random = 3;
+  itk::ImageRegionIterator< FieldType > it( field, field->GetLargestPossibleRegion() );
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    FieldType::PixelType displacement;
+    for ( unsigned int d = 0; d < Dimension; ++d )
+      {
+      random = random * 1103515245 + 12345;
+      displacement[d] = ( ( random >> 8 ) % 1000 ) / 1000.0 - 0.5;
+      }
+    it.Set(displacement);
+    }
+  DisplacementTransformType::Pointer transform = DisplacementTransformType::New();
+  transform->SetDisplacementField(field);
+  return transform;
+}
+
+AffineTransformType::Pointer MakeAffineTransform(const ImageType *image)
+{
+  AffineTransformType::Pointer transform = AffineTransformType::New();
+  AffineTransformType::ParametersType parameters = transform->GetParameters();
+  parameters[0] = 1.02;
+  parameters[1] = 0.03;
+  parameters[5] = -0.02;
+  parameters[9] = 0.4;
+  parameters[10] = -0.3;
+  AffineTransformType::CenterType center;
+  for ( unsigned int d = 0; d < Dimension; ++d )
+    {
+    center[d] = image->GetLargestPossibleRegion().GetSize()[d] / 2.0;
+    }
+  transform->SetCenter(center);
+  transform->SetParameters(parameters);
+  return transform;
+}
+
+MetricType::Pointer MakeMetric(ImageType *fixedImage, ImageType *movingImage,
+                               MetricType::MovingTransformType *movingTransform,
+                               itk::ThreadIdType numberOfThreads)
+{
+  MetricType::Pointer metric = MetricType::New();
+  metric->SetFixedImage(fixedImage);
+  metric->SetMovingImage(movingImage);
+  metric->SetFixedTransform( IdentityTransformType::New() );
+  metric->SetMovingTransform(movingTransform);
+  metric->SetNumberOfThreads(numberOfThreads);
+  metric->Initialize();
+  return metric;
+}
+
+bool TestTransform(const char *name, ImageType *fixedImage, ImageType *movingImage,
+                   MetricType::MovingTransformType *movingTransform)
+{
+  MetricType::MeasureType    expectedValue;
+  MetricType::DerivativeType expectedDerivative;
+  MakeMetric(fixedImage, movingImage, movingTransform, 1)->GetValueAndDerivative(expectedValue,
+                                                                                  expectedDerivative);
+  double maximum = 0.0;
+  for ( unsigned int p = 0; p < expectedDerivative.Size(); ++p )
+    {
+    maximum = std::max( maximum, vcl_abs(expectedDerivative[p]) );
+    }
+  // The derivatives of a transform with local support do not depend on
+  // the split of the image over the threads, those of a global transform
+  // are summed over it.
+  const double tolerance = movingTransform->HasLocalSupport() ? 0.0 : 1e-12 * maximum;
+
+  for ( itk::ThreadIdType threads = 1; threads <= 5; threads += 2 )
+    {
+    MetricType::Pointer        metric = MakeMetric(fixedImage, movingImage, movingTransform, threads);
+    MetricType::MeasureType    value;
+    MetricType::DerivativeType derivative;
+    for ( unsigned int evaluation = 0; evaluation < 2; ++evaluation )
+      {
+      metric->GetValueAndDerivative(value, derivative);
+      if ( vcl_abs(value - expectedValue) > 1e-12 * vcl_abs(expectedValue) )
+        {
+        std::cerr << name << ": the value is " << value << " instead of " << expectedValue << " with "
+                  << threads << " threads" << std::endl;
+        return false;
+        }
+      if ( derivative.Size() != expectedDerivative.Size() )
+        {
+        std::cerr << name << ": the derivative has " << derivative.Size() << " parameters instead of "
+                  << expectedDerivative.Size() << std::endl;
+        return false;
+        }
+      for ( unsigned int p = 0; p < derivative.Size(); ++p )
+        {
+        if ( vcl_abs(derivative[p] - expectedDerivative[p]) > tolerance )
+          {
+          std::cerr << name << ": the derivative of parameter " << p << " is " << derivative[p]
+                    << " instead of " << expectedDerivative[p] << " with " << threads << " threads, evaluation "
+                    << evaluation << std::endl;
+          return false;
+          }
+        }
+      }
+    }
+  return true;
+}
+
+double TimeEvaluation(ImageType *fixedImage, ImageType *movingImage,
+                      MetricType::MovingTransformType *movingTransform, itk::ThreadIdType numberOfThreads)
+{
+  MetricType::Pointer        metric = MakeMetric(fixedImage, movingImage, movingTransform, numberOfThreads);
+  MetricType::MeasureType    value;
+  MetricType::DerivativeType derivative;
+  // The first evaluation allocates the derivative.
+  metric->GetValueAndDerivative(value, derivative);
+  itk::TimeProbe probe;
+  for ( unsigned int evaluation = 0; evaluation < 3; ++evaluation )
+    {
+    probe.Start();
+    metric->GetValueAndDerivative(value, derivative);
+    probe.Stop();
+    }
+  return probe.GetMean();
+}
+}
+
+int itkDemonsImageToImageObjectMetricThreadsTest(int argc, char *argv[])
+{
+  unsigned int edgeLength = 32;
+  if ( argc > 1 )
+    {
+    edgeLength = atoi(argv[1]);
+    }
+
+  ImageType::Pointer fixedImage = MakeImage(13, 1);
+  ImageType::Pointer movingImage = MakeImage(13, 2);
+  if ( !TestTransform( "displacement field", fixedImage, movingImage,
+                       MakeDisplacementTransform(fixedImage).GetPointer() )
+       || !TestTransform( "affine", fixedImage, movingImage, MakeAffineTransform(fixedImage).GetPointer() )
+       || !TestTransform( "identity", fixedImage, movingImage, IdentityTransformType::New().GetPointer() ) )
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Benchmark.
+  ImageType::Pointer benchmarkFixedImage = MakeImage(edgeLength, 1);
+  ImageType::Pointer benchmarkMovingImage = MakeImage(edgeLength, 2);
+  DisplacementTransformType::Pointer displacementTransform = MakeDisplacementTransform(benchmarkFixedImage);
+  AffineTransformType::Pointer       affineTransform = MakeAffineTransform(benchmarkFixedImage);
+
+  const itk::ThreadIdType maximumThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+  std::cout << "Evaluating the Demons metric of " << edgeLength << "^3 volumes, s:" << std::endl;
+  std::cout << "  threads  displacement field      affine" << std::endl;
+  for ( itk::ThreadIdType threads = 1; threads <= maximumThreads; ++threads )
+    {
+    std::cout << "  " << std::setw(7) << threads
+              << std::setw(20) << TimeEvaluation(benchmarkFixedImage, benchmarkMovingImage,
+                                                 displacementTransform, threads)
+              << std::setw(12) << TimeEvaluation(benchmarkFixedImage, benchmarkMovingImage,
+                                                 affineTransform, threads) << std::endl;
+    }
+
+  return EXIT_SUCCESS;
+}
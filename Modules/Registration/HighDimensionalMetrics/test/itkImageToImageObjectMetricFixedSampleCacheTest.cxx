@@ -0,0 +1,278 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkJointHistogramMutualInformationImageToImageObjectMetric.h"
+#include "itkANTSNeighborhoodCorrelationImageToImageObjectMetric.h"
+#include "itkDisplacementFieldTransform.h"
+#include "itkAffineTransform.h"
+#include "itkTranslationTransform.h"
+#include "itkDiscreteGaussianImageFilter.h"
+#include "itkImageRegionIterator.h"
+#include "itkTimeProbe.h"
+#include <iomanip>
+
+//FIXME We need these as long as we have to define ImageToData and
+// Array1DToData as a fwd-declare in itkImageToImageObjectMetric.h
+#include "itkImageToData.h"
+#include "itkArray1DToData.h"
+
+// Evaluates the joint histogram mutual information and the neighborhood
+// correlation metrics of two smoothed noise volumes, with a translated
+// fixed image, with and without pre-warping of the fixed image, and with
+// and without the fixed image gradients, and checks that the value and
+// the derivative are the same with the fixed sample cache, and when the
+// cache exceeds its memory limit. It then reports the time taken by an
+// evaluation of both metrics with and without the cache. Pass a larger
+// edge length, e.g. 128, to use it as a benchmark.
+
+namespace
+{
+const unsigned int Dimension = 3;
+typedef itk::Image< double, Dimension > ImageType;
+typedef itk::JointHistogramMutualInformationImageToImageObjectMetric< ImageType, ImageType >
+                                                                 JointHistogramMetricType;
+typedef itk::ANTSNeighborhoodCorrelationImageToImageObjectMetric< ImageType, ImageType >
+                                                                 NeighborhoodCorrelationMetricType;
+typedef itk::ImageToImageObjectMetric< ImageType, ImageType >    MetricType;
+typedef itk::TranslationTransform< double, Dimension >           TranslationTransformType;
+typedef itk::AffineTransform< double, Dimension >                AffineTransformType;
+typedef itk::DisplacementFieldTransform< double, Dimension >     DisplacementTransformType;
+
+ImageType::Pointer MakeImage(unsigned int edgeLength, unsigned int seed)
+{
+  ImageType::Pointer noise = ImageType::New();
+  ImageType::SizeType size;
+  size.Fill(edgeLength);
+  noise->SetRegions(size);
+  noise->Allocate();
+  unsigned int random = seed;
+  itk::ImageRegionIterator< ImageType > it( noise, noise->GetLargestPossibleRegion() );
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    random = random * 1103515245 + 12345;
+    it.Set( ( random >> 8 ) % 1000 );
+    }
+  typedef itk::DiscreteGaussianImageFilter< ImageType, ImageType > GaussianType;
+  GaussianType::Pointer gaussian = GaussianType::New();
+  gaussian->SetInput(noise);
+  gaussian->SetVariance(2.0);
+  gaussian->Update();
+  return gaussian->GetOutput();
+}
+
+TranslationTransformType::Pointer MakeFixedTransform()
+{
+  TranslationTransformType::Pointer transform = TranslationTransformType::New();
+  TranslationTransformType::OutputVectorType translation;
+  translation[0] = 0.3;
+  translation[1] = -0.6;
+  translation[2] = 0.2;
+  transform->Translate(translation);
+  return transform;
+}
+
+AffineTransformType::Pointer MakeAffineTransform(const ImageType *image)
+{
+  AffineTransformType::Pointer transform = AffineTransformType::New();
+  AffineTransformType::ParametersType parameters = transform->GetParameters();
+  parameters[0] = 1.02;
+  parameters[1] = 0.03;
+  parameters[5] = -0.02;
+  parameters[9] = 0.4;
+  parameters[10] = -0.3;
+  AffineTransformType::CenterType center;
+  for ( unsigned int d = 0; d < Dimension; ++d )
+    {
+    center[d] = image->GetLargestPossibleRegion().GetSize()[d] / 2.0;
+    }
+  transform->SetCenter(center);
+  transform->SetParameters(parameters);
+  return transform;
+}
+
+DisplacementTransformType::Pointer MakeDisplacementTransform(const ImageType *image)
+{
+  typedef DisplacementTransformType::DisplacementFieldType FieldType;
+  FieldType::Pointer field = FieldType::New();
+  field->SetRegions( image->GetLargestPossibleRegion() );
+  field->SetSpacing( image->GetSpacing() );
+  field->SetOrigin( image->GetOrigin() );
+  field->SetDirection( image->GetDirection() );
+  field->Allocate();
+  unsigned int random = 3;
+  itk::ImageRegionIterator< FieldType > it( field, field->GetLargestPossibleRegion() );
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    FieldType::PixelType displacement;
+    for ( unsigned int d = 0; d < Dimension; ++d )
+      {
+      random = random * 1103515245 + 12345;
+      displacement[d] = ( ( random >> 8 ) % 1000 ) / 1000.0 - 0.5;
+      }
+    it.Set(displacement);
+    }
+  DisplacementTransformType::Pointer transform = DisplacementTransformType::New();
+  transform->SetDisplacementField(field);
+  return transform;
+}
+
+MetricType::Pointer MakeMetric(bool jointHistogram, ImageType *fixedImage, ImageType *movingImage)
+{
+  MetricType::Pointer metric;
+  if ( jointHistogram )
+    {
+    JointHistogramMetricType::Pointer jointHistogramMetric = JointHistogramMetricType::New();
+    jointHistogramMetric->SetNumberOfHistogramBins(20);
+    jointHistogramMetric->SetMovingTransform( MakeAffineTransform(fixedImage) );
+    metric = jointHistogramMetric;
+    }
+  else
+    {
+    NeighborhoodCorrelationMetricType::Pointer correlationMetric = NeighborhoodCorrelationMetricType::New();
+    NeighborhoodCorrelationMetricType::RadiusType radius;
+    radius.Fill(1);
+    correlationMetric->SetRadius(radius);
+    correlationMetric->SetMovingTransform( MakeDisplacementTransform(fixedImage) );
+    metric = correlationMetric;
+    }
+  metric->SetFixedImage(fixedImage);
+  metric->SetMovingImage(movingImage);
+  metric->SetFixedTransform( MakeFixedTransform() );
+  return metric;
+}
+
+bool TestMetric(bool jointHistogram, ImageType *fixedImage, ImageType *movingImage)
+{
+  for ( unsigned int configuration = 0; configuration < 4; ++configuration )
+    {
+    const bool preWarp = configuration % 2 == 0;
+    const bool fixedGradients = configuration / 2 == 1;
+    std::string name = jointHistogram ? "joint histogram" : "neighborhood correlation";
+    name += preWarp ? ", pre-warped" : ", interpolated";
+    name += fixedGradients ? ", fixed and moving gradients" : ", moving gradients";
+
+    MetricType::MeasureType    expectedValue = 0.0;
+    MetricType::DerivativeType expectedDerivative;
+    for ( unsigned int cache = 0; cache < 3; ++cache )
+      {
+      MetricType::Pointer metric = MakeMetric(jointHistogram, fixedImage, movingImage);
+      metric->SetDoFixedImagePreWarp(preWarp);
+      metric->SetUseFixedImageGradientFilter(preWarp);
+      metric->SetGradientSource( fixedGradients ? MetricType::GRADIENT_SOURCE_BOTH
+                                                : MetricType::GRADIENT_SOURCE_MOVING );
+      metric->SetUseFixedSampleCache(cache > 0);
+      if ( cache == 2 )
+        {
+        metric->SetFixedSampleCacheMemoryLimit(1000);
+        }
+      metric->Initialize();
+      if ( metric->GetFixedSampleCacheInUse() != ( cache == 1 ) )
+        {
+        std::cerr << name << ": the fixed sample cache is " << ( cache == 1 ? "not " : "" )
+                  << "in use" << std::endl;
+        return false;
+        }
+
+      MetricType::MeasureType    value;
+      MetricType::DerivativeType derivative;
+      for ( unsigned int evaluation = 0; evaluation < 2; ++evaluation )
+        {
+        metric->GetValueAndDerivative(value, derivative);
+        if ( jointHistogram )
+          {
+          // The joint histogram metric computes its value from the
+          // histograms, not from the values at each point.
+          value = metric->GetValue();
+          }
+        if ( cache == 0 && evaluation == 0 )
+          {
+          expectedValue = value;
+          expectedDerivative = derivative;
+          }
+        if ( value != expectedValue )
+          {
+          std::cerr << name << ": the value is " << value << " instead of " << expectedValue
+                    << ", cache " << cache << ", evaluation " << evaluation << std::endl;
+          return false;
+          }
+        for ( unsigned int p = 0; p < derivative.Size(); ++p )
+          {
+          if ( derivative[p] != expectedDerivative[p] )
+            {
+            std::cerr << name << ": the derivative of parameter " << p << " is " << derivative[p]
+                      << " instead of " << expectedDerivative[p] << ", cache " << cache << ", evaluation "
+                      << evaluation << std::endl;
+            return false;
+            }
+          }
+        }
+      }
+    std::cout << name << ": " << expectedValue << std::endl;
+    }
+  return true;
+}
+
+double TimeEvaluation(bool jointHistogram, ImageType *fixedImage, ImageType *movingImage, bool useCache)
+{
+  MetricType::Pointer metric = MakeMetric(jointHistogram, fixedImage, movingImage);
+  metric->SetUseFixedSampleCache(useCache);
+  metric->Initialize();
+  MetricType::MeasureType    value;
+  MetricType::DerivativeType derivative;
+  // The first evaluation allocates the derivative.
+  metric->GetValueAndDerivative(value, derivative);
+  itk::TimeProbe probe;
+  for ( unsigned int evaluation = 0; evaluation < 3; ++evaluation )
+    {
+    probe.Start();
+    metric->GetValueAndDerivative(value, derivative);
+    probe.Stop();
+    }
+  return probe.GetMean();
+}
+}
+
+int itkImageToImageObjectMetricFixedSampleCacheTest(int argc, char *argv[])
+{
+  unsigned int edgeLength = 32;
+  if ( argc > 1 )
+    {
+    edgeLength = atoi(argv[1]);
+    }
+
+  ImageType::Pointer fixedImage = MakeImage(13, 1);
+  ImageType::Pointer movingImage = MakeImage(13, 2);
+  if ( !TestMetric(true, fixedImage, movingImage) || !TestMetric(false, fixedImage, movingImage) )
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Benchmark.
+  ImageType::Pointer benchmarkFixedImage = MakeImage(edgeLength, 1);
+  ImageType::Pointer benchmarkMovingImage = MakeImage(edgeLength, 2);
+  std::cout << "Evaluating the metrics of " << edgeLength << "^3 volumes, s:" << std::endl;
+  std::cout << "                              no cache       cache" << std::endl;
+  std::cout << "  joint histogram         " << std::setw(12)
+            << TimeEvaluation(true, benchmarkFixedImage, benchmarkMovingImage, false) << std::setw(12)
+            << TimeEvaluation(true, benchmarkFixedImage, benchmarkMovingImage, true) << std::endl;
+  std::cout << "  neighborhood correlation" << std::setw(12)
+            << TimeEvaluation(false, benchmarkFixedImage, benchmarkMovingImage, false) << std::setw(12)
+            << TimeEvaluation(false, benchmarkFixedImage, benchmarkMovingImage, true) << std::endl;
+
+  return EXIT_SUCCESS;
+}
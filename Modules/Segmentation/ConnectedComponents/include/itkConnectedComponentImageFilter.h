@@ -41,9 +41,21 @@ namespace itk
  * component image filter which did not produce consecutive labels or
  * impose any particular ordering.
  *
- * \sa ImageToImageFilter
+ * The image is split between the threads along its slowest dimension.
+ * Each thread encodes the runs of its lines, labels them, and merges the
+ * labels of neighboring runs in an union-find structure. The labels of
+ * the runs along the borders between the threads are then merged in
+ * pairs of neighboring pieces, and the consecutive labels are computed
+ * by each thread for the labels of its piece, without locks: each label
+ * is only modified by the thread which owns it at each step.
+ *
+ * When ComputeObjectStatistics is on, the size in pixels and the
+ * bounding box of each object are computed while the output is written,
+ * for example to give them to RelabelComponentImageFilter, which then
+ * does not need to count the pixels of the objects.
+ *
+ * \sa ImageToImageFilter, RelabelComponentImageFilter
  *
- * \ingroup SingelThreaded
  * \ingroup ITKConnectedComponents
  *
  * \wiki
@@ -134,6 +146,36 @@ public:
   // only set after completion
   itkGetConstReferenceMacro(ObjectCount, LabelType);
 
+  /**
+   * Set/Get whether to compute the size in pixels and the bounding box
+   * of each object, while the output is written. Default is
+   * ComputeObjectStatisticsOff.
+   */
+  itkSetMacro(ComputeObjectStatistics, bool);
+  itkGetConstReferenceMacro(ComputeObjectStatistics, bool);
+  itkBooleanMacro(ComputeObjectStatistics);
+
+  typedef std::vector< SizeValueType > ObjectSizeInPixelsContainerType;
+  typedef std::vector< RegionType >    ObjectBoundingBoxContainerType;
+
+  /** Get the size in pixels of each object, in the order of their
+   * labels: with the default background value, the size of object #1
+   * is GetSizeOfObjectsInPixels()[0], the size of object #2 is
+   * GetSizeOfObjectsInPixels()[1], etc. Only set after completion,
+   * when ComputeObjectStatistics is on. */
+  const ObjectSizeInPixelsContainerType & GetSizeOfObjectsInPixels() const
+  {
+    return m_SizeOfObjectsInPixels;
+  }
+
+  /** Get the smallest region which contains each object, in the same
+   * order as GetSizeOfObjectsInPixels(). Only set after completion,
+   * when ComputeObjectStatistics is on. */
+  const ObjectBoundingBoxContainerType & GetBoundingBoxOfObjects() const
+  {
+    return m_BoundingBoxOfObjects;
+  }
+
   // Concept checking -- input and output dimensions must be the same
   itkConceptMacro( SameDimension,
                    ( Concept::SameDimension< itkGetStaticConstMacro(InputImageDimension),
@@ -159,6 +201,7 @@ protected:
   {
     m_FullyConnected = false;
     m_ObjectCount = 0;
+    m_ComputeObjectStatistics = false;
     m_BackgroundValue = NumericTraits< OutputImagePixelType >::Zero;
   }
 
@@ -193,6 +236,10 @@ private:
   LabelType            m_ObjectCount;
   OutputImagePixelType m_BackgroundValue;
 
+  bool                            m_ComputeObjectStatistics;
+  ObjectSizeInPixelsContainerType m_SizeOfObjectsInPixels;
+  ObjectBoundingBoxContainerType  m_BoundingBoxOfObjects;
+
   // some additional types
   typedef typename TOutputImage::RegionType::SizeType OutSizeType;
 
@@ -216,7 +263,18 @@ public:
   // the types to support union-find operations
   typedef std::vector< LabelType > UnionFindType;
   UnionFindType m_UnionFind;
-  UnionFindType m_Consecutive;
+
+  // the size and bounding box of an object, accumulated over its runs
+  class ObjectStatistics
+  {
+public:
+    SizeValueType size;
+    IndexType     minimum;
+    IndexType     maximum;
+  };
+
+  typedef std::vector< ObjectStatistics >                ObjectStatisticsContainerType;
+  typedef std::map< SizeValueType, ObjectStatistics >    ObjectStatisticsMapType;
 
   // functions to support union-find operations
   void InitUnion( SizeValueType size )
@@ -230,7 +288,16 @@ public:
 
   void LinkLabels(const LabelType lab1, const LabelType lab2);
 
-  SizeValueType CreateConsecutive();
+  // functions to compute the consecutive labels of the runs of a thread,
+  // whose labels go from firstLabel to lastLabel
+  SizeValueType FlattenSets(const LabelType firstLabel, const LabelType lastLabel);
+
+  LabelType FindRoot(LabelType label) const;
+
+  // functions to support the object statistics
+  static void InitializeObjectStatistics(ObjectStatistics & statistics);
+
+  static void AddRunToObjectStatistics(ObjectStatistics & statistics, const runLength & run);
 
   //////////////////
   bool CheckNeighbors(const OutputIndexType & A,
@@ -253,8 +320,15 @@ public:
   }
 
   typename std::vector< IdentifierType > m_NumberOfLabels;
+  typename std::vector< IdentifierType > m_NumberOfObjects;
   typename std::vector< IdentifierType > m_FirstLineIdToJoin;
 
+  // the statistics of the objects whose first run, which gives them
+  // their label, belongs to the same thread as the run, and for each
+  // thread, those of the other objects which have runs in that thread
+  ObjectStatisticsContainerType          m_ObjectStatistics;
+  std::vector< ObjectStatisticsMapType > m_OtherObjectStatistics;
+
   typename Barrier::Pointer m_Barrier;
 
   typename TInputImage::ConstPointer m_Input;
@@ -27,6 +27,7 @@
 #include "itkImageRegionIterator.h"
 #include "itkMaskImageFilter.h"
 #include "itkConnectedComponentAlgorithm.h"
+#include <algorithm>
 
 namespace itk
 {
@@ -101,6 +102,13 @@ ConnectedComponentImageFilter< TInputImage, TOutputImage, TMaskImage >
   // set up the vars used in the threads
   m_NumberOfLabels.clear();
   m_NumberOfLabels.resize(nbOfThreads, 0);
+  m_NumberOfObjects.clear();
+  m_NumberOfObjects.resize(nbOfThreads, 0);
+  m_ObjectStatistics.clear();
+  m_OtherObjectStatistics.clear();
+  m_OtherObjectStatistics.resize(nbOfThreads);
+  m_SizeOfObjectsInPixels.clear();
+  m_BoundingBoxOfObjects.clear();
   m_Barrier = Barrier::New();
   m_Barrier->Initialize(nbOfThreads);
   SizeValueType pixelcount = output->GetRequestedRegion().GetNumberOfPixels();
@@ -195,7 +203,7 @@ ConnectedComponentImageFilter< TInputImage, TOutputImage, TMaskImage >
         ++inLineIt;
         }
       }
-    m_LineMap[lineId] = ThisLine;
+    m_LineMap[lineId].swap(ThisLine);
     lineId++;
     progress.CompletedPixel();
     }
@@ -205,33 +213,40 @@ ConnectedComponentImageFilter< TInputImage, TOutputImage, TMaskImage >
   // wait for the other threads to complete that part
   this->Wait();
 
-  // compute the total number of labels
+  // compute the total number of labels, and the first label of the
+  // thread: the labels are given to the runs in raster order
   nbOfLabels = 0;
+  LabelType firstLabelForThread = 1;
   for ( ThreadIdType i = 0; i < nbOfThreads; i++ )
     {
+    if ( i == threadId )
+      {
+      firstLabelForThread += nbOfLabels;
+      }
     nbOfLabels += m_NumberOfLabels[i];
     }
+  const LabelType lastLabelForThread = firstLabelForThread + m_NumberOfLabels[threadId];
 
   if ( threadId == 0 )
     {
     // set up the union find structure
     InitUnion(nbOfLabels);
-    // insert all the labels into the structure -- an extra loop but
-    // saves complicating the ones that come later
-    typename LineMapType::iterator MapBegin, MapEnd, LineIt;
-    MapBegin = m_LineMap.begin();
-    MapEnd = m_LineMap.end();
-    LineIt = MapBegin;
-    SizeValueType label = 1;
-    for ( LineIt = MapBegin; LineIt != MapEnd; ++LineIt )
+    }
+
+  // wait for the other threads to complete that part
+  this->Wait();
+
+  // insert the labels of the runs of the thread into the structure --
+  // an extra loop but saves complicating the ones that come later
+  LabelType label = firstLabelForThread;
+  for ( lineId = firstLineIdForThread; lineId < firstLineIdForThread + linecountForThread; ++lineId )
+    {
+    typename lineEncoding::iterator cIt;
+    for ( cIt = m_LineMap[lineId].begin(); cIt != m_LineMap[lineId].end(); ++cIt )
       {
-      typename lineEncoding::iterator cIt;
-      for ( cIt = LineIt->begin(); cIt != LineIt->end(); ++cIt )
-        {
-        cIt->label = label;
-        InsertSet(label);
-        label++;
-        }
+      cIt->label = label;
+      InsertSet(label);
+      label++;
       }
     }
 
@@ -334,9 +349,63 @@ ConnectedComponentImageFilter< TInputImage, TOutputImage, TMaskImage >
     this->Wait();
     }
 
+  // Compute the consecutive labels. Each label now points to a smaller
+  // label, or to itself if it is the first label of its object. The
+  // labels of the thread first point to the first label of their
+  // object, or to a label of a previous thread, and the objects whose
+  // first label belongs to the thread are counted.
+  m_NumberOfObjects[threadId] = this->FlattenSets(firstLabelForThread, lastLabelForThread);
+
+  this->Wait();
+
+  // the runs get the first label of their object, which is found in
+  // at most one step per previous thread
+  for ( lineId = firstLineIdForThread; lineId < firstLineIdForThread + linecountForThread; ++lineId )
+    {
+    typename lineEncoding::iterator cIt;
+    for ( cIt = m_LineMap[lineId].begin(); cIt != m_LineMap[lineId].end(); ++cIt )
+      {
+      cIt->label = this->FindRoot(cIt->label);
+      }
+    }
+
+  SizeValueType firstObjectForThread = 0;
+  SizeValueType objectCount = 0;
+  for ( ThreadIdType i = 0; i < nbOfThreads; i++ )
+    {
+    if ( i == threadId )
+      {
+      firstObjectForThread = objectCount;
+      }
+    objectCount += m_NumberOfObjects[i];
+    }
+  const SizeValueType lastObjectForThread = firstObjectForThread + m_NumberOfObjects[threadId];
+
   if ( threadId == 0 )
     {
-    m_ObjectCount = CreateConsecutive();
+    m_ObjectCount = objectCount;
+    if ( m_ComputeObjectStatistics )
+      {
+      m_ObjectStatistics.resize(objectCount);
+      }
+    }
+
+  this->Wait();
+
+  // the first label of each object now gives the number of the object,
+  // in the order of the labels
+  SizeValueType objectNumber = firstObjectForThread;
+  for ( LabelType I = firstLabelForThread; I < lastLabelForThread; ++I )
+    {
+    if ( m_UnionFind[I] == I )
+      {
+      if ( m_ComputeObjectStatistics )
+        {
+        InitializeObjectStatistics(m_ObjectStatistics[objectNumber]);
+        }
+      m_UnionFind[I] = objectNumber;
+      ++objectNumber;
+      }
     }
 
   this->Wait();
@@ -376,6 +445,10 @@ ConnectedComponentImageFilter< TInputImage, TOutputImage, TMaskImage >
                         + RegionType( outputRegionIdx,
                                       outputRegionForThread.GetSize() ).GetNumberOfPixels() / xsizeForThread;
 
+  // the labels of the objects go from 0, skipping the background value
+  const SizeValueType background = static_cast< SizeValueType >( m_BackgroundValue );
+  ObjectStatisticsMapType & otherObjectStatistics = m_OtherObjectStatistics[threadId];
+
   for ( SizeValueType ThisIdx = firstLineIdForThread; ThisIdx < lastLineIdForThread; ThisIdx++ )
     {
     // now fill the labelled sections
@@ -383,8 +456,27 @@ ConnectedComponentImageFilter< TInputImage, TOutputImage, TMaskImage >
 
     for ( cIt = m_LineMap[ThisIdx].begin(); cIt != m_LineMap[ThisIdx].end(); ++cIt )
       {
-      SizeValueType   Ilab = LookupSet(cIt->label);
-      OutputPixelType lab = m_Consecutive[Ilab];
+      const SizeValueType object = m_UnionFind[cIt->label];
+      OutputPixelType     lab = static_cast< OutputPixelType >( object < background ? object : object + 1 );
+      if ( m_ComputeObjectStatistics )
+        {
+        // the objects numbered by other threads may also have runs in
+        // those threads, and are first accumulated separately
+        if ( object >= firstObjectForThread && object < lastObjectForThread )
+          {
+          AddRunToObjectStatistics(m_ObjectStatistics[object], *cIt);
+          }
+        else
+          {
+          typename ObjectStatisticsMapType::iterator mIt = otherObjectStatistics.find(object);
+          if ( mIt == otherObjectStatistics.end() )
+            {
+            mIt = otherObjectStatistics.insert( std::make_pair( object, ObjectStatistics() ) ).first;
+            InitializeObjectStatistics(mIt->second);
+            }
+          AddRunToObjectStatistics(mIt->second, *cIt);
+          }
+        }
       oit.SetIndex(cIt->where);
       // initialize the non labelled pixels
       for (; fstart != oit; ++fstart )
@@ -405,6 +497,50 @@ ConnectedComponentImageFilter< TInputImage, TOutputImage, TMaskImage >
     {
     fstart.Set(m_BackgroundValue);
     }
+
+  if ( m_ComputeObjectStatistics )
+    {
+    // wait for the other threads to complete that part
+    this->Wait();
+
+    // add the runs of the objects numbered by the thread that were found
+    // by the next threads
+    for ( ThreadIdType i = threadId + 1; i < nbOfThreads; i++ )
+      {
+      const ObjectStatisticsMapType & other = m_OtherObjectStatistics[i];
+      typename ObjectStatisticsMapType::const_iterator mIt = other.lower_bound(firstObjectForThread);
+      for (; mIt != other.end() && mIt->first < lastObjectForThread; ++mIt )
+        {
+        ObjectStatistics & statistics = m_ObjectStatistics[mIt->first];
+        statistics.size += mIt->second.size;
+        for ( unsigned int d = 0; d < ImageDimension; d++ )
+          {
+          statistics.minimum[d] = std::min(statistics.minimum[d], mIt->second.minimum[d]);
+          statistics.maximum[d] = std::max(statistics.maximum[d], mIt->second.maximum[d]);
+          }
+        }
+      }
+
+    if ( threadId == 0 )
+      {
+      m_SizeOfObjectsInPixels.resize(m_ObjectCount);
+      m_BoundingBoxOfObjects.resize(m_ObjectCount);
+      }
+
+    this->Wait();
+
+    for ( SizeValueType object = firstObjectForThread; object < lastObjectForThread; ++object )
+      {
+      const ObjectStatistics & statistics = m_ObjectStatistics[object];
+      m_SizeOfObjectsInPixels[object] = statistics.size;
+      RegionType & boundingBox = m_BoundingBoxOfObjects[object];
+      boundingBox.SetIndex(statistics.minimum);
+      for ( unsigned int d = 0; d < ImageDimension; d++ )
+        {
+        boundingBox.SetSize(d, statistics.maximum[d] - statistics.minimum[d] + 1);
+        }
+      }
+    }
 }
 
 template< class TInputImage, class TOutputImage, class TMaskImage >
@@ -413,8 +549,12 @@ ConnectedComponentImageFilter< TInputImage, TOutputImage, TMaskImage >
 ::AfterThreadedGenerateData()
 {
   m_NumberOfLabels.clear();
+  m_NumberOfObjects.clear();
   m_Barrier = NULL;
   m_LineMap.clear();
+  m_UnionFind.clear();
+  m_ObjectStatistics.clear();
+  m_OtherObjectStatistics.clear();
   m_Input = NULL;
 }
 
@@ -602,33 +742,64 @@ ConnectedComponentImageFilter< TInputImage, TOutputImage, TMaskImage >
 template< class TInputImage, class TOutputImage, class TMaskImage >
 SizeValueType
 ConnectedComponentImageFilter< TInputImage, TOutputImage, TMaskImage >
-::CreateConsecutive()
+::FlattenSets(const LabelType firstLabel, const LabelType lastLabel)
 {
-  m_Consecutive = UnionFindType( m_UnionFind.size() );
-
-  const LabelType background = static_cast< LabelType >( this->m_BackgroundValue );
-
-  m_Consecutive[background] = background;
-
-  SizeValueType CLab = 0;
+  // LinkLabels() always makes a label point to a smaller one, so the
+  // labels of the thread that point to a label of the thread can point
+  // to what it points to, in increasing order. Only the labels of the
+  // thread are modified.
   SizeValueType count = 0;
-  for ( SizeValueType I = 1; I < m_UnionFind.size(); I++ )
+  for ( LabelType I = firstLabel; I < lastLabel; I++ )
     {
-    SizeValueType L = m_UnionFind[I];
+    const LabelType L = m_UnionFind[I];
     if ( L == I )
       {
-      if ( CLab == static_cast< SizeValueType >( m_BackgroundValue ) )
-        {
-        ++CLab;
-        }
-      m_Consecutive[L] = CLab;
-      ++CLab;
       ++count;
       }
+    else if ( L >= firstLabel )
+      {
+      m_UnionFind[I] = m_UnionFind[L];
+      }
     }
   return count;
 }
 
+template< class TInputImage, class TOutputImage, class TMaskImage >
+typename ConnectedComponentImageFilter< TInputImage, TOutputImage, TMaskImage >::LabelType
+ConnectedComponentImageFilter< TInputImage, TOutputImage, TMaskImage >
+::FindRoot(LabelType label) const
+{
+  while ( m_UnionFind[label] != label )
+    {
+    label = m_UnionFind[label];
+    }
+  return label;
+}
+
+template< class TInputImage, class TOutputImage, class TMaskImage >
+void
+ConnectedComponentImageFilter< TInputImage, TOutputImage, TMaskImage >
+::InitializeObjectStatistics(ObjectStatistics & statistics)
+{
+  statistics.size = 0;
+  statistics.minimum.Fill( NumericTraits< IndexValueType >::max() );
+  statistics.maximum.Fill( NumericTraits< IndexValueType >::NonpositiveMin() );
+}
+
+template< class TInputImage, class TOutputImage, class TMaskImage >
+void
+ConnectedComponentImageFilter< TInputImage, TOutputImage, TMaskImage >
+::AddRunToObjectStatistics(ObjectStatistics & statistics, const runLength & run)
+{
+  statistics.size += run.length;
+  for ( unsigned int d = 0; d < ImageDimension; d++ )
+    {
+    statistics.minimum[d] = std::min(statistics.minimum[d], run.where[d]);
+    statistics.maximum[d] = std::max(statistics.maximum[d], run.where[d]);
+    }
+  statistics.maximum[0] = std::max< IndexValueType >(statistics.maximum[0], run.where[0] + run.length - 1);
+}
+
 template< class TInputImage, class TOutputImage, class TMaskImage >
 SizeValueType
 ConnectedComponentImageFilter< TInputImage, TOutputImage, TMaskImage >
@@ -669,6 +840,7 @@ ConnectedComponentImageFilter< TInputImage, TOutputImage, TMaskImage >
 
   os << indent << "FullyConnected: "  << m_FullyConnected << std::endl;
   os << indent << "ObjectCount: "  << m_ObjectCount << std::endl;
+  os << indent << "ComputeObjectStatistics: "  << m_ComputeObjectStatistics << std::endl;
   os << indent << "BackgroundValue: "
      << static_cast< typename NumericTraits< OutputImagePixelType >::PrintType >( m_BackgroundValue ) << std::endl;
 }
@@ -59,6 +59,13 @@ namespace itk
  * GetOriginalNumberOfObjects method can be called to find out how
  * many objects were present before the small ones were discarded.
  *
+ * The filter first walks the input image to count the pixels of each
+ * object. When the sizes are already known, for example from
+ * ConnectedComponentImageFilter::GetSizeOfObjectsInPixels() with
+ * ComputeObjectStatistics on, they can be given with
+ * SetInputSizeOfObjectsInPixels(), and the input image is then only
+ * walked once, to relabel it.
+ *
  * RelabelComponentImageFilter can be run as an "in place" filter,
  * where it will overwrite its output.  The default is run out of
  * place (or generate a separate output).  "In place" operation can be
@@ -169,6 +176,25 @@ public:
    * through to the output. */
   itkGetConstMacro(MinimumObjectSize, ObjectSizeType);
 
+  /** Set the size in pixels of each object of the input image, so that
+   * the filter does not count them. The labels of the input objects
+   * must then be consecutive from 1, and the size of object #1 is
+   * sizes[0], the size of object #2 is sizes[1], etc., as computed by
+   * ConnectedComponentImageFilter with ComputeObjectStatistics on and
+   * the default background value. The sizes must be set again when the
+   * input image changes. An empty container, the default, makes the
+   * filter count the sizes from the input image. */
+  void SetInputSizeOfObjectsInPixels(const ObjectSizeInPixelsContainerType & sizes)
+  {
+    m_InputSizeOfObjectsInPixels = sizes;
+    this->Modified();
+  }
+
+  const ObjectSizeInPixelsContainerType & GetInputSizeOfObjectsInPixels() const
+  {
+    return m_InputSizeOfObjectsInPixels;
+  }
+
   /** Get the size of each object in pixels. This information is only
    * valid after the filter has executed.  Size of the background is
    * not calculated.  Size of object #1 is
@@ -301,6 +327,7 @@ private:
   ObjectSizeType m_MinimumObjectSize;
 
   ObjectSizeInPixelsContainerType         m_SizeOfObjectsInPixels;
+  ObjectSizeInPixelsContainerType         m_InputSizeOfObjectsInPixels;
   ObjectSizeInPhysicalUnitsContainerType  m_SizeOfObjectsInPhysicalUnits;
 };
 } // end namespace itk
@@ -61,12 +61,16 @@ RelabelComponentImageFilter< TInputImage, TOutputImage >
   typename TInputImage::ConstPointer input = this->GetInput();
   typename TOutputImage::Pointer output = this->GetOutput();
 
+  // The first pass is not needed when the sizes of the objects are
+  // given.
+  const bool sizesAreKnown = !m_InputSizeOfObjectsInPixels.empty();
+
   // Setup a progress reporter.  We have 2 stages to the algorithm so
   // use the total number of pixels accessed. We walk the entire input
   // in the first pass, then walk just the output requested region in
   // the second pass.
   ProgressReporter progress( this, 0,
-                             input->GetRequestedRegion().GetNumberOfPixels()
+                             ( sizesAreKnown ? 0 : input->GetRequestedRegion().GetNumberOfPixels() )
                              + output->GetRequestedRegion().GetNumberOfPixels() );
 
   // Calculate the size of pixel
@@ -88,7 +92,7 @@ RelabelComponentImageFilter< TInputImage, TOutputImage >
   ImageRegionConstIterator< InputImageType > it( input, input->GetRequestedRegion() );
   it.GoToBegin();
 
-  while ( !it.IsAtEnd() )
+  while ( !sizesAreKnown && !it.IsAtEnd() )
     {
     // Get the input pixel value
     const LabelType inputValue = static_cast< LabelType >( it.Get() );
@@ -129,10 +133,33 @@ RelabelComponentImageFilter< TInputImage, TOutputImage >
   typedef typename RelabelMapType::value_type RelabelMapValueType;
   RelabelMapType relabelMap;
 
-  // copy the original object map to a vector so we can sort it
-  for ( mapIt = sizeMap.begin(); mapIt != sizeMap.end(); ++mapIt )
+  // the output label of each input label, when the input labels are
+  // known to be consecutive
+  std::vector< LabelType > relabelTable;
+
+  if ( sizesAreKnown )
     {
-    sizeVector.push_back( ( *mapIt ).second );
+    // the objects are numbered from 1
+    for ( i = 0; i < m_InputSizeOfObjectsInPixels.size(); ++i )
+      {
+      if ( m_InputSizeOfObjectsInPixels[i] > 0 )
+        {
+        RelabelComponentObjectType object;
+        object.m_ObjectNumber = i + 1;
+        object.m_SizeInPixels = m_InputSizeOfObjectsInPixels[i];
+        object.m_SizeInPhysicalUnits = object.m_SizeInPixels * physicalPixelSize;
+        sizeVector.push_back(object);
+        }
+      }
+    relabelTable.resize(m_InputSizeOfObjectsInPixels.size() + 1, 0);
+    }
+  else
+    {
+    // copy the original object map to a vector so we can sort it
+    for ( mapIt = sizeMap.begin(); mapIt != sizeMap.end(); ++mapIt )
+      {
+      sizeVector.push_back( ( *mapIt ).second );
+      }
     }
 
   // sort the objects by size and define the map to use to relabel the image
@@ -155,13 +182,23 @@ RelabelComponentImageFilter< TInputImage, TOutputImage >
       {
       // map small objects to the background
       NumberOfObjectsRemoved++;
-      relabelMap.insert( RelabelMapValueType( ( *vit ).m_ObjectNumber, 0 ) );
+      if ( !sizesAreKnown )
+        {
+        relabelMap.insert( RelabelMapValueType( ( *vit ).m_ObjectNumber, 0 ) );
+        }
       }
     else
       {
       // map for input labels to output labels (Note we use i+1 in the
       // map since index 0 is the background)
-      relabelMap.insert( RelabelMapValueType( ( *vit ).m_ObjectNumber, i + 1 ) );
+      if ( sizesAreKnown )
+        {
+        relabelTable[( *vit ).m_ObjectNumber] = i + 1;
+        }
+      else
+        {
+        relabelMap.insert( RelabelMapValueType( ( *vit ).m_ObjectNumber, i + 1 ) );
+        }
 
       // cache object sizes for later access by the user
       m_SizeOfObjectsInPixels[i] = ( *vit ).m_SizeInPixels;
@@ -203,7 +240,20 @@ RelabelComponentImageFilter< TInputImage, TOutputImage >
     if ( inputValue != NumericTraits< LabelType >::Zero )
       {
       // lookup the mapped label
-      outputValue = static_cast< OutputPixelType >( relabelMap[inputValue] );
+      if ( sizesAreKnown )
+        {
+        if ( inputValue >= relabelTable.size() )
+          {
+          itkExceptionMacro(<< "Label " << inputValue << " of pixel " << it.GetIndex()
+                            << " is larger than the number of input object sizes, "
+                            << m_InputSizeOfObjectsInPixels.size());
+          }
+        outputValue = static_cast< OutputPixelType >( relabelTable[inputValue] );
+        }
+      else
+        {
+        outputValue = static_cast< OutputPixelType >( relabelMap[inputValue] );
+        }
       oit.Set(outputValue);
       }
     else
@@ -230,6 +280,8 @@ RelabelComponentImageFilter< TInputImage, TOutputImage >
   os << indent << "NumberOfObjectsToPrint: "
      << m_NumberOfObjectsToPrint << std::endl;
   os << indent << "MinimumObjectSizez: " << m_MinimumObjectSize << std::endl;
+  os << indent << "InputSizeOfObjectsInPixels: " << m_InputSizeOfObjectsInPixels.size()
+     << " objects" << std::endl;
 
   typename ObjectSizeInPixelsContainerType::const_iterator it;
   ObjectSizeInPhysicalUnitsContainerType::const_iterator   fit;
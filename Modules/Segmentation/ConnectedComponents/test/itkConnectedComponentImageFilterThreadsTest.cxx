@@ -0,0 +1,288 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkConnectedComponentImageFilter.h"
+#include "itkRelabelComponentImageFilter.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMultiThreader.h"
+#include "itkTimeProbe.h"
+#include <iomanip>
+
+// Labels dense and sparse random masks, with face and full
+// connectivity, with a nonzero background value, and with several
+// numbers of threads, and checks that the labels do not depend on the
+// number of threads, that the sizes and bounding boxes of the objects
+// are those of the labeled pixels, and that RelabelComponentImageFilter
+// gives the same results with these sizes as when it counts them. It
+// then reports the time taken to label dense and sparse masks with one
+// thread and with the default number of threads, and to relabel them
+// by size with and without the sizes of the objects. Pass a larger edge
+// length, e.g. 512, to use it as a benchmark.
+
+namespace
+{
+// A mask where each pixel is set with the given probability.
+template< class TImage >
+typename TImage::Pointer MakeMask(const typename TImage::SizeType & size, double density)
+{
+  typename TImage::Pointer image = TImage::New();
+  typename TImage::IndexType index;
+  for ( unsigned int d = 0; d < TImage::ImageDimension; ++d )
+    {
+    index[d] = 2 - static_cast< int >( d );
+    }
+  typename TImage::RegionType region(index, size);
+  image->SetRegions(region);
+  image->Allocate();
+  unsigned int random = 1;
+  itk::ImageRegionIterator< TImage > it(image, region);
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    random = random * 1103515245 + 12345;
+    it.Set( ( ( random >> 8 ) % 1000 ) < density * 1000 ? 1 : 0 );
+    }
+  return image;
+}
+
+template< class TMask, class TLabelImage >
+typename itk::ConnectedComponentImageFilter< TMask, TLabelImage >::Pointer
+Label(TMask *mask, bool fullyConnected, typename TLabelImage::PixelType background,
+      bool computeStatistics, unsigned int numberOfThreads)
+{
+  typedef itk::ConnectedComponentImageFilter< TMask, TLabelImage > FilterType;
+  typename FilterType::Pointer filter = FilterType::New();
+  filter->SetInput(mask);
+  filter->SetFullyConnected(fullyConnected);
+  filter->SetBackgroundValue(background);
+  filter->SetComputeObjectStatistics(computeStatistics);
+  filter->SetNumberOfThreads(numberOfThreads);
+  filter->Update();
+  return filter;
+}
+
+template< class TImage >
+bool SameImages(const char *name, const TImage *image1, const TImage *image2, const char *what)
+{
+  itk::ImageRegionConstIteratorWithIndex< TImage > it1( image1, image1->GetLargestPossibleRegion() );
+  itk::ImageRegionConstIterator< TImage >          it2( image2, image2->GetLargestPossibleRegion() );
+  for ( it1.GoToBegin(), it2.GoToBegin(); !it1.IsAtEnd(); ++it1, ++it2 )
+    {
+    if ( it1.Get() != it2.Get() )
+      {
+      std::cerr << name << ": pixel " << it1.GetIndex() << " is " << it1.Get() << " " << what
+                << " instead of " << it2.Get() << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+template< class TMask, class TLabelImage >
+bool TestMask(const char *name, const typename TMask::SizeType & size, double density)
+{
+  typedef itk::ConnectedComponentImageFilter< TMask, TLabelImage > FilterType;
+  typedef typename TLabelImage::RegionType                         RegionType;
+  typedef typename TLabelImage::IndexType                          IndexType;
+
+  typename TMask::Pointer mask = MakeMask< TMask >(size, density);
+
+  for ( unsigned int test = 0; test < 4; ++test )
+    {
+    const bool                               fullyConnected = ( test & 1 ) != 0;
+    const typename TLabelImage::PixelType    background = test < 2 ? 0 : 3;
+
+    typename FilterType::Pointer expected =
+      Label< TMask, TLabelImage >(mask, fullyConnected, background, false, 1);
+    for ( unsigned int threads = 2; threads <= 7; threads += 5 )
+      {
+      typename FilterType::Pointer filter =
+        Label< TMask, TLabelImage >(mask, fullyConnected, background, true, threads);
+      if ( filter->GetObjectCount() != expected->GetObjectCount()
+           || !SameImages< TLabelImage >( name, filter->GetOutput(), expected->GetOutput(), "with several threads" ) )
+        {
+        std::cerr << name << " (fully connected " << fullyConnected << ", background " << background
+                  << ", " << threads << " threads): " << filter->GetObjectCount() << " objects instead of "
+                  << expected->GetObjectCount() << std::endl;
+        return false;
+        }
+
+      // count the pixels of each object, in the order of their labels
+      const itk::SizeValueType objectCount = filter->GetObjectCount();
+      std::vector< itk::SizeValueType > sizes(objectCount, 0);
+      std::vector< IndexType >          minimum(objectCount);
+      std::vector< IndexType >          maximum(objectCount);
+      itk::ImageRegionConstIteratorWithIndex< TLabelImage > it( filter->GetOutput(),
+                                                                filter->GetOutput()->GetLargestPossibleRegion() );
+      for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+        {
+        if ( it.Get() == background )
+          {
+          continue;
+          }
+        const itk::SizeValueType object = it.Get() < background ? it.Get() : it.Get() - 1;
+        const IndexType index = it.GetIndex();
+        if ( sizes[object]++ == 0 )
+          {
+          minimum[object] = index;
+          maximum[object] = index;
+          }
+        for ( unsigned int d = 0; d < TMask::ImageDimension; ++d )
+          {
+          minimum[object][d] = std::min(minimum[object][d], index[d]);
+          maximum[object][d] = std::max(maximum[object][d], index[d]);
+          }
+        }
+      if ( filter->GetSizeOfObjectsInPixels().size() != objectCount
+           || filter->GetBoundingBoxOfObjects().size() != objectCount )
+        {
+        std::cerr << name << ": the statistics of " << filter->GetSizeOfObjectsInPixels().size()
+                  << " objects were computed instead of " << objectCount << std::endl;
+        return false;
+        }
+      for ( itk::SizeValueType object = 0; object < objectCount; ++object )
+        {
+        RegionType boundingBox;
+        boundingBox.SetIndex(minimum[object]);
+        for ( unsigned int d = 0; d < TMask::ImageDimension; ++d )
+          {
+          boundingBox.SetSize(d, maximum[object][d] - minimum[object][d] + 1);
+          }
+        if ( filter->GetSizeOfObjectsInPixels()[object] != sizes[object]
+             || filter->GetBoundingBoxOfObjects()[object] != boundingBox )
+          {
+          std::cerr << name << " (fully connected " << fullyConnected << ", background " << background
+                    << ", " << threads << " threads): object " << object << " has "
+                    << filter->GetSizeOfObjectsInPixels()[object] << " pixels and bounding box "
+                    << filter->GetBoundingBoxOfObjects()[object] << " instead of " << sizes[object]
+                    << " pixels and " << boundingBox << std::endl;
+          return false;
+          }
+        }
+
+      if ( background != 0 )
+        {
+        continue;
+        }
+
+      // relabel by size, with and without the sizes, and discard the
+      // smallest objects
+      typedef itk::RelabelComponentImageFilter< TLabelImage, TLabelImage > RelabelType;
+      typename RelabelType::Pointer relabel = RelabelType::New();
+      relabel->SetInput( filter->GetOutput() );
+      relabel->SetMinimumObjectSize(2);
+      relabel->Update();
+      typename TLabelImage::Pointer relabelExpected = relabel->GetOutput();
+      relabelExpected->DisconnectPipeline();
+      const typename RelabelType::ObjectSizeInPixelsContainerType expectedSizes = relabel->GetSizeOfObjectsInPixels();
+
+      relabel->SetInputSizeOfObjectsInPixels( filter->GetSizeOfObjectsInPixels() );
+      relabel->Update();
+      if ( relabel->GetSizeOfObjectsInPixels() != expectedSizes
+           || !SameImages< TLabelImage >( name, relabel->GetOutput(), relabelExpected,
+                                          "when relabeled with the sizes of the objects" ) )
+        {
+        std::cerr << name << ": " << relabel->GetNumberOfObjects()
+                  << " objects are relabeled with the sizes of the objects" << std::endl;
+        return false;
+        }
+      }
+    }
+  return true;
+}
+
+template< class TMask, class TLabelImage >
+void Benchmark(const char *name, unsigned int edgeLength, double density)
+{
+  typedef itk::ConnectedComponentImageFilter< TMask, TLabelImage > FilterType;
+  typedef itk::RelabelComponentImageFilter< TLabelImage, TLabelImage > RelabelType;
+
+  typename TMask::SizeType size;
+  size.Fill(edgeLength);
+  typename TMask::Pointer mask = MakeMask< TMask >(size, density);
+
+  const unsigned int numberOfThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+
+  itk::TimeProbe singleThreadProbe;
+  singleThreadProbe.Start();
+  Label< TMask, TLabelImage >(mask, false, 0, false, 1);
+  singleThreadProbe.Stop();
+
+  itk::TimeProbe probe;
+  probe.Start();
+  typename FilterType::Pointer filter = Label< TMask, TLabelImage >(mask, false, 0, true, numberOfThreads);
+  probe.Stop();
+
+  typename RelabelType::Pointer relabel = RelabelType::New();
+  relabel->SetInput( filter->GetOutput() );
+  itk::TimeProbe countingProbe;
+  countingProbe.Start();
+  relabel->Update();
+  countingProbe.Stop();
+
+  relabel->SetInputSizeOfObjectsInPixels( filter->GetSizeOfObjectsInPixels() );
+  itk::TimeProbe sizesProbe;
+  sizesProbe.Start();
+  relabel->Update();
+  sizesProbe.Stop();
+
+  std::cout << "  " << std::setw(6) << name << std::setw(10) << filter->GetObjectCount()
+            << std::setw(12) << singleThreadProbe.GetTotal() << std::setw(12) << probe.GetTotal()
+            << std::setw(12) << countingProbe.GetTotal() << std::setw(12) << sizesProbe.GetTotal()
+            << std::endl;
+}
+}
+
+int itkConnectedComponentImageFilterThreadsTest(int argc, char *argv[])
+{
+  unsigned int edgeLength = 32;
+  if ( argc > 1 )
+    {
+    edgeLength = atoi(argv[1]);
+    }
+
+  typedef itk::Image< unsigned char, 3 > Mask3DType;
+  typedef itk::Image< unsigned int, 3 >  Label3DType;
+  typedef itk::Image< unsigned char, 2 > Mask2DType;
+  typedef itk::Image< short, 2 >         Label2DType;
+
+  Mask3DType::SizeType size3D;
+  size3D[0] = 31;
+  size3D[1] = 23;
+  size3D[2] = 19;
+  Mask2DType::SizeType size2D;
+  size2D[0] = 97;
+  size2D[1] = 88;
+
+  if ( !TestMask< Mask3DType, Label3DType >("dense 3D", size3D, 0.5)
+       || !TestMask< Mask3DType, Label3DType >("sparse 3D", size3D, 0.05)
+       || !TestMask< Mask2DType, Label2DType >("dense 2D", size2D, 0.6)
+       || !TestMask< Mask2DType, Label2DType >("sparse 2D", size2D, 0.1) )
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Benchmark.
+  std::cout << "Labeling a " << edgeLength << "^3 mask, with 1 and "
+            << itk::MultiThreader::GetGlobalDefaultNumberOfThreads()
+            << " threads, and relabeling it by counting the sizes or with the sizes, s:" << std::endl;
+  std::cout << "    mask   objects    1 thread     threads    counting  with sizes" << std::endl;
+  Benchmark< Mask3DType, Label3DType >("dense", edgeLength, 0.5);
+  Benchmark< Mask3DType, Label3DType >("sparse", edgeLength, 0.05);
+
+  return EXIT_SUCCESS;
+}
@@ -138,6 +138,13 @@ namespace itk
  * Threshold and Level parameters are controlled through the class'
  * Get/SetThreshold() and Get/SetLevel() methods.
  *
+ * \par Multithreading
+ * SetNumberOfThreads() sets the number of threads of the three filters of
+ * the mini-pipeline.  Most of the initial segmentation, the sorting of the
+ * adjacencies and the relabeling are computed in parallel, and the merging
+ * of the segments remains serial.  The output does not depend on the
+ * number of threads.
+ *
  * \par Notes on streaming the watershed segmentation code
  *  Coming soon... 12/06/01
  *
@@ -225,6 +232,10 @@ public:
 
   itkGetConstMacro(Level, double);
 
+  /** Set the number of threads of this filter and of the filters of its
+   * mini-pipeline. */
+  virtual void SetNumberOfThreads(ThreadIdType numberOfThreads);
+
   /** Get the basic segmentation from the Segmenter member filter. */
   typename watershed::Segmenter< InputImageType >::OutputImageType *
   GetBasicSegmentation()
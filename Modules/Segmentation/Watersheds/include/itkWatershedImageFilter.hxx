@@ -70,6 +70,17 @@ WatershedImageFilter< TInputImage >
     }
 }
 
+template< class TInputImage >
+void
+WatershedImageFilter< TInputImage >
+::SetNumberOfThreads(ThreadIdType numberOfThreads)
+{
+  Superclass::SetNumberOfThreads(numberOfThreads);
+  m_Segmenter->SetNumberOfThreads( this->GetNumberOfThreads() );
+  m_TreeGenerator->SetNumberOfThreads( this->GetNumberOfThreads() );
+  m_Relabeler->SetNumberOfThreads( this->GetNumberOfThreads() );
+}
+
 template< class TInputImage >
 WatershedImageFilter< TInputImage >
 ::WatershedImageFilter():m_Threshold(0.0), m_Level(0.0)
@@ -54,6 +54,10 @@ namespace watershed
  * image.  FloodLevel controls which level in the segmentation hierarchy to
  * produce on the output.
  *
+ * \par Multithreading
+ * The image is copied and relabeled in parallel with GetNumberOfThreads()
+ * threads, over consecutive slabs of the image.
+ *
  * \ingroup WatershedSegmentation
  * \sa itk::WatershedImageFilter
  * \sa itk::EquivalencyTable
@@ -123,7 +127,8 @@ public:
            ( this->ProcessObject::GetInput(1) );
   }
 
-  /** Standard non-threaded pipeline method */
+  /** Standard pipeline method.  It relabels the image with several
+   * threads. */
   void GenerateData();
 
   /** Set/Get the percentage of the maximum saliency level
@@ -147,6 +152,17 @@ protected:
   void GenerateOutputRequestedRegion(DataObject *output);
 
   void GenerateInputRequestedRegion();
+
+  /** Data shared by the threads that relabel the slabs of the image. */
+  struct ThreadStruct {
+    Self                                       *Filter;
+    std::vector< typename ImageType::RegionType > Slabs;
+    const EquivalencyTable                     *Equivalencies;
+  };
+
+  /** Copies the input image to the output image, relabeled according to
+   * the equivalencies, in each slab processed by a thread.  */
+  static ITK_THREAD_RETURN_TYPE RelabelThreaderCallback(void *arg);
 };
 } // end namespace watershed
 } // end namespace itk
@@ -19,6 +19,7 @@
 #define __itkWatershedRelabeler_hxx
 
 #include "itkImageRegionIterator.h"
+#include "itkImageRegionSplitter.h"
 #include "itkWatershedRelabeler.h"
 
 namespace itk
@@ -56,45 +57,72 @@ void Relabeler< TScalarType, TImageDimension >
 
   output->SetBufferedRegion( output->GetRequestedRegion() );
   output->Allocate();
-  //
-  // Copy input to output
-  //
-  ImageRegionIterator< ImageType > it_a( input, output->GetRequestedRegion() );
-  ImageRegionIterator< ImageType > it_b( output, output->GetRequestedRegion() );
-  it_a = it_a.Begin();
-  it_b = it_b.Begin();
-  while ( !it_a.IsAtEnd() )
-    {
-    it_b.Set( it_a.Get() );
-    ++it_a;
-    ++it_b;
-    }
 
   this->UpdateProgress(0.1);
   //
   // Extract the merges up the requested level
   //
-  if ( tree->Empty() == true )
+  if ( !tree->Empty() )
     {
-    // itkWarningMacro("Empty input.  No relabeling was done.");
-    return;
-    }
-  ScalarType max = tree->Back().saliency;
-  ScalarType mergeLimit = static_cast< ScalarType >( m_FloodLevel * max );
+    ScalarType max = tree->Back().saliency;
+    ScalarType mergeLimit = static_cast< ScalarType >( m_FloodLevel * max );
 
+    it = tree->Begin();
+    while ( it != tree->End() && ( *it ).saliency <= mergeLimit )
+      {
+      eqT->Add( ( *it ).from, ( *it ).to );
+      it++;
+      }
+    }
   this->UpdateProgress(0.5);
 
-  it = tree->Begin();
-  while ( it != tree->End() && ( *it ).saliency <= mergeLimit )
+  //
+  // Copy input to output, relabeled with the merges, in parallel slabs.
+  // Lookup() does not modify the flattened table.
+  //
+  eqT->Flatten();
+
+  typedef ImageRegionSplitter< ImageDimension > SplitterType;
+  typename SplitterType::Pointer splitter = SplitterType::New();
+  const typename ImageType::RegionType region = output->GetRequestedRegion();
+  const unsigned int numberOfSlabs =
+    splitter->GetNumberOfSplits( region, this->GetNumberOfThreads() );
+
+  ThreadStruct str;
+  str.Filter = this;
+  str.Equivalencies = eqT.GetPointer();
+  str.Slabs.resize(numberOfSlabs);
+  for ( unsigned int i = 0; i < numberOfSlabs; ++i )
     {
-    eqT->Add( ( *it ).from, ( *it ).to );
-    it++;
+    str.Slabs[i] = splitter->GetSplit(i, numberOfSlabs, region);
     }
 
-  SegmenterType::RelabelImage(output, output->GetRequestedRegion(), eqT);
+  this->GetMultiThreader()->SetNumberOfThreads(numberOfSlabs);
+  this->GetMultiThreader()->SetSingleMethod(Self::RelabelThreaderCallback, &str);
+  this->GetMultiThreader()->SingleMethodExecute();
+
   this->UpdateProgress(1.0);
 }
 
+template< class TScalarType, unsigned int TImageDimension >
+ITK_THREAD_RETURN_TYPE Relabeler< TScalarType, TImageDimension >
+::RelabelThreaderCallback(void *arg)
+{
+  MultiThreader::ThreadInfoStruct *info = static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  ThreadStruct *str = static_cast< ThreadStruct * >( info->UserData );
+
+  for ( unsigned int i = info->ThreadID; i < str->Slabs.size(); i += info->NumberOfThreads )
+    {
+    ImageRegionConstIterator< ImageType > it_a(str->Filter->GetInputImage(), str->Slabs[i]);
+    ImageRegionIterator< ImageType >      it_b(str->Filter->GetOutputImage(), str->Slabs[i]);
+    for ( it_a.GoToBegin(), it_b.GoToBegin(); !it_a.IsAtEnd(); ++it_a, ++it_b )
+      {
+      it_b.Set( str->Equivalencies->Lookup( it_a.Get() ) );
+      }
+    }
+  return ITK_THREAD_RETURN_VALUE;
+}
+
 template< class TScalarType, unsigned int VImageDimension >
 void Relabeler< TScalarType, VImageDimension >
 ::GenerateInputRequestedRegion()
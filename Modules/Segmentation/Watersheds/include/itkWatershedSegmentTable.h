@@ -105,6 +105,11 @@ public:
    * have been sorted prior to calling this method.   */
   void PruneEdgeLists(ScalarType maximum_saliency);
 
+  /** Removes the edges whose saliencies are above the specified maximum
+   * from the sorted edge list of one segment, as PruneEdgeLists() does for
+   * all the segments.   */
+  static void PruneEdgeList(segment_t & segment, ScalarType maximum_saliency);
+
   /** Lookup a segment in the table.  Returns a pointer to the
    * entry.  On failure, returns a null pointer.   */
   segment_t * Lookup(const IdentifierType a)
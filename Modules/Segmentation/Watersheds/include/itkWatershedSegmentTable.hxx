@@ -30,19 +30,26 @@ void SegmentTable< TScalarType >
 {
   Iterator it;
 
-  typename edge_list_t::iterator e;
   for ( it = this->Begin(); it != this->End(); ++it )
     {
-    for ( e = ( *it ).second.edge_list.begin();
-          e != ( *it ).second.edge_list.end();
-          e++ )
-      {
-      if ( ( e->height - ( *it ).second.min ) > maximum_saliency )
-        {   // dump the rest of the list, assumes list is sorted
-        e++;
-        ( *it ).second.edge_list.erase( e, ( *it ).second.edge_list.end() );
-        break;  // through with this segment
-        }
+    Self::PruneEdgeList( ( *it ).second, maximum_saliency );
+    }
+}
+
+template< class TScalarType >
+void SegmentTable< TScalarType >
+::PruneEdgeList(segment_t & segment, ScalarType maximum_saliency)
+{
+  typename edge_list_t::iterator e;
+  for ( e = segment.edge_list.begin();
+        e != segment.edge_list.end();
+        e++ )
+    {
+    if ( ( e->height - segment.min ) > maximum_saliency )
+      {   // dump the rest of the list, assumes list is sorted
+      e++;
+      segment.edge_list.erase( e, segment.edge_list.end() );
+      break;  // through with this segment
       }
     }
 }
@@ -24,6 +24,7 @@
 
 #include <algorithm>
 #include <utility>
+#include <vector>
 
 namespace itk
 {
@@ -70,6 +71,14 @@ namespace watershed
  * marked as equivalent in the EquivalencyTable.  This is only useful for
  * streaming applications and is turned off by default.  (TRUE == merge, FALSE
  * == do not merge).
+ *
+ * \par Multithreading
+ * The sorting and pruning of the edge lists of the segments, and the
+ * compilation of the initial list of merges, are computed in parallel
+ * with GetNumberOfThreads() threads.  The merges of the extraction of the
+ * merge hierarchy, where each merge depends on the previous ones, remain
+ * serial.  The merge tree does not depend on the number of threads.
+ *
  * \sa itk::WatershedImageFilter
  * \ingroup WatershedSegmentation
  * \ingroup ITKWatersheds
@@ -206,6 +215,34 @@ protected:
 
   void MergeEquivalencies();
 
+  /** Data shared by the threads that process the segments of a table. */
+  struct ThreadStruct {
+    std::vector< typename SegmentTableType::ValueType * >           Segments;
+    ScalarType                                                      Threshold;
+    const OneWayEquivalencyTableType                               *MergedSegments;
+    std::vector< std::vector< typename SegmentTreeType::merge_t > > Merges;
+  };
+
+  /** Collects the segments of a table, in the order of the table, and calls
+   * a threader callback with at most GetNumberOfThreads() threads, each of
+   * which processes a range of consecutive segments.   */
+  void ExecuteOnSegments(ThreadStruct & str, SegmentTableTypePointer segments,
+                         ThreadFunctionType callback);
+
+  /** Sorts the edge lists of a segment table in parallel.   */
+  void ThreadedSortEdgeLists(SegmentTableTypePointer segments);
+
+  /** Prunes the edge lists of a segment table in parallel, as
+   * SegmentTable::PruneEdgeLists() does.   */
+  void ThreadedPruneEdgeLists(SegmentTableTypePointer segments, ScalarType threshold);
+
+  /** Threader callbacks of the multithreaded steps.   */
+  static ITK_THREAD_RETURN_TYPE SortEdgeListsThreaderCallback(void *arg);
+
+  static ITK_THREAD_RETURN_TYPE PruneEdgeListsThreaderCallback(void *arg);
+
+  static ITK_THREAD_RETURN_TYPE CompileMergeListThreaderCallback(void *arg);
+
   /** Methods required by the itk pipeline */
   void GenerateOutputRequestedRegion(DataObject *output);
 
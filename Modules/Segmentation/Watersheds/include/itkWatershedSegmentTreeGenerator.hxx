@@ -81,7 +81,7 @@ void SegmentTreeGenerator< TScalarType >
   if ( m_ConsumeInput == true ) // do not copy input
     {
     input->Modified();
-    input->SortEdgeLists();
+    this->ThreadedSortEdgeLists(input);
 
     if ( m_Merge == true )   {      this->MergeEquivalencies();    }
 
@@ -91,7 +91,7 @@ void SegmentTreeGenerator< TScalarType >
   else
     {
     seg->Copy(*input); // copy the input
-    seg->SortEdgeLists();
+    this->ThreadedSortEdgeLists(seg);
     if ( m_Merge == true )   {      this->MergeEquivalencies();    }
     this->CompileMergeList(seg, mergeList);
     this->ExtractMergeHierarchy(seg, mergeList);
@@ -118,7 +118,7 @@ void SegmentTreeGenerator< TScalarType >
   eqTable->Flatten();
   IdentifierType counter = 0;
 
-  segTable->PruneEdgeLists(threshold);
+  this->ThreadedPruneEdgeLists(segTable, threshold);
 
   for ( it = eqTable->Begin(); it != eqTable->End(); ++it )
     {
@@ -127,7 +127,7 @@ void SegmentTreeGenerator< TScalarType >
     // deletes first
     if ( ( counter % 10000 ) == 0 )
       {
-      segTable->PruneEdgeLists(threshold);
+      this->ThreadedPruneEdgeLists(segTable, threshold);
       m_MergedSegmentsTable->Flatten();
       counter = 0;
       }
@@ -141,51 +141,139 @@ void SegmentTreeGenerator< TScalarType >
 ::CompileMergeList(SegmentTableTypePointer segments,
                    SegmentTreeTypePointer mergeList)
 {
-  typename SegmentTreeType::merge_t tempMerge;
-
   // Region A will flood Region B (B will merge with A) at a flood level L
   // when all of the following conditions are true:
   // 1) Depth of B < L
   // 2) A is across the lowest edge of B
-  typename SegmentTableType::Iterator segment_ptr;
-  IdentifierType labelFROM;
-  IdentifierType labelTO;
-  ScalarType    threshold = static_cast< ScalarType >( m_FloodLevel * segments->GetMaximumDepth() );
+  ScalarType threshold = static_cast< ScalarType >( m_FloodLevel * segments->GetMaximumDepth() );
   m_MergedSegmentsTable->Flatten();
 
-  segments->PruneEdgeLists(threshold);
+  // Prune the edge lists and find the potential merge of each segment in
+  // parallel, and add the merges to the list in the order of the segments
+  // in the table.
+  ThreadStruct str;
+  str.Threshold = threshold;
+  str.MergedSegments = m_MergedSegmentsTable.GetPointer();
+  this->ExecuteOnSegments(str, segments, Self::CompileMergeListThreaderCallback);
+
+  for ( unsigned int i = 0; i < str.Merges.size(); ++i )
+    {
+    for ( typename std::vector< typename SegmentTreeType::merge_t >::const_iterator merge = str.Merges[i].begin();
+          merge != str.Merges[i].end(); ++merge )
+      {
+      mergeList->PushBack(*merge);
+      }
+    }
+
+  // Heapsort the list
+  typedef typename SegmentTreeType::merge_comp MergeComparison;
+  std::make_heap( mergeList->Begin(), mergeList->End(), MergeComparison() );
+}
 
-  for ( segment_ptr = segments->Begin(); segment_ptr != segments->End();
-        ++segment_ptr )
+template< class TScalarType >
+void SegmentTreeGenerator< TScalarType >
+::ExecuteOnSegments(ThreadStruct & str, SegmentTableTypePointer segments,
+                    ThreadFunctionType callback)
+{
+  str.Segments.reserve( segments->Size() );
+  for ( typename SegmentTableType::Iterator it = segments->Begin(); it != segments->End(); ++it )
     {
-    labelFROM = ( *segment_ptr ).first;
+    str.Segments.push_back( &( *it ) );
+    }
+
+  this->GetMultiThreader()->SetNumberOfThreads( this->GetNumberOfThreads() );
+  str.Merges.resize( this->GetMultiThreader()->GetNumberOfThreads() );
+  this->GetMultiThreader()->SetSingleMethod(callback, &str);
+  this->GetMultiThreader()->SingleMethodExecute();
+}
+
+template< class TScalarType >
+void SegmentTreeGenerator< TScalarType >
+::ThreadedSortEdgeLists(SegmentTableTypePointer segments)
+{
+  ThreadStruct str;
+  this->ExecuteOnSegments(str, segments, Self::SortEdgeListsThreaderCallback);
+}
+
+template< class TScalarType >
+void SegmentTreeGenerator< TScalarType >
+::ThreadedPruneEdgeLists(SegmentTableTypePointer segments, ScalarType threshold)
+{
+  ThreadStruct str;
+  str.Threshold = threshold;
+  this->ExecuteOnSegments(str, segments, Self::PruneEdgeListsThreaderCallback);
+}
+
+template< class TScalarType >
+ITK_THREAD_RETURN_TYPE SegmentTreeGenerator< TScalarType >
+::SortEdgeListsThreaderCallback(void *arg)
+{
+  MultiThreader::ThreadInfoStruct *info = static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  ThreadStruct *str = static_cast< ThreadStruct * >( info->UserData );
+
+  for ( size_t i = info->ThreadID; i < str->Segments.size(); i += info->NumberOfThreads )
+    {
+    str->Segments[i]->second.edge_list.sort();
+    }
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template< class TScalarType >
+ITK_THREAD_RETURN_TYPE SegmentTreeGenerator< TScalarType >
+::PruneEdgeListsThreaderCallback(void *arg)
+{
+  MultiThreader::ThreadInfoStruct *info = static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  ThreadStruct *str = static_cast< ThreadStruct * >( info->UserData );
+
+  for ( size_t i = info->ThreadID; i < str->Segments.size(); i += info->NumberOfThreads )
+    {
+    SegmentTableType::PruneEdgeList(str->Segments[i]->second, str->Threshold);
+    }
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template< class TScalarType >
+ITK_THREAD_RETURN_TYPE SegmentTreeGenerator< TScalarType >
+::CompileMergeListThreaderCallback(void *arg)
+{
+  MultiThreader::ThreadInfoStruct *info = static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  ThreadStruct *str = static_cast< ThreadStruct * >( info->UserData );
+
+  typename SegmentTreeType::merge_t tempMerge;
+  IdentifierType labelFROM;
+  IdentifierType labelTO;
+
+  // Each thread processes a range of consecutive segments, so that the
+  // merges of the threads follow each other in the order of the table.
+  const size_t first = str->Segments.size() * info->ThreadID / info->NumberOfThreads;
+  const size_t last = str->Segments.size() * ( info->ThreadID + 1 ) / info->NumberOfThreads;
+  for ( size_t i = first; i < last; ++i )
+    {
+    typename SegmentTableType::segment_t & segment = str->Segments[i]->second;
+    SegmentTableType::PruneEdgeList(segment, str->Threshold);
+
+    labelFROM = str->Segments[i]->first;
 
     // Must take into account any equivalencies that have already been
     // recorded.
-    labelTO =
-      m_MergedSegmentsTable->RecursiveLookup( ( *segment_ptr ).second.edge_list.front().label );
+    labelTO = str->MergedSegments->RecursiveLookup( segment.edge_list.front().label );
     while ( labelTO == labelFROM ) // Pop off any bogus merges with ourself
       {                            // that may have been left in this list.
-      ( *segment_ptr ).second.edge_list.pop_front();
-      labelTO =
-        m_MergedSegmentsTable->RecursiveLookup( ( *segment_ptr ).second.edge_list.front().label );
+      segment.edge_list.pop_front();
+      labelTO = str->MergedSegments->RecursiveLookup( segment.edge_list.front().label );
       }
 
     // Add this merge to our list if its saliency is below
     // the threshold.
     tempMerge.from     = labelFROM;
     tempMerge.to       = labelTO;
-    tempMerge.saliency = ( *segment_ptr ).second.edge_list.front().height
-                         - ( *segment_ptr ).second.min;
-    if ( tempMerge.saliency < threshold )
+    tempMerge.saliency = segment.edge_list.front().height - segment.min;
+    if ( tempMerge.saliency < str->Threshold )
       {
-      mergeList->PushBack(tempMerge);
+      str->Merges[info->ThreadID].push_back(tempMerge);
       }
     }
-
-  // Heapsort the list
-  typedef typename SegmentTreeType::merge_comp MergeComparison;
-  std::make_heap( mergeList->Begin(), mergeList->End(), MergeComparison() );
+  return ITK_THREAD_RETURN_VALUE;
 }
 
 template< class TScalarType >
@@ -218,7 +306,7 @@ void SegmentTreeGenerator< TScalarType >
     if ( counter == 10000 )     // all the recursion in our records
       {                         // of which segments have merged.
       counter = 0;
-      segments->PruneEdgeLists(threshold); // also we want to
+      this->ThreadedPruneEdgeLists(segments, threshold); // also we want to
       // keep the edge list size under control
       }
     if ( ( counter % 10000 ) == 0 )
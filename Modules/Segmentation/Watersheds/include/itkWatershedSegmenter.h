@@ -80,6 +80,14 @@ namespace watershed
  * segments.  The assumption is that the ``shallow'' regions that this
  * thresholding eliminates are generally not of interest.
  *
+ * \par Multithreading
+ * The thresholding, the gradient descent, the relabeling of the image and
+ * the construction of the segment table are computed in parallel with
+ * GetNumberOfThreads() threads, over consecutive slabs of the image.  The
+ * labeling of the minima and of the flat regions, which numbers the
+ * segments in the order of the pixels, remains serial.  The labeled image
+ * and the segment table do not depend on the number of threads.
+ *
  * \sa WatershedImageFilter
  * \ingroup WatershedSegmentation
  * \ingroup ITKWatersheds
@@ -262,6 +270,34 @@ protected:
   typedef itksys::hash_map< IdentifierType, edge_table_t, itksys::hash< IdentifierType >
                          > edge_table_hash_t;
 
+  /** The segments and edges found in one slab of the image by
+   * UpdateSegmentTable().  The minimum values of the segments are stored
+   * in an edge_table_t, and the segments and edges are also listed in the
+   * order in which they are first met, so that the tables of the slabs
+   * can be merged in the order of the pixels.   */
+  struct slab_segments_t {
+    edge_table_t                                               minimum;
+    edge_table_hash_t                                          edges;
+    std::vector< IdentifierType >                              segments;
+    std::vector< std::pair< IdentifierType, IdentifierType > > adjacencies;
+  };
+
+  /** Data shared by the threads that process the slabs of the image.  */
+  struct ThreadStruct {
+    Self                                                 *Filter;
+    std::vector< ImageRegionType >                        Slabs;
+    InputImageTypePointer                                 Image;
+    InputImageTypePointer                                 Source;
+    ImageRegionType                                       Region;
+    InputPixelType                                        Value;
+    IdentifierType                                        Label;
+    const EquivalencyTable                               *Equivalencies;
+    std::vector< InputPixelType >                         Minimum;
+    std::vector< InputPixelType >                         Maximum;
+    std::vector< slab_segments_t >                        Segments;
+    std::vector< typename SegmentTableType::segment_t * > SegmentPointers;
+  };
+
   Segmenter();
   Segmenter(const Self &) {}
   virtual ~Segmenter();
@@ -352,6 +388,54 @@ protected:
                                    const ImageRegionType region,
                                    IdentifierType value);
 
+  /** Split a region into at most GetNumberOfThreads() slabs along its
+   * outermost dimension, which follow each other in the order of the
+   * pixels, and call a threader callback on each of them.  */
+  void ExecuteOnSlabs(ThreadStruct & str, const ImageRegionType & region,
+                      ThreadFunctionType callback);
+
+  /** Multithreaded versions of the helper functions.  */
+  void ThreadedMinMax(InputImageTypePointer img, const ImageRegionType & region,
+                      InputPixelType & min, InputPixelType & max);
+
+  void ThreadedThreshold(InputImageTypePointer destination,
+                         InputImageTypePointer source,
+                         const ImageRegionType & region,
+                         InputPixelType threshold);
+
+  void ThreadedSetOutputImageValues(const ImageRegionType & region,
+                                    IdentifierType value);
+
+  void ThreadedRelabelImage(const ImageRegionType & region,
+                            EquivalencyTable::Pointer eqTable);
+
+  /** Sorts the edge lists of the segment table in parallel.  */
+  void ThreadedSortEdgeLists();
+
+  /** Follows the unlabeled pixels of a slab of the region down their paths
+   * of steepest descent, which may leave the slab.  */
+  void GradientDescentInSlab(InputImageTypePointer, const ImageRegionType & region,
+                             const ImageRegionType & slab);
+
+  /** Collects the segments of a slab of the image, and their edges.  */
+  void CollectSegmentsInSlab(InputImageTypePointer, const ImageRegionType & slab,
+                             slab_segments_t & segments);
+
+  /** Threader callbacks of the multithreaded steps.  */
+  static ITK_THREAD_RETURN_TYPE MinMaxThreaderCallback(void *arg);
+
+  static ITK_THREAD_RETURN_TYPE ThresholdThreaderCallback(void *arg);
+
+  static ITK_THREAD_RETURN_TYPE SetOutputImageValuesThreaderCallback(void *arg);
+
+  static ITK_THREAD_RETURN_TYPE RelabelImageThreaderCallback(void *arg);
+
+  static ITK_THREAD_RETURN_TYPE SortEdgeListsThreaderCallback(void *arg);
+
+  static ITK_THREAD_RETURN_TYPE GradientDescentThreaderCallback(void *arg);
+
+  static ITK_THREAD_RETURN_TYPE UpdateSegmentTableThreaderCallback(void *arg);
+
   /** This is a debugging method.  Will be removed. 11/14/01 jc   */
   //  bool CheckLabeledBoundaries();
 
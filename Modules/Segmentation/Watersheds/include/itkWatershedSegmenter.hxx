@@ -21,6 +21,7 @@
 #include "itkWatershedSegmenter.h"
 #include "itkNeighborhoodAlgorithm.h"
 #include "itkImageRegionIterator.h"
+#include "itkImageRegionSplitter.h"
 #include <stack>
 #include <list>
 
@@ -184,7 +185,7 @@ void Segmenter< TInputImage >::GenerateData()
   //
   //
   InputPixelType minimum, maximum;
-  Self::MinMax(input, regionToProcess, minimum, maximum);
+  this->ThreadedMinMax(input, regionToProcess, minimum, maximum);
   // cap the maximum in the image so that we can always define a pixel
   // value that is one greater than the maximum value in the image.
   if ( NumericTraits< InputPixelType >::is_integer
@@ -193,8 +194,8 @@ void Segmenter< TInputImage >::GenerateData()
     maximum -= NumericTraits< InputPixelType >::One;
     }
   // threshold the image.
-  Self::Threshold( thresholdImage, input, regionToProcess, regionToProcess,
-                   static_cast< InputPixelType >( ( m_Threshold * ( maximum - minimum ) ) + minimum ) );
+  this->ThreadedThreshold( thresholdImage, input, regionToProcess,
+                           static_cast< InputPixelType >( ( m_Threshold * ( maximum - minimum ) ) + minimum ) );
 
   //
   // Redefine the regionToProcess in terms of the threshold image.  The region
@@ -231,7 +232,7 @@ void Segmenter< TInputImage >::GenerateData()
   //
   output->SetBufferedRegion( thresholdImage->GetBufferedRegion() );
   output->Allocate();
-  Self::SetOutputImageValues(output, output->GetBufferedRegion(), Self::NULL_LABEL);
+  this->ThreadedSetOutputImageValues(output->GetBufferedRegion(), Self::NULL_LABEL);
 
   //
   // Now we can create appropriate boundary regions for analyzing the
@@ -318,7 +319,7 @@ void Segmenter< TInputImage >::GenerateData()
   this->UpdateProgress(0.7);
 
   if ( m_SortEdgeLists == true )
-          {  this->GetSegmentTable()->SortEdgeLists(); }
+          {  this->ThreadedSortEdgeLists(); }
   this->UpdateProgress(0.8);
 
   this->GetSegmentTable()->SetMaximumDepth(maximum - minimum);
@@ -779,7 +780,7 @@ void Segmenter< TInputImage >
   Self::MergeFlatRegions(flatRegions, equivalentLabels);
 
   // Relabel the image with the merged regions.
-  Self::RelabelImage(output, region, equivalentLabels);
+  this->ThreadedRelabelImage(region, equivalentLabels);
 
   equivalentLabels->Clear();
 
@@ -826,13 +827,33 @@ void Segmenter< TInputImage >
   Self::MergeFlatRegions(flatRegions, equivalentLabels);
 
   // Relabel the image with the merged regions.
-  Self::RelabelImage(output, region, equivalentLabels);
+  this->ThreadedRelabelImage(region, equivalentLabels);
 }
 
 template< class TInputImage >
 void Segmenter< TInputImage >
 ::GradientDescent(InputImageTypePointer img,
                   ImageRegionType region)
+{
+  //
+  // The path of steepest descent from a pixel does not depend on the
+  // labels, and it ends at the first labeled pixel, whose label is then
+  // given to all the pixels of the path.  A thread may read the label of a
+  // pixel while another one writes it, but it then finds either NULL_LABEL,
+  // and goes on down the path, or the label at the end of the path.  The
+  // labels thus do not depend on the order in which the paths are followed.
+  //
+  ThreadStruct str;
+  str.Image = img;
+  str.Region = region;
+  this->ExecuteOnSlabs(str, region, Self::GradientDescentThreaderCallback);
+}
+
+template< class TInputImage >
+void Segmenter< TInputImage >
+::GradientDescentInSlab(InputImageTypePointer img,
+                        const ImageRegionType & region,
+                        const ImageRegionType & slab)
 {
   typename OutputImageType::Pointer output = this->GetOutputImage();
 
@@ -856,10 +877,10 @@ void Segmenter< TInputImage >
   valueIt(rad, img, region);
   NeighborhoodIterator< OutputImageType >
                                          labelIt(zeroRad, output, region);
-  ImageRegionIterator< OutputImageType > it(output, region);
+  ImageRegionIterator< OutputImageType > it(output, slab);
 
   //
-  // Sweep through the image and trace all unlabeled
+  // Sweep through the slab and trace all unlabeled
   // pixels to a labeled region
   //
   for ( it = it.Begin(); !it.IsAtEnd(); ++it )
@@ -920,99 +941,91 @@ void Segmenter< TInputImage >
     }
 
   equivalentLabels->Flatten();
-  Self::RelabelImage(output, imageRegion, equivalentLabels);
+  this->ThreadedRelabelImage(imageRegion, equivalentLabels);
 }
 
 template< class TInputImage >
 void Segmenter< TInputImage >
 ::UpdateSegmentTable(InputImageTypePointer input, ImageRegionType region)
 {
-  edge_table_hash_t edgeHash;
-  edge_table_t      tempEdgeTable;
-
   typename edge_table_hash_t::iterator edge_table_entry_ptr;
   typename edge_table_t::iterator edge_ptr;
+  typename edge_table_t::const_iterator minimum_ptr;
 
-  unsigned int i, nPos;
-  typename NeighborhoodIterator< OutputImageType >::RadiusType hoodRadius;
   typename SegmentTableType::segment_t * segment_ptr;
   typename SegmentTableType::segment_t temp_segment;
-  IdentifierType segment_label;
-
-  InputPixelType lowest_edge;
 
-  // Grab the data we need.
-  typename OutputImageType::Pointer output    = this->GetOutputImage();
   typename SegmentTableType::Pointer segments = this->GetSegmentTable();
 
-  // Set up some iterators.
-  for ( i = 0; i < ImageDimension; i++ )
-    {
-    hoodRadius[i] = 1;
-    }
-  ConstNeighborhoodIterator< InputImageType > searchIt(hoodRadius, input, region);
-  NeighborhoodIterator< OutputImageType >     labelIt(hoodRadius, output, region);
-
-  IdentifierType hoodCenter = searchIt.Size() >> 1;
+  // Collect the segments and their edges in each slab of the region.
+  ThreadStruct str;
+  str.Image = input;
+  str.Region = region;
+  this->ExecuteOnSlabs(str, region, Self::UpdateSegmentTableThreaderCallback);
 
-  for ( searchIt.GoToBegin(), labelIt.GoToBegin(); !searchIt.IsAtEnd();
-        ++searchIt, ++labelIt )
+  //
+  // Merge the tables of the slabs in the order of the pixels, so that the
+  // segments, and the edges of each segment, are added to the tables in
+  // the same order as if they were collected over the whole region at
+  // once.  The edges of the first slab are already in that order.
+  //
+  edge_table_hash_t edgeHash;
+  edgeHash.swap(str.Segments[0].edges);
+  for ( unsigned int slab = 0; slab < str.Segments.size(); ++slab )
     {
-    segment_label = labelIt.GetPixel(hoodCenter);
-
-    // Find the segment corresponding to this label
-    // and update its minimum value if necessary.
-    segment_ptr = segments->Lookup(segment_label);
-    edge_table_entry_ptr = edgeHash.find(segment_label);
-    if ( segment_ptr == 0 ) // This segment not yet identified.
-      {                     // So add it to the table.
-      temp_segment.min = searchIt.GetPixel(hoodCenter);
-      segments->Add(segment_label, temp_segment);
-      typedef typename edge_table_hash_t::value_type ValueType;
-      edgeHash.insert( ValueType(segment_label,
-                                 tempEdgeTable) );
-
-      edge_table_entry_ptr = edgeHash.find(segment_label);
+    slab_segments_t & slabSegments = str.Segments[slab];
+    for ( typename std::vector< IdentifierType >::const_iterator label = slabSegments.segments.begin();
+          label != slabSegments.segments.end(); ++label )
+      {
+      // Find the segment corresponding to this label
+      // and update its minimum value if necessary.
+      minimum_ptr = slabSegments.minimum.find(*label);
+      segment_ptr = segments->Lookup(*label);
+      if ( segment_ptr == 0 ) // This segment not yet identified.
+        {                     // So add it to the table.
+        temp_segment.min = ( *minimum_ptr ).second;
+        segments->Add(*label, temp_segment);
+        }
+      else if ( ( *minimum_ptr ).second < segment_ptr->min )
+        {
+        segment_ptr->min = ( *minimum_ptr ).second;
+        }
+      if ( slab > 0 )
+        {
+        typedef typename edge_table_hash_t::value_type ValueType;
+        edgeHash.insert( ValueType( *label, edge_table_t() ) );
+        }
       }
-    else if ( searchIt.GetPixel(hoodCenter) < segment_ptr->min )
+
+    if ( slab == 0 )
       {
-      segment_ptr->min = searchIt.GetPixel(hoodCenter);
+      continue;
       }
 
-    // Look up each neighboring segment in this segment's edge table.
-    // If an edge exists, compare (and reset) the minimum edge value.
-    // Note that edges are located *between* two adjacent pixels and
-    // the value is taken to be the maximum of the two adjacent pixel
-    // values.
-    for ( i = 0; i < m_Connectivity.size; ++i )
+    // Keep the lowest edge between each pair of segments.
+    for ( typename std::vector< std::pair< IdentifierType, IdentifierType > >::const_iterator
+          adjacency = slabSegments.adjacencies.begin();
+          adjacency != slabSegments.adjacencies.end(); ++adjacency )
       {
-      nPos = m_Connectivity.index[i];
-      if ( labelIt.GetPixel(nPos) != segment_label
-           && labelIt.GetPixel(nPos) != NULL_LABEL )
+      const InputPixelType lowest_edge =
+        ( *( *slabSegments.edges.find(adjacency->first) ).second.find(adjacency->second) ).second;
+      edge_table_t & edges = ( *edgeHash.find(adjacency->first) ).second;
+
+      edge_ptr = edges.find(adjacency->second);
+      if ( edge_ptr == edges.end() )
+        {     // This edge has not been identified yet.
+        typedef typename edge_table_t::value_type ValueType;
+        edges.insert( ValueType(adjacency->second, lowest_edge) );
+        }
+      else if ( lowest_edge < ( *edge_ptr ).second )
         {
-        if ( searchIt.GetPixel(nPos) < searchIt.GetPixel(hoodCenter) )
-          {
-          lowest_edge = searchIt.GetPixel(hoodCenter); // We want the
-          }
-        else
-          {
-          lowest_edge = searchIt.GetPixel(nPos);       // max of the
-          }
-        // adjacent pixels
-
-        edge_ptr = ( *edge_table_entry_ptr ).second.find( labelIt.GetPixel(nPos) );
-        if ( edge_ptr == ( *edge_table_entry_ptr ).second.end() )
-          {     // This edge has not been identified yet.
-          typedef typename edge_table_t::value_type ValueType;
-          ( *edge_table_entry_ptr ).second.insert(
-            ValueType(labelIt.GetPixel(nPos), lowest_edge) );
-          }
-        else if ( lowest_edge < ( *edge_ptr ).second )
-          {
-          ( *edge_ptr ).second = lowest_edge;
-          }
+        ( *edge_ptr ).second = lowest_edge;
         }
       }
+
+    // Clean up memory as we go
+    slabSegments.minimum.clear();
+    slabSegments.edges.clear();
     }
 
   //
@@ -1050,6 +1063,100 @@ void Segmenter< TInputImage >
     }
 }
 
+template< class TInputImage >
+void Segmenter< TInputImage >
+::CollectSegmentsInSlab(InputImageTypePointer input,
+                        const ImageRegionType & slab,
+                        slab_segments_t & slabSegments)
+{
+  typename edge_table_t::iterator edge_ptr;
+
+  unsigned int i, nPos;
+  typename ConstNeighborhoodIterator< OutputImageType >::RadiusType hoodRadius;
+  IdentifierType  segment_label;
+  IdentifierType  neighbor_label;
+  InputPixelType  lowest_edge;
+  InputPixelType *minimum = 0;
+  edge_table_t   *edges = 0;
+
+  typename OutputImageType::Pointer output = this->GetOutputImage();
+
+  // Set up some iterators.
+  for ( i = 0; i < ImageDimension; i++ )
+    {
+    hoodRadius[i] = 1;
+    }
+  ConstNeighborhoodIterator< InputImageType >  searchIt(hoodRadius, input, slab);
+  ConstNeighborhoodIterator< OutputImageType > labelIt(hoodRadius, output, slab);
+
+  IdentifierType hoodCenter = searchIt.Size() >> 1;
+
+  for ( searchIt.GoToBegin(), labelIt.GoToBegin(); !searchIt.IsAtEnd();
+        ++searchIt, ++labelIt )
+    {
+    // Find the entries of the segment of this pixel, which is most
+    // often the segment of the previous pixel.
+    if ( edges == 0 || labelIt.GetPixel(hoodCenter) != segment_label )
+      {
+      segment_label = labelIt.GetPixel(hoodCenter);
+      typename edge_table_t::iterator minimum_ptr = slabSegments.minimum.find(segment_label);
+      if ( minimum_ptr == slabSegments.minimum.end() ) // This segment not yet
+        {                                                // identified.
+        typedef typename edge_table_t::value_type      MinimumValueType;
+        typedef typename edge_table_hash_t::value_type EdgeTableValueType;
+        minimum_ptr = slabSegments.minimum.insert(
+          MinimumValueType( segment_label, searchIt.GetPixel(hoodCenter) ) ).first;
+        slabSegments.edges.insert( EdgeTableValueType( segment_label, edge_table_t() ) );
+        slabSegments.segments.push_back(segment_label);
+        }
+      minimum = &( ( *minimum_ptr ).second );
+      edges = &( ( *slabSegments.edges.find(segment_label) ).second );
+      }
+
+    if ( searchIt.GetPixel(hoodCenter) < *minimum )
+      {
+      *minimum = searchIt.GetPixel(hoodCenter);
+      }
+
+    // Look up each neighboring segment in this segment's edge table.
+    // If an edge exists, compare (and reset) the minimum edge value.
+    // Note that edges are located *between* two adjacent pixels and
+    // the value is taken to be the maximum of the two adjacent pixel
+    // values.
+    for ( i = 0; i < m_Connectivity.size; ++i )
+      {
+      nPos = m_Connectivity.index[i];
+      neighbor_label = labelIt.GetPixel(nPos);
+      if ( neighbor_label != segment_label
+           && neighbor_label != NULL_LABEL )
+        {
+        if ( searchIt.GetPixel(nPos) < searchIt.GetPixel(hoodCenter) )
+          {
+          lowest_edge = searchIt.GetPixel(hoodCenter); // We want the
+          }
+        else
+          {
+          lowest_edge = searchIt.GetPixel(nPos);       // max of the
+          }
+        // adjacent pixels
+
+        edge_ptr = edges->find(neighbor_label);
+        if ( edge_ptr == edges->end() )
+          {     // This edge has not been identified yet.
+          typedef typename edge_table_t::value_type ValueType;
+          edges->insert( ValueType(neighbor_label, lowest_edge) );
+          slabSegments.adjacencies.push_back(
+            std::pair< IdentifierType, IdentifierType >(segment_label, neighbor_label) );
+          }
+        else if ( lowest_edge < ( *edge_ptr ).second )
+          {
+          ( *edge_ptr ).second = lowest_edge;
+          }
+        }
+      }
+    }
+}
+
 template< class TInputImage >
 void Segmenter< TInputImage >
 ::BuildRetainingWall(InputImageTypePointer img,
@@ -1241,6 +1348,214 @@ void Segmenter< TInputImage >::Threshold(InputImageTypePointer destination,
     }
 }
 
+/*
+  ----------------------------------------------------------------------------
+  Multithreading methods
+  ----------------------------------------------------------------------------
+*/
+template< class TInputImage >
+void Segmenter< TInputImage >
+::ExecuteOnSlabs(ThreadStruct & str, const ImageRegionType & region,
+                 ThreadFunctionType callback)
+{
+  typedef ImageRegionSplitter< ImageDimension > SplitterType;
+  typename SplitterType::Pointer splitter = SplitterType::New();
+
+  const unsigned int numberOfSlabs =
+    splitter->GetNumberOfSplits( region, this->GetNumberOfThreads() );
+
+  str.Filter = this;
+  str.Slabs.resize(numberOfSlabs);
+  for ( unsigned int i = 0; i < numberOfSlabs; ++i )
+    {
+    str.Slabs[i] = splitter->GetSplit(i, numberOfSlabs, region);
+    }
+  str.Minimum.resize(numberOfSlabs);
+  str.Maximum.resize(numberOfSlabs);
+  str.Segments.resize(numberOfSlabs);
+
+  this->GetMultiThreader()->SetNumberOfThreads(numberOfSlabs);
+  this->GetMultiThreader()->SetSingleMethod(callback, &str);
+  this->GetMultiThreader()->SingleMethodExecute();
+}
+
+template< class TInputImage >
+void Segmenter< TInputImage >
+::ThreadedMinMax(InputImageTypePointer img, const ImageRegionType & region,
+                 InputPixelType & min, InputPixelType & max)
+{
+  ThreadStruct str;
+  str.Image = img;
+  this->ExecuteOnSlabs(str, region, Self::MinMaxThreaderCallback);
+
+  min = str.Minimum[0];
+  max = str.Maximum[0];
+  for ( unsigned int i = 1; i < str.Slabs.size(); ++i )
+    {
+    if ( str.Maximum[i] > max ) { max = str.Maximum[i]; }
+    if ( str.Minimum[i] < min ) { min = str.Minimum[i]; }
+    }
+}
+
+template< class TInputImage >
+void Segmenter< TInputImage >
+::ThreadedThreshold(InputImageTypePointer destination,
+                    InputImageTypePointer source,
+                    const ImageRegionType & region,
+                    InputPixelType threshold)
+{
+  ThreadStruct str;
+  str.Image = destination;
+  str.Source = source;
+  str.Value = threshold;
+  this->ExecuteOnSlabs(str, region, Self::ThresholdThreaderCallback);
+}
+
+template< class TInputImage >
+void Segmenter< TInputImage >
+::ThreadedSetOutputImageValues(const ImageRegionType & region,
+                               IdentifierType value)
+{
+  ThreadStruct str;
+  str.Label = value;
+  this->ExecuteOnSlabs(str, region, Self::SetOutputImageValuesThreaderCallback);
+}
+
+template< class TInputImage >
+void Segmenter< TInputImage >
+::ThreadedRelabelImage(const ImageRegionType & region,
+                       EquivalencyTable::Pointer eqTable)
+{
+  // Lookup() does not modify the flattened table.
+  eqTable->Flatten();
+
+  ThreadStruct str;
+  str.Equivalencies = eqTable.GetPointer();
+  this->ExecuteOnSlabs(str, region, Self::RelabelImageThreaderCallback);
+}
+
+template< class TInputImage >
+void Segmenter< TInputImage >
+::ThreadedSortEdgeLists()
+{
+  typename SegmentTableType::Pointer segments = this->GetSegmentTable();
+
+  ThreadStruct str;
+  str.Filter = this;
+  str.SegmentPointers.reserve( segments->Size() );
+  for ( typename SegmentTableType::Iterator it = segments->Begin(); it != segments->End(); ++it )
+    {
+    str.SegmentPointers.push_back( &( ( *it ).second ) );
+    }
+
+  this->GetMultiThreader()->SetNumberOfThreads( this->GetNumberOfThreads() );
+  this->GetMultiThreader()->SetSingleMethod(Self::SortEdgeListsThreaderCallback, &str);
+  this->GetMultiThreader()->SingleMethodExecute();
+}
+
+template< class TInputImage >
+ITK_THREAD_RETURN_TYPE Segmenter< TInputImage >
+::MinMaxThreaderCallback(void *arg)
+{
+  MultiThreader::ThreadInfoStruct *info = static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  ThreadStruct *str = static_cast< ThreadStruct * >( info->UserData );
+
+  for ( unsigned int i = info->ThreadID; i < str->Slabs.size(); i += info->NumberOfThreads )
+    {
+    Self::MinMax(str->Image, str->Slabs[i], str->Minimum[i], str->Maximum[i]);
+    }
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template< class TInputImage >
+ITK_THREAD_RETURN_TYPE Segmenter< TInputImage >
+::ThresholdThreaderCallback(void *arg)
+{
+  MultiThreader::ThreadInfoStruct *info = static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  ThreadStruct *str = static_cast< ThreadStruct * >( info->UserData );
+
+  for ( unsigned int i = info->ThreadID; i < str->Slabs.size(); i += info->NumberOfThreads )
+    {
+    Self::Threshold(str->Image, str->Source, str->Slabs[i], str->Slabs[i], str->Value);
+    }
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template< class TInputImage >
+ITK_THREAD_RETURN_TYPE Segmenter< TInputImage >
+::SetOutputImageValuesThreaderCallback(void *arg)
+{
+  MultiThreader::ThreadInfoStruct *info = static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  ThreadStruct *str = static_cast< ThreadStruct * >( info->UserData );
+
+  for ( unsigned int i = info->ThreadID; i < str->Slabs.size(); i += info->NumberOfThreads )
+    {
+    Self::SetOutputImageValues(str->Filter->GetOutputImage(), str->Slabs[i], str->Label);
+    }
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template< class TInputImage >
+ITK_THREAD_RETURN_TYPE Segmenter< TInputImage >
+::RelabelImageThreaderCallback(void *arg)
+{
+  MultiThreader::ThreadInfoStruct *info = static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  ThreadStruct *str = static_cast< ThreadStruct * >( info->UserData );
+
+  for ( unsigned int i = info->ThreadID; i < str->Slabs.size(); i += info->NumberOfThreads )
+    {
+    ImageRegionIterator< OutputImageType > it(str->Filter->GetOutputImage(), str->Slabs[i]);
+    for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+      {
+      const IdentifierType temp = str->Equivalencies->Lookup( it.Get() );
+      if ( temp != it.Get() )  { it.Set(temp); }
+      }
+    }
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template< class TInputImage >
+ITK_THREAD_RETURN_TYPE Segmenter< TInputImage >
+::SortEdgeListsThreaderCallback(void *arg)
+{
+  MultiThreader::ThreadInfoStruct *info = static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  ThreadStruct *str = static_cast< ThreadStruct * >( info->UserData );
+
+  for ( size_t i = info->ThreadID; i < str->SegmentPointers.size(); i += info->NumberOfThreads )
+    {
+    str->SegmentPointers[i]->edge_list.sort();
+    }
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template< class TInputImage >
+ITK_THREAD_RETURN_TYPE Segmenter< TInputImage >
+::GradientDescentThreaderCallback(void *arg)
+{
+  MultiThreader::ThreadInfoStruct *info = static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  ThreadStruct *str = static_cast< ThreadStruct * >( info->UserData );
+
+  for ( unsigned int i = info->ThreadID; i < str->Slabs.size(); i += info->NumberOfThreads )
+    {
+    str->Filter->GradientDescentInSlab(str->Image, str->Region, str->Slabs[i]);
+    }
+  return ITK_THREAD_RETURN_VALUE;
+}
+
+template< class TInputImage >
+ITK_THREAD_RETURN_TYPE Segmenter< TInputImage >
+::UpdateSegmentTableThreaderCallback(void *arg)
+{
+  MultiThreader::ThreadInfoStruct *info = static_cast< MultiThreader::ThreadInfoStruct * >( arg );
+  ThreadStruct *str = static_cast< ThreadStruct * >( info->UserData );
+
+  for ( unsigned int i = info->ThreadID; i < str->Slabs.size(); i += info->NumberOfThreads )
+    {
+    str->Filter->CollectSegmentsInSlab(str->Image, str->Slabs[i], str->Segments[i]);
+    }
+  return ITK_THREAD_RETURN_VALUE;
+}
+
 /*
   ----------------------------------------------------------------------------
   Pipeline methods
@@ -0,0 +1,221 @@
+/*=========================================================================
+ *
+ *  Copyright Insight Software Consortium
+ *
+ *  Licensed under the Apache License, Version 2.0 (the "License");
+ *  you may not use this file except in compliance with the License.
+ *  You may obtain a copy of the License at
+ *
+ *         http://www.apache.org/licenses/LICENSE-2.0.txt
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ *=========================================================================*/
+
+#include "itkWatershedImageFilter.h"
+#include "itkDiscreteGaussianImageFilter.h"
+#include "itkGradientMagnitudeImageFilter.h"
+#include "itkImageRegionIteratorWithIndex.h"
+#include "itkMultiThreader.h"
+#include "itkTimeProbe.h"
+#include <iomanip>
+
+// Segments the gradient magnitudes of smoothed noise, as float volumes,
+// as unsigned char volumes with many flat regions, and as short images,
+// with several numbers of threads, and checks that the basic
+// segmentation, the merge tree and the labeled image do not depend on the
+// number of threads. It then reports the time taken to segment a float
+// volume with 1 to the default number of threads. Pass a larger edge
+// length, e.g. 512, to use it as a benchmark.
+
+namespace
+{
+// The gradient magnitude of smoothed noise, scaled to the range of the
+// pixel type.
+template< class TImage >
+typename TImage::Pointer MakeImage(const typename TImage::SizeType & size, double scale)
+{
+  typedef itk::Image< float, TImage::ImageDimension > FloatImageType;
+
+  typename FloatImageType::Pointer noise = FloatImageType::New();
+  typename FloatImageType::IndexType index;
+  for ( unsigned int d = 0; d < TImage::ImageDimension; ++d )
+    {
+    index[d] = 1 - 2 * static_cast< int >( d );
+    }
+  typename FloatImageType::RegionType region(index, size);
+  noise->SetRegions(region);
+  noise->Allocate();
+  unsigned int random = 1;
+  itk::ImageRegionIterator< FloatImageType > it(noise, region);
+  for ( it.GoToBegin(); !it.IsAtEnd(); ++it )
+    {
+    random = random * 1103515245 + 12345;
+    it.Set( ( random >> 8 ) % 1000 );
+    }
+
+  typedef itk::DiscreteGaussianImageFilter< FloatImageType, FloatImageType > GaussianType;
+  typename GaussianType::Pointer gaussian = GaussianType::New();
+  gaussian->SetInput(noise);
+  gaussian->SetVariance(4.0);
+  typedef itk::GradientMagnitudeImageFilter< FloatImageType, FloatImageType > GradientType;
+  typename GradientType::Pointer gradient = GradientType::New();
+  gradient->SetInput( gaussian->GetOutput() );
+  gradient->Update();
+
+  typename TImage::Pointer image = TImage::New();
+  image->SetRegions(region);
+  image->Allocate();
+  itk::ImageRegionIterator< FloatImageType > git(gradient->GetOutput(), region);
+  itk::ImageRegionIterator< TImage >         iit(image, region);
+  for ( git.GoToBegin(), iit.GoToBegin(); !iit.IsAtEnd(); ++git, ++iit )
+    {
+    iit.Set( static_cast< typename TImage::PixelType >( git.Get() * scale ) );
+    }
+  return image;
+}
+
+template< class TImage >
+typename itk::WatershedImageFilter< TImage >::Pointer
+Segment(TImage *input, double threshold, double level, unsigned int numberOfThreads)
+{
+  typedef itk::WatershedImageFilter< TImage > FilterType;
+  typename FilterType::Pointer filter = FilterType::New();
+  filter->SetInput(input);
+  filter->SetThreshold(threshold);
+  filter->SetLevel(level);
+  filter->SetNumberOfThreads(numberOfThreads);
+  filter->Update();
+  return filter;
+}
+
+template< class TLabelImage >
+bool SameImages(const char *name, const TLabelImage *image1, const TLabelImage *image2, const char *what)
+{
+  itk::ImageRegionConstIteratorWithIndex< TLabelImage > it1( image1, image1->GetLargestPossibleRegion() );
+  itk::ImageRegionConstIterator< TLabelImage >          it2( image2, image2->GetLargestPossibleRegion() );
+  for ( it1.GoToBegin(), it2.GoToBegin(); !it1.IsAtEnd(); ++it1, ++it2 )
+    {
+    if ( it1.Get() != it2.Get() )
+      {
+      std::cerr << name << ": pixel " << it1.GetIndex() << " of the " << what << " is " << it1.Get()
+                << " instead of " << it2.Get() << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+template< class TImage >
+bool TestImage(const char *name, const typename TImage::SizeType & size, double scale,
+               double threshold, double level)
+{
+  typedef itk::WatershedImageFilter< TImage > FilterType;
+  typedef typename FilterType::OutputImageType LabelImageType;
+  typedef typename itk::watershed::SegmentTreeGenerator< typename TImage::PixelType >::SegmentTreeType TreeType;
+
+  typename TImage::Pointer input = MakeImage< TImage >(size, scale);
+
+  typename FilterType::Pointer expected = Segment< TImage >(input, threshold, level, 1);
+  for ( unsigned int threads = 2; threads <= 5; threads += 3 )
+    {
+    typename FilterType::Pointer filter = Segment< TImage >(input, threshold, level, threads);
+    std::cout << name << ", " << threads << " threads: " << filter->GetSegmentTree()->Size()
+              << " merges" << std::endl;
+
+    TreeType *tree = filter->GetSegmentTree();
+    TreeType *expectedTree = expected->GetSegmentTree();
+    if ( tree->Size() != expectedTree->Size() )
+      {
+      std::cerr << name << ": " << tree->Size() << " merges with " << threads << " threads instead of "
+                << expectedTree->Size() << std::endl;
+      return false;
+      }
+    for ( typename TreeType::Iterator it = tree->Begin(), eit = expectedTree->Begin();
+          it != tree->End(); ++it, ++eit )
+      {
+      if ( it->from != eit->from || it->to != eit->to || it->saliency != eit->saliency )
+        {
+        std::cerr << name << ": the merge of " << it->from << " into " << it->to << " at " << it->saliency
+                  << " with " << threads << " threads is instead that of " << eit->from << " into "
+                  << eit->to << " at " << eit->saliency << std::endl;
+        return false;
+        }
+      }
+
+    if ( !SameImages< LabelImageType >( name, filter->GetBasicSegmentation(), expected->GetBasicSegmentation(),
+                                        "basic segmentation" )
+         || !SameImages< LabelImageType >( name, filter->GetOutput(), expected->GetOutput(), "output" ) )
+      {
+      std::cerr << "  with " << threads << " threads" << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+}
+
+int itkWatershedImageFilterThreadsTest(int argc, char *argv[])
+{
+  unsigned int edgeLength = 32;
+  if ( argc > 1 )
+    {
+    edgeLength = atoi(argv[1]);
+    }
+
+  typedef itk::Image< float, 3 >         FloatImageType;
+  typedef itk::Image< unsigned char, 3 > UCharImageType;
+  typedef itk::Image< short, 2 >         ShortImageType;
+
+  FloatImageType::SizeType size3D;
+  size3D[0] = 37;
+  size3D[1] = 29;
+  size3D[2] = 23;
+  ShortImageType::SizeType size2D;
+  size2D[0] = 157;
+  size2D[1] = 133;
+
+  if ( !TestImage< FloatImageType >("float 3D", size3D, 1.0, 0.01, 0.2)
+       || !TestImage< UCharImageType >("unsigned char 3D", size3D, 3.0, 0.0, 0.1)
+       || !TestImage< ShortImageType >("short 2D", size2D, 5.0, 0.05, 0.3) )
+    {
+    return EXIT_FAILURE;
+    }
+
+  // Benchmark.
+  FloatImageType::SizeType size;
+  size.Fill(edgeLength);
+  FloatImageType::Pointer input = MakeImage< FloatImageType >(size, 1.0);
+
+  typedef itk::WatershedImageFilter< FloatImageType > FilterType;
+  FilterType::Pointer expected;
+
+  const itk::ThreadIdType maximumThreads = itk::MultiThreader::GetGlobalDefaultNumberOfThreads();
+  std::cout << "Segmenting the gradient magnitude of a " << edgeLength << "^3 float volume, s:" << std::endl;
+  std::cout << "  threads        time    merges" << std::endl;
+  for ( itk::ThreadIdType threads = 1; threads <= maximumThreads; ++threads )
+    {
+    itk::TimeProbe probe;
+    probe.Start();
+    FilterType::Pointer filter = Segment< FloatImageType >(input, 0.01, 0.2, threads);
+    probe.Stop();
+    std::cout << "  " << std::setw(7) << threads << std::setw(12) << probe.GetTotal()
+              << std::setw(10) << filter->GetSegmentTree()->Size() << std::endl;
+
+    if ( threads == 1 )
+      {
+      expected = filter;
+      }
+    else if ( !SameImages< FilterType::OutputImageType >( "benchmark", filter->GetOutput(),
+                                                          expected->GetOutput(), "output" ) )
+      {
+      return EXIT_FAILURE;
+      }
+    }
+
+  return EXIT_SUCCESS;
+}